@@ -127,6 +127,15 @@ static void osd_buf_destroy(XINE_BD_ARGB_BUFFER *buf)
   }
 }
 
+#define OVERLAY_CACHE_SIZE 8  /* decoded objects / plane */
+
+typedef struct {
+  uint32_t  serial;    /* BD_OVERLAY object_serial, 0 = unused entry */
+  uint16_t  w, h;
+  uint8_t  *img;       /* palette indexes */
+  unsigned  last_use;
+} overlay_cache_t;
+
 typedef struct {
   input_plugin_t        input_plugin;
 
@@ -135,6 +144,11 @@ typedef struct {
   xine_osd_t           *osd[2];
   XINE_BD_ARGB_BUFFER   osd_buf;
 
+  /* converted overlay data */
+  uint32_t              palette_serial[2];  /* palette currently set to osd */
+  overlay_cache_t       ov_cache[2][OVERLAY_CACHE_SIZE];
+  unsigned              ov_cache_tick;
+
   bluray_input_class_t *class;
 
   char                 *mrl;
@@ -197,6 +211,60 @@ static void clear_overlay(xine_osd_t *osd)
   osd->osd.area_touched = 0;
 }
 
+static void overlay_cache_flush(bluray_input_plugin_t *this, int plane)
+{
+  unsigned i;
+
+  for (i = 0; i < OVERLAY_CACHE_SIZE; i++) {
+    free(this->ov_cache[plane][i].img);
+  }
+  memset(this->ov_cache[plane], 0, sizeof(this->ov_cache[plane]));
+  this->palette_serial[plane] = 0;
+}
+
+/* decoded image of object, or NULL if object can't be cached */
+static const uint8_t *overlay_cache_get(bluray_input_plugin_t *this, const BD_OVERLAY * const ov)
+{
+  overlay_cache_t *e = NULL;
+  unsigned i;
+
+  if (!ov->object_serial || !ov->img) {
+    return NULL;
+  }
+
+  for (i = 0; i < OVERLAY_CACHE_SIZE; i++) {
+    overlay_cache_t *c = &this->ov_cache[ov->plane][i];
+    if (c->serial == ov->object_serial && c->w == ov->w && c->h == ov->h) {
+      c->last_use = ++this->ov_cache_tick;
+      return c->img;
+    }
+    /* replace unused or least recently used entry */
+    if (!e || !c->serial || (e->serial && c->last_use < e->last_use)) {
+      e = c;
+    }
+  }
+
+  free(e->img);
+  e->serial = 0;
+  e->img    = malloc(ov->w * ov->h);
+  if (!e->img) {
+    return NULL;
+  }
+
+  if (ov->index_img) {
+    memcpy(e->img, ov->index_img, ov->w * ov->h);
+  } else {
+    bd_rle_decode8(ov->img, ov->w, ov->h, e->img, ov->w);
+  }
+
+  e->serial   = ov->object_serial;
+  e->w        = ov->w;
+  e->h        = ov->h;
+  e->last_use = ++this->ov_cache_tick;
+
+  return e->img;
+}
+
 static void close_overlay(bluray_input_plugin_t *this, int plane)
 {
   if (plane < 0) {
@@ -205,6 +273,10 @@ static void close_overlay(bluray_input_plugin_t *this, int plane)
     return;
   }
 
+  if (plane < 2) {
+    overlay_cache_flush(this, plane);
+  }
+
   if (plane < 2 && this->osd[plane]) {
     xine_osd_free(this->osd[plane]);
     this->osd[plane] = NULL;
@@ -242,12 +314,13 @@ static xine_osd_t *get_overlay(bluray_input_plugin_t *this, int plane)
   return this->osd[plane];
 }
 
-static void draw_bitmap(xine_osd_t *osd, const BD_OVERLAY * const ov)
+static void draw_bitmap(bluray_input_plugin_t *this, xine_osd_t *osd, const BD_OVERLAY * const ov)
 {
+  const uint8_t *cached;
   unsigned i;
 
-  /* convert and set palette */
-  if (ov->palette) {
+  /* convert and set palette (skip if palette has not changed) */
+  if (ov->palette && (!ov->palette_serial || ov->palette_serial != this->palette_serial[ov->plane])) {
     uint32_t color[256];
     uint8_t  trans[256];
     for(i = 0; i < 256; i++) {
@@ -256,17 +329,21 @@ static void draw_bitmap(xine_osd_t *osd, const BD_OVERLAY * const ov)
     }
 
     xine_osd_set_palette(osd, color, trans);
+    this->palette_serial[ov->plane] = ov->palette_serial;
+  }
+
+  /* re-use previously decoded object */
+  cached = overlay_cache_get(this, ov);
+  if (cached) {
+    xine_osd_draw_bitmap(osd, (uint8_t *)cached, ov->x, ov->y, ov->w, ov->h, NULL);
+    return;
   }
 
   /* uncompress and draw bitmap */
   if (ov->img) {
-    const BD_PG_RLE_ELEM *rlep = ov->img;
     uint8_t *img = malloc(ov->w * ov->h);
-    unsigned pixels = ov->w * ov->h;
 
-    for (i = 0; i < pixels; i += rlep->len, rlep++) {
-      memset(img + i, rlep->color, rlep->len);
-    }
+    bd_rle_decode8(ov->img, ov->w, ov->h, img, ov->w);
 
     xine_osd_draw_bitmap(osd, img, ov->x, ov->y, ov->w, ov->h, NULL);
 
@@ -311,7 +388,7 @@ static void overlay_proc(void *this_gen, const BD_OVERLAY * const ov)
 
   switch (ov->cmd) {
     case BD_OVERLAY_DRAW:    /* draw bitmap (x,y,w,h,img,palette) */
-      draw_bitmap(osd, ov);
+      draw_bitmap(this, osd, ov);
       return;
 
     case BD_OVERLAY_WIPE:    /* clear area (x,y,w,h) */
@@ -1032,8 +1109,9 @@ static buf_element_t *bluray_plugin_read_block (input_plugin_t *this_gen, fifo_b
   if (todo > (off_t)buf->max_size)
     todo = buf->max_size;
 
+  /* read as many whole aligned units as fit to fifo buffer */
   if (todo > ALIGNED_UNIT_SIZE)
-    todo = ALIGNED_UNIT_SIZE;
+    todo -= todo % ALIGNED_UNIT_SIZE;
 
   if (todo > 0) {
     bluray_input_plugin_t *this = (bluray_input_plugin_t *) this_gen;
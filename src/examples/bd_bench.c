@@ -0,0 +1,323 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * bd_read() / bd_read_ext() throughput and latency benchmark
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "libbluray/bluray.h"
+
+#define DEFAULT_BUF_SIZE (192 * 1024)
+
+typedef struct {
+    uint32_t *lat;        /* per-call latency (us) */
+    unsigned  num_lat;
+    unsigned  size_lat;
+
+    uint64_t  bytes;
+    uint64_t  wall_us;
+    clock_t   cpu;
+
+    unsigned  num_stalls; /* reads crossing clip boundary */
+    uint64_t  stall_us;
+    uint32_t  max_stall_us;
+} BENCH;
+
+static uint64_t _now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void _add_latency(BENCH *b, uint32_t us)
+{
+    if (b->num_lat >= b->size_lat) {
+        unsigned  new_size = b->size_lat ? 2 * b->size_lat : 4096;
+        uint32_t *tmp = realloc(b->lat, new_size * sizeof(uint32_t));
+        if (!tmp) {
+            return;
+        }
+        b->lat      = tmp;
+        b->size_lat = new_size;
+    }
+    b->lat[b->num_lat++] = us;
+}
+
+static int _cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t _percentile(const BENCH *b, unsigned pct)
+{
+    if (!b->num_lat) {
+        return 0;
+    }
+    return b->lat[(uint64_t)(b->num_lat - 1) * pct / 100];
+}
+
+static void _print_stream_stats(const char *name, const BLURAY_STREAM_STATS *s)
+{
+    if (!s->read_calls) {
+        return;
+    }
+    printf("  %-8s %10"PRIu64" bytes %8u reads %4u errors %4u opens %4u seeks\n",
+           name, s->bytes_read, s->read_calls, s->read_errors, s->clip_opens, s->seeks);
+    printf("  %-8s read %.3f s (decrypt %.3f s, bd+ %.3f s) filter %.3f s decode %.3f s\n",
+           "", s->read_time / 1e6, s->decrypt_time / 1e6, s->bdplus_time / 1e6,
+           s->filter_time / 1e6, s->decode_time / 1e6);
+}
+
+static void _print_results(BLURAY *bd, unsigned title, BENCH *b)
+{
+    BLURAY_STATS stats;
+    double       secs = b->wall_us / 1e6;
+    double       cpu  = (double)b->cpu / CLOCKS_PER_SEC;
+
+    qsort(b->lat, b->num_lat, sizeof(uint32_t), _cmp_u32);
+
+    printf("title %u: %"PRIu64" bytes in %.3f s (%"PRIu64" us): %.2f MB/s, cpu %.3f s (%.1f%%)\n",
+           title, b->bytes, secs, b->wall_us, secs > 0 ? b->bytes / secs / 1e6 : 0.0,
+           cpu, secs > 0 ? 100.0 * cpu / secs : 0.0);
+    printf("  latency: %u calls, p50 %u us, p99 %u us, max %u us\n",
+           b->num_lat, _percentile(b, 50), _percentile(b, 99), _percentile(b, 100));
+    printf("  clip boundaries: %u, avg %u us, max %u us\n",
+           b->num_stalls, b->num_stalls ? (unsigned)(b->stall_us / b->num_stalls) : 0, b->max_stall_us);
+
+    if (bd_get_stats(bd, &stats)) {
+        _print_stream_stats("main",    &stats.main);
+        _print_stream_stats("preload", &stats.preload);
+        _print_stream_stats("textst",  &stats.textst);
+        printf("  event queue high-water mark: %u (statistics are cumulative)\n", stats.event_queue_max);
+    }
+}
+
+static int _bench_title(BLURAY *bd, unsigned title, unsigned buf_size, int use_ext, uint64_t limit)
+{
+    BLURAY_TITLE_INFO *ti;
+    BENCH      b;
+    uint8_t   *buf;
+    uint64_t  *clip_end;
+    unsigned   ii, next_clip = 0;
+    uint64_t   t0, pos;
+
+    if (!bd_select_title(bd, title)) {
+        fprintf(stderr, "Failed to open title %u\n", title);
+        return -1;
+    }
+
+    ti = bd_get_title_info(bd, title, 0);
+    if (!ti) {
+        return -1;
+    }
+
+    /* clip boundaries (title byte positions) */
+    clip_end = calloc(ti->clip_count + 1, sizeof(uint64_t));
+    buf      = malloc(buf_size);
+    if (!clip_end || !buf) {
+        free(clip_end);
+        free(buf);
+        bd_free_title_info(ti);
+        return -1;
+    }
+    for (ii = 0, pos = 0; ii < ti->clip_count; ii++) {
+        pos += (uint64_t)ti->clips[ii].pkt_count * 192;
+        clip_end[ii] = pos;
+    }
+
+    memset(&b, 0, sizeof(b));
+
+    if (use_ext) {
+        bd_get_event(bd, NULL);
+    }
+
+    b.cpu = clock();
+    t0    = _now_us();
+
+    while (!limit || b.bytes < limit) {
+        uint64_t start = _now_us();
+        int      bytes;
+
+        if (use_ext) {
+            BD_EVENT ev;
+            bytes = bd_read_ext(bd, buf, buf_size, &ev);
+            if (ev.event == BD_EVENT_END_OF_TITLE || ev.event == BD_EVENT_PLAYLIST_STOP ||
+                ev.event == BD_EVENT_ERROR || ev.event == BD_EVENT_READ_ERROR) {
+                break;
+            }
+            if (bytes == 0 && ev.event != BD_EVENT_NONE) {
+                /* event only */
+                continue;
+            }
+        } else {
+            bytes = bd_read(bd, buf, buf_size);
+        }
+
+        uint32_t us = (uint32_t)(_now_us() - start);
+
+        if (bytes <= 0) {
+            break;
+        }
+
+        _add_latency(&b, us);
+        b.bytes += bytes;
+
+        pos = bd_tell(bd);
+        if (next_clip + 1 < ti->clip_count && pos > clip_end[next_clip]) {
+            while (next_clip + 1 < ti->clip_count && pos > clip_end[next_clip]) {
+                next_clip++;
+            }
+            b.num_stalls++;
+            b.stall_us += us;
+            if (us > b.max_stall_us) {
+                b.max_stall_us = us;
+            }
+        }
+    }
+
+    b.wall_us = _now_us() - t0;
+    b.cpu     = clock() - b.cpu;
+
+    _print_results(bd, title + 1, &b);
+
+    free(b.lat);
+    free(clip_end);
+    free(buf);
+    bd_free_title_info(ti);
+
+    return 0;
+}
+
+static void _usage(const char *cmd)
+{
+    fprintf(stderr,
+"Usage: %s [-t title | -a] [-b buffer size] [-l limit] [-e] [-r read-ahead] [-d threads] [-k keyfile] [-T trace] <bd path>\n"
+"Options:\n"
+"    t N         - Title to read. First title is 1 (default: main title).\n"
+"    a           - Read all titles.\n"
+"    b N         - Read buffer size in bytes (default %d).\n"
+"    l N         - Stop each title after N MB.\n"
+"    e           - Use bd_read_ext() instead of bd_read().\n"
+"    r N         - Read-ahead buffer size in aligned units.\n"
+"    d N         - Number of AACS decryption threads.\n"
+"    k keyfile   - AACS keyfile path.\n"
+"    T trace     - Record file I/O trace (replay with io_replay).\n"
+"    <bd path>   - Path to root of Blu-Ray directory tree or image.\n"
+, cmd, DEFAULT_BUF_SIZE);
+
+    exit(EXIT_FAILURE);
+}
+
+#define OPTS "t:ab:l:er:d:k:T:"
+
+int main(int argc, char *argv[])
+{
+    BLURAY     *bd;
+    const char *keyfile   = NULL;
+    const char *trace     = NULL;
+    int         title     = -1;
+    int         all       = 0;
+    int         use_ext   = 0;
+    int         read_ahead = -1;
+    int         threads   = -1;
+    unsigned    buf_size  = DEFAULT_BUF_SIZE;
+    uint64_t    limit     = 0;
+    int         opt, count, ii;
+
+    while ((opt = getopt(argc, argv, OPTS)) != -1) {
+        switch (opt) {
+            case 't': title = atoi(optarg) - 1;                 break;
+            case 'a': all = 1;                                  break;
+            case 'b': buf_size = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'l': limit = strtoull(optarg, NULL, 0) * 1024 * 1024; break;
+            case 'e': use_ext = 1;                              break;
+            case 'r': read_ahead = atoi(optarg);                break;
+            case 'd': threads = atoi(optarg);                   break;
+            case 'k': keyfile = optarg;                         break;
+            case 'T': trace = optarg;                           break;
+            default:  _usage(argv[0]);
+        }
+    }
+
+    if (optind != argc - 1 || buf_size < 192) {
+        _usage(argv[0]);
+    }
+
+    if (trace && !bd_set_io_trace(trace)) {
+        fprintf(stderr, "Failed to create I/O trace: %s\n", trace);
+        return 1;
+    }
+
+    bd = bd_open(argv[optind], keyfile);
+    if (!bd) {
+        fprintf(stderr, "Failed to open disc: %s\n", argv[optind]);
+        bd_set_io_trace(NULL);
+        return 1;
+    }
+
+    if (read_ahead >= 0) {
+        bd_set_player_setting(bd, BLURAY_PLAYER_SETTING_READ_AHEAD, read_ahead);
+    }
+    if (threads >= 0) {
+        bd_set_player_setting(bd, BLURAY_PLAYER_SETTING_DECRYPT_THREADS, threads);
+    }
+
+    count = bd_get_titles(bd, TITLES_RELEVANT, 0);
+    if (count <= 0) {
+        fprintf(stderr, "No titles found: %s\n", argv[optind]);
+        bd_close(bd);
+        bd_set_io_trace(NULL);
+        return 1;
+    }
+
+    if (all) {
+        for (ii = 0; ii < count; ii++) {
+            _bench_title(bd, ii, buf_size, use_ext, limit);
+        }
+    } else {
+        if (title < 0) {
+            title = bd_get_main_title(bd);
+        }
+        if (title < 0 || title >= count) {
+            fprintf(stderr, "Invalid title\n");
+            bd_close(bd);
+            bd_set_io_trace(NULL);
+            return 1;
+        }
+        _bench_title(bd, title, buf_size, use_ext, limit);
+    }
+
+    bd_close(bd);
+    bd_set_io_trace(NULL);
+    return 0;
+}
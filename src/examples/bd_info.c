@@ -19,8 +19,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 #include <unistd.h>
+#include <sys/time.h>
 
 #include "libbluray/bdnav/meta_data.h"
 #include "libbluray/bluray.h"
@@ -141,27 +143,135 @@ static void _print_app_info(const BLURAY_DISC_INFO *info)
     printf("  provider data           : \'%32s\'\n",  info->provider_data);
 }
 
+static void _print_profile_item(const char *name, uint64_t us)
+{
+    if (us) {
+        printf("  %-24s: %"PRIu64".%03u ms\n", name, us / 1000, (unsigned)(us % 1000));
+    }
+}
+
+static void _print_startup_profile(const BLURAY_STARTUP_PROFILE *p)
+{
+    if (!p) {
+        return;
+    }
+
+    printf("\nStartup profile:\n");
+    _print_profile_item("open",              p->open_us);
+    _print_profile_item("  disc open",       p->disc_open_us);
+    _print_profile_item("    AACS/BD+ init", p->dec_init_us);
+    _print_profile_item("  disc info",       p->fill_disc_info_us);
+    _print_profile_item("    index.bdmv",    p->index_parse_us);
+    _print_profile_item("title scan",        p->title_scan_us);
+    _print_profile_item("MovieObject.bdmv",  p->mobj_parse_us);
+    _print_profile_item("BD-J start",        p->bdj_start_us);
+    _print_profile_item("  create JVM",      p->create_jvm_us);
+    _print_profile_item("  BD-J init",       p->bdj_init_us);
+    _print_profile_item("first title",       p->first_title_us);
+}
+
+/*
+ * --profile
+ */
+
+static uint64_t _now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void _print_kb(const char *name, uint64_t bytes)
+{
+    printf("  %-24s: %"PRIu64" kB\n", name, (bytes + 1023) / 1024);
+}
+
+static void _profile_titles(BLURAY *bd)
+{
+    uint64_t t0;
+    uint32_t num_all, num_relevant, ii;
+
+    t0 = _now_us();
+    num_all = bd_get_titles(bd, TITLES_ALL, 0);
+    _print_profile_item("bd_get_titles(all)", _now_us() - t0);
+    printf("  %-24s: %u\n", "  titles", num_all);
+
+    t0 = _now_us();
+    num_relevant = bd_get_titles(bd, TITLES_RELEVANT, 0);
+    _print_profile_item("bd_get_titles(relevant)", _now_us() - t0);
+    printf("  %-24s: %u\n", "  titles", num_relevant);
+
+    t0 = _now_us();
+    for (ii = 0; ii < num_relevant; ii++) {
+        BLURAY_TITLE_INFO *ti = bd_get_title_info(bd, ii, 0);
+        bd_free_title_info(ti);
+    }
+    _print_profile_item("bd_get_title_info(all)", _now_us() - t0);
+}
+
+static void _print_memory_usage(BLURAY *bd)
+{
+    BLURAY_MEMORY_USAGE mem;
+
+    if (!bd_get_memory_usage(bd, &mem)) {
+        return;
+    }
+
+    printf("\nMemory usage:\n");
+    _print_kb("playlist",     mem.playlist);
+    _print_kb("title list",   mem.title_list);
+    _print_kb("graphics",     mem.graphics);
+    _print_kb("TextST",       mem.textst);
+    _print_kb("event queue",  mem.event_queue);
+    _print_kb("read buffers", mem.read_buffers);
+    _print_kb("total",        mem.total);
+}
+
 int main(int argc, char *argv[])
 {
-    const char *disc_root = (argc > 1) ? argv[1] : NULL;
-    const char *keyfile   = (argc > 2) ? argv[2] : NULL;
+    const char *disc_root = NULL;
+    const char *keyfile   = NULL;
+    int         profile   = 0;
+    uint64_t    t0, open_us, info_us, meta_us;
+    int         ii;
+
+    for (ii = 1; ii < argc; ii++) {
+        if (!strcmp(argv[ii], "--profile")) {
+            profile = 1;
+        } else if (!disc_root) {
+            disc_root = argv[ii];
+        } else if (!keyfile) {
+            keyfile = argv[ii];
+        }
+    }
 
     if (!disc_root) {
         fprintf(stderr,
-                "%s <BD base dir> [keyfile]\n"
-                "   Show BD disc info\n",
+                "%s [--profile] <BD base dir> [keyfile]\n"
+                "   Show BD disc info\n"
+                "   --profile: show API call timings and memory usage\n",
                 argv[0]);
         exit(EXIT_FAILURE);
     }
 
 
-    BLURAY *bd = bd_open(disc_root, keyfile);
+    BLURAY *bd = bd_init();
     if (!bd) {
+        fprintf(stderr, "bd_init() failed.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    t0 = _now_us();
+    if (!bd_open_disc(bd, disc_root, keyfile)) {
         fprintf(stderr, "bd_open('%s', '%s') failed.\n", disc_root, keyfile);
+        bd_close(bd);
         exit(EXIT_FAILURE);
     }
+    open_us = _now_us() - t0;
 
+    t0 = _now_us();
     const BLURAY_DISC_INFO *info = bd_get_disc_info(bd);
+    info_us = _now_us() - t0;
     if (!info) {
         fprintf(stderr, "bd_get_disc_info() failed.\n");
         exit(EXIT_FAILURE);
@@ -220,7 +330,23 @@ int main(int argc, char *argv[])
 
     _print_app_info(info);
 
-    _print_meta(bd_get_meta(bd));
+    t0 = _now_us();
+    const META_DL *meta = bd_get_meta(bd);
+    meta_us = _now_us() - t0;
+
+    _print_meta(meta);
+
+    _print_startup_profile(bd_get_startup_profile(bd));
+
+    if (profile) {
+        printf("\nAPI profile:\n");
+        _print_profile_item("bd_open_disc()",     open_us);
+        _print_profile_item("bd_get_disc_info()", info_us);
+        _print_profile_item("bd_get_meta()",      meta_us);
+        _profile_titles(bd);
+
+        _print_memory_usage(bd);
+    }
 
     bd_close(bd);
 
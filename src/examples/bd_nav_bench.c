@@ -0,0 +1,363 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Navigation latency benchmark: disc open, title / playlist selection,
+ * chapter and time seeks, first read after seek and menu startup.
+ * Results are written as JSON.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "libbluray/bluray.h"
+
+#define READ_SIZE  (6144 * 32)
+
+typedef struct {
+    unsigned count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+} TIMING;
+
+typedef struct {
+    FILE    *out;
+    int      first;  /* no separator needed before next array element */
+    uint8_t *buf;
+
+    TIMING   select;
+    TIMING   select_playlist;
+    TIMING   seek_chapter;
+    TIMING   seek_time;
+    TIMING   first_read;
+} NAV_BENCH;
+
+/* most navigation calls complete in well under 1 us: time in nanoseconds */
+static uint64_t _now_ns(void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+#endif
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return ((uint64_t)tv.tv_sec * 1000000 + tv.tv_usec) * 1000;
+}
+
+static void _add_timing(TIMING *t, uint64_t ns)
+{
+    if (!t->count || ns < t->min) t->min = ns;
+    if (ns > t->max)              t->max = ns;
+    t->total += ns;
+    t->count++;
+}
+
+static void _print_timing(FILE *out, const char *name, const TIMING *t, int last)
+{
+    fprintf(out, "    \"%s\": {\"count\": %u, \"min_ns\": %"PRIu64", \"avg_ns\": %"PRIu64", \"max_ns\": %"PRIu64"}%s\n",
+            name, t->count, t->min, t->count ? t->total / t->count : 0, t->max, last ? "" : ",");
+}
+
+static void _print_string(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', out);
+        }
+        if ((unsigned char)*s >= 0x20) {
+            fputc(*s, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/* deterministic pseudo-random numbers (same sequence on every platform) */
+static uint32_t _rand(uint32_t *state)
+{
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 8;
+}
+
+/*
+ * stream access through bd_open_stream()
+ */
+
+static int _read_blocks(void *handle, void *buf, int lba, int num_blocks)
+{
+    FILE *fp = (FILE *)handle;
+
+    if (fseeko(fp, (off_t)lba * 2048, SEEK_SET) < 0) {
+        return -1;
+    }
+    return (int)fread(buf, 2048, num_blocks, fp);
+}
+
+/*
+ * benchmarks
+ */
+
+static uint64_t _timed_read(NAV_BENCH *b, BLURAY *bd)
+{
+    uint64_t t0 = _now_ns();
+    bd_read(bd, b->buf, READ_SIZE);
+    uint64_t ns = _now_ns() - t0;
+    _add_timing(&b->first_read, ns);
+    return ns;
+}
+
+static void _bench_title(NAV_BENCH *b, BLURAY *bd, unsigned title, unsigned num_seeks, uint32_t *seed)
+{
+    BLURAY_TITLE_INFO *ti;
+    uint64_t t0, ns;
+    unsigned ii;
+    int      ok;
+
+    t0 = _now_ns();
+    ok = bd_select_title(bd, title);
+    ns = _now_ns() - t0;
+    _add_timing(&b->select, ns);
+
+    fprintf(b->out, "%s\n    {\"title\": %u, \"select_ns\": %"PRIu64", \"ok\": %d",
+            b->first ? "" : ",", title + 1, ns, ok);
+    b->first = 0;
+
+    ti = ok ? bd_get_title_info(bd, title, 0) : NULL;
+    if (!ti) {
+        fprintf(b->out, "}");
+        return;
+    }
+
+    t0 = _now_ns();
+    ok = bd_select_playlist(bd, ti->playlist);
+    ns = _now_ns() - t0;
+    _add_timing(&b->select_playlist, ns);
+
+    fprintf(b->out, ", \"playlist\": %u, \"select_playlist_ns\": %"PRIu64", \"duration\": %"PRIu64",\n     \"chapters\": [",
+            ti->playlist, ns, ti->duration);
+
+    for (ii = 0; ii < ti->chapter_count; ii++) {
+        t0 = _now_ns();
+        int64_t pos = bd_seek_chapter(bd, ii);
+        ns = _now_ns() - t0;
+        _add_timing(&b->seek_chapter, ns);
+
+        fprintf(b->out, "%s\n       {\"chapter\": %u, \"pos\": %"PRId64", \"seek_ns\": %"PRIu64", \"read_ns\": %"PRIu64"}",
+                ii ? "," : "", ii + 1, pos, ns, _timed_read(b, bd));
+    }
+
+    fprintf(b->out, "],\n     \"seeks\": [");
+
+    for (ii = 0; ii < num_seeks && ti->duration > 0; ii++) {
+        uint64_t tick = ((uint64_t)_rand(seed) << 24 | _rand(seed)) % ti->duration;
+
+        t0 = _now_ns();
+        int64_t pos = bd_seek_time(bd, tick);
+        ns = _now_ns() - t0;
+        _add_timing(&b->seek_time, ns);
+
+        fprintf(b->out, "%s\n       {\"time\": %"PRIu64", \"pos\": %"PRId64", \"seek_ns\": %"PRIu64", \"read_ns\": %"PRIu64"}",
+                ii ? "," : "", tick, pos, ns, _timed_read(b, bd));
+    }
+
+    fprintf(b->out, "]}");
+
+    bd_free_title_info(ti);
+}
+
+/* time from bd_play() to first stream data (or max_calls bd_read_ext() calls) */
+static void _bench_play(NAV_BENCH *b, BLURAY *bd, unsigned max_calls)
+{
+    uint64_t t0, play_ns, data_ns = 0;
+    unsigned calls;
+    int      ok;
+
+    bd_get_event(bd, NULL);
+
+    t0 = _now_ns();
+    ok = bd_play(bd);
+    play_ns = _now_ns() - t0;
+
+    for (calls = 0; ok && calls < max_calls; calls++) {
+        BD_EVENT ev;
+        int bytes = bd_read_ext(bd, b->buf, READ_SIZE, &ev);
+        if (bytes > 0) {
+            data_ns = _now_ns() - t0;
+            break;
+        }
+        if (bytes < 0 || ev.event == BD_EVENT_ERROR) {
+            break;
+        }
+        if (ev.event == BD_EVENT_STILL_TIME || ev.event == BD_EVENT_IDLE) {
+            /* menu without video: skip still */
+            bd_read_skip_still(bd);
+        }
+    }
+
+    fprintf(b->out, "  \"play\": {\"ok\": %d, \"play_ns\": %"PRIu64", \"first_data_ns\": %"PRIu64", \"calls\": %u},\n",
+            ok, play_ns, data_ns, calls);
+}
+
+static void _usage(const char *cmd)
+{
+    fprintf(stderr,
+"Usage: %s [-t title] [-n seeks] [-r seed] [-s] [-m] [-o file] [-k keyfile] <bd path>\n"
+"Options:\n"
+"    t N         - Benchmark only title N. First title is 1 (default: all titles).\n"
+"    n N         - Number of random time seeks per title (default 20).\n"
+"    r N         - Random seed (default 1).\n"
+"    s           - Read disc image through bd_open_stream() callback.\n"
+"    m           - Measure bd_play() (menu mode) startup.\n"
+"    o file      - Write JSON to file (default stdout).\n"
+"    k keyfile   - AACS keyfile path.\n"
+"    <bd path>   - Path to Blu-Ray directory tree or disc image.\n"
+, cmd);
+
+    exit(EXIT_FAILURE);
+}
+
+#define OPTS "t:n:r:smo:k:"
+
+int main(int argc, char *argv[])
+{
+    NAV_BENCH   b;
+    BLURAY     *bd;
+    FILE       *image = NULL;
+    const char *keyfile = NULL, *outfile = NULL, *mode;
+    const char *path;
+    struct stat st;
+    uint32_t    seed = 1;
+    unsigned    num_seeks = 20;
+    int         title = -1, use_stream = 0, play = 0;
+    int         opt, count, ii, ok;
+    uint64_t    t0, open_ns, titles_ns;
+
+    while ((opt = getopt(argc, argv, OPTS)) != -1) {
+        switch (opt) {
+            case 't': title = atoi(optarg) - 1;                  break;
+            case 'n': num_seeks = (unsigned)atoi(optarg);        break;
+            case 'r': seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 's': use_stream = 1;                            break;
+            case 'm': play = 1;                                  break;
+            case 'o': outfile = optarg;                          break;
+            case 'k': keyfile = optarg;                          break;
+            default:  _usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1) {
+        _usage(argv[0]);
+    }
+    path = argv[optind];
+
+    memset(&b, 0, sizeof(b));
+    b.first = 1;
+    b.out   = outfile ? fopen(outfile, "w") : stdout;
+    b.buf   = malloc(READ_SIZE);
+    if (!b.out || !b.buf) {
+        fprintf(stderr, "Failed to open output\n");
+        return 1;
+    }
+
+    mode = (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) ? "folder" : "image";
+
+    t0 = _now_ns();
+    bd = bd_init();
+    if (use_stream) {
+        mode  = "stream";
+        image = fopen(path, "rb");
+        ok    = bd && image && bd_open_stream(bd, image, _read_blocks);
+    } else {
+        ok    = bd && bd_open_disc(bd, path, keyfile);
+    }
+    open_ns = _now_ns() - t0;
+
+    if (!ok) {
+        fprintf(stderr, "Failed to open disc: %s\n", path);
+        return 1;
+    }
+
+    t0 = _now_ns();
+    count = bd_get_titles(bd, TITLES_RELEVANT, 0);
+    titles_ns = _now_ns() - t0;
+
+    fprintf(b.out, "{\n  \"disc\": ");
+    _print_string(b.out, path);
+    fprintf(b.out, ",\n  \"mode\": \"%s\",\n", mode);
+    fprintf(b.out, "  \"open_ns\": %"PRIu64",\n  \"get_titles_ns\": %"PRIu64",\n  \"num_titles\": %d,\n",
+            open_ns, titles_ns, count);
+
+    if (play) {
+        _bench_play(&b, bd, 1000);
+
+        /* restart in title mode */
+        bd_close(bd);
+        bd = bd_init();
+        if (use_stream) {
+            ok = bd && bd_open_stream(bd, image, _read_blocks);
+        } else {
+            ok = bd && bd_open_disc(bd, path, keyfile);
+        }
+        if (!ok) {
+            fprintf(stderr, "Failed to re-open disc: %s\n", path);
+            return 1;
+        }
+        count = bd_get_titles(bd, TITLES_RELEVANT, 0);
+    }
+
+    fprintf(b.out, "  \"titles\": [");
+    for (ii = 0; ii < count; ii++) {
+        if (title < 0 || title == ii) {
+            _bench_title(&b, bd, ii, num_seeks, &seed);
+        }
+    }
+    fprintf(b.out, "\n  ],\n  \"summary\": {\n");
+
+    _print_timing(b.out, "select_title", &b.select,       0);
+    _print_timing(b.out, "select_playlist", &b.select_playlist, 0);
+    _print_timing(b.out, "seek_chapter", &b.seek_chapter, 0);
+    _print_timing(b.out, "seek_time",    &b.seek_time,    0);
+    _print_timing(b.out, "first_read",   &b.first_read,   1);
+
+    fprintf(b.out, "  }\n}\n");
+
+    bd_close(bd);
+    if (image) {
+        fclose(image);
+    }
+    if (outfile) {
+        fclose(b.out);
+    }
+    free(b.buf);
+
+    return 0;
+}
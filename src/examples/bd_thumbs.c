@@ -0,0 +1,463 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Chapter thumbnail extraction
+ *
+ * For each chapter of a title, the random access point (EP map entry) at or
+ * before chapter start is looked up and only the data up to the next random
+ * access point is read. Result is a short TS snippet starting with I-frame,
+ * ready for a video decoder.
+ *
+ * Chapters are extracted in parallel. Each worker has its own BLURAY object;
+ * objects share the AACS session and parsed playlist cache.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "libbluray/bluray.h"
+
+#define PKT_SIZE      192
+#define UNIT_SIZE     (PKT_SIZE * 32)
+#define BUF_SIZE      (UNIT_SIZE * 32)
+#define DEFAULT_JOBS  4
+#define DEFAULT_MAX_KB 4096
+
+static void
+_usage(char *cmd)
+{
+    fprintf(stderr,
+"Usage: %s [-t title] [-a angle] [-j jobs] [-s max kB] [-m] [-k keyfile] <bd path> <dest dir>\n"
+"Summary:\n"
+"    Extract I-frame nearest to start of each chapter as short\n"
+"    transport stream snippet (chapterNNN.ts) for thumbnail decoding.\n"
+"Options:\n"
+"    t N         - Index of title. First title is 1. Default: main title.\n"
+"    a N         - Angle. First angle is 1.\n"
+"    j N         - Number of parallel jobs (default: %d).\n"
+"    s N         - Max. snippet size in kB (default: %d).\n"
+"    m           - Keep 192-byte M2TS packets (chapterNNN.m2ts).\n"
+"    k keyfile   - AACS keyfile path.\n"
+"    <bd path>   - Path to root of Blu-Ray directory tree.\n"
+"    <dest dir>  - Destination directory of snippets.\n"
+, cmd, DEFAULT_JOBS, DEFAULT_MAX_KB);
+
+    exit(EXIT_FAILURE);
+}
+
+typedef struct {
+    unsigned  chapter;
+    uint64_t  time;       /* chapter start */
+    uint64_t  kf_time;    /* random access point */
+    uint64_t  offset;     /* title byte position of random access point */
+    uint64_t  size;       /* bytes to read */
+
+    /* result */
+    int       error;
+    uint64_t  bytes;
+    uint64_t  time_us;
+} THUMB_JOB;
+
+typedef struct {
+    const char      *bdpath;
+    const char      *keyfile;
+    const char      *dest;
+    unsigned         title;
+    unsigned         angle;
+    int              m2ts;
+
+    pthread_mutex_t  mutex;
+    THUMB_JOB       *jobs;
+    unsigned         num_jobs;
+    unsigned         next_job;
+} THUMB_QUEUE;
+
+static uint64_t _now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static BLURAY *_open_shared(const char *bdpath, const char *keyfile)
+{
+    BLURAY *bd = bd_init();
+    if (!bd) {
+        return NULL;
+    }
+
+    bd_set_player_setting(bd, BLURAY_PLAYER_SETTING_SHARED_DECRYPT, 1);
+
+    if (!bd_open_disc(bd, bdpath, keyfile)) {
+        bd_close(bd);
+        return NULL;
+    }
+
+    bd_set_player_setting(bd, BLURAY_PLAYER_SETTING_SHARED_CACHE, 1);
+
+    /* title list is needed for bd_select_title() */
+    if (bd_get_titles(bd, TITLES_RELEVANT, 0) <= 0) {
+        bd_close(bd);
+        return NULL;
+    }
+
+    return bd;
+}
+
+/* last random access point at or before given time */
+static const BLURAY_KEYFRAME *_find_keyframe(const BLURAY_KEYFRAME *kf, uint32_t count, uint64_t time)
+{
+    uint32_t lo = 0, hi = count;
+
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (kf[mid].time <= time) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return &kf[lo];
+}
+
+/* write TS packets (drop 4-byte M2TS header) */
+static int _write_ts(FILE *out, const uint8_t *buf, int len)
+{
+    int ii;
+
+    for (ii = 0; ii + PKT_SIZE <= len; ii += PKT_SIZE) {
+        if (fwrite(buf + ii + 4, 1, PKT_SIZE - 4, out) != PKT_SIZE - 4) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int _thumb_job(THUMB_QUEUE *q, BLURAY *bd, THUMB_JOB *job, uint8_t *buf)
+{
+    FILE    *out;
+    char    *path;
+    int64_t  pos;
+    uint64_t left;
+    int      result = 0;
+
+    pos = bd_seek(bd, job->offset);
+    if (pos < 0 || (uint64_t)pos > job->offset) {
+        fprintf(stderr, "Seek failed: chapter %u\n", job->chapter + 1);
+        return -1;
+    }
+    /* seek may land at start of aligned unit */
+    left = job->size + (job->offset - pos);
+
+    path = malloc(strlen(q->dest) + 32);
+    if (!path) {
+        return -1;
+    }
+    sprintf(path, "%s/chapter%03u.%s", q->dest, job->chapter + 1, q->m2ts ? "m2ts" : "ts");
+
+    out = fopen(path, "wb");
+    if (!out) {
+        fprintf(stderr, "Failed to open destination: %s\n", path);
+        free(path);
+        return -1;
+    }
+
+    while (left > 0) {
+        int bytes = bd_read(bd, buf, left < BUF_SIZE ? (int)left : BUF_SIZE);
+        if (bytes <= 0) {
+            if (bytes < 0) {
+                fprintf(stderr, "Read error in chapter %u\n", job->chapter + 1);
+                result = -1;
+            }
+            break;
+        }
+
+        if (q->m2ts ? fwrite(buf, 1, bytes, out) != (size_t)bytes : _write_ts(out, buf, bytes) < 0) {
+            perror("Write error");
+            result = -1;
+            break;
+        }
+        job->bytes += bytes;
+        left -= bytes;
+    }
+
+    if (fclose(out)) {
+        perror("Write error");
+        result = -1;
+    }
+    free(path);
+
+    return result;
+}
+
+static void *_thumb_worker(void *arg)
+{
+    THUMB_QUEUE *q = (THUMB_QUEUE *)arg;
+    BLURAY      *bd;
+    uint8_t     *buf;
+
+    buf = malloc(BUF_SIZE);
+    if (!buf) {
+        return NULL;
+    }
+
+    bd = _open_shared(q->bdpath, q->keyfile);
+    if (!bd || !bd_select_title(bd, q->title)) {
+        fprintf(stderr, "Failed to open title: %u\n", q->title + 1);
+        if (bd) {
+            bd_close(bd);
+        }
+        free(buf);
+        return NULL;
+    }
+    bd_select_angle(bd, q->angle);
+
+    while (1) {
+        THUMB_JOB *job = NULL;
+        uint64_t   t0;
+
+        pthread_mutex_lock(&q->mutex);
+        if (q->next_job < q->num_jobs) {
+            job = &q->jobs[q->next_job++];
+        }
+        pthread_mutex_unlock(&q->mutex);
+
+        if (!job) {
+            break;
+        }
+
+        t0 = _now_us();
+        job->error   = _thumb_job(q, bd, job, buf);
+        job->time_us = _now_us() - t0;
+
+        fprintf(stderr, "chapter %3u: %02u:%02u:%02u (keyframe %+6.2f s) %6"PRIu64" kB  %7.1f ms%s\n",
+                job->chapter + 1,
+                (unsigned)(job->time / 90000 / 3600),
+                (unsigned)(job->time / 90000 / 60 % 60),
+                (unsigned)(job->time / 90000 % 60),
+                ((int64_t)job->kf_time - (int64_t)job->time) / 90000.0,
+                job->bytes / 1024, job->time_us / 1000.0,
+                job->error ? "  FAILED" : "");
+    }
+
+    bd_close(bd);
+    free(buf);
+    return NULL;
+}
+
+/* one job per chapter: read from random access point to the next one */
+static int _build_jobs(THUMB_QUEUE *q, BLURAY *bd, uint64_t max_size)
+{
+    BLURAY_TITLE_INFO *ti;
+    BLURAY_KEYFRAME   *kf;
+    uint32_t           num_kf = 0;
+    uint64_t           title_size;
+    unsigned           ii;
+
+    ti = bd_get_title_info(bd, q->title, q->angle);
+    if (!ti || !ti->chapter_count) {
+        fprintf(stderr, "No chapters in title %u\n", q->title + 1);
+        bd_free_title_info(ti);
+        return -1;
+    }
+
+    kf = bd_get_keyframes(bd, q->title, q->angle, &num_kf);
+    if (!kf) {
+        fprintf(stderr, "No random access points in title %u\n", q->title + 1);
+        bd_free_title_info(ti);
+        return -1;
+    }
+
+    q->jobs = calloc(ti->chapter_count, sizeof(THUMB_JOB));
+    if (!q->jobs) {
+        bd_free_keyframes(kf);
+        bd_free_title_info(ti);
+        return -1;
+    }
+
+    title_size = bd_get_title_size(bd);
+
+    for (ii = 0; ii < ti->chapter_count; ii++) {
+        const BLURAY_KEYFRAME *k = _find_keyframe(kf, num_kf, ti->chapters[ii].start);
+        uint64_t               end = (k + 1 < kf + num_kf) ? k[1].offset : title_size;
+        THUMB_JOB             *job = &q->jobs[q->num_jobs++];
+
+        job->chapter = ii;
+        job->time    = ti->chapters[ii].start;
+        job->kf_time = k->time;
+        job->offset  = k->offset;
+        job->size    = end > k->offset ? end - k->offset : 0;
+        if (job->size < UNIT_SIZE) {
+            job->size = UNIT_SIZE;
+        }
+        if (job->size > max_size) {
+            job->size = max_size;
+        }
+    }
+
+    bd_free_keyframes(kf);
+    bd_free_title_info(ti);
+    return 0;
+}
+
+#define OPTS "t:a:j:s:mk:"
+
+int
+main(int argc, char *argv[])
+{
+    THUMB_QUEUE q;
+    BLURAY     *bd;
+    pthread_t  *threads;
+    uint64_t    t0, total = 0, time_us, max_size = (uint64_t)DEFAULT_MAX_KB * 1024;
+    unsigned    ii;
+    int         title_no = -1, num_threads = DEFAULT_JOBS;
+    int         num_started = 0, errors = 0;
+    int         opt;
+
+    memset(&q, 0, sizeof(q));
+
+    do {
+        opt = getopt(argc, argv, OPTS);
+        switch (opt) {
+            case -1:
+                break;
+
+            case 't':
+                title_no = atoi(optarg) - 1;
+                if (title_no < 0) {
+                    _usage(argv[0]);
+                }
+                break;
+
+            case 'a':
+                if (atoi(optarg) <= 0) {
+                    _usage(argv[0]);
+                }
+                q.angle = atoi(optarg) - 1;
+                break;
+
+            case 'j':
+                num_threads = atoi(optarg);
+                if (num_threads <= 0) {
+                    _usage(argv[0]);
+                }
+                break;
+
+            case 's':
+                max_size = (uint64_t)atoi(optarg) * 1024;
+                if (max_size < UNIT_SIZE) {
+                    _usage(argv[0]);
+                }
+                break;
+
+            case 'm':
+                q.m2ts = 1;
+                break;
+
+            case 'k':
+                q.keyfile = optarg;
+                break;
+
+            default:
+                _usage(argv[0]);
+                break;
+        }
+    } while (opt != -1);
+
+    if (optind + 2 != argc) {
+        _usage(argv[0]);
+    }
+    q.bdpath = argv[optind];
+    q.dest   = argv[optind + 1];
+
+    t0 = _now_us();
+
+    /* first object keeps shared session and cache alive */
+    bd = _open_shared(q.bdpath, q.keyfile);
+    if (!bd) {
+        fprintf(stderr, "Failed to open disc (or no titles found): %s\n", q.bdpath);
+        return 1;
+    }
+    if (title_no < 0) {
+        title_no = bd_get_main_title(bd);
+    }
+    if (title_no < 0 || !bd_select_title(bd, title_no)) {
+        fprintf(stderr, "Failed to open title: %d\n", title_no + 1);
+        bd_close(bd);
+        return 1;
+    }
+    q.title = title_no;
+
+    if (_build_jobs(&q, bd, max_size) < 0) {
+        bd_close(bd);
+        return 1;
+    }
+
+    if (num_threads > (int)q.num_jobs) {
+        num_threads = q.num_jobs;
+    }
+
+    threads = calloc(num_threads, sizeof(pthread_t));
+    if (!threads) {
+        free(q.jobs);
+        bd_close(bd);
+        return 1;
+    }
+
+    pthread_mutex_init(&q.mutex, NULL);
+    for (; num_started < num_threads; num_started++) {
+        if (pthread_create(&threads[num_started], NULL, _thumb_worker, &q)) {
+            break;
+        }
+    }
+    if (!num_started) {
+        /* no threads, run jobs here */
+        _thumb_worker(&q);
+    }
+    for (ii = 0; ii < (unsigned)num_started; ii++) {
+        pthread_join(threads[ii], NULL);
+    }
+    pthread_mutex_destroy(&q.mutex);
+
+    time_us = _now_us() - t0;
+    for (ii = 0; ii < q.num_jobs; ii++) {
+        total  += q.jobs[ii].bytes;
+        /* chapters not processed (worker failed to start) count as failed */
+        errors += q.jobs[ii].error || !q.jobs[ii].bytes;
+    }
+    fprintf(stderr, "title %d: %u chapters (%d threads): %"PRIu64" kB in %.1f s, %d failed\n",
+            title_no + 1, q.num_jobs, num_started, total / 1024, time_us / 1000000.0, errors);
+
+    free(threads);
+    free(q.jobs);
+    bd_close(bd);
+
+    return errors ? 1 : 0;
+}
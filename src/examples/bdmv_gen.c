@@ -0,0 +1,797 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Synthetic BDMV tree generator for reproducible performance tests.
+ *
+ * Writes index.bdmv, MovieObject.bdmv (one HDMV title / PlayPL object per
+ * playlist), MPLS files, CLPI files with dense EP maps and m2ts files with
+ * video, PG and IG PIDs. Payload is filler: output is meant for navigation
+ * and stream access benchmarks, not for decoding.
+ * Output depends only on the options.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define PMT_PID    0x0100
+#define VIDEO_PID  0x1011
+#define PG_PID     0x1200
+#define IG_PID     0x1400
+
+#define CLIP_START 90000  /* first PTS in clip (90 kHz) */
+
+typedef struct {
+    const char *root;
+    unsigned    num_playlists;
+    unsigned    num_items;     /* play items / playlist */
+    unsigned    num_clips;
+    unsigned    clip_duration; /* seconds */
+    unsigned    ep_interval;   /* ms */
+    unsigned    bitrate;       /* kbit/s */
+    unsigned    mark_interval; /* seconds, 0 = chapter at each play item */
+} GEN;
+
+/*
+ * growable big-endian output buffer
+ */
+
+typedef struct {
+    uint8_t *p;
+    size_t   len;
+    size_t   size;
+} BUF;
+
+static void _put8(BUF *b, unsigned v)
+{
+    if (b->len >= b->size) {
+        size_t   new_size = b->size ? 2 * b->size : 4096;
+        uint8_t *tmp = realloc(b->p, new_size);
+        if (!tmp) {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        b->p    = tmp;
+        b->size = new_size;
+    }
+    b->p[b->len++] = (uint8_t)v;
+}
+
+static void _put16(BUF *b, unsigned v)
+{
+    _put8(b, v >> 8);
+    _put8(b, v);
+}
+
+static void _put32(BUF *b, uint32_t v)
+{
+    _put16(b, v >> 16);
+    _put16(b, v);
+}
+
+static void _put_str(BUF *b, const char *s)
+{
+    while (*s) {
+        _put8(b, *s++);
+    }
+}
+
+static void _put_zero(BUF *b, unsigned n)
+{
+    while (n--) {
+        _put8(b, 0);
+    }
+}
+
+static void _set16(BUF *b, size_t pos, unsigned v)
+{
+    b->p[pos]     = (uint8_t)(v >> 8);
+    b->p[pos + 1] = (uint8_t)v;
+}
+
+static void _set32(BUF *b, size_t pos, uint32_t v)
+{
+    _set16(b, pos,     v >> 16);
+    _set16(b, pos + 2, v);
+}
+
+/* patch length field at pos (length excludes the field itself) */
+static void _end_len32(BUF *b, size_t pos)
+{
+    _set32(b, pos, (uint32_t)(b->len - pos - 4));
+}
+
+static void _end_len16(BUF *b, size_t pos)
+{
+    _set16(b, pos, (unsigned)(b->len - pos - 2));
+}
+
+/*
+ * files
+ */
+
+static void _make_dir(const char *path)
+{
+    if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Can't create directory %s: %s\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+}
+
+static FILE *_open_file(const GEN *g, const char *dir, const char *name)
+{
+    char  path[1024];
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "%s/BDMV%s%s/%s", g->root, *dir ? "/" : "", dir, name);
+    fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "Can't create %s: %s\n", path, strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    return fp;
+}
+
+static void _write_buf(const GEN *g, const char *dir, const char *name, BUF *b)
+{
+    FILE *fp = _open_file(g, dir, name);
+
+    if (fwrite(b->p, 1, b->len, fp) != b->len || fclose(fp)) {
+        fprintf(stderr, "Write error: %s\n", name);
+        exit(EXIT_FAILURE);
+    }
+    b->len = 0;
+}
+
+/*
+ * index.bdmv and MovieObject.bdmv
+ */
+
+static void _put_hdmv_obj(BUF *b, unsigned id)
+{
+    _put32(b, 1u << 30);        /* object_type: HDMV */
+    _put16(b, 0);               /* playback_type: movie */
+    _put16(b, id);
+    _put32(b, 0);
+}
+
+static void _gen_index(const GEN *g, BUF *b)
+{
+    size_t   pos;
+    unsigned ii;
+
+    _put_str(b, "INDX0200");
+    _put32(b, 78);              /* index_start = 40 + 4 + 34 */
+    _put32(b, 0);               /* no extension data */
+    _put_zero(b, 24);
+
+    _put32(b, 34);              /* app_info */
+    _put8(b, 0);
+    _put8(b, 0x61);             /* 1080p, 23.976 */
+    _put_zero(b, 32);
+
+    pos = b->len;
+    _put32(b, 0);
+    _put_hdmv_obj(b, 0);        /* first play */
+    _put_hdmv_obj(b, 0);        /* top menu */
+    _put16(b, g->num_playlists);
+    for (ii = 0; ii < g->num_playlists; ii++) {
+        _put32(b, 1u << 30);    /* HDMV title, access type 0 */
+        _put16(b, 0);           /* playback_type: movie */
+        _put16(b, ii);          /* movie object */
+        _put32(b, 0);
+    }
+    _end_len32(b, pos);
+}
+
+static void _gen_mobj(const GEN *g, BUF *b)
+{
+    size_t   pos;
+    unsigned ii;
+
+    _put_str(b, "MOBJ0200");
+    _put32(b, 0);               /* no extension data */
+    _put_zero(b, 28);
+
+    pos = b->len;
+    _put32(b, 0);
+    _put32(b, 0);
+    _put16(b, g->num_playlists);
+    for (ii = 0; ii < g->num_playlists; ii++) {
+        _put16(b, 0);           /* flags */
+        _put16(b, 1);           /* num_cmds */
+
+        /* PlayPL <ii>: op_cnt 1, grp BRANCH, sub_grp PLAY, immediate dst */
+        _put8(b, 1 << 5 | 0 << 3 | 2);
+        _put8(b, 0x80);
+        _put16(b, 0);
+        _put32(b, ii);
+        _put32(b, 0);
+    }
+    _end_len32(b, pos);
+}
+
+/*
+ * MPLS
+ */
+
+static void _put_stream(BUF *b, unsigned pid, unsigned coding_type)
+{
+    _put8(b, 9);                /* stream entry */
+    _put8(b, 1);                /* stream_type: play item */
+    _put16(b, pid);
+    _put_zero(b, 6);
+
+    _put8(b, 5);                /* stream attributes */
+    _put8(b, coding_type);
+    if (coding_type == 0x1b) {
+        _put8(b, 0x61);         /* 1080p, 23.976 */
+        _put_zero(b, 3);
+    } else {
+        _put_str(b, "eng");
+        _put8(b, 0);
+    }
+}
+
+static void _gen_mpls(const GEN *g, BUF *b, unsigned playlist)
+{
+    uint32_t in_time  = CLIP_START / 2;
+    uint32_t out_time = in_time + g->clip_duration * 45000;
+    size_t   pos, pos_pi, pos_stn, pos_marks, pos_count;
+    unsigned ii, num_marks = 0;
+
+    _put_str(b, "MPLS0200");
+    _put32(b, 0);               /* list_pos */
+    _put32(b, 0);               /* mark_pos */
+    _put32(b, 0);               /* no extension data */
+    _put_zero(b, 20);
+
+    _put32(b, 14);              /* AppInfo */
+    _put8(b, 0);
+    _put8(b, 1);                /* sequential playback */
+    _put16(b, 0);
+    _put_zero(b, 8);            /* UO mask */
+    _put16(b, 0);
+
+    _set32(b, 8, (uint32_t)b->len);
+    pos = b->len;
+    _put32(b, 0);
+    _put16(b, 0);
+    _put16(b, g->num_items);
+    _put16(b, 0);               /* no sub paths */
+
+    for (ii = 0; ii < g->num_items; ii++) {
+        char clip_id[16];
+
+        snprintf(clip_id, sizeof(clip_id), "%05u", (playlist * g->num_items + ii) % g->num_clips);
+
+        pos_pi = b->len;
+        _put16(b, 0);
+        _put_str(b, clip_id);
+        _put_str(b, "M2TS");
+        _put16(b, 1);           /* connection_condition 1 */
+        _put8(b, 0);            /* stc_id */
+        _put32(b, in_time);
+        _put32(b, out_time);
+        _put_zero(b, 8);        /* UO mask */
+        _put8(b, 0);
+        _put8(b, 0);            /* no still */
+        _put16(b, 0);
+
+        pos_stn = b->len;
+        _put16(b, 0);
+        _put16(b, 0);
+        _put8(b, 1);            /* video */
+        _put8(b, 0);            /* audio */
+        _put8(b, 1);            /* pg */
+        _put8(b, 1);            /* ig */
+        _put_zero(b, 3);
+        _put_zero(b, 5);
+        _put_stream(b, VIDEO_PID, 0x1b);
+        _put_stream(b, PG_PID,    0x90);
+        _put_stream(b, IG_PID,    0x91);
+        _end_len16(b, pos_stn);
+
+        _end_len16(b, pos_pi);
+    }
+    _end_len32(b, pos);
+
+    _set32(b, 12, (uint32_t)b->len);
+    pos_marks = b->len;
+    _put32(b, 0);
+    pos_count = b->len;
+    _put16(b, 0);
+    for (ii = 0; ii < g->num_items; ii++) {
+        unsigned step = g->mark_interval ? g->mark_interval * 45000 : out_time - in_time;
+        uint32_t t;
+        for (t = in_time; t < out_time; t += step) {
+            _put8(b, 0);
+            _put8(b, 1);        /* entry mark */
+            _put16(b, ii);
+            _put32(b, t);
+            _put16(b, 0xffff);
+            _put32(b, 0);
+            num_marks++;
+        }
+    }
+    _set16(b, pos_count, num_marks);
+    _end_len32(b, pos_marks);
+}
+
+/*
+ * m2ts
+ */
+
+typedef struct {
+    FILE    *fp;
+    uint32_t spn;         /* current source packet */
+    uint32_t num_packets;
+    uint64_t duration;    /* 90 kHz */
+    unsigned bitrate;     /* kbit/s */
+    uint8_t  cc_pat, cc_pmt, cc_video, cc_pg, cc_ig;
+} M2TS;
+
+static uint32_t _crc32(const uint8_t *p, unsigned len)
+{
+    uint32_t crc = 0xffffffff;
+    int      ii;
+
+    while (len--) {
+        crc ^= (uint32_t)*p++ << 24;
+        for (ii = 0; ii < 8; ii++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static uint64_t _packet_time(const M2TS *m, uint32_t spn)
+{
+    return CLIP_START + m->duration * spn / m->num_packets;
+}
+
+/* write one source packet. payload shorter than 184 bytes is stuffed with adaptation field. */
+static void _write_packet(M2TS *m, unsigned pid, int pusi, uint8_t *cc,
+                          const uint8_t *pcr_payload, const uint8_t *payload, unsigned len)
+{
+    uint8_t  pkt[192];
+    uint64_t ats = (uint64_t)m->spn * 188 * 8 * 27000 / m->bitrate;
+    unsigned hdr = 8, af_len;
+
+    memset(pkt, 0xff, sizeof(pkt));
+
+    pkt[0] = (ats >> 24) & 0x3f;
+    pkt[1] = ats >> 16;
+    pkt[2] = ats >> 8;
+    pkt[3] = ats;
+
+    pkt[4] = 0x47;
+    pkt[5] = (pusi ? 0x40 : 0) | (pid >> 8);
+    pkt[6] = pid;
+    pkt[7] = 0x10 | (*cc & 0x0f);
+    *cc = *cc + 1;
+
+    if (len < 184 || pcr_payload) {
+        af_len = 183 - len;
+        pkt[7] |= 0x20;
+        pkt[8] = af_len;
+        if (af_len > 0) {
+            pkt[9] = 0;
+            if (pcr_payload) {
+                pkt[9] = 0x10;
+                memcpy(pkt + 10, pcr_payload, 6);
+            }
+        }
+        hdr = 9 + af_len;
+    }
+    memcpy(pkt + hdr, payload, len);
+
+    if (fwrite(pkt, 1, 192, m->fp) != 192) {
+        fprintf(stderr, "Write error\n");
+        exit(EXIT_FAILURE);
+    }
+    m->spn++;
+}
+
+static void _write_section(M2TS *m, unsigned pid, uint8_t *cc, uint8_t *sec, unsigned len)
+{
+    uint8_t  buf[184];
+    uint32_t crc;
+
+    /* section_length includes CRC */
+    sec[1] = 0xb0 | (len + 4 - 3) >> 8;
+    sec[2] = len + 4 - 3;
+    crc = _crc32(sec, len);
+    sec[len++] = crc >> 24;
+    sec[len++] = crc >> 16;
+    sec[len++] = crc >> 8;
+    sec[len++] = crc;
+
+    memset(buf, 0xff, sizeof(buf));
+    buf[0] = 0;                 /* pointer_field */
+    memcpy(buf + 1, sec, len);
+    _write_packet(m, pid, 1, cc, NULL, buf, sizeof(buf));
+}
+
+static void _write_psi(M2TS *m)
+{
+    static const unsigned streams[][2] = {
+        { 0x1b, VIDEO_PID }, { 0x90, PG_PID }, { 0x91, IG_PID },
+    };
+    uint8_t  sec[64];
+    unsigned ii, len;
+
+    len = 0;
+    sec[len++] = 0x00;          /* PAT */
+    len += 2;
+    sec[len++] = 0; sec[len++] = 1;
+    sec[len++] = 0xc1; sec[len++] = 0; sec[len++] = 0;
+    sec[len++] = 0; sec[len++] = 1;
+    sec[len++] = 0xe0 | PMT_PID >> 8; sec[len++] = PMT_PID & 0xff;
+    _write_section(m, 0, &m->cc_pat, sec, len);
+
+    len = 0;
+    sec[len++] = 0x02;          /* PMT */
+    len += 2;
+    sec[len++] = 0; sec[len++] = 1;
+    sec[len++] = 0xc1; sec[len++] = 0; sec[len++] = 0;
+    sec[len++] = 0xe0 | VIDEO_PID >> 8; sec[len++] = VIDEO_PID & 0xff;
+    sec[len++] = 0xf0; sec[len++] = 0;
+    for (ii = 0; ii < sizeof(streams) / sizeof(streams[0]); ii++) {
+        sec[len++] = streams[ii][0];
+        sec[len++] = 0xe0 | streams[ii][1] >> 8;
+        sec[len++] = streams[ii][1] & 0xff;
+        sec[len++] = 0xf0; sec[len++] = 0;
+    }
+    _write_section(m, PMT_PID, &m->cc_pmt, sec, len);
+}
+
+static unsigned _put_pes_header(uint8_t *p, unsigned stream_id, unsigned payload_len, uint64_t pts)
+{
+    unsigned pes_len = payload_len ? payload_len + 8 : 0;
+
+    p[0] = 0; p[1] = 0; p[2] = 1;
+    p[3] = stream_id;
+    p[4] = pes_len >> 8;
+    p[5] = pes_len;
+    p[6] = 0x80;
+    p[7] = 0x80;                /* PTS only */
+    p[8] = 5;
+    p[9]  = 0x21 | ((pts >> 29) & 0x0e);
+    p[10] = pts >> 22;
+    p[11] = 0x01 | ((pts >> 14) & 0xfe);
+    p[12] = pts >> 7;
+    p[13] = 0x01 | ((pts << 1) & 0xfe);
+    return 14;
+}
+
+/* video access unit start: PCR + PES header */
+static void _write_video_start(M2TS *m, uint64_t pts)
+{
+    uint8_t  pcr[6], buf[184];
+    uint64_t base = pts - 9000;
+
+    pcr[0] = base >> 25;
+    pcr[1] = base >> 17;
+    pcr[2] = base >> 9;
+    pcr[3] = base >> 1;
+    pcr[4] = (base << 7) | 0x7e;
+    pcr[5] = 0;
+
+    memset(buf, 0xff, sizeof(buf));
+    _put_pes_header(buf, 0xe0, 0, pts);
+    _write_packet(m, VIDEO_PID, 1, &m->cc_video, pcr, buf, 184 - 8);
+}
+
+/* graphics display set with only END segment */
+static void _write_graphics(M2TS *m, unsigned pid, uint8_t *cc, uint64_t pts)
+{
+    uint8_t  buf[32];
+    unsigned len = _put_pes_header(buf, 0xbd, 3, pts);
+
+    buf[len++] = 0x80;          /* END_OF_DISPLAY_SET */
+    buf[len++] = 0;
+    buf[len++] = 0;
+    _write_packet(m, pid, 1, cc, NULL, buf, len);
+}
+
+static void _put_ep_map(BUF *b, const uint32_t *ep_spn, const uint64_t *ep_pts, unsigned num_ep)
+{
+    size_t   pos_count, pos_start, pos_fine;
+    unsigned ii, num_coarse = 0;
+    uint64_t last_pts = 0;
+    uint32_t last_spn = 0;
+
+    size_t ep_map_pos = b->len;
+    _put8(b, 0);
+    _put8(b, 1);                /* num_stream_pid */
+    _put16(b, VIDEO_PID);
+    pos_count = b->len;
+    _put_zero(b, 6);            /* ep_stream_type, num_coarse, num_fine */
+    _put32(b, 0);
+
+    pos_start = b->len;
+    _set32(b, pos_count + 6, (uint32_t)(pos_start - ep_map_pos));
+    _put32(b, 0);
+    for (ii = 0; ii < num_ep; ii++) {
+        if (!ii || (ep_pts[ii] >> 19) != last_pts || (ep_spn[ii] >> 17) != last_spn) {
+            _put32(b, ii << 14 | ((ep_pts[ii] >> 19) & 0x3fff));
+            _put32(b, ep_spn[ii]);
+            last_pts = ep_pts[ii] >> 19;
+            last_spn = ep_spn[ii] >> 17;
+            num_coarse++;
+        }
+    }
+
+    pos_fine = b->len;
+    _set32(b, pos_start, (uint32_t)(pos_fine - pos_start));
+    for (ii = 0; ii < num_ep; ii++) {
+        _put32(b, 1u << 28 | ((ep_pts[ii] >> 9) & 0x7ff) << 17 | (ep_spn[ii] & 0x1ffff));
+    }
+
+    /* 10 reserved, ep_stream_type 4, num_coarse 16, num_fine 18 */
+    b->p[pos_count]     = 0;
+    b->p[pos_count + 1] = 1 << 2 | (num_coarse >> 14);
+    b->p[pos_count + 2] = num_coarse >> 6;
+    b->p[pos_count + 3] = num_coarse << 2 | ((num_ep >> 16) & 3);
+    b->p[pos_count + 4] = num_ep >> 8;
+    b->p[pos_count + 5] = num_ep;
+}
+
+static void _gen_clip(const GEN *g, BUF *b, unsigned clip)
+{
+    static const unsigned streams[][2] = {
+        { VIDEO_PID, 0x1b }, { PG_PID, 0x90 }, { IG_PID, 0x91 },
+    };
+    char      name[16];
+    M2TS      m;
+    uint64_t  bytes, next_ep, next_gfx, pts = 0;
+    uint64_t *ep_pts;
+    uint32_t *ep_spn;
+    unsigned  num_ep = 0, max_ep, ii;
+    size_t    pos;
+
+    memset(&m, 0, sizeof(m));
+    m.duration = (uint64_t)g->clip_duration * 90000;
+    m.bitrate  = g->bitrate;
+    bytes      = (uint64_t)g->clip_duration * g->bitrate * 1000 / 8;
+    m.num_packets = (uint32_t)((bytes / 192 + 31) & ~31);
+    if (m.num_packets < 32) {
+        m.num_packets = 32;
+    }
+
+    max_ep = (unsigned)(m.duration / (g->ep_interval * 90) + 1);
+    ep_pts = calloc(max_ep, sizeof(*ep_pts));
+    ep_spn = calloc(max_ep, sizeof(*ep_spn));
+    if (!ep_pts || !ep_spn) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    snprintf(name, sizeof(name), "%05u.m2ts", clip);
+    m.fp = _open_file(g, "STREAM", name);
+
+    next_ep  = CLIP_START;
+    next_gfx = CLIP_START;
+    while (m.spn < m.num_packets) {
+        uint64_t t = _packet_time(&m, m.spn);
+
+        if (t >= next_ep && num_ep < max_ep && m.num_packets - m.spn >= 3) {
+            pts = next_ep;
+            _write_psi(&m);
+            ep_pts[num_ep] = pts;
+            ep_spn[num_ep] = m.spn;
+            num_ep++;
+            _write_video_start(&m, pts);
+            next_ep += g->ep_interval * 90;
+
+        } else if (t >= next_gfx && m.num_packets - m.spn >= 2) {
+            _write_graphics(&m, PG_PID, &m.cc_pg, t);
+            _write_graphics(&m, IG_PID, &m.cc_ig, t);
+            next_gfx += 90000;
+
+        } else {
+            uint8_t fill[184];
+            memset(fill, 0xff, sizeof(fill));
+            _write_packet(&m, VIDEO_PID, 0, &m.cc_video, NULL, fill, sizeof(fill));
+        }
+    }
+
+    if (fclose(m.fp)) {
+        fprintf(stderr, "Write error: %s\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    /* clip info */
+
+    _put_str(b, "HDMV0200");
+    _put_zero(b, 20);           /* section addresses */
+    _put_zero(b, 12);
+
+    pos = b->len;
+    _put32(b, 0);
+    _put16(b, 0);
+    _put8(b, 1);                /* clip_stream_type */
+    _put8(b, 1);                /* application_type: main TS for movie */
+    _put32(b, 0);
+    _put32(b, g->bitrate * 1000 / 8);
+    _put32(b, m.num_packets);
+    _put_zero(b, 128);
+    _put16(b, 0);               /* no TS type info */
+    _end_len32(b, pos);
+
+    _set32(b, 8, (uint32_t)b->len);
+    pos = b->len;
+    _put32(b, 0);
+    _put8(b, 0);
+    _put8(b, 1);                /* num_atc_seq */
+    _put32(b, 0);
+    _put8(b, 1);                /* num_stc_seq */
+    _put8(b, 0);
+    _put16(b, VIDEO_PID);       /* pcr_pid */
+    _put32(b, 0);
+    _put32(b, CLIP_START / 2);
+    _put32(b, (uint32_t)((CLIP_START + m.duration) / 2));
+    _end_len32(b, pos);
+
+    _set32(b, 12, (uint32_t)b->len);
+    pos = b->len;
+    _put32(b, 0);
+    _put8(b, 0);
+    _put8(b, 1);                /* num_prog */
+    _put32(b, 0);
+    _put16(b, PMT_PID);
+    _put8(b, sizeof(streams) / sizeof(streams[0]));
+    _put8(b, 0);
+    for (ii = 0; ii < sizeof(streams) / sizeof(streams[0]); ii++) {
+        _put16(b, streams[ii][0]);
+        _put8(b, 5);
+        _put8(b, streams[ii][1]);
+        if (streams[ii][1] == 0x1b) {
+            _put8(b, 0x61);
+            _put8(b, 0x30);     /* 16:9 */
+            _put_zero(b, 2);
+        } else {
+            _put_str(b, "eng");
+            _put8(b, 0);
+        }
+    }
+    _end_len32(b, pos);
+
+    _set32(b, 16, (uint32_t)b->len);
+    pos = b->len;
+    _put32(b, 0);
+    _put16(b, 1);               /* CPI type: EP map */
+    _put_ep_map(b, ep_spn, ep_pts, num_ep);
+    _end_len32(b, pos);
+
+    /* empty ClipMark */
+    _set32(b, 20, (uint32_t)b->len);
+    _put32(b, 0);
+
+    snprintf(name, sizeof(name), "%05u.clpi", clip);
+    _write_buf(g, "CLIPINF", name, b);
+
+    free(ep_pts);
+    free(ep_spn);
+}
+
+static void _usage(const char *cmd)
+{
+    fprintf(stderr,
+"Usage: %s [-p playlists] [-i items] [-c clips] [-d duration] [-e interval] [-r bitrate] [-m interval] <output dir>\n"
+"Options:\n"
+"    p N         - Number of playlists (and titles) (default 10).\n"
+"    i N         - Play items per playlist (default 1).\n"
+"    c N         - Number of clips shared by all playlists (default: playlists * items, max 10).\n"
+"    d N         - Clip duration in seconds (default 10).\n"
+"    e N         - EP map interval in milliseconds (default 500).\n"
+"    r N         - Stream bitrate in kbit/s (default 2000).\n"
+"    m N         - Chapter mark interval in seconds (default: one chapter / play item).\n"
+"    <output dir> - Root of generated disc tree (BDMV/ is created inside).\n"
+, cmd);
+
+    exit(EXIT_FAILURE);
+}
+
+#define OPTS "p:i:c:d:e:r:m:"
+
+int main(int argc, char *argv[])
+{
+    GEN      g;
+    BUF      b;
+    char     path[1024];
+    unsigned ii;
+    int      opt;
+
+    memset(&g, 0, sizeof(g));
+    memset(&b, 0, sizeof(b));
+    g.num_playlists = 10;
+    g.num_items     = 1;
+    g.clip_duration = 10;
+    g.ep_interval   = 500;
+    g.bitrate       = 2000;
+
+    while ((opt = getopt(argc, argv, OPTS)) != -1) {
+        switch (opt) {
+            case 'p': g.num_playlists = (unsigned)atoi(optarg); break;
+            case 'i': g.num_items     = (unsigned)atoi(optarg); break;
+            case 'c': g.num_clips     = (unsigned)atoi(optarg); break;
+            case 'd': g.clip_duration = (unsigned)atoi(optarg); break;
+            case 'e': g.ep_interval   = (unsigned)atoi(optarg); break;
+            case 'r': g.bitrate       = (unsigned)atoi(optarg); break;
+            case 'm': g.mark_interval = (unsigned)atoi(optarg); break;
+            default:  _usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1) {
+        _usage(argv[0]);
+    }
+    if (!g.num_clips) {
+        g.num_clips = g.num_playlists * g.num_items < 10 ? g.num_playlists * g.num_items : 10;
+    }
+    if (g.num_playlists < 1 || g.num_playlists > 65535 || g.num_items < 1 || g.num_items > 999 ||
+        g.num_clips < 1 || g.num_clips > 99999 || g.clip_duration < 1 || g.ep_interval < 1 || g.bitrate < 100) {
+        _usage(argv[0]);
+    }
+    g.root = argv[optind];
+
+    _make_dir(g.root);
+    snprintf(path, sizeof(path), "%s/BDMV", g.root);
+    _make_dir(path);
+    snprintf(path, sizeof(path), "%s/BDMV/PLAYLIST", g.root);
+    _make_dir(path);
+    snprintf(path, sizeof(path), "%s/BDMV/CLIPINF", g.root);
+    _make_dir(path);
+    snprintf(path, sizeof(path), "%s/BDMV/STREAM", g.root);
+    _make_dir(path);
+
+    _gen_index(&g, &b);
+    _write_buf(&g, "", "index.bdmv", &b);
+
+    _gen_mobj(&g, &b);
+    _write_buf(&g, "", "MovieObject.bdmv", &b);
+
+    for (ii = 0; ii < g.num_playlists; ii++) {
+        char name[16];
+        _gen_mpls(&g, &b, ii);
+        snprintf(name, sizeof(name), "%05u.mpls", ii);
+        _write_buf(&g, "PLAYLIST", name, &b);
+    }
+
+    for (ii = 0; ii < g.num_clips; ii++) {
+        _gen_clip(&g, &b, ii);
+    }
+
+    printf("%s: %u playlists, %u play items / playlist, %u clips\n",
+           g.root, g.num_playlists, g.num_items, g.num_clips);
+
+    free(b.p);
+    return 0;
+}
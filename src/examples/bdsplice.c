@@ -23,9 +23,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <libgen.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <sys/time.h>
 
 #include "libbluray/bluray.h"
 
@@ -39,6 +42,7 @@ _usage(char *cmd)
     fprintf(stderr,
 "Usage: %s -t title    [-c first[-last]] [-k keyfile] [-a angle]  <bd path> [dest]\n"
 "       %s -p playlist [-c first[-last]] [-k keyfile] [-a angle]  <bd path> [dest]\n"
+"       %s -A | -t title -G [-j jobs] [-k keyfile] <bd path> <dest dir>\n"
 "Summary:\n"
 "    Given a title or playlist number and Blu-Ray directory tree,\n"
 "    find the clips that compose the movie and splice\n"
@@ -49,14 +53,269 @@ _usage(char *cmd)
 "    a N         - Angle. First angle is 1.\n"
 "    c N or N-M  - Chapter or chapter range. First chapter is 1.\n"
 "    k keyfile   - AACS keyfile path.\n"
+"    A           - Splice all titles in parallel.\n"
+"    G           - Splice all angles of title in parallel.\n"
+"    j N         - Number of parallel jobs (default: all at once).\n"
 "    <bd path>   - Path to root of Blu-Ray directory tree.\n"
 "    [dest]      - Destination of spliced clips. stdout if not specified.\n"
-, cmd, cmd);
+"    <dest dir>  - Destination directory of spliced titles (titleNNNNN[-angleN].m2ts).\n"
+, cmd, cmd, cmd);
 
     exit(EXIT_FAILURE);
 }
 
-#define OPTS "c:vt:p:k:a:"
+/*
+ * parallel mode
+ *
+ * Each job has its own BLURAY object. Objects share the AACS session and
+ * parsed playlist cache, so the disc is authenticated and scanned once.
+ */
+
+typedef struct {
+    unsigned  title;
+    unsigned  angle;
+    int       angles;   /* title has multiple angles */
+
+    /* result */
+    int       error;
+    uint64_t  bytes;
+    uint64_t  time_us;
+} SPLICE_JOB;
+
+typedef struct {
+    const char      *bdpath;
+    const char      *keyfile;
+    const char      *dest;
+
+    pthread_mutex_t  mutex;
+    SPLICE_JOB      *jobs;
+    unsigned         num_jobs;
+    unsigned         next_job;
+} SPLICE_QUEUE;
+
+static uint64_t _now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static BLURAY *_open_shared(const char *bdpath, const char *keyfile)
+{
+    BLURAY *bd = bd_init();
+    if (!bd) {
+        return NULL;
+    }
+
+    bd_set_player_setting(bd, BLURAY_PLAYER_SETTING_SHARED_DECRYPT, 1);
+
+    if (!bd_open_disc(bd, bdpath, keyfile)) {
+        bd_close(bd);
+        return NULL;
+    }
+
+    bd_set_player_setting(bd, BLURAY_PLAYER_SETTING_SHARED_CACHE, 1);
+
+    return bd;
+}
+
+static int _splice_job(SPLICE_QUEUE *q, SPLICE_JOB *job, uint8_t *buf)
+{
+    BLURAY *bd;
+    FILE   *out;
+    char   *path;
+    int     bytes;
+    int     result = 0;
+
+    bd = _open_shared(q->bdpath, q->keyfile);
+    if (!bd) {
+        fprintf(stderr, "Failed to open disc: %s\n", q->bdpath);
+        return -1;
+    }
+
+    if (bd_get_titles(bd, TITLES_RELEVANT, 0) <= job->title ||
+        !bd_select_title(bd, job->title)) {
+        fprintf(stderr, "Failed to open title: %u\n", job->title + 1);
+        bd_close(bd);
+        return -1;
+    }
+    bd_select_angle(bd, job->angle);
+
+    path = malloc(strlen(q->dest) + 32);
+    if (!path) {
+        bd_close(bd);
+        return -1;
+    }
+    if (job->angles) {
+        sprintf(path, "%s/title%05u-angle%u.m2ts", q->dest, job->title + 1, job->angle + 1);
+    } else {
+        sprintf(path, "%s/title%05u.m2ts", q->dest, job->title + 1);
+    }
+
+    out = fopen(path, "wb");
+    if (!out) {
+        fprintf(stderr, "Failed to open destination: %s\n", path);
+        free(path);
+        bd_close(bd);
+        return -1;
+    }
+
+    while ((bytes = bd_read(bd, buf, BUF_SIZE)) > 0) {
+        if (fwrite(buf, 1, bytes, out) != (size_t)bytes) {
+            perror("Write error");
+            result = -1;
+            break;
+        }
+        job->bytes += bytes;
+    }
+    if (bytes < 0) {
+        fprintf(stderr, "Read error in title %u\n", job->title + 1);
+        result = -1;
+    }
+
+    if (fclose(out)) {
+        perror("Write error");
+        result = -1;
+    }
+    free(path);
+    bd_close(bd);
+
+    return result;
+}
+
+static void *_splice_worker(void *arg)
+{
+    SPLICE_QUEUE *q = (SPLICE_QUEUE *)arg;
+    uint8_t *buf = malloc(BUF_SIZE);
+
+    if (!buf) {
+        return NULL;
+    }
+
+    while (1) {
+        SPLICE_JOB *job = NULL;
+        uint64_t    t0;
+
+        pthread_mutex_lock(&q->mutex);
+        if (q->next_job < q->num_jobs) {
+            job = &q->jobs[q->next_job++];
+        }
+        pthread_mutex_unlock(&q->mutex);
+
+        if (!job) {
+            break;
+        }
+
+        t0 = _now_us();
+        job->error   = _splice_job(q, job, buf);
+        job->time_us = _now_us() - t0;
+
+        fprintf(stderr, "title %5u angle %u: %10"PRIu64" kB  %7.1f s  %6.1f MB/s%s\n",
+                job->title + 1, job->angle + 1, job->bytes / 1024,
+                job->time_us / 1000000.0,
+                job->time_us ? job->bytes / (double)job->time_us : 0.0,
+                job->error ? "  FAILED" : "");
+    }
+
+    free(buf);
+    return NULL;
+}
+
+/* title < 0: all titles, main angle. title >= 0: all angles of title. */
+static int _splice_parallel(const char *bdpath, const char *keyfile, const char *dest,
+                            int title, int num_threads)
+{
+    SPLICE_QUEUE q;
+    pthread_t   *threads;
+    BLURAY      *bd;
+    uint64_t     t0, total = 0, time_us;
+    unsigned     ii;
+    int          num_started = 0, errors = 0;
+
+    memset(&q, 0, sizeof(q));
+    q.bdpath  = bdpath;
+    q.keyfile = keyfile;
+    q.dest    = dest;
+
+    t0 = _now_us();
+
+    /* first object keeps shared session and cache alive */
+    bd = _open_shared(bdpath, keyfile);
+    if (!bd) {
+        fprintf(stderr, "Failed to open disc: %s\n", bdpath);
+        return 1;
+    }
+
+    q.num_jobs = bd_get_titles(bd, TITLES_RELEVANT, 0);
+    if ((int)q.num_jobs <= 0 || title >= (int)q.num_jobs) {
+        fprintf(stderr, "No titles found: %s\n", bdpath);
+        bd_close(bd);
+        return 1;
+    }
+
+    if (title >= 0) {
+        BLURAY_TITLE_INFO *ti = bd_get_title_info(bd, title, 0);
+        q.num_jobs = ti ? ti->angle_count : 0;
+        bd_free_title_info(ti);
+        if (!q.num_jobs) {
+            q.num_jobs = 1;
+        }
+    }
+
+    q.jobs = calloc(q.num_jobs, sizeof(SPLICE_JOB));
+    if (!q.jobs) {
+        bd_close(bd);
+        return 1;
+    }
+    for (ii = 0; ii < q.num_jobs; ii++) {
+        q.jobs[ii].title  = title >= 0 ? (unsigned)title : ii;
+        q.jobs[ii].angle  = title >= 0 ? ii : 0;
+        q.jobs[ii].angles = title >= 0 && q.num_jobs > 1;
+    }
+
+    if (num_threads <= 0 || num_threads > (int)q.num_jobs) {
+        num_threads = q.num_jobs;
+    }
+
+    threads = calloc(num_threads, sizeof(pthread_t));
+    if (!threads) {
+        free(q.jobs);
+        bd_close(bd);
+        return 1;
+    }
+
+    pthread_mutex_init(&q.mutex, NULL);
+    for (; num_started < num_threads; num_started++) {
+        if (pthread_create(&threads[num_started], NULL, _splice_worker, &q)) {
+            break;
+        }
+    }
+    if (!num_started) {
+        /* no threads, run jobs here */
+        _splice_worker(&q);
+    }
+    for (ii = 0; ii < (unsigned)num_started; ii++) {
+        pthread_join(threads[ii], NULL);
+    }
+    pthread_mutex_destroy(&q.mutex);
+
+    time_us = _now_us() - t0;
+    for (ii = 0; ii < q.num_jobs; ii++) {
+        total  += q.jobs[ii].bytes;
+        errors += !!q.jobs[ii].error;
+    }
+    fprintf(stderr, "%u jobs (%d threads): %"PRIu64" kB in %.1f s, %.1f MB/s, %d failed\n",
+            q.num_jobs, num_started, total / 1024, time_us / 1000000.0,
+            time_us ? total / (double)time_us : 0.0, errors);
+
+    free(threads);
+    free(q.jobs);
+    bd_close(bd);
+
+    return errors ? 1 : 0;
+}
+
+#define OPTS "c:vt:p:k:a:AGj:"
 
 int
 main(int argc, char *argv[])
@@ -79,6 +338,9 @@ main(int argc, char *argv[])
     uint8_t buf[BUF_SIZE];
     char *keyfile = NULL;
     BLURAY_TITLE_INFO *ti;
+    int all_titles = 0;
+    int all_angles = 0;
+    int jobs = 0;
 
     do {
         opt = getopt(argc, argv, OPTS);
@@ -134,12 +396,31 @@ main(int argc, char *argv[])
                 verbose = 1;
                 break;
 
+            case 'A':
+                all_titles = 1;
+                break;
+
+            case 'G':
+                all_angles = 1;
+                break;
+
+            case 'j':
+                jobs = atoi(optarg);
+                break;
+
             default:
                 _usage(argv[0]);
                 break;
         }
     } while (opt != -1);
 
+    if (all_titles || all_angles) {
+        if (optind < argc || !bdpath || !dest || playlist >= 0 || (all_angles && title_no < 0)) {
+            _usage(argv[0]);
+        }
+        return _splice_parallel(bdpath, keyfile, dest, all_titles ? -1 : title_no, jobs);
+    }
+
     if (title_no < 0 && playlist < 0) {
         _usage(argv[0]);
     }
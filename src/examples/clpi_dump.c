@@ -20,8 +20,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <sys/time.h>
 
 #include "libbluray/bdnav/clpi_data.h"
 #include "libbluray/bluray.h"
@@ -367,6 +369,105 @@ _show_cpi_info(CLPI_CPI *cpi, int level)
     }
 }
 
+/*
+ * --bench-seek
+ */
+
+static uint64_t
+_now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static uint32_t
+_rand32(uint32_t *state)
+{
+    /* xorshift32: cheap and deterministic */
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static void
+_print_bench(const char *name, uint64_t us, unsigned count, uint32_t check)
+{
+    printf("  %-24s: %8.1f ns/lookup (%u lookups, check %08x)\n",
+           name, count ? us * 1000.0 / count : 0.0, count, check);
+}
+
+static void
+_bench_seek(const CLPI_CL *cl, unsigned count)
+{
+    uint32_t *query, state = 0x12345678, check, max_pts, max_pkt, time;
+    uint64_t  t0;
+    unsigned  ii;
+    int       num_coarse = 0, num_fine = 0;
+
+    printf("EP map:\n");
+    for (ii = 0; ii < cl->cpi.num_stream_pid; ii++) {
+        const CLPI_EP_MAP_ENTRY *e = &cl->cpi.entry[ii];
+        printf("  stream %u: PID 0x%04x, %d coarse, %d fine entries\n",
+               ii, e->pid, e->num_ep_coarse, e->num_ep_fine);
+        num_coarse += e->num_ep_coarse;
+        num_fine   += e->num_ep_fine;
+    }
+    printf("  total: %d coarse, %d fine entries\n", num_coarse, num_fine);
+    printf("  clip info memory: %zu bytes\n", bd_clpi_memory_size(cl));
+
+    if (!cl->ep_index || cl->cpi.num_stream_pid < 1 || cl->ep_index[0].num_ep < 1 || !count) {
+        printf("  no EP map, nothing to benchmark\n");
+        return;
+    }
+
+    max_pts = cl->ep_index[0].pts[cl->ep_index[0].num_ep - 1] + 45000;
+    max_pkt = cl->clip.num_source_packets;
+    if (!max_pkt) {
+        max_pkt = cl->ep_index[0].spn[cl->ep_index[0].num_ep - 1] + 1;
+    }
+
+    /* generate queries outside of timed loops */
+    query = malloc(count * sizeof(uint32_t));
+    if (!query) {
+        return;
+    }
+
+    printf("Seek benchmark:\n");
+
+    for (ii = 0; ii < count; ii++) {
+        query[ii] = _rand32(&state) % max_pts;
+    }
+    check = 0;
+    t0 = _now_us();
+    for (ii = 0; ii < count; ii++) {
+        check += bd_clpi_lookup_spn(cl, query[ii], 1, 0);
+    }
+    _print_bench("clpi_lookup_spn()", _now_us() - t0, count, check);
+
+    for (ii = 0; ii < count; ii++) {
+        query[ii] = _rand32(&state) % max_pkt;
+    }
+    check = 0;
+    t0 = _now_us();
+    for (ii = 0; ii < count; ii++) {
+        check += bd_clpi_access_point(cl, query[ii], 0, 0, &time);
+        check += time;
+    }
+    _print_bench("clpi_access_point()", _now_us() - t0, count, check);
+
+    check = 0;
+    t0 = _now_us();
+    for (ii = 0; ii < count; ii++) {
+        check += bd_clpi_access_point(cl, query[ii], 1, 0, &time);
+        check += time;
+    }
+    _print_bench("clpi_access_point(next)", _now_us() - t0, count, check);
+
+    free(query);
+}
 
 static void
 _usage(char *cmd)
@@ -381,6 +482,8 @@ _usage(char *cmd)
 "    p - Shows the Program Info structure\n"
 "    i - Shows the CPI. PTS to SPN map\n"
 "    e - Shows Extent Start Table\n"
+"    --bench-seek[=N] - Run N (default 1000000) random EP map lookups and\n"
+"                       show EP map statistics\n"
 , cmd);
 
     exit(EXIT_FAILURE);
@@ -395,8 +498,19 @@ main(int argc, char *argv[])
     int opt;
     int opt_clip_info = 0, opt_seq_info = 0, opt_prog_info = 0;
     int opt_cpi_info = 0, opt_extent_start = 0;
+    unsigned opt_bench_seek = 0;
     int ii;
 
+    /* long options are removed before getopt() */
+    for (ii = 1; ii < argc; ii++) {
+        if (!strncmp(argv[ii], "--bench-seek", 12) && (!argv[ii][12] || argv[ii][12] == '=')) {
+            opt_bench_seek = argv[ii][12] ? (unsigned)strtoul(argv[ii] + 13, NULL, 0) : 1000000;
+            memmove(&argv[ii], &argv[ii + 1], (argc - ii) * sizeof(argv[0]));
+            argc--;
+            ii--;
+        }
+    }
+
     do {
         opt = getopt(argc, argv, OPTS);
         switch (opt) {
@@ -480,6 +594,10 @@ main(int argc, char *argv[])
             }
         }
 
+        if (opt_bench_seek) {
+            _bench_seek(cl, opt_bench_seek);
+        }
+
         bd_free_clpi(cl);
     }
     return 0;
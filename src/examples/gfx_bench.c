@@ -0,0 +1,381 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Graphics pipeline benchmark.
+ *
+ * Capture IG / PG stream packets of a title to a file, and replay captured
+ * packets through the IG / PG decoder and graphics controller.
+ * Replay reports decode time per display set, overlay commands / s and
+ * drawn pixels / s.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/time.h>
+
+#include "libbluray/bluray.h"
+#include "libbluray/decoders/overlay.h"
+
+#define PKT_SIZE   192
+#define UNIT_PKTS  32
+#define UNIT_SIZE  (PKT_SIZE * UNIT_PKTS)
+#define READ_SIZE  (UNIT_SIZE * 32)
+
+#define IS_PG_PID(pid) ((pid) >= 0x1200 && (pid) <= 0x121f)
+#define IS_IG_PID(pid) ((pid) >= 0x1400 && (pid) <= 0x141f)
+#define NUM_PIDS       0x40  /* 0x1200...0x121f, 0x1400...0x141f */
+
+typedef struct {
+    uint16_t pid;
+    unsigned num_pkts;           /* packets in unit */
+    uint8_t  unit[UNIT_SIZE];
+
+    uint64_t packets;
+    uint32_t display_sets;
+    uint64_t decode_time;        /* us */
+    uint64_t max_time;           /* us, single display set */
+    uint64_t set_time;           /* us, current display set */
+} PID_STATE;
+
+typedef struct {
+    int       render;            /* expand RLE images */
+    uint32_t *frame;
+
+    uint64_t  cmds[8];
+    uint64_t  num_cmds;
+    uint64_t  pixels;
+    uint64_t  render_time;       /* us, included in decode time */
+
+    PID_STATE *pids[NUM_PIDS];
+} GFX_BENCH;
+
+static uint64_t _now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static uint16_t _pkt_pid(const uint8_t *pkt)
+{
+    return ((pkt[5] & 0x1f) << 8) | pkt[6];
+}
+
+static int _pid_index(uint16_t pid)
+{
+    if (IS_PG_PID(pid)) return pid - 0x1200;
+    if (IS_IG_PID(pid)) return pid - 0x1400 + 0x20;
+    return -1;
+}
+
+/*
+ * capture
+ */
+
+static int _capture(const char *disc_root, unsigned title, const char *file)
+{
+    BLURAY   *bd;
+    FILE     *fp;
+    uint8_t  *buf;
+    uint64_t  total = 0, kept = 0;
+    int       len, ii;
+
+    bd = bd_open(disc_root, NULL);
+    if (!bd) {
+        fprintf(stderr, "error opening disc %s\n", disc_root);
+        return -1;
+    }
+
+    if (bd_get_titles(bd, TITLES_RELEVANT, 0) <= title || !bd_select_title(bd, title)) {
+        fprintf(stderr, "error selecting title %u\n", title + 1);
+        bd_close(bd);
+        return -1;
+    }
+
+    fp = fopen(file, "wb");
+    if (!fp) {
+        fprintf(stderr, "error creating %s\n", file);
+        bd_close(bd);
+        return -1;
+    }
+
+    buf = malloc(READ_SIZE);
+    if (!buf) {
+        fclose(fp);
+        bd_close(bd);
+        return -1;
+    }
+
+    while ((len = bd_read(bd, buf, READ_SIZE)) > 0) {
+        for (ii = 0; ii + PKT_SIZE <= len; ii += PKT_SIZE) {
+            if (_pid_index(_pkt_pid(buf + ii)) >= 0) {
+                if (fwrite(buf + ii, PKT_SIZE, 1, fp) != 1) {
+                    fprintf(stderr, "error writing %s\n", file);
+                    len = -1;
+                    break;
+                }
+                kept++;
+            }
+            total++;
+        }
+    }
+
+    printf("title %u: %"PRIu64" packets, %"PRIu64" IG / PG packets captured\n",
+           title + 1, total, kept);
+
+    free(buf);
+    fclose(fp);
+    bd_close(bd);
+
+    return len < 0 ? -1 : 0;
+}
+
+/*
+ * replay
+ */
+
+static void _overlay_cb(void *handle, const BD_OVERLAY * const ov)
+{
+    GFX_BENCH *b = (GFX_BENCH *)handle;
+
+    if (!ov) {
+        return;
+    }
+
+    b->num_cmds++;
+    b->cmds[ov->cmd & 7]++;
+
+    if (ov->cmd == BD_OVERLAY_DRAW && ov->img) {
+        b->pixels += (uint64_t)ov->w * ov->h;
+
+        if (b->render && ov->w <= 1920 && ov->h <= 1080) {
+            uint32_t lut[256];
+            uint64_t t0 = _now_us();
+            bd_pg_palette_to_argb(ov->palette, lut, 1);
+            bd_rle_decode32(ov->img, ov->w, ov->h, lut, b->frame, 1920);
+            b->render_time += _now_us() - t0;
+        }
+    }
+}
+
+static void _decode_unit(BLURAY *bd, PID_STATE *ps)
+{
+    uint64_t t0, us;
+    int      result;
+
+    /* pad partial unit with null packets */
+    while (ps->num_pkts < UNIT_PKTS) {
+        uint8_t *pkt = ps->unit + ps->num_pkts * PKT_SIZE;
+        memset(pkt, 0xff, PKT_SIZE);
+        pkt[4] = 0x47;
+        pkt[5] = 0x1f;
+        pkt[6] = 0xff;
+        pkt[7] = 0x10;
+        ps->num_pkts++;
+    }
+
+    t0 = _now_us();
+    result = bd_decode_graphics(bd, ps->pid, ps->unit, 1);
+    us = _now_us() - t0;
+
+    ps->num_pkts = 0;
+    ps->decode_time += us;
+    ps->set_time += us;
+
+    if (result > 0) {
+        ps->display_sets++;
+        if (ps->set_time > ps->max_time) {
+            ps->max_time = ps->set_time;
+        }
+        ps->set_time = 0;
+    }
+}
+
+static int _replay(const char *file, int render, unsigned loops)
+{
+    static const char * const cmd_names[8] = {
+        "init", "clear", "draw", "wipe", "flush", "close", "hide", "?",
+    };
+
+    GFX_BENCH  b;
+    BLURAY    *bd;
+    FILE      *fp;
+    uint8_t    pkt[PKT_SIZE];
+    uint64_t   total_time = 0, t0;
+    uint32_t   total_sets = 0;
+    unsigned   loop, ii;
+
+    memset(&b, 0, sizeof(b));
+    b.render = render;
+    if (render) {
+        b.frame = malloc(1920 * 1080 * sizeof(uint32_t));
+        if (!b.frame) {
+            return -1;
+        }
+    }
+
+    fp = fopen(file, "rb");
+    if (!fp) {
+        fprintf(stderr, "error opening %s\n", file);
+        free(b.frame);
+        return -1;
+    }
+
+    t0 = _now_us();
+
+    for (loop = 0; loop < loops; loop++) {
+
+        /* fresh decoder state for each pass */
+        bd = bd_init();
+        if (!bd) {
+            break;
+        }
+        bd_register_overlay_proc(bd, &b, _overlay_cb);
+        bd_select_stream(bd, BLURAY_PG_TEXTST_STREAM, 1, 1);
+
+        rewind(fp);
+        while (fread(pkt, PKT_SIZE, 1, fp) == 1) {
+            uint16_t pid = _pkt_pid(pkt);
+            int      idx = _pid_index(pid);
+            PID_STATE *ps;
+
+            if (idx < 0) {
+                continue;
+            }
+            ps = b.pids[idx];
+            if (!ps) {
+                ps = b.pids[idx] = calloc(1, sizeof(PID_STATE));
+                if (!ps) {
+                    continue;
+                }
+                ps->pid = pid;
+            }
+
+            memcpy(ps->unit + ps->num_pkts * PKT_SIZE, pkt, PKT_SIZE);
+            ps->num_pkts++;
+            ps->packets++;
+            if (ps->num_pkts == UNIT_PKTS) {
+                _decode_unit(bd, ps);
+            }
+        }
+
+        for (ii = 0; ii < NUM_PIDS; ii++) {
+            if (b.pids[ii] && b.pids[ii]->num_pkts) {
+                _decode_unit(bd, b.pids[ii]);
+            }
+        }
+
+        /* flush and close planes */
+        bd_close(bd);
+    }
+
+    t0 = _now_us() - t0;
+
+    for (ii = 0; ii < NUM_PIDS; ii++) {
+        PID_STATE *ps = b.pids[ii];
+        if (ps) {
+            printf("%s pid 0x%04x: %8"PRIu64" packets, %6u display sets, decode %8"PRIu64" us"
+                   " (avg %6"PRIu64" us / set, max %6"PRIu64" us)\n",
+                   IS_IG_PID(ps->pid) ? "IG" : "PG", ps->pid, ps->packets, ps->display_sets,
+                   ps->decode_time, ps->display_sets ? ps->decode_time / ps->display_sets : 0,
+                   ps->max_time);
+            total_time += ps->decode_time;
+            total_sets += ps->display_sets;
+            free(ps);
+        }
+    }
+
+    printf("\n%u pass(es), %u display sets, %"PRIu64" us in decoder (%"PRIu64" us total)\n",
+           loops, total_sets, total_time, t0);
+    printf("overlay commands: %"PRIu64" (", b.num_cmds);
+    for (ii = 0; ii < 7; ii++) {
+        printf("%s%s %"PRIu64, ii ? ", " : "", cmd_names[ii], b.cmds[ii]);
+    }
+    printf(")\n");
+    if (total_time > 0) {
+        printf("%.0f overlay commands / s, %.1f Mpixels / s drawn\n",
+               (double)b.num_cmds * 1000000.0 / total_time,
+               (double)b.pixels / total_time);
+    }
+    if (render) {
+        printf("RLE expansion: %"PRIu64" us (included in decoder time)\n", b.render_time);
+    }
+
+    fclose(fp);
+    free(b.frame);
+
+    return 0;
+}
+
+/*
+ *
+ */
+
+static void _usage(const char *name)
+{
+    fprintf(stderr,
+            "%s -c <disc_root> [-t title] <capture_file>\n"
+            "    capture IG and PG stream packets of title to file\n"
+            "%s [-r] [-l loops] <capture_file>\n"
+            "    replay captured packets through graphics decoder\n"
+            "Options:\n"
+            "    -c <disc_root>  disc root directory or device\n"
+            "    -t <title>      title number (default 1)\n"
+            "    -r              expand RLE images to ARGB frame (application rendering cost)\n"
+            "    -l <loops>      number of replay passes (default 1)\n",
+            name, name);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *disc_root = NULL;
+    unsigned    title = 1;
+    unsigned    loops = 1;
+    int         render = 0;
+    int         opt;
+
+    while ((opt = getopt(argc, argv, "c:t:rl:h")) != -1) {
+        switch (opt) {
+            case 'c': disc_root = optarg;                     break;
+            case 't': title = strtoul(optarg, NULL, 0);       break;
+            case 'r': render = 1;                             break;
+            case 'l': loops = strtoul(optarg, NULL, 0);       break;
+            default:  _usage(argv[0]);
+        }
+    }
+
+    if (optind != argc - 1 || title < 1 || loops < 1) {
+        _usage(argv[0]);
+    }
+
+    if (disc_root) {
+        return _capture(disc_root, title - 1, argv[optind]) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    return _replay(argv[optind], render, loops) < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <sys/time.h>
 
 #include "util/log_control.h"
 #include "libbluray/bluray.h"
@@ -115,6 +116,132 @@ static void _print_event(BD_EVENT *ev)
       fflush(stdout);
 }
 
+static void _print_profile(BLURAY *bd)
+{
+    BLURAY_STATS             stats;
+    BLURAY_HDMV_OBJECT_STATS os;
+    unsigned                 object;
+
+    if (!bd_get_stats(bd, &stats)) {
+        return;
+    }
+
+    printf("HDMV VM: %"PRIu64" instructions, %"PRIu64" GPR writes, %"PRIu64" PSR writes, %u budget yields\n",
+           stats.hdmv.instructions, stats.hdmv.gpr_writes, stats.hdmv.psr_writes, stats.hdmv.budget_yields);
+
+    for (object = 0; bd_get_hdmv_object_stats(bd, object, &os, NULL, 0); object++) {
+        uint32_t *hits;
+        unsigned  ii;
+
+        if (!os.calls && !os.instructions) {
+            continue;
+        }
+
+        printf("  object %5u: %6u calls %10"PRIu64" instructions %10"PRIu64" us\n",
+               object, os.calls, os.instructions, os.time_us);
+
+        hits = os.num_cmds ? calloc(os.num_cmds, sizeof(uint32_t)) : NULL;
+        if (hits && bd_get_hdmv_object_stats(bd, object, &os, hits, os.num_cmds)) {
+            for (ii = 0; ii < os.num_cmds; ii++) {
+                if (hits[ii]) {
+                    printf("      %04u: %10u\n", ii, hits[ii]);
+                }
+            }
+        }
+        free(hits);
+    }
+
+    printf("\n");
+}
+
+static uint64_t _now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static uint64_t _hdmv_instructions(BLURAY *bd)
+{
+    BLURAY_STATS stats;
+    return bd_get_stats(bd, &stats) ? stats.hdmv.instructions : 0;
+}
+
+/* run HDMV VM until first playlist is started. Returns playlist number or -1. */
+static int _run_to_playlist(BLURAY *bd)
+{
+    BD_EVENT ev;
+
+    do {
+        bd_read_ext(bd, NULL, 0, &ev);
+        if (ev.event == BD_EVENT_PLAYLIST) {
+            return (int)ev.param;
+        }
+    } while (ev.event != BD_EVENT_NONE && ev.event != BD_EVENT_ERROR);
+
+    return -1;
+}
+
+static void _time_title(BLURAY *bd, unsigned title, const char *name)
+{
+    uint64_t insn0, t0, us;
+    int      ok, playlist;
+
+    /* reset VM. Title is started from first play playlist, like with user title selection. */
+    if (title != BLURAY_TITLE_FIRST_PLAY) {
+        bd_play(bd);
+        _run_to_playlist(bd);
+    }
+
+    insn0 = _hdmv_instructions(bd);
+    t0    = _now_us();
+
+    ok = title == BLURAY_TITLE_FIRST_PLAY ? bd_play(bd) : bd_play_title(bd, title);
+    playlist = ok ? _run_to_playlist(bd) : -1;
+
+    us = _now_us() - t0;
+
+    printf("%-12s %10"PRIu64" us %12"PRIu64" instructions  ", name, us, _hdmv_instructions(bd) - insn0);
+    if (!ok) {
+        printf("not started\n");
+    } else if (playlist < 0) {
+        printf("no playlist\n");
+    } else {
+        printf("-> %05d.mpls\n", playlist);
+    }
+    fflush(stdout);
+}
+
+/* wall time and HDMV instructions from movie object start to first PlayPL, for each HDMV title */
+static void _time_titles(BLURAY *bd)
+{
+    const BLURAY_DISC_INFO *di = bd_get_disc_info(bd);
+    char     name[16];
+    unsigned ii;
+
+    if (!di || !di->bluray_detected) {
+        printf("No disc index\n");
+        return;
+    }
+
+    printf("Timing HDMV titles\n");
+
+    if (di->first_play_supported && di->first_play && !di->first_play->bdj) {
+        _time_title(bd, BLURAY_TITLE_FIRST_PLAY, "first play");
+    }
+    if (di->top_menu_supported && di->top_menu && !di->top_menu->bdj) {
+        _time_title(bd, BLURAY_TITLE_TOP_MENU, "top menu");
+    }
+    for (ii = 1; ii <= di->num_titles; ii++) {
+        if (di->titles[ii] && !di->titles[ii]->bdj) {
+            sprintf(name, "title %u", ii);
+            _time_title(bd, ii, name);
+        }
+    }
+
+    printf("\n");
+}
+
 static void _read_to_eof(BLURAY *bd)
 {
     BD_EVENT ev;
@@ -161,6 +288,8 @@ int main(int argc, char *argv[])
 {
     int title = -1;
     int verbose = 0;
+    int profile = 0;
+    int timed = 0;
     int args = 0;
 
     /*
@@ -168,7 +297,7 @@ int main(int argc, char *argv[])
      */
 
     if (argc < 2) {
-        printf("\nUsage:\n   %s [-v] [-t <title>] <media_path> [<keyfile_path>]\n\n", argv[0]);
+        printf("\nUsage:\n   %s [-v] [-p] [-T] [-t <title>] <media_path> [<keyfile_path>]\n\n", argv[0]);
         return -1;
     }
 
@@ -177,6 +306,16 @@ int main(int argc, char *argv[])
         args++;
     }
 
+    if (!strcmp(argv[1+args], "-p")) {
+        profile = 1;
+        args++;
+    }
+
+    if (!strcmp(argv[1+args], "-T")) {
+        timed = 1;
+        args++;
+    }
+
     if (!strcmp(argv[1+args], "-t")) {
         args++;
         title = atoi(argv[1+args]);
@@ -207,6 +346,16 @@ int main(int argc, char *argv[])
     bd_set_player_setting_str(bd, BLURAY_PLAYER_SETTING_PG_LANG,      "eng");
     bd_set_player_setting_str(bd, BLURAY_PLAYER_SETTING_MENU_LANG,    "eng");
     bd_set_player_setting_str(bd, BLURAY_PLAYER_SETTING_COUNTRY_CODE, NULL);
+    bd_set_player_setting    (bd, BLURAY_PLAYER_SETTING_HDMV_PROFILE, profile);
+
+    if (timed) {
+        _time_titles(bd);
+        if (profile) {
+            _print_profile(bd);
+        }
+        bd_close(bd);
+        return 0;
+    }
 
     /*
      * play
@@ -246,6 +395,10 @@ int main(int argc, char *argv[])
 
     _play_pl(bd);
 
+    if (profile) {
+        _print_profile(bd);
+    }
+
     /*
      * clean up
      */
@@ -0,0 +1,410 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * I/O trace replay.
+ *
+ * Replays file access pattern recorded with bd_set_io_trace() (bd_bench -T).
+ * Operations are issued at recorded times (or back-to-back with -f).
+ * Files that exist are read for real; missing files (or all files with -s)
+ * are synthetic: reads take the recorded time, so recorded stalls are
+ * reproduced.
+ * Reports recorded vs. replayed latency per operation type and lists
+ * operations slower than the stall threshold.
+ *
+ * Operations are replayed from a single thread in trace order.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/time.h>
+
+#define TRACE_SIGNATURE  "# libbluray I/O trace v1"
+#define MAX_READ         (64 * 1024 * 1024)
+#define UDF_BLOCK_SIZE   2048
+
+enum { OP_OPEN, OP_READ, OP_SEEK, OP_CLOSE, OP_BLOCK, OP_OTHER, NUM_OPS };
+
+static const char * const op_names[NUM_OPS] = {
+    "open", "read", "seek", "close", "block", "other",
+};
+
+typedef struct {
+    FILE *fp;      /* NULL if synthetic */
+    int   open;
+} REPLAY_FILE;
+
+typedef struct {
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t rec_us, rep_us;
+    uint64_t rec_max, rep_max;
+} OP_STATS;
+
+typedef struct {
+    int          synthetic;   /* never touch real files */
+    int          fast;        /* ignore recorded timing */
+    uint64_t     stall_us;
+    const char  *map_from;    /* path prefix mapping */
+    const char  *map_to;
+    FILE        *image;       /* UDF block reads */
+
+    REPLAY_FILE *files;
+    unsigned     num_files;
+
+    uint8_t     *buf;
+    size_t       buf_size;
+
+    OP_STATS     stats[NUM_OPS];
+    unsigned     num_stalls;
+    uint64_t     late_us;     /* max. lag behind recorded schedule */
+} REPLAY;
+
+static uint64_t _now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void _sleep_us(uint64_t us)
+{
+    struct timespec ts;
+    ts.tv_sec  = (time_t)(us / 1000000);
+    ts.tv_nsec = (long)(us % 1000000) * 1000;
+    nanosleep(&ts, NULL);
+}
+
+static REPLAY_FILE *_file(REPLAY *r, unsigned id)
+{
+    if (id >= r->num_files) {
+        unsigned     n   = id + 64;
+        REPLAY_FILE *tmp = realloc(r->files, n * sizeof(*tmp));
+        if (!tmp) {
+            return NULL;
+        }
+        memset(tmp + r->num_files, 0, (n - r->num_files) * sizeof(*tmp));
+        r->files     = tmp;
+        r->num_files = n;
+    }
+    return &r->files[id];
+}
+
+static uint8_t *_buf(REPLAY *r, int64_t size)
+{
+    size = size > MAX_READ ? MAX_READ : size;
+    if ((size_t)size > r->buf_size) {
+        uint8_t *tmp = realloc(r->buf, size);
+        if (!tmp) {
+            return NULL;
+        }
+        r->buf      = tmp;
+        r->buf_size = size;
+    }
+    return r->buf;
+}
+
+/* synthetic operation: take the recorded time */
+static void _synthetic(int64_t dur_us, uint8_t *buf, int64_t size)
+{
+    if (buf && size > 0) {
+        memset(buf, 0x47, size > MAX_READ ? MAX_READ : size);
+    }
+    if (dur_us > 0) {
+        _sleep_us((uint64_t)dur_us);
+    }
+}
+
+static void _read_at(FILE *fp, int64_t offset, uint8_t *buf, int64_t size)
+{
+    if (buf && size > 0 && fseeko(fp, (off_t)offset, SEEK_SET) == 0) {
+        if (fread(buf, 1, size > MAX_READ ? MAX_READ : size, fp) == 0) {
+            /* EOF */
+        }
+    }
+}
+
+static void _open(REPLAY *r, unsigned id, const char *mode, const char *path)
+{
+    REPLAY_FILE *f = _file(r, id);
+    char        *mapped = NULL;
+
+    if (!f) {
+        return;
+    }
+    f->open = 1;
+    f->fp   = NULL;
+
+    /* never write, never replay files that were opened for writing */
+    if (r->synthetic || strchr(mode, 'w')) {
+        return;
+    }
+
+    if (r->map_from && !strncmp(path, r->map_from, strlen(r->map_from))) {
+        const char *rest = path + strlen(r->map_from);
+        mapped = malloc(strlen(r->map_to) + strlen(rest) + 1);
+        if (mapped) {
+            sprintf(mapped, "%s%s", r->map_to, rest);
+            path = mapped;
+        }
+    }
+
+    f->fp = fopen(path, "rb");
+    free(mapped);
+}
+
+static void _close(REPLAY *r, unsigned id)
+{
+    REPLAY_FILE *f = _file(r, id);
+    if (f && f->open) {
+        if (f->fp) {
+            fclose(f->fp);
+        }
+        f->fp   = NULL;
+        f->open = 0;
+    }
+}
+
+static void _replay_line(REPLAY *r, char *line, uint64_t t_start)
+{
+    uint64_t   start, dur, t0, t1, now;
+    char       op;
+    unsigned   id = 0;
+    int64_t    a = 0, b = 0;
+    int        n, kind;
+    char      *args;
+
+    if (sscanf(line, "%"SCNu64" %"SCNu64" %c %n", &start, &dur, &op, &n) < 3) {
+        return;
+    }
+    args = line + n;
+
+    /* wait until recorded start time */
+    now = _now_us() - t_start;
+    if (!r->fast) {
+        if (now < start) {
+            _sleep_us(start - now);
+        } else if (now - start > r->late_us) {
+            r->late_us = now - start;
+        }
+    }
+
+    t0 = _now_us();
+
+    switch (op) {
+        case 'O': {
+            char mode[8];
+            int  m;
+            kind = OP_OPEN;
+            if (sscanf(args, "%u %"SCNd64" %7s %n", &id, &a, mode, &m) >= 3 && id) {
+                args[strcspn(args, "\r\n")] = 0;
+                _open(r, id, mode, args + m);
+            }
+            break;
+        }
+        case 'R':
+        case 'A': {
+            REPLAY_FILE *f;
+            kind = OP_READ;
+            if (sscanf(args, "%u %"SCNd64" %"SCNd64, &id, &a, &b) == 3 && (f = _file(r, id))) {
+                uint8_t *buf = _buf(r, b);
+                if (f->fp) {
+                    _read_at(f->fp, a, buf, b);
+                } else {
+                    _synthetic((int64_t)dur, buf, b);
+                }
+                r->stats[kind].bytes += b;
+            }
+            break;
+        }
+        case 'B': {
+            uint32_t lba, blocks;
+            kind = OP_BLOCK;
+            if (sscanf(args, "%u %u", &lba, &blocks) == 2) {
+                uint8_t *buf = _buf(r, (int64_t)blocks * UDF_BLOCK_SIZE);
+                if (r->image && !r->synthetic) {
+                    _read_at(r->image, (int64_t)lba * UDF_BLOCK_SIZE, buf, (int64_t)blocks * UDF_BLOCK_SIZE);
+                } else {
+                    _synthetic((int64_t)dur, buf, (int64_t)blocks * UDF_BLOCK_SIZE);
+                }
+                r->stats[kind].bytes += (uint64_t)blocks * UDF_BLOCK_SIZE;
+            }
+            break;
+        }
+        case 'S':
+            kind = OP_SEEK;
+            break;
+        case 'C':
+            kind = OP_CLOSE;
+            if (sscanf(args, "%u", &id) == 1) {
+                _close(r, id);
+            }
+            break;
+        default:
+            /* prefetch hints, writes */
+            kind = OP_OTHER;
+            break;
+    }
+
+    t1 = _now_us() - t0;
+
+    r->stats[kind].count++;
+    r->stats[kind].rec_us += dur;
+    r->stats[kind].rep_us += t1;
+    if (dur > r->stats[kind].rec_max) r->stats[kind].rec_max = dur;
+    if (t1  > r->stats[kind].rep_max) r->stats[kind].rep_max = t1;
+
+    if (dur >= r->stall_us || t1 >= r->stall_us) {
+        line[strcspn(line, "\r\n")] = 0;
+        printf("stall: %-60.60s recorded %8"PRIu64" us, replayed %8"PRIu64" us\n", line, dur, t1);
+        r->num_stalls++;
+    }
+}
+
+static int _replay(REPLAY *r, const char *trace_file)
+{
+    FILE     *fp;
+    char      line[4096];
+    uint64_t  t_start, total;
+    unsigned  ii;
+
+    fp = fopen(trace_file, "r");
+    if (!fp) {
+        fprintf(stderr, "error opening %s\n", trace_file);
+        return -1;
+    }
+
+    if (!fgets(line, sizeof(line), fp) || strncmp(line, TRACE_SIGNATURE, strlen(TRACE_SIGNATURE))) {
+        fprintf(stderr, "%s: not a libbluray I/O trace\n", trace_file);
+        fclose(fp);
+        return -1;
+    }
+
+    t_start = _now_us();
+    while (fgets(line, sizeof(line), fp)) {
+        _replay_line(r, line, t_start);
+    }
+    total = _now_us() - t_start;
+
+    fclose(fp);
+    for (ii = 0; ii < r->num_files; ii++) {
+        _close(r, ii);
+    }
+
+    printf("\n%-6s %10s %12s %14s %14s %12s %12s\n",
+           "op", "count", "bytes", "recorded us", "replayed us", "rec max us", "rep max us");
+    for (ii = 0; ii < NUM_OPS; ii++) {
+        OP_STATS *s = &r->stats[ii];
+        if (s->count) {
+            printf("%-6s %10"PRIu64" %12"PRIu64" %14"PRIu64" %14"PRIu64" %12"PRIu64" %12"PRIu64"\n",
+                   op_names[ii], s->count, s->bytes, s->rec_us, s->rep_us, s->rec_max, s->rep_max);
+        }
+    }
+    printf("\n%u operation(s) over %"PRIu64" us, replay took %"PRIu64" us",
+           r->num_stalls, r->stall_us, total);
+    if (!r->fast) {
+        printf(", max. %"PRIu64" us behind schedule", r->late_us);
+    }
+    printf("\n");
+
+    return 0;
+}
+
+/*
+ *
+ */
+
+static void _usage(const char *name)
+{
+    fprintf(stderr,
+            "%s [-f] [-s] [-t ms] [-i image] [-m from=to] <trace_file>\n"
+            "    replay I/O trace recorded with bd_set_io_trace() (bd_bench -T)\n"
+            "Options:\n"
+            "    -f            replay back-to-back, ignore recorded timing\n"
+            "    -s            synthetic data only (do not read real files)\n"
+            "    -t <ms>       stall report threshold (default 50)\n"
+            "    -i <image>    disc image or device for UDF block reads\n"
+            "    -m <from=to>  replace path prefix 'from' with 'to'\n",
+            name);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    REPLAY      r;
+    const char *image = NULL;
+    char       *eq;
+    int         opt, result;
+
+    memset(&r, 0, sizeof(r));
+    r.stall_us = 50 * 1000;
+
+    while ((opt = getopt(argc, argv, "fst:i:m:h")) != -1) {
+        switch (opt) {
+            case 'f': r.fast = 1;                                     break;
+            case 's': r.synthetic = 1;                                break;
+            case 't': r.stall_us = strtoull(optarg, NULL, 0) * 1000;  break;
+            case 'i': image = optarg;                                 break;
+            case 'm':
+                eq = strchr(optarg, '=');
+                if (!eq) {
+                    _usage(argv[0]);
+                }
+                *eq = 0;
+                r.map_from = optarg;
+                r.map_to   = eq + 1;
+                break;
+            default:  _usage(argv[0]);
+        }
+    }
+
+    if (optind != argc - 1) {
+        _usage(argv[0]);
+    }
+
+    if (image) {
+        r.image = fopen(image, "rb");
+        if (!r.image) {
+            fprintf(stderr, "error opening %s\n", image);
+            return EXIT_FAILURE;
+        }
+    }
+
+    result = _replay(&r, argv[optind]);
+
+    if (r.image) {
+        fclose(r.image);
+    }
+    free(r.files);
+    free(r.buf);
+
+    return result < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Metadata parser benchmark: repeated bd_read_mpls() / bd_read_clpi() /
+ * bd_read_mobj() parsing of the given files
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/time.h>
+
+#include "libbluray/bluray.h"
+
+static uint64_t _now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static int _has_ext(const char *path, const char *ext)
+{
+    size_t len = strlen(path), ext_len = strlen(ext), ii;
+
+    if (len < ext_len) {
+        return 0;
+    }
+    for (ii = 0; ii < ext_len; ii++) {
+        char c = path[len - ext_len + ii];
+        if ((c >= 'A' && c <= 'Z' ? c + 'a' - 'A' : c) != ext[ii]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* parse file once, return 0 on error */
+static int _parse(const char *path)
+{
+    if (_has_ext(path, ".mpls")) {
+        struct mpls_pl *pl = bd_read_mpls(path);
+        bd_free_mpls(pl);
+        return !!pl;
+    }
+    if (_has_ext(path, ".clpi")) {
+        struct clpi_cl *cl = bd_read_clpi(path);
+        bd_free_clpi(cl);
+        return !!cl;
+    }
+    if (_has_ext(path, ".bdmv")) {
+        struct mobj_objects *mobj = bd_read_mobj(path);
+        bd_free_mobj(mobj);
+        return !!mobj;
+    }
+    return -1;
+}
+
+static void _usage(const char *cmd)
+{
+    fprintf(stderr,
+"Usage: %s [-n iterations] <file> [<file> ...]\n"
+"Options:\n"
+"    n N         - Number of times each file is parsed (default 100).\n"
+"    <file>      - .mpls, .clpi or MovieObject.bdmv file.\n"
+, cmd);
+
+    exit(EXIT_FAILURE);
+}
+
+#define OPTS "n:"
+
+int main(int argc, char *argv[])
+{
+    unsigned iterations = 100;
+    uint64_t total_us = 0, total_parses = 0;
+    int      opt, ii, ret = 0;
+
+    while ((opt = getopt(argc, argv, OPTS)) != -1) {
+        switch (opt) {
+            case 'n': iterations = (unsigned)atoi(optarg); break;
+            default:  _usage(argv[0]);
+        }
+    }
+    if (optind >= argc || iterations < 1) {
+        _usage(argv[0]);
+    }
+
+    for (ii = optind; ii < argc; ii++) {
+        const char *path = argv[ii];
+        uint64_t    t0, us;
+        unsigned    jj;
+        int         r;
+
+        r = _parse(path);
+        if (r <= 0) {
+            fprintf(stderr, "%s: %s\n", path, r < 0 ? "unknown file type" : "parse failed");
+            ret = 1;
+            continue;
+        }
+
+        t0 = _now_us();
+        for (jj = 0; jj < iterations; jj++) {
+            _parse(path);
+        }
+        us = _now_us() - t0;
+
+        printf("%s: %u parses, %.2f us / parse\n", path, iterations, (double)us / iterations);
+
+        total_us     += us;
+        total_parses += iterations;
+    }
+
+    if (total_parses > 0 && argc - optind > 1) {
+        printf("total: %"PRIu64" parses, %.2f us / parse\n", total_parses, (double)total_us / total_parses);
+    }
+
+    return ret;
+}
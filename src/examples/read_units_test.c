@@ -0,0 +1,338 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * bd_read_units() test with injected read errors.
+ *
+ * .m2ts reads fail in a range of aligned units (damaged area skipping is
+ * enabled), and one unit looks still encrypted (fatal error in the middle
+ * of a batch). Every returned batch must be contiguous clip data as stored
+ * on disc, and it must not change until it is released.
+ *
+ * Run against an unencrypted disc (ex. bdmv_gen output). Exit status is 0
+ * when all checks pass.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "libbluray/bluray.h"
+#include "file/filesystem.h"
+
+#define UNIT_SIZE    6144
+#define MAX_UNITS    32
+#define MAX_BATCHES  4096
+
+/*
+ * unit index: content hashes of clip file units.
+ * Clip files are indexed when they are opened.
+ */
+
+#define MAX_CLIPS  64
+
+typedef struct {
+    char     *path;
+    uint64_t *hash;       /* unit hashes in file order */
+    uint32_t  num_units;
+} CLIP_INDEX;
+
+static CLIP_INDEX clip_index[MAX_CLIPS];
+static unsigned   num_clips;
+
+static uint64_t _hash(const uint8_t *p, size_t size)
+{
+    uint64_t h = UINT64_C(0xcbf29ce484222325);
+    while (size--) {
+        h ^= *p++;
+        h *= UINT64_C(0x100000001b3);
+    }
+    return h;
+}
+
+static int _index_clip(const char *path)
+{
+    static uint8_t  unit[UNIT_SIZE];
+    CLIP_INDEX     *c;
+    FILE           *fp;
+    unsigned        ii;
+
+    for (ii = 0; ii < num_clips; ii++) {
+        if (!strcmp(clip_index[ii].path, path)) {
+            return 0;
+        }
+    }
+    if (num_clips >= MAX_CLIPS) {
+        return -1;
+    }
+
+    fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "can't open %s\n", path);
+        return -1;
+    }
+
+    c = &clip_index[num_clips];
+    c->path = malloc(strlen(path) + 1);
+    if (c->path) {
+        strcpy(c->path, path);
+    }
+    while (c->path && fread(unit, 1, UNIT_SIZE, fp) == UNIT_SIZE) {
+        uint64_t *tmp = realloc(c->hash, (c->num_units + 1) * sizeof(*c->hash));
+        if (!tmp) {
+            break;
+        }
+        c->hash = tmp;
+        c->hash[c->num_units++] = _hash(unit, UNIT_SIZE);
+    }
+
+    fclose(fp);
+    num_clips++;
+    return 0;
+}
+
+/* check units are stored contiguously in some clip file */
+static int _find_units(const uint8_t *data, unsigned n)
+{
+    unsigned cc, uu, ii;
+
+    for (cc = 0; cc < num_clips; cc++) {
+        const CLIP_INDEX *c = &clip_index[cc];
+        for (uu = 0; uu + n <= c->num_units; uu++) {
+            for (ii = 0; ii < n; ii++) {
+                if (c->hash[uu + ii] != _hash(data + (size_t)ii * UNIT_SIZE, UNIT_SIZE)) {
+                    break;
+                }
+            }
+            if (ii == n) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * failing .m2ts files
+ */
+
+static BD_FILE_OPEN  default_open;
+static uint64_t      bad_start = 45 * UNIT_SIZE;   /* unreadable range in each clip */
+static uint64_t      bad_end   = 52 * UNIT_SIZE;
+static uint64_t      enc_unit  = 10 * UNIT_SIZE;   /* unit that looks still encrypted */
+static unsigned      num_errors;
+
+typedef struct {
+    BD_FILE_H *fp;
+    uint64_t   pos;
+} FAULTY_FILE;
+
+static void _ff_close(BD_FILE_H *file)
+{
+    FAULTY_FILE *f = (FAULTY_FILE *)file->internal;
+    f->fp->close(f->fp);
+    free(f);
+    free(file);
+}
+
+static int64_t _ff_seek(BD_FILE_H *file, int64_t offset, int32_t origin)
+{
+    FAULTY_FILE *f = (FAULTY_FILE *)file->internal;
+    int64_t result = f->fp->seek(f->fp, offset, origin);
+    if (result >= 0) {
+        f->pos = (uint64_t)f->fp->tell(f->fp);
+    }
+    return result;
+}
+
+static int64_t _ff_tell(BD_FILE_H *file)
+{
+    FAULTY_FILE *f = (FAULTY_FILE *)file->internal;
+    return f->fp->tell(f->fp);
+}
+
+static int _ff_eof(BD_FILE_H *file)
+{
+    FAULTY_FILE *f = (FAULTY_FILE *)file->internal;
+    return f->fp->eof(f->fp);
+}
+
+static int64_t _ff_read(BD_FILE_H *file, uint8_t *buf, int64_t size)
+{
+    FAULTY_FILE *f = (FAULTY_FILE *)file->internal;
+    int64_t got;
+
+    if (f->pos < bad_end && f->pos + (uint64_t)size > bad_start) {
+        num_errors++;
+        if (f->pos >= bad_start) {
+            return -1;
+        }
+        /* short read up to damaged area */
+        size = (int64_t)(bad_start - f->pos);
+    }
+
+    got = f->fp->read(f->fp, buf, size);
+    if (got > 0) {
+        if (f->pos <= enc_unit && f->pos + (uint64_t)got >= enc_unit + UNIT_SIZE) {
+            /* set copy permission indicator and break TS sync */
+            uint8_t *unit = buf + (enc_unit - f->pos);
+            unit[0] |= 0xc0;
+            unit[4 + 192] = 0;
+            num_errors++;
+        }
+        f->pos += (uint64_t)got;
+    }
+    return got;
+}
+
+static BD_FILE_H *_open_faulty(const char *filename, const char *mode)
+{
+    BD_FILE_H   *fp = default_open(filename, mode);
+    BD_FILE_H   *file;
+    FAULTY_FILE *f;
+    size_t       len = strlen(filename);
+
+    if (!fp || len < 5 || strcmp(filename + len - 5, ".m2ts")) {
+        return fp;
+    }
+    if (_index_clip(filename) < 0) {
+        fp->close(fp);
+        return NULL;
+    }
+
+    file = calloc(1, sizeof(*file));
+    f    = calloc(1, sizeof(*f));
+    if (!file || !f) {
+        free(file);
+        free(f);
+        fp->close(fp);
+        return NULL;
+    }
+
+    f->fp          = fp;
+    file->internal = f;
+    file->close    = _ff_close;
+    file->seek     = _ff_seek;
+    file->tell     = _ff_tell;
+    file->eof      = _ff_eof;
+    file->read     = _ff_read;
+
+    return file;
+}
+
+/*
+ *
+ */
+
+static int _end_of_title(BLURAY *bd)
+{
+    BD_EVENT ev;
+    int      eot = 0;
+
+    while (bd_get_event(bd, &ev)) {
+        eot |= (ev.event == BD_EVENT_END_OF_TITLE);
+    }
+    return eot;
+}
+
+typedef struct {
+    BLURAY_UNITS units;
+    uint64_t     hash;
+} BATCH;
+
+int main(int argc, char *argv[])
+{
+    static BATCH batch[MAX_BATCHES];
+    BLURAY  *bd;
+    unsigned num_batches = 0, num_units = 0, retries = 0, ii;
+    int      title, failed = 0;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <media_path> [<title_number>]\n", argv[0]);
+        return 2;
+    }
+    title = argc > 2 ? atoi(argv[2]) : 0;
+
+    default_open = bd_register_file(_open_faulty);
+
+    bd = bd_open(argv[1], NULL);
+    if (!bd || bd_get_titles(bd, TITLES_ALL, 0) <= (uint32_t)title || !bd_select_title(bd, title)) {
+        fprintf(stderr, "Error opening title %d of %s\n", title, argv[1]);
+        return 2;
+    }
+    bd_set_player_setting(bd, BLURAY_PLAYER_SETTING_READ_ERROR_BUDGET, 1000);
+    bd_get_event(bd, NULL);
+
+    /* read title. Keep all batches until the end. */
+    while (num_batches < MAX_BATCHES) {
+        BATCH *b = &batch[num_batches];
+        int n = bd_read_units(bd, &b->units, MAX_UNITS);
+        if (n < 0 && retries++ < 1000) {
+            /* unit failed, following units are still readable */
+            continue;
+        }
+        if (n == 0 && !_end_of_title(bd) && retries++ < 1000) {
+            /* broken unit was skipped */
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        num_batches++;
+        num_units += (unsigned)n;
+
+        if (b->units.num_units != (unsigned)n || !b->units.buffer) {
+            printf("batch %u: %d units returned, units struct not filled\n", num_batches - 1, n);
+            failed = 1;
+        } else if (!_find_units(b->units.data, (unsigned)n)) {
+            printf("batch %u: %d units are not contiguous clip data\n", num_batches - 1, n);
+            failed = 1;
+        }
+        b->hash = _hash(b->units.data, (size_t)n * UNIT_SIZE);
+    }
+
+    /* handed out units must not change */
+    for (ii = 0; ii < num_batches; ii++) {
+        if (_hash(batch[ii].units.data, (size_t)batch[ii].units.num_units * UNIT_SIZE) != batch[ii].hash) {
+            printf("batch %u: units changed after bd_read_units() returned\n", ii);
+            failed = 1;
+        }
+        bd_release_units(&batch[ii].units);
+    }
+
+    bd_close(bd);
+    for (ii = 0; ii < num_clips; ii++) {
+        free(clip_index[ii].path);
+        free(clip_index[ii].hash);
+    }
+
+    printf("%u units in %u batches, %u injected read errors: %s\n",
+           num_units, num_batches, num_errors, failed ? "FAILED" : "OK");
+
+    if (!num_errors) {
+        printf("no read errors were injected (clip too short ?)\n");
+        return 2;
+    }
+    return failed;
+}
@@ -0,0 +1,120 @@
+#!/bin/sh
+#
+# Benchmark regression suite ("make bench").
+#
+# Generates synthetic discs with bdmv_gen at each scale (number of playlists
+# in BENCH_SCALES), runs the example benchmarks against them and writes one
+# "<metric> <value>" line per result. All values are times (us or ns):
+# lower is better.
+#
+# When a baseline file is given, results are compared against it and the
+# script fails if any metric is more than BENCH_TOLERANCE percent (and
+# BENCH_MIN_DELTA units) slower than the baseline.
+#
+# Usage: run_bench.sh <bin dir> <work dir> <results file> [<baseline file>]
+#
+# Environment:
+#   BENCH_SCALES       playlists per generated disc (default "10 100 1000")
+#   BENCH_TOLERANCE    allowed slowdown in percent (default 20)
+#   BENCH_MIN_DELTA    ignore smaller absolute differences (default 5)
+#   BENCH_GFX_CAPTURE  gfx_bench capture file (optional, graphics replay)
+#
+
+set -e
+
+if [ $# -lt 3 ]; then
+    echo "Usage: $0 <bin dir> <work dir> <results file> [<baseline file>]" >&2
+    exit 1
+fi
+
+BIN=$1
+WORK=$2
+RESULTS=$3
+BASELINE=$4
+
+SCALES=${BENCH_SCALES:-"10 100 1000"}
+TOLERANCE=${BENCH_TOLERANCE:-20}
+MIN_DELTA=${BENCH_MIN_DELTA:-5}
+
+rm -rf "$WORK"
+mkdir -p "$WORK"
+: > "$RESULTS"
+
+result() {
+    echo "$1 $2" >> "$RESULTS"
+    echo "  $1 $2"
+}
+
+for scale in $SCALES; do
+    disc=$WORK/disc-$scale
+    out=$WORK/out-$scale
+    mkdir -p "$out"
+
+    echo "scale $scale: generating disc"
+    # two shared 40 Mbit/s clips: enough data for bd_read() to take tens of ms
+    "$BIN/bdmv_gen" -p "$scale" -c 2 -r 40000 "$disc" > "$out/bdmv_gen.txt"
+
+    # bd_read() throughput (main title), wall time in us
+    "$BIN/bd_bench" "$disc" > "$out/bd_bench.txt"
+    result "read_s$scale" \
+        $(awk '/^title [0-9]+:/ { for (i = 1; i < NF; i++) if ($(i + 1) == "us):") t += substr($i, 2) } END { printf "%.0f", t }' "$out/bd_bench.txt")
+
+    # navigation latency (ns)
+    "$BIN/bd_nav_bench" -n 200 -o "$out/bd_nav_bench.json" "$disc"
+    for m in select_title select_playlist seek_chapter seek_time first_read; do
+        result "nav_${m}_s$scale" \
+            $(sed -n "s/^ *\"$m\": {.*\"avg_ns\": \([0-9]*\).*/\1/p" "$out/bd_nav_bench.json")
+    done
+
+    # metadata parsing
+    "$BIN/parse_bench" -n 20 "$disc"/BDMV/PLAYLIST/*.mpls "$disc"/BDMV/CLIPINF/*.clpi \
+        "$disc/BDMV/MovieObject.bdmv" > "$out/parse_bench.txt"
+    result "parse_s$scale" \
+        $(awk '/^total:/ { printf "%.0f", $4 * 1000 }' "$out/parse_bench.txt")
+
+    # EP map lookups
+    "$BIN/clpi_dump" --bench-seek=200000 "$disc/BDMV/CLIPINF/00000.clpi" > "$out/clpi_dump.txt"
+    awk -v s="$scale" -F: '/ns\/lookup/ {
+            name = $1; gsub(/[^a-z_]+/, "_", name); gsub(/^_+|_+$/, "", name);
+            split($2, v, " "); printf "seek_%s_s%s %.1f\n", name, s, v[1] }' \
+        "$out/clpi_dump.txt" | while read -r name value; do result "$name" "$value"; done
+
+    # HDMV title start (movie object to first PlayPL)
+    "$BIN/hdmv_test" -T "$disc" > "$out/hdmv_test.txt"
+    result "hdmv_start_s$scale" \
+        $(awk '/ us .* instructions/ { for (i = 2; i < NF; i++) if ($(i + 1) == "us") t += $i } END { printf "%.0f", t }' "$out/hdmv_test.txt")
+done
+
+# graphics decoding (captured IG / PG stream)
+if [ -n "$BENCH_GFX_CAPTURE" ]; then
+    echo "graphics replay: $BENCH_GFX_CAPTURE"
+    "$BIN/gfx_bench" -l 5 "$BENCH_GFX_CAPTURE" > "$WORK/gfx_bench.txt"
+    result "gfx_decode" \
+        $(awk '/us in decoder/ { for (i = 2; i <= NF; i++) if ($i == "in" && $(i + 1) == "decoder") print $(i - 2) }' "$WORK/gfx_bench.txt")
+fi
+
+echo "results written to $RESULTS"
+
+if [ -z "$BASELINE" ]; then
+    exit 0
+fi
+
+if [ ! -f "$BASELINE" ]; then
+    echo "baseline $BASELINE not found" >&2
+    exit 1
+fi
+
+awk -v tol="$TOLERANCE" -v min_delta="$MIN_DELTA" '
+    FNR == NR { base[$1] = $2; next }
+    ($1 in base) {
+        b = base[$1]; c = $2
+        pct = (b > 0) ? (c - b) * 100 / b : 0
+        if (c > b * (1 + tol / 100) && c - b >= min_delta) {
+            printf "REGRESSION %s: %s -> %s (%+.1f%%)\n", $1, b, c, pct
+            fail++
+        } else {
+            printf "ok         %s: %s -> %s (%+.1f%%)\n", $1, b, c, pct
+        }
+    }
+    END { if (fail) { printf "%d benchmark(s) regressed\n", fail; exit 1 } }
+' "$BASELINE" "$RESULTS"
@@ -0,0 +1,241 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "drive.h"
+
+#include "util/logging.h"
+#include "util/macro.h"
+#include "util/strutl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(HAVE_LINUX_CDROM_H) && defined(HAVE_MNTENT_H)
+#define USE_CDROM_IOCTL
+#include <fcntl.h>
+#include <unistd.h>
+#include <mntent.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/cdrom.h>
+#endif
+
+struct bd_drive_s {
+    int      fd;
+    uint32_t speed;  /* current speed (KB/s), 0 = drive default */
+};
+
+#ifdef USE_CDROM_IOCTL
+
+/* resolve mount point to device node */
+static char *_device_node(const char *path)
+{
+    struct stat st;
+    char *dev = NULL;
+
+    if (stat(path, &st)) {
+        return NULL;
+    }
+    if (S_ISBLK(st.st_mode)) {
+        return str_dup(path);
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        /* image file */
+        return NULL;
+    }
+
+    FILE *f = setmntent("/proc/self/mounts", "r");
+    if (f) {
+        size_t len = strlen(path);
+        struct mntent *m;
+
+        /* ignore trailing slash */
+        while (len > 1 && path[len - 1] == '/') {
+            len--;
+        }
+        while ((m = getmntent(f)) != NULL) {
+            if (!strncmp(m->mnt_dir, path, len) && !m->mnt_dir[len] && !strncmp(m->mnt_fsname, "/dev/", 5)) {
+                dev = str_dup(m->mnt_fsname);
+                break;
+            }
+        }
+        endmntent(f);
+    }
+
+    return dev;
+}
+
+static void _put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static int _send_packet(int fd, const uint8_t *cdb, uint8_t *data, unsigned data_len)
+{
+    struct cdrom_generic_command cgc;
+    struct request_sense         sense;
+
+    memset(&cgc, 0, sizeof(cgc));
+    memset(&sense, 0, sizeof(sense));
+
+    memcpy(cgc.cmd, cdb, CDROM_PACKET_SIZE);
+    cgc.buffer         = data;
+    cgc.buflen         = data_len;
+    cgc.data_direction = data ? CGC_DATA_WRITE : CGC_DATA_NONE;
+    cgc.sense          = &sense;
+    cgc.timeout        = 5000;
+
+    if (ioctl(fd, CDROM_SEND_PACKET, &cgc) < 0) {
+        BD_DEBUG(DBG_FILE, "drive command 0x%02x failed (sense %x/%02x/%02x)\n",
+                 cdb[0], sense.sense_key, sense.asc, sense.ascq);
+        return -1;
+    }
+    return 0;
+}
+
+/* MMC SET STREAMING with performance descriptor */
+static int _set_streaming(int fd, uint32_t kbytes_per_sec)
+{
+    uint8_t cdb[CDROM_PACKET_SIZE];
+    uint8_t desc[28];
+
+    memset(cdb, 0, sizeof(cdb));
+    memset(desc, 0, sizeof(desc));
+
+    cdb[0]  = 0xb6;
+    cdb[10] = sizeof(desc);
+
+    if (!kbytes_per_sec) {
+        desc[0] = 0x04;  /* RDD: restore drive defaults */
+    }
+    _put32(desc + 8,  0xffffffff);      /* end LBA */
+    _put32(desc + 12, kbytes_per_sec);  /* read size (KB) ... */
+    _put32(desc + 16, 1000);            /* ... per read time (ms) */
+    _put32(desc + 20, kbytes_per_sec);
+    _put32(desc + 24, 1000);
+
+    return _send_packet(fd, cdb, desc, sizeof(desc));
+}
+
+/* MMC SET CD SPEED */
+static int _set_cd_speed(int fd, uint32_t kbytes_per_sec)
+{
+    uint8_t  cdb[CDROM_PACKET_SIZE];
+    uint16_t speed = kbytes_per_sec ? (uint16_t)BD_MIN(kbytes_per_sec, 0xfffe) : 0xffff;
+
+    memset(cdb, 0, sizeof(cdb));
+
+    cdb[0] = 0xbb;
+    cdb[2] = speed >> 8;
+    cdb[3] = speed;
+    cdb[4] = 0xff;  /* write speed: maximum */
+    cdb[5] = 0xff;
+
+    return _send_packet(fd, cdb, NULL, 0);
+}
+
+#endif /* USE_CDROM_IOCTL */
+
+BD_DRIVE *drive_open(const char *device_path)
+{
+#ifdef USE_CDROM_IOCTL
+    BD_DRIVE *p;
+    char     *dev;
+    int       fd;
+
+    if (!device_path) {
+        return NULL;
+    }
+
+    dev = _device_node(device_path);
+    if (!dev) {
+        BD_DEBUG(DBG_FILE, "drive speed control: %s is not an optical drive\n", device_path);
+        return NULL;
+    }
+
+    fd = open(dev, O_RDONLY | O_NONBLOCK);
+    if (fd < 0) {
+        BD_DEBUG(DBG_FILE, "drive speed control: error opening %s\n", dev);
+        X_FREE(dev);
+        return NULL;
+    }
+
+    p = calloc(1, sizeof(*p));
+    if (!p) {
+        close(fd);
+        X_FREE(dev);
+        return NULL;
+    }
+
+    p->fd = fd;
+
+    BD_DEBUG(DBG_FILE, "drive speed control: using %s\n", dev);
+    X_FREE(dev);
+
+    return p;
+#else
+    (void)device_path;
+    BD_DEBUG(DBG_FILE, "drive speed control not supported\n");
+    return NULL;
+#endif
+}
+
+void drive_close(BD_DRIVE **pp)
+{
+    if (pp && *pp) {
+        BD_DRIVE *p = *pp;
+
+        drive_set_speed(p, 0);
+#ifdef USE_CDROM_IOCTL
+        close(p->fd);
+#endif
+        X_FREE(*pp);
+    }
+}
+
+int drive_set_speed(BD_DRIVE *p, uint32_t kbytes_per_sec)
+{
+    if (!p) {
+        return -1;
+    }
+    if (p->speed == kbytes_per_sec) {
+        return 0;
+    }
+
+#ifdef USE_CDROM_IOCTL
+    if (_set_streaming(p->fd, kbytes_per_sec) < 0 &&
+        _set_cd_speed(p->fd, kbytes_per_sec) < 0) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "drive speed control: setting speed failed\n");
+        return -1;
+    }
+
+    BD_DEBUG(DBG_FILE, "drive read speed set to %u KB/s\n", kbytes_per_sec);
+    p->speed = kbytes_per_sec;
+    return 0;
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,48 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BD_DRIVE_H_
+#define BD_DRIVE_H_
+
+#include "util/attributes.h"
+
+#include <stdint.h>
+
+/*
+ * Optical drive read speed control
+ *
+ * Speed is set with MMC SET STREAMING command, or with SET CD SPEED if
+ * drive does not support streaming performance descriptors.
+ * Implemented on Linux.
+ */
+
+typedef struct bd_drive_s BD_DRIVE;
+
+#define DRIVE_SPEED_1X_BD  4496  /* KB/s */
+
+/* device_path: device node (/dev/sr0) or mount point of disc. NULL if not a drive or not supported. */
+BD_PRIVATE BD_DRIVE *drive_open(const char *device_path);
+
+/* drive default speed is restored */
+BD_PRIVATE void      drive_close(BD_DRIVE **p);
+
+/* set read speed in KB/s (0 = restore drive default). Returns 0 on success. */
+BD_PRIVATE int       drive_set_speed(BD_DRIVE *p, uint32_t kbytes_per_sec);
+
+#endif /* BD_DRIVE_H_ */
@@ -23,11 +23,15 @@
 
 #include "file.h"
 
+#include "util/buffer.h"
 #include "util/logging.h"
 #include "util/macro.h"
+#include "util/mutex.h"
 #include "util/strutl.h"
 
+#include <inttypes.h>
 #include <stdio.h>  // SEEK_*
+#include <stdlib.h>
 #include <string.h> // strchr
 
 
@@ -45,6 +49,225 @@ int64_t file_size(BD_FILE_H *fp)
     return length;
 }
 
+/*
+ * extended file handles
+ */
+
+/* eof() is not used. It is set to this function to tag extended file handles. */
+static int _file_ext_eof(BD_FILE_H *fp)
+{
+    (void)fp;
+    return 0;
+}
+
+BD_FILE_EXT_H *file_ext_alloc(void)
+{
+    BD_FILE_EXT_H *p = calloc(1, sizeof(BD_FILE_EXT_H));
+    if (p) {
+        p->h.eof = _file_ext_eof;
+    }
+    return p;
+}
+
+int64_t file_read_at(BD_FILE_H *fp, int64_t offset, uint8_t *buf, int64_t size)
+{
+    if (fp->eof == _file_ext_eof) {
+        BD_FILE_EXT_H *ext = (BD_FILE_EXT_H *)fp;
+        if (ext->read_at) {
+            return ext->read_at(fp, offset, buf, size);
+        }
+    }
+
+    if (file_tell(fp) != offset) {
+        if (file_seek(fp, offset, SEEK_SET) < 0) {
+            BD_DEBUG(DBG_FILE | DBG_CRIT, "file_read_at(): seek to %"PRId64" failed\n", offset);
+            return -1;
+        }
+    }
+    return fp->read(fp, buf, size);
+}
+
+void file_prefetch(BD_FILE_H *fp, int64_t offset, int64_t size)
+{
+    if (fp->eof == _file_ext_eof) {
+        BD_FILE_EXT_H *ext = (BD_FILE_EXT_H *)fp;
+        if (ext->prefetch) {
+            ext->prefetch(fp, offset, size);
+        }
+    }
+}
+
+/*
+ * direct file access
+ */
+
+#define DIRECT_BUF_SIZE  (256 * 1024)  /* bounce buffer for unaligned reads */
+
+typedef struct {
+    BD_FILE_H *fp;       /* unbuffered file, aligned reads only */
+    unsigned   align;
+    int64_t    size;
+    int64_t    pos;      /* sequential read position */
+
+    BD_MUTEX   mutex;    /* protects buf */
+    uint8_t   *buf;
+} DIRECT_FILE;
+
+static int64_t _direct_read_at(BD_FILE_H *file, int64_t offset, uint8_t *buf, int64_t size)
+{
+    DIRECT_FILE *df = (DIRECT_FILE *)file->internal;
+    int64_t      done = 0, got = 0;
+
+    if (size <= 0 || offset < 0) {
+        return 0;
+    }
+
+    while (done < size) {
+        int64_t  off = offset + done;
+        int64_t  len = size - done;
+        uint8_t *dst = buf + done;
+
+        if (!(off % df->align) && !((uintptr_t)dst % df->align) && len >= df->align) {
+            /* read directly to caller buffer */
+            len -= len % df->align;
+            got = file_read_at(df->fp, off, dst, len);
+            if (got <= 0) {
+                break;
+            }
+            done += got;
+
+        } else {
+            /* read aligned block to bounce buffer */
+            int64_t start = off - off % df->align;
+            int64_t skip  = off - start;
+            int64_t req   = BD_MIN(skip + len + df->align - 1, DIRECT_BUF_SIZE);
+
+            req -= req % df->align;
+            len  = BD_MIN(len, req - skip);
+
+            bd_mutex_lock(&df->mutex);
+            got = file_read_at(df->fp, start, df->buf, req);
+            if (got > skip) {
+                got = BD_MIN(got - skip, len);
+                memcpy(dst, df->buf + skip, (size_t)got);
+            } else if (got >= 0) {
+                got = 0;  /* EOF */
+            }
+            bd_mutex_unlock(&df->mutex);
+
+            if (got <= 0) {
+                break;
+            }
+            done += got;
+        }
+
+        if (got < len) {
+            /* EOF */
+            break;
+        }
+    }
+
+    return done > 0 ? done : got;
+}
+
+static int64_t _direct_read(BD_FILE_H *file, uint8_t *buf, int64_t size)
+{
+    DIRECT_FILE *df = (DIRECT_FILE *)file->internal;
+    int64_t      got;
+
+    got = _direct_read_at(file, df->pos, buf, size);
+    if (got > 0) {
+        df->pos += got;
+    }
+    return got;
+}
+
+static int64_t _direct_seek(BD_FILE_H *file, int64_t offset, int32_t origin)
+{
+    DIRECT_FILE *df = (DIRECT_FILE *)file->internal;
+
+    switch (origin) {
+        case SEEK_CUR: offset += df->pos;  break;
+        case SEEK_END: offset += df->size; break;
+        case SEEK_SET: break;
+        default: return -1;
+    }
+
+    if (offset < 0) {
+        return -1;
+    }
+    df->pos = offset;
+    return offset;
+}
+
+static int64_t _direct_tell(BD_FILE_H *file)
+{
+    DIRECT_FILE *df = (DIRECT_FILE *)file->internal;
+    return df->pos;
+}
+
+static void _direct_prefetch(BD_FILE_H *file, int64_t offset, int64_t size)
+{
+    DIRECT_FILE *df = (DIRECT_FILE *)file->internal;
+    file_prefetch(df->fp, offset, size);
+}
+
+static void _direct_free(DIRECT_FILE *df)
+{
+    if (df->fp) {
+        file_close(df->fp);
+    }
+    bd_buffer_free(df->buf, DIRECT_BUF_SIZE);
+    bd_mutex_destroy(&df->mutex);
+    X_FREE(df);
+}
+
+static void _direct_close(BD_FILE_H *file)
+{
+    _direct_free((DIRECT_FILE *)file->internal);
+    X_FREE(file);
+}
+
+BD_FILE_H *file_open_direct(const char *filename)
+{
+    BD_FILE_EXT_H *file;
+    DIRECT_FILE   *df;
+    unsigned       align = 0;
+
+    df = calloc(1, sizeof(*df));
+    if (!df) {
+        return NULL;
+    }
+    bd_mutex_init(&df->mutex);
+
+    df->fp = file_open_unbuffered(filename, &align);
+    if (!df->fp || !align || align > DIRECT_BUF_SIZE || (align & (align - 1))) {
+        _direct_free(df);
+        return NULL;
+    }
+
+    df->align = align;
+    df->size  = file_size(df->fp);
+    df->buf   = bd_buffer_alloc(DIRECT_BUF_SIZE);
+    file      = file_ext_alloc();
+    if (df->size < 0 || !df->buf || !file) {
+        _direct_free(df);
+        X_FREE(file);
+        return NULL;
+    }
+
+    file->h.internal = df;
+    file->h.close    = _direct_close;
+    file->h.seek     = _direct_seek;
+    file->h.tell     = _direct_tell;
+    file->h.read     = _direct_read;
+    file->read_at    = _direct_read_at;
+    file->prefetch   = _direct_prefetch;
+
+    BD_DEBUG(DBG_FILE, "Opened %s for direct I/O (alignment %u)\n", filename, align);
+    return &file->h;
+}
+
 int file_mkdirs(const char *path)
 {
     int result = 0;
@@ -45,8 +45,48 @@
 //#define file_write(X,Y,Z) (size_t)X->write(X,Y,Z)
 BD_PRIVATE int64_t file_size(BD_FILE_H *fp);
 
+/*
+ * extended file handles
+ *
+ * Public BD_FILE_H can't be extended without breaking ABI (application can provide
+ * its own file handles). Internal file implementations allocate extended handles
+ * with file_ext_alloc(). Extended handle can be freed with free().
+ */
+
+typedef struct bd_file_ext_s BD_FILE_EXT_H;
+struct bd_file_ext_s {
+    BD_FILE_H h;
+
+    /* optional: positional read. Does not use or change current file position. */
+    int64_t (*read_at)(BD_FILE_H *file, int64_t offset, uint8_t *buf, int64_t size);
+
+    /* optional: hint that data will be needed soon. Must not block. */
+    void    (*prefetch)(BD_FILE_H *file, int64_t offset, int64_t size);
+};
+
+BD_PRIVATE BD_FILE_EXT_H *file_ext_alloc(void);
+
+/* positional read. Falls back to seek + read if file does not support read_at(). */
+BD_PRIVATE int64_t file_read_at(BD_FILE_H *fp, int64_t offset, uint8_t *buf, int64_t size);
+
+/* read-ahead hint. No-op if file does not support prefetch(). */
+BD_PRIVATE void    file_prefetch(BD_FILE_H *fp, int64_t offset, int64_t size);
+
 BD_PRIVATE extern BD_FILE_H* (*file_open)(const char* filename, const char *mode);
 
+/*
+ * direct (unbuffered) file access
+ *
+ * Read-only, data bypasses OS page cache. Used for large files that are read
+ * only once. Reads can use any offset, size and buffer: unaligned parts are
+ * read through an internal aligned buffer.
+ * Returns NULL if direct I/O is not supported (use file_open()).
+ */
+BD_PRIVATE BD_FILE_H *file_open_direct(const char *filename);
+
+/* platform part (file_posix.c / file_win32.c): reads must be aligned to *align (offset, size and buffer) */
+BD_PRIVATE BD_FILE_H *file_open_unbuffered(const char *filename, unsigned *align);
+
 BD_PRIVATE BD_FILE_OPEN file_open_default(void);
 
 
@@ -18,13 +18,25 @@
  * <http://www.gnu.org/licenses/>.
  */
 
+/* pread() */
+#if !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 600
+#endif
+
+/* O_DIRECT */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
 
 #include "file.h"
+#include "util/atomic.h"
 #include "util/macro.h"
 #include "util/logging.h"
+#include "util/mutex.h"
 
 #include <errno.h>
 #include <inttypes.h>
@@ -35,8 +47,15 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
 static void file_close_linux(BD_FILE_H *file)
 {
     if (file) {
@@ -95,6 +114,58 @@ static int64_t file_read_linux(BD_FILE_H *file, uint8_t *buf, int64_t size)
     return (int64_t)got;
 }
 
+static int64_t _pread_full(int fd, int64_t offset, uint8_t *buf, int64_t size)
+{
+    ssize_t got, result;
+
+    for (got = 0; got < (ssize_t)size; got += result) {
+        result = pread(fd, buf + got, size - got, (off_t)(offset + got));
+        if (result < 0) {
+            if (errno != EINTR) {
+                BD_DEBUG(DBG_FILE, "pread() failed (%d)\n", errno);
+                break;
+            }
+            result = 0;
+        } else if (result == 0) {
+            // hit EOF.
+            break;
+        }
+    }
+    return (int64_t)got;
+}
+
+static int64_t file_read_at_linux(BD_FILE_H *file, int64_t offset, uint8_t *buf, int64_t size)
+{
+    if (size <= 0 || size >= BD_MAX_SSIZE || offset < 0) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid read of size %"PRId64" at %"PRId64" (%p)\n", size, offset, (void*)file);
+        return 0;
+    }
+
+    return _pread_full((int)(intptr_t)file->internal, offset, buf, size);
+}
+
+static void file_prefetch_linux(BD_FILE_H *file, int64_t offset, int64_t size)
+{
+    int fd = (int)(intptr_t)file->internal;
+
+#if defined(POSIX_FADV_WILLNEED)
+    if (posix_fadvise(fd, (off_t)offset, (off_t)size, POSIX_FADV_WILLNEED)) {
+        BD_DEBUG(DBG_FILE, "posix_fadvise() failed (%p)\n", (void*)file);
+    }
+#elif defined(F_RDADVISE)
+    struct radvisory ra;
+    ra.ra_offset = (off_t)offset;
+    ra.ra_count  = (int)BD_MIN(size, 0x7fffffff);
+    if (fcntl(fd, F_RDADVISE, &ra) < 0) {
+        BD_DEBUG(DBG_FILE, "fcntl(F_RDADVISE) failed (%p)\n", (void*)file);
+    }
+#else
+    (void)fd;
+    (void)offset;
+    (void)size;
+#endif
+}
+
 static int64_t file_write_linux(BD_FILE_H *file, const uint8_t *buf, int64_t size)
 {
     ssize_t written, result;
@@ -117,6 +188,749 @@ static int64_t file_write_linux(BD_FILE_H *file, const uint8_t *buf, int64_t siz
     return (int64_t)written;
 }
 
+/*
+ * memory-mapped read-only files
+ *
+ * Enabled with environment variable LIBBLURAY_FILE_MMAP=1.
+ * Note that I/O errors in mapped files are reported with SIGBUS,
+ * so this should be used only with reliable (local) storage.
+ */
+
+#define MMAP_ADVISE_SIZE  (8*1024*1024)  /* read-ahead window */
+
+typedef struct {
+    int      fd;
+    uint8_t *map;
+    uint64_t size;
+    uint64_t pos;
+    uint64_t advise_start; /* last WILLNEED window */
+    uint64_t advise_end;
+} MMAP_FILE;
+
+static void _mmap_advise(MMAP_FILE *mf)
+{
+    /* keep read-ahead window in front of current position */
+    if (mf->pos < mf->advise_start ||
+        (mf->pos + MMAP_ADVISE_SIZE / 2 > mf->advise_end && mf->advise_end < mf->size)) {
+        long     page  = sysconf(_SC_PAGESIZE);
+        uint64_t start = mf->pos - mf->pos % (page > 0 ? (uint64_t)page : 4096);
+        uint64_t len   = BD_MIN((uint64_t)MMAP_ADVISE_SIZE, mf->size - start);
+
+        posix_madvise(mf->map + start, (size_t)len, POSIX_MADV_WILLNEED);
+        mf->advise_start = start;
+        mf->advise_end   = start + len;
+    }
+}
+
+static void file_close_mmap(BD_FILE_H *file)
+{
+    if (file) {
+        MMAP_FILE *mf = (MMAP_FILE *)file->internal;
+
+        munmap(mf->map, (size_t)mf->size);
+        close(mf->fd);
+
+        BD_DEBUG(DBG_FILE, "Closed mmap file (%p)\n", (void*)file);
+
+        X_FREE(mf);
+        X_FREE(file);
+    }
+}
+
+static int64_t file_seek_mmap(BD_FILE_H *file, int64_t offset, int32_t origin)
+{
+    MMAP_FILE *mf = (MMAP_FILE *)file->internal;
+    int64_t    pos;
+
+    switch (origin) {
+        case SEEK_SET: pos = offset;                       break;
+        case SEEK_CUR: pos = (int64_t)mf->pos + offset;    break;
+        case SEEK_END: pos = (int64_t)mf->size + offset;   break;
+        default:       pos = -1;                           break;
+    }
+
+    if (pos < 0) {
+        BD_DEBUG(DBG_FILE, "seek failed (%p)\n", (void*)file);
+        return -1;
+    }
+
+    mf->pos = (uint64_t)pos;
+    return pos;
+}
+
+static int64_t file_tell_mmap(BD_FILE_H *file)
+{
+    MMAP_FILE *mf = (MMAP_FILE *)file->internal;
+    return (int64_t)mf->pos;
+}
+
+static int64_t file_read_mmap(BD_FILE_H *file, uint8_t *buf, int64_t size)
+{
+    MMAP_FILE *mf = (MMAP_FILE *)file->internal;
+
+    if (size <= 0 || size >= BD_MAX_SSIZE) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid read of size %"PRId64" (%p)\n", size, (void*)file);
+        return 0;
+    }
+
+    if (mf->pos >= mf->size) {
+        return 0;
+    }
+
+    size = (int64_t)BD_MIN((uint64_t)size, mf->size - mf->pos);
+
+    _mmap_advise(mf);
+
+    memcpy(buf, mf->map + mf->pos, (size_t)size);
+    mf->pos += size;
+
+    return size;
+}
+
+static int64_t file_read_at_mmap(BD_FILE_H *file, int64_t offset, uint8_t *buf, int64_t size)
+{
+    MMAP_FILE *mf = (MMAP_FILE *)file->internal;
+
+    if (size <= 0 || size >= BD_MAX_SSIZE || offset < 0) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid read of size %"PRId64" at %"PRId64" (%p)\n", size, offset, (void*)file);
+        return 0;
+    }
+
+    if ((uint64_t)offset >= mf->size) {
+        return 0;
+    }
+
+    size = (int64_t)BD_MIN((uint64_t)size, mf->size - offset);
+
+    memcpy(buf, mf->map + offset, (size_t)size);
+
+    return size;
+}
+
+static void file_prefetch_mmap(BD_FILE_H *file, int64_t offset, int64_t size)
+{
+    MMAP_FILE *mf   = (MMAP_FILE *)file->internal;
+    long       page = sysconf(_SC_PAGESIZE);
+    uint64_t   start;
+
+    if (offset < 0 || (uint64_t)offset >= mf->size || size <= 0) {
+        return;
+    }
+
+    start = offset - offset % (page > 0 ? page : 4096);
+    size  = (int64_t)BD_MIN((uint64_t)(size + (offset - start)), mf->size - start);
+
+    posix_madvise(mf->map + start, (size_t)size, POSIX_MADV_WILLNEED);
+}
+
+static int _use_mmap(void)
+{
+    static int use_mmap = -1;
+
+    if (use_mmap < 0) {
+        const char *env = getenv("LIBBLURAY_FILE_MMAP");
+        use_mmap = env && atoi(env) > 0;
+    }
+
+    return use_mmap;
+}
+
+static BD_FILE_H *_file_open_mmap(int fd)
+{
+    BD_FILE_EXT_H *file;
+    MMAP_FILE     *mf;
+    struct stat    st;
+    void       *map;
+
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        return NULL;
+    }
+    if ((uint64_t)st.st_size != (uint64_t)(size_t)st.st_size) {
+        /* too large for address space */
+        return NULL;
+    }
+
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        BD_DEBUG(DBG_FILE, "mmap() failed\n");
+        return NULL;
+    }
+
+    file = file_ext_alloc();
+    mf   = calloc(1, sizeof(MMAP_FILE));
+    if (!file || !mf) {
+        munmap(map, (size_t)st.st_size);
+        X_FREE(file);
+        X_FREE(mf);
+        return NULL;
+    }
+
+    posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+
+    mf->fd   = fd;
+    mf->map  = map;
+    mf->size = (uint64_t)st.st_size;
+
+    file->h.close = file_close_mmap;
+    file->h.seek = file_seek_mmap;
+    file->h.read = file_read_mmap;
+    file->h.tell = file_tell_mmap;
+    file->read_at = file_read_at_mmap;
+    file->prefetch = file_prefetch_mmap;
+
+    file->h.internal = mf;
+
+    return &file->h;
+}
+
+/*
+ * io_uring read-ahead for large read-only files (Linux)
+ *
+ * Keeps URING_QUEUE_DEPTH reads of URING_READ_SIZE bytes in flight in front
+ * of sequential reads (stream files, disc image blocks of current clip).
+ * Non-sequential reads (metadata, seeks) are served with pread() and do not
+ * disturb the queue. The queue is restarted when sequential reading continues
+ * outside of it.
+ *
+ * Cost: each file has its own ring (one file descriptor, a few kB of mapped
+ * memory). Read buffers (URING_QUEUE_DEPTH * URING_READ_SIZE = 768 kB) are
+ * allocated when sequential reading starts, so files that are only opened
+ * (ex. parked clip handles that were never played) don't use them. A player
+ * streams one or two clips at a time.
+ *
+ * Ring head and tail indices are shared with the kernel: requires atomics.
+ *
+ * Disabled with environment variable LIBBLURAY_FILE_URING=0.
+ */
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(BD_HAVE_ATOMICS) && \
+    defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+
+#define URING_UNIT_SIZE      6144                        /* aligned unit */
+#define URING_READ_SIZE      (32 * URING_UNIT_SIZE)      /* single request */
+#define URING_QUEUE_DEPTH    4
+#define URING_MIN_FILE_SIZE  (16 * 1024 * 1024)          /* smaller files use plain read() */
+
+typedef struct {
+    uint8_t      *buf;
+    struct iovec  iov;
+    uint64_t      offset;
+    int           result;   /* bytes read or -errno */
+    int           pending;  /* submitted, not completed */
+} URING_SLOT;
+
+typedef struct {
+    int       fd;
+    uint64_t  size;
+    uint64_t  pos;        /* position of read() */
+    uint64_t  last_end;   /* end of previous read (sequential access detection) */
+    BD_MUTEX  mutex;
+
+    /* ring */
+    int       ring_fd;
+    uint8_t  *sq_ptr;
+    size_t    sq_len;
+    uint8_t  *cq_ptr;
+    size_t    cq_len;
+    struct io_uring_sqe *sqes;
+    size_t    sqes_len;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    /* queue: slots head, head+1, ... cover consecutive file areas up to next_offset */
+    URING_SLOT slot[URING_QUEUE_DEPTH];
+    unsigned   head;
+    unsigned   num_pending;
+    uint64_t   next_offset;
+    int        active;
+} URING_FILE;
+
+static int _uring_enter(URING_FILE *u, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    long result;
+
+    do {
+        result = syscall(__NR_io_uring_enter, u->ring_fd, to_submit, min_complete, flags, NULL, 0);
+    } while (result < 0 && errno == EINTR);
+
+    if (result < 0) {
+        BD_DEBUG(DBG_FILE, "io_uring_enter() failed (%d)\n", errno);
+        return -1;
+    }
+    return 0;
+}
+
+static void _uring_submit(URING_FILE *u, unsigned index, uint64_t offset)
+{
+    URING_SLOT          *s = &u->slot[index];
+    struct io_uring_sqe *sqe;
+    unsigned             tail, sq_index;
+
+    s->offset = offset;
+    s->result = 0;
+
+    if (offset >= u->size) {
+        /* beyond end of file: empty slot */
+        return;
+    }
+
+    tail     = *u->sq_tail;
+    sq_index = tail & *u->sq_mask;
+    sqe      = &u->sqes[sq_index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_READV;
+    sqe->fd        = u->fd;
+    sqe->addr      = (uint64_t)(uintptr_t)&s->iov;
+    sqe->len       = 1;
+    sqe->off       = offset;
+    sqe->user_data = index;
+
+    u->sq_array[sq_index] = sq_index;
+    bd_atomic_store((BD_ATOMIC_UINT *)u->sq_tail, tail + 1);
+
+    if (_uring_enter(u, 1, 0, 0) < 0 && bd_atomic_load((BD_ATOMIC_UINT *)u->sq_head) == tail) {
+        /* request was not consumed by kernel: undo */
+        bd_atomic_store((BD_ATOMIC_UINT *)u->sq_tail, tail);
+        s->result = -EIO;
+        return;
+    }
+
+    s->pending = 1;
+    u->num_pending++;
+}
+
+/* collect completions. Returns -1 on error. */
+static int _uring_reap(URING_FILE *u, int wait)
+{
+    unsigned head, tail;
+
+    while (1) {
+        head = *u->cq_head;
+        tail = bd_atomic_load((BD_ATOMIC_UINT *)u->cq_tail);
+
+        if (head != tail || !wait) {
+            break;
+        }
+        if (_uring_enter(u, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+            return -1;
+        }
+    }
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+        URING_SLOT *s = &u->slot[cqe->user_data % URING_QUEUE_DEPTH];
+
+        s->result  = cqe->res;
+        s->pending = 0;
+        u->num_pending--;
+    }
+    bd_atomic_store((BD_ATOMIC_UINT *)u->cq_head, head);
+
+    return 0;
+}
+
+static int _uring_wait(URING_FILE *u, URING_SLOT *s)
+{
+    while (s->pending) {
+        if (_uring_reap(u, 1) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* buffers can't be re-used or freed before all requests have completed */
+static int _uring_drain(URING_FILE *u)
+{
+    while (u->num_pending) {
+        if (_uring_reap(u, 1) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* read buffers are allocated when first needed */
+static int _uring_alloc_buffers(URING_FILE *u)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < URING_QUEUE_DEPTH; ii++) {
+        if (!u->slot[ii].buf) {
+            u->slot[ii].buf = malloc(URING_READ_SIZE);
+            if (!u->slot[ii].buf) {
+                BD_DEBUG(DBG_FILE | DBG_CRIT, "out of memory\n");
+                return -1;
+            }
+            u->slot[ii].iov.iov_base = u->slot[ii].buf;
+            u->slot[ii].iov.iov_len  = URING_READ_SIZE;
+        }
+    }
+    return 0;
+}
+
+static void _uring_start(URING_FILE *u, uint64_t offset)
+{
+    unsigned ii;
+
+    u->active = 0;
+    if (_uring_drain(u) < 0 || _uring_alloc_buffers(u) < 0) {
+        return;
+    }
+
+    u->head        = 0;
+    u->next_offset = offset;
+    for (ii = 0; ii < URING_QUEUE_DEPTH; ii++) {
+        _uring_submit(u, ii, u->next_offset);
+        u->next_offset += URING_READ_SIZE;
+    }
+    u->active = 1;
+}
+
+/* head slot has been consumed: re-use it for next area */
+static int _uring_advance(URING_FILE *u)
+{
+    URING_SLOT *s = &u->slot[u->head];
+
+    if (_uring_wait(u, s) < 0) {
+        u->active = 0;
+        return -1;
+    }
+
+    _uring_submit(u, u->head, u->next_offset);
+    u->next_offset += URING_READ_SIZE;
+    u->head = (u->head + 1) % URING_QUEUE_DEPTH;
+    return 0;
+}
+
+static int _uring_in_queue(const URING_FILE *u, uint64_t offset)
+{
+    return u->active && offset >= u->slot[u->head].offset && offset < u->next_offset;
+}
+
+static int64_t _uring_read(URING_FILE *u, uint64_t offset, uint8_t *buf, int64_t size)
+{
+    int64_t got = 0;
+
+    if (offset >= u->size) {
+        return 0;
+    }
+    size = (int64_t)BD_MIN((uint64_t)size, u->size - offset);
+
+    /* sequential read outside of queue: restart read-ahead here */
+    if (!_uring_in_queue(u, offset) && offset == u->last_end) {
+        _uring_start(u, offset);
+    }
+
+    while (got < size && _uring_in_queue(u, offset + got)) {
+        URING_SLOT *s   = &u->slot[u->head];
+        uint64_t    pos = offset + got;
+        size_t      len;
+
+        if (pos >= s->offset + URING_READ_SIZE) {
+            /* skipped */
+            if (_uring_advance(u) < 0) {
+                break;
+            }
+            continue;
+        }
+
+        if (_uring_wait(u, s) < 0 || s->result < 0) {
+            BD_DEBUG(DBG_FILE, "io_uring read at %"PRIu64" failed (%d)\n", s->offset, s->result);
+            u->active = 0;
+            break;
+        }
+        if (pos >= s->offset + (uint64_t)s->result) {
+            /* short read: restart later */
+            u->active = 0;
+            break;
+        }
+
+        len = (size_t)BD_MIN((uint64_t)(size - got), s->offset + s->result - pos);
+        memcpy(buf + got, s->buf + (pos - s->offset), len);
+        got += len;
+
+        if (pos + len >= s->offset + URING_READ_SIZE) {
+            _uring_advance(u);
+        }
+    }
+
+    /* not in queue or I/O error */
+    if (got < size) {
+        got += _pread_full(u->fd, (int64_t)(offset + got), buf + got, size - got);
+    }
+
+    u->last_end = offset + got;
+    return got;
+}
+
+static void file_close_uring(BD_FILE_H *file)
+{
+    if (file) {
+        URING_FILE *u = (URING_FILE *)file->internal;
+        unsigned    ii;
+
+        if (_uring_drain(u) < 0) {
+            /* kernel may still write to buffers of pending reads: leak them */
+            BD_DEBUG(DBG_FILE | DBG_CRIT, "io_uring: %u reads still pending, leaking buffers\n", u->num_pending);
+            for (ii = 0; ii < URING_QUEUE_DEPTH; ii++) {
+                if (u->slot[ii].pending) {
+                    u->slot[ii].buf = NULL;
+                }
+            }
+        }
+
+        munmap(u->sqes, u->sqes_len);
+        if (u->cq_ptr != u->sq_ptr) {
+            munmap(u->cq_ptr, u->cq_len);
+        }
+        munmap(u->sq_ptr, u->sq_len);
+        close(u->ring_fd);
+        close(u->fd);
+
+        for (ii = 0; ii < URING_QUEUE_DEPTH; ii++) {
+            X_FREE(u->slot[ii].buf);
+        }
+        bd_mutex_destroy(&u->mutex);
+
+        BD_DEBUG(DBG_FILE, "Closed io_uring file (%p)\n", (void*)file);
+
+        X_FREE(u);
+        X_FREE(file);
+    }
+}
+
+static int64_t file_seek_uring(BD_FILE_H *file, int64_t offset, int32_t origin)
+{
+    URING_FILE *u = (URING_FILE *)file->internal;
+    int64_t     pos;
+
+    switch (origin) {
+        case SEEK_SET: pos = offset;                      break;
+        case SEEK_CUR: pos = (int64_t)u->pos + offset;    break;
+        case SEEK_END: pos = (int64_t)u->size + offset;   break;
+        default:       pos = -1;                          break;
+    }
+
+    if (pos < 0) {
+        BD_DEBUG(DBG_FILE, "seek failed (%p)\n", (void*)file);
+        return -1;
+    }
+
+    u->pos = (uint64_t)pos;
+    return pos;
+}
+
+static int64_t file_tell_uring(BD_FILE_H *file)
+{
+    URING_FILE *u = (URING_FILE *)file->internal;
+    return (int64_t)u->pos;
+}
+
+static int64_t file_read_uring(BD_FILE_H *file, uint8_t *buf, int64_t size)
+{
+    URING_FILE *u = (URING_FILE *)file->internal;
+    int64_t     got;
+
+    if (size <= 0 || size >= BD_MAX_SSIZE) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid read of size %"PRId64" (%p)\n", size, (void*)file);
+        return 0;
+    }
+
+    bd_mutex_lock(&u->mutex);
+    got = _uring_read(u, u->pos, buf, size);
+    u->pos += got;
+    bd_mutex_unlock(&u->mutex);
+
+    return got;
+}
+
+static int64_t file_read_at_uring(BD_FILE_H *file, int64_t offset, uint8_t *buf, int64_t size)
+{
+    URING_FILE *u = (URING_FILE *)file->internal;
+    int64_t     got;
+
+    if (size <= 0 || size >= BD_MAX_SSIZE || offset < 0) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid read of size %"PRId64" at %"PRId64" (%p)\n", size, offset, (void*)file);
+        return 0;
+    }
+
+    bd_mutex_lock(&u->mutex);
+    got = _uring_read(u, (uint64_t)offset, buf, size);
+    bd_mutex_unlock(&u->mutex);
+
+    return got;
+}
+
+static void file_prefetch_uring(BD_FILE_H *file, int64_t offset, int64_t size)
+{
+    URING_FILE *u = (URING_FILE *)file->internal;
+
+#if defined(POSIX_FADV_WILLNEED)
+    if (posix_fadvise(u->fd, (off_t)offset, (off_t)size, POSIX_FADV_WILLNEED)) {
+        BD_DEBUG(DBG_FILE, "posix_fadvise() failed (%p)\n", (void*)file);
+    }
+#else
+    (void)u;
+    (void)offset;
+    (void)size;
+#endif
+}
+
+static int _uring_setup(URING_FILE *u)
+{
+    struct io_uring_params p;
+    long fd;
+
+    memset(&p, 0, sizeof(p));
+    fd = syscall(__NR_io_uring_setup, URING_QUEUE_DEPTH, &p);
+    if (fd < 0) {
+        BD_DEBUG(DBG_FILE, "io_uring_setup() failed (%d)\n", errno);
+        return -1;
+    }
+    u->ring_fd = (int)fd;
+
+    u->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        u->sq_len = u->cq_len = BD_MAX(u->sq_len, u->cq_len);
+    }
+
+    u->sq_ptr = mmap(NULL, u->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     u->ring_fd, IORING_OFF_SQ_RING);
+    if (u->sq_ptr == MAP_FAILED) {
+        goto fail_sq;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        u->cq_ptr = u->sq_ptr;
+    } else {
+        u->cq_ptr = mmap(NULL, u->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         u->ring_fd, IORING_OFF_CQ_RING);
+        if (u->cq_ptr == MAP_FAILED) {
+            goto fail_cq;
+        }
+    }
+    u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   u->ring_fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) {
+        goto fail_sqes;
+    }
+
+    u->sq_head  = (unsigned *)(u->sq_ptr + p.sq_off.head);
+    u->sq_tail  = (unsigned *)(u->sq_ptr + p.sq_off.tail);
+    u->sq_mask  = (unsigned *)(u->sq_ptr + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(u->sq_ptr + p.sq_off.array);
+    u->cq_head  = (unsigned *)(u->cq_ptr + p.cq_off.head);
+    u->cq_tail  = (unsigned *)(u->cq_ptr + p.cq_off.tail);
+    u->cq_mask  = (unsigned *)(u->cq_ptr + p.cq_off.ring_mask);
+    u->cqes     = (struct io_uring_cqe *)(u->cq_ptr + p.cq_off.cqes);
+
+    return 0;
+
+ fail_sqes:
+    if (u->cq_ptr != u->sq_ptr) {
+        munmap(u->cq_ptr, u->cq_len);
+    }
+ fail_cq:
+    munmap(u->sq_ptr, u->sq_len);
+ fail_sq:
+    BD_DEBUG(DBG_FILE, "io_uring mmap() failed\n");
+    close(u->ring_fd);
+    return -1;
+}
+
+static int _use_uring(void)
+{
+    static int use_uring = -1;
+
+    if (use_uring < 0) {
+        const char *env = getenv("LIBBLURAY_FILE_URING");
+        use_uring = !env || atoi(env) > 0;
+    }
+
+    return use_uring;
+}
+
+static BD_FILE_H *_file_open_uring(int fd)
+{
+    BD_FILE_EXT_H *file;
+    URING_FILE    *u;
+    struct stat    st;
+
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size < URING_MIN_FILE_SIZE) {
+        return NULL;
+    }
+
+    u = calloc(1, sizeof(URING_FILE));
+    if (!u) {
+        return NULL;
+    }
+    if (_uring_setup(u) < 0) {
+        X_FREE(u);
+        return NULL;
+    }
+
+    file = file_ext_alloc();
+    if (!file) {
+        munmap(u->sqes, u->sqes_len);
+        if (u->cq_ptr != u->sq_ptr) {
+            munmap(u->cq_ptr, u->cq_len);
+        }
+        munmap(u->sq_ptr, u->sq_len);
+        close(u->ring_fd);
+        X_FREE(u);
+        return NULL;
+    }
+
+    u->fd       = fd;
+    u->size     = (uint64_t)st.st_size;
+    u->last_end = (uint64_t)-1;
+    bd_mutex_init(&u->mutex);
+
+    file->h.close = file_close_uring;
+    file->h.seek = file_seek_uring;
+    file->h.read = file_read_uring;
+    file->h.tell = file_tell_uring;
+    file->read_at = file_read_at_uring;
+    file->prefetch = file_prefetch_uring;
+
+    file->h.internal = u;
+
+    return &file->h;
+}
+
+#define USING_IO_URING 1
+#endif /* HAVE_LINUX_IO_URING_H */
+
+static BD_FILE_H *_file_open_fd(int fd)
+{
+    BD_FILE_EXT_H *ext;
+    BD_FILE_H *file;
+
+    ext = file_ext_alloc();
+    if (!ext) {
+        return NULL;
+    }
+
+    ext->read_at = file_read_at_linux;
+    ext->prefetch = file_prefetch_linux;
+
+    file = &ext->h;
+    file->close = file_close_linux;
+    file->seek = file_seek_linux;
+    file->read = file_read_linux;
+    file->write = file_write_linux;
+    file->tell = file_tell_linux;
+    //file->eof = file_eof_linux;
+
+    file->internal = (void*)(intptr_t)fd;
+
+    return file;
+}
+
 static BD_FILE_H *file_open_linux(const char* filename, const char *cmode)
 {
     BD_FILE_H *file;
@@ -143,26 +957,86 @@ static BD_FILE_H *file_open_linux(const char* filename, const char *cmode)
         return NULL;
     }
 
-    file = calloc(1, sizeof(BD_FILE_H));
+    if (!strchr(cmode, 'w') && _use_mmap()) {
+        file = _file_open_mmap(fd);
+        if (file) {
+            BD_DEBUG(DBG_FILE, "Opened mmap file %s (%p)\n", filename, (void*)file);
+            return file;
+        }
+    }
+
+#ifdef USING_IO_URING
+    if (!strchr(cmode, 'w') && _use_uring()) {
+        file = _file_open_uring(fd);
+        if (file) {
+            BD_DEBUG(DBG_FILE, "Opened io_uring file %s (%p)\n", filename, (void*)file);
+            return file;
+        }
+    }
+#endif
+
+    file = _file_open_fd(fd);
     if (!file) {
         close(fd);
         BD_DEBUG(DBG_FILE, "Error opening file %s (out of memory)\n", filename);
         return NULL;
     }
 
-    file->close = file_close_linux;
-    file->seek = file_seek_linux;
-    file->read = file_read_linux;
-    file->write = file_write_linux;
-    file->tell = file_tell_linux;
-    //file->eof = file_eof_linux;
+    BD_DEBUG(DBG_FILE, "Opened LINUX file %s (%p)\n", filename, (void*)file);
+    return file;
+}
 
-    file->internal = (void*)(intptr_t)fd;
+BD_FILE_H *file_open_unbuffered(const char *filename, unsigned *align)
+{
+    BD_FILE_H *file;
+    int fd    = -1;
+    int flags = O_RDONLY;
 
-    BD_DEBUG(DBG_FILE, "Opened LINUX file %s (%p)\n", filename, (void*)file);
+#ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#endif
+#ifdef O_BINARY
+    flags |= O_BINARY;
+#endif
+
+#if defined(O_DIRECT)
+    /* Linux, FreeBSD: offset, size and buffer must be aligned to logical block size.
+     * 4096 covers all common devices. */
+    if ((fd = open(filename, flags | O_DIRECT)) < 0) {
+        BD_DEBUG(DBG_FILE, "Error opening file %s for direct I/O (%d)\n", filename, errno);
+        return NULL;
+    }
+    *align = 4096;
+#elif defined(F_NOCACHE)
+    /* macOS: no alignment requirements, aligned requests bypass the cache */
+    if ((fd = open(filename, flags)) < 0) {
+        BD_DEBUG(DBG_FILE, "Error opening file %s\n", filename);
+        return NULL;
+    }
+    if (fcntl(fd, F_NOCACHE, 1) < 0) {
+        BD_DEBUG(DBG_FILE, "fcntl(F_NOCACHE) failed for %s (%d)\n", filename, errno);
+        close(fd);
+        return NULL;
+    }
+    *align = 4096;
+#else
+    (void)flags;
+    (void)align;
+    BD_DEBUG(DBG_FILE, "Direct I/O not supported\n");
+    return NULL;
+#endif
+
+    file = _file_open_fd(fd);
+    if (!file) {
+        close(fd);
+        return NULL;
+    }
+
+    BD_DEBUG(DBG_FILE, "Opened LINUX file %s for direct I/O (%p)\n", filename, (void*)file);
     return file;
 }
 
+
 BD_FILE_H* (*file_open)(const char* filename, const char *mode) = file_open_linux;
 
 BD_FILE_OPEN file_open_default(void)
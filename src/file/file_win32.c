@@ -33,6 +33,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 
 #include <windows.h>
@@ -93,11 +94,306 @@ static int64_t _file_write(BD_FILE_H *file, const uint8_t *buf, int64_t size)
     return 0;
 }
 
+/*
+ * read-only file (overlapped I/O with read-ahead)
+ */
+
+#define RA_SLOTS      4              /* outstanding read-ahead requests */
+#define RA_SLOT_SIZE  (256 * 1024)
+
+typedef struct {
+    OVERLAPPED ov;
+    uint8_t   *buf;
+    int64_t    offset;
+    DWORD      size;      /* requested */
+    DWORD      got;
+    DWORD      used;      /* bytes consumed by read() */
+    int        pending;   /* request in flight */
+} RA_SLOT;
+
+typedef struct {
+    HANDLE   h;
+    int64_t  size;        /* file size at open */
+    int64_t  pos;         /* read() position */
+
+    /* sequential read-ahead (read() only) */
+    RA_SLOT  slot[RA_SLOTS];
+    unsigned head;        /* slot holding data at pos */
+    unsigned count;       /* slots in use */
+    int64_t  ra_next;     /* offset of next request */
+    DWORD    slot_size;
+} WIN32_FILE;
+
+static int _ra_wait(WIN32_FILE *f, RA_SLOT *s)
+{
+    if (s->pending) {
+        s->pending = 0;
+        if (!GetOverlappedResult(f->h, &s->ov, &s->got, TRUE)) {
+            s->got = 0;
+            if (GetLastError() != ERROR_HANDLE_EOF) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void _ra_reset(WIN32_FILE *f)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < RA_SLOTS; ii++) {
+        RA_SLOT *s = &f->slot[ii];
+        if (s->pending) {
+            CancelIoEx(f->h, &s->ov);
+            _ra_wait(f, s);
+        }
+    }
+
+    f->head    = 0;
+    f->count   = 0;
+    f->ra_next = f->pos;
+}
+
+static void _ra_fill(WIN32_FILE *f)
+{
+    while (f->count < RA_SLOTS && f->ra_next < f->size) {
+        RA_SLOT *s = &f->slot[(f->head + f->count) % RA_SLOTS];
+
+        if (!s->buf) {
+            s->buf = malloc(f->slot_size);
+        }
+        if (!s->ov.hEvent) {
+            s->ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        }
+        if (!s->buf || !s->ov.hEvent) {
+            break;
+        }
+
+        s->offset        = f->ra_next;
+        s->size          = (DWORD)BD_MIN((int64_t)f->slot_size, f->size - f->ra_next);
+        s->got           = 0;
+        s->used          = 0;
+        s->ov.Offset     = (DWORD)s->offset;
+        s->ov.OffsetHigh = (DWORD)(s->offset >> 32);
+        ResetEvent(s->ov.hEvent);
+
+        if (ReadFile(f->h, s->buf, s->size, &s->got, &s->ov)) {
+            s->pending = 0;
+        } else if (GetLastError() == ERROR_IO_PENDING) {
+            s->pending = 1;
+        } else {
+            BD_DEBUG(DBG_FILE, "ReadFile() failed (%lu)\n", (unsigned long)GetLastError());
+            break;
+        }
+
+        f->ra_next += s->size;
+        f->count++;
+    }
+}
+
+static void _file_close_read(BD_FILE_H *file)
+{
+    if (file) {
+        WIN32_FILE *f = (WIN32_FILE *)file->internal;
+        unsigned    ii;
+
+        _ra_reset(f);
+        for (ii = 0; ii < RA_SLOTS; ii++) {
+            if (f->slot[ii].ov.hEvent) {
+                CloseHandle(f->slot[ii].ov.hEvent);
+            }
+            X_FREE(f->slot[ii].buf);
+        }
+        CloseHandle(f->h);
+        X_FREE(f);
+
+        BD_DEBUG(DBG_FILE, "Closed WIN32 file (%p)\n", (void*)file);
+
+        X_FREE(file);
+    }
+}
+
+static int64_t _file_seek_read(BD_FILE_H *file, int64_t offset, int32_t origin)
+{
+    WIN32_FILE *f = (WIN32_FILE *)file->internal;
+
+    switch (origin) {
+        case SEEK_CUR: offset += f->pos;  break;
+        case SEEK_END: offset += f->size; break;
+        case SEEK_SET: break;
+        default: return -1;
+    }
+
+    if (offset < 0) {
+        return -1;
+    }
+    f->pos = offset;
+    return offset;
+}
+
+static int64_t _file_tell_read(BD_FILE_H *file)
+{
+    WIN32_FILE *f = (WIN32_FILE *)file->internal;
+    return f->pos;
+}
+
+static int64_t _file_read_at(BD_FILE_H *file, int64_t offset, uint8_t *buf, int64_t size)
+{
+    WIN32_FILE *f = (WIN32_FILE *)file->internal;
+    OVERLAPPED  ov;
+    DWORD       got = 0;
+    int64_t     done = 0;
+
+    if (size <= 0 || size >= BD_MAX_SSIZE || offset < 0) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid read of size %"PRId64" at %"PRId64" (%p)\n", size, offset, (void*)file);
+        return 0;
+    }
+
+    /* private event: safe to call from multiple threads */
+    memset(&ov, 0, sizeof(ov));
+    ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!ov.hEvent) {
+        return -1;
+    }
+
+    while (done < size) {
+        DWORD req = (DWORD)BD_MIN(size - done, 0x40000000);
+
+        ov.Offset     = (DWORD)(offset + done);
+        ov.OffsetHigh = (DWORD)((offset + done) >> 32);
+        ResetEvent(ov.hEvent);
+
+        if (!ReadFile(f->h, buf + done, req, &got, &ov) &&
+            (GetLastError() != ERROR_IO_PENDING || !GetOverlappedResult(f->h, &ov, &got, TRUE))) {
+            if (GetLastError() != ERROR_HANDLE_EOF) {
+                BD_DEBUG(DBG_FILE, "ReadFile() failed (%lu) (%p)\n", (unsigned long)GetLastError(), (void*)file);
+            }
+            break;
+        }
+        if (!got) {
+            /* EOF */
+            break;
+        }
+        done += got;
+    }
+
+    CloseHandle(ov.hEvent);
+    return done;
+}
+
+static int64_t _file_read_seq(BD_FILE_H *file, uint8_t *buf, int64_t size)
+{
+    WIN32_FILE *f = (WIN32_FILE *)file->internal;
+    int64_t     done = 0;
+
+    if (size <= 0 || size >= BD_MAX_SSIZE) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid read of size %"PRId64" (%p)\n", size, (void*)file);
+        return 0;
+    }
+
+    /* restart read-ahead after seek */
+    if (f->count && f->slot[f->head].offset + (int64_t)f->slot[f->head].used != f->pos) {
+        _ra_reset(f);
+    }
+    if (!f->count) {
+        f->ra_next = f->pos;
+    }
+
+    while (done < size) {
+        RA_SLOT *s;
+        DWORD    n;
+
+        _ra_fill(f);
+        if (!f->count) {
+            break;
+        }
+
+        s = &f->slot[f->head];
+        if (_ra_wait(f, s) < 0) {
+            BD_DEBUG(DBG_FILE, "ReadFile() failed (%lu) (%p)\n", (unsigned long)GetLastError(), (void*)file);
+            _ra_reset(f);
+            return done > 0 ? done : -1;
+        }
+
+        n = (DWORD)BD_MIN((int64_t)(s->got - s->used), size - done);
+        memcpy(buf + done, s->buf + s->used, n);
+        s->used += n;
+        done    += n;
+        f->pos  += n;
+
+        if (s->used >= s->got) {
+            int short_read = s->got < s->size;
+            f->head = (f->head + 1) % RA_SLOTS;
+            f->count--;
+            if (short_read) {
+                /* file truncated ? */
+                _ra_reset(f);
+                break;
+            }
+        }
+    }
+
+    return done;
+}
+
+static BD_FILE_H *_file_open_read(const wchar_t *wfilename)
+{
+    BD_FILE_EXT_H *ext;
+    WIN32_FILE    *f;
+    LARGE_INTEGER  size;
+    HANDLE         h;
+
+    h = CreateFileW(wfilename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+                    FILE_FLAG_SEQUENTIAL_SCAN | FILE_FLAG_OVERLAPPED, NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    if (!GetFileSizeEx(h, &size)) {
+        CloseHandle(h);
+        return NULL;
+    }
+
+    f   = calloc(1, sizeof(*f));
+    ext = file_ext_alloc();
+    if (!f || !ext) {
+        CloseHandle(h);
+        X_FREE(f);
+        X_FREE(ext);
+        return NULL;
+    }
+
+    f->h         = h;
+    f->size      = size.QuadPart;
+    f->slot_size = (DWORD)BD_MIN(RA_SLOT_SIZE, BD_MAX(f->size, 1));
+
+    ext->read_at    = _file_read_at;
+    ext->h.internal = f;
+    ext->h.close    = _file_close_read;
+    ext->h.seek     = _file_seek_read;
+    ext->h.read     = _file_read_seq;
+    ext->h.tell     = _file_tell_read;
+
+    return &ext->h;
+}
+
 static BD_FILE_H *_file_open(const char* filename, const char *mode)
 {
     FILE *fp = NULL;
 
     wchar_t wfilename[MAX_PATH], wmode[8];
+    if (!strchr(mode, 'w') &&
+        MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, filename, -1, wfilename, MAX_PATH)) {
+
+        BD_FILE_H *file = _file_open_read(wfilename);
+        if (file) {
+            BD_DEBUG(DBG_FILE, "Opened WIN32 file %s (%p)\n", filename, (void*)file);
+            return file;
+        }
+        BD_DEBUG(DBG_FILE, "Error opening file %s\n", filename);
+        return NULL;
+    }
+
     if (MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, filename, -1, wfilename, MAX_PATH) &&
         MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, mode, -1, wmode, 8) &&
         (fp = _wfopen(wfilename, wmode))) {
@@ -119,6 +415,110 @@ static BD_FILE_H *_file_open(const char* filename, const char *mode)
     return NULL;
 }
 
+/*
+ * unbuffered file (FILE_FLAG_NO_BUFFERING)
+ */
+
+static void _unbuf_close(BD_FILE_H *file)
+{
+    if (file) {
+        CloseHandle((HANDLE)file->internal);
+
+        BD_DEBUG(DBG_FILE, "Closed WIN32 unbuffered file (%p)\n", (void*)file);
+
+        X_FREE(file);
+    }
+}
+
+static int64_t _unbuf_seek(BD_FILE_H *file, int64_t offset, int32_t origin)
+{
+    LARGE_INTEGER dist, pos;
+    DWORD method = origin == SEEK_END ? FILE_END : origin == SEEK_CUR ? FILE_CURRENT : FILE_BEGIN;
+
+    dist.QuadPart = offset;
+    if (!SetFilePointerEx((HANDLE)file->internal, dist, &pos, method)) {
+        return -1;
+    }
+    return pos.QuadPart;
+}
+
+static int64_t _unbuf_tell(BD_FILE_H *file)
+{
+    return _unbuf_seek(file, 0, SEEK_CUR);
+}
+
+static int64_t _unbuf_read_at(BD_FILE_H *file, int64_t offset, uint8_t *buf, int64_t size)
+{
+    OVERLAPPED ov;
+    DWORD      got = 0;
+
+    if (size <= 0 || size > 0x7fffffff) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "Ignoring invalid read of size %"PRId64" (%p)\n", size, (void*)file);
+        return 0;
+    }
+
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset     = (DWORD)offset;
+    ov.OffsetHigh = (DWORD)(offset >> 32);
+
+    if (!ReadFile((HANDLE)file->internal, buf, (DWORD)size, &got, &ov)) {
+        if (GetLastError() == ERROR_HANDLE_EOF) {
+            return 0;
+        }
+        BD_DEBUG(DBG_FILE, "ReadFile() failed (%lu) (%p)\n", (unsigned long)GetLastError(), (void*)file);
+        return -1;
+    }
+
+    return got;
+}
+
+static int64_t _unbuf_read(BD_FILE_H *file, uint8_t *buf, int64_t size)
+{
+    int64_t pos = _unbuf_tell(file);
+    int64_t got = pos < 0 ? -1 : _unbuf_read_at(file, pos, buf, size);
+    if (got > 0) {
+        _unbuf_seek(file, pos + got, SEEK_SET);
+    }
+    return got;
+}
+
+BD_FILE_H *file_open_unbuffered(const char *filename, unsigned *align)
+{
+    BD_FILE_EXT_H *ext;
+    HANDLE h;
+
+    wchar_t wfilename[MAX_PATH];
+    if (!MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, filename, -1, wfilename, MAX_PATH)) {
+        return NULL;
+    }
+
+    h = CreateFileW(wfilename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                    FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+        BD_DEBUG(DBG_FILE, "Error opening file %s for direct I/O (%lu)\n", filename, (unsigned long)GetLastError());
+        return NULL;
+    }
+
+    ext = file_ext_alloc();
+    if (!ext) {
+        CloseHandle(h);
+        return NULL;
+    }
+
+    ext->read_at    = _unbuf_read_at;
+    ext->h.internal = h;
+    ext->h.close    = _unbuf_close;
+    ext->h.seek     = _unbuf_seek;
+    ext->h.read     = _unbuf_read;
+    ext->h.tell     = _unbuf_tell;
+
+    /* sector size of all common devices (4K native / 512e) */
+    *align = 4096;
+
+    BD_DEBUG(DBG_FILE, "Opened WIN32 file %s for direct I/O (%p)\n", filename, (void*)&ext->h);
+    return &ext->h;
+}
+
 BD_FILE_H* (*file_open)(const char* filename, const char *mode) = _file_open;
 
 BD_FILE_OPEN file_open_default(void)
@@ -0,0 +1,347 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "io_trace.h"
+
+#include "file.h"
+#include "util/logging.h"
+#include "util/macro.h"
+#include "util/mutex.h"
+#include "util/time.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_BUF_SIZE  (64 * 1024)   /* flush trace file when this much is buffered */
+#define TRACE_LINE_MAX  1024
+
+typedef struct {
+    BD_MUTEX    mutex;
+    BD_FILE_H  *out;
+    BD_FILE_OPEN prev_open;  /* traced file_open() */
+    uint64_t    t0;
+    unsigned    next_id;
+    unsigned    refs;        /* active trace + open traced files / block inputs */
+
+    size_t      len;
+    char        buf[TRACE_BUF_SIZE];
+} IO_TRACE;
+
+typedef struct {
+    IO_TRACE  *trace;
+    BD_FILE_H *fp;
+    unsigned   id;
+    int64_t    pos;
+} TRACE_FILE;
+
+static IO_TRACE *trace = NULL;
+
+/*
+ * trace output
+ */
+
+/* mutex must be locked */
+static void _flush(IO_TRACE *t)
+{
+    if (t->len && t->out) {
+        if (t->out->write(t->out, (const uint8_t *)t->buf, (int64_t)t->len) != (int64_t)t->len) {
+            BD_DEBUG(DBG_FILE | DBG_CRIT, "I/O trace: write failed\n");
+        }
+    }
+    t->len = 0;
+}
+
+static void _record(IO_TRACE *t, uint64_t start, const char *fmt, ...) BD_ATTR_FORMAT_PRINTF(3,4);
+static void _record(IO_TRACE *t, uint64_t start, const char *fmt, ...)
+{
+    char     line[TRACE_LINE_MAX];
+    uint64_t now = bd_get_time_us();
+    int      len, n;
+    va_list  ap;
+
+    len = snprintf(line, sizeof(line), "%"PRIu64" %"PRIu64" ", start - t->t0, now - start);
+
+    va_start(ap, fmt);
+    n = vsnprintf(line + len, sizeof(line) - len - 1, fmt, ap);
+    va_end(ap);
+
+    if (n < 0) {
+        return;
+    }
+    len = BD_MIN(len + n, (int)sizeof(line) - 2);
+    line[len++] = '\n';
+
+    bd_mutex_lock(&t->mutex);
+    if (t->len + len > sizeof(t->buf)) {
+        _flush(t);
+    }
+    memcpy(t->buf + t->len, line, len);
+    t->len += len;
+    bd_mutex_unlock(&t->mutex);
+}
+
+static void _trace_unref(IO_TRACE *t)
+{
+    unsigned refs;
+
+    bd_mutex_lock(&t->mutex);
+    refs = --t->refs;
+    bd_mutex_unlock(&t->mutex);
+
+    if (!refs) {
+        _flush(t);
+        file_close(t->out);
+        bd_mutex_destroy(&t->mutex);
+        X_FREE(t);
+    }
+}
+
+/*
+ * traced file
+ */
+
+static void _tf_close(BD_FILE_H *file)
+{
+    TRACE_FILE *tf = (TRACE_FILE *)file->internal;
+    uint64_t    t  = bd_get_time_us();
+
+    file_close(tf->fp);
+    _record(tf->trace, t, "C %u", tf->id);
+
+    _trace_unref(tf->trace);
+    X_FREE(tf);
+    X_FREE(file);
+}
+
+static int64_t _tf_seek(BD_FILE_H *file, int64_t offset, int32_t origin)
+{
+    TRACE_FILE *tf = (TRACE_FILE *)file->internal;
+    uint64_t    t  = bd_get_time_us();
+    int64_t     result;
+
+    result = file_seek(tf->fp, offset, origin);
+    if (result >= 0) {
+        tf->pos = file_tell(tf->fp);
+    }
+
+    _record(tf->trace, t, "S %u %"PRId64" %d %"PRId64, tf->id, offset, (int)origin, result < 0 ? result : tf->pos);
+    return result;
+}
+
+static int64_t _tf_tell(BD_FILE_H *file)
+{
+    TRACE_FILE *tf = (TRACE_FILE *)file->internal;
+    return file_tell(tf->fp);
+}
+
+static int64_t _tf_read(BD_FILE_H *file, uint8_t *buf, int64_t size)
+{
+    TRACE_FILE *tf = (TRACE_FILE *)file->internal;
+    uint64_t    t  = bd_get_time_us();
+    int64_t     pos = tf->pos;
+    int64_t     got;
+
+    got = tf->fp->read(tf->fp, buf, size);
+    if (got > 0) {
+        tf->pos += got;
+    }
+
+    _record(tf->trace, t, "R %u %"PRId64" %"PRId64" %"PRId64, tf->id, pos, size, got);
+    return got;
+}
+
+static int64_t _tf_write(BD_FILE_H *file, const uint8_t *buf, int64_t size)
+{
+    TRACE_FILE *tf = (TRACE_FILE *)file->internal;
+    uint64_t    t  = bd_get_time_us();
+    int64_t     pos = tf->pos;
+    int64_t     got;
+
+    got = tf->fp->write(tf->fp, buf, size);
+    if (got > 0) {
+        tf->pos += got;
+    }
+
+    _record(tf->trace, t, "W %u %"PRId64" %"PRId64" %"PRId64, tf->id, pos, size, got);
+    return got;
+}
+
+static int64_t _tf_read_at(BD_FILE_H *file, int64_t offset, uint8_t *buf, int64_t size)
+{
+    TRACE_FILE *tf = (TRACE_FILE *)file->internal;
+    uint64_t    t  = bd_get_time_us();
+    int64_t     got;
+
+    got = file_read_at(tf->fp, offset, buf, size);
+
+    _record(tf->trace, t, "A %u %"PRId64" %"PRId64" %"PRId64, tf->id, offset, size, got);
+    return got;
+}
+
+static void _tf_prefetch(BD_FILE_H *file, int64_t offset, int64_t size)
+{
+    TRACE_FILE *tf = (TRACE_FILE *)file->internal;
+    uint64_t    t  = bd_get_time_us();
+
+    file_prefetch(tf->fp, offset, size);
+
+    _record(tf->trace, t, "P %u %"PRId64" %"PRId64, tf->id, offset, size);
+}
+
+static BD_FILE_H *_trace_open(const char *filename, const char *mode)
+{
+    IO_TRACE      *t = trace;
+    BD_FILE_EXT_H *ext;
+    TRACE_FILE    *tf;
+    BD_FILE_H     *fp;
+    uint64_t       start = bd_get_time_us();
+
+    fp = t->prev_open(filename, mode);
+    if (!fp) {
+        _record(t, start, "O 0 -1 %s %s", mode, filename);
+        return NULL;
+    }
+
+    tf  = calloc(1, sizeof(*tf));
+    ext = file_ext_alloc();
+    if (!tf || !ext) {
+        X_FREE(tf);
+        X_FREE(ext);
+        /* keep working without tracing this file */
+        return fp;
+    }
+
+    bd_mutex_lock(&t->mutex);
+    tf->id = ++t->next_id;
+    t->refs++;
+    bd_mutex_unlock(&t->mutex);
+
+    tf->trace = t;
+    tf->fp    = fp;
+
+    ext->h.internal = tf;
+    ext->h.close    = _tf_close;
+    ext->h.seek     = _tf_seek;
+    ext->h.tell     = _tf_tell;
+    ext->h.read     = _tf_read;
+    ext->h.write    = fp->write ? _tf_write : NULL;
+    ext->read_at    = _tf_read_at;
+    ext->prefetch   = _tf_prefetch;
+
+    _record(t, start, "O %u %"PRId64" %s %s", tf->id, strchr(mode, 'w') ? 0 : file_size(fp), mode, filename);
+
+    return &ext->h;
+}
+
+/*
+ *
+ */
+
+int io_trace_start(const char *trace_file)
+{
+    IO_TRACE *t;
+    char      hdr[64];
+    int       len;
+
+    if (trace) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "I/O trace already active\n");
+        return -1;
+    }
+
+    t = calloc(1, sizeof(*t));
+    if (!t) {
+        return -1;
+    }
+
+    t->out = file_open_default()(trace_file, "wb");
+    if (!t->out) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "I/O trace: error creating %s\n", trace_file);
+        X_FREE(t);
+        return -1;
+    }
+
+    bd_mutex_init(&t->mutex);
+    t->refs      = 1;
+    t->t0        = bd_get_time_us();
+    t->prev_open = file_open;
+
+    len = snprintf(hdr, sizeof(hdr), "%s\n", IO_TRACE_SIGNATURE);
+    memcpy(t->buf, hdr, len);
+    t->len = len;
+
+    trace     = t;
+    file_open = _trace_open;
+
+    BD_DEBUG(DBG_FILE, "I/O trace started (%s)\n", trace_file);
+    return 0;
+}
+
+void io_trace_stop(void)
+{
+    IO_TRACE *t = trace;
+
+    if (!t) {
+        return;
+    }
+
+    if (file_open == _trace_open) {
+        file_open = t->prev_open;
+    }
+    trace = NULL;
+
+    bd_mutex_lock(&t->mutex);
+    _flush(t);
+    bd_mutex_unlock(&t->mutex);
+
+    /* freed when last traced file / block input is closed */
+    _trace_unref(t);
+
+    BD_DEBUG(DBG_FILE, "I/O trace stopped\n");
+}
+
+void *io_trace_ref(void)
+{
+    IO_TRACE *t = trace;
+
+    if (t) {
+        bd_mutex_lock(&t->mutex);
+        t->refs++;
+        bd_mutex_unlock(&t->mutex);
+    }
+    return t;
+}
+
+void io_trace_unref(void *t)
+{
+    if (t) {
+        _trace_unref((IO_TRACE *)t);
+    }
+}
+
+void io_trace_block(void *t, uint64_t start_us, uint32_t lba, uint32_t num_blocks, int result)
+{
+    _record((IO_TRACE *)t, start_us, "B %u %u %d", lba, num_blocks, result);
+}
@@ -0,0 +1,65 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BD_IO_TRACE_H_
+#define BD_IO_TRACE_H_
+
+#include "util/attributes.h"
+
+#include <stdint.h>
+
+/*
+ * I/O trace
+ *
+ * While active, all files opened with file_open() are wrapped and every
+ * open, seek, read, prefetch and close is written to trace file.
+ * UDF image block reads are recorded separately.
+ *
+ * Trace is a text file, one operation per line:
+ *
+ *   <start us> <duration us> <op> <arguments>
+ *
+ *   O <id> <size> <mode> <path>        open (id 0 if open failed)
+ *   R <id> <offset> <size> <result>    read (offset = file position)
+ *   A <id> <offset> <size> <result>    positional read (read_at)
+ *   W <id> <offset> <size> <result>    write
+ *   S <id> <offset> <origin> <result>  seek (result = new position)
+ *   P <id> <offset> <size>             prefetch hint
+ *   C <id>                             close
+ *   B <lba> <blocks> <result>          UDF block input read (2048-byte blocks)
+ *
+ * Start time is relative to io_trace_start(). Lines are written when
+ * operation completes; operations from different threads may overlap.
+ *
+ * Start / stop is not thread-safe: use only when no discs are open.
+ */
+
+#define IO_TRACE_SIGNATURE "# libbluray I/O trace v1"
+
+BD_PRIVATE int  io_trace_start(const char *trace_file);   /* 0 on success */
+BD_PRIVATE void io_trace_stop(void);
+
+/* reference to active trace (NULL if not tracing). Trace stays valid until released. */
+BD_PRIVATE void *io_trace_ref(void);
+BD_PRIVATE void  io_trace_unref(void *trace);
+
+/* record UDF block input read. start_us from bd_get_time_us(). */
+BD_PRIVATE void io_trace_block(void *trace, uint64_t start_us, uint32_t lba, uint32_t num_blocks, int result);
+
+#endif /* BD_IO_TRACE_H_ */
@@ -0,0 +1,288 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "async_read.h"
+
+#include "util/logging.h"
+#include "util/macro.h"
+#include "util/mutex.h"
+#include "util/thread.h"
+
+#include <stdlib.h>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_NOTIFY_FD 1
+#endif
+
+typedef struct async_req_s ASYNC_REQ;
+struct async_req_s {
+    ASYNC_REQ    *next;
+    uint8_t      *buf;
+    int           len;
+    int           result;
+    async_done_f  done;
+    void         *ctx;
+};
+
+struct bd_async_reader_s {
+    async_read_f  read;
+    void         *handle;
+
+    BD_MUTEX      mutex;
+    BD_COND       cond;
+    BD_THREAD     thread;
+    int           running;
+    int           exit;
+
+    /* FIFO of queued requests */
+    ASYNC_REQ    *pending;
+    ASYNC_REQ   **pending_tail;
+
+    /* FIFO of completed requests (only with notify fd) */
+    ASYNC_REQ    *done;
+    ASYNC_REQ   **done_tail;
+
+    int           notify[2];  /* pipe: [0] is polled by application */
+};
+
+static void _complete(BD_ASYNC_READER *p, ASYNC_REQ *req)
+{
+#ifdef HAVE_NOTIFY_FD
+    if (p->notify[1] >= 0) {
+        const uint8_t b = 0;
+
+        bd_mutex_lock(&p->mutex);
+        *p->done_tail = req;
+        p->done_tail  = &req->next;
+        bd_mutex_unlock(&p->mutex);
+
+        /* pipe may be full if application does not dispatch. It is readable anyway. */
+        if (write(p->notify[1], &b, 1) < 0) {
+            /* EAGAIN: notification already pending */
+        }
+        return;
+    }
+#endif
+
+    req->done(req->ctx, req->buf, req->result);
+    X_FREE(req);
+}
+
+static void *_worker(void *arg)
+{
+    BD_ASYNC_READER *p = (BD_ASYNC_READER *)arg;
+
+    bd_mutex_lock(&p->mutex);
+
+    while (!p->exit) {
+        ASYNC_REQ *req = p->pending;
+
+        if (!req) {
+            bd_cond_wait(&p->cond, &p->mutex);
+            continue;
+        }
+
+        p->pending = req->next;
+        if (!p->pending) {
+            p->pending_tail = &p->pending;
+        }
+        req->next = NULL;
+
+        bd_mutex_unlock(&p->mutex);
+
+        req->result = p->read(p->handle, req->buf, req->len);
+        _complete(p, req);
+
+        bd_mutex_lock(&p->mutex);
+    }
+
+    bd_mutex_unlock(&p->mutex);
+
+    return NULL;
+}
+
+BD_ASYNC_READER *async_reader_init(async_read_f read, void *handle)
+{
+    BD_ASYNC_READER *p = calloc(1, sizeof(*p));
+
+    if (p) {
+        p->read         = read;
+        p->handle       = handle;
+        p->pending_tail = &p->pending;
+        p->done_tail    = &p->done;
+        p->notify[0]    = -1;
+        p->notify[1]    = -1;
+        bd_mutex_init(&p->mutex);
+        bd_cond_init(&p->cond);
+    }
+
+    return p;
+}
+
+void async_reader_free(BD_ASYNC_READER **pp)
+{
+    if (pp && *pp) {
+        BD_ASYNC_READER *p = *pp;
+
+        if (p->running) {
+            bd_mutex_lock(&p->mutex);
+            p->exit = 1;
+            bd_cond_signal(&p->cond);
+            bd_mutex_unlock(&p->mutex);
+
+            bd_thread_join(&p->thread);
+        }
+
+        /* deliver completed and cancel pending requests */
+        async_reader_dispatch(p);
+        while (p->pending) {
+            ASYNC_REQ *req = p->pending;
+            p->pending = req->next;
+            req->done(req->ctx, req->buf, -1);
+            X_FREE(req);
+        }
+
+#ifdef HAVE_NOTIFY_FD
+        if (p->notify[0] >= 0) {
+            close(p->notify[0]);
+            close(p->notify[1]);
+        }
+#endif
+
+        bd_cond_destroy(&p->cond);
+        bd_mutex_destroy(&p->mutex);
+        X_FREE(*pp);
+    }
+}
+
+int async_reader_submit(BD_ASYNC_READER *p, uint8_t *buf, int len, async_done_f done, void *ctx)
+{
+    ASYNC_REQ *req;
+
+    if (!p || !done) {
+        return 0;
+    }
+
+    req = calloc(1, sizeof(*req));
+    if (!req) {
+        return 0;
+    }
+    req->buf  = buf;
+    req->len  = len;
+    req->done = done;
+    req->ctx  = ctx;
+
+    bd_mutex_lock(&p->mutex);
+
+    if (!p->running) {
+        if (bd_thread_create(&p->thread, "bd_async_read", _worker, p) < 0) {
+            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "failed creating asynchronous read thread\n");
+            bd_mutex_unlock(&p->mutex);
+            X_FREE(req);
+            return 0;
+        }
+        p->running = 1;
+    }
+
+    *p->pending_tail = req;
+    p->pending_tail  = &req->next;
+    bd_cond_signal(&p->cond);
+
+    bd_mutex_unlock(&p->mutex);
+
+    return 1;
+}
+
+int async_reader_fd(BD_ASYNC_READER *p)
+{
+#ifdef HAVE_NOTIFY_FD
+    int fd;
+
+    if (!p) {
+        return -1;
+    }
+
+    bd_mutex_lock(&p->mutex);
+
+    if (p->notify[0] < 0) {
+        int notify[2];
+        if (pipe(notify) < 0) {
+            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "failed creating asynchronous read notification pipe\n");
+        } else {
+            fcntl(notify[0], F_SETFL, fcntl(notify[0], F_GETFL) | O_NONBLOCK);
+            fcntl(notify[1], F_SETFL, fcntl(notify[1], F_GETFL) | O_NONBLOCK);
+            fcntl(notify[0], F_SETFD, FD_CLOEXEC);
+            fcntl(notify[1], F_SETFD, FD_CLOEXEC);
+            p->notify[0] = notify[0];
+            p->notify[1] = notify[1];
+        }
+    }
+    fd = p->notify[0];
+
+    bd_mutex_unlock(&p->mutex);
+
+    return fd;
+#else
+    (void)p;
+    return -1;
+#endif
+}
+
+int async_reader_dispatch(BD_ASYNC_READER *p)
+{
+    ASYNC_REQ *list;
+    int        count = 0;
+
+    if (!p) {
+        return 0;
+    }
+
+    bd_mutex_lock(&p->mutex);
+
+    list = p->done;
+    p->done      = NULL;
+    p->done_tail = &p->done;
+
+#ifdef HAVE_NOTIFY_FD
+    if (p->notify[0] >= 0) {
+        uint8_t tmp[64];
+        while (read(p->notify[0], tmp, sizeof(tmp)) > 0) {
+        }
+    }
+#endif
+
+    bd_mutex_unlock(&p->mutex);
+
+    while (list) {
+        ASYNC_REQ *req = list;
+        list = req->next;
+        req->done(req->ctx, req->buf, req->result);
+        X_FREE(req);
+        count++;
+    }
+
+    return count;
+}
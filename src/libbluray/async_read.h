@@ -0,0 +1,54 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined(_BD_ASYNC_READ_H_)
+#define _BD_ASYNC_READ_H_
+
+/*
+ * asynchronous stream reading
+ *
+ * Requests are executed in order by a worker thread (started with first request).
+ * Completion callbacks are called from the worker thread, or, after
+ * async_reader_fd() has been called, from async_reader_dispatch().
+ */
+
+#include "util/attributes.h"
+
+#include <stdint.h>
+
+typedef struct bd_async_reader_s BD_ASYNC_READER;
+
+typedef int  (*async_read_f)(void *handle, uint8_t *buf, int len);
+typedef void (*async_done_f)(void *ctx, uint8_t *buf, int result);
+
+BD_PRIVATE BD_ASYNC_READER *async_reader_init(async_read_f read, void *handle);
+
+/* stop worker thread. Callbacks of unfinished requests are called with result -1. */
+BD_PRIVATE void async_reader_free(BD_ASYNC_READER **);
+
+/* queue read request. Returns 0 on error. */
+BD_PRIVATE int  async_reader_submit(BD_ASYNC_READER *, uint8_t *buf, int len, async_done_f done, void *ctx);
+
+/* file descriptor that becomes readable when requests complete. -1 if not supported. */
+BD_PRIVATE int  async_reader_fd(BD_ASYNC_READER *);
+
+/* call callbacks of completed requests. Returns number of completed requests. */
+BD_PRIVATE int  async_reader_dispatch(BD_ASYNC_READER *);
+
+#endif /* _BD_ASYNC_READ_H_ */
@@ -31,6 +31,8 @@
 #include "util/strutl.h"
 #include "util/macro.h"
 #include "util/logging.h"
+#include "util/mutex.h"
+#include "util/time.h"
 
 
 #include <jni.h>
@@ -52,11 +54,30 @@
 #define BDJ_JARFILE "libbluray-j2se-" VERSION ".jar"
 #endif
 
+#define BDJ_EVENT_BATCH_SIZE 32
+
 struct bdjava_s {
     void   *h_libjvm;
     JavaVM *jvm;
+
+    /* cached org.videolan.Libbluray.processEvent() / processEvents() */
+    jclass    event_class;  /* global ref */
+    jmethodID event_id;
+    jmethodID events_id;
+
+    /* pending notification events (delivered in batches) */
+    BD_MUTEX  event_mutex;
+    unsigned  num_events;
+    jint      events[BDJ_EVENT_BATCH_SIZE * 2];  /* event, param */
+
+    /* org.videolan.Libbluray.psrMirror */
+    jintArray psr_mirror;   /* global ref */
+    unsigned  num_psrs;
 };
 
+/* JVM library handle kept open by bdj_close(keep_warm) */
+static void *_warm_jvm_lib = NULL;
+
 typedef jint (JNICALL * fptr_JNI_CreateJavaVM) (JavaVM **pvm, void **penv,void *args);
 typedef jint (JNICALL * fptr_JNI_GetCreatedJavaVMs) (JavaVM **vmBuf, jsize bufLen, jsize *nVMs);
 
@@ -427,6 +448,40 @@ int bdj_jvm_available(BDJ_STORAGE *storage)
     return 2;
 }
 
+#ifndef HAVE_BDJ_J2ME
+/* class data sharing archive of libbluray.jar (generated with "ant cds") */
+static char *_find_cds_archive(const char *jar_file)
+{
+    const char *archive = getenv("LIBBLURAY_CDS");
+    char *path;
+
+    if (archive) {
+        if (!archive[0]) {
+            /* disabled */
+            return NULL;
+        }
+        path = str_dup(archive);
+    } else {
+        size_t len = strlen(jar_file);
+        if (len < 4 || strcmp(jar_file + len - 4, ".jar")) {
+            return NULL;
+        }
+        path = str_printf("%.*s.jsa", (int)(len - 4), jar_file);
+    }
+
+    if (path && _can_read_file(path)) {
+        BD_DEBUG(DBG_BDJ, "Using class data sharing archive %s\n", path);
+        return path;
+    }
+
+    if (archive) {
+        BD_DEBUG(DBG_BDJ | DBG_CRIT, "invalid LIBBLURAY_CDS %s\n", archive);
+    }
+    X_FREE(path);
+    return NULL;
+}
+#endif
+
 static int _find_jvm(void *jvm_lib, JNIEnv **env, JavaVM **jvm)
 {
     fptr_JNI_GetCreatedJavaVMs JNI_GetCreatedJavaVMs_fp = (fptr_JNI_GetCreatedJavaVMs)(intptr_t)dl_dlsym(jvm_lib, "JNI_GetCreatedJavaVMs");
@@ -448,9 +503,80 @@ static int _find_jvm(void *jvm_lib, JNIEnv **env, JavaVM **jvm)
     return 0;
 }
 
+/*
+ * User JVM options (LIBBLURAY_JVM_OPTIONS, BLURAY_PLAYER_JVM_OPTIONS).
+ * Whitespace-separated list, appended after built-in options (later options
+ * override earlier ones, ex. -Xmx).
+ * "low-latency" expands to preset reducing GC pauses and JIT warm-up time
+ * (menu animation stalls on constrained players).
+ */
+
+#define JVM_PRESET_LOW_LATENCY "low-latency"
+
+#ifndef HAVE_BDJ_J2ME
+static const char * const _low_latency_options[] = {
+    "-XX:+UseG1GC",             /* incremental collector */
+    "-XX:MaxGCPauseMillis=10",  /* GC pause target */
+    "-XX:TieredStopAtLevel=1",  /* C1 JIT only: fast warm-up, short compile pauses */
+};
+#endif
+
+static int _count_options(const char *options)
+{
+    int count = 0;
+
+    while (options && *options) {
+        options += strspn(options, " \t\r\n");
+        if (*options) {
+            count++;
+            options += strcspn(options, " \t\r\n");
+        }
+    }
+
+#ifndef HAVE_BDJ_J2ME
+    /* room for preset */
+    return count * (int)(sizeof(_low_latency_options) / sizeof(_low_latency_options[0]));
+#else
+    return count;
+#endif
+}
+
+static int _add_options(JavaVMOption *option, int n, const char *options, const char *source)
+{
+    while (options && *options) {
+        size_t len;
+
+        options += strspn(options, " \t\r\n");
+        len = strcspn(options, " \t\r\n");
+        if (!len) {
+            break;
+        }
+
+        if (len == strlen(JVM_PRESET_LOW_LATENCY) && !strncmp(options, JVM_PRESET_LOW_LATENCY, len)) {
+#ifndef HAVE_BDJ_J2ME
+            unsigned ii;
+            for (ii = 0; ii < sizeof(_low_latency_options) / sizeof(_low_latency_options[0]); ii++) {
+                option[n++].optionString = str_dup(_low_latency_options[ii]);
+            }
+#else
+            BD_DEBUG(DBG_BDJ | DBG_CRIT, "JVM option preset " JVM_PRESET_LOW_LATENCY " not supported with J2ME\n");
+#endif
+        } else {
+            option[n++].optionString = str_printf("%.*s", (int)len, options);
+        }
+
+        BD_DEBUG(DBG_BDJ, "JVM option from %s: %.*s\n", source, (int)len, options);
+        options += len;
+    }
+
+    return n;
+}
+
 static int _create_jvm(void *jvm_lib, const char *java_home, const char *jar_file,
-                       JNIEnv **env, JavaVM **jvm)
+                       const char *jvm_options, JNIEnv **env, JavaVM **jvm)
 {
+    const char *env_options = getenv("LIBBLURAY_JVM_OPTIONS");
+
     (void)java_home;  /* used only with J2ME */
 
     fptr_JNI_CreateJavaVM JNI_CreateJavaVM_fp = (fptr_JNI_CreateJavaVM)(intptr_t)dl_dlsym(jvm_lib, "JNI_CreateJavaVM");
@@ -459,19 +585,46 @@ static int _create_jvm(void *jvm_lib, const char *java_home, const char *jar_fil
         return 0;
     }
 
-    JavaVMOption* option = calloc(1, sizeof(JavaVMOption) * 20);
+    JavaVMOption* option = calloc(1, sizeof(JavaVMOption) * (20 + _count_options(env_options) + _count_options(jvm_options)));
     int n = 0;
     JavaVMInitArgs args;
+    if (!option) {
+        return 0;
+    }
     option[n++].optionString = str_dup   ("-Dawt.toolkit=java.awt.BDToolkit");
     option[n++].optionString = str_dup   ("-Djava.awt.graphicsenv=java.awt.BDGraphicsEnvironment");
     option[n++].optionString = str_printf("-Xbootclasspath/p:%s", jar_file);
     option[n++].optionString = str_dup   ("-Xms256M");
     option[n++].optionString = str_dup   ("-Xmx256M");
     option[n++].optionString = str_dup   ("-Xss2048k");
+
+    /* BD-J action queue worker threads */
+    if (getenv("LIBBLURAY_BDJ_THREADS")) {
+        option[n++].optionString = str_printf("-Dorg.videolan.threadpool.size=%d", atoi(getenv("LIBBLURAY_BDJ_THREADS")));
+    }
+    if (getenv("LIBBLURAY_BDJ_THREAD_STACK")) {
+        /* kB */
+        option[n++].optionString = str_printf("-Dorg.videolan.threadpool.stack=%d", atoi(getenv("LIBBLURAY_BDJ_THREAD_STACK")));
+    }
+
+    /* decoded image cache size (kB, 0 = disabled) */
+    if (getenv("LIBBLURAY_BDJ_IMAGE_CACHE")) {
+        option[n++].optionString = str_printf("-Dorg.videolan.imagecache.size=%d", atoi(getenv("LIBBLURAY_BDJ_IMAGE_CACHE")));
+    }
+
 #ifdef HAVE_BDJ_J2ME
     option[n++].optionString = str_printf("-Djava.home=%s", java_home);
     option[n++].optionString = str_printf("-Xbootclasspath/a:%s/lib/xmlparser.jar", java_home);
     option[n++].optionString = str_dup   ("-XfullShutdown");
+#else
+    /* archive must have been dumped with the same JVM and boot class path */
+    char *cds_archive = _find_cds_archive(jar_file);
+    if (cds_archive) {
+        option[n++].optionString = str_dup   ("-XX:+UnlockDiagnosticVMOptions");
+        option[n++].optionString = str_printf("-XX:SharedArchiveFile=%s", cds_archive);
+        option[n++].optionString = str_dup   ("-Xshare:auto");
+        X_FREE(cds_archive);
+    }
 #endif
 
     /* JVM debug options */
@@ -494,6 +647,10 @@ static int _create_jvm(void *jvm_lib, const char *java_home, const char *jar_fil
     }
 #endif
 
+    /* user options: environment, then player setting */
+    n = _add_options(option, n, env_options, "LIBBLURAY_JVM_OPTIONS");
+    n = _add_options(option, n, jvm_options, "player setting");
+
     args.version = JNI_VERSION_1_4;
     args.nOptions = n;
     args.options = option;
@@ -515,8 +672,11 @@ static int _create_jvm(void *jvm_lib, const char *java_home, const char *jar_fil
 }
 
 BDJAVA* bdj_open(const char *path, struct bluray *bd,
-                 const char *bdj_disc_id, BDJ_STORAGE *storage)
+                 const char *bdj_disc_id, BDJ_STORAGE *storage,
+                 BDJ_PROFILE *profile)
 {
+    uint64_t t0;
+
     BD_DEBUG(DBG_BDJ, "bdj_open()\n");
 
     const char *jar_file = _find_libbluray_jar(storage);
@@ -536,24 +696,55 @@ BDJAVA* bdj_open(const char *path, struct bluray *bd,
 
     JNIEnv* env = NULL;
     JavaVM *jvm = NULL;
+    t0 = bd_get_time_us();
     if (!_find_jvm(jvm_lib, &env, &jvm) &&
-        !_create_jvm(jvm_lib, java_home, jar_file, &env, &jvm)) {
+        !_create_jvm(jvm_lib, java_home, jar_file, storage->jvm_options, &env, &jvm)) {
 
         dl_dlclose(jvm_lib);
         return NULL;
     }
+    if (_warm_jvm_lib) {
+        /* BD-J stack was left running by previous bdj_close() */
+        dl_dlclose(_warm_jvm_lib);
+        _warm_jvm_lib = NULL;
+    }
+    if (profile) {
+        profile->create_jvm_us = bd_get_time_us() - t0;
+    }
 
     BDJAVA* bdjava = calloc(1, sizeof(BDJAVA));
     bdjava->h_libjvm = jvm_lib;
     bdjava->jvm = jvm;
+    bd_mutex_init(&bdjava->event_mutex);
 
     if (debug_mask & DBG_JNI) {
         int version = (int)(*env)->GetVersion(env);
         BD_DEBUG(DBG_BDJ, "Java version: %d.%d\n", version >> 16, version & 0xffff);
     }
 
+    t0 = bd_get_time_us();
     if (!_bdj_init(env, bd, path, bdj_disc_id, storage)) {
-        bdj_close(bdjava);
+        bdj_close(bdjava, 0);
+        return NULL;
+    }
+    if (profile) {
+        profile->bdj_init_us = bd_get_time_us() - t0;
+    }
+
+    /* cache event methods (used for every event, including frequent PTS updates) */
+    jclass event_class;
+    if (_get_method(env, &event_class, &bdjava->event_id,
+                    "org/videolan/Libbluray", "processEvent", "(II)Z")) {
+        bdjava->events_id = (*env)->GetStaticMethodID(env, event_class, "processEvents", "([II)V");
+        if (bdjava->events_id) {
+            bdjava->event_class = (jclass)(*env)->NewGlobalRef(env, event_class);
+        } else {
+            (*env)->ExceptionClear(env);
+        }
+        (*env)->DeleteLocalRef(env, event_class);
+    }
+    if (!bdjava->event_class) {
+        bdj_close(bdjava, 0);
         return NULL;
     }
 
@@ -563,7 +754,7 @@ BDJAVA* bdj_open(const char *path, struct bluray *bd,
     return bdjava;
 }
 
-void bdj_close(BDJAVA *bdjava)
+void bdj_close(BDJAVA *bdjava, int keep_warm)
 {
     JNIEnv *env;
     int attach = 0;
@@ -583,8 +774,8 @@ void bdj_close(BDJAVA *bdjava)
         }
 
         if (_get_method(env, &shutdown_class, &shutdown_id,
-                           "org/videolan/Libbluray", "shutdown", "()V")) {
-            (*env)->CallStaticVoidMethod(env, shutdown_class, shutdown_id);
+                           "org/videolan/Libbluray", "shutdown", "(Z)V")) {
+            (*env)->CallStaticVoidMethod(env, shutdown_class, shutdown_id, keep_warm ? JNI_TRUE : JNI_FALSE);
 
             if ((*env)->ExceptionOccurred(env)) {
                 (*env)->ExceptionDescribe(env);
@@ -595,7 +786,19 @@ void bdj_close(BDJAVA *bdjava)
             (*env)->DeleteLocalRef(env, shutdown_class);
         }
 
-        bdj_unregister_native_methods(env);
+        if (bdjava->event_class) {
+            (*env)->DeleteGlobalRef(env, bdjava->event_class);
+            bdjava->event_class = NULL;
+        }
+        if (bdjava->psr_mirror) {
+            (*env)->DeleteGlobalRef(env, bdjava->psr_mirror);
+            bdjava->psr_mirror = NULL;
+        }
+
+        /* threads left running may still call native methods */
+        if (!keep_warm) {
+            bdj_unregister_native_methods(env);
+        }
 
         if (attach) {
             (*bdjava->jvm)->DetachCurrentThread(bdjava->jvm);
@@ -603,12 +806,125 @@ void bdj_close(BDJAVA *bdjava)
     }
 
     if (bdjava->h_libjvm) {
-        dl_dlclose(bdjava->h_libjvm);
+        if (keep_warm && !_warm_jvm_lib) {
+            _warm_jvm_lib = bdjava->h_libjvm;
+        } else {
+            dl_dlclose(bdjava->h_libjvm);
+        }
     }
 
+    bd_mutex_destroy(&bdjava->event_mutex);
+
     X_FREE(bdjava);
 }
 
+/*
+ * events
+ */
+
+static JNIEnv *_get_env(BDJAVA *bdjava)
+{
+    JNIEnv *env;
+
+    /* Calling thread is left attached to the JVM: events are usually sent
+     * from the same application thread(s) several times per second.
+     * Attach as daemon, so the thread does not prevent JVM shutdown.
+     */
+    if ((*bdjava->jvm)->GetEnv(bdjava->jvm, (void**)&env, JNI_VERSION_1_4) != JNI_OK) {
+        if ((*bdjava->jvm)->AttachCurrentThreadAsDaemon(bdjava->jvm, (void**)&env, NULL) != JNI_OK) {
+            BD_DEBUG(DBG_BDJ | DBG_CRIT, "failed to attach thread to JVM\n");
+            return NULL;
+        }
+    }
+
+    return env;
+}
+
+static void _deliver_events(BDJAVA *bdjava, const jint *events, unsigned num_events)
+{
+    JNIEnv    *env;
+    jintArray  array;
+
+    if (!bdjava->event_class) {
+        return;
+    }
+
+    env = _get_env(bdjava);
+    if (!env) {
+        return;
+    }
+
+    array = (*env)->NewIntArray(env, num_events * 2);
+    if (!array) {
+        BD_DEBUG(DBG_BDJ | DBG_CRIT, "bdj: failed to deliver %u events (out of memory)\n", num_events);
+        (*env)->ExceptionClear(env);
+        return;
+    }
+
+    (*env)->SetIntArrayRegion(env, array, 0, num_events * 2, events);
+    (*env)->CallStaticVoidMethod(env, bdjava->event_class, bdjava->events_id, array, (jint)num_events);
+
+    if ((*env)->ExceptionOccurred(env)) {
+        (*env)->ExceptionDescribe(env);
+        BD_DEBUG(DBG_BDJ | DBG_CRIT, "bdj: event delivery failed (uncaught exception)\n");
+        (*env)->ExceptionClear(env);
+    }
+
+    (*env)->DeleteLocalRef(env, array);
+}
+
+void bdj_flush_events(BDJAVA *bdjava)
+{
+    jint     events[BDJ_EVENT_BATCH_SIZE * 2];
+    unsigned num_events;
+
+    if (!bdjava) {
+        return;
+    }
+
+    /* do not hold the lock while in Java: event handlers may trigger new events */
+    bd_mutex_lock(&bdjava->event_mutex);
+    num_events = bdjava->num_events;
+    memcpy(events, bdjava->events, num_events * 2 * sizeof(jint));
+    bdjava->num_events = 0;
+    bd_mutex_unlock(&bdjava->event_mutex);
+
+    if (num_events > 0) {
+        _deliver_events(bdjava, events, num_events);
+    }
+}
+
+static void _queue_event(BDJAVA *bdjava, unsigned ev, unsigned param)
+{
+    unsigned i;
+    int      full;
+
+    bd_mutex_lock(&bdjava->event_mutex);
+
+    /* coalesce PTS updates: only latest value is delivered */
+    if (ev == BDJ_EVENT_PTS) {
+        for (i = 0; i < bdjava->num_events; i++) {
+            if (bdjava->events[i * 2] == BDJ_EVENT_PTS) {
+                memmove(&bdjava->events[i * 2], &bdjava->events[i * 2 + 2],
+                        (bdjava->num_events - i - 1) * 2 * sizeof(jint));
+                bdjava->num_events--;
+                break;
+            }
+        }
+    }
+
+    bdjava->events[bdjava->num_events * 2]     = (jint)ev;
+    bdjava->events[bdjava->num_events * 2 + 1] = (jint)param;
+    bdjava->num_events++;
+    full = (bdjava->num_events >= BDJ_EVENT_BATCH_SIZE);
+
+    bd_mutex_unlock(&bdjava->event_mutex);
+
+    if (full) {
+        bdj_flush_events(bdjava);
+    }
+}
+
 int bdj_process_event(BDJAVA *bdjava, unsigned ev, unsigned param)
 {
     static const char * const ev_name[] = {
@@ -632,9 +948,6 @@ int bdj_process_event(BDJAVA *bdjava, unsigned ev, unsigned param)
     };
 
     JNIEnv* env;
-    int attach = 0;
-    jclass event_class;
-    jmethodID event_id;
     int result = -1;
 
     if (!bdjava) {
@@ -646,29 +959,91 @@ int bdj_process_event(BDJAVA *bdjava, unsigned ev, unsigned param)
         BD_DEBUG(DBG_BDJ, "bdj_process_event(%s,%d)\n", ev_name[ev], param);
     }
 
-    if ((*bdjava->jvm)->GetEnv(bdjava->jvm, (void**)&env, JNI_VERSION_1_4) != JNI_OK) {
-        (*bdjava->jvm)->AttachCurrentThread(bdjava->jvm, (void**)&env, NULL);
-        attach = 1;
+    /* notifications are queued and delivered in batches */
+    if (ev != BDJ_EVENT_START && ev != BDJ_EVENT_STOP && ev != BDJ_EVENT_VK_KEY) {
+        _queue_event(bdjava, ev, param);
+        return 0;
     }
 
-    if (_get_method(env, &event_class, &event_id,
-                       "org/videolan/Libbluray", "processEvent", "(II)Z")) {
-        if ((*env)->CallStaticBooleanMethod(env, event_class, event_id, ev, param)) {
-            result = 0;
-        }
+    /* keep order: deliver queued notifications first */
+    bdj_flush_events(bdjava);
 
-        if ((*env)->ExceptionOccurred(env)) {
-            (*env)->ExceptionDescribe(env);
-            BD_DEBUG(DBG_BDJ | DBG_CRIT, "bdj_process_event(%u,%u) failed (uncaught exception)\n", ev, param);
-            (*env)->ExceptionClear(env);
-        }
+    env = _get_env(bdjava);
+    if (!env) {
+        return -1;
+    }
 
-        (*env)->DeleteLocalRef(env, event_class);
+    if ((*env)->CallStaticBooleanMethod(env, bdjava->event_class, bdjava->event_id, ev, param)) {
+        result = 0;
     }
 
-    if (attach) {
-        (*bdjava->jvm)->DetachCurrentThread(bdjava->jvm);
+    if ((*env)->ExceptionOccurred(env)) {
+        (*env)->ExceptionDescribe(env);
+        BD_DEBUG(DBG_BDJ | DBG_CRIT, "bdj_process_event(%u,%u) failed (uncaught exception)\n", ev, param);
+        (*env)->ExceptionClear(env);
     }
 
     return result;
 }
+
+/*
+ * PSR mirror
+ */
+
+int bdj_psr_mirror_init(BDJAVA *bdjava, const uint32_t *psr, unsigned num_psrs)
+{
+    JNIEnv    *env;
+    jfieldID   field_id;
+    jintArray  array;
+
+    if (!bdjava || !bdjava->event_class || bdjava->psr_mirror) {
+        return 0;
+    }
+
+    env = _get_env(bdjava);
+    if (!env) {
+        return 0;
+    }
+
+    field_id = (*env)->GetStaticFieldID(env, bdjava->event_class, "psrMirror", "[I");
+    if (!field_id) {
+        BD_DEBUG(DBG_BDJ | DBG_CRIT, "bdj: PSR mirror not available\n");
+        (*env)->ExceptionClear(env);
+        return 0;
+    }
+
+    array = (*env)->NewIntArray(env, num_psrs);
+    if (!array) {
+        BD_DEBUG(DBG_BDJ | DBG_CRIT, "bdj: failed to create PSR mirror (out of memory)\n");
+        (*env)->ExceptionClear(env);
+        return 0;
+    }
+
+    (*env)->SetIntArrayRegion(env, array, 0, num_psrs, (const jint *)psr);
+
+    bdjava->psr_mirror = (jintArray)(*env)->NewGlobalRef(env, array);
+    bdjava->num_psrs   = num_psrs;
+
+    /* publish: Java reads the mirror instead of calling readPSRN() */
+    (*env)->SetStaticObjectField(env, bdjava->event_class, field_id, array);
+    (*env)->DeleteLocalRef(env, array);
+
+    return bdjava->psr_mirror != NULL;
+}
+
+void bdj_psr_mirror_update(BDJAVA *bdjava, int reg, uint32_t value)
+{
+    JNIEnv *env;
+    jint    v = (jint)value;
+
+    if (!bdjava || !bdjava->psr_mirror || reg < 0 || (unsigned)reg >= bdjava->num_psrs) {
+        return;
+    }
+
+    env = _get_env(bdjava);
+    if (!env) {
+        return;
+    }
+
+    (*env)->SetIntArrayRegion(env, bdjava->psr_mirror, reg, 1, &v);
+}
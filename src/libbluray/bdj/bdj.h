@@ -22,6 +22,8 @@
 
 #include "util/attributes.h"
 
+#include <stdint.h>
+
 typedef enum {
     BDJ_EVENT_NONE = 0,
     BDJ_EVENT_CHAPTER,
@@ -47,16 +49,32 @@ typedef struct {
     char *cache_root;
 
     char *classpath;
+
+    char *jvm_options;  /* extra JVM options (applied when JVM is created) */
 } BDJ_STORAGE;
 
 typedef struct bdjava_s BDJAVA;
 
+/* bdj_open() phase timings (microseconds) */
+typedef struct {
+    uint64_t create_jvm_us;
+    uint64_t bdj_init_us;
+} BDJ_PROFILE;
+
 struct bluray;
 
 BD_PRIVATE BDJAVA* bdj_open(const char *path, struct bluray *bd,
-                            const char *bdj_disc_id, BDJ_STORAGE *storage);
-BD_PRIVATE void bdj_close(BDJAVA *bdjava);
+                            const char *bdj_disc_id, BDJ_STORAGE *storage,
+                            BDJ_PROFILE *profile);
+BD_PRIVATE void bdj_close(BDJAVA *bdjava, int keep_warm); /* keep_warm: leave JVM threads and fonts loaded for next disc */
 BD_PRIVATE int  bdj_process_event(BDJAVA *bdjava, unsigned ev, unsigned param);
+BD_PRIVATE void bdj_flush_events(BDJAVA *bdjava); /* deliver queued notification events */
+
+/* Java-side PSR mirror (org.videolan.Libbluray.psrMirror).
+ * Initialize with current register values, then update from PSR change callbacks
+ * (with PSRs locked, so no change is lost in between). */
+BD_PRIVATE int  bdj_psr_mirror_init(BDJAVA *bdjava, const uint32_t *psr, unsigned num_psrs);
+BD_PRIVATE void bdj_psr_mirror_update(BDJAVA *bdjava, int reg, uint32_t value);
 
 BD_PRIVATE int  bdj_jvm_available(BDJ_STORAGE *storage); /* 0: no. 1: only jvm. 2: jvm + libbluray.jar. */
 
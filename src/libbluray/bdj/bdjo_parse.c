@@ -27,6 +27,7 @@
 #include "file/file.h"
 #include "util/bits.h"
 #include "util/logging.h"
+#include "util/refcnt.h"
 #include "util/macro.h"
 
 #include <stdlib.h>
@@ -452,8 +453,10 @@ static int _parse_file_access_info(BITSTREAM *bs, BDJO_FILE_ACCESS_INFO *p)
 
 /* BDJO */
 
-static void _clean_bdjo(BDJO *p)
+/* refcnt cleanup callback */
+static void _clean_bdjo(void *q)
 {
+    BDJO *p = (BDJO *)q;
     if (p) {
         _clean_app_cache_info(&p->app_cache_info);
         _clean_accessible_playlists(&p->accessible_playlists);
@@ -503,13 +506,14 @@ static BDJO *_bdjo_parse(BD_FILE_H *fp)
     BITSTREAM   bs;
     BDJO       *p;
 
-    bs_init(&bs, fp);
-
-    p = calloc(1, sizeof(BDJO));
+    p = refcnt_realloc(NULL, sizeof(BDJO), _clean_bdjo);
     if (!p) {
         BD_DEBUG(DBG_BDJ | DBG_CRIT, "Out of memory\n");
         return NULL;
     }
+    memset(p, 0, sizeof(BDJO));
+
+    bs_init(&bs, fp);
 
     if (_check_version(&bs) < 0 ||
         _parse_terminal_info(&bs, &p->terminal_info) < 0 ||
@@ -522,6 +526,7 @@ static BDJO *_bdjo_parse(BD_FILE_H *fp)
         bdjo_free(&p);
     }
 
+    bs_close(&bs);
     return p;
 }
 
@@ -532,8 +537,9 @@ static BDJO *_bdjo_parse(BD_FILE_H *fp)
 void bdjo_free(BDJO **pp)
 {
     if (pp && *pp) {
-        _clean_bdjo(*pp);
-        X_FREE(*pp);
+        /* release reference (object may be shared with disc cache) */
+        bd_refcnt_dec(*pp);
+        *pp = NULL;
     }
 }
 
@@ -553,7 +559,7 @@ BDJO *bdjo_parse(const char *path)
     return bdjo;
 }
 
-static BDJO *_bdjo_get(BD_DISC *disc, const char *dir, const char *file)
+static BDJO *_bdjo_get(BD_DISC *disc, const char *dir, const char *file, size_t *size)
 {
     BD_FILE_H *fp;
     BDJO      *bdjo;
@@ -564,6 +570,7 @@ static BDJO *_bdjo_get(BD_DISC *disc, const char *dir, const char *file)
     }
 
     bdjo = _bdjo_parse(fp);
+    *size = sizeof(BDJO) + (size_t)file_size(fp);
     file_close(fp);
 
     return bdjo;
@@ -571,14 +578,20 @@ static BDJO *_bdjo_get(BD_DISC *disc, const char *dir, const char *file)
 
 BDJO *bdjo_get(BD_DISC *disc, const char *file)
 {
-    BDJO *bdjo;
+    BDJO   *bdjo;
+    size_t  size = 0;
 
-    bdjo = _bdjo_get(disc, "BDMV" DIR_SEP "BDJO", file);
+    bdjo = disc_cache_get(disc, file);
     if (bdjo) {
         return bdjo;
     }
 
-    /* if failed, try backup file */
-    bdjo = _bdjo_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "BDJO", file);
+    bdjo = _bdjo_get(disc, "BDMV" DIR_SEP "BDJO", file, &size);
+    if (!bdjo) {
+        /* if failed, try backup file */
+        bdjo = _bdjo_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "BDJO", file, &size);
+    }
+
+    disc_cache_put(disc, file, bdjo, size);
     return bdjo;
 }
@@ -26,7 +26,9 @@ struct bdjo_data;
 struct bd_disc;
 
 BD_PRIVATE struct bdjo_data *bdjo_parse(const char *path);
+/* returned object is shared (disc cache): must not be modified */
 BD_PRIVATE struct bdjo_data *bdjo_get(struct bd_disc *disc, const char *file);
+/* release reference */
 BD_PRIVATE void              bdjo_free(struct bdjo_data **pp);
 
 #endif // _BDJO_PARSE_H_
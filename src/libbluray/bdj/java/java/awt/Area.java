@@ -20,6 +20,9 @@
 package java.awt;
 
 class Area {
+    /* max. number of separate dirty rectangles. More rectangles are merged. */
+    public static final int MAX_RECTS = 8;
+
     public int x0;
     public int y0;
     public int x1;
@@ -38,6 +41,9 @@ class Area {
         this.y0 = y0;
         this.x1 = x1;
         this.y1 = y1;
+        if (!isEmpty()) {
+            addRect(x0, y0, x1, y1);
+        }
     }
 
     public void clear() {
@@ -45,6 +51,7 @@ class Area {
         y0 = Integer.MAX_VALUE;
         x1 = -1;
         y1 = -1;
+        numRects = 0;
     }
 
     public void add(int newx, int newy) {
@@ -52,6 +59,7 @@ class Area {
         x1 = Math.max(x1, newx);
         y0 = Math.min(y0, newy);
         y1 = Math.max(y1, newy);
+        addRect(newx, newy, newx, newy);
     }
 
     public void add(Rectangle r) {
@@ -60,6 +68,9 @@ class Area {
             x1 = Math.max(x1, r.x + r.width - 1);
             y0 = Math.min(y0, r.y);
             y1 = Math.max(y1, r.y + r.height - 1);
+            if (r.width > 0 && r.height > 0) {
+                addRect(r.x, r.y, r.x + r.width - 1, r.y + r.height - 1);
+            }
         }
     }
 
@@ -70,4 +81,76 @@ class Area {
     public Area getBounds() {
         return new Area(x0, y0, x1, y1);
     }
+
+    /* copy dirty rectangles (x0, y0, x1, y1 for each rectangle) to out
+     * (MAX_RECTS * 4 entries). Returns number of rectangles. */
+    public int getRects(int[] out) {
+        System.arraycopy(rects, 0, out, 0, numRects * 4);
+        return numRects;
+    }
+
+    public int getNumRects() {
+        return numRects;
+    }
+
+    private static long area(int ax0, int ay0, int ax1, int ay1) {
+        return (long)(ax1 - ax0 + 1) * (long)(ay1 - ay0 + 1);
+    }
+
+    private void addRect(int rx0, int ry0, int rx1, int ry1) {
+        /* merge with touching or overlapping rectangle */
+        for (int i = 0; i < numRects; i++) {
+            int o = i * 4;
+            if (rx0 <= rects[o + 2] + 1 && rx1 + 1 >= rects[o] &&
+                ry0 <= rects[o + 3] + 1 && ry1 + 1 >= rects[o + 1]) {
+                rx0 = Math.min(rx0, rects[o]);
+                ry0 = Math.min(ry0, rects[o + 1]);
+                rx1 = Math.max(rx1, rects[o + 2]);
+                ry1 = Math.max(ry1, rects[o + 3]);
+                removeRect(i);
+                /* merged rectangle may now touch others */
+                addRect(rx0, ry0, rx1, ry1);
+                return;
+            }
+        }
+
+        if (numRects >= MAX_RECTS) {
+            /* too many rectangles: merge with the one that grows least */
+            int  best = 0;
+            long bestGrowth = Long.MAX_VALUE;
+            for (int i = 0; i < numRects; i++) {
+                int o = i * 4;
+                long growth = area(Math.min(rx0, rects[o]),     Math.min(ry0, rects[o + 1]),
+                                   Math.max(rx1, rects[o + 2]), Math.max(ry1, rects[o + 3]))
+                              - area(rects[o], rects[o + 1], rects[o + 2], rects[o + 3]);
+                if (growth < bestGrowth) {
+                    bestGrowth = growth;
+                    best = i;
+                }
+            }
+            int o = best * 4;
+            rx0 = Math.min(rx0, rects[o]);
+            ry0 = Math.min(ry0, rects[o + 1]);
+            rx1 = Math.max(rx1, rects[o + 2]);
+            ry1 = Math.max(ry1, rects[o + 3]);
+            removeRect(best);
+            addRect(rx0, ry0, rx1, ry1);
+            return;
+        }
+
+        int o = numRects * 4;
+        rects[o]     = rx0;
+        rects[o + 1] = ry0;
+        rects[o + 2] = rx1;
+        rects[o + 3] = ry1;
+        numRects++;
+    }
+
+    private void removeRect(int i) {
+        numRects--;
+        System.arraycopy(rects, (i + 1) * 4, rects, i * 4, (numRects - i) * 4);
+    }
+
+    private int   numRects = 0;
+    private int[] rects = new int[MAX_RECTS * 4];
 }
@@ -138,6 +138,31 @@ public class BDFontMetrics extends sun.font.FontDesignMetrics {
         ftLib = 0;
     }
 
+    /* release disc fonts only. FreeType library and system fonts are kept loaded. */
+    public synchronized static void shutdownDisc() {
+        if (systemFontNameMap == null) {
+            return;
+        }
+        Iterator it = fontMetricsMap.entrySet().iterator();
+        while (it.hasNext()) {
+            try {
+                Map.Entry entry = (Map.Entry)it.next();
+                String key = (String)entry.getKey();
+                String nativeName = key.substring(0, key.lastIndexOf('.'));
+                if (systemFontNameMap.containsValue(nativeName)) {
+                    continue;
+                }
+                BDFontMetrics fm = (BDFontMetrics)((WeakReference)entry.getValue()).get();
+                it.remove();
+                if (fm != null) {
+                    fm.destroy();
+                }
+            } catch (Throwable e) {
+                e.printStackTrace();
+            }
+        }
+    }
+
     /** A map which maps a native font name and size to a font metrics object. This is used
      as a cache to prevent loading the same fonts multiple times. */
     private static Map fontMetricsMap = new HashMap();
@@ -282,14 +307,33 @@ public class BDFontMetrics extends sun.font.FontDesignMetrics {
      * Return the width of the specified string in this Font.
      */
     public synchronized int stringWidth(String string) {
-        return stringWidthN(ftFace, string);
+        /* Latin-1 strings are measured without native call */
+        int length = string.length();
+        int width = 0;
+        loadWidths();
+        for (int i = 0; i < length; i++) {
+            char c = string.charAt(i);
+            if (c >= 256) {
+                return stringWidthN(ftFace, string);
+            }
+            width += widths[c];
+        }
+        return width;
     }
 
     /**
      * Return the width of the specified char[] in this Font.
      */
     public synchronized int charsWidth(char chars[], int offset, int length) {
-        return charsWidthN(ftFace, chars, offset, length);
+        int width = 0;
+        loadWidths();
+        for (int i = offset; i < offset + length; i++) {
+            if (chars[i] >= 256) {
+                return charsWidthN(ftFace, chars, offset, length);
+            }
+            width += widths[chars[i]];
+        }
+        return width;
     }
 
     /**
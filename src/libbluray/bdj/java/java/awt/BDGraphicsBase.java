@@ -301,6 +301,19 @@ abstract class BDGraphicsBase extends Graphics2D implements ConstrainableGraphic
         return ((int)((rgb >>> 24) * composite.getAlpha()) << 24) | (rgb & 0x00FFFFFF);
     }
 
+    /*
+     * native pixel kernels. Used for areas of at least NATIVE_MIN_PIXELS pixels,
+     * smaller areas are faster to draw in Java (no JNI call overhead).
+     */
+
+    private static final int NATIVE_MIN_PIXELS = 256;
+
+    private static native void fillRectN(int[] dst, int dstOffset, int dstStride,
+                                         int w, int h, int rgb, int rule);
+    private static native void blitN(int[] dst, int dstOffset, int dstStride,
+                                     int[] src, int srcOffset, int srcStride,
+                                     int w, int h, int rule, float alpha, boolean flipX);
+
     private void drawSpanN(int x, int y, int length, int rgb) {
 
         Rectangle rect = new Rectangle(x, y, length, 1);
@@ -322,6 +335,12 @@ abstract class BDGraphicsBase extends Graphics2D implements ConstrainableGraphic
             return;
         }
 
+        if (length >= NATIVE_MIN_PIXELS) {
+            fillRectN(backBuffer, y * width + x, width, length, 1, applyComposite(rgb), composite.getRule());
+            dirty.add(rect);
+            return;
+        }
+
         switch (composite.getRule()) {
             case AlphaComposite.CLEAR:
                 for (int i = 0; i < length; i++) {
@@ -391,6 +410,13 @@ abstract class BDGraphicsBase extends Graphics2D implements ConstrainableGraphic
             return;
         }
 
+        if (length >= NATIVE_MIN_PIXELS) {
+            blitN(backBuffer, dstOffset, width, src, srcOffset, length,
+                  length, 1, composite.getRule(), composite.getAlpha(), flipX);
+            dirty.add(rect);
+            return;
+        }
+
         switch (composite.getRule()) {
             case AlphaComposite.CLEAR:
                 for (int i = 0; i < length; i++) {
@@ -482,6 +508,11 @@ abstract class BDGraphicsBase extends Graphics2D implements ConstrainableGraphic
         w = rect.width;
         h = rect.height;
         int rgb = foreground.getRGB();
+        if (xorColor == null && w > 0 && h > 0 && x >= 0 && y >= 0 && w * h >= NATIVE_MIN_PIXELS) {
+            fillRectN(backBuffer, y * width + x, width, w, h, applyComposite(rgb), composite.getRule());
+            dirty.add(rect);
+            return;
+        }
         for (int Y = y; Y < (y + h); Y++)
             drawSpanN(x, Y, w, rgb);
     }
@@ -1109,7 +1140,25 @@ abstract class BDGraphicsBase extends Graphics2D implements ConstrainableGraphic
         }
     }
 
-    protected native void drawStringN(long ftFace, String string, int x, int y, int rgb);
+    private static native void drawStringN(long ftFace, String string, int x, int y, int rgb,
+                                           int[] dst, int dstWidth, int dstHeight,
+                                           int clipX, int clipY, int clipW, int clipH,
+                                           int rule, float alpha, boolean xorMode, int xorRgb,
+                                           int[] bbox);
+
+    /* called from BDFontMetrics.drawString() */
+    protected void drawStringN(long ftFace, String string, int x, int y, int rgb) {
+        int[] bbox = new int[4];
+        drawStringN(ftFace, string, x + originX, y + originY, rgb,
+                    backBuffer, width, height,
+                    actualClip.x, actualClip.y, actualClip.width, actualClip.height,
+                    composite.getRule(), composite.getAlpha(),
+                    xorColor != null, xorColor != null ? xorColor.getRGB() : 0,
+                    bbox);
+        if (bbox[2] >= bbox[0] && bbox[3] >= bbox[1]) {
+            dirty.add(new Rectangle(bbox[0], bbox[1], bbox[2] - bbox[0] + 1, bbox[3] - bbox[1] + 1));
+        }
+    }
 
     /** Draws the given string. */
     public void drawString(String string, int x, int y) {
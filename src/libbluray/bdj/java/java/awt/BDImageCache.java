@@ -0,0 +1,186 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2014  Petri Hintukainen <phintuka@users.sourceforge.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+package java.awt;
+
+import java.io.File;
+import java.lang.ref.ReferenceQueue;
+import java.lang.ref.SoftReference;
+import java.net.URL;
+import java.util.Hashtable;
+import java.util.Iterator;
+import java.util.LinkedHashMap;
+
+import org.videolan.Logger;
+
+/*
+ * Cache of decoded images.
+ *
+ * Images loaded from files are shared between all xlets. Cache is keyed by
+ * canonical file path, modification time and size. Pixel data is held with
+ * soft references, and total size of cached pixels is limited to
+ * org.videolan.imagecache.size kB (least recently used images are dropped).
+ *
+ * Cached pixel arrays are shared: images must copy the array before modifying it.
+ */
+
+class BDImageCache {
+
+    static class Entry {
+        final int width;
+        final int height;
+        final int[] pixels;
+        final Hashtable properties;
+
+        Entry(int width, int height, int[] pixels, Hashtable properties) {
+            this.width = width;
+            this.height = height;
+            this.pixels = pixels;
+            this.properties = properties;
+        }
+    }
+
+    /* get cache key for image file. Returns null if file can't be cached. */
+    static String getKey(String filename) {
+        if (maxBytes <= 0) {
+            return null;
+        }
+        try {
+            File file = new File(filename);
+            long length = file.length();
+            long modified = file.lastModified();
+            if (length <= 0 || modified == 0) {
+                return null;
+            }
+            return file.getCanonicalPath() + ":" + modified + ":" + length;
+        } catch (Exception e) {
+            return null;
+        }
+    }
+
+    static String getKey(URL url) {
+        if (url == null || !"file".equals(url.getProtocol())) {
+            return null;
+        }
+        return getKey(url.getFile());
+    }
+
+    static synchronized Entry get(String key) {
+        CachedImage img = (CachedImage)images.get(key);
+        if (img == null) {
+            return null;
+        }
+
+        int[] pixels = (int[])img.get();
+        if (pixels == null) {
+            /* collected */
+            remove(key);
+            return null;
+        }
+
+        return new Entry(img.width, img.height, pixels, img.properties);
+    }
+
+    static synchronized void put(String key, int width, int height, int[] pixels, Hashtable properties) {
+        long bytes = 4L * pixels.length;
+        if (bytes > maxBytes / 4) {
+            /* do not flush whole cache because of one big image */
+            return;
+        }
+
+        purge();
+
+        remove(key);
+        images.put(key, new CachedImage(key, width, height, pixels, properties, queue));
+        totalBytes += bytes;
+
+        /* drop least recently used images */
+        Iterator it = images.values().iterator();
+        while (totalBytes > maxBytes && it.hasNext()) {
+            CachedImage img = (CachedImage)it.next();
+            it.remove();
+            totalBytes -= img.bytes;
+        }
+    }
+
+    static synchronized void clear() {
+        images.clear();
+        totalBytes = 0;
+        while (queue.poll() != null) {
+        }
+    }
+
+    /*
+     *
+     */
+
+    private static class CachedImage extends SoftReference {
+        final String key;
+        final int width;
+        final int height;
+        final long bytes;
+        final Hashtable properties;
+
+        CachedImage(String key, int width, int height, int[] pixels, Hashtable properties, ReferenceQueue queue) {
+            super(pixels, queue);
+            this.key = key;
+            this.width = width;
+            this.height = height;
+            this.bytes = 4L * pixels.length;
+            this.properties = properties;
+        }
+    }
+
+    private static void remove(String key) {
+        CachedImage img = (CachedImage)images.remove(key);
+        if (img != null) {
+            totalBytes -= img.bytes;
+        }
+    }
+
+    /* remove images collected by GC */
+    private static void purge() {
+        CachedImage img;
+        while ((img = (CachedImage)queue.poll()) != null) {
+            if (images.get(img.key) == img) {
+                remove(img.key);
+            }
+        }
+    }
+
+    private static long getMaxBytes() {
+        try {
+            String value = System.getProperty("org.videolan.imagecache.size");
+            if (value != null) {
+                return 1024L * Integer.parseInt(value);
+            }
+        } catch (Exception e) {
+            logger.error("invalid org.videolan.imagecache.size: " + e);
+        }
+        return 16 * 1024 * 1024;
+    }
+
+    private static final Logger logger = Logger.getLogger(BDImageCache.class.getName());
+
+    /* access order map: first entry is least recently used */
+    private static final LinkedHashMap images = new LinkedHashMap(64, 0.75f, true);
+    private static final ReferenceQueue queue = new ReferenceQueue();
+    private static final long maxBytes = getMaxBytes();
+    private static long totalBytes = 0;
+}
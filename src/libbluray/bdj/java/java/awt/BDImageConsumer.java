@@ -30,12 +30,59 @@ public class BDImageConsumer extends BDImage implements ImageConsumer {
     private ImageProducer producer;
     private int status;
     private boolean started;
+    private String cacheKey = null;
+    private boolean sharedBuffer = false; /* backBuffer is in BDImageCache */
 
     public BDImageConsumer(ImageProducer producer) {
         super(null, -1, -1, null);
         this.producer = producer;
     }
 
+    /* cacheKey: BDImageCache key of the image source, or null */
+    BDImageConsumer(ImageProducer producer, String cacheKey) {
+        this(producer);
+        this.cacheKey = cacheKey;
+
+        BDImageCache.Entry cached = (cacheKey == null) ? null : BDImageCache.get(cacheKey);
+        if (cached != null) {
+            width = cached.width;
+            height = cached.height;
+            backBuffer = cached.pixels;
+            properties = cached.properties;
+            sharedBuffer = true;
+            started = true;
+            status = ImageObserver.WIDTH | ImageObserver.HEIGHT | ImageObserver.ALLBITS;
+            if (properties != null) {
+                status |= ImageObserver.PROPERTIES;
+            }
+        }
+    }
+
+    /* copy shared pixels before modifying the image */
+    private synchronized void unshareBuffer() {
+        if (sharedBuffer) {
+            sharedBuffer = false;
+            if (backBuffer != null) {
+                backBuffer = (int[])backBuffer.clone();
+            }
+        }
+    }
+
+    public Graphics getGraphics() {
+        unshareBuffer();
+        return super.getGraphics();
+    }
+
+    public void setRGB(int x, int y, int rgb) {
+        unshareBuffer();
+        super.setRGB(x, y, rgb);
+    }
+
+    public void setRGB(int x, int y, int w, int h, int[] rgbArray, int offset, int scansize) {
+        unshareBuffer();
+        super.setRGB(x, y, w, h, rgbArray, offset, scansize);
+    }
+
     public int getWidth(ImageObserver observer) {
         if (width < 0) {
             addObserver(observer);
@@ -88,6 +135,7 @@ public class BDImageConsumer extends BDImage implements ImageConsumer {
         width = -1;
         height = -1;
         backBuffer = null;
+        sharedBuffer = false;
         status = 0;
         started = false;
         producer.removeConsumer(this);
@@ -105,6 +153,12 @@ public class BDImageConsumer extends BDImage implements ImageConsumer {
             notifyObservers(this, ImageObserver.FRAMEBITS, 0, 0, width, height);
             break;
         case STATICIMAGEDONE:
+            /* animated images are not cached */
+            if (cacheKey != null && backBuffer != null &&
+                (status & (ImageObserver.ERROR | ImageObserver.ABORT | ImageObserver.FRAMEBITS)) == 0) {
+                BDImageCache.put(cacheKey, width, height, backBuffer, properties);
+                sharedBuffer = true;
+            }
             status |= ImageObserver.ALLBITS;
             notifyObservers(this, ImageObserver.ALLBITS, 0, 0, width, height);
             break;
@@ -94,34 +94,76 @@ public class BDRootWindow extends Frame {
             }
             changeCount++;
             if (timerTask == null) {
+                /* refresh task keeps running during animation (no per-frame allocation) */
                 timerTask = new RefreshTimerTask(this);
                 timer.schedule(timerTask, 40, 40);
             }
         }
     }
 
+    /*
+     * Flush dirty area to overlay.
+     * Steady-state repaint does not allocate: dirty rectangles are copied to
+     * pre-allocated array and back buffer is passed to native code as-is.
+     */
     public void sync() {
         synchronized (this) {
-            if (timerTask != null) {
-                timerTask.cancel();
-                timerTask = null;
+            syncCount = changeCount;
+
+            if (dirty.isEmpty()) {
+                return;
             }
-            changeCount = 0;
 
-            Area a = dirty.getBounds();
+            long t0 = 0, heap0 = 0;
+            if (REPAINT_STATS) {
+                t0 = System.nanoTime();
+                heap0 = runtime.freeMemory();
+            }
+
+            int x0 = dirty.x0, y0 = dirty.y0, x1 = dirty.x1, y1 = dirty.y1;
+            int numRects = dirty.getRects(rects);
             dirty.clear();
 
-            if (!a.isEmpty()) {
-                if (!overlay_open) {
-                    Libbluray.updateGraphic(getWidth(), getHeight(), null);
-                    overlay_open = true;
-                    a = new Area(getWidth(), getHeight()); /* force full plane update */
-                }
-                Libbluray.updateGraphic(getWidth(), getHeight(), backBuffer, a.x0, a.y0, a.x1, a.y1);
+            if (!overlay_open) {
+                Libbluray.updateGraphic(getWidth(), getHeight(), null);
+                overlay_open = true;
+                /* force full plane update */
+                x0 = 0;
+                y0 = 0;
+                x1 = getWidth() - 1;
+                y1 = getHeight() - 1;
+                numRects = 1;
+            }
+            if (numRects > 1) {
+                /* report separate damaged regions */
+                Libbluray.updateGraphic(getWidth(), getHeight(), backBuffer, rects, numRects);
+            } else {
+                Libbluray.updateGraphic(getWidth(), getHeight(), backBuffer, x0, y0, x1, y1);
+            }
+
+            if (REPAINT_STATS) {
+                updateStats(System.nanoTime() - t0, heap0 - runtime.freeMemory());
             }
         }
     }
 
+    /* repaint instrumentation (-Ddebug.repaint.stats=YES) */
+    private void updateStats(long time, long allocated) {
+        statFrames++;
+        statTime += time;
+        if (allocated > 0) {
+            /* approximate: heap usage grows only by allocations (unless GC ran) */
+            statAllocated += allocated;
+        }
+        if (statFrames >= 100) {
+            logger.info("repaint: " + statFrames + " frames, " + (statTime / statFrames / 1000) + " us/frame, " +
+                        (statAllocated / statFrames) + " bytes allocated/frame");
+            statFrames = 0;
+            statTime = 0;
+            statAllocated = 0;
+        }
+    }
+
     private class RefreshTimerTask extends TimerTask {
         public RefreshTimerTask(BDRootWindow window) {
             this.window = window;
@@ -130,6 +172,17 @@ public class BDRootWindow extends Frame {
 
         public void run() {
             synchronized (window) {
+                if (window.changeCount == window.syncCount) {
+                    /* stop after idle period */
+                    if (++idleTicks >= 25) {
+                        cancel();
+                        if (window.timerTask == this) {
+                            window.timerTask = null;
+                        }
+                    }
+                    return;
+                }
+                idleTicks = 0;
                 if (this.changeCount == window.changeCount)
                     window.sync();
                 else
@@ -139,6 +192,7 @@ public class BDRootWindow extends Frame {
 
         private BDRootWindow window;
         private int changeCount;
+        private int idleTicks = 0;
     }
 
     private void close() {
@@ -197,12 +251,20 @@ public class BDRootWindow extends Frame {
 
     private int[] backBuffer = null;
     private Area dirty = new Area();
+    private int[] rects = new int[Area.MAX_RECTS * 4];
     private int changeCount = 0;
+    private int syncCount = 0;
     private Timer timer = new Timer();
     private TimerTask timerTask = null;
     private boolean overlay_open = false;
     private Font defaultFont = null;
 
+    private static final boolean REPAINT_STATS = "YES".equalsIgnoreCase(System.getProperty("debug.repaint.stats"));
+    private static final Runtime runtime = Runtime.getRuntime();
+    private int  statFrames = 0;
+    private long statTime = 0;
+    private long statAllocated = 0;
+
     private static final Logger logger = Logger.getLogger(BDRootWindow.class.getName());
 
     private static final long serialVersionUID = -8325961861529007953L;
@@ -74,6 +74,7 @@ abstract class BDToolkitBase extends Toolkit {
         }
         */
         cachedImages.clear();
+        BDImageCache.clear();
         contextMap.clear();
     }
 
@@ -156,13 +157,13 @@ abstract class BDToolkitBase extends Toolkit {
         }
 
         ImageProducer ip = new FileImageSource(filename);
-        Image newImage = createImage(ip);
+        Image newImage = new BDImageConsumer(ip, BDImageCache.getKey(filename));
         return newImage;
     }
 
     public Image createImage(URL url) {
         ImageProducer ip = new URLImageSource(url);
-        Image newImage = createImage(ip);
+        Image newImage = new BDImageConsumer(ip, BDImageCache.getKey(url));
         return newImage;
     }
 
@@ -20,6 +20,10 @@ package org.videolan;
 
 public class BDJActionManager {
     protected static void createInstance() {
+        if (instance != null) {
+            /* kept running by shutdownDisc() */
+            return;
+        }
         if (running) {
             System.err.println("BDJActionManager: manager already running! " + Logger.dumpStack());
             return;
@@ -41,6 +45,15 @@ public class BDJActionManager {
         } catch (Throwable t) {
         } finally {
             running = false;
+            instance = null;
+        }
+    }
+
+    /* complete pending actions, but keep queue thread running for next disc */
+    protected static void shutdownDisc() {
+        try {
+            instance.commandQueue.flush();
+        } catch (Throwable t) {
         }
     }
 
@@ -20,7 +20,7 @@ package org.videolan;
 
 import java.util.LinkedList;
 
-public class BDJActionQueue implements Runnable {
+public class BDJActionQueue {
     public BDJActionQueue(String name) {
         this(null, name);
     }
@@ -30,55 +30,43 @@ public class BDJActionQueue implements Runnable {
             if (BDJXletContext.getCurrentContext() != null) {
                 logger.error("BDJActionQueue created from wrong context: " + Logger.dumpStack());
             }
+            pool = BDJThreadPool.getSystemPool();
+        } else {
+            /* run all actions in given thread group / xlet context */
+            pool = threadGroup.getThreadPool();
         }
 
-        /* run all actions in given thread group / xlet context */
-        thread = new Thread(threadGroup, this, name + ".BDJActionQueue");
-        thread.setDaemon(true);
-        thread.start();
-
-        watchdog = new Watchdog(name);
+        this.name = name;
+        pool.addQueue();
     }
 
     public void shutdown() {
 
         synchronized (actions) {
+            if (terminated) {
+                return;
+            }
             terminated = true;
-            actions.addLast(null);
-            actions.notifyAll();
-        }
-        watchdog.shutdown();
-        try {
-            thread.join();
-        } catch (Throwable t) {
-            logger.error("Error joining thread: " + t);
-        }
-    }
 
-    public void run() {
-        while (true) {
-            Object action;
-            synchronized (actions) {
-                while (actions.isEmpty()) {
-                    try {
-                        actions.wait();
-                    } catch (InterruptedException e) {
-                    }
+            /* wait until all queued actions have been processed */
+            while (scheduled && runner != Thread.currentThread()) {
+                try {
+                    actions.wait();
+                } catch (InterruptedException e) {
                 }
-                action = actions.removeFirst();
-            }
-            if (action == null)
-                return;
-            try {
-                watchdog.startAction(action);
-
-                ((BDJAction)action).process();
-
-                watchdog.endAction();
-            } catch (Throwable e) {
-                System.err.println("action failed: " + e + "\n" + Logger.dumpStack(e));
             }
         }
+        pool.removeQueue();
+    }
+
+    /* wait until all queued actions have been processed */
+    public void flush() {
+        BDJAction marker = new BDJAction() {
+                protected void doAction() {
+                }
+            };
+        put(marker);
+        marker.waitEnd();
     }
 
     public void put(BDJAction action) {
@@ -86,79 +74,58 @@ public class BDJActionQueue implements Runnable {
             synchronized (actions) {
                 if (!terminated) {
                     actions.addLast(action);
-                    actions.notifyAll();
+                    if (scheduled) {
+                        return;
+                    }
+                    scheduled = true;
                 } else {
                     logger.error("Action skipped (queue stopped): " + action);
                     action.abort();
+                    return;
                 }
             }
+            pool.schedule(this);
         }
     }
 
-    private boolean terminated = false;
-    private Thread thread;
-    private LinkedList actions = new LinkedList();
-
-    private static final Logger logger = Logger.getLogger(BDJActionQueue.class.getName());
-
     /*
-     *
+     * called from thread pool
      */
 
-    private Watchdog watchdog = null;
-
-    class Watchdog implements Runnable {
-
-        private Object currentAction = null;
-        private boolean terminate = false;
-
-        Watchdog(String name) {
-            Thread t = new Thread(null, this, name + ".BDJActionQueue.Monitor");
-            t.setDaemon(true);
-            t.start();
-        }
-
-        public synchronized void shutdown() {
-            terminate = true;
-            notifyAll();
-        }
-
-        public synchronized void startAction(Object action) {
-            currentAction = action;
-            notifyAll();
+    /* get next action, or null if queue is empty */
+    protected BDJAction takeAction() {
+        synchronized (actions) {
+            if (actions.isEmpty()) {
+                return null;
+            }
+            runner = Thread.currentThread();
+            return (BDJAction)actions.removeFirst();
         }
+    }
 
-        public synchronized void endAction() {
-            currentAction = null;
-            notifyAll();
+    /* returns true if queue has more actions and needs to be re-scheduled */
+    protected boolean actionDone() {
+        synchronized (actions) {
+            runner = null;
+            if (!actions.isEmpty()) {
+                return true;
+            }
+            scheduled = false;
+            actions.notifyAll();
+            return false;
         }
+    }
 
-        public void run() {
-            Object loggedAction = null;
-            synchronized (this) {
-                while (!terminate) {
+    public String toString() {
+        return name + ".BDJActionQueue";
+    }
 
-                    if (loggedAction != null && currentAction != loggedAction) {
-                        loggedAction = null;
-                        logger.info("Callback returned (" + thread + ")");
-                    }
+    private final String name;
+    private final BDJThreadPool pool;
+    private boolean terminated = false;
+    private boolean scheduled = false;  /* in thread pool run queue or being processed */
+    private Thread runner = null;
+    private LinkedList actions = new LinkedList();
 
-                    try {
-                        if (currentAction == null) {
-                            wait();
-                        } else {
-                            Object cachedAction = currentAction;
-                            wait(5000);
-                            if (currentAction == cachedAction && loggedAction != cachedAction) {
-                                logger.error("Callback timeout in " + thread + ", callback=" + currentAction + "\n" +
-                                             PortingHelper.dumpStack(thread));
-                                loggedAction = cachedAction;
-                            }
-                        }
-                    } catch (InterruptedException e) {
-                    }
-                }
-            }
-        }
-    }
+    private static final Logger logger = Logger.getLogger(BDJActionQueue.class.getName());
 }
@@ -287,6 +287,8 @@ class BDJAppProxy implements DVBJProxy, Runnable {
     }
 
     public void run() {
+        Libbluray.threadStarted();
+
         if (context.getEventQueue() == null)
             context.setEventQueue(new EventQueue());
 
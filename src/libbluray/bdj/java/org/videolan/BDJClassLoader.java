@@ -28,6 +28,8 @@ import java.net.URL;
 import java.net.URLClassLoader;
 import java.util.ArrayList;
 import java.util.Enumeration;
+import java.util.jar.JarEntry;
+import java.util.jar.JarFile;
 
 import javax.tv.xlet.Xlet;
 
@@ -45,7 +47,9 @@ public class BDJClassLoader extends URLClassLoader {
             if ((url != null) && (classPath.indexOf(url) < 0))
                 classPath.add(url);
         }
-        return new BDJClassLoader((URL[])classPath.toArray(new URL[classPath.size()]) , xletClass);
+        BDJClassLoader loader = new BDJClassLoader((URL[])classPath.toArray(new URL[classPath.size()]) , xletClass);
+        loader.preload();
+        return loader;
     }
 
     private static URL translateClassPath(AppCache[] appCaches, String basePath, String classPath) {
@@ -156,5 +160,78 @@ public class BDJClassLoader extends URLClassLoader {
         return super.getResourceAsStream(name);
     }
 
+    /*
+     * Background class loading.
+     * Enabled with system property org.videolan.preload=YES.
+     * All classes of class path JAR files are loaded (but not initialized) in parallel,
+     * one thread for each JAR file, while xlet is starting.
+     */
+
+    private void preload() {
+        String enable = System.getProperty("org.videolan.preload");
+        if (enable == null || !enable.equals("YES")) {
+            return;
+        }
+
+        URL[] urls = getURLs();
+        for (int i = 0; i < urls.length; i++) {
+            if (urls[i].getProtocol().equals("file") && urls[i].getPath().endsWith(".jar")) {
+                final String path = urls[i].getPath();
+                Thread t = new Thread(new Runnable() {
+                        public void run() {
+                            preloadJar(path);
+                        }
+                    }, "BDJClassLoader.preload");
+                t.setDaemon(true);
+                t.setPriority(Thread.MIN_PRIORITY);
+                t.start();
+            }
+        }
+    }
+
+    private void preloadJar(String path) {
+        ArrayList classes = new ArrayList();
+        JarFile jar = null;
+        try {
+            jar = new JarFile(path, false);
+            for (Enumeration e = jar.entries(); e.hasMoreElements(); ) {
+                String name = ((JarEntry)e.nextElement()).getName();
+                if (name.endsWith(".class")) {
+                    classes.add(name.substring(0, name.length() - 6).replace('/', '.'));
+                }
+            }
+        } catch (IOException e) {
+            logger.error("preload: error reading " + path + ": " + e);
+            return;
+        } finally {
+            if (jar != null) {
+                try {
+                    jar.close();
+                } catch (IOException e) {
+                }
+            }
+        }
+
+        long time = System.currentTimeMillis();
+        int count = 0;
+        for (int i = 0; i < classes.size() && !preloadStopped; i++) {
+            try {
+                Class.forName((String)classes.get(i), false, this);
+                count++;
+            } catch (Throwable t) {
+                /* class will be loaded (and error reported) when xlet uses it */
+            }
+        }
+        logger.info("preload: loaded " + count + "/" + classes.size() + " classes from " + path +
+                    " in " + (System.currentTimeMillis() - time) + " ms");
+    }
+
+    protected void stopPreload() {
+        preloadStopped = true;
+    }
+
+    private volatile boolean preloadStopped = false;
     private String xletClass;
+
+    private static final Logger logger = Logger.getLogger(BDJClassLoader.class.getName());
 }
@@ -114,6 +114,18 @@ public class BDJLoader {
         vfsCache = null;
     }
 
+    /* complete pending actions, but keep queue thread running for next disc */
+    protected static void shutdownDisc() {
+        try {
+            if (queue != null) {
+                queue.flush();
+            }
+        } catch (Throwable e) {
+            logger.error("shutdownDisc() failed: " + e + "\n" + Logger.dumpStack(e));
+        }
+        vfsCache = null;
+    }
+
     private static boolean loadN(TitleImpl title, boolean restart) {
 
         if (vfsCache == null) {
@@ -53,6 +53,18 @@ public class BDJThreadGroup extends ThreadGroup {
         this.context = context;
     }
 
+    /* worker threads for BDJActionQueues of this context */
+    protected synchronized BDJThreadPool getThreadPool() {
+        if (threadPool == null) {
+            threadPool = new BDJThreadPool(this, getName());
+        }
+        return threadPool;
+    }
+
+    protected synchronized int numPoolThreads() {
+        return (threadPool == null) ? 0 : threadPool.numThreads();
+    }
+
     public boolean waitForShutdown(int timeout, int maxThreads) {
 
         if (parentOf(Thread.currentThread().getThreadGroup()) && maxThreads < 1) {
@@ -78,6 +90,15 @@ public class BDJThreadGroup extends ThreadGroup {
 
     protected void stopAll(int timeout) {
 
+        BDJThreadPool pool;
+        synchronized (this) {
+            pool = threadPool;
+            threadPool = null;
+        }
+        if (pool != null) {
+            pool.shutdown();
+        }
+
         interrupt();
         waitForShutdown(timeout, 0);
 
@@ -116,5 +137,6 @@ public class BDJThreadGroup extends ThreadGroup {
     }
 
     private BDJXletContext context;
+    private BDJThreadPool threadPool = null;
     private static final Logger logger = Logger.getLogger(BDJThreadGroup.class.getName());
 }
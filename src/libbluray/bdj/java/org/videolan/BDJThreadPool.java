@@ -0,0 +1,325 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2014  Petri Hintukainen <phintuka@users.sourceforge.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+package org.videolan;
+
+import java.security.AccessController;
+import java.security.PrivilegedAction;
+import java.util.Iterator;
+import java.util.LinkedList;
+
+/*
+ * Worker threads for BDJActionQueues.
+ *
+ * Each queue is processed serially (by at most one thread at a time).
+ * All queues of one thread group (xlet context) share one pool, and all
+ * libbluray internal queues share the system pool.
+ *
+ * Worker threads are started on demand and exit when idle. Number of threads
+ * is limited to org.videolan.threadpool.size. If all workers are blocked in
+ * callbacks, monitor thread starts more workers (at most one per queue), so
+ * blocking callback in one queue can't stall processing of other queues.
+ */
+
+class BDJThreadPool {
+
+    protected static synchronized BDJThreadPool getSystemPool() {
+        if (systemPool == null) {
+            systemPool = new BDJThreadPool(Thread.currentThread().getThreadGroup(), "System");
+        }
+        return systemPool;
+    }
+
+    protected BDJThreadPool(ThreadGroup group, String name) {
+        this.group = group;
+        this.name = name;
+
+        synchronized (pools) {
+            pools.add(this);
+        }
+    }
+
+    /* queues */
+
+    protected synchronized void addQueue() {
+        numQueues++;
+    }
+
+    protected synchronized void removeQueue() {
+        numQueues--;
+    }
+
+    /* called when queue has new actions */
+    protected synchronized void schedule(BDJActionQueue queue) {
+        ready.addLast(queue);
+        if (idleWorkers > 0) {
+            notify();
+        } else if (workers.size() < maxThreads) {
+            startWorker();
+        }
+    }
+
+    protected synchronized int numThreads() {
+        return workers.size();
+    }
+
+    /* stop all workers (all queues must have been shut down) */
+    protected void shutdown() {
+        Thread[] threads;
+        synchronized (this) {
+            terminated = true;
+            notifyAll();
+
+            threads = new Thread[workers.size()];
+            Iterator it = workers.iterator();
+            for (int i = 0; it.hasNext(); i++) {
+                threads[i] = ((Worker)it.next()).thread;
+            }
+        }
+
+        for (int i = 0; i < threads.length; i++) {
+            if (threads[i] == Thread.currentThread()) {
+                continue;
+            }
+            try {
+                threads[i].join(1000);
+            } catch (InterruptedException e) {
+            }
+        }
+
+        synchronized (pools) {
+            pools.remove(this);
+        }
+    }
+
+    /*
+     *
+     */
+
+    /* must be called from synchronized (this) {} */
+    private void startWorker() {
+        if (terminated) {
+            logger.error("thread pool " + name + " is terminated");
+            return;
+        }
+
+        final Worker worker = new Worker();
+        final int num = ++workerCount;
+        worker.thread = (Thread)AccessController.doPrivileged(new PrivilegedAction() {
+                public Object run() {
+                    Thread t = new Thread(group, worker, name + ".BDJThreadPool." + num, stackSize);
+                    t.setDaemon(true);
+                    t.setPriority(Thread.NORM_PRIORITY);
+                    return t;
+                }
+            });
+        workers.add(worker);
+        worker.thread.start();
+    }
+
+    /* called from monitor thread. Returns true if some actions are being processed. */
+    private synchronized boolean check(long now) {
+        int  busy = 0;
+        long oldest = now;
+
+        Iterator it = workers.iterator();
+        while (it.hasNext()) {
+            Worker w = (Worker)it.next();
+            if (w.action == null) {
+                continue;
+            }
+
+            busy++;
+            oldest = Math.min(oldest, w.startTime);
+
+            if (now - w.startTime > CALLBACK_TIMEOUT && w.loggedAction != w.action) {
+                logger.error("Callback timeout in " + w.thread + ", callback=" + w.action + "\n" +
+                             PortingHelper.dumpStack(w.thread));
+                w.loggedAction = w.action;
+            }
+        }
+
+        /* all workers are blocked and there are queues waiting */
+        if (!ready.isEmpty() && idleWorkers == 0 && busy >= workers.size() &&
+            now - oldest > BLOCKED_DELAY && workers.size() < numQueues) {
+            logger.info("all " + name + " workers are busy, starting new worker");
+            startWorker();
+        }
+
+        return busy > 0;
+    }
+
+    /* called when worker starts processing an action */
+    private static void wakeMonitor() {
+        final ThreadGroup systemGroup = getSystemPool().group;
+        synchronized (pools) {
+            if (monitorActive) {
+                return;
+            }
+            if (monitor == null) {
+                monitor = (Thread)AccessController.doPrivileged(new PrivilegedAction() {
+                        public Object run() {
+                            Thread t = new Thread(systemGroup, new Monitor(), "BDJThreadPool.Monitor");
+                            t.setDaemon(true);
+                            return t;
+                        }
+                    });
+                monitor.start();
+            }
+            monitorActive = true;
+            pools.notifyAll();
+        }
+    }
+
+    /*
+     *
+     */
+
+    private class Worker implements Runnable {
+        Thread thread;
+        BDJAction action = null;
+        BDJAction loggedAction = null;
+        long startTime;
+
+        private BDJActionQueue nextQueue() {
+            synchronized (BDJThreadPool.this) {
+                if (ready.isEmpty() && !terminated) {
+                    idleWorkers++;
+                    try {
+                        BDJThreadPool.this.wait(IDLE_TIMEOUT);
+                    } catch (InterruptedException e) {
+                    }
+                    idleWorkers--;
+                }
+                /* exit when idle */
+                if (ready.isEmpty() || terminated) {
+                    workers.remove(this);
+                    return null;
+                }
+                return (BDJActionQueue)ready.removeFirst();
+            }
+        }
+
+        public void run() {
+            BDJActionQueue queue;
+
+            Libbluray.threadStarted();
+
+            while ((queue = nextQueue()) != null) {
+                BDJAction a = queue.takeAction();
+                if (a != null) {
+                    synchronized (BDJThreadPool.this) {
+                        action = a;
+                        startTime = System.currentTimeMillis();
+                    }
+                    wakeMonitor();
+
+                    try {
+                        a.process();
+                    } catch (Throwable e) {
+                        System.err.println("action failed: " + e + "\n" + Logger.dumpStack(e));
+                    }
+
+                    synchronized (BDJThreadPool.this) {
+                        action = null;
+                        if (loggedAction == a) {
+                            logger.info("Callback returned (" + thread + ")");
+                            loggedAction = null;
+                        }
+                    }
+                }
+
+                /* round-robin between queues: re-schedule if there are more actions */
+                if (queue.actionDone()) {
+                    synchronized (BDJThreadPool.this) {
+                        ready.addLast(queue);
+                    }
+                }
+            }
+        }
+    }
+
+    private static class Monitor implements Runnable {
+        public void run() {
+            Libbluray.threadStarted();
+
+            synchronized (pools) {
+                while (true) {
+                    try {
+                        if (monitorActive) {
+                            pools.wait(CHECK_INTERVAL);
+                        } else {
+                            pools.wait();
+                        }
+                    } catch (InterruptedException e) {
+                    }
+
+                    long now = System.currentTimeMillis();
+                    boolean busy = false;
+                    Iterator it = pools.iterator();
+                    while (it.hasNext()) {
+                        busy |= ((BDJThreadPool)it.next()).check(now);
+                    }
+                    monitorActive = busy;
+                }
+            }
+        }
+    }
+
+    /*
+     *
+     */
+
+    private static int getIntProperty(String name, int defaultValue, int minValue) {
+        try {
+            String value = System.getProperty(name);
+            if (value != null) {
+                return Math.max(minValue, Integer.parseInt(value));
+            }
+        } catch (Exception e) {
+            logger.error("invalid " + name + ": " + e);
+        }
+        return defaultValue;
+    }
+
+    private final ThreadGroup group;
+    private final String name;
+    private LinkedList ready = new LinkedList();
+    private LinkedList workers = new LinkedList();
+    private int idleWorkers = 0;
+    private int workerCount = 0;
+    private int numQueues = 0;
+    private boolean terminated = false;
+
+    private static final Logger logger = Logger.getLogger(BDJThreadPool.class.getName());
+
+    private static BDJThreadPool systemPool = null;
+    private static LinkedList pools = new LinkedList();
+    private static Thread monitor = null;
+    private static boolean monitorActive = false;
+
+    /* configured with -D (see _create_jvm() in bdj.c) */
+    private static final int  maxThreads = getIntProperty("org.videolan.threadpool.size", 2, 1);
+    private static final long stackSize  = 1024L * getIntProperty("org.videolan.threadpool.stack", 0, 0);
+
+    private static final long IDLE_TIMEOUT     = 5000;
+    private static final long CHECK_INTERVAL   = 100;
+    private static final long BLOCKED_DELAY    = 100;
+    private static final long CALLBACK_TIMEOUT = 5000;
+}
@@ -242,9 +242,10 @@ public class BDJXletContext implements javax.tv.xlet.XletContext, javax.microedi
                 cnt++;
             }
         }
-        if (!released) {
-            // callbackQueue, userEventQueue, mediaQueue
-            cnt += 3;
+        BDJThreadGroup group = threadGroup;
+        if (!released && group != null) {
+            // callbackQueue, userEventQueue, mediaQueue workers
+            cnt += group.numPoolThreads();
         }
         return cnt;
     }
@@ -461,6 +462,7 @@ public class BDJXletContext implements javax.tv.xlet.XletContext, javax.microedi
 
         threadGroup.stopAll(1000);
 
+        loader.stopPreload();
         try {
             Method m;
             m = loader.getClass().getMethod("close", new Class[0]);
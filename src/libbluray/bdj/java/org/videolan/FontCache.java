@@ -0,0 +1,345 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2014  Petri Hintukainen <phintuka@users.sourceforge.net>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+package org.videolan;
+
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.BufferedInputStream;
+import java.io.BufferedOutputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.security.AccessController;
+import java.security.PrivilegedAction;
+import java.util.zip.CRC32;
+
+import org.bluray.ti.Disc;
+import org.bluray.ti.DiscManager;
+
+/*
+ * Persistent cache of disc fonts.
+ *
+ * Parsed font index and copies of font files are stored in
+ * <persistent root>/.fontcache/<disc id>/ and re-used when the same disc
+ * is played again.
+ * Font index is validated with size and CRC of dvb.fontindex.
+ * Font files are validated with size and modification time of the
+ * BD-ROM file (when disc is not in UDF image).
+ */
+
+class FontCache {
+
+    /*
+     * font index
+     */
+
+    protected static FontIndexData[] readIndex(final String indexPath) {
+        return (FontIndexData[])AccessController.doPrivileged(new PrivilegedAction() {
+                public Object run() {
+                    return readIndexImpl(indexPath);
+                }
+            });
+    }
+
+    protected static void writeIndex(final String indexPath, final FontIndexData[] data) {
+        AccessController.doPrivileged(new PrivilegedAction() {
+                public Object run() {
+                    writeIndexImpl(indexPath, data);
+                    return null;
+                }
+            });
+    }
+
+    /*
+     * font files
+     *
+     * relPath: path of font file in BD-ROM
+     * srcPath: path of font file in local filesystem, or null if disc is in UDF image
+     * return:  valid cached copy of the font file, or null
+     */
+
+    protected static File cacheFont(final String relPath, final String srcPath) {
+        return (File)AccessController.doPrivileged(new PrivilegedAction() {
+                public Object run() {
+                    return cacheFontImpl(relPath, srcPath);
+                }
+            });
+    }
+
+    /*
+     *
+     */
+
+    private static File getDiscDir() {
+        String disable = System.getProperty("org.videolan.fontcache");
+        if (disable != null && disable.equals("NO")) {
+            return null;
+        }
+
+        String root = System.getProperty("dvb.persistent.root");
+        if (root == null) {
+            return null;
+        }
+
+        Disc disc = DiscManager.getDiscManager().getCurrentDisc();
+        String id = (disc == null) ? null : disc.getId();
+        if (id == null || id.length() < 1 || id.charAt(0) == '0') {
+            /* disc ID is not known (leading zeros are stripped) */
+            return null;
+        }
+
+        File baseDir = new File(root, ".fontcache");
+        File discDir = new File(baseDir, id);
+        if (!discDir.isDirectory()) {
+            if (!discDir.mkdirs()) {
+                logger.error("Error creating font cache directory " + discDir);
+                return null;
+            }
+            pruneDiscDirs(baseDir);
+        }
+        discDir.setLastModified(System.currentTimeMillis());
+
+        return discDir;
+    }
+
+    /* keep fonts of MAX_DISCS most recently used discs */
+    private static void pruneDiscDirs(File baseDir) {
+        File[] dirs = baseDir.listFiles();
+        if (dirs == null || dirs.length <= MAX_DISCS) {
+            return;
+        }
+
+        for (int n = dirs.length; n > MAX_DISCS; n--) {
+            File oldest = null;
+            for (int i = 0; i < dirs.length; i++) {
+                if (dirs[i] != null && (oldest == null || dirs[i].lastModified() < oldest.lastModified())) {
+                    oldest = dirs[i];
+                }
+            }
+            if (oldest == null) {
+                break;
+            }
+
+            File[] files = oldest.listFiles();
+            if (files != null) {
+                for (int i = 0; i < files.length; i++) {
+                    files[i].delete();
+                }
+            }
+            oldest.delete();
+
+            for (int i = 0; i < dirs.length; i++) {
+                if (dirs[i] == oldest) {
+                    dirs[i] = null;
+                }
+            }
+        }
+    }
+
+    private static long fileCrc(File file) {
+        InputStream is = null;
+        try {
+            CRC32 crc = new CRC32();
+            byte[] buffer = new byte[8192];
+            int length;
+            is = new FileInputStream(file);
+            while ((length = is.read(buffer)) > 0) {
+                crc.update(buffer, 0, length);
+            }
+            return crc.getValue();
+        } catch (IOException e) {
+            return -1;
+        } finally {
+            if (is != null) {
+                try {
+                    is.close();
+                } catch (IOException e) {
+                }
+            }
+        }
+    }
+
+    private static String readString(DataInputStream is) throws IOException {
+        if (!is.readBoolean()) {
+            return null;
+        }
+        return is.readUTF();
+    }
+
+    private static void writeString(DataOutputStream os, String s) throws IOException {
+        os.writeBoolean(s != null);
+        if (s != null) {
+            os.writeUTF(s);
+        }
+    }
+
+    private static FontIndexData[] readIndexImpl(String indexPath) {
+        File discDir = getDiscDir();
+        File srcFile = new File(indexPath);
+        if (discDir == null || !srcFile.isFile()) {
+            return null;
+        }
+
+        File cacheFile = new File(discDir, INDEX_FILE);
+        if (!cacheFile.isFile()) {
+            return null;
+        }
+
+        DataInputStream is = null;
+        try {
+            is = new DataInputStream(new BufferedInputStream(new FileInputStream(cacheFile)));
+
+            if (is.readInt() != INDEX_MAGIC || is.readInt() != INDEX_VERSION) {
+                return null;
+            }
+            if (is.readLong() != srcFile.length() || is.readLong() != fileCrc(srcFile)) {
+                logger.info("font index of disc changed");
+                return null;
+            }
+
+            int count = is.readInt();
+            if (count < 0 || count > 0xffff) {
+                return null;
+            }
+            FontIndexData[] data = new FontIndexData[count];
+            for (int i = 0; i < count; i++) {
+                data[i] = new FontIndexData();
+                data[i].name     = readString(is);
+                data[i].format   = readString(is);
+                data[i].filename = readString(is);
+                data[i].style    = is.readInt();
+                data[i].minSize  = is.readInt();
+                data[i].maxSize  = is.readInt();
+            }
+
+            logger.info("using cached font index (" + count + " fonts)");
+            return data;
+
+        } catch (IOException e) {
+            logger.error("Error reading cached font index: " + e);
+            return null;
+
+        } finally {
+            if (is != null) {
+                try {
+                    is.close();
+                } catch (IOException e) {
+                }
+            }
+        }
+    }
+
+    private static void writeIndexImpl(String indexPath, FontIndexData[] data) {
+        File discDir = getDiscDir();
+        File srcFile = new File(indexPath);
+        if (discDir == null || !srcFile.isFile()) {
+            return;
+        }
+
+        File cacheFile = new File(discDir, INDEX_FILE);
+        File tmpFile   = new File(discDir, INDEX_FILE + ".tmp");
+
+        DataOutputStream os = null;
+        boolean ok = false;
+        try {
+            os = new DataOutputStream(new BufferedOutputStream(new FileOutputStream(tmpFile)));
+
+            os.writeInt(INDEX_MAGIC);
+            os.writeInt(INDEX_VERSION);
+            os.writeLong(srcFile.length());
+            os.writeLong(fileCrc(srcFile));
+
+            os.writeInt(data.length);
+            for (int i = 0; i < data.length; i++) {
+                writeString(os, data[i].name);
+                writeString(os, data[i].format);
+                writeString(os, data[i].filename);
+                os.writeInt(data[i].style);
+                os.writeInt(data[i].minSize);
+                os.writeInt(data[i].maxSize);
+            }
+            ok = true;
+
+        } catch (IOException e) {
+            logger.error("Error writing cached font index: " + e);
+
+        } finally {
+            if (os != null) {
+                try {
+                    os.close();
+                } catch (IOException e) {
+                    ok = false;
+                }
+            }
+        }
+
+        cacheFile.delete();
+        if (!ok || !tmpFile.renameTo(cacheFile)) {
+            tmpFile.delete();
+        }
+    }
+
+    private static File cacheFontImpl(String relPath, String srcPath) {
+        File discDir = getDiscDir();
+        if (discDir == null) {
+            return null;
+        }
+
+        File srcFile   = (srcPath == null) ? null : new File(srcPath);
+        File cacheFile = new File(discDir, new File(relPath).getName());
+
+        if (cacheFile.isFile()) {
+            /* BD-ROM content does not change for the same disc ID.
+               Check file size and timestamp when those are available. */
+            if (srcFile == null ||
+                (cacheFile.length() == srcFile.length() && cacheFile.lastModified() == srcFile.lastModified())) {
+                return cacheFile;
+            }
+            logger.info("cached font " + cacheFile.getName() + " is stale");
+            cacheFile.delete();
+        }
+
+        /* copy to temporary file: only complete fonts are found from the cache */
+        File tmpFile = new File(discDir, cacheFile.getName() + ".tmp");
+        if (!Libbluray.cacheBdRomFile(relPath, tmpFile.getPath())) {
+            tmpFile.delete();
+            return null;
+        }
+        if (srcFile != null) {
+            tmpFile.setLastModified(srcFile.lastModified());
+        }
+        if (!tmpFile.renameTo(cacheFile)) {
+            tmpFile.delete();
+            return null;
+        }
+
+        logger.info("cached font " + cacheFile.getName() + " to persistent storage");
+        return cacheFile;
+    }
+
+    private static final String INDEX_FILE = "fontindex.bin";
+    private static final int INDEX_MAGIC   = 0x42444a46; /* "BDJF" */
+    private static final int INDEX_VERSION = 1;
+    private static final int MAX_DISCS     = 16;
+
+    private static final Logger logger = Logger.getLogger(FontCache.class.getName());
+}
@@ -36,7 +36,12 @@ import org.xml.sax.helpers.DefaultHandler;
 
 public class FontIndex extends DefaultHandler implements EntityResolver{
     public static FontIndexData[] parseIndex(String path) {
-        return new FontIndex(path).getFontIndexData();
+        FontIndexData[] data = FontCache.readIndex(path);
+        if (data == null) {
+            data = new FontIndex(path).getFontIndexData();
+            FontCache.writeIndex(path, data);
+        }
+        return data;
     }
 
     private FontIndex(String path) {
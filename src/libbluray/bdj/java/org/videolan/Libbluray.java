@@ -24,6 +24,7 @@ import java.awt.BDFontMetrics;
 import java.awt.BDToolkit;
 import java.awt.event.KeyEvent;
 import java.io.File;
+import java.util.Hashtable;
 import java.util.Vector;
 
 import javax.media.PackageManager;
@@ -195,15 +196,23 @@ public class Libbluray {
         }
     }
 
-    /* called only from native code */
-    private static void shutdown() {
+    /* called only from native code.
+     * warm: keep action queue threads, FreeType library and system fonts
+     * for next disc. Only disc state is released.
+     */
+    private static void shutdown(boolean warm) {
         if (nativePointer == 0) {
             return;
         }
         try {
             stopTitle(true);
-            BDJLoader.shutdown();
-            BDJActionManager.shutdown();
+            if (warm) {
+                BDJLoader.shutdownDisc();
+                BDJActionManager.shutdownDisc();
+            } else {
+                BDJLoader.shutdown();
+                BDJActionManager.shutdown();
+            }
 
             /* all Xlet contexts (and threads) should be terminated now */
             try {
@@ -215,7 +224,11 @@ public class Libbluray {
             MountManager.unmountAll();
             GUIManager.shutdown();
             BDToolkit.shutdownDisc();
-            BDFontMetrics.shutdown();
+            if (warm) {
+                BDFontMetrics.shutdownDisc();
+            } else {
+                BDFontMetrics.shutdown();
+            }
             SIManagerImpl.shutdown();
             IxcRegistry.shutdown();
             EventManager.shutdown();
@@ -226,8 +239,10 @@ public class Libbluray {
         } catch (Throwable e) {
             System.err.println("shutdown() failed: " + e + "\n" + Logger.dumpStack(e));
         }
+        psrMirror = null;
         nativePointer = 0;
         titleInfos = null;
+        playlistInfos.clear();
     }
 
     /*
@@ -243,12 +258,37 @@ public class Libbluray {
         return cacheBdRomFileN(nativePointer, path, cachePath) == 0;
     }
 
+    /* start copying file in background */
+    protected static boolean cacheBdRomFileAsync(String path, String cachePath) {
+        return cacheBdRomFileAsyncN(nativePointer, path, cachePath) == 0;
+    }
+
+    /* wait until background copy of cachePath is complete */
+    protected static void waitBdRomFile(String cachePath) {
+        waitBdRomFileN(nativePointer, cachePath);
+    }
+
     protected static void setUOMask(boolean menuCallMask, boolean titleSearchMask) {
         setUOMaskN(nativePointer, menuCallMask, titleSearchMask);
     }
 
+    /* run application thread start hook. Called at start of library-created threads. */
+    protected static void threadStarted() {
+        try {
+            threadStartedN(Thread.currentThread().getName());
+        } catch (Throwable t) {
+            /* native methods are not registered (libbluray closed) */
+        }
+    }
+
     protected static int setVirtualPackage(String vpPath, boolean initBackupRegs) {
-        return setVirtualPackageN(nativePointer, vpPath, initBackupRegs);
+        int result = setVirtualPackageN(nativePointer, vpPath, initBackupRegs);
+
+        /* disc content changed */
+        titleInfos = null;
+        playlistInfos.clear();
+
+        return result;
     }
 
     /*
@@ -296,8 +336,17 @@ public class Libbluray {
         return getAacsDataN(nativePointer, type);
     }
 
+    /* cached until disc or virtual package changes. Returned objects are shared: do not modify. */
     public static PlaylistInfo getPlaylistInfo(int playlist) {
-        return getPlaylistInfoN(nativePointer, playlist);
+        Integer key = new Integer(playlist);
+        PlaylistInfo pi = (PlaylistInfo)playlistInfos.get(key);
+        if (pi == null) {
+            pi = getPlaylistInfoN(nativePointer, playlist);
+            if (pi != null) {
+                playlistInfos.put(key, pi);
+            }
+        }
+        return pi;
     }
 
     public static Bdjo getBdjo(String name) {
@@ -410,6 +459,11 @@ public class Libbluray {
         if (num < 0 || (num >= 128))
             throw new IllegalArgumentException("Invalid PSR");
 
+        /* backup registers (36-44) are modified without change notification */
+        int[] mirror = psrMirror;
+        if (mirror != null && (num < 36 || num > 44))
+            return mirror[num];
+
         return readPSRN(nativePointer, num);
     }
 
@@ -428,6 +482,11 @@ public class Libbluray {
                        x0, y0, x1, y1);
     }
 
+    /* rects: x0, y0, x1, y1 of each changed rectangle */
+    public static void updateGraphic(int width, int height, int[] rgbArray, int[] rects, int numRects) {
+        updateGraphicRectsN(nativePointer, width, height, rgbArray, rects, numRects);
+    }
+
     /*
      * Events from native side
      */
@@ -466,6 +525,13 @@ public class Libbluray {
     }
 
     /* called only from native code */
+    /* called only from native code. events: count * (event, param) */
+    private static void processEvents(int[] events, int count) {
+        for (int i = 0; i < count; i++) {
+            processEvent(events[i * 2], events[i * 2 + 1]);
+        }
+    }
+
     private static boolean processEvent(int event, int param) {
         boolean result = true;
         int key = 0;
@@ -629,11 +695,19 @@ public class Libbluray {
     private static native int setVirtualPackageN(long np, String vpPath, boolean psrBackup);
     private static native int readPSRN(long np, int num);
     private static native int cacheBdRomFileN(long np, String path, String cachePath);
+    private static native int cacheBdRomFileAsyncN(long np, String path, String cachePath);
+    private static native int waitBdRomFileN(long np, String cachePath);
     private static native String[] listBdFilesN(long np, String path, boolean onlyBdRom);
     private static native Bdjo getBdjoN(long np, String name);
     private static native void updateGraphicN(long np, int width, int height, int[] rgbArray,
                                               int x0, int y0, int x1, int y1);
+    private static native void updateGraphicRectsN(long np, int width, int height, int[] rgbArray, int[] rects, int numRects);
+    private static native void threadStartedN(String name);
 
     private static long nativePointer = 0;
     private static TitleInfo[] titleInfos = null;
+    private static final Hashtable playlistInfos = new Hashtable();
+
+    /* copy of player status registers, updated from native PSR change callback */
+    private static volatile int[] psrMirror = null;
 }
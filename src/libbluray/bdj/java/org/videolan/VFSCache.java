@@ -154,9 +154,10 @@ class VFSCache {
             return;
         }
 
-        Libbluray.cacheBdRomFile(relPath, dstPath);
+        /* class loader waits for the copy in map() */
+        Libbluray.cacheBdRomFileAsync(relPath, dstPath);
 
-        logger.info("cached " + relPath);
+        logger.info("caching " + relPath);
     }
 
     private void copyJarDir(String name, String[] files) {
@@ -167,7 +168,7 @@ class VFSCache {
             if (subFiles != null) {
                 copyJarDir(relPath, subFiles);
             } else {
-                Libbluray.cacheBdRomFile(relPath, cacheRoot + relPath);
+                Libbluray.cacheBdRomFileAsync(relPath, cacheRoot + relPath);
             }
         }
     }
@@ -181,7 +182,7 @@ class VFSCache {
             return;
         }
         copyJarDir(relPath, files);
-        logger.info("cached " + relPath);
+        logger.info("caching " + relPath);
     }
 
     /*
@@ -212,6 +213,12 @@ class VFSCache {
             return dstFile;
         }
 
+        /* re-use font from previous playback of the same disc */
+        File cachedFile = FontCache.cacheFont(relPath, cacheAll ? null : vfsRoot + relPath);
+        if (cachedFile != null) {
+            return cachedFile;
+        }
+
         if (!Libbluray.cacheBdRomFile(relPath, dstPath)) {
             return null;
         }
@@ -284,6 +291,9 @@ class VFSCache {
 
     private void accessFileImp(String absPath) {
 
+        /* file may be still copied in background */
+        Libbluray.waitBdRomFile(absPath);
+
         if (BDFileSystem.nativeFileExists(absPath)) {
             /* file is already cached */
             return;
@@ -335,6 +345,7 @@ class VFSCache {
         }
 
         String cachePath = cacheRoot + absPath.substring(vfsRootLength);
+        Libbluray.waitBdRomFile(cachePath);
         if (!BDFileSystem.nativeFileExists(cachePath)) {
             //logger.info(cachePath + " not in VFS cache");
             return absPath;
@@ -410,6 +410,81 @@ Java_java_awt_BDFontMetrics_destroyFontN(JNIEnv *env, jobject obj, jlong ftFace)
 #endif
 }
 
+/*
+ * advance width cache
+ *
+ * Widths are stored in pages of 256 characters, allocated when a character
+ * in the page is measured first time. Cache is attached to the FT_Size of
+ * the face (one size per face) and released by FT_Done_Face().
+ * Faces are used only from synchronized BDFontMetrics methods.
+ */
+
+#ifdef HAVE_FT2
+
+#define ADVANCE_PAGE_SIZE 256
+#define ADVANCE_UNKNOWN   -1
+
+typedef struct {
+    int16_t *page[0x10000 / ADVANCE_PAGE_SIZE];
+} ADVANCE_CACHE;
+
+static void _advance_cache_free(void *object)
+{
+    FT_Size        size  = (FT_Size)object;
+    ADVANCE_CACHE *cache = (ADVANCE_CACHE *)size->generic.data;
+    unsigned       i;
+
+    if (cache) {
+        for (i = 0; i < sizeof(cache->page) / sizeof(cache->page[0]); i++) {
+            X_FREE(cache->page[i]);
+        }
+        X_FREE(cache);
+        size->generic.data = NULL;
+    }
+}
+
+static int _load_advance(FT_Face face, jchar c)
+{
+    if (FT_Load_Char(face, c, FT_LOAD_DEFAULT))
+        return 0;
+    return face->glyph->metrics.horiAdvance >> 6;
+}
+
+static int _char_advance(FT_Face face, jchar c)
+{
+    ADVANCE_CACHE *cache = (ADVANCE_CACHE *)face->size->generic.data;
+    int16_t      **page;
+    unsigned       i;
+
+    if (!cache) {
+        cache = calloc(1, sizeof(ADVANCE_CACHE));
+        if (!cache) {
+            return _load_advance(face, c);
+        }
+        face->size->generic.data      = cache;
+        face->size->generic.finalizer = _advance_cache_free;
+    }
+
+    page = &cache->page[c / ADVANCE_PAGE_SIZE];
+    if (!*page) {
+        *page = malloc(ADVANCE_PAGE_SIZE * sizeof(int16_t));
+        if (!*page) {
+            return _load_advance(face, c);
+        }
+        for (i = 0; i < ADVANCE_PAGE_SIZE; i++) {
+            (*page)[i] = ADVANCE_UNKNOWN;
+        }
+    }
+
+    if ((*page)[c % ADVANCE_PAGE_SIZE] == ADVANCE_UNKNOWN) {
+        (*page)[c % ADVANCE_PAGE_SIZE] = (int16_t)_load_advance(face, c);
+    }
+
+    return (*page)[c % ADVANCE_PAGE_SIZE];
+}
+
+#endif /* HAVE_FT2 */
+
 JNIEXPORT jint JNICALL
 Java_java_awt_BDFontMetrics_charWidthN(JNIEnv * env, jobject obj, jlong ftFace, jchar c)
 {
@@ -420,9 +495,7 @@ Java_java_awt_BDFontMetrics_charWidthN(JNIEnv * env, jobject obj, jlong ftFace,
         return 0;
     }
 
-    if (FT_Load_Char(face, c, FT_LOAD_DEFAULT))
-        return 0;
-    return face->glyph->metrics.horiAdvance >> 6;
+    return _char_advance(face, c);
 #else
     return 0;
 #endif
@@ -449,9 +522,7 @@ Java_java_awt_BDFontMetrics_stringWidthN(JNIEnv * env, jobject obj, jlong ftFace
         return 0;
 
     for (i = 0, width = 0; i < length; i++) {
-        if (FT_Load_Char(face, chars[i], FT_LOAD_DEFAULT) == 0) {
-            width += face->glyph->metrics.horiAdvance >> 6;
-        }
+        width += _char_advance(face, chars[i]);
     }
 
     (*env)->ReleaseStringCritical(env, string, chars);
@@ -486,9 +557,7 @@ Java_java_awt_BDFontMetrics_charsWidthN(JNIEnv * env, jobject obj, jlong ftFace,
     }
 
     for (i = 0, width = 0; i < length; i++) {
-        if (FT_Load_Char(face, chars[i], FT_LOAD_DEFAULT) == 0) {
-            width += face->glyph->metrics.horiAdvance >> 6;
-        }
+        width += _char_advance(face, chars[i]);
     }
 
     free(chars);
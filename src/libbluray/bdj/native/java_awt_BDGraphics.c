@@ -25,6 +25,8 @@
 
 #include <jni.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #ifdef HAVE_FT2
 #include <ft2build.h>
@@ -44,51 +46,381 @@
 #define CPP_EXTERN
 #endif
 
+/*
+ * pixel kernels
+ */
+
+/* java.awt.AlphaComposite rules */
+#define RULE_CLEAR    1
+#define RULE_SRC      2
+#define RULE_SRC_OVER 3
+
+/* same as BDGraphicsBase.alphaBlend() */
+static inline uint32_t _alpha_blend(uint32_t dest, uint32_t src)
+{
+    int As = src >> 24;
+    int Ad = dest >> 24;
+    int R, G, B;
+
+    if (As == 0)
+        return dest;
+    if (As == 255 || Ad == 0)
+        return src;
+
+    R = ((src >> 16) & 255) * As * 255;
+    G = ((src >> 8) & 255) * As * 255;
+    B = (src & 255) * As * 255;
+    Ad = Ad * (255 - As);
+    As = As * 255 + Ad;
+    R = (R + ((dest >> 16) & 255) * Ad) / As;
+    G = (G + ((dest >> 8) & 255) * Ad) / As;
+    B = (B + (dest & 255) * Ad) / As;
+    R = R < 255 ? R : 255;
+    G = G < 255 ? G : 255;
+    B = B < 255 ? B : 255;
+    Ad = As / 255;
+    Ad = Ad < 255 ? Ad : 255;
+    return ((uint32_t)Ad << 24) | ((uint32_t)R << 16) | ((uint32_t)G << 8) | (uint32_t)B;
+}
+
+/* same as BDGraphicsBase.applyComposite() */
+static inline uint32_t _apply_alpha(uint32_t rgb, jfloat alpha)
+{
+    return ((uint32_t)(int)((jfloat)(rgb >> 24) * alpha) << 24) | (rgb & 0x00ffffff);
+}
+
+static int _check_area(JNIEnv *env, jintArray array, jint offset, jint stride, jint w, jint h)
+{
+    jsize length = (*env)->GetArrayLength(env, array);
+
+    if (offset < 0 || stride < w || (int64_t)offset + (int64_t)(h - 1) * stride + w > length) {
+        BD_DEBUG(DBG_JNI | DBG_CRIT, "pixel kernel: area outside of array (offset %d stride %d size %dx%d length %d)\n",
+                 (int)offset, (int)stride, (int)w, (int)h, (int)length);
+        return 0;
+    }
+    return 1;
+}
+
+static void _fill_span(uint32_t *dst, int w, uint32_t rgb, int rule)
+{
+    int i;
+
+    switch (rule) {
+        case RULE_CLEAR:
+            memset(dst, 0, w * sizeof(uint32_t));
+            break;
+        case RULE_SRC_OVER:
+            if ((rgb >> 24) == 0) {
+                break;
+            }
+            if ((rgb >> 24) != 255) {
+                for (i = 0; i < w; i++) {
+                    dst[i] = _alpha_blend(dst[i], rgb);
+                }
+                break;
+            }
+            /* opaque: same as SRC */
+            /* fall thru */
+        case RULE_SRC:
+            for (i = 0; i < w; i++) {
+                dst[i] = rgb;
+            }
+            break;
+    }
+}
+
+static void _blit_span(uint32_t *dst, const uint32_t *src, int w, int rule, jfloat alpha, int flip_x)
+{
+    int i;
+
+    switch (rule) {
+        case RULE_CLEAR:
+            memset(dst, 0, w * sizeof(uint32_t));
+            break;
+        case RULE_SRC:
+            if (flip_x) {
+                for (i = 0; i < w; i++) {
+                    dst[w - 1 - i] = _apply_alpha(src[i], alpha);
+                }
+            } else if (alpha == 1.0f) {
+                memmove(dst, src, w * sizeof(uint32_t));
+            } else {
+                for (i = 0; i < w; i++) {
+                    dst[i] = _apply_alpha(src[i], alpha);
+                }
+            }
+            break;
+        case RULE_SRC_OVER:
+            if (flip_x) {
+                for (i = 0; i < w; i++) {
+                    dst[w - 1 - i] = _alpha_blend(dst[w - 1 - i], _apply_alpha(src[i], alpha));
+                }
+            } else {
+                for (i = 0; i < w; i++) {
+                    dst[i] = _alpha_blend(dst[i], _apply_alpha(src[i], alpha));
+                }
+            }
+            break;
+    }
+}
+
+/* fill w x h area. rgb: color with composite alpha already applied. */
 JNIEXPORT void JNICALL
-Java_java_awt_BDGraphics_drawStringN(JNIEnv * env, jobject obj, jlong ftFace, jstring string, jint x, jint y, jint rgb)
+Java_java_awt_BDGraphics_fillRectN(JNIEnv * env, jclass cls, jintArray dstArray, jint dstOffset, jint dstStride,
+                                   jint w, jint h, jint rgb, jint rule)
 {
+    uint32_t *dst;
+    jint y;
+
+    if (w <= 0 || h <= 0 || !_check_area(env, dstArray, dstOffset, dstStride, w, h)) {
+        return;
+    }
+
+    dst = (uint32_t *)(*env)->GetPrimitiveArrayCritical(env, dstArray, NULL);
+    if (!dst) {
+        BD_DEBUG(DBG_JNI | DBG_CRIT, "fillRectN(): GetPrimitiveArrayCritical() failed\n");
+        return;
+    }
+
+    for (y = 0; y < h; y++) {
+        _fill_span(dst + dstOffset + y * dstStride, w, (uint32_t)rgb, rule);
+    }
+
+    (*env)->ReleasePrimitiveArrayCritical(env, dstArray, dst, 0);
+}
+
+/* copy / blend w x h area from src to dst (composite alpha is applied to source pixels) */
+JNIEXPORT void JNICALL
+Java_java_awt_BDGraphics_blitN(JNIEnv * env, jclass cls, jintArray dstArray, jint dstOffset, jint dstStride,
+                               jintArray srcArray, jint srcOffset, jint srcStride,
+                               jint w, jint h, jint rule, jfloat alpha, jboolean flipX)
+{
+    uint32_t *dst, *src;
+    jint y;
+
+    if (w <= 0 || h <= 0 ||
+        !_check_area(env, dstArray, dstOffset, dstStride, w, h) ||
+        !_check_area(env, srcArray, srcOffset, srcStride, w, h)) {
+        return;
+    }
+
+    dst = (uint32_t *)(*env)->GetPrimitiveArrayCritical(env, dstArray, NULL);
+    if (!dst) {
+        BD_DEBUG(DBG_JNI | DBG_CRIT, "blitN(): GetPrimitiveArrayCritical() failed\n");
+        return;
+    }
+    src = (uint32_t *)(*env)->GetPrimitiveArrayCritical(env, srcArray, NULL);
+    if (!src) {
+        BD_DEBUG(DBG_JNI | DBG_CRIT, "blitN(): GetPrimitiveArrayCritical() failed\n");
+        (*env)->ReleasePrimitiveArrayCritical(env, dstArray, dst, JNI_ABORT);
+        return;
+    }
+
+    for (y = 0; y < h; y++) {
+        _blit_span(dst + dstOffset + y * dstStride, src + srcOffset + y * srcStride, w, rule, alpha, flipX);
+    }
+
+    (*env)->ReleasePrimitiveArrayCritical(env, srcArray, src, JNI_ABORT);
+    (*env)->ReleasePrimitiveArrayCritical(env, dstArray, dst, 0);
+}
+
+/*
+ * text
+ */
+
 #ifdef HAVE_FT2
-    jsize length;
+
+#define GLYPH_CACHE_SIZE 256  /* direct-mapped, indexed by low bits of character code */
+
+typedef struct {
+    uint8_t   valid;
+    uint8_t   loaded;   /* FT_Load_Char() succeeded */
+    jchar     ch;
+    int       left, top;
+    int       advance;
+    unsigned  w, h;
+    uint8_t  *bitmap;   /* w * h coverage values */
+} GLYPH;
+
+typedef struct {
+    GLYPH glyph[GLYPH_CACHE_SIZE];
+} GLYPH_CACHE;
+
+/* FT_Generic finalizer, called from FT_Done_Face() */
+static void _glyph_cache_free(void *object)
+{
+    FT_Face      face  = (FT_Face)object;
+    GLYPH_CACHE *cache = (GLYPH_CACHE *)face->generic.data;
+    unsigned     i;
+
+    if (cache) {
+        for (i = 0; i < GLYPH_CACHE_SIZE; i++) {
+            free(cache->glyph[i].bitmap);
+        }
+        free(cache);
+        face->generic.data = NULL;
+    }
+}
+
+/* face is used only from synchronized BDFontMetrics methods */
+static const GLYPH *_get_glyph(FT_Face face, jchar ch)
+{
+    GLYPH_CACHE *cache = (GLYPH_CACHE *)face->generic.data;
+    GLYPH       *g;
+    unsigned     y;
+
+    if (!cache) {
+        cache = calloc(1, sizeof(GLYPH_CACHE));
+        if (!cache) {
+            return NULL;
+        }
+        face->generic.data      = cache;
+        face->generic.finalizer = _glyph_cache_free;
+    }
+
+    g = &cache->glyph[ch % GLYPH_CACHE_SIZE];
+    if (g->valid && g->ch == ch) {
+        return g;
+    }
+
+    free(g->bitmap);
+    memset(g, 0, sizeof(*g));
+
+    if (FT_Load_Char(face, ch, FT_LOAD_RENDER) == 0) {
+        const FT_Bitmap *bm = &face->glyph->bitmap;
+
+        if (bm->rows > 0 && bm->width > 0) {
+            g->bitmap = malloc(bm->rows * bm->width);
+            if (!g->bitmap) {
+                return NULL;
+            }
+            for (y = 0; y < bm->rows; y++) {
+                memcpy(g->bitmap + y * bm->width, bm->buffer + y * bm->pitch, bm->width);
+            }
+            g->w = bm->width;
+            g->h = bm->rows;
+        }
+        g->left    = face->glyph->bitmap_left;
+        g->top     = face->glyph->bitmap_top;
+        g->advance = face->glyph->metrics.horiAdvance >> 6;
+        g->loaded  = 1;
+    }
+
+    g->ch    = ch;
+    g->valid = 1;
+    return g;
+}
+
+#endif /* HAVE_FT2 */
+
+/* Draw string directly to back buffer.
+ * Same result as drawing each glyph pixel with BDGraphicsBase.drawPointN().
+ * (x, y, clip) are in back buffer coordinates. Bounding box of modified pixels is stored to bbox[4] (x0, y0, x1, y1).
+ */
+JNIEXPORT void JNICALL
+Java_java_awt_BDGraphics_drawStringN(JNIEnv * env, jclass cls, jlong ftFace, jstring string, jint x, jint y, jint rgb,
+                                     jintArray dstArray, jint dstWidth, jint dstHeight,
+                                     jint clipX, jint clipY, jint clipW, jint clipH,
+                                     jint rule, jfloat alpha, jboolean xorMode, jint xorRgb,
+                                     jintArray bboxArray)
+{
+    jint bbox[4] = { 0, 0, -1, -1 };
+
+#ifdef HAVE_FT2
+    FT_Face      face = (FT_Face)(intptr_t)ftFace;
+    jsize        length, i;
     const jchar *chars;
-    jclass cls;
-    jmethodID mid;
-    jint a, c;
-    jint i;
-    unsigned j, k;
-    FT_Face face = (FT_Face)(intptr_t)ftFace;
+    uint32_t    *dst;
+    uint32_t     a, c;
+    int          cx0, cy0, cx1, cy1;
+    int          bx0 = dstWidth, by0 = dstHeight, bx1 = -1, by1 = -1;
+
+    /* clip area inside back buffer */
+    cx0 = clipX > 0 ? clipX : 0;
+    cy0 = clipY > 0 ? clipY : 0;
+    cx1 = clipX + clipW < dstWidth  ? clipX + clipW : dstWidth;
+    cy1 = clipY + clipH < dstHeight ? clipY + clipH : dstHeight;
 
     length = (*env)->GetStringLength(env, string);
-    if (length <= 0)
-      return;
-    chars = (*env)->GetStringCritical(env, string, NULL);
-    if (chars == NULL)
-      return;
+    if (length <= 0 || cx1 <= cx0 || cy1 <= cy0 ||
+        (int64_t)dstWidth * dstHeight > (*env)->GetArrayLength(env, dstArray)) {
+        goto out;
+    }
 
-    cls = (*env)->GetObjectClass(env, obj);
-    mid = (*env)->GetMethodID(env, cls, "drawPoint", "(III)V");
+    chars = (*env)->GetStringChars(env, string, NULL);
+    if (chars == NULL) {
+        goto out;
+    }
 
-    a = (rgb >> 24) & 0xff;
-    c = rgb & 0xffffff;
+    dst = (uint32_t *)(*env)->GetPrimitiveArrayCritical(env, dstArray, NULL);
+    if (!dst) {
+        BD_DEBUG(DBG_JNI | DBG_CRIT, "drawStringN(): GetPrimitiveArrayCritical() failed\n");
+        (*env)->ReleaseStringChars(env, string, chars);
+        goto out;
+    }
+
+    a = ((uint32_t)rgb >> 24) & 0xff;
+    c = (uint32_t)rgb & 0xffffff;
 
     for (i = 0; i < length; i++) {
-        if (FT_Load_Char(face, chars[i], FT_LOAD_RENDER) == 0) {
-            for (j = 0; j < face->glyph->bitmap.rows; j++) {
-                for (k = 0; k < face->glyph->bitmap.width; k++) {
-                    jint pixel;
-                    pixel = face->glyph->bitmap.buffer[j*face->glyph->bitmap.pitch + k];
-                    pixel = ((a * pixel / 255) << 24) | c;
-                    (*env)->CallVoidMethod(env, obj, mid,
-                                           x + face->glyph->bitmap_left + k,
-                                           y - face->glyph->bitmap_top + j,
-                                           pixel);
+        const GLYPH *g = _get_glyph(face, chars[i]);
+        int ox, oy, gx0, gy0, gx1, gy1, gx, gy;
+
+        if (!g || !g->loaded) {
+            continue;
+        }
+
+        /* glyph area clipped */
+        ox  = x + g->left;
+        oy  = y - g->top;
+        gx0 = ox;
+        gy0 = oy;
+        gx1 = gx0 + (int)g->w;
+        gy1 = gy0 + (int)g->h;
+        if (gx0 < cx0) gx0 = cx0;
+        if (gy0 < cy0) gy0 = cy0;
+        if (gx1 > cx1) gx1 = cx1;
+        if (gy1 > cy1) gy1 = cy1;
+
+        for (gy = gy0; gy < gy1; gy++) {
+            const uint8_t *src = g->bitmap + (gy - oy) * g->w;
+            uint32_t      *d   = dst + gy * dstWidth;
+
+            for (gx = gx0; gx < gx1; gx++) {
+                uint32_t pixel = ((a * src[gx - ox] / 255) << 24) | c;
+                if (xorMode) {
+                    d[gx] ^= (uint32_t)xorRgb ^ pixel;
+                } else if (rule == RULE_CLEAR) {
+                    d[gx] = 0;
+                } else if (rule == RULE_SRC) {
+                    d[gx] = _apply_alpha(pixel, alpha);
+                } else if (rule == RULE_SRC_OVER) {
+                    d[gx] = _alpha_blend(d[gx], _apply_alpha(pixel, alpha));
                 }
             }
-            x += face->glyph->metrics.horiAdvance >> 6;
         }
+
+        if (gx1 > gx0 && gy1 > gy0) {
+            if (gx0 < bx0)     bx0 = gx0;
+            if (gy0 < by0)     by0 = gy0;
+            if (gx1 - 1 > bx1) bx1 = gx1 - 1;
+            if (gy1 - 1 > by1) by1 = gy1 - 1;
+        }
+
+        x += g->advance;
+    }
+
+    (*env)->ReleasePrimitiveArrayCritical(env, dstArray, dst, 0);
+    (*env)->ReleaseStringChars(env, string, chars);
+
+    if (bx1 >= bx0) {
+        bbox[0] = bx0; bbox[1] = by0; bbox[2] = bx1; bbox[3] = by1;
     }
 
-    (*env)->ReleaseStringCritical(env, string, chars);
+ out:
 #endif /* HAVE_FT2 */
+
+    (*env)->SetIntArrayRegion(env, bboxArray, 0, 4, bbox);
 }
 
 #define CC (char*)(uintptr_t)  /* cast a literal from (const char*) */
@@ -99,9 +431,19 @@ Java_java_awt_BDGraphics_methods[] =
 { /* AUTOMATICALLY GENERATED */
     {
         CC("drawStringN"),
-        CC("(JLjava/lang/String;III)V"),
+        CC("(JLjava/lang/String;III[IIIIIIIIFZI[I)V"),
         VC(Java_java_awt_BDGraphics_drawStringN),
     },
+    {
+        CC("fillRectN"),
+        CC("([IIIIIII)V"),
+        VC(Java_java_awt_BDGraphics_fillRectN),
+    },
+    {
+        CC("blitN"),
+        CC("([III[IIIIIIFZ)V"),
+        VC(Java_java_awt_BDGraphics_blitN),
+    },
 };
 
 BD_PRIVATE CPP_EXTERN const int
@@ -15,10 +15,26 @@ extern "C" {
 /*
  * Class:     java_awt_BDGraphics
  * Method:    drawStringN
- * Signature: (JLjava/lang/String;III)V
+ * Signature: (JLjava/lang/String;III[IIIIIIIIFZI[I)V
  */
 JNIEXPORT void JNICALL Java_java_awt_BDGraphics_drawStringN
-  (JNIEnv *, jobject, jlong, jstring, jint, jint, jint);
+  (JNIEnv *, jclass, jlong, jstring, jint, jint, jint, jintArray, jint, jint, jint, jint, jint, jint, jint, jfloat, jboolean, jint, jintArray);
+
+/*
+ * Class:     java_awt_BDGraphics
+ * Method:    fillRectN
+ * Signature: ([IIIIIII)V
+ */
+JNIEXPORT void JNICALL Java_java_awt_BDGraphics_fillRectN
+  (JNIEnv *, jclass, jintArray, jint, jint, jint, jint, jint, jint);
+
+/*
+ * Class:     java_awt_BDGraphics
+ * Method:    blitN
+ * Signature: ([III[IIIIIIFZ)V
+ */
+JNIEXPORT void JNICALL Java_java_awt_BDGraphics_blitN
+  (JNIEnv *, jclass, jintArray, jint, jint, jintArray, jint, jint, jint, jint, jint, jfloat, jboolean);
 
 #ifdef __cplusplus
 }
@@ -35,6 +35,7 @@
 #include "file/file.h"
 #include "util/logging.h"
 #include "util/macro.h"
+#include "util/thread.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -360,6 +361,57 @@ JNIEXPORT jint JNICALL Java_org_videolan_Libbluray_cacheBdRomFileN(JNIEnv * env,
     return result;
 }
 
+JNIEXPORT jint JNICALL Java_org_videolan_Libbluray_cacheBdRomFileAsyncN(JNIEnv * env,
+                                                                        jclass cls, jlong np,
+                                                                        jstring jrel_path, jstring jcache_path) {
+
+    BLURAY *bd = (BLURAY*)(intptr_t)np;
+    BD_DISC *disc = bd_get_disc(bd);
+    int result = -1;
+
+    const char *rel_path = (*env)->GetStringUTFChars(env, jrel_path, NULL);
+    const char *cache_path = (*env)->GetStringUTFChars(env, jcache_path, NULL);
+    if (!rel_path || !cache_path) {
+        BD_DEBUG(DBG_JNI | DBG_CRIT, "cacheBdRomFileAsync() failed: no path\n");
+        goto out;
+    }
+    BD_DEBUG(DBG_JNI, "cacheBdRomFileAsync(%s => %s)\n", rel_path, cache_path);
+
+    result = disc_cache_bdrom_file_async(disc, rel_path, cache_path);
+
+ out:
+    if (rel_path) {
+        (*env)->ReleaseStringUTFChars(env, jrel_path, rel_path);
+    }
+    if (cache_path) {
+        (*env)->ReleaseStringUTFChars(env, jcache_path, cache_path);
+    }
+
+    return result;
+}
+
+JNIEXPORT jint JNICALL Java_org_videolan_Libbluray_waitBdRomFileN(JNIEnv * env,
+                                                                  jclass cls, jlong np,
+                                                                  jstring jcache_path) {
+
+    BLURAY *bd = (BLURAY*)(intptr_t)np;
+    BD_DISC *disc = bd_get_disc(bd);
+    int result;
+
+    const char *cache_path = (*env)->GetStringUTFChars(env, jcache_path, NULL);
+    if (!cache_path) {
+        BD_DEBUG(DBG_JNI | DBG_CRIT, "waitBdRomFile() failed: no path\n");
+        return -1;
+    }
+
+    result = disc_cache_bdrom_file_wait(disc, cache_path);
+    BD_DEBUG(DBG_JNI, "waitBdRomFile(%s) -> %d\n", cache_path, result);
+
+    (*env)->ReleaseStringUTFChars(env, jcache_path, cache_path);
+
+    return result;
+}
+
 JNIEXPORT jobjectArray JNICALL Java_org_videolan_Libbluray_listBdFilesN(JNIEnv * env,
                                                                         jclass cls, jlong np, jstring jpath,
                                                                         jboolean onlyBdRom) {
@@ -455,10 +507,56 @@ JNIEXPORT jobject JNICALL Java_org_videolan_Libbluray_getBdjoN(JNIEnv * env,
     return jbdjo;
 }
 
+static void _copy_rect(JNIEnv *env, jintArray rgbArray, jint width,
+                       jint *dst, int dst_stride,
+                       jint x0, jint y0, jint x1, jint y1) {
+
+    jint  y;
+    jsize offset = y0 * width + x0;
+    jsize length = (*env)->GetArrayLength(env, rgbArray);
+    jint *image;
+
+    if (offset < 0 || y1 * width + x1 >= length) {
+        BD_DEBUG(DBG_BDJ | DBG_CRIT, "Array access error at %ld (+%ld)\n", (long)offset, (long)(x1 - x0 + 1));
+        return;
+    }
+
+    /* copy directly from java heap (no intermediate copy, no JNI call per line) */
+    image = (jint *)(*env)->GetPrimitiveArrayCritical(env, rgbArray, NULL);
+    if (image) {
+        const jint *src = image + offset;
+        size_t      len = (x1 - x0 + 1) * sizeof(jint);
+        for (y = y0; y <= y1; y++) {
+            memcpy(dst, src, len);
+            src += width;
+            dst += dst_stride;
+        }
+        (*env)->ReleasePrimitiveArrayCritical(env, rgbArray, image, JNI_ABORT);
+        return;
+    }
+
+    for (y = y0; y <= y1; y++) {
+        (*env)->GetIntArrayRegion(env, rgbArray, offset, x1 - x0 + 1, dst);
+        offset += width;
+        dst += dst_stride;
+    }
+
+    /* check for errors */
+    if ((*env)->ExceptionOccurred(env)) {
+        BD_DEBUG(DBG_BDJ | DBG_CRIT, "Array access error at %ld (+%ld)\n", (long)offset, (long)(x1 - x0 + 1));
+        (*env)->ExceptionDescribe(env);
+        (*env)->ExceptionClear(env);
+    }
+}
+
+/* rects: num_rects * {x0, y0, x1, y1}, disjoint and inside frame */
 static void _updateGraphic(JNIEnv * env,
         BLURAY *bd, jint width, jint height, jintArray rgbArray,
-        jint x0, jint y0, jint x1, jint y1,
-        BD_ARGB_BUFFER *buf) {
+        const int *rects, int num_rects,
+        BD_ARGB_BUFFER *buf, BD_ARGB_BUFFER_EXT *ext) {
+
+    jint x0, y0, x1, y1;
+    int  ii;
 
     /* close ? */
     if (!rgbArray) {
@@ -466,18 +564,56 @@ static void _updateGraphic(JNIEnv * env,
         return;
     }
 
-    if (buf) {
+    /* bounding box */
+    x0 = rects[0]; y0 = rects[1]; x1 = rects[2]; y1 = rects[3];
+    for (ii = 1; ii < num_rects; ii++) {
+        x0 = BD_MIN(x0, rects[ii * 4 + 0]);
+        y0 = BD_MIN(y0, rects[ii * 4 + 1]);
+        x1 = BD_MAX(x1, rects[ii * 4 + 2]);
+        y1 = BD_MAX(y1, rects[ii * 4 + 3]);
+    }
+
+    if (ext && ext->num_buffers == 3) {
+
+        /* copy to back buffer of triple-buffered application frame buffer (no locking) */
+
+        jint *dst;
+        jint cx0 = x0, cy0 = y0, cx1 = x1, cy1 = y1;
+
+        dst = (jint*)bd_argb_buffer_back(ext, BD_OVERLAY_IG, &cx0, &cy0, &cx1, &cy1);
+        if (!dst || buf->width < width || buf->height < height) {
+            BD_DEBUG(DBG_BDJ | DBG_CRIT, "ARGB back buffer missing or too small\n");
+            return;
+        }
+
+        /* area missed by this buffer may extend outside of current frame */
+        cx1 = BD_MIN(cx1, width - 1);
+        cy1 = BD_MIN(cy1, height - 1);
+
+        if (cx0 != x0 || cy0 != y0 || cx1 != x1 || cy1 != y1) {
+            /* buffer is missing older changes too */
+            _copy_rect(env, rgbArray, width, dst + cy0 * buf->width + cx0, buf->width, cx0, cy0, cx1, cy1);
+        } else {
+            for (ii = 0; ii < num_rects; ii++) {
+                const int *r = rects + ii * 4;
+                _copy_rect(env, rgbArray, width, dst + r[1] * buf->width + r[0], buf->width, r[0], r[1], r[2], r[3]);
+            }
+        }
+
+        /* publish */
+        dst = (jint*)bd_argb_buffer_flip(ext, BD_OVERLAY_IG, cx0, cy0, cx1, cy1);
+
+        bd_bdj_osd_cb_rects(bd, (const unsigned *)dst, (int)width, (int)height,
+                            rects, num_rects);
+
+    } else if (buf) {
 
         /* copy to application-allocated buffer */
 
-        jint y, *dst;
-        jsize offset;
+        jint *dst;
 
         /* set dirty area before lock() */
-        buf->dirty[BD_OVERLAY_IG].x0 = (uint16_t)x0;
-        buf->dirty[BD_OVERLAY_IG].x1 = (uint16_t)x1;
-        buf->dirty[BD_OVERLAY_IG].y0 = (uint16_t)y0;
-        buf->dirty[BD_OVERLAY_IG].y1 = (uint16_t)y1;
+        bd_argb_buffer_set_dirty(buf, ext, BD_OVERLAY_IG, rects, num_rects);
 
         /* get buffer */
         if (buf->lock) {
@@ -506,46 +642,38 @@ static void _updateGraphic(JNIEnv * env,
                 return;
             }
 
+            /* copy bounding box */
             dst = (jint*)buf->buf[BD_OVERLAY_IG];
+            _copy_rect(env, rgbArray, width, dst, buf->width, x0, y0, x1, y1);
 
         } else {
 
-            dst = (jint*)buf->buf[BD_OVERLAY_IG] + y0 * buf->width + x0;
+            /* copy each dirty rectangle */
+            for (ii = 0; ii < num_rects; ii++) {
+                jint rx0 = rects[ii * 4 + 0], ry0 = rects[ii * 4 + 1];
+                jint rx1 = rects[ii * 4 + 2], ry1 = rects[ii * 4 + 3];
 
-            /* clip */
-            if (y1 >= buf->height) {
-                BD_DEBUG(DBG_BDJ | DBG_CRIT, "Cropping %ld rows from bottom\n", (long)(y1 - buf->height));
-                y1 = buf->height - 1;
-            }
-            if (x1 >= buf->width) {
-                BD_DEBUG(DBG_BDJ | DBG_CRIT, "Cropping %ld pixels from right\n", (long)(x1 - buf->width));
-                x1 = buf->width - 1;
-            }
-        }
-
-        /* copy */
-
-        offset = y0 * width + x0;
-
-        for (y = y0; y <= y1; y++) {
-            (*env)->GetIntArrayRegion(env, rgbArray, offset, x1 - x0 + 1, dst);
-            offset += width;
-            dst += buf->width;
-        }
+                /* clip */
+                if (ry1 >= buf->height) {
+                    BD_DEBUG(DBG_BDJ | DBG_CRIT, "Cropping %ld rows from bottom\n", (long)(ry1 - buf->height));
+                    ry1 = buf->height - 1;
+                }
+                if (rx1 >= buf->width) {
+                    BD_DEBUG(DBG_BDJ | DBG_CRIT, "Cropping %ld pixels from right\n", (long)(rx1 - buf->width));
+                    rx1 = buf->width - 1;
+                }
 
-        /* check for errors */
-        if ((*env)->ExceptionOccurred(env)) {
-            BD_DEBUG(DBG_BDJ | DBG_CRIT, "Array access error at %ld (+%ld)\n", (long)offset, (long)(x1 - x0 + 1));
-            (*env)->ExceptionDescribe(env);
-            (*env)->ExceptionClear(env);
+                dst = (jint*)buf->buf[BD_OVERLAY_IG] + ry0 * buf->width + rx0;
+                _copy_rect(env, rgbArray, width, dst, buf->width, rx0, ry0, rx1, ry1);
+            }
         }
 
         if (buf->unlock) {
             buf->unlock(buf);
         }
 
-        bd_bdj_osd_cb(bd, buf->buf[BD_OVERLAY_IG], (int)width, (int)height,
-                      x0, y0, x1, y1);
+        bd_bdj_osd_cb_rects(bd, buf->buf[BD_OVERLAY_IG], (int)width, (int)height,
+                            rects, num_rects);
 
     } else {
 
@@ -553,8 +681,8 @@ static void _updateGraphic(JNIEnv * env,
 
         jint *image = (jint *)(*env)->GetPrimitiveArrayCritical(env, rgbArray, NULL);
         if (image) {
-            bd_bdj_osd_cb(bd, (const unsigned *)image, (int)width, (int)height,
-                          x0, y0, x1, y1);
+            bd_bdj_osd_cb_rects(bd, (const unsigned *)image, (int)width, (int)height,
+                                rects, num_rects);
             (*env)->ReleasePrimitiveArrayCritical(env, rgbArray, image, JNI_ABORT);
         } else {
             BD_DEBUG(DBG_BDJ | DBG_CRIT, "GetPrimitiveArrayCritical() failed\n");
@@ -567,6 +695,7 @@ JNIEXPORT void JNICALL Java_org_videolan_Libbluray_updateGraphicN(JNIEnv * env,
         jint x0, jint y0, jint x1, jint y1) {
 
     BLURAY* bd = (BLURAY*)(intptr_t)np;
+    int rect[4] = {x0, y0, x1, y1};
 
     BD_DEBUG(DBG_JNI, "updateGraphicN(%ld,%ld-%ld,%ld)\n", (long)x0, (long)y0, (long)x1, (long)y1);
 
@@ -582,11 +711,75 @@ JNIEXPORT void JNICALL Java_org_videolan_Libbluray_updateGraphicN(JNIEnv * env,
 
     BD_ARGB_BUFFER *buf = bd_lock_osd_buffer(bd);
 
-    _updateGraphic(env, bd, width, height, rgbArray, x0, y0, x1, y1, buf);
+    _updateGraphic(env, bd, width, height, rgbArray, rect, 1, buf, bd_osd_buffer_ext(bd));
+
+    bd_unlock_osd_buffer(bd);
+}
+
+JNIEXPORT void JNICALL Java_org_videolan_Libbluray_updateGraphicRectsN(JNIEnv * env,
+        jclass cls, jlong np, jint width, jint height, jintArray rgbArray,
+        jintArray jrects, jint jnum_rects) {
+
+    BLURAY* bd = (BLURAY*)(intptr_t)np;
+    jint    in[BD_ARGB_MAX_DIRTY_RECTS * 4];
+    int     rects[BD_ARGB_MAX_DIRTY_RECTS * 4];
+    int     ii, num_in, num_rects = 0;
+
+    /* app callback not initialized ? */
+    if (!bd) {
+        return;
+    }
+
+    if (!rgbArray || !jrects) {
+        return;
+    }
+
+    /* rectangle array is re-used by caller, only jnum_rects entries are valid */
+    num_in = BD_MIN((int)jnum_rects, (*env)->GetArrayLength(env, jrects) / 4);
+    if (num_in > BD_ARGB_MAX_DIRTY_RECTS) {
+        BD_DEBUG(DBG_JNI | DBG_CRIT, "updateGraphicRectsN(): too many rectangles (%d)\n", num_in);
+        num_in = BD_ARGB_MAX_DIRTY_RECTS;
+    }
+    (*env)->GetIntArrayRegion(env, jrects, 0, num_in * 4, in);
+
+    BD_DEBUG(DBG_JNI, "updateGraphicRectsN(%d rects)\n", num_in);
+
+    /* clip to frame and drop empty rectangles */
+    for (ii = 0; ii < num_in; ii++) {
+        int x0 = BD_MAX(in[ii * 4 + 0], 0),         y0 = BD_MAX(in[ii * 4 + 1], 0);
+        int x1 = BD_MIN(in[ii * 4 + 2], width - 1), y1 = BD_MIN(in[ii * 4 + 3], height - 1);
+        if (x1 >= x0 && y1 >= y0) {
+            rects[num_rects * 4 + 0] = x0;
+            rects[num_rects * 4 + 1] = y0;
+            rects[num_rects * 4 + 2] = x1;
+            rects[num_rects * 4 + 3] = y1;
+            num_rects++;
+        }
+    }
+
+    /* nothing to draw ? */
+    if (num_rects < 1) {
+        return;
+    }
+
+    BD_ARGB_BUFFER *buf = bd_lock_osd_buffer(bd);
+
+    _updateGraphic(env, bd, width, height, rgbArray, rects, num_rects, buf, bd_osd_buffer_ext(bd));
 
     bd_unlock_osd_buffer(bd);
 }
 
+JNIEXPORT void JNICALL Java_org_videolan_Libbluray_threadStartedN(JNIEnv * env,
+        jclass cls, jstring jname) {
+    const char *name = jname ? (*env)->GetStringUTFChars(env, jname, NULL) : NULL;
+
+    bd_thread_started(name ? name : "bdj");
+
+    if (name) {
+        (*env)->ReleaseStringUTFChars(env, jname, name);
+    }
+}
+
 #define CC (char*)(uintptr_t)  /* cast a literal from (const char*) */
 #define VC (void*)(uintptr_t)  /* cast function pointer to void* */
 
@@ -678,6 +871,16 @@ Java_org_videolan_Libbluray_methods[] =
         CC("(JLjava/lang/String;Ljava/lang/String;)I"),
         VC(Java_org_videolan_Libbluray_cacheBdRomFileN),
     },
+    {
+        CC("cacheBdRomFileAsyncN"),
+        CC("(JLjava/lang/String;Ljava/lang/String;)I"),
+        VC(Java_org_videolan_Libbluray_cacheBdRomFileAsyncN),
+    },
+    {
+        CC("waitBdRomFileN"),
+        CC("(JLjava/lang/String;)I"),
+        VC(Java_org_videolan_Libbluray_waitBdRomFileN),
+    },
     {
         CC("listBdFilesN"),
         CC("(JLjava/lang/String;Z)[Ljava/lang/String;"),
@@ -693,6 +896,16 @@ Java_org_videolan_Libbluray_methods[] =
         CC("(JII[IIIII)V"),
         VC(Java_org_videolan_Libbluray_updateGraphicN),
     },
+    {
+        CC("updateGraphicRectsN"),
+        CC("(JII[I[II)V"),
+        VC(Java_org_videolan_Libbluray_updateGraphicRectsN),
+    },
+    {
+        CC("threadStartedN"),
+        CC("(Ljava/lang/String;)V"),
+        VC(Java_org_videolan_Libbluray_threadStartedN),
+    },
 };
 
 BD_PRIVATE CPP_EXTERN const int
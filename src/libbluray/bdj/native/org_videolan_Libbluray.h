@@ -228,6 +228,22 @@ JNIEXPORT jint JNICALL Java_org_videolan_Libbluray_readPSRN
 JNIEXPORT jint JNICALL Java_org_videolan_Libbluray_cacheBdRomFileN
 (JNIEnv *, jclass, jlong, jstring, jstring);
 
+/*
+ * Class:     org_videolan_Libbluray
+ * Method:    cacheBdRomFileAsyncN
+ * Signature: (JLjava/lang/String;Ljava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_org_videolan_Libbluray_cacheBdRomFileAsyncN
+(JNIEnv *, jclass, jlong, jstring, jstring);
+
+/*
+ * Class:     org_videolan_Libbluray
+ * Method:    waitBdRomFileN
+ * Signature: (JLjava/lang/String;)I
+ */
+JNIEXPORT jint JNICALL Java_org_videolan_Libbluray_waitBdRomFileN
+(JNIEnv *, jclass, jlong, jstring);
+
 /*
  * Class:     org_videolan_Libbluray
  * Method:    listBdFilesN
@@ -253,6 +269,22 @@ JNIEXPORT jobject JNICALL Java_org_videolan_Libbluray_getBdjoN
 JNIEXPORT void JNICALL Java_org_videolan_Libbluray_updateGraphicN
 (JNIEnv *, jclass, jlong, jint, jint, jintArray, jint, jint, jint, jint);
 
+/*
+ * Class:     org_videolan_Libbluray
+ * Method:    updateGraphicRectsN
+ * Signature: (JII[I[II)V
+ */
+JNIEXPORT void JNICALL Java_org_videolan_Libbluray_updateGraphicRectsN
+(JNIEnv *, jclass, jlong, jint, jint, jintArray, jintArray, jint);
+
+/*
+ * Class:     org_videolan_Libbluray
+ * Method:    threadStartedN
+ * Signature: (Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_org_videolan_Libbluray_threadStartedN
+(JNIEnv *, jclass, jstring);
+
 #ifdef __cplusplus
 }
 #endif
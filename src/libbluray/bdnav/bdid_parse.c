@@ -67,6 +67,7 @@ static BDID_DATA *_bdid_parse(BD_FILE_H *fp)
 
     if (!_parse_header(&bs, &data_start, &extension_data_start)) {
         BD_DEBUG(DBG_NAV | DBG_CRIT, "id.bdmv: invalid header\n");
+        bs_close(&bs);
         return NULL;
     }
 
@@ -80,6 +81,7 @@ static BDID_DATA *_bdid_parse(BD_FILE_H *fp)
     bs_read_bytes(&bs, tmp, 16);
     str_print_hex(bdid->disc_id, tmp, 16);
 
+    bs_close(&bs);
     return bdid;
 }
 
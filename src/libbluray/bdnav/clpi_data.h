@@ -136,6 +136,14 @@ typedef struct
     CLPI_EP_FINE     *fine;
 } CLPI_EP_MAP_ENTRY;
 
+/* Decoded EP map: full PTS / SPN of each fine entry */
+typedef struct
+{
+    int               num_ep;
+    uint32_t         *pts;     /* 45 kHz */
+    uint32_t         *spn;
+} CLPI_EP_INDEX;
+
 typedef struct
 {
     uint8_t           type;
@@ -172,6 +180,9 @@ typedef struct clpi_cl {
 
     /* Text subtitle stream font files */
     CLPI_FONT_INFO    font_info;
+
+    /* Decoded EP map of cpi.entry[] (cpi.num_stream_pid entries) */
+    CLPI_EP_INDEX    *ep_index;
 } CLPI_CL;
 
 #endif // _CLPI_DATA_H_
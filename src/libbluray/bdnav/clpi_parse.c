@@ -26,6 +26,7 @@
 
 #include "file/file.h"
 #include "util/bits.h"
+#include "util/refcnt.h"
 #include "util/macro.h"
 #include "util/logging.h"
 
@@ -308,6 +309,16 @@ _parse_ep_map_stream(BITSTREAM *bits, CLPI_EP_MAP_ENTRY *ee)
         fine[ii].pts_ep                =  bs_read(bits, 11);
         fine[ii].spn_ep                =  bs_read(bits, 17);
     }
+
+    // EP map search requires coarse entries in fine entry order
+    for (ii = 0; ii < ee->num_ep_coarse; ii++) {
+        int ref = coarse[ii].ref_ep_fine_id;
+        if (ref >= ee->num_ep_fine || (ii ? ref < coarse[ii-1].ref_ep_fine_id : ref != 0)) {
+            BD_DEBUG(DBG_NAV | DBG_CRIT, "invalid EP map (coarse entry %d)\n", ii);
+            ee->num_ep_coarse = 0;
+            break;
+        }
+    }
     return 1;
 }
 
@@ -347,12 +358,65 @@ _parse_cpi(BITSTREAM *bits, CLPI_CPI *cpi)
     return 1;
 }
 
+static int
+_decode_ep_map(const CLPI_EP_MAP_ENTRY *ee, CLPI_EP_INDEX *idx)
+{
+    int ii, jj, end;
+
+    if (ee->num_ep_coarse < 1 || ee->num_ep_fine < 1) {
+        return 1;
+    }
+
+    idx->pts = malloc(ee->num_ep_fine * sizeof(uint32_t));
+    idx->spn = malloc(ee->num_ep_fine * sizeof(uint32_t));
+    if (!idx->pts || !idx->spn) {
+        X_FREE(idx->pts);
+        X_FREE(idx->spn);
+        return 0;
+    }
+
+    for (ii = 0; ii < ee->num_ep_coarse; ii++) {
+        uint32_t coarse_pts = (uint32_t)(ee->coarse[ii].pts_ep & ~0x01) << 18;
+        uint32_t coarse_spn = ee->coarse[ii].spn_ep & ~0x1FFFF;
+
+        end = (ii < ee->num_ep_coarse - 1) ? ee->coarse[ii+1].ref_ep_fine_id : ee->num_ep_fine;
+        for (jj = ee->coarse[ii].ref_ep_fine_id; jj < end; jj++) {
+            idx->pts[jj] = coarse_pts + ((uint32_t)ee->fine[jj].pts_ep << 8);
+            idx->spn[jj] = coarse_spn + ee->fine[jj].spn_ep;
+        }
+    }
+    idx->num_ep = ee->num_ep_fine;
+
+    return 1;
+}
+
+static int
+_build_ep_index(CLPI_CL *cl)
+{
+    int ii;
+
+    if (cl->cpi.num_stream_pid < 1) {
+        return 1;
+    }
+
+    cl->ep_index = calloc(cl->cpi.num_stream_pid, sizeof(CLPI_EP_INDEX));
+    if (!cl->ep_index) {
+        return 0;
+    }
+    for (ii = 0; ii < cl->cpi.num_stream_pid; ii++) {
+        if (!_decode_ep_map(&cl->cpi.entry[ii], &cl->ep_index[ii])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
 static int
 _parse_cpi_info(BITSTREAM *bits, CLPI_CL *cl)
 {
     bs_seek_byte(bits, cl->cpi_start_addr);
 
-    return _parse_cpi(bits, &cl->cpi);
+    return _parse_cpi(bits, &cl->cpi) && _build_ep_index(cl);
 }
 
 static uint32_t
@@ -370,110 +434,124 @@ _find_stc_spn(const CLPI_CL *cl, uint8_t stc_id)
     return 0;
 }
 
+static int
+_find_stc_end_spn(const CLPI_CL *cl, uint8_t stc_id, uint32_t *spn)
+{
+    int ii;
+    CLPI_ATC_SEQ *atc;
+
+    // end of STC sequence = start of next STC or ATC sequence
+    for (ii = 0; ii < cl->sequence.num_atc_seq; ii++) {
+        atc = &cl->sequence.atc_seq[ii];
+        if (stc_id < atc->offset_stc_id + atc->num_stc_seq) {
+            if (stc_id + 1 < atc->offset_stc_id + atc->num_stc_seq) {
+                *spn = atc->stc_seq[stc_id + 1 - atc->offset_stc_id].spn_stc_start;
+                return 1;
+            }
+            if (ii + 1 < cl->sequence.num_atc_seq) {
+                *spn = cl->sequence.atc_seq[ii + 1].spn_atc_start;
+                return 1;
+            }
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/*
+ * EP map search
+ *
+ * Lookups use the decoded EP map (cl->ep_index).
+ * SPN is monotonic over the whole map, PTS inside one STC sequence.
+ */
+
+// Find first entry in v[first..last) > limit (>= limit if inclusive is set).
+// Returns last if not found.
+static int
+_ep_search(const uint32_t *v, int first, int last, uint32_t limit, int inclusive)
+{
+    int mid;
+
+    while (first < last) {
+        mid = first + (last - first) / 2;
+        if (inclusive ? v[mid] >= limit : v[mid] > limit) {
+            last = mid;
+        } else {
+            first = mid + 1;
+        }
+    }
+    return first;
+}
+
+static const CLPI_EP_INDEX *
+_ep_index(const CLPI_CL *cl)
+{
+    if (cl->cpi.num_stream_pid < 1 || !cl->ep_index || cl->ep_index[0].num_ep < 1) {
+        return NULL;
+    }
+
+    // Assumes that there is only one pid of interest
+    return &cl->ep_index[0];
+}
+
+// Find EP map entry (index to cl->ep_index[0]) at or before the packet.
+// Returns -1 if there is no such entry
+int
+clpi_ep_entry(const CLPI_CL *cl, uint32_t pkt)
+{
+    const CLPI_EP_INDEX *idx = _ep_index(cl);
+
+    if (!idx) {
+        return -1;
+    }
+    return _ep_search(idx->spn, 0, idx->num_ep, pkt, 0) - 1;
+}
+
 // Looks up the start packet number for the timestamp
 // Returns the spn for the entry that is closest to but
 // before the given timestamp
 uint32_t
 clpi_lookup_spn(const CLPI_CL *cl, uint32_t timestamp, int before, uint8_t stc_id)
 {
-    const CLPI_EP_MAP_ENTRY *entry;
-    const CLPI_CPI *cpi = &cl->cpi;
-    int ii, jj;
-    uint32_t coarse_pts, pts; // 45khz timestamps
-    uint32_t spn, coarse_spn, stc_spn;
-    int start, end;
-    int ref;
+    const CLPI_EP_INDEX *idx;
+    uint32_t stc_spn, stc_end;
+    int first, last, jj;
 
-    if (cpi->num_stream_pid < 1 || !cpi->entry) {
+    idx = _ep_index(cl);
+    if (!idx) {
         if (before) {
             return 0;
         }
         return cl->clip.num_source_packets;
     }
 
-    // Assumes that there is only one pid of interest
-    entry = &cpi->entry[0];
-
-    // Use sequence info to find spn_stc_start before doing
-    // PTS search. The spn_stc_start defines the point in
-    // the EP map to start searching.
+    // Use sequence info to limit PTS search to the STC sequence.
     stc_spn = _find_stc_spn(cl, stc_id);
-    for (ii = 0; ii < entry->num_ep_coarse; ii++) {
-        ref = entry->coarse[ii].ref_ep_fine_id;
-        if (entry->coarse[ii].spn_ep >= stc_spn) {
-            // The desired starting point is either after this point
-            // or in the middle of the previous coarse entry
-            break;
-        }
-    }
-    if (ii >= entry->num_ep_coarse) {
+    first = _ep_search(idx->spn, 0, idx->num_ep, stc_spn, 1);
+    if (first >= idx->num_ep) {
         return cl->clip.num_source_packets;
     }
-    pts = ((uint64_t)(entry->coarse[ii].pts_ep & ~0x01) << 18) +
-          ((uint64_t)entry->fine[ref].pts_ep << 8);
-    if (pts > timestamp && ii) {
-        // The starting point and desired PTS is in the previous coarse entry
-        ii--;
-        coarse_pts = (uint32_t)(entry->coarse[ii].pts_ep & ~0x01) << 18;
-        coarse_spn = entry->coarse[ii].spn_ep;
-        start = entry->coarse[ii].ref_ep_fine_id;
-        end = entry->coarse[ii+1].ref_ep_fine_id;
-        // Find a fine entry that has bothe spn > stc_spn and ptc > timestamp
-        for (jj = start; jj < end; jj++) {
-
-            pts = coarse_pts + ((uint32_t)entry->fine[jj].pts_ep << 8);
-            spn = (coarse_spn & ~0x1FFFF) + entry->fine[jj].spn_ep;
-            if (stc_spn >= spn && pts > timestamp)
-                break;
-        }
-        goto done;
+    last = idx->num_ep;
+    if (_find_stc_end_spn(cl, stc_id, &stc_end)) {
+        last = _ep_search(idx->spn, first, last, stc_end, 1);
     }
 
-    // If we've gotten this far, the desired timestamp is somewhere
-    // after the coarse entry we found the stc_spn in.
-    start = ii;
-    for (ii = start; ii < entry->num_ep_coarse; ii++) {
-        ref = entry->coarse[ii].ref_ep_fine_id;
-        pts = ((uint64_t)(entry->coarse[ii].pts_ep & ~0x01) << 18) +
-                ((uint64_t)entry->fine[ref].pts_ep << 8);
-        if (pts > timestamp) {
-            break;
-        }
-    }
+    // first entry after the timestamp
+    jj = _ep_search(idx->pts, first, last, timestamp, 0);
+
     // If the timestamp is before the first entry, then return
     // the beginning of the clip
-    if (ii == 0) {
+    if (jj == 0) {
         return 0;
     }
-    ii--;
-    coarse_pts = (uint32_t)(entry->coarse[ii].pts_ep & ~0x01) << 18;
-    start = entry->coarse[ii].ref_ep_fine_id;
-    if (ii < entry->num_ep_coarse - 1) {
-        end = entry->coarse[ii+1].ref_ep_fine_id;
-    } else {
-        end = entry->num_ep_fine;
-    }
-    for (jj = start; jj < end; jj++) {
-
-        pts = coarse_pts + ((uint32_t)entry->fine[jj].pts_ep << 8);
-        if (pts > timestamp)
-            break;
-    }
-
-done:
-    if (before) {
+    if (before && jj > first) {
         jj--;
     }
-    if (jj == end) {
-        ii++;
-        if (ii >= entry->num_ep_coarse) {
-            // End of file
-            return cl->clip.num_source_packets;
-        }
-        jj = entry->coarse[ii].ref_ep_fine_id;
+    if (jj >= idx->num_ep) {
+        // End of file
+        return cl->clip.num_source_packets;
     }
-    spn = (entry->coarse[ii].spn_ep & ~0x1FFFF) + entry->fine[jj].spn_ep;
-    return spn;
+    return idx->spn[jj];
 }
 
 // Looks up the start packet number that is closest to the requested packet
@@ -482,87 +560,78 @@ done:
 uint32_t
 clpi_access_point(const CLPI_CL *cl, uint32_t pkt, int next, int angle_change, uint32_t *time)
 {
-    const CLPI_EP_MAP_ENTRY *entry;
-    const CLPI_CPI *cpi = &cl->cpi;
-    int ii, jj;
-    uint32_t coarse_spn, spn;
-    int start, end;
-    int ref;
+    const CLPI_EP_INDEX *idx;
+    const CLPI_EP_FINE *fine;
+    int jj;
 
-    // Assumes that there is only one pid of interest
-    entry = &cpi->entry[0];
+    idx = _ep_index(cl);
 
-    for (ii = 0; ii < entry->num_ep_coarse; ii++) {
-        ref = entry->coarse[ii].ref_ep_fine_id;
-        spn = (entry->coarse[ii].spn_ep & ~0x1FFFF) + entry->fine[ref].spn_ep;
-        if (spn > pkt) {
-            break;
-        }
-    }
-    // If the timestamp is before the first entry, then return
+    // If the packet is before the first entry, then return
     // the beginning of the clip
-    if (ii == 0) {
+    if (!idx || idx->spn[0] > pkt) {
         *time = 0;
         return 0;
     }
-    ii--;
-    coarse_spn = (entry->coarse[ii].spn_ep & ~0x1FFFF);
-    start = entry->coarse[ii].ref_ep_fine_id;
-    if (ii < entry->num_ep_coarse - 1) {
-        end = entry->coarse[ii+1].ref_ep_fine_id;
+
+    if (next) {
+        jj = _ep_search(idx->spn, 0, idx->num_ep, pkt, 1);
     } else {
-        end = entry->num_ep_fine;
+        jj = _ep_search(idx->spn, 0, idx->num_ep, pkt, 0) - 1;
     }
-    for (jj = start; jj < end; jj++) {
 
-        spn = coarse_spn + entry->fine[jj].spn_ep;
-        if (spn >= pkt) {
-            break;
+    if (angle_change) {
+        // Keep looking till there's an angle change point
+        fine = cl->cpi.entry[0].fine;
+        for (; jj < idx->num_ep; jj++) {
+            if (fine[jj].is_angle_change_point) {
+                break;
+            }
         }
     }
-    if (jj == end && next) {
-        ii++;
-        jj = 0;
-    } else if (spn != pkt && !next) {
-        jj--;
-    }
-    if (ii == entry->num_ep_coarse) {
+
+    if (jj >= idx->num_ep) {
         *time = 0;
         return cl->clip.num_source_packets;
     }
-    coarse_spn = (entry->coarse[ii].spn_ep & ~0x1FFFF);
-    if (angle_change) {
-        // Keep looking till there's an angle change point
-        for (; jj < end; jj++) {
 
-            if (entry->fine[jj].is_angle_change_point) {
-                *time = ((uint64_t)(entry->coarse[ii].pts_ep & ~0x01) << 18) +
-                        ((uint64_t)entry->fine[jj].pts_ep << 8);
-                return coarse_spn + entry->fine[jj].spn_ep;
-            }
-        }
-        for (ii++; ii < entry->num_ep_coarse; ii++) {
-            start = entry->coarse[ii].ref_ep_fine_id;
-            if (ii < entry->num_ep_coarse - 1) {
-                end = entry->coarse[ii+1].ref_ep_fine_id;
-            } else {
-                end = entry->num_ep_fine;
-            }
-            for (jj = start; jj < end; jj++) {
+    *time = idx->pts[jj];
+    return idx->spn[jj];
+}
 
-                if (entry->fine[jj].is_angle_change_point) {
-                    *time = ((uint64_t)(entry->coarse[ii].pts_ep & ~0x01) << 18) +
-                            ((uint64_t)entry->fine[jj].pts_ep << 8);
-                    return coarse_spn + entry->fine[jj].spn_ep;
-                }
-            }
+unsigned
+clpi_angle_change_points(const CLPI_CL *cl, uint32_t **spn, uint32_t **pts)
+{
+    const CLPI_EP_INDEX *idx;
+    const CLPI_EP_FINE *fine;
+    unsigned count = 0;
+    int jj;
+
+    *spn = NULL;
+    *pts = NULL;
+
+    idx = _ep_index(cl);
+    if (!idx) {
+        return 0;
+    }
+
+    *spn = malloc(idx->num_ep * sizeof(uint32_t));
+    *pts = malloc(idx->num_ep * sizeof(uint32_t));
+    if (!*spn || !*pts) {
+        X_FREE(*spn);
+        X_FREE(*pts);
+        return 0;
+    }
+
+    fine = cl->cpi.entry[0].fine;
+    for (jj = 0; jj < idx->num_ep; jj++) {
+        if (fine[jj].is_angle_change_point) {
+            (*spn)[count] = idx->spn[jj];
+            (*pts)[count] = idx->pts[jj];
+            count++;
         }
-        *time = 0;
-        return cl->clip.num_source_packets;
     }
-    *time = ((uint64_t)(entry->coarse[ii].pts_ep & ~0x01) << 18) +
-            ((uint64_t)entry->fine[jj].pts_ep << 8);
-    return coarse_spn + entry->fine[jj].spn_ep;
+
+    return count;
 }
 
 static int
@@ -642,14 +711,13 @@ _clean_cpi(CLPI_CPI *cpi)
     X_FREE(cpi->entry);
 }
 
-void
-clpi_free(CLPI_CL *cl)
+/* refcnt cleanup callback: free clip info contents */
+static void
+_clean_clpi(void *p)
 {
+    CLPI_CL *cl = (CLPI_CL *)p;
     int ii;
 
-    if (cl == NULL) {
-        return;
-    }
     if (cl->clip.atc_delta != NULL) {
         X_FREE(cl->clip.atc_delta);
     }
@@ -663,6 +731,13 @@ clpi_free(CLPI_CL *cl)
     }
 
     _clean_program(&cl->program);
+    if (cl->ep_index != NULL) {
+        for (ii = 0; ii < cl->cpi.num_stream_pid; ii++) {
+            X_FREE(cl->ep_index[ii].pts);
+            X_FREE(cl->ep_index[ii].spn);
+        }
+        X_FREE(cl->ep_index);
+    }
     _clean_cpi(&cl->cpi);
 
     X_FREE(cl->extent_start.point);
@@ -671,17 +746,86 @@ clpi_free(CLPI_CL *cl)
     _clean_cpi(&cl->cpi_ss);
 
     X_FREE(cl->font_info.font);
+}
+
+static size_t
+_cpi_size(const CLPI_CPI *cpi)
+{
+    size_t size = cpi->num_stream_pid * sizeof(CLPI_EP_MAP_ENTRY);
+    int ii;
+
+    for (ii = 0; ii < cpi->num_stream_pid; ii++) {
+        size += cpi->entry[ii].num_ep_coarse * sizeof(CLPI_EP_COARSE);
+        size += cpi->entry[ii].num_ep_fine * sizeof(CLPI_EP_FINE);
+    }
+    return size;
+}
+
+static size_t
+_program_size(const CLPI_PROG_INFO *p)
+{
+    size_t size = p->num_prog * sizeof(CLPI_PROG);
+    int ii;
+
+    for (ii = 0; ii < p->num_prog; ii++) {
+        size += p->progs[ii].num_streams * sizeof(CLPI_PROG_STREAM);
+    }
+    return size;
+}
+
+size_t
+clpi_memory_size(const CLPI_CL *cl)
+{
+    size_t size = sizeof(CLPI_CL);
+    int ii;
+
+    size += cl->clip.atc_delta_count * sizeof(CLPI_ATC_DELTA);
+    size += cl->sequence.num_atc_seq * sizeof(CLPI_ATC_SEQ);
+    for (ii = 0; ii < cl->sequence.num_atc_seq; ii++) {
+        size += cl->sequence.atc_seq[ii].num_stc_seq * sizeof(CLPI_STC_SEQ);
+    }
+
+    size += _program_size(&cl->program);
+    size += _cpi_size(&cl->cpi);
+    if (cl->ep_index) {
+        size += cl->cpi.num_stream_pid * sizeof(CLPI_EP_INDEX);
+        for (ii = 0; ii < cl->cpi.num_stream_pid; ii++) {
+            size += cl->ep_index[ii].num_ep * 2 * sizeof(uint32_t);
+        }
+    }
+
+    size += cl->extent_start.num_point * sizeof(uint32_t);
+    size += _program_size(&cl->program_ss);
+    size += _cpi_size(&cl->cpi_ss);
+    size += cl->font_info.font_count * sizeof(CLPI_FONT);
+
+    return size;
+}
+
+void
+clpi_free(CLPI_CL *cl)
+{
+    /* release reference (object may be shared with disc cache) */
+    bd_refcnt_dec(cl);
+}
 
-    X_FREE(cl);
+static CLPI_CL*
+_clpi_alloc(void)
+{
+    CLPI_CL *cl = refcnt_realloc(NULL, sizeof(CLPI_CL), _clean_clpi);
+    if (cl) {
+        memset(cl, 0, sizeof(CLPI_CL));
+    }
+    return cl;
 }
 
 static CLPI_CL*
-_clpi_parse(BD_FILE_H *fp)
+_clpi_parse(BD_FILE_H *fp, int full)
 {
     BITSTREAM  bits;
     CLPI_CL   *cl;
 
-    cl = calloc(1, sizeof(CLPI_CL));
+    cl = _clpi_alloc();
     if (cl == NULL) {
         BD_DEBUG(DBG_CRIT, "out of memory\n");
         return NULL;
@@ -689,35 +833,31 @@ _clpi_parse(BD_FILE_H *fp)
 
     bs_init(&bits, fp);
     if (!_parse_header(&bits, cl)) {
-        clpi_free(cl);
-        return NULL;
+        goto error;
     }
 
-    if (cl->ext_data_start_addr > 0) {
+    // extension data (3D extents and SS CPI) is not used in playback
+    if (full && cl->ext_data_start_addr > 0) {
         bdmv_parse_extension_data(&bits,
                                    cl->ext_data_start_addr,
                                    _parse_clpi_extension,
                                    cl);
     }
 
-    if (!_parse_clipinfo(&bits, cl)) {
-        clpi_free(cl);
-        return NULL;
-    }
-    if (!_parse_sequence(&bits, cl)) {
-        clpi_free(cl);
-        return NULL;
-    }
-    if (!_parse_program_info(&bits, cl)) {
-        clpi_free(cl);
-        return NULL;
-    }
-    if (!_parse_cpi_info(&bits, cl)) {
-        clpi_free(cl);
-        return NULL;
+    if (!_parse_clipinfo(&bits, cl) ||
+        !_parse_sequence(&bits, cl) ||
+        !_parse_program_info(&bits, cl) ||
+        !_parse_cpi_info(&bits, cl)) {
+        goto error;
     }
 
+    bs_close(&bits);
     return cl;
+
+ error:
+    bs_close(&bits);
+    clpi_free(cl);
+    return NULL;
 }
 
 CLPI_CL*
@@ -732,13 +872,13 @@ clpi_parse(const char *path)
         return NULL;
     }
 
-    cl = _clpi_parse(fp);
+    cl = _clpi_parse(fp, 1);
     file_close(fp);
     return cl;
 }
 
 static CLPI_CL*
-_clpi_get(BD_DISC *disc, const char *dir, const char *file)
+_clpi_get(BD_DISC *disc, const char *dir, const char *file, size_t *size)
 {
     BD_FILE_H *fp;
     CLPI_CL   *cl;
@@ -748,7 +888,8 @@ _clpi_get(BD_DISC *disc, const char *dir, const char *file)
         return NULL;
     }
 
-    cl = _clpi_parse(fp);
+    cl = _clpi_parse(fp, 0);
+    *size = sizeof(CLPI_CL) + (size_t)file_size(fp);
     file_close(fp);
     return cl;
 }
@@ -757,14 +898,20 @@ CLPI_CL*
 clpi_get(BD_DISC *disc, const char *file)
 {
     CLPI_CL *cl;
+    size_t   size = 0;
 
-    cl = _clpi_get(disc, "BDMV" DIR_SEP "CLIPINF", file);
+    cl = disc_cache_get(disc, file);
     if (cl) {
         return cl;
     }
 
-    /* if failed, try backup file */
-    cl = _clpi_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "CLIPINF", file);
+    cl = _clpi_get(disc, "BDMV" DIR_SEP "CLIPINF", file, &size);
+    if (!cl) {
+        /* if failed, try backup file */
+        cl = _clpi_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "CLIPINF", file, &size);
+    }
+
+    disc_cache_put(disc, file, cl, size);
     return cl;
 }
 
@@ -775,7 +922,7 @@ clpi_copy(const CLPI_CL* src_cl)
     int ii, jj;
 
     if (src_cl) {
-        dest_cl = (CLPI_CL*) calloc(1, sizeof(CLPI_CL));
+        dest_cl = _clpi_alloc();
         dest_cl->clip.clip_stream_type = src_cl->clip.clip_stream_type;
         dest_cl->clip.application_type = src_cl->clip.application_type;
         dest_cl->clip.is_atc_delta = src_cl->clip.is_atc_delta;
@@ -849,6 +996,8 @@ clpi_copy(const CLPI_CL* src_cl)
             }
         }
 
+        _build_ep_index(dest_cl);
+
         dest_cl->font_info.font_count = src_cl->font_info.font_count;
         if (dest_cl->font_info.font_count) {
             dest_cl->font_info.font = malloc(dest_cl->font_info.font_count * sizeof(CLPI_FONT));
@@ -23,15 +23,24 @@
 #include "clpi_data.h"
 #include "util/attributes.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 struct bd_disc;
 
 BD_PRIVATE uint32_t clpi_lookup_spn(const CLPI_CL *cl, uint32_t timestamp, int before, uint8_t stc_id);
 BD_PRIVATE uint32_t clpi_access_point(const CLPI_CL *cl, uint32_t pkt, int next, int angle_change, uint32_t *time);
+BD_PRIVATE int clpi_ep_entry(const CLPI_CL *cl, uint32_t pkt);
+/* list angle change points (EP map order). Returns number of points, *spn and *pts are allocated. */
+BD_PRIVATE unsigned clpi_angle_change_points(const CLPI_CL *cl, uint32_t **spn, uint32_t **pts);
 BD_PRIVATE CLPI_CL* clpi_parse(const char *path) BD_ATTR_MALLOC;
+/* returned object is shared (disc cache): must not be modified.
+   Extension data (extent start points, SS program info and CPI) is not parsed. */
 BD_PRIVATE CLPI_CL* clpi_get(struct bd_disc *disc, const char *file);
 BD_PRIVATE CLPI_CL* clpi_copy(const CLPI_CL* src_cl);
+/* approximate heap memory used by parsed clip info (including EP map) */
+BD_PRIVATE size_t clpi_memory_size(const CLPI_CL *cl);
+/* release reference */
 BD_PRIVATE void clpi_free(CLPI_CL *cl);
 
 #endif // _CLPI_PARSE_H_
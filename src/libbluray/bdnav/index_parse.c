@@ -24,6 +24,7 @@
 #include "file/file.h"
 #include "util/bits.h"
 #include "util/logging.h"
+#include "util/refcnt.h"
 #include "util/macro.h"
 #include "util/strutl.h"
 
@@ -179,31 +180,42 @@ static int _parse_header(BITSTREAM *bs, int *index_start, int *extension_data_st
     return 1;
 }
 
+/* refcnt cleanup callback: free index contents */
+static void _clean_index(void *p)
+{
+    INDX_ROOT *index = (INDX_ROOT *)p;
+    X_FREE(index->titles);
+}
+
 static INDX_ROOT *_indx_parse(BD_FILE_H *fp)
 {
     BITSTREAM  bs;
-    INDX_ROOT *index = calloc(1, sizeof(INDX_ROOT));
+    INDX_ROOT *index = refcnt_realloc(NULL, sizeof(INDX_ROOT), _clean_index);
     int        indexes_start, extension_data_start;
 
     if (!index) {
         BD_DEBUG(DBG_CRIT, "out of memory\n");
         return NULL;
     }
+    memset(index, 0, sizeof(INDX_ROOT));
 
     bs_init(&bs, fp);
 
     if (!_parse_header(&bs, &indexes_start, &extension_data_start) ||
         !_parse_app_info(&bs, &index->app_info)) {
 
+        bs_close(&bs);
         indx_free(&index);
         return NULL;
     }
 
     bs_seek_byte(&bs, indexes_start);
     if (!_parse_index(&bs, index)) {
+        bs_close(&bs);
         indx_free(&index);
         return NULL;
     }
+    bs_close(&bs);
 
     if (extension_data_start) {
         BD_DEBUG(DBG_NAV | DBG_CRIT, "index.bdmv: unknown extension data at %d\n", extension_data_start);
@@ -212,7 +224,7 @@ static INDX_ROOT *_indx_parse(BD_FILE_H *fp)
     return index;
 }
 
-static INDX_ROOT *_indx_get(BD_DISC *disc, const char *path)
+static INDX_ROOT *_indx_get(BD_DISC *disc, const char *path, size_t *size)
 {
     BD_FILE_H *fp;
     INDX_ROOT *index;
@@ -223,6 +235,7 @@ static INDX_ROOT *_indx_get(BD_DISC *disc, const char *path)
     }
 
     index = _indx_parse(fp);
+    *size = sizeof(INDX_ROOT) + (size_t)file_size(fp);
     file_close(fp);
     return index;
 }
@@ -230,21 +243,29 @@ static INDX_ROOT *_indx_get(BD_DISC *disc, const char *path)
 INDX_ROOT *indx_get(BD_DISC *disc)
 {
     INDX_ROOT *index;
+    size_t     size = 0;
+
+    index = disc_cache_get(disc, "index.bdmv");
+    if (index) {
+        return index;
+    }
 
-    index = _indx_get(disc, "BDMV" DIR_SEP "index.bdmv");
+    index = _indx_get(disc, "BDMV" DIR_SEP "index.bdmv", &size);
 
     if (!index) {
         /* try backup */
-        index = _indx_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "index.bdmv");
+        index = _indx_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "index.bdmv", &size);
     }
 
+    disc_cache_put(disc, "index.bdmv", index, size);
     return index;
 }
 
 void indx_free(INDX_ROOT **p)
 {
     if (p && *p) {
-        X_FREE((*p)->titles);
-        X_FREE(*p);
+        /* release reference (object may be shared with disc cache) */
+        bd_refcnt_dec(*p);
+        *p = NULL;
     }
 }
@@ -117,7 +117,7 @@ typedef struct indx_root_s {
 
 struct bd_disc;
 
-BD_PRIVATE INDX_ROOT* indx_get(struct bd_disc *disc);  /* parse index.bdmv */
+BD_PRIVATE INDX_ROOT* indx_get(struct bd_disc *disc);  /* parse index.bdmv. Returned object is shared (disc cache): must not be modified. */
 BD_PRIVATE void       indx_free(INDX_ROOT **index);
 
 #endif // _INDX_PARSE_H_
@@ -56,6 +56,16 @@
 #define MAX_META_FILE_SIZE  0xfffff
 
 #ifdef HAVE_LIBXML2
+/* libxml2 strings are copied to malloc()ed memory (objects may come from cache, see meta_free()) */
+static char *_xml_str(xmlChar *tmp)
+{
+    char *s = tmp ? str_dup((const char *)tmp) : NULL;
+    if (tmp) {
+        XML_FREE(tmp);
+    }
+    return s;
+}
+
 static void _parseManifestNode(xmlNode * a_node, META_DL *disclib)
 {
     xmlNode *cur_node = NULL;
@@ -65,10 +75,10 @@ static void _parseManifestNode(xmlNode * a_node, META_DL *disclib)
         if (cur_node->type == XML_ELEMENT_NODE) {
             if (xmlStrEqual(cur_node->parent->name, BAD_CAST_CONST "title")) {
                 if (xmlStrEqual(cur_node->name, BAD_CAST_CONST "name")) {
-                    disclib->di_name = (char*)xmlNodeGetContent(cur_node);
+                    disclib->di_name = _xml_str(xmlNodeGetContent(cur_node));
                 }
                 if (xmlStrEqual(cur_node->name, BAD_CAST_CONST "alternative")) {
-                    disclib->di_alternative = (char*)xmlNodeGetContent(cur_node);
+                    disclib->di_alternative = _xml_str(xmlNodeGetContent(cur_node));
                 }
                 if (xmlStrEqual(cur_node->name, BAD_CAST_CONST "numSets")) {
                     disclib->di_num_sets = atoi((char*)(tmp = xmlNodeGetContent(cur_node)));
@@ -85,7 +95,7 @@ static void _parseManifestNode(xmlNode * a_node, META_DL *disclib)
                     disclib->toc_count++;
                     disclib->toc_entries = realloc(disclib->toc_entries, (disclib->toc_count*sizeof(META_TITLE)));
                     disclib->toc_entries[i].title_number = atoi((const char*)tmp);
-                    disclib->toc_entries[i].title_name = (char*)xmlNodeGetContent(cur_node);
+                    disclib->toc_entries[i].title_name = _xml_str(xmlNodeGetContent(cur_node));
                     XML_FREE(tmp);
                 }
             }
@@ -94,7 +104,8 @@ static void _parseManifestNode(xmlNode * a_node, META_DL *disclib)
                     uint8_t i = disclib->thumb_count;
                     disclib->thumb_count++;
                     disclib->thumbnails = realloc(disclib->thumbnails, (disclib->thumb_count*sizeof(META_THUMBNAIL)));
-                    disclib->thumbnails[i].path = (char *)tmp;
+                    disclib->thumbnails[i].path = str_dup((const char *)tmp);
+                    XML_FREE(tmp);
                     if ((tmp = xmlGetProp(cur_node, BAD_CAST_CONST "size"))) {
                         int x = 0, y = 0;
                         sscanf((const char*)tmp, "%ix%i", &x, &y);
@@ -172,7 +183,7 @@ META_ROOT *meta_parse(BD_DISC *disc)
                     root->dl_entries[i].toc_entries = NULL;
                     root->dl_entries[i].thumbnails = NULL;
                     _parseManifestNode(root_element, &root->dl_entries[i]);
-                    XML_FREE(doc);
+                    xmlFreeDoc(doc);
                 }
             X_FREE(data);
         }
@@ -188,7 +199,6 @@ META_ROOT *meta_parse(BD_DISC *disc)
 
 const META_DL *meta_get(const META_ROOT *meta_root, const char *language_code)
 {
-#ifdef HAVE_LIBXML2
     unsigned i;
 
     if (meta_root == NULL || meta_root->dl_count == 0) {
@@ -214,36 +224,28 @@ const META_DL *meta_get(const META_ROOT *meta_root, const char *language_code)
 
     BD_DEBUG(DBG_DIR, "requested disclib language '%s' or default '"DEFAULT_LANGUAGE"' not found, using '%s' instead\n", language_code, meta_root->dl_entries[0].language_code);
     return &meta_root->dl_entries[0];
-#else
-    (void)meta_root;
-    (void)language_code;
-    return NULL;
-#endif
 }
 
 void meta_free(META_ROOT **p)
 {
-    (void)p;
-#ifdef HAVE_LIBXML2
     if (p && *p)
     {
         uint8_t i;
         for (i = 0; i < (*p)->dl_count; i++) {
             uint32_t t;
             for (t = 0; t < (*p)->dl_entries[i].toc_count; t++) {
-                XML_FREE((*p)->dl_entries[i].toc_entries[t].title_name);
+                X_FREE((*p)->dl_entries[i].toc_entries[t].title_name);
             }
             for (t = 0; t < (*p)->dl_entries[i].thumb_count; t++) {
-                XML_FREE((*p)->dl_entries[i].thumbnails[t].path);
+                X_FREE((*p)->dl_entries[i].thumbnails[t].path);
             }
             X_FREE((*p)->dl_entries[i].toc_entries);
             X_FREE((*p)->dl_entries[i].thumbnails);
             X_FREE((*p)->dl_entries[i].filename);
-            XML_FREE((*p)->dl_entries[i].di_name);
-            XML_FREE((*p)->dl_entries[i].di_alternative);
+            X_FREE((*p)->dl_entries[i].di_name);
+            X_FREE((*p)->dl_entries[i].di_alternative);
         }
         X_FREE((*p)->dl_entries);
         X_FREE(*p);
     }
-#endif
 }
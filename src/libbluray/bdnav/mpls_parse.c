@@ -27,6 +27,7 @@
 #include "file/file.h"
 #include "util/bits.h"
 #include "util/logging.h"
+#include "util/refcnt.h"
 #include "util/macro.h"
 
 #include <stdlib.h>
@@ -645,7 +646,7 @@ _clean_subpath(MPLS_SUB *sp)
 }
 
 static int
-_parse_playlistmark(BITSTREAM *bits, MPLS_PL *pl)
+_parse_playlistmark(BITSTREAM *bits, MPLS_PL *pl, int full)
 {
     int64_t len;
     int ii;
@@ -662,6 +663,9 @@ _parse_playlistmark(BITSTREAM *bits, MPLS_PL *pl)
 
     // Then get the number of marks
     pl->mark_count = bs_read(bits, 16);
+    if (!full) {
+        return 1;
+    }
 
     plm = calloc(pl->mark_count, sizeof(MPLS_PLM));
     for (ii = 0; ii < pl->mark_count; ii++) {
@@ -677,7 +681,7 @@ _parse_playlistmark(BITSTREAM *bits, MPLS_PL *pl)
 }
 
 static int
-_parse_playlist(BITSTREAM *bits, MPLS_PL *pl)
+_parse_playlist(BITSTREAM *bits, MPLS_PL *pl, int full)
 {
     int64_t len;
     int ii;
@@ -709,6 +713,11 @@ _parse_playlist(BITSTREAM *bits, MPLS_PL *pl)
     }
     pl->play_item = pi;
 
+    if (!full) {
+        pl->sub_count = 0;
+        return 1;
+    }
+
     sub_path = calloc(pl->sub_count,  sizeof(MPLS_SUB));
     for (ii = 0; ii < pl->sub_count; ii++)
     {
@@ -724,14 +733,13 @@ _parse_playlist(BITSTREAM *bits, MPLS_PL *pl)
     return 1;
 }
 
+/* refcnt cleanup callback: free playlist contents */
 static void
-_clean_playlist(MPLS_PL *pl)
+_clean_playlist(void *p)
 {
+    MPLS_PL *pl = (MPLS_PL *)p;
     int ii;
 
-    if (pl == NULL) {
-        return;
-    }
     if (pl->play_item != NULL) {
         for (ii = 0; ii < pl->list_count; ii++) {
             _clean_playitem(&pl->play_item[ii]);
@@ -751,13 +759,80 @@ _clean_playlist(MPLS_PL *pl)
         X_FREE(pl->ext_sub_path);
     }
     X_FREE(pl->play_mark);
-    X_FREE(pl);
+}
+
+static size_t
+_stn_size(const MPLS_STN *stn)
+{
+    size_t size;
+
+    size = (stn->num_video + stn->num_audio + stn->num_pg + stn->num_pip_pg + stn->num_ig +
+            stn->num_secondary_audio + stn->num_secondary_video) * sizeof(MPLS_STREAM);
+    if (stn->secondary_audio) {
+        size += stn->secondary_audio->sa_num_primary_audio_ref;
+    }
+    if (stn->secondary_video) {
+        size += stn->secondary_video->sv_num_secondary_audio_ref;
+        size += stn->secondary_video->sv_num_pip_pg_ref;
+    }
+    return size;
+}
+
+static size_t
+_subpath_size(const MPLS_SUB *sp)
+{
+    size_t size = sp->sub_playitem_count * sizeof(MPLS_SUB_PI);
+    int ii;
+
+    for (ii = 0; ii < sp->sub_playitem_count; ii++) {
+        size += sp->sub_play_item[ii].clip_count * sizeof(MPLS_CLIP);
+    }
+    return size;
+}
+
+size_t
+mpls_memory_size(const MPLS_PL *pl)
+{
+    size_t size = sizeof(MPLS_PL);
+    int ii;
+
+    if (pl->play_item) {
+        size += pl->list_count * sizeof(MPLS_PI);
+        for (ii = 0; ii < pl->list_count; ii++) {
+            size += pl->play_item[ii].angle_count * sizeof(MPLS_CLIP);
+            size += _stn_size(&pl->play_item[ii].stn);
+        }
+    }
+    if (pl->sub_path) {
+        size += pl->sub_count * sizeof(MPLS_SUB);
+        for (ii = 0; ii < pl->sub_count; ii++) {
+            size += _subpath_size(&pl->sub_path[ii]);
+        }
+    }
+    if (pl->ext_sub_path) {
+        size += pl->ext_sub_count * sizeof(MPLS_SUB);
+        for (ii = 0; ii < pl->ext_sub_count; ii++) {
+            size += _subpath_size(&pl->ext_sub_path[ii]);
+        }
+    }
+    if (pl->play_mark) {
+        size += pl->mark_count * sizeof(MPLS_PLM);
+    }
+    if (pl->ext_pip_data) {
+        size += pl->ext_pip_data_count * sizeof(MPLS_PIP_METADATA);
+        for (ii = 0; ii < pl->ext_pip_data_count; ii++) {
+            size += pl->ext_pip_data[ii].data_count * sizeof(MPLS_PIP_DATA);
+        }
+    }
+
+    return size;
 }
 
 void
 mpls_free(MPLS_PL *pl)
 {
-    _clean_playlist(pl);
+    /* release reference (object may be shared with disc cache) */
+    bd_refcnt_dec(pl);
 }
 
 static int
@@ -903,39 +978,36 @@ _parse_mpls_extension(BITSTREAM *bits, int id1, int id2, void *handle)
 }
 
 static MPLS_PL*
-_mpls_parse(BD_FILE_H *fp)
+_mpls_parse(BD_FILE_H *fp, int full)
 {
     BITSTREAM  bits;
     MPLS_PL   *pl = NULL;
 
-    pl = calloc(1, sizeof(MPLS_PL));
+    pl = refcnt_realloc(NULL, sizeof(MPLS_PL), _clean_playlist);
     if (pl == NULL) {
         BD_DEBUG(DBG_CRIT, "out of memory\n");
         return NULL;
     }
+    memset(pl, 0, sizeof(MPLS_PL));
 
     bs_init(&bits, fp);
 
-    if (!_parse_header(&bits, pl)) {
-        _clean_playlist(pl);
-        return NULL;
-    }
-    if (!_parse_playlist(&bits, pl)) {
-        _clean_playlist(pl);
-        return NULL;
-    }
-    if (!_parse_playlistmark(&bits, pl)) {
-        _clean_playlist(pl);
+    if (!_parse_header(&bits, pl) ||
+        !_parse_playlist(&bits, pl, full) ||
+        !_parse_playlistmark(&bits, pl, full)) {
+        bs_close(&bits);
+        mpls_free(pl);
         return NULL;
     }
 
-    if (pl->ext_pos > 0) {
+    if (full && pl->ext_pos > 0) {
         bdmv_parse_extension_data(&bits,
                                   pl->ext_pos,
                                   _parse_mpls_extension,
                                   pl);
     }
 
+    bs_close(&bits);
     return pl;
 }
 
@@ -951,13 +1023,13 @@ mpls_parse(const char *path)
         return NULL;
     }
 
-    pl = _mpls_parse(fp);
+    pl = _mpls_parse(fp, 1);
     file_close(fp);
     return pl;
 }
 
 static MPLS_PL*
-_mpls_get(BD_DISC *disc, const char *dir, const char *file)
+_mpls_get(BD_DISC *disc, const char *dir, const char *file, int full, size_t *size)
 {
     MPLS_PL   *pl;
     BD_FILE_H *fp;
@@ -967,22 +1039,55 @@ _mpls_get(BD_DISC *disc, const char *dir, const char *file)
         return NULL;
     }
 
-    pl = _mpls_parse(fp);
+    pl = _mpls_parse(fp, full);
+    *size = sizeof(MPLS_PL) + (size_t)file_size(fp);
     file_close(fp);
     return pl;
 }
 
+static MPLS_PL*
+_mpls_get_file(BD_DISC *disc, const char *file, int full, size_t *size)
+{
+    MPLS_PL *pl;
+
+    pl = _mpls_get(disc, "BDMV" DIR_SEP "PLAYLIST", file, full, size);
+    if (pl) {
+        return pl;
+    }
+
+    /* if failed, try backup file */
+    pl = _mpls_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "PLAYLIST", file, full, size);
+    return pl;
+}
+
 MPLS_PL*
 mpls_get(BD_DISC *disc, const char *file)
 {
     MPLS_PL *pl;
+    size_t   size = 0;
 
-    pl = _mpls_get(disc, "BDMV" DIR_SEP "PLAYLIST", file);
+    pl = disc_cache_get(disc, file);
     if (pl) {
         return pl;
     }
 
-    /* if failed, try backup file */
-    pl = _mpls_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "PLAYLIST", file);
+    pl = _mpls_get_file(disc, file, 1, &size);
+    disc_cache_put(disc, file, pl, size);
     return pl;
 }
+
+MPLS_PL*
+mpls_scan(BD_DISC *disc, const char *file)
+{
+    MPLS_PL *pl;
+    size_t   size = 0;
+
+    /* fully parsed playlist is a superset */
+    pl = disc_cache_get(disc, file);
+    if (pl) {
+        return pl;
+    }
+
+    /* partially parsed playlist is not cached */
+    return _mpls_get_file(disc, file, 0, &size);
+}
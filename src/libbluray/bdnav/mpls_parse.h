@@ -25,6 +25,7 @@
 
 #include "util/attributes.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define BD_MARK_ENTRY   0x01
@@ -180,8 +181,14 @@ typedef struct mpls_pl
 struct bd_disc;
 
 BD_PRIVATE MPLS_PL* mpls_parse(const char *path) BD_ATTR_MALLOC;
+/* returned object is shared (disc cache): must not be modified */
 BD_PRIVATE MPLS_PL* mpls_get(struct bd_disc *disc, const char *file);
+/* parse only play items and mark count (no sub paths, marks or extension data) */
+BD_PRIVATE MPLS_PL* mpls_scan(struct bd_disc *disc, const char *file);
+/* release reference */
 BD_PRIVATE void mpls_free(MPLS_PL *pl);
+/* approximate heap memory used by parsed playlist */
+BD_PRIVATE size_t mpls_memory_size(const MPLS_PL *pl);
 
 BD_PRIVATE int  mpls_parse_uo(uint8_t *buf, BD_UO_MASK *uo);
 
@@ -0,0 +1,608 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "nav_cache.h"
+
+#include "meta_data.h"
+#include "meta_parse.h"
+
+#include "disc/disc.h"
+
+#include "file/dirs.h"
+#include "file/file.h"
+#include "util/logging.h"
+#include "util/macro.h"
+#include "util/strutl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NAV_CACHE_SIG      ('B' << 24 | 'D' << 16 | 'N' << 8 | 'C')
+#define NAV_CACHE_VERSION  1
+#define NAV_CACHE_HDR_SIZE 24
+#define NAV_CACHE_ENT_SIZE 18  /* name (10) + mpls_id + duration */
+
+#define META_CACHE_SIG     ('B' << 24 | 'D' << 16 | 'M' << 8 | 'C')
+#define META_CACHE_VERSION 1
+#define META_CACHE_NO_STR  0xffffffff  /* NULL string */
+
+/*
+ * disc identity
+ */
+
+static uint64_t _hash(uint64_t h, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    /* FNV-1a */
+    while (size--) {
+        h ^= *p++;
+        h *= UINT64_C(0x100000001b3);
+    }
+    return h;
+}
+
+static uint64_t _hash_u64(uint64_t h, uint64_t v)
+{
+    uint8_t  b[8];
+    unsigned ii;
+
+    /* fixed width and byte order: same key on all platforms */
+    for (ii = 0; ii < 8; ii++) {
+        b[ii] = (uint8_t)(v >> (56 - 8 * ii));
+    }
+    return _hash(h, b, sizeof(b));
+}
+
+/* hash of file name, size and contents. Unreadable file is hashed as empty and counted in *missing. */
+static uint64_t _hash_file(BD_DISC *disc, const char *dir, const char *file, unsigned *missing)
+{
+    uint64_t h = UINT64_C(0xcbf29ce484222325);
+    uint8_t *data;
+    size_t   size;
+
+    size = disc_read_file(disc, dir, file, &data);
+    h = _hash(h, file, strlen(file) + 1);
+    h = _hash_u64(h, data ? (uint64_t)size : 0);
+    if (data) {
+        h = _hash(h, data, size);
+        X_FREE(data);
+    } else {
+        (*missing)++;
+    }
+    return h;
+}
+
+/* sum of file hashes (independent of directory order) */
+static uint64_t _hash_dir(BD_DISC *disc, const char *dir, unsigned *count, unsigned *missing)
+{
+    BD_DIR_H  *d;
+    BD_DIRENT  ent;
+    uint64_t   h = 0;
+
+    *count = 0;
+
+    d = disc_open_dir(disc, dir);
+    if (!d) {
+        return 0;
+    }
+    while (!dir_read(d, &ent)) {
+        if (ent.d_name[0] != '.') {
+            h += _hash_file(disc, dir, ent.d_name, missing);
+            (*count)++;
+        }
+    }
+    dir_close(d);
+
+    return h;
+}
+
+char *nav_cache_key(BD_DISC *disc)
+{
+    const char *volume_id;
+    uint64_t    h = UINT64_C(0xcbf29ce484222325);
+    unsigned    count, missing = 0, optional = 0;
+
+    volume_id = disc_volume_id(disc);
+    if (volume_id) {
+        h = _hash(h, volume_id, strlen(volume_id) + 1);
+    }
+
+    /* contents of all navigation files parsed objects are derived from */
+    h = _hash_u64(h, _hash_file(disc, "BDMV", "index.bdmv", &missing));
+    h = _hash_u64(h, _hash_file(disc, "BDMV", "MovieObject.bdmv", &optional));
+    h = _hash_u64(h, _hash_dir(disc, "BDMV" DIR_SEP "BDJO", &count, &missing));
+    h = _hash_u64(h, _hash_dir(disc, "BDMV" DIR_SEP "CLIPINF", &count, &missing));
+    h = _hash_u64(h, _hash_dir(disc, "BDMV" DIR_SEP "PLAYLIST", &count, &missing));
+
+    /* incomplete identity could match another disc */
+    if (!count || missing) {
+        BD_DEBUG(DBG_NAV, "disc identity not available (%u unreadable files)\n", missing);
+        return NULL;
+    }
+
+    return str_printf("%08x%08x", (unsigned)(h >> 32), (unsigned)h);
+}
+
+/*
+ * cache files
+ */
+
+static char *_cache_path(const char *name)
+{
+    char *cache_home = file_get_cache_home();
+    char *path;
+
+    if (!cache_home || !name) {
+        X_FREE(cache_home);
+        return NULL;
+    }
+
+    path = str_printf("%s" DIR_SEP "bluray" DIR_SEP "navcache" DIR_SEP "%s", cache_home, name);
+    X_FREE(cache_home);
+    return path;
+}
+
+static char *_cache_file(const char *key, uint32_t flags, uint32_t min_title_length)
+{
+    char *name = str_printf("%s_%02x_%u.bin", key, flags, min_title_length);
+    char *path = _cache_path(name);
+    X_FREE(name);
+    return path;
+}
+
+static uint8_t *_read_cache_file(const char *path, size_t min_size, size_t *size)
+{
+    BD_FILE_H *fp;
+    uint8_t   *data = NULL;
+    int64_t    len;
+
+    fp = file_open_default()(path, "rb");
+    if (!fp) {
+        return NULL;
+    }
+
+    len = file_size(fp);
+    if (len >= (int64_t)min_size && len < 16*1024*1024) {
+        data = malloc((size_t)len);
+    }
+    if (data && (int64_t)file_read(fp, data, len) != len) {
+        X_FREE(data);
+    }
+    file_close(fp);
+
+    *size = data ? (size_t)len : 0;
+    return data;
+}
+
+static void _write_cache_file(const char *path, const uint8_t *data, size_t size)
+{
+    BD_FILE_H *fp;
+
+    file_mkdirs(path);
+    fp = file_open_default()(path, "wb");
+    if (fp) {
+        int64_t wrote = fp->write(fp, data, (int64_t)size);
+        file_close(fp);
+        if (wrote != (int64_t)size) {
+            BD_DEBUG(DBG_NAV | DBG_CRIT, "error writing cache file %s\n", path);
+            file_unlink(path);
+        }
+    }
+}
+
+static uint32_t _get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static void _put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static NAV_TITLE_LIST *_parse(const uint8_t *data, size_t size, uint32_t flags, uint32_t min_title_length)
+{
+    NAV_TITLE_LIST *title_list;
+    uint32_t        count, ii;
+
+    if (size < NAV_CACHE_HDR_SIZE ||
+        _get32(data)      != NAV_CACHE_SIG ||
+        _get32(data + 4)  != NAV_CACHE_VERSION ||
+        _get32(data + 8)  != flags ||
+        _get32(data + 12) != min_title_length) {
+        return NULL;
+    }
+
+    count = _get32(data + 16);
+    if (!count || (size - NAV_CACHE_HDR_SIZE) / NAV_CACHE_ENT_SIZE != count ||
+        _get32(data + 20) >= count) {
+        return NULL;
+    }
+
+    title_list = calloc(1, sizeof(NAV_TITLE_LIST));
+    if (!title_list) {
+        return NULL;
+    }
+    title_list->title_info = calloc(count, sizeof(NAV_TITLE_INFO));
+    if (!title_list->title_info) {
+        X_FREE(title_list);
+        return NULL;
+    }
+
+    title_list->count          = count;
+    title_list->main_title_idx = _get32(data + 20);
+
+    data += NAV_CACHE_HDR_SIZE;
+    for (ii = 0; ii < count; ii++, data += NAV_CACHE_ENT_SIZE) {
+        NAV_TITLE_INFO *ti = &title_list->title_info[ii];
+        memcpy(ti->name, data, 10);
+        ti->name[10] = 0;
+        ti->mpls_id  = _get32(data + 10);
+        ti->duration = _get32(data + 14);
+        ti->ref      = ii;
+    }
+
+    return title_list;
+}
+
+NAV_TITLE_LIST *nav_cache_load(const char *key, uint32_t flags, uint32_t min_title_length)
+{
+    NAV_TITLE_LIST *title_list = NULL;
+    char           *path;
+    uint8_t        *data;
+    size_t          size;
+
+    if (!key) {
+        return NULL;
+    }
+
+    path = _cache_file(key, flags, min_title_length);
+    if (!path) {
+        return NULL;
+    }
+
+    data = _read_cache_file(path, NAV_CACHE_HDR_SIZE, &size);
+    if (data) {
+        title_list = _parse(data, size, flags, min_title_length);
+        X_FREE(data);
+
+        if (!title_list) {
+            BD_DEBUG(DBG_NAV | DBG_CRIT, "invalid title list cache file %s\n", path);
+        } else {
+            BD_DEBUG(DBG_NAV, "title list loaded from %s\n", path);
+        }
+    }
+
+    X_FREE(path);
+    return title_list;
+}
+
+void nav_cache_save(const char *key, uint32_t flags, uint32_t min_title_length,
+                    const NAV_TITLE_LIST *title_list)
+{
+    char      *path;
+    uint8_t   *data, *p;
+    size_t     size;
+    unsigned   ii;
+
+    if (!key || !title_list || !title_list->count) {
+        return;
+    }
+
+    size = NAV_CACHE_HDR_SIZE + (size_t)title_list->count * NAV_CACHE_ENT_SIZE;
+    data = calloc(1, size);
+    if (!data) {
+        return;
+    }
+
+    _put32(data,      NAV_CACHE_SIG);
+    _put32(data + 4,  NAV_CACHE_VERSION);
+    _put32(data + 8,  flags);
+    _put32(data + 12, min_title_length);
+    _put32(data + 16, title_list->count);
+    _put32(data + 20, title_list->main_title_idx);
+
+    p = data + NAV_CACHE_HDR_SIZE;
+    for (ii = 0; ii < title_list->count; ii++, p += NAV_CACHE_ENT_SIZE) {
+        const NAV_TITLE_INFO *ti = &title_list->title_info[ii];
+        strncpy((char *)p, ti->name, 10);
+        _put32(p + 10, ti->mpls_id);
+        _put32(p + 14, ti->duration);
+    }
+
+    path = _cache_file(key, flags, min_title_length);
+    if (path) {
+        _write_cache_file(path, data, size);
+        X_FREE(path);
+    }
+
+    X_FREE(data);
+}
+
+/*
+ * disc library metadata
+ */
+
+typedef struct {
+    uint8_t *data;
+    size_t   size;
+    size_t   alloc;
+    int      error;
+} META_WRITER;
+
+static void _w_bytes(META_WRITER *w, const void *p, size_t len)
+{
+    if (w->error) {
+        return;
+    }
+    if (w->size + len > w->alloc) {
+        size_t   new_alloc = BD_MAX(2 * w->alloc, w->size + len + 256);
+        uint8_t *tmp = realloc(w->data, new_alloc);
+        if (!tmp) {
+            w->error = 1;
+            return;
+        }
+        w->data  = tmp;
+        w->alloc = new_alloc;
+    }
+    memcpy(w->data + w->size, p, len);
+    w->size += len;
+}
+
+static void _w_u32(META_WRITER *w, uint32_t v)
+{
+    uint8_t b[4];
+    _put32(b, v);
+    _w_bytes(w, b, 4);
+}
+
+static void _w_str(META_WRITER *w, const char *s)
+{
+    if (!s) {
+        _w_u32(w, META_CACHE_NO_STR);
+        return;
+    }
+    _w_u32(w, (uint32_t)strlen(s));
+    _w_bytes(w, s, strlen(s));
+}
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    int            error;
+} META_READER;
+
+static uint32_t _r_u32(META_READER *r)
+{
+    uint32_t v;
+    if (r->error || r->end - r->p < 4) {
+        r->error = 1;
+        return 0;
+    }
+    v = _get32(r->p);
+    r->p += 4;
+    return v;
+}
+
+static char *_r_str(META_READER *r)
+{
+    uint32_t len = _r_u32(r);
+    char    *s;
+
+    if (r->error || len == META_CACHE_NO_STR) {
+        return NULL;
+    }
+    if ((size_t)(r->end - r->p) < len || !(s = malloc((size_t)len + 1))) {
+        r->error = 1;
+        return NULL;
+    }
+    memcpy(s, r->p, len);
+    s[len] = 0;
+    r->p += len;
+    return s;
+}
+
+static META_ROOT *_parse_meta(const uint8_t *data, size_t size)
+{
+    META_READER r = { data, data + size, 0 };
+    META_ROOT  *meta;
+    uint32_t    ii, jj;
+
+    if (_r_u32(&r) != META_CACHE_SIG || _r_u32(&r) != META_CACHE_VERSION) {
+        return NULL;
+    }
+
+    meta = calloc(1, sizeof(META_ROOT));
+    if (!meta) {
+        return NULL;
+    }
+
+    meta->dl_count = (uint8_t)_r_u32(&r);
+    if (meta->dl_count) {
+        meta->dl_entries = calloc(meta->dl_count, sizeof(META_DL));
+        if (!meta->dl_entries) {
+            meta->dl_count = 0;
+            r.error = 1;
+        }
+    }
+
+    for (ii = 0; ii < meta->dl_count && !r.error; ii++) {
+        META_DL *dl  = &meta->dl_entries[ii];
+        char    *lang = _r_str(&r);
+
+        if (lang) {
+            strncpy(dl->language_code, lang, 3);
+            X_FREE(lang);
+        }
+        dl->filename       = _r_str(&r);
+        dl->di_name        = _r_str(&r);
+        dl->di_alternative = _r_str(&r);
+        dl->di_num_sets    = (uint8_t)_r_u32(&r);
+        dl->di_set_number  = (uint8_t)_r_u32(&r);
+
+        dl->toc_count = _r_u32(&r);
+        if (dl->toc_count > (size_t)(r.end - r.p) / 8) {
+            /* each entry takes at least 8 bytes */
+            dl->toc_count = 0;
+            r.error = 1;
+        }
+        if (dl->toc_count) {
+            dl->toc_entries = calloc(dl->toc_count, sizeof(META_TITLE));
+            if (!dl->toc_entries) {
+                dl->toc_count = 0;
+                r.error = 1;
+            }
+        }
+        for (jj = 0; jj < dl->toc_count; jj++) {
+            dl->toc_entries[jj].title_number = _r_u32(&r);
+            dl->toc_entries[jj].title_name   = _r_str(&r);
+        }
+
+        dl->thumb_count = (uint8_t)_r_u32(&r);
+        if (dl->thumb_count) {
+            dl->thumbnails = calloc(dl->thumb_count, sizeof(META_THUMBNAIL));
+            if (!dl->thumbnails) {
+                dl->thumb_count = 0;
+                r.error = 1;
+            }
+        }
+        for (jj = 0; jj < dl->thumb_count; jj++) {
+            dl->thumbnails[jj].path = _r_str(&r);
+            dl->thumbnails[jj].xres = _r_u32(&r);
+            dl->thumbnails[jj].yres = _r_u32(&r);
+        }
+    }
+
+    if (r.error || r.p != r.end) {
+        meta_free(&meta);
+    }
+    return meta;
+}
+
+/* disc key does not cover metadata files */
+static char *_meta_cache_file(BD_DISC *disc, const char *key)
+{
+    BD_DIR_H  *dir;
+    BD_DIRENT  ent;
+    uint64_t   h = UINT64_C(0xcbf29ce484222325);
+    char      *name, *path;
+
+    dir = disc_open_dir(disc, "BDMV" DIR_SEP "META" DIR_SEP "DL");
+    if (dir) {
+        while (!dir_read(dir, &ent)) {
+            if (ent.d_name[0] != '.') {
+                h = _hash(h, ent.d_name, strlen(ent.d_name) + 1);
+            }
+        }
+        dir_close(dir);
+    }
+
+    name = str_printf("%s_meta_%08x.bin", key, (unsigned)(h ^ (h >> 32)));
+    path = _cache_path(name);
+    X_FREE(name);
+    return path;
+}
+
+META_ROOT *nav_cache_load_meta(BD_DISC *disc, const char *key)
+{
+    META_ROOT *meta = NULL;
+    char      *path;
+    uint8_t   *data;
+    size_t     size;
+
+    if (!key) {
+        return NULL;
+    }
+
+    path = _meta_cache_file(disc, key);
+    if (!path) {
+        return NULL;
+    }
+
+    data = _read_cache_file(path, 12, &size);
+    if (data) {
+        meta = _parse_meta(data, size);
+        X_FREE(data);
+
+        if (!meta) {
+            BD_DEBUG(DBG_NAV | DBG_CRIT, "invalid metadata cache file %s\n", path);
+        } else {
+            BD_DEBUG(DBG_NAV, "disc metadata loaded from %s\n", path);
+        }
+    }
+
+    X_FREE(path);
+    return meta;
+}
+
+void nav_cache_save_meta(BD_DISC *disc, const char *key, const META_ROOT *meta)
+{
+    META_WRITER w = { NULL, 0, 0, 0 };
+    char       *path;
+    unsigned    ii, jj;
+
+    if (!key || !meta) {
+        return;
+    }
+
+    _w_u32(&w, META_CACHE_SIG);
+    _w_u32(&w, META_CACHE_VERSION);
+    _w_u32(&w, meta->dl_count);
+
+    for (ii = 0; ii < meta->dl_count; ii++) {
+        const META_DL *dl = &meta->dl_entries[ii];
+
+        _w_str(&w, dl->language_code);
+        _w_str(&w, dl->filename);
+        _w_str(&w, dl->di_name);
+        _w_str(&w, dl->di_alternative);
+        _w_u32(&w, dl->di_num_sets);
+        _w_u32(&w, dl->di_set_number);
+
+        _w_u32(&w, dl->toc_count);
+        for (jj = 0; jj < dl->toc_count; jj++) {
+            _w_u32(&w, dl->toc_entries[jj].title_number);
+            _w_str(&w, dl->toc_entries[jj].title_name);
+        }
+
+        _w_u32(&w, dl->thumb_count);
+        for (jj = 0; jj < dl->thumb_count; jj++) {
+            _w_str(&w, dl->thumbnails[jj].path);
+            _w_u32(&w, dl->thumbnails[jj].xres);
+            _w_u32(&w, dl->thumbnails[jj].yres);
+        }
+    }
+
+    path = _meta_cache_file(disc, key);
+    if (path && !w.error) {
+        _write_cache_file(path, w.data, w.size);
+    }
+
+    X_FREE(path);
+    X_FREE(w.data);
+}
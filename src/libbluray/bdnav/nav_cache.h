@@ -0,0 +1,52 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined(_NAV_CACHE_H_)
+#define _NAV_CACHE_H_
+
+#include "navigation.h"
+
+#include "util/attributes.h"
+
+#include <stdint.h>
+
+/*
+ * Persistent title list and disc metadata cache.
+ *
+ * Cache files are stored in user cache directory and keyed by disc identity
+ * (UDF volume id and contents of index.bdmv, MovieObject.bdmv,
+ * playlist, clip info and BD-J object files).
+ */
+
+struct bd_disc;
+struct meta_root;
+
+/* Returns NULL if disc identity can't be determined.
+ * AACS disc ID is not used: it is not known before AACS is initialized (lazy decryption init). */
+BD_PRIVATE char *nav_cache_key(struct bd_disc *disc) BD_ATTR_MALLOC;
+
+BD_PRIVATE NAV_TITLE_LIST *nav_cache_load(const char *key, uint32_t flags, uint32_t min_title_length) BD_ATTR_MALLOC;
+BD_PRIVATE void            nav_cache_save(const char *key, uint32_t flags, uint32_t min_title_length,
+                                          const NAV_TITLE_LIST *title_list);
+
+/* parsed disc library metadata (META/DL) */
+BD_PRIVATE struct meta_root *nav_cache_load_meta(struct bd_disc *disc, const char *key) BD_ATTR_MALLOC;
+BD_PRIVATE void              nav_cache_save_meta(struct bd_disc *disc, const char *key, const struct meta_root *meta);
+
+#endif // _NAV_CACHE_H_
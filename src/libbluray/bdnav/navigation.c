@@ -28,9 +28,12 @@
 
 #include "disc/disc.h"
 
+#include "util/refcnt.h"
 #include "util/macro.h"
 #include "util/logging.h"
+#include "util/mutex.h"
 #include "util/strutl.h"
+#include "util/thread.h"
 #include "file/file.h"
 
 #include <stdlib.h>
@@ -111,19 +114,118 @@ static int _pl_cmp(MPLS_PL *pl1, MPLS_PL *pl2)
     return 0;
 }
 
-/* return 0 if duplicate playlist */
-static int _filter_dup(MPLS_PL *pl_list[], unsigned count, MPLS_PL *pl)
+/*
+ * duplicate playlist detection
+ *
+ * Playlists are hashed over the fields compared in _pl_cmp().
+ * Full compare is done only when hashes match.
+ */
+
+typedef struct {
+    unsigned   size;  /* power of 2 */
+    uint32_t  *hash;
+    MPLS_PL  **pl;    /* NULL = free slot */
+} PL_HASH;
+
+static uint32_t _hash_bytes(uint32_t h, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    size_t ii;
+
+    /* FNV-1a */
+    for (ii = 0; ii < len; ii++) {
+        h = (h ^ p[ii]) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t _hash_u32(uint32_t h, uint32_t v)
+{
+    uint8_t b[4] = { v >> 24, v >> 16, v >> 8, v };
+    return _hash_bytes(h, b, 4);
+}
+
+static uint32_t _streams_hash(uint32_t h, const MPLS_STREAM *s, unsigned count)
 {
     unsigned ii;
 
+    h = _hash_u32(h, count);
     for (ii = 0; ii < count; ii++) {
-        if (!_pl_cmp(pl, pl_list[ii])) {
-            return 0;
-        }
+        h = _hash_u32(h, ((uint32_t)s[ii].stream_type << 24) | ((uint32_t)s[ii].coding_type << 16) | s[ii].pid);
+        h = _hash_u32(h, ((uint32_t)s[ii].subpath_id << 24) | ((uint32_t)s[ii].subclip_id << 16) |
+                         ((uint32_t)s[ii].format << 8) | s[ii].rate);
+        h = _hash_u32(h, s[ii].char_code);
+        h = _hash_bytes(h, s[ii].lang, 4);
+    }
+    return h;
+}
+
+static uint32_t _pl_hash(const MPLS_PL *pl)
+{
+    uint32_t h = 2166136261u;
+    unsigned ii;
+
+    h = _hash_u32(h, pl->list_count);
+    h = _hash_u32(h, pl->mark_count);
+    for (ii = 0; ii < pl->list_count; ii++) {
+        const MPLS_PI *pi = &pl->play_item[ii];
+
+        h = _hash_bytes(h, pi->clip[0].clip_id, 5);
+        h = _hash_u32(h, pi->in_time);
+        h = _hash_u32(h, pi->out_time);
+        h = _streams_hash(h, pi->stn.video,           pi->stn.num_video);
+        h = _streams_hash(h, pi->stn.audio,           pi->stn.num_audio);
+        h = _streams_hash(h, pi->stn.pg,              pi->stn.num_pg);
+        h = _streams_hash(h, pi->stn.ig,              pi->stn.num_ig);
+        h = _streams_hash(h, pi->stn.secondary_audio, pi->stn.num_secondary_audio);
+        h = _streams_hash(h, pi->stn.secondary_video, pi->stn.num_secondary_video);
+    }
+    return h;
+}
+
+static int _pl_hash_init(PL_HASH *h, unsigned count)
+{
+    for (h->size = 16; h->size < 2 * count; h->size <<= 1) ;
+
+    h->hash = calloc(h->size, sizeof(uint32_t));
+    h->pl   = calloc(h->size, sizeof(MPLS_PL *));
+    if (!h->hash || !h->pl) {
+        X_FREE(h->hash);
+        X_FREE(h->pl);
+        return 0;
     }
     return 1;
 }
 
+static void _pl_hash_free(PL_HASH *h)
+{
+    X_FREE(h->hash);
+    X_FREE(h->pl);
+}
+
+/* return 1 if playlist is duplicate of already added playlist */
+static int _pl_hash_find(const PL_HASH *h, MPLS_PL *pl, uint32_t hash)
+{
+    unsigned ii;
+
+    for (ii = hash & (h->size - 1); h->pl[ii]; ii = (ii + 1) & (h->size - 1)) {
+        if (h->hash[ii] == hash && !_pl_cmp(pl, h->pl[ii])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void _pl_hash_add(PL_HASH *h, MPLS_PL *pl, uint32_t hash)
+{
+    unsigned ii;
+
+    for (ii = hash & (h->size - 1); h->pl[ii]; ii = (ii + 1) & (h->size - 1)) ;
+
+    h->hash[ii] = hash;
+    h->pl[ii]   = pl;
+}
+
 static unsigned int
 _find_repeats(MPLS_PL *pl, const char *m2ts, uint32_t in_time, uint32_t out_time)
 {
@@ -174,93 +276,260 @@ _pl_duration(MPLS_PL *pl)
     return duration;
 }
 
-NAV_TITLE_LIST* nav_get_title_list(BD_DISC *disc, uint32_t flags, uint32_t min_title_length)
+/*
+ * parallel playlist scan
+ */
+
+#define SCAN_MAX_THREADS 8
+
+typedef struct {
+    BD_DISC   *disc;
+    char     **names;
+    MPLS_PL  **pl;
+    uint8_t   *done;
+    unsigned   count;
+
+    BD_MUTEX   mutex;
+    BD_COND    cond;  /* playlist parsed */
+    unsigned   next;  /* next playlist to parse */
+
+    BD_THREAD  threads[SCAN_MAX_THREADS];
+    unsigned   num_workers;
+} PL_SCAN;
+
+static void _scan_one(PL_SCAN *s, unsigned ii)
+{
+    /* only play items and mark count are needed here */
+    MPLS_PL *pl = mpls_scan(s->disc, s->names[ii]);
+
+    bd_mutex_lock(&s->mutex);
+    s->pl[ii]   = pl;
+    s->done[ii] = 1;
+    bd_cond_broadcast(&s->cond);
+    bd_mutex_unlock(&s->mutex);
+}
+
+static void *_scan_worker(void *arg)
+{
+    PL_SCAN *s = (PL_SCAN *)arg;
+    unsigned ii;
+
+    while (1) {
+        bd_mutex_lock(&s->mutex);
+        ii = s->next++;
+        bd_mutex_unlock(&s->mutex);
+
+        if (ii >= s->count) {
+            break;
+        }
+        _scan_one(s, ii);
+    }
+
+    return NULL;
+}
+
+static void _scan_start(PL_SCAN *s, unsigned num_threads)
+{
+    if (!num_threads) {
+        num_threads = bd_cpu_count();
+    }
+    num_threads = BD_MIN(num_threads, SCAN_MAX_THREADS);
+    num_threads = BD_MIN(num_threads, s->count);
+
+    /* UDF image reader is not thread-safe */
+    if (disc_volume_id(s->disc)) {
+        num_threads = 1;
+    }
+
+    bd_mutex_init(&s->mutex);
+    bd_cond_init(&s->cond);
+    s->next = 0;
+
+    /* calling thread parses playlists too (see _scan_wait()) */
+    s->num_workers = 0;
+    while (s->num_workers + 1 < num_threads) {
+        if (bd_thread_create(&s->threads[s->num_workers], "bd_nav_scan", _scan_worker, s) < 0) {
+            break;
+        }
+        s->num_workers++;
+    }
+}
+
+/* wait until playlist ii has been parsed (parse it in calling thread if no worker has started it) */
+static MPLS_PL *_scan_wait(PL_SCAN *s, unsigned ii)
+{
+    MPLS_PL *pl;
+
+    bd_mutex_lock(&s->mutex);
+    while (!s->done[ii]) {
+        if (s->next <= ii) {
+            /* playlists are claimed in order: ii is the next one */
+            s->next++;
+            bd_mutex_unlock(&s->mutex);
+            _scan_one(s, ii);
+            bd_mutex_lock(&s->mutex);
+        } else {
+            bd_cond_wait(&s->cond, &s->mutex);
+        }
+    }
+    pl = s->pl[ii];
+    s->pl[ii] = NULL;
+    bd_mutex_unlock(&s->mutex);
+
+    return pl;
+}
+
+static void _scan_stop(PL_SCAN *s)
+{
+    unsigned ii;
+
+    /* stop claiming new playlists */
+    bd_mutex_lock(&s->mutex);
+    s->next = s->count;
+    bd_mutex_unlock(&s->mutex);
+
+    for (ii = 0; ii < s->num_workers; ii++) {
+        bd_thread_join(&s->threads[ii]);
+    }
+
+    /* playlists parsed but not merged (cancelled scan) */
+    for (ii = 0; ii < s->count; ii++) {
+        mpls_free(s->pl[ii]);
+    }
+
+    bd_cond_destroy(&s->cond);
+    bd_mutex_destroy(&s->mutex);
+}
+
+NAV_TITLE_LIST* nav_get_title_list(BD_DISC *disc, uint32_t flags, uint32_t min_title_length, unsigned num_threads,
+                                   nav_title_list_cb cb, void *cb_handle)
 {
     BD_DIR_H *dir;
     BD_DIRENT ent;
     MPLS_PL **pl_list = NULL;
     MPLS_PL *pl = NULL;
-    unsigned int ii, pl_list_size = 0;
+    PL_SCAN  scan;
+    PL_HASH  pl_hash;
+    unsigned int ii, jj, names_size = 0;
+    size_t name_len;
     int res;
     NAV_TITLE_LIST *title_list;
-    unsigned int title_info_alloc = 100;
 
     dir = disc_open_dir(disc, "BDMV" DIR_SEP "PLAYLIST");
     if (dir == NULL) {
         return NULL;
     }
 
-    title_list = calloc(1, sizeof(NAV_TITLE_LIST));
-    title_list->title_info = calloc(title_info_alloc, sizeof(NAV_TITLE_INFO));
-
-    ii = 0;
+    /* collect playlist names (directory order) */
+    memset(&scan, 0, sizeof(scan));
+    scan.disc = disc;
     for (res = dir_read(dir, &ent); !res; res = dir_read(dir, &ent)) {
 
         if (ent.d_name[0] == '.') {
             continue;
         }
-        if (ii >= pl_list_size) {
-            MPLS_PL **tmp = NULL;
+        if (scan.count >= names_size) {
+            char **tmp;
 
-            pl_list_size += 100;
-            tmp = realloc(pl_list, pl_list_size * sizeof(MPLS_PL*));
+            names_size += 100;
+            tmp = realloc(scan.names, names_size * sizeof(char*));
             if (tmp == NULL) {
                 break;
             }
-            pl_list = tmp;
+            scan.names = tmp;
+        }
+        scan.names[scan.count] = str_dup(ent.d_name);
+        if (!scan.names[scan.count]) {
+            break;
         }
-        pl = mpls_get(disc, ent.d_name);
+        scan.count++;
+    }
+    dir_close(dir);
+
+    title_list = calloc(1, sizeof(NAV_TITLE_LIST));
+    if (title_list) {
+        title_list->title_info = calloc(scan.count + 1, sizeof(NAV_TITLE_INFO));
+    }
+    scan.pl   = calloc(scan.count + 1, sizeof(MPLS_PL*));
+    scan.done = calloc(scan.count + 1, 1);
+    pl_list = calloc(scan.count + 1, sizeof(MPLS_PL*));
+    memset(&pl_hash, 0, sizeof(pl_hash));
+    if (!title_list || !title_list->title_info || !scan.pl || !scan.done || !pl_list ||
+        !_pl_hash_init(&pl_hash, scan.count)) {
+        BD_DEBUG(DBG_CRIT, "out of memory\n");
+        if (title_list) {
+            X_FREE(title_list->title_info);
+            X_FREE(title_list);
+        }
+        goto out;
+    }
+
+    _scan_start(&scan, num_threads);
+
+    /* merge in directory order: filtering and main title guessing stay deterministic */
+    ii = 0;
+    for (jj = 0; jj < scan.count; jj++) {
+        pl = _scan_wait(&scan, jj);
         if (pl != NULL) {
-            if ((flags & TITLES_FILTER_DUP_TITLE) &&
-                !_filter_dup(pl_list, ii, pl)) {
-                mpls_free(pl);
-                continue;
-            }
-            if ((flags & TITLES_FILTER_DUP_CLIP) && !_filter_repeats(pl, 2)) {
-                mpls_free(pl);
-                continue;
-            }
-            if (min_title_length > 0 &&
-                _pl_duration(pl) < min_title_length*45000) {
+            uint32_t hash = _pl_hash(pl);
+            int      dup  = _pl_hash_find(&pl_hash, pl, hash);
+
+            if (((flags & TITLES_FILTER_DUP_TITLE) && dup) ||
+                ((flags & TITLES_FILTER_DUP_CLIP) && !_filter_repeats(pl, 2)) ||
+                (min_title_length > 0 && _pl_duration(pl) < min_title_length*45000)) {
                 mpls_free(pl);
-                continue;
-            }
-            if (ii >= title_info_alloc) {
-                NAV_TITLE_INFO *tmp = NULL;
-                title_info_alloc += 100;
-
-                tmp = realloc(title_list->title_info,
-                              title_info_alloc * sizeof(NAV_TITLE_INFO));
-                if (tmp == NULL) {
-                    break;
+            } else {
+                pl_list[ii] = pl;
+                _pl_hash_add(&pl_hash, pl, hash);
+
+                /* main title guessing */
+                if (!dup && _filter_repeats(pl, 2)) {
+                    if (_pl_duration(pl_list[ii]) >= _pl_duration(pl_list[title_list->main_title_idx])) {
+                        title_list->main_title_idx = ii;
+                    }
                 }
-                title_list->title_info = tmp;
-            }
-            pl_list[ii] = pl;
 
-            /* main title guessing */
-            if (_filter_dup(pl_list, ii, pl) &&
-                _filter_repeats(pl, 2)) {
-                if (_pl_duration(pl_list[ii]) >= _pl_duration(pl_list[title_list->main_title_idx])) {
-                    title_list->main_title_idx = ii;
+                name_len = strlen(scan.names[jj]);
+                if (name_len > 10) {
+                    name_len = 10;
                 }
+                memcpy(title_list->title_info[ii].name, scan.names[jj], name_len);
+                title_list->title_info[ii].name[name_len] = '\0';
+                title_list->title_info[ii].ref = ii;
+                title_list->title_info[ii].mpls_id  = atoi(scan.names[jj]);
+                title_list->title_info[ii].duration = _pl_duration(pl_list[ii]);
+                ii++;
             }
+        }
 
-            strncpy(title_list->title_info[ii].name, ent.d_name, 11);
-            title_list->title_info[ii].name[10] = '\0';
-            title_list->title_info[ii].ref = ii;
-            title_list->title_info[ii].mpls_id  = atoi(ent.d_name);
-            title_list->title_info[ii].duration = _pl_duration(pl_list[ii]);
-            ii++;
+        title_list->count = ii;
+        if (cb && cb(cb_handle, title_list, jj + 1, scan.count)) {
+            BD_DEBUG(DBG_NAV, "title list scan cancelled\n");
+            break;
         }
     }
-    dir_close(dir);
+
+    _scan_stop(&scan);
 
     title_list->count = ii;
     for (ii = 0; ii < title_list->count; ii++) {
         mpls_free(pl_list[ii]);
     }
+    if (jj < scan.count) {
+        /* cancelled */
+        nav_free_title_list(title_list);
+        title_list = NULL;
+    }
+
+ out:
+    for (jj = 0; jj < scan.count; jj++) {
+        X_FREE(scan.names[jj]);
+    }
+    X_FREE(scan.names);
+    X_FREE(scan.pl);
+    X_FREE(scan.done);
     X_FREE(pl_list);
+    _pl_hash_free(&pl_hash);
     return title_list;
 }
 
@@ -305,14 +574,6 @@ _fill_mark(NAV_TITLE *title, NAV_MARK *mark, int entry)
     mark->plm = plm;
     mark->mark_type = plm->mark_type;
     mark->clip_ref = plm->play_item_ref;
-    clip = &title->clip_list.clip[mark->clip_ref];
-    if (clip->cl != NULL && mark->clip_ref < title->pl->list_count) {
-        mark->clip_pkt = clpi_lookup_spn(clip->cl, plm->time, 1,
-            title->pl->play_item[mark->clip_ref].clip[title->angle].stc_id);
-    } else {
-        mark->clip_pkt = clip->start_pkt;
-    }
-    mark->title_pkt = clip->title_pkt + mark->clip_pkt;
     mark->clip_time = plm->time;
 
     // Calculate start of mark relative to beginning of playlist
@@ -323,11 +584,24 @@ _fill_mark(NAV_TITLE *title, NAV_MARK *mark, int entry)
     }
 }
 
+/* mark position in packets. Clip of mark must be loaded. */
+static void
+_fill_mark_pkt(NAV_TITLE *title, NAV_MARK *mark)
+{
+    NAV_CLIP *clip = &title->clip_list.clip[mark->clip_ref];
+
+    if (clip->cl != NULL) {
+        mark->clip_pkt = clpi_lookup_spn(clip->cl, mark->clip_time, 1, clip->stc_id);
+    } else {
+        mark->clip_pkt = clip->start_pkt;
+    }
+    mark->title_pkt = clip->title_pkt + mark->clip_pkt;
+}
+
 static void
 _extrapolate_title(NAV_TITLE *title)
 {
     uint32_t duration = 0;
-    uint32_t pkt = 0;
     unsigned ii, jj;
     MPLS_PL *pl = title->pl;
     MPLS_PI *pi;
@@ -344,12 +618,9 @@ _extrapolate_title(NAV_TITLE *title)
 
         clip->title_time = duration;
         clip->duration = pi->out_time - pi->in_time;
-        clip->title_pkt = pkt;
         duration += clip->duration;
-        pkt += clip->end_pkt - clip->start_pkt;
     }
     title->duration = duration;
-    title->packets = pkt;
 
     for (ii = 0, jj = 0; ii < pl->mark_count; ii++) {
         plm = &pl->play_mark[ii];
@@ -380,18 +651,166 @@ _extrapolate_title(NAV_TITLE *title)
     }
 }
 
-static void _fill_clip(NAV_TITLE *title,
+/*
+ * parallel clip info loading
+ *
+ * Clip info files of a range of main path clips are loaded with a small
+ * worker pool before clips are filled. Each file is a few small reads: on network storage or
+ * optical media the latency, not parsing, dominates.
+ */
+
+#define CLPI_LOAD_MAX_THREADS 8
+
+typedef struct {
+    BD_DISC   *disc;
+    char     (*names)[11];
+    CLPI_CL  **cl;
+    unsigned   count;
+    unsigned   num_missing;  /* files not in disc cache (first entries) */
+
+    BD_MUTEX   mutex;
+    unsigned   next;  /* next file to load */
+} CLPI_LOAD;
+
+static void *_clpi_load_worker(void *arg)
+{
+    CLPI_LOAD *ld = (CLPI_LOAD *)arg;
+    unsigned   ii;
+
+    while (1) {
+        bd_mutex_lock(&ld->mutex);
+        ii = ld->next++;
+        bd_mutex_unlock(&ld->mutex);
+
+        if (ii >= ld->num_missing) {
+            break;
+        }
+        ld->cl[ii] = clpi_get(ld->disc, ld->names[ii]);
+    }
+
+    return NULL;
+}
+
+static void _clpi_load_add(CLPI_LOAD *ld, const char *clip_id)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < ld->count; ii++) {
+        if (!memcmp(ld->names[ii], clip_id, 5)) {
+            return;
+        }
+    }
+
+    memcpy(ld->names[ld->count], clip_id, 5);
+    strcpy(&ld->names[ld->count][5], ".clpi");
+    ld->count++;
+}
+
+/* load clip info of main path clips first...last */
+static void _clpi_load(CLPI_LOAD *ld, NAV_TITLE *title, unsigned first, unsigned last)
+{
+    BD_THREAD threads[CLPI_LOAD_MAX_THREADS];
+    unsigned  num_threads = 0, max_items, ii;
+
+    memset(ld, 0, sizeof(*ld));
+    ld->disc = title->disc;
+
+    max_items = last - first + 1;
+    if (max_items < 2) {
+        return;
+    }
+
+    ld->names = calloc(max_items, sizeof(*ld->names));
+    ld->cl    = calloc(max_items, sizeof(*ld->cl));
+    if (!ld->names || !ld->cl) {
+        X_FREE(ld->names);
+        X_FREE(ld->cl);
+        return;
+    }
+
+    for (ii = first; ii <= last; ii++) {
+        _clpi_load_add(ld, title->clip_list.clip[ii].name);
+    }
+
+    /* files already in disc cache do not need workers */
+    for (ii = 0; ii < ld->count; ii++) {
+        ld->cl[ii] = disc_cache_get(ld->disc, ld->names[ii]);
+        if (!ld->cl[ii]) {
+            /* move to front */
+            if (ii != ld->num_missing) {
+                char tmp[11];
+                memcpy(tmp, ld->names[ld->num_missing], sizeof(tmp));
+                memcpy(ld->names[ld->num_missing], ld->names[ii], sizeof(tmp));
+                memcpy(ld->names[ii], tmp, sizeof(tmp));
+                ld->cl[ii] = ld->cl[ld->num_missing];
+                ld->cl[ld->num_missing] = NULL;
+            }
+            ld->num_missing++;
+        }
+    }
+
+    /* UDF image reader is not thread-safe. Missing files are loaded in _load_clip(). */
+    if (ld->num_missing < 2 || disc_volume_id(ld->disc)) {
+        return;
+    }
+
+    bd_mutex_init(&ld->mutex);
+    ld->next = 0;
+
+    /* calling thread loads files too */
+    while (num_threads + 1 < BD_MIN(ld->num_missing, CLPI_LOAD_MAX_THREADS)) {
+        if (bd_thread_create(&threads[num_threads], "bd_clpi_load", _clpi_load_worker, ld) < 0) {
+            break;
+        }
+        num_threads++;
+    }
+    _clpi_load_worker(ld);
+    for (ii = 0; ii < num_threads; ii++) {
+        bd_thread_join(&threads[ii]);
+    }
+
+    bd_mutex_destroy(&ld->mutex);
+
+    BD_DEBUG(DBG_NAV, "%s: loaded %u clip info files with %u threads\n",
+             title->name, ld->num_missing, num_threads + 1);
+}
+
+static CLPI_CL *_clpi_load_get(const CLPI_LOAD *ld, const char *file)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < ld->count; ii++) {
+        if (ld->cl[ii] && !strcmp(ld->names[ii], file)) {
+            bd_refcnt_inc(ld->cl[ii]);
+            return ld->cl[ii];
+        }
+    }
+
+    return clpi_get(ld->disc, file);
+}
+
+static void _clpi_load_free(CLPI_LOAD *ld)
+{
+    unsigned ii;
+
+    for (ii = 0; ld->cl && ii < ld->count; ii++) {
+        clpi_free(ld->cl[ii]);
+    }
+    X_FREE(ld->names);
+    X_FREE(ld->cl);
+}
+
+static void _init_clip(NAV_TITLE *title,
                        MPLS_CLIP *mpls_clip,
                        uint8_t connection_condition, uint32_t in_time, uint32_t out_time,
                        unsigned pi_angle_count,
                        NAV_CLIP *clip,
-                       unsigned ref, uint32_t *pos, uint32_t *time)
+                       unsigned ref, uint32_t *time)
 
 {
-    char *file;
-
     clip->title = title;
     clip->ref   = ref;
+    clip->loaded = 0;
 
     if (title->angle >= pi_angle_count) {
         clip->angle = 0;
@@ -402,47 +821,131 @@ static void _fill_clip(NAV_TITLE *title,
     strncpy(clip->name, mpls_clip[clip->angle].clip_id, 5);
     strncpy(&clip->name[5], ".m2ts", 6);
     clip->clip_id = atoi(mpls_clip[clip->angle].clip_id);
+    clip->stc_id = mpls_clip[clip->angle].stc_id;
 
-    file = str_printf("%s.clpi", mpls_clip[clip->angle].clip_id);
-    clpi_free(clip->cl);
-    clip->cl = clpi_get(title->disc, file);
-    X_FREE(file);
-    if (clip->cl == NULL) {
-        clip->start_pkt = 0;
-        clip->end_pkt = 0;
-        return;
-    }
     switch (connection_condition) {
         case 5:
         case 6:
-            clip->start_pkt = 0;
             clip->connection = CONNECT_SEAMLESS;
             break;
         default:
-            if (ref) {
-                clip->start_pkt = clpi_lookup_spn(clip->cl, in_time, 1,
-                                              mpls_clip[clip->angle].stc_id);
-            } else {
-                clip->start_pkt = 0;
-            }
             clip->connection = CONNECT_NON_SEAMLESS;
             break;
     }
-    clip->end_pkt = clpi_lookup_spn(clip->cl, out_time, 0,
-                                    mpls_clip[clip->angle].stc_id);
     clip->in_time = in_time;
     clip->out_time = out_time;
-    clip->title_pkt = *pos;
-    *pos += clip->end_pkt - clip->start_pkt;
     clip->title_time = *time;
     *time += clip->out_time - clip->in_time;
 }
 
+static void _load_clip(NAV_TITLE *title, const CLPI_LOAD *ld, NAV_CLIP *clip)
+{
+    char file[11];
+
+    memcpy(file, clip->name, 5);
+    memcpy(&file[5], ".clpi", 6);
+    clpi_free(clip->cl);
+    clip->cl = ld ? _clpi_load_get(ld, file) : clpi_get(title->disc, file);
+    clip->loaded = 1;
+    if (clip->cl == NULL) {
+        clip->start_pkt = 0;
+        clip->end_pkt = 0;
+        return;
+    }
+    if (clip->connection == CONNECT_SEAMLESS || !clip->ref) {
+        clip->start_pkt = 0;
+    } else {
+        clip->start_pkt = clpi_lookup_spn(clip->cl, clip->in_time, 1, clip->stc_id);
+    }
+    clip->end_pkt = clpi_lookup_spn(clip->cl, clip->out_time, 0, clip->stc_id);
+}
+
+/*
+ * Main path clips are loaded in order: clip title_pkt is the sum of
+ * packet counts of all earlier clips.
+ */
+static void _load_clips(NAV_TITLE *title, unsigned last)
+{
+    CLPI_LOAD ld;
+    NAV_CLIP *clip;
+    uint32_t  pkt = 0;
+    unsigned  first = title->loaded_clips, ii;
+
+    if (title->clip_list.count < 1) {
+        return;
+    }
+    if (last >= title->clip_list.count) {
+        last = title->clip_list.count - 1;
+    }
+    if (first > last) {
+        return;
+    }
+
+    if (first > 0) {
+        clip = &title->clip_list.clip[first - 1];
+        pkt = clip->title_pkt + clip->end_pkt - clip->start_pkt;
+    }
+
+    _clpi_load(&ld, title, first, last);
+    for (ii = first; ii <= last; ii++) {
+        clip = &title->clip_list.clip[ii];
+        _load_clip(title, &ld, clip);
+        clip->title_pkt = pkt;
+        pkt += clip->end_pkt - clip->start_pkt;
+    }
+    _clpi_load_free(&ld);
+
+    title->loaded_clips = last + 1;
+    if (title->loaded_clips == title->clip_list.count) {
+        title->packets = pkt;
+    }
+
+    // marks of loaded clips
+    for (ii = 0; ii < title->chap_list.count; ii++) {
+        NAV_MARK *mark = &title->chap_list.mark[ii];
+        if (mark->clip_ref >= first && mark->clip_ref <= last) {
+            _fill_mark_pkt(title, mark);
+        }
+    }
+    for (ii = 0; ii < title->mark_list.count; ii++) {
+        NAV_MARK *mark = &title->mark_list.mark[ii];
+        if (mark->clip_ref >= first && mark->clip_ref <= last) {
+            _fill_mark_pkt(title, mark);
+        }
+    }
+}
+
+void nav_title_load(NAV_TITLE *title)
+{
+    _load_clips(title, title->clip_list.count - 1);
+}
+
+void nav_clip_load(NAV_CLIP *clip)
+{
+    NAV_TITLE *title = clip->title;
+
+    if (clip->loaded) {
+        return;
+    }
+    if (clip >= title->clip_list.clip && clip < title->clip_list.clip + title->clip_list.count) {
+        _load_clips(title, clip->ref);
+    } else {
+        /* sub path clip */
+        _load_clip(title, NULL, clip);
+    }
+}
+
+void nav_mark_load(NAV_TITLE *title, const NAV_MARK *mark)
+{
+    if (mark->clip_ref < title->clip_list.count) {
+        _load_clips(title, mark->clip_ref);
+    }
+}
+
 NAV_TITLE* nav_title_open(BD_DISC *disc, const char *playlist, unsigned angle)
 {
     NAV_TITLE *title = NULL;
     unsigned ii, ss, chapters = 0;
-    uint32_t pos = 0;
     uint32_t time = 0;
 
     title = calloc(1, sizeof(NAV_TITLE));
@@ -461,7 +964,7 @@ NAV_TITLE* nav_title_open(BD_DISC *disc, const char *playlist, unsigned angle)
         return NULL;
     }
 
-    // Find length in packets and end_pkt for each clip
+    // Clip info is loaded on demand (nav_clip_load())
     title->clip_list.count = title->pl->list_count;
     title->clip_list.clip = calloc(title->pl->list_count, sizeof(NAV_CLIP));
     title->packets = 0;
@@ -473,12 +976,11 @@ NAV_TITLE* nav_title_open(BD_DISC *disc, const char *playlist, unsigned angle)
 
         clip = &title->clip_list.clip[ii];
 
-        _fill_clip(title, pi->clip, pi->connection_condition, pi->in_time, pi->out_time, pi->angle_count,
-                   clip, ii, &pos, &time);
+        _init_clip(title, pi->clip, pi->connection_condition, pi->in_time, pi->out_time, pi->angle_count,
+                   clip, ii, &time);
     }
 
     // sub paths
-    // Find length in packets and end_pkt for each clip
     if (title->pl->sub_count > 0) {
         title->sub_path_count = title->pl->sub_count;
         title->sub_path       = calloc(title->sub_path_count, sizeof(NAV_SUB_PATH));
@@ -490,13 +992,13 @@ NAV_TITLE* nav_title_open(BD_DISC *disc, const char *playlist, unsigned angle)
             sub_path->clip_list.count = title->pl->sub_path[ss].sub_playitem_count;
             sub_path->clip_list.clip  = calloc(sub_path->clip_list.count, sizeof(NAV_CLIP));
 
-            pos = time = 0;
+            time = 0;
             for (ii = 0; ii < sub_path->clip_list.count; ii++) {
                 MPLS_SUB_PI *pi   = &title->pl->sub_path[ss].sub_play_item[ii];
                 NAV_CLIP    *clip = &sub_path->clip_list.clip[ii];
 
-                _fill_clip(title, pi->clip, pi->connection_condition, pi->in_time, pi->out_time, 0,
-                           clip, ii, &pos, &time);
+                _init_clip(title, pi->clip, pi->connection_condition, pi->in_time, pi->out_time, 0,
+                           clip, ii, &time);
             }
         }
     }
@@ -519,9 +1021,26 @@ NAV_TITLE* nav_title_open(BD_DISC *disc, const char *playlist, unsigned angle)
         title->angle = 0;
     }
 
+    // first clip is needed to start playback
+    _load_clips(title, 0);
+
     return title;
 }
 
+static void _free_angle_points(NAV_CLIP *clip)
+{
+    unsigned ii;
+
+    if (clip->angle_points) {
+        for (ii = 0; ii < clip->angle_count; ii++) {
+            X_FREE(clip->angle_points[ii].pkt);
+            X_FREE(clip->angle_points[ii].time);
+        }
+        X_FREE(clip->angle_points);
+    }
+    clip->angle_count = 0;
+}
+
 void nav_title_close(NAV_TITLE *title)
 {
     unsigned ii, ss;
@@ -535,6 +1054,7 @@ void nav_title_close(NAV_TITLE *title)
     X_FREE(title->sub_path);
 
     for (ii = 0; ii < title->pl->list_count; ii++) {
+        _free_angle_points(&title->clip_list.clip[ii]);
         clpi_free(title->clip_list.clip[ii].cl);
     }
     mpls_free(title->pl);
@@ -544,6 +1064,56 @@ void nav_title_close(NAV_TITLE *title)
     X_FREE(title);
 }
 
+/* clip info objects are shared by clips referring to the same file: count once */
+static size_t _clip_list_memory_size(const NAV_CLIP_LIST *list)
+{
+    size_t   size = list->count * sizeof(NAV_CLIP);
+    unsigned ii, jj;
+
+    for (ii = 0; ii < list->count; ii++) {
+        const NAV_CLIP *clip = &list->clip[ii];
+
+        if (clip->angle_points) {
+            size += clip->angle_count * sizeof(NAV_ANGLE_POINTS);
+            for (jj = 0; jj < clip->angle_count; jj++) {
+                size += clip->angle_points[jj].count * 2 * sizeof(uint32_t);
+            }
+        }
+
+        if (clip->cl) {
+            for (jj = 0; jj < ii && list->clip[jj].cl != clip->cl; jj++) ;
+            if (jj == ii) {
+                size += clpi_memory_size(clip->cl);
+            }
+        }
+    }
+
+    return size;
+}
+
+size_t nav_title_memory_size(const NAV_TITLE *title)
+{
+    size_t   size = sizeof(NAV_TITLE);
+    unsigned ii;
+
+    size += _clip_list_memory_size(&title->clip_list);
+    size += (title->chap_list.count + title->mark_list.count) * sizeof(NAV_MARK);
+    size += title->sub_path_count * sizeof(NAV_SUB_PATH);
+    for (ii = 0; ii < title->sub_path_count; ii++) {
+        size += _clip_list_memory_size(&title->sub_path[ii].clip_list);
+    }
+    if (title->pl) {
+        size += mpls_memory_size(title->pl);
+    }
+
+    return size;
+}
+
+size_t nav_title_list_memory_size(const NAV_TITLE_LIST *title_list)
+{
+    return sizeof(NAV_TITLE_LIST) + title_list->count * sizeof(NAV_TITLE_INFO);
+}
+
 // Search for random access point closest to the requested packet
 // Packets are 192 byte TS packets
 NAV_CLIP* nav_chapter_search(NAV_TITLE *title, unsigned chapter, uint32_t *clip_pkt, uint32_t *out_pkt)
@@ -556,6 +1126,7 @@ NAV_CLIP* nav_chapter_search(NAV_TITLE *title, unsigned chapter, uint32_t *clip_
         *out_pkt = clip->title_pkt;
         return clip;
     }
+    nav_mark_load(title, &title->chap_list.mark[chapter]);
     clip = &title->clip_list.clip[title->chap_list.mark[chapter].clip_ref];
     *clip_pkt = title->chap_list.mark[chapter].clip_pkt;
     *out_pkt = clip->title_pkt + *clip_pkt - clip->start_pkt;
@@ -566,33 +1137,28 @@ uint32_t nav_chapter_get_current(NAV_CLIP *clip, uint32_t clip_pkt)
 {
     NAV_MARK * mark;
     NAV_TITLE *title;
-    uint32_t ii;
+    uint32_t lo, hi, mid;
 
     // Clip can be null if we haven't started the first clip yet
     if (clip == NULL) {
         return 0;
     }
     title = clip->title;
-    for (ii = 0; ii < title->chap_list.count; ii++) {
-        mark = &title->chap_list.mark[ii];
-        if (mark->clip_ref > clip->ref)
-        {
-            if (ii)
-                return ii-1;
-            else
-                return 0;
-        }
-        if (mark->clip_ref == clip->ref && mark->clip_pkt <= clip_pkt) {
-            if ( ii == title->chap_list.count - 1 ) {
-                return ii;
-            }
-            mark = &title->chap_list.mark[ii+1];
-            if (mark->clip_ref != clip->ref || mark->clip_pkt > clip_pkt) {
-                return ii;
-            }
+
+    // find last chapter mark at or before (clip, clip_pkt)
+    lo = 0;
+    hi = title->chap_list.count;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        mark = &title->chap_list.mark[mid];
+        if (mark->clip_ref < clip->ref ||
+            (mark->clip_ref == clip->ref && mark->clip_pkt <= clip_pkt)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
     }
-    return 0;
+    return lo ? lo - 1 : 0;
 }
 
 // Search for random access point closest to the requested packet
@@ -607,31 +1173,66 @@ NAV_CLIP* nav_mark_search(NAV_TITLE *title, unsigned mark, uint32_t *clip_pkt, u
         *out_pkt = clip->title_pkt;
         return clip;
     }
+    nav_mark_load(title, &title->mark_list.mark[mark]);
     clip = &title->clip_list.clip[title->mark_list.mark[mark].clip_ref];
     *clip_pkt = title->mark_list.mark[mark].clip_pkt;
     *out_pkt = clip->title_pkt + *clip_pkt - clip->start_pkt;
     return clip;
 }
 
+/*
+ * Clip lookup.
+ * clip->title_pkt and clip->title_time are cumulative start positions
+ * (filled in _load_clips() and _extrapolate_title()), so clips can be found with binary search.
+ * Returns index of first clip ending after pkt / tick, or clip count.
+ */
+
+static unsigned _clip_by_pkt(const NAV_TITLE *title, uint32_t pkt)
+{
+    const NAV_CLIP *clip;
+    unsigned lo = 0, hi = title->clip_list.count, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        clip = &title->clip_list.clip[mid];
+        if (pkt < clip->title_pkt + (clip->end_pkt - clip->start_pkt)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+static unsigned _clip_by_time(const NAV_TITLE *title, uint32_t tick)
+{
+    const NAV_CLIP *clip;
+    unsigned lo = 0, hi = title->clip_list.count, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        clip = &title->clip_list.clip[mid];
+        if (tick < clip->title_time + clip->duration) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
 // Search for random access point closest to the requested packet
 // Packets are 192 byte TS packets
 // pkt is relative to the beginning of the title
 // out_pkt and out_time is relative to the the clip which the packet falls in
 NAV_CLIP* nav_packet_search(NAV_TITLE *title, uint32_t pkt, uint32_t *clip_pkt, uint32_t *out_pkt, uint32_t *out_time)
 {
-    uint32_t pos, len;
     NAV_CLIP *clip;
     unsigned ii;
 
     *out_time = 0;
-    pos = 0;
-    for (ii = 0; ii < title->pl->list_count; ii++) {
-        clip = &title->clip_list.clip[ii];
-        len = clip->end_pkt - clip->start_pkt;
-        if (pkt < pos + len)
-            break;
-        pos += len;
-    }
+    nav_title_load(title);
+    ii = _clip_by_pkt(title, pkt);
     if (ii == title->pl->list_count) {
         clip = &title->clip_list.clip[ii-1];
         *out_time = clip->duration + clip->in_time;
@@ -639,7 +1240,7 @@ NAV_CLIP* nav_packet_search(NAV_TITLE *title, uint32_t pkt, uint32_t *clip_pkt,
     } else {
         clip = &title->clip_list.clip[ii];
         if (clip->cl != NULL) {
-            *clip_pkt = clpi_access_point(clip->cl, pkt - pos + clip->start_pkt, 0, 0, out_time);
+            *clip_pkt = clpi_access_point(clip->cl, pkt - clip->title_pkt + clip->start_pkt, 0, 0, out_time);
             if (*clip_pkt < clip->start_pkt) {
                 *clip_pkt = clip->start_pkt;
             }
@@ -681,15 +1282,113 @@ uint32_t nav_angle_change_search(NAV_CLIP *clip, uint32_t pkt, uint32_t *time)
     if (clip->cl == NULL) {
         return pkt;
     }
+
+    if (clip->angle_points && clip->angle < clip->angle_count) {
+        const NAV_ANGLE_POINTS *ap = &clip->angle_points[clip->angle];
+        unsigned first = 0, last = ap->count;
+
+        /* first point at or after pkt */
+        while (first < last) {
+            unsigned mid = first + (last - first) / 2;
+            if (ap->pkt[mid] >= pkt) {
+                last = mid;
+            } else {
+                first = mid + 1;
+            }
+        }
+        if (first < ap->count) {
+            *time = ap->time[first];
+            return ap->pkt[first];
+        }
+        *time = 0;
+        return clip->cl->clip.num_source_packets;
+    }
+
     return clpi_access_point(clip->cl, pkt, 1, 1, time);
 }
 
+const char *nav_angle_clip_name(const NAV_CLIP *clip, unsigned angle, char name[11])
+{
+    const MPLS_PI *pi = &clip->title->pl->play_item[clip->ref];
+
+    if (angle >= pi->angle_count) {
+        angle = 0;
+    }
+    memcpy(name, pi->clip[angle].clip_id, 5);
+    memcpy(&name[5], ".m2ts", 6);
+    return name;
+}
+
+// Load EP maps of all angles of multi-angle play items, and collect angle
+// change points. Angle change does not need to look up the EP map of the
+// target angle.
+void nav_title_angle_points(NAV_TITLE *title)
+{
+    unsigned ii, aa;
+
+    for (ii = 0; ii < title->clip_list.count; ii++) {
+        NAV_CLIP *clip = &title->clip_list.clip[ii];
+        MPLS_PI  *pi   = &title->pl->play_item[ii];
+
+        if (pi->angle_count < 2 || clip->angle_points) {
+            continue;
+        }
+
+        clip->angle_points = calloc(pi->angle_count, sizeof(NAV_ANGLE_POINTS));
+        if (!clip->angle_points) {
+            continue;
+        }
+        clip->angle_count = pi->angle_count;
+
+        for (aa = 0; aa < pi->angle_count; aa++) {
+            NAV_ANGLE_POINTS *ap = &clip->angle_points[aa];
+            CLPI_CL *cl;
+            char file[11];
+
+            memcpy(file, pi->clip[aa].clip_id, 5);
+            memcpy(&file[5], ".clpi", 6);
+            cl = clpi_get(title->disc, file);
+            if (cl) {
+                ap->count = clpi_angle_change_points(cl, &ap->pkt, &ap->time);
+                clpi_free(cl);
+            }
+        }
+
+        BD_DEBUG(DBG_NAV, "%s: angle change points for %u angles of clip %s\n",
+                 title->name, clip->angle_count, clip->name);
+    }
+}
+
+int nav_angle_change_point(const NAV_CLIP *clip, unsigned angle, uint32_t time, uint32_t *pkt)
+{
+    const NAV_ANGLE_POINTS *ap;
+    unsigned first = 0, last;
+
+    if (!clip->angle_points || angle >= clip->angle_count) {
+        return 0;
+    }
+
+    ap   = &clip->angle_points[angle];
+    last = ap->count;
+    while (first < last) {
+        unsigned mid = first + (last - first) / 2;
+        if (ap->time[mid] >= time) {
+            last = mid;
+        } else {
+            first = mid + 1;
+        }
+    }
+    if (first < ap->count && ap->time[first] == time) {
+        *pkt = ap->pkt[first];
+        return 1;
+    }
+    return 0;
+}
+
 // Search for random access point closest to the requested time
 // Time is in 45khz ticks
 NAV_CLIP* nav_time_search(NAV_TITLE *title, uint32_t tick, uint32_t *clip_pkt, uint32_t *out_pkt)
 {
-    uint32_t pos, len;
-    MPLS_PI *pi = NULL;
     NAV_CLIP *clip;
     unsigned ii;
 
@@ -702,22 +1401,16 @@ NAV_CLIP* nav_time_search(NAV_TITLE *title, uint32_t tick, uint32_t *clip_pkt, u
         return NULL;
     }
 
-    pos = 0;
-    for (ii = 0; ii < title->pl->list_count; ii++) {
-        pi = &title->pl->play_item[ii];
-        len = pi->out_time - pi->in_time;
-        if (tick < pos + len)
-            break;
-        pos += len;
-    }
+    ii = _clip_by_time(title, tick);
+    _load_clips(title, ii);
     if (ii == title->pl->list_count) {
         clip = &title->clip_list.clip[ii-1];
         *clip_pkt = clip->end_pkt;
     } else {
         clip = &title->clip_list.clip[ii];
         if (clip->cl != NULL) {
-            *clip_pkt = clpi_lookup_spn(clip->cl, tick - pos + pi->in_time, 1,
-                      title->pl->play_item[clip->ref].clip[clip->angle].stc_id);
+            *clip_pkt = clpi_lookup_spn(clip->cl, tick - clip->title_time + clip->in_time, 1,
+                      clip->stc_id);
             if (*clip_pkt < clip->start_pkt) {
                 *clip_pkt = clip->start_pkt;
             }
@@ -729,6 +1422,142 @@ NAV_CLIP* nav_time_search(NAV_TITLE *title, uint32_t tick, uint32_t *clip_pkt, u
     return clip;
 }
 
+// List all random access points of the title.
+// Returns allocated array (count in *count), NULL if there are no entries
+NAV_KEYFRAME* nav_title_keyframes(NAV_TITLE *title, unsigned *count)
+{
+    NAV_KEYFRAME *kf;
+    unsigned ii, num = 0, size = 0;
+    int jj;
+
+    *count = 0;
+
+    nav_title_load(title);
+
+    for (ii = 0; ii < title->clip_list.count; ii++) {
+        const CLPI_CL *cl = title->clip_list.clip[ii].cl;
+        if (cl && cl->ep_index && cl->cpi.num_stream_pid > 0) {
+            size += cl->ep_index[0].num_ep;
+        }
+    }
+    if (!size) {
+        return NULL;
+    }
+
+    kf = calloc(size, sizeof(NAV_KEYFRAME));
+    if (!kf) {
+        BD_DEBUG(DBG_NAV | DBG_CRIT, "out of memory\n");
+        return NULL;
+    }
+
+    for (ii = 0; ii < title->clip_list.count; ii++) {
+        const NAV_CLIP *clip = &title->clip_list.clip[ii];
+        const CLPI_EP_INDEX *idx;
+
+        if (!clip->cl || !clip->cl->ep_index || clip->cl->cpi.num_stream_pid < 1) {
+            continue;
+        }
+
+        // Assumes that there is only one pid of interest
+        idx = &clip->cl->ep_index[0];
+        for (jj = 0; jj < idx->num_ep; jj++) {
+            if (idx->spn[jj] < clip->start_pkt) {
+                continue;
+            }
+            if (idx->spn[jj] >= clip->end_pkt || idx->pts[jj] >= clip->out_time) {
+                break;
+            }
+            if (idx->pts[jj] < clip->in_time) {
+                // use only the last entry before clip in time
+                // (EP map PTS is truncated, first entry may be slightly before in time)
+                if (jj + 1 < idx->num_ep && idx->pts[jj + 1] <= clip->in_time &&
+                    idx->spn[jj + 1] < clip->end_pkt) {
+                    continue;
+                }
+                kf[num].title_time = clip->title_time;
+            } else {
+                kf[num].title_time = clip->title_time + idx->pts[jj] - clip->in_time;
+            }
+            kf[num].title_pkt  = clip->title_pkt + idx->spn[jj] - clip->start_pkt;
+            kf[num].clip_pkt   = idx->spn[jj];
+            kf[num].clip_ref   = ii;
+            num++;
+        }
+    }
+
+    *count = num;
+    return kf;
+}
+
+/* upper limit of I-picture size (bytes) for EP map I_end_position_offset */
+static const uint32_t i_end_size[8] = {
+    0, 128*1024, 256*1024, 384*1024, 576*1024, 768*1024, 1024*1024, 0,
+};
+
+static void _fill_keyframe(const NAV_CLIP *clip, int entry,
+                           uint32_t *out_pkt, uint32_t *end_pkt, uint32_t *pts)
+{
+    const CLPI_EP_INDEX *idx = &clip->cl->ep_index[0];
+    uint32_t size = i_end_size[clip->cl->cpi.entry[0].fine[entry].i_end_position_offset & 7];
+    uint32_t end;
+
+    *out_pkt = BD_MAX(idx->spn[entry], clip->start_pkt);
+    *pts     = idx->pts[entry];
+
+    // I-picture ends before next entry.
+    // Packet estimate from I-picture size: 184 bytes payload / packet, + 1/4 for multiplexed streams.
+    end = (entry + 1 < idx->num_ep) ? idx->spn[entry + 1] : clip->end_pkt;
+    if (size) {
+        end = BD_MIN(end, *out_pkt + size / 184 + size / 184 / 4);
+    }
+    end = BD_MIN(end, clip->end_pkt);
+
+    *end_pkt = BD_MAX(end, *out_pkt + 1);
+}
+
+// Find random access point 'step' EP map entries forward (step > 0)
+// or backward (step < 0) from the clip position.
+// Returns clip of the entry and entry packet in *out_pkt,
+// estimated end of I-picture in *end_pkt and entry PTS (45 kHz) in *pts.
+// Returns NULL when title start / end is reached.
+NAV_CLIP* nav_keyframe_step(NAV_TITLE *title, NAV_CLIP *clip, uint32_t clip_pkt, int step,
+                            uint32_t *out_pkt, uint32_t *end_pkt, uint32_t *pts)
+{
+    int land = 0;
+
+    while (clip) {
+        int first, last, target;
+
+        if (clip->cl && clip->end_pkt > clip->start_pkt) {
+            first = BD_MAX(clpi_ep_entry(clip->cl, clip->start_pkt), 0);
+            last  = clpi_ep_entry(clip->cl, clip->end_pkt - 1);
+
+            if (land > 0) {
+                target = first;
+            } else if (land < 0) {
+                target = last;
+            } else {
+                target = clpi_ep_entry(clip->cl, clip_pkt) + step;
+            }
+            if (last >= 0 && target >= first && target <= last) {
+                _fill_keyframe(clip, target, out_pkt, end_pkt, pts);
+                return clip;
+            }
+        }
+
+        // continue from first / last entry of next / previous clip
+        if (step > 0) {
+            clip = nav_next_clip(title, clip);
+            land = 1;
+        } else {
+            clip = clip->ref ? &title->clip_list.clip[clip->ref - 1] : NULL;
+            land = -1;
+        }
+    }
+
+    return NULL;
+}
+
 // Search for random access point closest to the requested time
 // Time is in 45khz ticks relative to the beginning of a specific clip
 void nav_clip_time_search(NAV_CLIP *clip, uint32_t tick, uint32_t *clip_pkt, uint32_t *out_pkt)
@@ -762,13 +1591,13 @@ NAV_CLIP* nav_next_clip(NAV_TITLE *title, NAV_CLIP *clip)
     if (clip->ref >= title->clip_list.count - 1) {
         return NULL;
     }
+    _load_clips(title, clip->ref + 1);
     return &title->clip_list.clip[clip->ref + 1];
 }
 
 NAV_CLIP* nav_set_angle(NAV_TITLE *title, NAV_CLIP *clip, unsigned angle)
 {
     int ii;
-    uint32_t pos = 0;
     uint32_t time = 0;
 
     if (title == NULL) {
@@ -784,8 +1613,7 @@ NAV_CLIP* nav_set_angle(NAV_TITLE *title, NAV_CLIP *clip, unsigned angle)
     }
 
     title->angle = angle;
-    // Find length in packets and end_pkt for each clip
-    title->packets = 0;
+    // Clips of new angle. Clip info is re-loaded on demand.
     for (ii = 0; ii < title->pl->list_count; ii++) {
         MPLS_PI *pi;
         NAV_CLIP *cl;
@@ -793,10 +1621,12 @@ NAV_CLIP* nav_set_angle(NAV_TITLE *title, NAV_CLIP *clip, unsigned angle)
         pi = &title->pl->play_item[ii];
         cl = &title->clip_list.clip[ii];
 
-        _fill_clip(title, pi->clip, pi->connection_condition, pi->in_time, pi->out_time, pi->angle_count,
-                   cl, ii, &pos, &time);
+        _init_clip(title, pi->clip, pi->connection_condition, pi->in_time, pi->out_time, pi->angle_count,
+                   cl, ii, &time);
     }
-    _extrapolate_title(title);
+    title->loaded_clips = 0;
+    title->packets = 0;
+    _load_clips(title, clip ? clip->ref : 0);
     return clip;
 }
 
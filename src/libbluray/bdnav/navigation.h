@@ -62,6 +62,13 @@ struct nav_mark_list_s
     NAV_MARK *mark;
 };
 
+/* angle change points of one angle (from EP map) */
+typedef struct {
+    unsigned  count;
+    uint32_t *pkt;   /* clip source packet */
+    uint32_t *time;  /* clip time, 45 kHz */
+} NAV_ANGLE_POINTS;
+
 typedef struct nav_clip_s NAV_CLIP;
 struct nav_clip_s
 {
@@ -72,6 +79,7 @@ struct nav_clip_s
     uint32_t end_pkt;
     uint8_t  connection;
     uint8_t  angle;
+    uint8_t  stc_id;
 
     uint32_t duration;
 
@@ -84,7 +92,14 @@ struct nav_clip_s
 
     NAV_TITLE *title;
 
+    /* clip info is loaded on first use (nav_clip_load()).
+       start_pkt, end_pkt and title_pkt are not valid before that. */
+    uint8_t   loaded;
     CLPI_CL  *cl;
+
+    /* angle change points of all angles (nav_title_angle_points()), NULL if not available */
+    unsigned          angle_count;
+    NAV_ANGLE_POINTS *angle_points;
 };
 
 typedef struct nav_clip_list_s NAV_CLIP_LIST;
@@ -113,12 +128,21 @@ struct nav_title_s {
     unsigned      sub_path_count;
     NAV_SUB_PATH  *sub_path;
 
-    uint32_t      packets;
+    unsigned      loaded_clips;  /* main path clips 0...loaded_clips-1 are loaded */
+    uint32_t      packets;       /* valid after nav_title_load() */
     uint32_t      duration;
 
     MPLS_PL       *pl;
 };
 
+/* random access point (EP map entry) */
+typedef struct {
+    uint32_t        title_time;  /* 45 kHz, relative to title start */
+    uint32_t        title_pkt;
+    uint32_t        clip_pkt;
+    unsigned        clip_ref;
+} NAV_KEYFRAME;
+
 typedef struct nav_title_info_s NAV_TITLE_INFO;
 struct nav_title_info_s
 {
@@ -140,6 +164,12 @@ struct nav_title_list_s
 BD_PRIVATE uint8_t nav_lookup_aspect(NAV_CLIP *clip, int pid);
 BD_PRIVATE NAV_TITLE* nav_title_open(struct bd_disc *disc, const char *playlist, unsigned angle) BD_ATTR_MALLOC;
 BD_PRIVATE void nav_title_close(NAV_TITLE *title);
+/* load clip info of all main path clips (title size, all clip and mark positions) */
+BD_PRIVATE void nav_title_load(NAV_TITLE *title);
+/* load clip info of clip. Main path clips are loaded in order (title_pkt depends on earlier clips). */
+BD_PRIVATE void nav_clip_load(NAV_CLIP *clip);
+/* load clip of mark (mark clip_pkt and title_pkt) */
+BD_PRIVATE void nav_mark_load(NAV_TITLE *title, const NAV_MARK *mark);
 BD_PRIVATE NAV_CLIP* nav_next_clip(NAV_TITLE *title, NAV_CLIP *clip);
 BD_PRIVATE NAV_CLIP* nav_packet_search(NAV_TITLE *title, uint32_t pkt, uint32_t *clip_pkt,
                                        uint32_t *out_pkt, uint32_t *out_time);
@@ -149,9 +179,32 @@ BD_PRIVATE NAV_CLIP* nav_chapter_search(NAV_TITLE *title, unsigned chapter, uint
 BD_PRIVATE uint32_t nav_chapter_get_current(NAV_CLIP *clip, uint32_t clip_pkt);
 BD_PRIVATE NAV_CLIP* nav_mark_search(NAV_TITLE *title, unsigned mark, uint32_t *clip_pkt, uint32_t *out_pkt);
 BD_PRIVATE uint32_t nav_angle_change_search(NAV_CLIP *clip, uint32_t pkt, uint32_t *time);
+/* precompute angle change points of all angles of multi-angle clips */
+BD_PRIVATE void nav_title_angle_points(NAV_TITLE *title);
+/* angle change point at clip time in given angle. Returns 0 if not known. */
+BD_PRIVATE int nav_angle_change_point(const NAV_CLIP *clip, unsigned angle, uint32_t time, uint32_t *pkt);
+BD_PRIVATE const char *nav_angle_clip_name(const NAV_CLIP *clip, unsigned angle, char name[11]);
 BD_PRIVATE NAV_CLIP* nav_set_angle(NAV_TITLE *title, NAV_CLIP *clip, unsigned angle);
 
-BD_PRIVATE NAV_TITLE_LIST* nav_get_title_list(struct bd_disc *disc, uint32_t flags, uint32_t min_title_length) BD_ATTR_MALLOC;
+BD_PRIVATE NAV_KEYFRAME* nav_title_keyframes(NAV_TITLE *title, unsigned *count);
+BD_PRIVATE NAV_CLIP* nav_keyframe_step(NAV_TITLE *title, NAV_CLIP *clip, uint32_t clip_pkt, int step,
+                                      uint32_t *out_pkt, uint32_t *end_pkt, uint32_t *pts);
+
+/* progress callback: called after each title added to (partial) title list.
+ * scanned / total: number of playlists processed / found.
+ * Return non-zero to cancel the scan. */
+typedef int (*nav_title_list_cb)(void *handle, const NAV_TITLE_LIST *title_list, unsigned scanned, unsigned total);
+
+/* num_threads: playlist parsing threads (0 = default)
+ * returns NULL if cancelled */
+BD_PRIVATE NAV_TITLE_LIST* nav_get_title_list(struct bd_disc *disc, uint32_t flags, uint32_t min_title_length,
+                                              unsigned num_threads,
+                                              nav_title_list_cb cb, void *cb_handle) BD_ATTR_MALLOC;
 BD_PRIVATE void nav_free_title_list(NAV_TITLE_LIST *title_list);
 
+/* approximate heap memory used by title (playlist, clip info, EP maps) or title list.
+   Objects shared through disc cache are included. */
+BD_PRIVATE size_t nav_title_memory_size(const NAV_TITLE *title);
+BD_PRIVATE size_t nav_title_list_memory_size(const NAV_TITLE_LIST *title_list);
+
 #endif // _NAVIGATION_H_
@@ -98,11 +98,29 @@ static int _sound_read_samples(BITSTREAM *bs, SOUND_OBJECT *obj)
 {
     uint32_t n;
     uint32_t num_samples = obj->num_frames * obj->num_channels;
+    uint32_t num_avail;
+    uint8_t *p;
 
     obj->samples = calloc(num_samples, sizeof(uint16_t));
+    if (num_samples && !obj->samples) {
+        return 0;
+    }
+
+    num_avail = num_samples;
+    if (bs_avail(bs) < (int64_t)num_samples * 16) {
+        num_avail = (uint32_t)(BD_MAX(bs_avail(bs), 0) / 16);
+        BD_DEBUG(DBG_NAV | DBG_CRIT, "sound data truncated\n");
+    }
 
-    for (n = 0; n < num_samples; n++) {
-        obj->samples[n] = bs_read(bs, 16);
+    /* read big-endian samples as one block and convert in place */
+    p = (uint8_t *)obj->samples;
+    for (n = 0; n < num_avail; ) {
+        uint32_t chunk = BD_MIN(num_avail - n, BF_BUF_SIZE / 4);
+        bs_read_bytes(bs, p + 2 * n, 2 * chunk);
+        n += chunk;
+    }
+    for (n = 0; n < num_avail; n++) {
+        obj->samples[n] = (uint16_t)(p[2 * n] << 8 | p[2 * n + 1]);
     }
 
     return 1;
@@ -178,11 +196,13 @@ static SOUND_DATA *_sound_parse(BD_FILE_H *fp)
     }
 
     X_FREE(data_offsets);
+    bs_close(&bs);
     return data;
 
  error:
     sound_free(&data);
     X_FREE(data_offsets);
+    bs_close(&bs);
     return NULL;
 }
 
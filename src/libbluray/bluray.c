@@ -27,13 +27,23 @@
 #include "bluray.h"
 #include "bluray_internal.h"
 #include "register.h"
+#include "async_read.h"
+#include "fanout.h"
 #include "util/array.h"
+#include "decoders/overlay.h" /* before refcnt.h */
+#include "util/refcnt.h"
+#include "util/sha1.h"
 #include "util/macro.h"
 #include "util/logging.h"
 #include "util/strutl.h"
+#include "util/time.h"
+#include "util/atomic.h"
 #include "util/mutex.h"
+#include "util/thread.h"
+#include "util/timers.h"
 #include "bdnav/bdid_parse.h"
 #include "bdnav/navigation.h"
+#include "bdnav/nav_cache.h"
 #include "bdnav/index_parse.h"
 #include "bdnav/meta_parse.h"
 #include "bdnav/meta_data.h"
@@ -42,11 +52,19 @@
 #include "hdmv/hdmv_vm.h"
 #include "hdmv/mobj_parse.h"
 #include "decoders/graphics_controller.h"
+#include "decoders/hdmv_pids.h"
+#include "decoders/m2ts_demux.h"
 #include "decoders/m2ts_filter.h"
-#include "decoders/overlay.h"
+#include "decoders/m2ts_scan.h"
+#include "decoders/pes_buffer.h"
+#include "disc/dec.h"
 #include "disc/disc.h"
+#include "disc/read_ahead.h"
+#include "disc/unit_cache.h"
 #include "disc/enc_info.h"
+#include "file/drive.h"
 #include "file/file.h"
+#include "file/io_trace.h"
 #ifdef USING_BDJAVA
 #include "bdj/bdj.h"
 #include "bdj/bdjo_parse.h"
@@ -57,32 +75,138 @@
 #include <inttypes.h>
 #include <string.h>
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_EVENT_FD 1
+#endif
+
 
+/*
+ * Events are produced with bd->mutex locked (single producer).
+ * Consumers (bd_read_ext() and bd_get_event()) do not take any lock.
+ * Without atomics the queue falls back to locking eq->mutex.
+ */
 #define MAX_EVENTS 31  /* 2^n - 1 */
 typedef struct bd_event_queue_s {
-    BD_MUTEX mutex;
-    unsigned in;  /* next free slot */
-    unsigned out; /* next event */
-    BD_EVENT ev[MAX_EVENTS+1];
+    BD_MUTEX       mutex;   /* blocking wait (and queue access without atomics) */
+    BD_COND        cond;
+    BD_ATOMIC_UINT waiting;
+    uint8_t        wakeup;  /* wake up bd_wait_still() without event (user input). Protected by mutex. */
+    BD_ATOMIC_UINT in;  /* next free slot */
+    BD_ATOMIC_UINT out; /* next event */
+    BD_EVENT       ev[MAX_EVENTS+1];
+
+    /* events that did not fit to ring. Accessed only with bd->mutex locked. */
+    BD_ATOMIC_UINT num_pending;
+    unsigned       pending_size;
+    BD_EVENT      *pending;
+    unsigned       max_pending;
+
+    unsigned       max_queued; /* high-water mark (statistics) */
+
+    int            notify[2];  /* pipe: [0] is polled by application (bd_get_event_fd()). Created once. */
 } BD_EVENT_QUEUE;
 
+#define MAX_PENDING_EVENTS 1024
+
+/* BLURAY_PLAYER_SETTING_LOW_MEMORY limits */
+#define LOW_MEM_PENDING_EVENTS    (MAX_EVENTS + 1)
+#define LOW_MEM_READ_AHEAD_UNITS  (1024*1024 / 6144)    /* 1M */
+#define LOW_MEM_UNIT_CACHE_UNITS  (1024*1024 / 6144)    /* 1M */
+#define LOW_MEM_FANOUT_UNITS      (2*1024*1024 / 6144)  /* 2M */
+#define LOW_MEM_GRAPHICS_KB       4096
+#define LOW_MEM_DISC_CACHE_SIZE   (1024*1024)
+
+/* BLURAY_PLAYER_SETTING_DRIVE_SPEED */
+#define DRIVE_SPEED_AUTO          1
+#define DRIVE_SPEED_HEADROOM      50                    /* % above clip recording rate */
+#define DRIVE_READ_AHEAD_UNITS    (8*1024*1024 / 6144)  /* default read-ahead when drive is slowed down */
+
+/* events reporting current state: only the latest value matters */
+#define COALESCE_EVENTS ((1u << BD_EVENT_ANGLE)                  | \
+                         (1u << BD_EVENT_TITLE)                  | \
+                         (1u << BD_EVENT_PLAYLIST)               | \
+                         (1u << BD_EVENT_PLAYITEM)               | \
+                         (1u << BD_EVENT_CHAPTER)                | \
+                         (1u << BD_EVENT_AUDIO_STREAM)           | \
+                         (1u << BD_EVENT_IG_STREAM)              | \
+                         (1u << BD_EVENT_PG_TEXTST_STREAM)       | \
+                         (1u << BD_EVENT_PIP_PG_TEXTST_STREAM)   | \
+                         (1u << BD_EVENT_SECONDARY_AUDIO_STREAM) | \
+                         (1u << BD_EVENT_SECONDARY_VIDEO_STREAM) | \
+                         (1u << BD_EVENT_PG_TEXTST)              | \
+                         (1u << BD_EVENT_PIP_PG_TEXTST)          | \
+                         (1u << BD_EVENT_SECONDARY_AUDIO)        | \
+                         (1u << BD_EVENT_SECONDARY_VIDEO)        | \
+                         (1u << BD_EVENT_SECONDARY_VIDEO_SIZE)   | \
+                         (1u << BD_EVENT_STILL)                  | \
+                         (1u << BD_EVENT_POPUP)                  | \
+                         (1u << BD_EVENT_MENU)                   | \
+                         (1u << BD_EVENT_STEREOSCOPIC_STATUS))
+#define CAN_COALESCE(ev) ((ev) < 32 && (COALESCE_EVENTS & (1u << (ev))))
+
+#ifdef BD_HAVE_ATOMICS
+#  define EQ_LOCK(eq)    do { } while (0)
+#  define EQ_UNLOCK(eq)  do { } while (0)
+#else
+#  define EQ_LOCK(eq)    bd_mutex_lock(&(eq)->mutex)
+#  define EQ_UNLOCK(eq)  bd_mutex_unlock(&(eq)->mutex)
+#endif
+
 typedef enum {
     title_undef = 0,
     title_hdmv,
     title_bdj,
 } BD_TITLE_TYPE;
 
+/* damaged area recovery state (BLURAY_PLAYER_SETTING_READ_ERROR_BUDGET) */
+typedef struct {
+    uint8_t        active;
+    uint32_t       skip;      /* current forward skip distance (units) */
+    uint64_t       bad_end;   /* end of last unreadable unit */
+    uint64_t       good_pos;  /* first known readable unit after damaged area (0 = not found yet) */
+    uint64_t       next_pos;  /* position set by recovery (detects seeks and clip changes) */
+    uint64_t       start_us;  /* time of first read error in damaged area */
+} BD_READ_ERROR;
+
+/* per-stream statistics */
+typedef struct {
+    BLURAY_STREAM_STATS s;
+    DEC_STATS           dec;  /* updated by the stream decrypt layer */
+} BD_STREAM_STATS;
+
+/* periodic metrics reporting (bd_register_metrics_cb()) */
+typedef struct {
+    bd_metrics_cb_f cb;
+    void           *handle;
+    uint64_t        interval_us;
+    uint64_t        last_us;   /* time of previous report */
+    BLURAY_METRICS  last;      /* counter values at previous report */
+} BD_METRICS;
+
 typedef struct {
     /* current clip */
     NAV_CLIP       *clip;
     BD_FILE_H      *fp;
+    BD_STREAM_STATS *stats;
     uint64_t       clip_size;
     uint64_t       clip_block_pos;
     uint64_t       clip_pos;
+    uint64_t       prefetch_pos; /* read-ahead hint given up to this clip position */
 
     /* current aligned unit */
     uint16_t       int_buf_off;
 
+    /* read-ahead buffer: aligned units read from disc but not yet consumed */
+    uint8_t        *rd_buf;      /* reference-counted */
+    size_t         rd_buf_len;
+    size_t         rd_buf_off;
+    uint8_t        rd_buf_shared; /* buffer has been handed out with bd_read_units() */
+    uint64_t       rd_limit;     /* do not fill read buffer past this clip position (0 = no limit) */
+
+    UNIT_CACHE     *cache;        /* decrypted units (optional) */
+
     BD_UO_MASK     uo_mask;
 
     /* internally handled pids */
@@ -90,17 +214,85 @@ typedef struct {
     uint16_t        pg_pid; /* pid of currently selected PG stream */
 
     M2TS_FILTER    *m2ts_filter;
+
+    /* parsed packet headers of current unit */
+    M2TS_UNIT_INFO  unit_info;
+    uint8_t         unit_info_valid;
+
+    /* unit timing: title time (90 kHz) of last PCR and its arrival time stamp */
+    int64_t         time_ref;
+    uint32_t        ats_ref;
+    uint8_t         time_ref_valid;
+    uint8_t         unit_time_reported; /* current unit has been reported to bd_read_timed() caller */
+    uint8_t         unit_paced;         /* current unit has been released by output pacing */
+    uint8_t         background;         /* read from sub path preload thread: do not queue events */
+
+    BD_READ_ERROR   rd_err;
 } BD_STREAM;
 
+#define PRELOAD_DONE    1
+#define PRELOAD_FAILED  2
+
 typedef struct {
     NAV_CLIP *clip;
-    size_t    clip_size;
-    uint8_t  *buf;
+    uint64_t  clip_size;
+
+    /* background loading (BLURAY_PLAYER_SETTING_ASYNC_PRELOAD) */
+    struct bluray  *bd;
+    BD_THREAD      thread;
+    uint8_t        loading;          /* thread started and not yet joined */
+    uint16_t       pid;
+    uint8_t        stop_on_complete;
+    uint8_t        char_code;        /* TextST */
+    BD_ATOMIC_UINT cancel;
+    BD_ATOMIC_UINT done;             /* PRELOAD_DONE / PRELOAD_FAILED */
 } BD_PRELOAD;
 
+typedef struct {
+    NAV_CLIP  *clip;
+    char       name[11];  /* clip file (may change with angle) */
+    BD_FILE_H *fp;
+    int64_t    clip_size;
+} BD_PREOPEN;
+
+/*
+ * Recently used main path clip streams (file + decrypt context + stream filter),
+ * kept open when seeking to another clip of the same title.
+ */
+#define CLIP_HANDLE_CACHE_SIZE  4
+
+typedef struct {
+    NAV_CLIP    *clip;
+    char         name[11];  /* clip file (may change with angle) */
+    BD_FILE_H   *fp;
+    int64_t      clip_size;
+    M2TS_FILTER *m2ts_filter;
+    uint64_t     last_use;
+} BD_CLIP_HANDLE;
+
+/*
+ * State published for API calls that should not wait behind stream I/O.
+ * Updated by the reading thread before it starts blocking I/O.
+ */
+#define MAX_PENDING_KEYS  8
+
+typedef struct {
+    BD_RWLOCK lock;
+
+    uint64_t  s_pos;
+    uint64_t  time;     /* 90 kHz */
+    uint32_t  chapter;
+
+    /* user input received while stream was being read */
+    unsigned  num_keys;
+    int64_t   key_pts[MAX_PENDING_KEYS];
+    uint32_t  key[MAX_PENDING_KEYS];
+} BD_PUBLIC_STATE;
+
 struct bluray {
 
     BD_MUTEX          mutex;  /* protect API function access to internal data */
+    BD_PUBLIC_STATE   pub;    /* read-mostly state, own lock */
 
     /* current disc */
     BD_DISC          *disc;
@@ -118,14 +310,78 @@ struct bluray {
     BD_STREAM      st0; /* main path */
     BD_PRELOAD     st_ig; /* preloaded IG stream sub path */
     BD_PRELOAD     st_textst; /* preloaded TextST sub path */
-
-    /* buffer for bd_read(): current aligned unit of main stream (st0) */
-    uint8_t        int_buf[6144];
+    NAV_CLIP       *prefetch_clip; /* next clip of main path (read-ahead hint given) */
+    BD_PREOPEN     st_next;        /* pre-opened next clip of main path */
+    BD_CLIP_HANDLE clip_handles[CLIP_HANDLE_CACHE_SIZE];  /* main path clips left by seek */
+    uint64_t       clip_handle_seq;
+    unsigned       read_ahead_units; /* main path background read-ahead buffer size */
+    unsigned       scan_threads;     /* bd_get_titles() playlist parsing threads (0 = default) */
+    uint8_t        nav_cache;        /* use persistent title list cache */
+    uint8_t        lazy_decrypt;     /* defer libaacs / libbdplus initialization */
+    uint8_t        shared_decrypt;   /* share libaacs instance with other BLURAY objects */
+    uint8_t        direct_io;        /* unbuffered stream file access */
+    uint8_t        graphics_thread;  /* decode main path PG stream in separate thread */
+    unsigned       pg_preroll_ms;    /* decode PG stream before seek point after seek */
+    uint8_t        overlay_index;    /* include palette index image in overlay DRAW events */
+    uint8_t        overlay_argb;     /* include ARGB image in overlay DRAW events */
+    uint32_t       graphics_memory_kb; /* decoded IG object budget (0 = unlimited) */
+    uint32_t       read_error_budget_ms; /* damaged area search time (0 = skip one unit after each error) */
+    uint32_t       drive_speed;      /* BLURAY_PLAYER_SETTING_DRIVE_SPEED (0 = not controlled) */
+    BD_DRIVE       *drive;           /* optical drive speed control */
+    char           *drive_path;      /* device path given to bd_open() */
+    unsigned       ig_decode_threads; /* IG object decoding threads (0 = decode in calling thread) */
+    uint8_t        low_memory;       /* cap buffers and caches (BLURAY_PLAYER_SETTING_LOW_MEMORY) */
+    uint8_t        async_preload;    /* load IG / TextST sub paths in background thread */
+    uint8_t        continuous_read;  /* do not split reads at seamless clip boundaries */
+    uint8_t        pl_prefetch;      /* prefetch playlists reachable from HDMV menu */
+    uint8_t        enc_info_pending; /* disc_info AACS/BD+ fields not yet complete */
+
+    BLURAY_STARTUP_PROFILE profile;
+
+    /* bd_get_titles_async() */
+    BD_THREAD      title_scan_thread;
+    uint8_t        title_scan_running;
+    BD_ATOMIC_UINT title_scan_cancel;
+    uint8_t        title_scan_flags;
+    uint32_t       title_scan_min_length;
+    void         (*title_scan_cb)(void *, const BLURAY_TITLE_SCAN *);
+    void          *title_scan_handle;
+    uint32_t       title_scan_count;  /* titles reported */
+    uint32_t       title_scan_total;  /* playlists processed */
+
+    /* speculative playlist prefetch */
+    BD_THREAD      pl_prefetch_thread;
+    uint8_t        pl_prefetch_running;
+    BD_ATOMIC_UINT pl_prefetch_cancel;
+    BD_MUTEX       pl_prefetch_mutex;  /* protects list, count, next and done */
+    uint8_t        pl_prefetch_done;   /* thread has exited */
+    unsigned       pl_prefetch_count;
+    unsigned       pl_prefetch_next;
+    uint32_t       pl_prefetch_list[HDMV_MAX_NAV_TARGETS];
+
+    /* statistics */
+    BD_STREAM_STATS stats_main;
+    BD_STREAM_STATS stats_preload;
+    BD_STREAM_STATS stats_textst;
+    BD_TRACE_BUF    *trace;
+    uint32_t        bdj_events;      /* events delivered to BD-J */
+    uint64_t        bdj_event_time;  /* time spent delivering BD-J events (us) */
+    BD_METRICS      metrics;
+
+    /* bd_read(): current aligned unit of main stream (st0). Points to st0 read buffer. */
+    uint8_t        *int_buf;
 
     /* seamless angle change request */
     int            seamless_angle_change;
     uint32_t       angle_change_pkt;
     uint32_t       angle_change_time;
+    uint8_t        angle_change_target_valid;
+    uint32_t       angle_change_target_pkt;  /* angle change point in requested angle */
+
+    /* trick-play (I-frame only) reading */
+    int            trick_step;     /* EP map entries per jump, 0 = disabled */
+    uint32_t       trick_pkt;      /* clip packet of current I-frame */
+    uint32_t       trick_end_pkt;  /* end of current I-frame, 0 = jump from current position */
     unsigned       request_angle;
 
     /* mark tracking */
@@ -144,18 +400,60 @@ struct bluray {
 
     HDMV_VM        *hdmv_vm;
     uint8_t        hdmv_suspended;
+    uint8_t        hdmv_profile;      /* collect per-object HDMV VM statistics */
+    unsigned       hdmv_insn_budget;  /* max. HDMV instructions per bd_read_ext() call (0 = unlimited) */
 #ifdef USING_BDJAVA
     BDJAVA         *bdjava;
     BDJ_STORAGE     bdjstorage;
 #endif
     uint8_t         bdj_wait_start;  /* BD-J has selected playlist (prefetch) but not yet started playback */
 
+    /* still mode play item reached (bd_wait_still()) */
+    uint8_t         still_active;
+    uint64_t        still_end_us;    /* end of timed still (bd_get_time_us()), 0 = infinite */
+    uint8_t         bdj_keep_warm;   /* leave BD-J stack running after bdj_close() */
+
     /* HDMV graphics */
     GRAPHICS_CONTROLLER *graphics_controller;
     SOUND_DATA          *sound_effects;
+    uint8_t              sound_effects_loaded; /* sound.bdmv has been parsed (or does not exist) */
     uint32_t             gc_status;
     uint8_t              decode_pg;
 
+    /* asynchronous reading */
+    BD_ASYNC_READER     *async_reader;
+
+    /* fan-out reading */
+    BD_FANOUT           *fanout;
+
+    /* internal timer thread (IG effects and timeouts, still time) */
+    BD_TIMERS           *timers;
+
+    /* per-unit timing (bd_read_timed()) */
+    uint8_t              unit_timing;  /* track PCR of main path */
+    BD_UNIT_TIME        *unit_times;   /* output of current bd_read_timed() call */
+    unsigned             max_unit_times;
+    unsigned             num_unit_times;
+
+    /* rate-paced output */
+    uint32_t             pace_lead_ms;  /* 0 = disabled */
+    float                pace_rate;     /* playback rate (BD-J), <= 0 holds output */
+    uint8_t              pace_valid;    /* anchor is valid */
+    uint64_t             pace_wall;     /* anchor: wall clock time (us) */
+    int64_t              pace_time;     /* anchor: title time (90 kHz) */
+    BD_COND              pace_cond;     /* wakes up reader waiting for release time */
+    BD_MUTEX             pace_mutex;    /* leaf lock for pace_cond and pace_seq. Never held recursively. */
+    unsigned             pace_seq;      /* incremented when anchor or rate changes */
+    unsigned             pace_wait_ms;  /* reader must wait before retrying (set by _bd_readv()) */
+    unsigned             pace_wait_seq; /* pace_seq when wait was requested */
+
+    /* elementary stream extraction */
+    M2TS_DEMUX          *es_demux;
+    uint16_t             es_pids[BD_ES_MAX_PIDS];
+    unsigned             es_num_pids;
+    void                *es_proc_handle;
+    bd_es_proc_f         es_proc;
+
     /* TextST */
     uint32_t gc_wakeup_time;  /* stream timestamp of next subtitle */
     uint64_t gc_wakeup_pos;   /* stream position of gc_wakeup_time */
@@ -165,6 +463,7 @@ struct bluray {
     void                *argb_overlay_proc_handle;
     bd_argb_overlay_proc_f argb_overlay_proc;
     BD_ARGB_BUFFER      *argb_buffer;
+    BD_ARGB_BUFFER_EXT  *argb_buffer_ext;  /* NULL if registered with bd_register_argb_overlay_proc() */
     BD_MUTEX             argb_buffer_mutex;
     BD_UO_MASK           bdj_uo_mask;
 #endif
@@ -184,49 +483,222 @@ void bd_get_version(int *major, int *minor, int *micro)
     *micro = BLURAY_VERSION_MICRO;
 }
 
+void bd_set_thread_start_handler(void *handle, bd_thread_start_f func)
+{
+    bd_thread_set_start_handler(handle, func);
+}
+
+void bd_set_decryptor(const BD_DECRYPTOR *decryptor)
+{
+    dec_set_decryptor(decryptor);
+}
+
+int bd_set_io_trace(const char *trace_file)
+{
+    io_trace_stop();
+    if (trace_file) {
+        return io_trace_start(trace_file) == 0;
+    }
+    return 1;
+}
+
 /*
  * Navigation mode event queue
  */
 
+/* make notification fd readable */
+static void _notify_event(BD_EVENT_QUEUE *eq)
+{
+#ifdef HAVE_EVENT_FD
+    if (eq->notify[1] >= 0) {
+        const uint8_t b = 0;
+        /* pipe may be full if application does not read events. It is readable anyway. */
+        if (write(eq->notify[1], &b, 1) < 0) {
+            /* EAGAIN: notification already pending */
+        }
+    }
+#else
+    (void)eq;
+#endif
+}
+
+/* clear notification fd. Events queued after this make it readable again. */
+static void _clear_notify(BD_EVENT_QUEUE *eq)
+{
+#ifdef HAVE_EVENT_FD
+    if (eq->notify[0] >= 0) {
+        uint8_t tmp[64];
+        while (read(eq->notify[0], tmp, sizeof(tmp)) > 0) {
+        }
+    }
+#else
+    (void)eq;
+#endif
+}
+
 static void _init_event_queue(BLURAY *bd)
 {
     if (!bd->event_queue) {
         bd->event_queue = calloc(1, sizeof(struct bd_event_queue_s));
+        bd->event_queue->notify[0] = -1;
+        bd->event_queue->notify[1] = -1;
+        bd->event_queue->max_pending = bd->low_memory ? LOW_MEM_PENDING_EVENTS : MAX_PENDING_EVENTS;
         bd_mutex_init(&bd->event_queue->mutex);
+        bd_cond_init(&bd->event_queue->cond);
     } else {
-        bd_mutex_lock(&bd->event_queue->mutex);
-        bd->event_queue->in  = 0;
-        bd->event_queue->out = 0;
-        memset(bd->event_queue->ev, 0, sizeof(bd->event_queue->ev));
-        bd_mutex_unlock(&bd->event_queue->mutex);
+        /* drop pending events */
+        BD_EVENT_QUEUE *eq = bd->event_queue;
+        EQ_LOCK(eq);
+        bd_atomic_store(&eq->out, bd_atomic_load(&eq->in));
+        bd_atomic_store(&eq->num_pending, 0);
+        EQ_UNLOCK(eq);
+        _clear_notify(eq);
     }
 }
 
 static void _free_event_queue(BLURAY *bd)
 {
     if (bd->event_queue) {
+#ifdef HAVE_EVENT_FD
+        if (bd->event_queue->notify[0] >= 0) {
+            close(bd->event_queue->notify[0]);
+            close(bd->event_queue->notify[1]);
+        }
+#endif
+        bd_cond_destroy(&bd->event_queue->cond);
         bd_mutex_destroy(&bd->event_queue->mutex);
+        X_FREE(bd->event_queue->pending);
         X_FREE(bd->event_queue);
     }
 }
 
+static int _ring_put(BD_EVENT_QUEUE *eq, uint32_t event, uint32_t param)
+{
+    unsigned in, new_in;
+
+    EQ_LOCK(eq);
+
+    in     = bd_atomic_load(&eq->in);
+    new_in = (in + 1) & MAX_EVENTS;
+
+    if (new_in == bd_atomic_load(&eq->out)) {
+        EQ_UNLOCK(eq);
+        return 0;
+    }
+
+    eq->ev[in].event = event;
+    eq->ev[in].param = param;
+    bd_atomic_store(&eq->in, new_in);
+
+    EQ_UNLOCK(eq);
+
+    _notify_event(eq);
+
+    /* wake up bd_wait_event() */
+    bd_atomic_fence();
+    if (bd_atomic_load(&eq->waiting)) {
+        bd_mutex_lock(&eq->mutex);
+        bd_cond_signal(&eq->cond);
+        bd_mutex_unlock(&eq->mutex);
+    }
+
+    return 1;
+}
+
+/* move pending events to ring. Called with bd->mutex locked. */
+static void _flush_events(BD_EVENT_QUEUE *eq)
+{
+    unsigned num = bd_atomic_load(&eq->num_pending);
+    unsigned ii;
+
+    for (ii = 0; ii < num; ii++) {
+        if (!_ring_put(eq, eq->pending[ii].event, eq->pending[ii].param)) {
+            break;
+        }
+    }
+
+    if (ii > 0) {
+        memmove(eq->pending, eq->pending + ii, (num - ii) * sizeof(BD_EVENT));
+        bd_atomic_store(&eq->num_pending, num - ii);
+    }
+}
+
+/* ring is full. Called with bd->mutex locked. */
+static int _pend_event(BD_EVENT_QUEUE *eq, uint32_t event, uint32_t param)
+{
+    unsigned num = bd_atomic_load(&eq->num_pending);
+
+    /* replace previous state update if no other kind of event has been queued after it */
+    if (CAN_COALESCE(event)) {
+        unsigned ii;
+        for (ii = num; ii > 0 && CAN_COALESCE(eq->pending[ii - 1].event); ii--) {
+            if (eq->pending[ii - 1].event == event) {
+                memmove(eq->pending + ii - 1, eq->pending + ii, (num - ii) * sizeof(BD_EVENT));
+                eq->pending[num - 1].event = event;
+                eq->pending[num - 1].param = param;
+                return 1;
+            }
+        }
+    }
+
+    if (num >= eq->pending_size) {
+        unsigned new_size = eq->pending_size ? 2 * eq->pending_size : MAX_EVENTS + 1;
+        BD_EVENT *tmp = NULL;
+        if (new_size <= eq->max_pending) {
+            tmp = realloc(eq->pending, new_size * sizeof(BD_EVENT));
+        }
+        if (!tmp) {
+            BD_DEBUG(DBG_BLURAY|DBG_CRIT, "_queue_event(%d, %d): queue overflow !\n", event, param);
+            return 0;
+        }
+        BD_DEBUG(DBG_BLURAY, "event queue grown to %u events\n", new_size + MAX_EVENTS);
+        eq->pending      = tmp;
+        eq->pending_size = new_size;
+    }
+
+    eq->pending[num].event = event;
+    eq->pending[num].param = param;
+    bd_atomic_store(&eq->num_pending, num + 1);
+
+    return 1;
+}
+
 static int _get_event(BLURAY *bd, BD_EVENT *ev)
 {
     struct bd_event_queue_s *eq = bd->event_queue;
+    int notify_cleared = 0;
+    unsigned out;
 
     if (eq) {
-        bd_mutex_lock(&eq->mutex);
+ retry:
+        /* refill ring from pending events unless stream is being read */
+        if (bd_atomic_load(&eq->num_pending) && !bd_mutex_trylock(&bd->mutex)) {
+            _flush_events(eq);
+            bd_mutex_unlock(&bd->mutex);
+        }
 
-        if (eq->in != eq->out) {
+        EQ_LOCK(eq);
 
-            *ev = eq->ev[eq->out];
-            eq->out = (eq->out + 1) & MAX_EVENTS;
+        out = bd_atomic_load(&eq->out);
 
-            bd_mutex_unlock(&eq->mutex);
-            return 1;
+        /* CAS keeps the queue consistent if both consumers run at once */
+        while (out != bd_atomic_load(&eq->in)) {
+            BD_EVENT tmp = eq->ev[out];
+            if (bd_atomic_cas(&eq->out, &out, (out + 1) & MAX_EVENTS)) {
+                EQ_UNLOCK(eq);
+                *ev = tmp;
+                return 1;
+            }
         }
 
-        bd_mutex_unlock(&eq->mutex);
+        EQ_UNLOCK(eq);
+
+        /* queue is empty: clear notification and check again (event may have been queued in between) */
+        if (eq->notify[0] >= 0 && !notify_cleared) {
+            _clear_notify(eq);
+            notify_cleared = 1;
+            goto retry;
+        }
     }
 
     ev->event = BD_EVENT_NONE;
@@ -234,27 +706,69 @@ static int _get_event(BLURAY *bd, BD_EVENT *ev)
     return 0;
 }
 
-static int _queue_event(BLURAY *bd, uint32_t event, uint32_t param)
+static int _wait_event(BLURAY *bd, BD_EVENT *ev, unsigned timeout_ms)
 {
     struct bd_event_queue_s *eq = bd->event_queue;
 
+    if (_get_event(bd, ev) || !eq || !timeout_ms) {
+        return ev->event != BD_EVENT_NONE;
+    }
+
+    bd_mutex_lock(&eq->mutex);
+    bd_atomic_store(&eq->waiting, 1);
+    bd_atomic_fence();
+    if (bd_atomic_load(&eq->out) == bd_atomic_load(&eq->in)) {
+        bd_cond_timedwait(&eq->cond, &eq->mutex, timeout_ms);
+    }
+    bd_atomic_store(&eq->waiting, 0);
+    bd_mutex_unlock(&eq->mutex);
+
+    return _get_event(bd, ev);
+}
+
+/* wake up thread blocked in bd_wait_still() */
+static void _wake_event_waiter(BLURAY *bd)
+{
+    BD_EVENT_QUEUE *eq = bd->event_queue;
+
     if (eq) {
         bd_mutex_lock(&eq->mutex);
+        eq->wakeup = 1;
+        bd_cond_signal(&eq->cond);
+        bd_mutex_unlock(&eq->mutex);
+    }
+}
 
-        unsigned new_in = (eq->in + 1) & MAX_EVENTS;
+static void _update_queue_stats(BD_EVENT_QUEUE *eq)
+{
+    unsigned queued = ((bd_atomic_load(&eq->in) - bd_atomic_load(&eq->out)) & MAX_EVENTS) +
+                      bd_atomic_load(&eq->num_pending);
+    if (queued > eq->max_queued) {
+        eq->max_queued = queued;
+    }
+}
 
-        if (new_in != eq->out) {
-            eq->ev[eq->in].event = event;
-            eq->ev[eq->in].param = param;
-            eq->in = new_in;
+static int _queue_event(BLURAY *bd, uint32_t event, uint32_t param)
+{
+    struct bd_event_queue_s *eq = bd->event_queue;
+    int result;
 
-            bd_mutex_unlock(&eq->mutex);
-            return 1;
+    if (eq) {
+        if (bd_atomic_load(&eq->num_pending)) {
+            _flush_events(eq);
         }
 
-        bd_mutex_unlock(&eq->mutex);
+        BD_TRACE(bd->trace, BD_TRACE_EVENT, param, event);
+
+        /* keep order: use ring only if there are no older pending events */
+        if (!bd_atomic_load(&eq->num_pending) && _ring_put(eq, event, param)) {
+            result = 1;
+        } else {
+            result = _pend_event(eq, event, param);
+        }
 
-        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "_queue_event(%d, %d): queue overflow !\n", event, param);
+        _update_queue_stats(eq);
+        return result;
     }
 
     return 0;
@@ -321,6 +835,9 @@ static void _update_clip_psrs(BLURAY *bd, NAV_CLIP *clip)
     MPLS_STN *stn = &clip->title->pl->play_item[clip->ref].stn;
     uint32_t audio_lang = 0;
 
+    /* single notification for each changed register */
+    bd_psr_begin(bd->regs);
+
     bd_psr_write(bd->regs, PSR_PLAYITEM, clip->ref);
     bd_psr_write(bd->regs, PSR_TIME,     clip->in_time);
 
@@ -381,6 +898,8 @@ static void _update_clip_psrs(BLURAY *bd, NAV_CLIP *clip)
             bd_psr_unlock(bd->regs);
         }
     }
+
+    bd_psr_commit(bd->regs);
 }
 
 static int _is_interactive_title(BLURAY *bd)
@@ -478,9 +997,9 @@ static int _init_pg_stream(BLURAY *bd)
 
 static void _update_textst_timer(BLURAY *bd)
 {
-    if (bd->st_textst.clip) {
+    if (bd->st_textst.clip && !bd->st_textst.loading) {
         if (bd->st0.clip_block_pos >= bd->gc_wakeup_pos) {
-            GC_NAV_CMDS cmds = {-1, NULL, -1, 0, 0, EMPTY_UO_MASK};
+            GC_NAV_CMDS cmds = {-1, NULL, -1, 0, 0, EMPTY_UO_MASK, 0, NULL};
 
             gc_run(bd->graphics_controller, GC_CTRL_PG_UPDATE, bd->gc_wakeup_time, &cmds);
 
@@ -505,7 +1024,7 @@ static void _update_textst_timer(BLURAY *bd)
 
 static void _init_textst_timer(BLURAY *bd)
 {
-    if (bd->st_textst.clip && bd->st0.clip->cl) {
+    if (bd->st_textst.clip && !bd->st_textst.loading && bd->st0.clip->cl) {
         uint32_t clip_time;
         clpi_access_point(bd->st0.clip->cl, SPN(bd->st0.clip_block_pos), /*next=*/0, /*angle_change=*/0, &clip_time);
         bd->gc_wakeup_time = clip_time;
@@ -518,6 +1037,14 @@ static void _init_textst_timer(BLURAY *bd)
  * clip access (BD_STREAM)
  */
 
+#define STREAM_READ_UNITS  32  /* number of aligned units read from disc at once */
+
+static void _reset_read_buffer(BD_STREAM *st)
+{
+    st->rd_buf_len = 0;
+    st->rd_buf_off = 0;
+}
+
 static void _close_m2ts(BD_STREAM *st)
 {
     if (st->fp != NULL) {
@@ -525,34 +1052,255 @@ static void _close_m2ts(BD_STREAM *st)
         st->fp = NULL;
     }
 
+    bd_refcnt_dec(st->rd_buf);
+    st->rd_buf = NULL;
+    st->rd_buf_shared = 0;
+    _reset_read_buffer(st);
+
     m2ts_filter_close(&st->m2ts_filter);
 
     /* reset UO mask */
     memset(&st->uo_mask, 0, sizeof(st->uo_mask));
 }
 
+static void _close_preopen(BD_PREOPEN *p)
+{
+    if (p->fp) {
+        file_close(p->fp);
+    }
+    memset(p, 0, sizeof(*p));
+}
+
+static void _close_clip_handle(BD_CLIP_HANDLE *h)
+{
+    if (h->fp) {
+        file_close(h->fp);
+    }
+    m2ts_filter_close(&h->m2ts_filter);
+    memset(h, 0, sizeof(*h));
+}
+
+static void _flush_clip_handles(BLURAY *bd)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < CLIP_HANDLE_CACHE_SIZE; ii++) {
+        _close_clip_handle(&bd->clip_handles[ii]);
+    }
+}
+
+/* move opened main path clip to handle cache (least recently used handle is closed) */
+static void _park_m2ts(BLURAY *bd, BD_STREAM *st)
+{
+    BD_CLIP_HANDLE *h = &bd->clip_handles[0];
+    unsigned ii;
+
+    if (!st->fp || !st->clip || st->clip_size <= 0) {
+        return;
+    }
+
+    for (ii = 1; ii < CLIP_HANDLE_CACHE_SIZE && h->fp; ii++) {
+        if (!bd->clip_handles[ii].fp || bd->clip_handles[ii].last_use < h->last_use) {
+            h = &bd->clip_handles[ii];
+        }
+    }
+    _close_clip_handle(h);
+
+    h->clip        = st->clip;
+    strcpy(h->name, st->clip->name);
+    h->fp          = st->fp;
+    h->clip_size   = st->clip_size;
+    h->m2ts_filter = st->m2ts_filter;
+    h->last_use    = ++bd->clip_handle_seq;
+
+    st->fp          = NULL;
+    st->m2ts_filter = NULL;
+}
+
+/* take opened clip from handle cache */
+static BD_FILE_H *_unpark_m2ts(BLURAY *bd, BD_STREAM *st, int64_t *clip_size)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < CLIP_HANDLE_CACHE_SIZE; ii++) {
+        BD_CLIP_HANDLE *h = &bd->clip_handles[ii];
+        if (h->fp && h->clip == st->clip && !strcmp(h->name, st->clip->name)) {
+            BD_FILE_H *fp = h->fp;
+
+            BD_DEBUG(DBG_BLURAY, "Re-using opened clip %s\n", h->name);
+            *clip_size      = h->clip_size;
+            st->m2ts_filter = h->m2ts_filter;
+            h->fp           = NULL;
+            h->m2ts_filter  = NULL;
+            _close_clip_handle(h);
+            return fp;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * optical drive read speed
+ */
+
+static void _open_drive(BLURAY *bd)
+{
+    if (!bd->drive && bd->drive_speed && bd->drive_path) {
+        bd->drive = drive_open(bd->drive_path);
+        if (!bd->drive) {
+            /* not an optical drive, do not retry */
+            X_FREE(bd->drive_path);
+        }
+    }
+}
+
+/* read speed for clip: recording rate + headroom, at least 1x */
+static uint32_t _drive_clip_speed(BLURAY *bd, NAV_CLIP *clip)
+{
+    uint64_t rate;
+
+    if (bd->drive_speed != DRIVE_SPEED_AUTO) {
+        return bd->drive_speed;
+    }
+    if (!clip || !clip->cl || !clip->cl->clip.ts_recording_rate) {
+        return 0;
+    }
+
+    /* recording rate is TS rate (bytes/s), add source packet headers */
+    rate = (uint64_t)clip->cl->clip.ts_recording_rate * 192 / 188;
+    rate = rate * (100 + DRIVE_SPEED_HEADROOM) / 100 / 1024;
+
+    return (uint32_t)BD_MAX(rate, DRIVE_SPEED_1X_BD);
+}
+
+static void _update_drive_speed(BLURAY *bd)
+{
+    if (bd->drive) {
+        drive_set_speed(bd->drive, _drive_clip_speed(bd, bd->st0.clip));
+    }
+}
+
+/*
+ * open clip file. Main path stream is wrapped in read-ahead layer.
+ */
+static BD_FILE_H *_open_clip_file(BLURAY *bd, const char *name, uint32_t start_pkt, BD_STREAM_STATS *stats,
+                                  int main_path, int64_t *clip_size)
+{
+    BD_FILE_H *fp = disc_open_stream(bd->disc, name, &stats->dec);
+    unsigned   read_ahead_units;
+
+    *clip_size = 0;
+
+    if (fp) {
+        *clip_size = file_size(fp);
+
+        read_ahead_units = bd->read_ahead_units;
+        if (!read_ahead_units && bd->drive) {
+            /* slowed-down drive: keep buffer to cover spin-up and seeks */
+            read_ahead_units = bd->low_memory ? LOW_MEM_READ_AHEAD_UNITS : DRIVE_READ_AHEAD_UNITS;
+        }
+
+        if (*clip_size > 0 && main_path && read_ahead_units) {
+            /* start read-ahead from clip start */
+            if (file_seek(fp, ((uint64_t)start_pkt * 192 / 6144) * 6144, SEEK_SET) < 0) {
+                BD_DEBUG(DBG_BLURAY, "Unable to seek clip %s\n", name);
+            }
+            fp = read_ahead_open(fp, read_ahead_units);
+        }
+    }
+
+    return fp;
+}
+
+/*
+ * Open next clip (or next angle of current clip) of main path before playback reaches it.
+ * Clip switch at clip boundary does not need to wait for file open and decoder setup.
+ */
+static void _preopen_clip(BLURAY *bd, NAV_CLIP *next, const char *name, uint32_t start_pkt)
+{
+    BD_PREOPEN *p = &bd->st_next;
+
+    if (p->clip == next && !strcmp(p->name, name)) {
+        return;
+    }
+
+    _close_preopen(p);
+
+    p->fp = _open_clip_file(bd, name, start_pkt, &bd->stats_main, 1, &p->clip_size);
+    if (p->fp) {
+        p->clip = next;
+        strcpy(p->name, name);
+        BD_DEBUG(DBG_BLURAY, "Pre-opened clip %s\n", name);
+    }
+}
+
+static void _preopen_next_clip(BLURAY *bd, NAV_CLIP *next)
+{
+    _preopen_clip(bd, next, next->name, next->start_pkt);
+}
+
+/*
+ * Timestamp filter needs to inspect units only near clip IN and OUT time.
+ * OUT checking starts this much (45 kHz ticks) before out_time, from the
+ * preceding EP map entry (audio is multiplexed ahead of video).
+ */
+#define FILTER_OUT_MARGIN  (5 * 45000)
+
+static void _set_filter_out_pos(BD_STREAM *st)
+{
+    uint32_t spn, title_pkt;
+
+    if (!st->clip->cl || st->clip->out_time <= st->clip->in_time + FILTER_OUT_MARGIN) {
+        return;
+    }
+
+    nav_clip_time_search(st->clip, st->clip->out_time - FILTER_OUT_MARGIN, &spn, &title_pkt);
+    m2ts_filter_set_out_pos(st->m2ts_filter, (uint64_t)spn * 192);
+}
+
 static int _open_m2ts(BLURAY *bd, BD_STREAM *st)
 {
+    int64_t clip_size = 0;
+
     _close_m2ts(st);
 
-    st->fp = disc_open_stream(bd->disc, st->clip->name);
+    st->time_ref_valid = 0;
+
+    nav_clip_load(st->clip);
+
+    if (st == &bd->st0 && bd->st_next.fp &&
+        bd->st_next.clip == st->clip && !strcmp(bd->st_next.name, st->clip->name)) {
+        /* use pre-opened clip */
+        st->fp    = bd->st_next.fp;
+        clip_size = bd->st_next.clip_size;
+        bd->st_next.fp = NULL;
+        _close_preopen(&bd->st_next);
+    } else {
+        if (st == &bd->st0) {
+            /* re-use clip left by earlier seek */
+            st->fp = _unpark_m2ts(bd, st, &clip_size);
+        }
+        if (!st->fp) {
+            st->fp = _open_clip_file(bd, st->clip->name, st->clip->start_pkt, st->stats, st == &bd->st0, &clip_size);
+        }
+    }
 
     st->clip_size = 0;
     st->clip_pos = (uint64_t)st->clip->start_pkt * 192;
     st->clip_block_pos = (st->clip_pos / 6144) * 6144;
+    st->prefetch_pos = 0;
+    st->rd_err.active = 0;
 
     if (st->fp) {
-        int64_t clip_size = file_size(st->fp);
         if (clip_size > 0) {
 
-            if (file_seek(st->fp, st->clip_block_pos, SEEK_SET) < 0) {
-                BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to seek clip %s!\n", st->clip->name);
-                _close_m2ts(st);
-                return 0;
-            }
+            /* no seek here: units are read with positional reads */
 
             st->clip_size   = clip_size;
             st->int_buf_off = 6144;
+            st->stats->s.clip_opens++;
+            BD_TRACE(st->stats->dec.trace, BD_TRACE_CLIP_OPEN, (uint64_t)clip_size, st->clip->clip_id);
 
             if (st == &bd->st0) {
                 MPLS_PL *pl = st->clip->title->pl;
@@ -561,13 +1309,20 @@ static int _open_m2ts(BLURAY *bd, BD_STREAM *st)
                 st->uo_mask = bd_uo_mask_combine(pl->app_info.uo_mask,
                                                  pl->play_item[st->clip->ref].uo_mask);
 
-                st->m2ts_filter = m2ts_filter_init((int64_t)st->clip->in_time << 1,
-                                                   (int64_t)st->clip->out_time << 1,
-                                                   stn->num_video, stn->num_audio,
-                                                   stn->num_ig, stn->num_pg);
+                if (!st->m2ts_filter) {
+                    st->m2ts_filter = m2ts_filter_init((int64_t)st->clip->in_time << 1,
+                                                       (int64_t)st->clip->out_time << 1,
+                                                       stn->num_video, stn->num_audio,
+                                                       stn->num_ig, stn->num_pg);
+                    if (st->m2ts_filter) {
+                        _set_filter_out_pos(st);
+                    }
+                }
 
                 _update_clip_psrs(bd, st->clip);
 
+                _update_drive_speed(bd);
+
                 _init_pg_stream(bd);
 
                 _init_textst_timer(bd);
@@ -585,20 +1340,233 @@ static int _open_m2ts(BLURAY *bd, BD_STREAM *st)
     return 0;
 }
 
-static int _read_block(BLURAY *bd, BD_STREAM *st, uint8_t *buf)
+/*
+ * Fill read-ahead buffer with up to STREAM_READ_UNITS aligned units.
+ * Buffered data starts at st->clip_block_pos.
+ * Return number of buffered bytes (0 on error).
+ */
+static size_t _fill_read_buffer(BD_STREAM *st)
+{
+    const size_t len = 6144;
+    size_t       req_len, read_len;
+    uint64_t     t0;
+    int64_t      got;
+
+    _reset_read_buffer(st);
+
+    if (st->rd_buf_shared) {
+        /* application still holds reference to the old buffer */
+        bd_refcnt_dec(st->rd_buf);
+        st->rd_buf = NULL;
+        st->rd_buf_shared = 0;
+    }
+
+    if (!st->rd_buf) {
+        st->rd_buf = refcnt_realloc(NULL, STREAM_READ_UNITS * len, NULL);
+        if (!st->rd_buf) {
+            BD_DEBUG(DBG_STREAM | DBG_CRIT, "out of memory\n");
+            return 0;
+        }
+    }
+
+    /* do not read past end of file */
+    req_len = (size_t)BD_MIN((uint64_t)(STREAM_READ_UNITS * len), st->clip_size - st->clip_block_pos);
+    req_len -= req_len % len;
+
+    /* trick-play: read only units of current I-frame */
+    if (st->rd_limit > st->clip_block_pos) {
+        req_len = (size_t)BD_MIN((uint64_t)req_len, (st->rd_limit - st->clip_block_pos + len - 1) / len * len);
+    }
+
+    if (st->cache) {
+        /* use cached units until first miss */
+        for (read_len = 0; read_len < req_len; read_len += len) {
+            if (!unit_cache_lookup(st->cache, st->clip->clip_id, st->clip_block_pos + read_len,
+                                   st->rd_buf + read_len)) {
+                break;
+            }
+        }
+        if (read_len > 0) {
+            st->rd_buf_len = read_len;
+            return read_len;
+        }
+    }
+
+    t0  = bd_get_time_us();
+    got = file_read_at(st->fp, st->clip_block_pos, st->rd_buf, req_len);
+    st->stats->s.read_time += bd_get_time_us() - t0;
+    st->stats->s.read_calls++;
+
+    read_len = got > 0 ? (size_t)got : 0;
+    st->stats->s.bytes_read += read_len;
+    BD_TRACE(st->stats->dec.trace, BD_TRACE_FILE_READ, st->clip_block_pos, (uint32_t)read_len);
+    if (read_len != req_len) {
+        st->stats->s.read_errors++;
+        BD_DEBUG(DBG_STREAM | DBG_CRIT, "Read %d bytes at %"PRIu64" ; requested %d !\n",
+                 (int)read_len, st->clip_block_pos, (int)req_len);
+        /* drop incomplete unit */
+        read_len -= read_len % len;
+    }
+
+    if (st->cache) {
+        /* cache units before m2ts filter modifies them */
+        size_t off;
+        for (off = 0; off < read_len; off += len) {
+            unit_cache_insert(st->cache, st->clip->clip_id, st->clip_block_pos + off, st->rd_buf + off);
+        }
+    }
+
+    st->rd_buf_len = read_len;
+
+    return read_len;
+}
+
+/*
+ * Parsed packet headers of last read unit.
+ * Unit is scanned only once, and only when some consumer needs it.
+ */
+static M2TS_UNIT_INFO *_unit_info(BD_STREAM *st, const uint8_t *unit)
+{
+    if (!st->unit_info_valid) {
+        m2ts_scan_unit(unit, &st->unit_info);
+        st->unit_info_valid = 1;
+    }
+    return &st->unit_info;
+}
+
+/*
+ * damaged area recovery
+ *
+ * Skip distance after a read error grows exponentially until a readable
+ * unit is found. Forward probes are moved to next EP map entry.
+ * The gap between last unreadable and first readable unit is then
+ * bisected to find start of readable data. Bisecting is stopped when
+ * the time budget is used up.
+ */
+
+#define READ_ERROR_MAX_SKIP  4096  /* units (24 MB) */
+
+static void _skip_to(BD_STREAM *st, uint64_t pos)
+{
+    _reset_read_buffer(st);
+    st->clip_pos += pos - st->clip_block_pos;
+    st->clip_block_pos = pos;
+    st->rd_err.next_pos = pos;
+}
+
+static uint64_t _next_ep_unit(BD_STREAM *st, uint64_t pos)
+{
+    uint32_t spn, time;
+    uint64_t ep_pos;
+
+    if (!st->clip->cl) {
+        return pos;
+    }
+
+    spn    = clpi_access_point(st->clip->cl, SPN(pos), /*next=*/1, /*angle_change=*/0, &time);
+    ep_pos = ((uint64_t)spn * 192 / 6144) * 6144;
+
+    return BD_MAX(pos, ep_pos);
+}
+
+static int _read_error_budget_used(BLURAY *bd, BD_READ_ERROR *e)
+{
+    return bd_get_time_us() - e->start_us > (uint64_t)bd->read_error_budget_ms * 1000;
+}
+
+/* read error at current position */
+static void _read_error_skip(BLURAY *bd, BD_STREAM *st)
+{
+    const size_t   len = 6144;
+    BD_READ_ERROR *e   = &st->rd_err;
+    uint64_t       pos = st->clip_block_pos;
+    uint64_t       next;
+
+    if (!e->active || e->next_pos != pos) {
+        /* new damaged area */
+        memset(e, 0, sizeof(*e));
+        e->active   = 1;
+        e->start_us = bd_get_time_us();
+    }
+
+    e->bad_end = pos + len;
+
+    if (e->good_pos) {
+        /* bisecting */
+        uint64_t gap = (e->good_pos - e->bad_end) / len;
+        if (!gap || _read_error_budget_used(bd, e)) {
+            next = e->good_pos;
+        } else {
+            next = e->bad_end + gap / 2 * len;
+        }
+    } else {
+        e->skip = e->skip ? BD_MIN(e->skip * 2, READ_ERROR_MAX_SKIP) : 1;
+        next = pos + e->skip * len;
+        if (e->skip > 1) {
+            next = _next_ep_unit(st, next);
+        }
+    }
+
+    next = BD_MIN(next, st->clip_size / len * len);
+
+    BD_DEBUG(DBG_STREAM, "damaged area: skipping to %"PRIu64" (%"PRIu64" units)\n",
+             next, (next - pos) / len);
+
+    _skip_to(st, next);
+}
+
+/* unit at current position was read. Returns 0 if position was moved to search start of readable data. */
+static int _read_error_recovered(BLURAY *bd, BD_STREAM *st)
+{
+    const size_t   len = 6144;
+    BD_READ_ERROR *e   = &st->rd_err;
+    uint64_t       pos = st->clip_block_pos;
+    uint64_t       gap;
+
+    if (e->next_pos != pos || pos < e->bad_end) {
+        /* seek or clip change */
+        e->active = 0;
+        return 1;
+    }
+
+    gap = (pos - e->bad_end) / len;
+    if (!gap || _read_error_budget_used(bd, e)) {
+        BD_DEBUG(DBG_STREAM, "damaged area: reading continues at %"PRIu64" after %"PRIu64" ms\n",
+                 pos, (bd_get_time_us() - e->start_us) / 1000);
+        e->active = 0;
+        return 1;
+    }
+
+    e->good_pos = pos;
+    _skip_to(st, e->bad_end + gap / 2 * len);
+
+    return 0;
+}
+
+/*
+ * Read next aligned unit.
+ * Unit is checked and filtered in the stream read buffer, *unit is set to point there.
+ */
+static int _read_unit(BLURAY *bd, BD_STREAM *st, uint8_t **unit)
 {
     const size_t len = 6144;
 
     if (st->fp) {
-        BD_DEBUG(DBG_STREAM, "Reading unit at %"PRIu64"...\n", st->clip_block_pos);
+        BD_TRACE(st->stats->dec.trace, BD_TRACE_UNIT, st->clip_block_pos, st->clip->clip_id);
 
         if (len + st->clip_block_pos <= st->clip_size) {
-            size_t read_len;
 
-            if ((read_len = file_read(st->fp, buf, len))) {
-                if (read_len != len) {
-                    BD_DEBUG(DBG_STREAM | DBG_CRIT, "Read %d bytes at %"PRIu64" ; requested %d !\n", (int)read_len, st->clip_block_pos, (int)len);
+            if (st->rd_buf_off < st->rd_buf_len || _fill_read_buffer(st)) {
+                uint8_t *buf = st->rd_buf + st->rd_buf_off;
+
+                if (st->rd_err.active && !_read_error_recovered(bd, st)) {
+                    /* probe next position in damaged area */
+                    return _read_unit(bd, st, unit);
                 }
+
+                *unit = buf;
+                st->unit_info_valid = 0;
+                st->rd_buf_off += len;
                 st->clip_block_pos += len;
 
                 /* Check TP_extra_header Copy_permission_indicator. If != 0, unit is still encrypted. */
@@ -607,21 +1575,23 @@ static int _read_block(BLURAY *bd, BD_STREAM *st, uint8_t *buf)
                     if (buf[4] == 0x47 && (buf[4+192] != 0x47 || buf[4+2*192] != 0x47)) {
                         BD_DEBUG(DBG_BLURAY | DBG_CRIT,
                                  "TP header copy permission indicator != 0, unit is still encrypted?\n");
-                        _queue_event(bd, BD_EVENT_ENCRYPTED, BD_ERROR_AACS);
+                        if (!st->background) {
+                            _queue_event(bd, BD_EVENT_ENCRYPTED, BD_ERROR_AACS);
+                        }
                         return -1;
                     }
                 }
 
-                if (st->m2ts_filter) {
-                    int result = m2ts_filter(st->m2ts_filter, buf);
+                if (st->m2ts_filter && !m2ts_filter_idle(st->m2ts_filter, st->clip_block_pos - len)) {
+                    uint64_t t0 = bd_get_time_us();
+                    int result = m2ts_filter(st->m2ts_filter, buf, _unit_info(st, buf));
+                    st->stats->s.filter_time += bd_get_time_us() - t0;
                     if (result < 0) {
                         m2ts_filter_close(&st->m2ts_filter);
                         BD_DEBUG(DBG_BLURAY | DBG_CRIT, "m2ts filter error\n");
                     }
                 }
 
-                BD_DEBUG(DBG_STREAM, "Read unit OK!\n");
-
 #ifdef BLURAY_READ_ERROR_TEST
                 /* simulate broken blocks */
                 if (random() % 1000)
@@ -631,18 +1601,20 @@ static int _read_block(BLURAY *bd, BD_STREAM *st, uint8_t *buf)
             }
 
             BD_DEBUG(DBG_STREAM | DBG_CRIT, "Read unit at %"PRIu64" failed !\n", st->clip_block_pos);
+            BD_TRACE(st->stats->dec.trace, BD_TRACE_READ_ERROR, st->clip_block_pos, st->clip->clip_id);
 
             _queue_event(bd, BD_EVENT_READ_ERROR, 0);
 
+            if (bd->read_error_budget_ms) {
+                _read_error_skip(bd, st);
+                return 0;
+            }
+
             /* skip broken unit */
+            _reset_read_buffer(st);
             st->clip_block_pos += len;
             st->clip_pos += len;
 
-            if (file_seek(st->fp, st->clip_block_pos, SEEK_SET) < 0) {
-                BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to seek clip %s!\n", st->clip->name);
-                return -1;
-            }
-
             return 0;
         }
 
@@ -668,1904 +1640,4945 @@ static int _read_block(BLURAY *bd, BD_STREAM *st, uint8_t *buf)
  * clip preload (BD_PRELOAD)
  */
 
+static void _stop_preload_thread(BD_PRELOAD *p)
+{
+    if (p->loading) {
+        bd_atomic_store(&p->cancel, 1);
+        bd_thread_join(&p->thread);
+        p->loading = 0;
+    }
+}
+
 static void _close_preload(BD_PRELOAD *p)
 {
-    X_FREE(p->buf);
+    _stop_preload_thread(p);
     memset(p, 0, sizeof(*p));
 }
 
-#define PRELOAD_SIZE_LIMIT  (512*1024*1024)  /* do not preload clips larger than 512M */
+/*
+ * Preloaded sub path data cache.
+ * Units read from sub path clip are stored in disc object cache, keyed by
+ * clip name. The cache is shared by all handles of the disc (when disc cache
+ * is shared), so reloading the same sub path after playlist change or title
+ * restart, or from another handle, is served from memory.
+ */
+
+#define PRELOAD_CACHE_MAX_SIZE  (8*1024*1024)  /* larger clips are not cached */
 
-static int _preload_m2ts(BLURAY *bd, BD_PRELOAD *p)
+typedef struct {
+    uint64_t clip_size;
+    uint64_t len;        /* cached bytes from clip start (whole units) */
+    uint8_t  complete;   /* whole clip is cached */
+    /* followed by clip data */
+} BD_PRELOAD_DATA;
+
+#define PRELOAD_DATA(d)        ((uint8_t *)(d) + sizeof(BD_PRELOAD_DATA))
+#define PRELOAD_DATA_CONST(d)  ((const uint8_t *)(d) + sizeof(BD_PRELOAD_DATA))
+
+static BD_PRELOAD_DATA *_preload_data_alloc(BLURAY *bd, uint64_t clip_size)
 {
-    /* setup and open BD_STREAM */
+    BD_PRELOAD_DATA *d;
 
-    BD_STREAM st;
+    if (bd->low_memory || clip_size > PRELOAD_CACHE_MAX_SIZE) {
+        return NULL;
+    }
 
-    memset(&st, 0, sizeof(st));
-    st.clip = p->clip;
+    d = refcnt_realloc(NULL, sizeof(*d) + (size_t)clip_size, NULL);
+    if (d) {
+        d->clip_size = clip_size;
+        d->len       = 0;
+        d->complete  = 0;
+    }
+    return d;
+}
 
-    if (st.clip_size > PRELOAD_SIZE_LIMIT) {
-        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "_preload_m2ts(): too large clip (%"PRId64")\n", st.clip_size);
-        return 0;
+static void _preload_data_put(BLURAY *bd, const char *name, BD_PRELOAD_DATA *d)
+{
+    BD_PRELOAD_DATA *shrunk;
+
+    d->complete = (d->len + 6144 > d->clip_size);
+
+    /* release unused space (stopped at first complete display set) */
+    shrunk = refcnt_realloc(d, sizeof(*d) + (size_t)d->len, NULL);
+    if (shrunk) {
+        d = shrunk;
+    }
+
+    disc_cache_put(bd->disc, name, d, sizeof(*d) + (size_t)d->len);
+    bd_refcnt_dec(d);
+}
+
+/* feed cached units to graphics controller. Returns >0 when loading is complete. */
+static int _preload_cached(BLURAY *bd, BD_PRELOAD *p, const BD_PRELOAD_DATA *d,
+                           uint16_t pid, int stop_on_complete, BD_STREAM_STATS *stats)
+{
+    uint8_t        unit[6144];
+    M2TS_UNIT_INFO info;
+    uint64_t       pos, t0;
+    int            complete;
+
+    for (pos = 0; pos + 6144 <= d->len; pos += 6144) {
+        /* cached data is shared, decode from a copy */
+        memcpy(unit, PRELOAD_DATA_CONST(d) + pos, 6144);
+        m2ts_scan_unit(unit, &info);
+
+        t0 = bd_get_time_us();
+        complete = gc_decode_ts(bd->graphics_controller, pid, unit, &info, 1, -1) > 0;
+        stats->s.decode_time += bd_get_time_us() - t0;
+
+        if (complete && stop_on_complete) {
+            break;
+        }
+    }
+
+    BD_DEBUG(DBG_BLURAY, "_preload_m2ts(): decoded %"PRIu64" cached bytes from %s\n", pos, p->clip->name);
+
+    p->clip_size = d->clip_size;
+
+    return pos < d->len || d->complete;
+}
+
+/*
+ * Stream sub path clip to graphics controller.
+ * Clip is decoded unit by unit from the stream read buffer, so memory
+ * usage does not depend on clip size.
+ * If stop_on_complete is set, reading stops at first complete display set.
+ * When running in preload thread (background), events are not queued and
+ * loading stops when p->cancel is set.
+ */
+
+static int _preload_m2ts(BLURAY *bd, BD_PRELOAD *p, uint16_t pid, int stop_on_complete, int background)
+{
+    BD_STREAM        st;
+    BD_STREAM_STATS *stats = (p == &bd->st_textst) ? &bd->stats_textst : &bd->stats_preload;
+    BD_PRELOAD_DATA *cached, *d = NULL;
+    uint64_t         start = 0;
+
+    /* try cache */
+
+    cached = disc_cache_get(bd->disc, p->clip->name);
+    if (cached) {
+        int done = _preload_cached(bd, p, cached, pid, stop_on_complete, stats);
+        start = cached->len;
+        bd_refcnt_dec(cached);
+        if (done) {
+            return 1;
+        }
+        /* cached data ends before clip end, continue from disc */
     }
 
+    /* setup and open BD_STREAM */
+
+    memset(&st, 0, sizeof(st));
+    st.clip  = p->clip;
+    st.stats = stats;
+    st.background = background;
+
     if (!_open_m2ts(bd, &st)) {
         return 0;
     }
 
-    /* allocate buffer */
-    p->clip_size = (size_t)st.clip_size;
-    p->buf       = realloc(p->buf, p->clip_size);
+    p->clip_size = st.clip_size;
+
+    if (start) {
+        _skip_to(&st, start);
+    } else {
+        d = _preload_data_alloc(bd, st.clip_size);
+    }
 
-    /* read clip to buffer */
+    /* feed clip to graphics controller */
 
-    uint8_t *buf = p->buf;
-    uint8_t *end = p->buf + p->clip_size;
+    while (st.clip_block_pos + 6144 <= st.clip_size) {
+        uint8_t *unit;
+        uint64_t t0;
+        int      complete;
 
-    for (; buf < end; buf += 6144) {
-        if (_read_block(bd, &st, buf) <= 0) {
+        if (_read_unit(bd, &st, &unit) <= 0) {
             BD_DEBUG(DBG_BLURAY|DBG_CRIT, "_preload_m2ts(): error loading %s at %"PRIu64"\n",
-                  st.clip->name, (uint64_t)(buf - p->buf));
+                  st.clip->name, st.clip_block_pos);
+            bd_refcnt_dec(d);
+            _close_m2ts(&st);
+            return 0;
+        }
+
+        if (d) {
+            memcpy(PRELOAD_DATA(d) + d->len, unit, 6144);
+            d->len += 6144;
+        }
+
+        t0 = bd_get_time_us();
+        complete = gc_decode_ts(bd->graphics_controller, pid, unit, _unit_info(&st, unit), 1, -1) > 0;
+        st.stats->s.decode_time += bd_get_time_us() - t0;
+
+        if (complete && stop_on_complete) {
+            break;
+        }
+
+        if (background && bd_atomic_load(&p->cancel)) {
+            BD_DEBUG(DBG_BLURAY, "_preload_m2ts(): loading of %s cancelled\n", st.clip->name);
+            bd_refcnt_dec(d);
             _close_m2ts(&st);
-            _close_preload(p);
             return 0;
         }
     }
 
     /* */
 
-    BD_DEBUG(DBG_BLURAY, "_preload_m2ts(): loaded %"PRIu64" bytes from %s\n",
-          st.clip_size, st.clip->name);
+    BD_DEBUG(DBG_BLURAY, "_preload_m2ts(): decoded %"PRIu64" bytes from %s\n",
+          st.clip_block_pos, st.clip->name);
+
+    if (d) {
+        _preload_data_put(bd, st.clip->name, d);
+    }
 
     _close_m2ts(&st);
 
     return 1;
 }
 
-static int64_t _seek_stream(BLURAY *bd, BD_STREAM *st,
-                            NAV_CLIP *clip, uint32_t clip_pkt)
+/*
+ * Background sub path loading (BLURAY_PLAYER_SETTING_ASYNC_PRELOAD).
+ * Clip is decoded in separate thread while main path is played.
+ * Completion is handled in _check_preload() from bd_read*() (under bd->mutex).
+ */
+
+static void *_preload_thread(void *arg)
 {
-    if (!clip)
-        return -1;
+    BD_PRELOAD *p = (BD_PRELOAD *)arg;
+    int ok = _preload_m2ts(p->bd, p, p->pid, p->stop_on_complete, 1);
 
-    if (!st->fp || !st->clip || clip->ref != st->clip->ref) {
-        // The position is in a new clip
-        st->clip = clip;
-        if (!_open_m2ts(bd, st)) {
-            return -1;
-        }
-    }
+    bd_atomic_store(&p->done, ok ? PRELOAD_DONE : PRELOAD_FAILED);
 
-    if (st->m2ts_filter) {
-        m2ts_filter_seek(st->m2ts_filter, 0, (int64_t)st->clip->in_time << 1);
+    return NULL;
+}
+
+static int _start_preload(BLURAY *bd, BD_PRELOAD *p, uint16_t pid, int stop_on_complete)
+{
+    _stop_preload_thread(p);
+
+    p->bd               = bd;
+    p->pid              = pid;
+    p->stop_on_complete = stop_on_complete;
+    bd_atomic_store(&p->cancel, 0);
+    bd_atomic_store(&p->done, 0);
+
+    if (bd_thread_create(&p->thread, "bd_preload", _preload_thread, p) < 0) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "failed to start sub path preload thread\n");
+        return 0;
     }
+    p->loading = 1;
 
-    st->clip_pos = (uint64_t)clip_pkt * 192;
-    st->clip_block_pos = (st->clip_pos / 6144) * 6144;
+    return 1;
+}
+
+/* join finished preload thread. Returns 0 if still loading, PRELOAD_DONE or PRELOAD_FAILED. */
+static uint32_t _join_preload(BD_PRELOAD *p)
+{
+    uint32_t done;
 
-    if (file_seek(st->fp, st->clip_block_pos, SEEK_SET) < 0) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to seek clip %s!\n", st->clip->name);
+    if (!p->loading) {
+        return 0;
     }
 
-    st->int_buf_off = 6144;
+    done = bd_atomic_load(&p->done);
+    if (done) {
+        bd_thread_join(&p->thread);
+        p->loading = 0;
+    }
 
-    return st->clip_pos;
+    return done;
 }
 
 /*
- * Graphics controller interface
+ * Speculative playlist prefetch (BLURAY_PLAYER_SETTING_PLAYLIST_PREFETCH)
+ *
+ * When HDMV menu is opened, playlists that menu buttons can start (directly
+ * or through movie object of a title) are parsed into disc cache and start
+ * of the first clip is prefetched in background thread.
+ * When selected button changes, its targets replace pending work: the
+ * likely next playlist is loaded while user is still on the button.
  */
 
-static int _run_gc(BLURAY *bd, gc_ctrl_e msg, uint32_t param)
+#define PL_PREFETCH_CLIPS        4            /* clip info files loaded per playlist */
+#define PL_PREFETCH_STREAM_SIZE  (1024*1024)  /* stream data hint at playlist start */
+
+static void _prefetch_playlist(BD_DISC *disc, uint32_t playlist, BD_ATOMIC_UINT *cancel)
 {
-    int result = -1;
+    char     file[11];
+    MPLS_PL *pl;
+    unsigned ii;
 
-    if (!bd) {
-        return -1;
+    snprintf(file, sizeof(file), "%05u.mpls", playlist);
+    pl = mpls_get(disc, file);
+    if (!pl) {
+        return;
     }
 
-    if (bd->graphics_controller && bd->hdmv_vm) {
-        GC_NAV_CMDS cmds = {-1, NULL, -1, 0, 0, EMPTY_UO_MASK};
+    for (ii = 0; ii < pl->list_count && ii < PL_PREFETCH_CLIPS && !bd_atomic_load(cancel); ii++) {
+        const MPLS_PI *pi = &pl->play_item[ii];
+        CLPI_CL *cl;
 
-        result = gc_run(bd->graphics_controller, msg, param, &cmds);
+        snprintf(file, sizeof(file), "%s.clpi", pi->clip[0].clip_id);
+        cl = clpi_get(disc, file);
 
-        if (cmds.num_nav_cmds > 0) {
-            hdmv_vm_set_object(bd->hdmv_vm, cmds.num_nav_cmds, cmds.nav_cmds);
-            bd->hdmv_suspended = !hdmv_vm_running(bd->hdmv_vm);
+        if (cl && ii == 0) {
+            uint32_t spn = clpi_lookup_spn(cl, pi->in_time, 1, pi->clip[0].stc_id);
+            snprintf(file, sizeof(file), "%s.m2ts", pi->clip[0].clip_id);
+            disc_prefetch_stream(disc, file, ((uint64_t)spn * 192 / 6144) * 6144, PL_PREFETCH_STREAM_SIZE);
         }
+        clpi_free(cl);
+    }
 
-        if (cmds.status != bd->gc_status) {
-            uint32_t changed_flags = cmds.status ^ bd->gc_status;
-            bd->gc_status = cmds.status;
-            if (changed_flags & GC_STATUS_MENU_OPEN) {
-                _queue_event(bd, BD_EVENT_MENU, !!(bd->gc_status & GC_STATUS_MENU_OPEN));
-            }
-            if (changed_flags & GC_STATUS_POPUP) {
-                _queue_event(bd, BD_EVENT_POPUP, !!(bd->gc_status & GC_STATUS_POPUP));
-            }
+    /* sub path clips are loaded when playlist is opened */
+    for (ii = 0; ii < pl->sub_count && !bd_atomic_load(cancel); ii++) {
+        const MPLS_SUB *sub = &pl->sub_path[ii];
+        if (sub->sub_playitem_count > 0) {
+            snprintf(file, sizeof(file), "%s.clpi", sub->sub_play_item[0].clip[0].clip_id);
+            clpi_free(clpi_get(disc, file));
         }
+    }
 
-        if (cmds.sound_id_ref >= 0 && cmds.sound_id_ref < 0xff) {
-            _queue_event(bd, BD_EVENT_SOUND_EFFECT, cmds.sound_id_ref);
-        }
+    mpls_free(pl);
+}
 
-    } else {
-        if (bd->gc_status & GC_STATUS_MENU_OPEN) {
-            _queue_event(bd, BD_EVENT_MENU, 0);
-        }
-        if (bd->gc_status & GC_STATUS_POPUP) {
-            _queue_event(bd, BD_EVENT_POPUP, 0);
+static void *_pl_prefetch_thread(void *arg)
+{
+    BLURAY  *bd = (BLURAY *)arg;
+    uint64_t t0 = bd_get_time_us();
+    unsigned count = 0;
+    uint32_t playlist;
+
+    while (1) {
+        /* list may be replaced while running */
+        bd_mutex_lock(&bd->pl_prefetch_mutex);
+        if (bd_atomic_load(&bd->pl_prefetch_cancel) || bd->pl_prefetch_next >= bd->pl_prefetch_count) {
+            bd->pl_prefetch_done = 1;
+            bd_mutex_unlock(&bd->pl_prefetch_mutex);
+            break;
         }
-        bd->gc_status = GC_STATUS_NONE;
+        playlist = bd->pl_prefetch_list[bd->pl_prefetch_next++];
+        bd_mutex_unlock(&bd->pl_prefetch_mutex);
+
+        _prefetch_playlist(bd->disc, playlist, &bd->pl_prefetch_cancel);
+        count++;
     }
 
-    return result;
-}
+    BD_DEBUG(DBG_BLURAY, "playlist prefetch: %u playlists in %"PRIu64" us\n",
+             count, bd_get_time_us() - t0);
 
-/*
- * meta open
- */
+    return NULL;
+}
 
-static int _meta_open(BLURAY *bd)
+static void _stop_pl_prefetch(BLURAY *bd)
 {
-    if (!bd->meta) {
-        bd->meta = meta_parse(bd->disc);
+    if (bd->pl_prefetch_running) {
+        bd_atomic_store(&bd->pl_prefetch_cancel, 1);
+        bd_thread_join(&bd->pl_prefetch_thread);
+        bd->pl_prefetch_running = 0;
     }
-
-    return !!bd->meta;
+    bd->pl_prefetch_count = 0;
+    bd->pl_prefetch_next  = 0;
 }
 
-/*
- * disc info
- */
-
-const BLURAY_DISC_INFO *bd_get_disc_info(BLURAY *bd)
+static int _find_playlist(const uint32_t *list, unsigned count, uint32_t playlist)
 {
-    return &bd->disc_info;
+    unsigned ii;
+    for (ii = 0; ii < count; ii++) {
+        if (list[ii] == playlist) {
+            return 1;
+        }
+    }
+    return 0;
 }
 
-static void _fill_disc_info(BLURAY *bd, BD_ENC_INFO *enc_info)
+/* keep_pending: continue with not yet started playlists of current list after these */
+static void _start_pl_prefetch(BLURAY *bd, const uint32_t *playlists, unsigned count, int keep_pending)
 {
-    bd->disc_info.aacs_detected      = enc_info->aacs_detected;
-    bd->disc_info.libaacs_detected   = enc_info->libaacs_detected;
-    bd->disc_info.aacs_error_code    = enc_info->aacs_error_code;
-    bd->disc_info.aacs_handled       = enc_info->aacs_handled;
-    bd->disc_info.aacs_mkbv          = enc_info->aacs_mkbv;
-    memcpy(bd->disc_info.disc_id, enc_info->disc_id, 20);
-    bd->disc_info.bdplus_detected    = enc_info->bdplus_detected;
-    bd->disc_info.libbdplus_detected = enc_info->libbdplus_detected;
-    bd->disc_info.bdplus_handled     = enc_info->bdplus_handled;
-    bd->disc_info.bdplus_gen         = enc_info->bdplus_gen;
-    bd->disc_info.bdplus_date        = enc_info->bdplus_date;
-
-    bd->disc_info.udf_volume_id      = disc_volume_id(bd->disc);
-
-    bd->disc_info.bluray_detected        = 0;
-    bd->disc_info.top_menu_supported     = 0;
-    bd->disc_info.first_play_supported   = 0;
-    bd->disc_info.num_hdmv_titles        = 0;
-    bd->disc_info.num_bdj_titles         = 0;
-    bd->disc_info.num_unsupported_titles = 0;
-
-    bd->disc_info.bdj_detected    = 0;
-    bd->disc_info.bdj_supported   = 0;
-    bd->disc_info.libjvm_detected = 0;
-    bd->disc_info.bdj_handled     = 0;
-
-    bd->disc_info.num_titles  = 0;
-    bd->disc_info.titles      = NULL;
-    bd->disc_info.top_menu    = NULL;
-    bd->disc_info.first_play  = NULL;
-
-    array_free((void**)&bd->titles);
-
-    memset(bd->disc_info.bdj_org_id,  0, sizeof(bd->disc_info.bdj_org_id));
-    memset(bd->disc_info.bdj_disc_id, 0, sizeof(bd->disc_info.bdj_disc_id));
-
-    INDX_ROOT *index = indx_get(bd->disc);
-    if (index) {
-        INDX_PLAY_ITEM *pi;
-        unsigned        ii;
+    uint32_t list[HDMV_MAX_NAV_TARGETS];
+    unsigned ii, num = 0;
 
-        bd->disc_info.bluray_detected = 1;
+    bd_mutex_lock(&bd->pl_prefetch_mutex);
 
-        /* application info */
-        bd->disc_info.video_format     = index->app_info.video_format;
-        bd->disc_info.frame_rate       = index->app_info.frame_rate;
-        bd->disc_info.content_exist_3D = index->app_info.content_exist_flag;
-        bd->disc_info.initial_output_mode_preference = index->app_info.initial_output_mode_preference;
-        memcpy(bd->disc_info.provider_data, index->app_info.user_data, sizeof(bd->disc_info.provider_data));
+    /* skip targets that are already loaded or being loaded */
+    for (ii = 0; ii < count; ii++) {
+        if (!_find_playlist(bd->pl_prefetch_list, bd->pl_prefetch_next, playlists[ii])) {
+            break;
+        }
+    }
+    if (ii >= count) {
+        bd_mutex_unlock(&bd->pl_prefetch_mutex);
+        return;
+    }
 
-        /* allocate array for title info */
-        BLURAY_TITLE **titles = (BLURAY_TITLE**)array_alloc(index->num_titles + 2, sizeof(BLURAY_TITLE));
-        if (!titles) {
-            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Can't allocate memory\n");
-            return;
+    for (ii = 0; ii < count && num < HDMV_MAX_NAV_TARGETS; ii++) {
+        list[num++] = playlists[ii];
+    }
+    if (keep_pending) {
+        for (ii = bd->pl_prefetch_next; ii < bd->pl_prefetch_count && num < HDMV_MAX_NAV_TARGETS; ii++) {
+            if (!_find_playlist(list, num, bd->pl_prefetch_list[ii])) {
+                list[num++] = bd->pl_prefetch_list[ii];
+            }
         }
-        bd->titles = titles;
-        bd->disc_info.titles = (const BLURAY_TITLE * const *)titles;
-        bd->disc_info.num_titles = index->num_titles;
+    }
 
-        /* count titles and fill title info */
+    memcpy(bd->pl_prefetch_list, list, num * sizeof(uint32_t));
+    bd->pl_prefetch_count = num;
+    bd->pl_prefetch_next  = 0;
 
-        for (ii = 0; ii < index->num_titles; ii++) {
-            if (index->titles[ii].object_type == indx_object_type_hdmv) {
-                bd->disc_info.num_hdmv_titles++;
-                titles[ii + 1]->interactive = (index->titles[ii].hdmv.playback_type == indx_hdmv_playback_type_interactive);
-                titles[ii + 1]->id_ref = index->titles[ii].hdmv.id_ref;
-            }
-            if (index->titles[ii].object_type == indx_object_type_bdj) {
-                bd->disc_info.num_bdj_titles++;
-                bd->disc_info.bdj_detected = 1;
-                titles[ii + 1]->bdj = 1;
-                titles[ii + 1]->interactive = (index->titles[ii].bdj.playback_type == indx_bdj_playback_type_interactive);
-                titles[ii + 1]->id_ref = atoi(index->titles[ii].bdj.name);
-            }
+    /* thread is still running: it continues with new list */
+    if (bd->pl_prefetch_running && !bd->pl_prefetch_done) {
+        bd_mutex_unlock(&bd->pl_prefetch_mutex);
+        return;
+    }
 
-            titles[ii + 1]->accessible =  !(index->titles[ii].access_type & INDX_ACCESS_PROHIBITED_MASK);
-            titles[ii + 1]->hidden     = !!(index->titles[ii].access_type & INDX_ACCESS_HIDDEN_MASK);
-        }
+    bd_mutex_unlock(&bd->pl_prefetch_mutex);
 
-        pi = &index->first_play;
-        if (pi->object_type == indx_object_type_bdj) {
-            bd->disc_info.bdj_detected = 1;
-            titles[index->num_titles + 1]->bdj = 1;
-            titles[index->num_titles + 1]->interactive = (pi->bdj.playback_type == indx_bdj_playback_type_interactive);
-            titles[index->num_titles + 1]->id_ref = atoi(pi->bdj.name);
-        }
-        if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
-            titles[index->num_titles + 1]->interactive = (pi->hdmv.playback_type == indx_hdmv_playback_type_interactive);
-            titles[index->num_titles + 1]->id_ref = pi->hdmv.id_ref;
-        }
+    if (bd->pl_prefetch_running) {
+        /* already exited */
+        bd_thread_join(&bd->pl_prefetch_thread);
+        bd->pl_prefetch_running = 0;
+    }
 
-        pi = &index->top_menu;
-        if (pi->object_type == indx_object_type_bdj) {
-            bd->disc_info.bdj_detected = 1;
-            titles[0]->bdj = 1;
-            titles[0]->interactive = (pi->bdj.playback_type == indx_bdj_playback_type_interactive);
-            titles[0]->id_ref = atoi(pi->bdj.name);
-        }
-        if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
-            titles[0]->interactive = (pi->hdmv.playback_type == indx_hdmv_playback_type_interactive);
-            titles[0]->id_ref = pi->hdmv.id_ref;
-        }
+    bd->pl_prefetch_done = 0;
+    bd_atomic_store(&bd->pl_prefetch_cancel, 0);
 
-        /* check for BD-J capability */
+    if (bd_thread_create(&bd->pl_prefetch_thread, "bd_pl_prefetch", _pl_prefetch_thread, bd) < 0) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "failed to start playlist prefetch thread\n");
+        bd->pl_prefetch_count = 0;
+        return;
+    }
+    bd->pl_prefetch_running = 1;
+}
 
-#ifdef USING_BDJAVA
-        if (bd->disc_info.bdj_detected) {
-            bd->disc_info.bdj_supported = 1;
-            /* BD-J titles found. Check if jvm + jar can be loaded ? */
-            switch (bdj_jvm_available(&bd->bdjstorage)) {
-                case 2: bd->disc_info.bdj_handled     = 1;
-                case 1: bd->disc_info.libjvm_detected = 1;
-                default:;
-            }
-        }
-#endif /* USING_BDJAVA */
+static void _collect_nav_targets(void *handle, const struct mobj_cmd *cmds, unsigned num_cmds)
+{
+    hdmv_nav_targets(cmds, num_cmds, (HDMV_NAV_TARGETS *)handle);
+}
 
-        /* mark supported titles */
+/* buttons usually jump to a title: add playlists started by its movie object.
+ * Titles found there are appended to the list and followed too. */
+static void _resolve_title_targets(BLURAY *bd, HDMV_NAV_TARGETS *t)
+{
+    unsigned ii;
 
-        if (bd->disc_info.bdj_detected && !bd->disc_info.bdj_handled) {
-            bd->disc_info.num_unsupported_titles = bd->disc_info.num_bdj_titles;
+    for (ii = 0; ii < t->num_titles; ii++) {
+        uint32_t title = t->title[ii];
+        if (title >= 1 && title <= bd->disc_info.num_titles && !bd->disc_info.titles[title]->bdj) {
+            hdmv_vm_object_nav_targets(bd->hdmv_vm, bd->disc_info.titles[title]->id_ref, t);
         }
+    }
+}
 
-        pi = &index->first_play;
-        if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
-            bd->disc_info.first_play_supported = 1;
-        }
-        if (pi->object_type == indx_object_type_bdj) {
-            bd->disc_info.first_play_supported = bd->disc_info.bdj_handled;
-        }
+static void _prefetch_menu_playlists(BLURAY *bd)
+{
+    HDMV_NAV_TARGETS t;
 
-        pi = &index->top_menu;
-        if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
-            bd->disc_info.top_menu_supported = 1;
-        }
-        if (pi->object_type == indx_object_type_bdj) {
-            bd->disc_info.top_menu_supported = bd->disc_info.bdj_handled;
-        }
+    if (!bd->pl_prefetch || !bd->hdmv_vm || !bd->disc_info.titles) {
+        return;
+    }
 
-        /* */
+    memset(&t, 0, sizeof(t));
+    gc_scan_nav_cmds(bd->graphics_controller, _collect_nav_targets, &t);
+    _resolve_title_targets(bd, &t);
 
-        if (bd->disc_info.first_play_supported) {
-            titles[index->num_titles + 1]->accessible = 1;
-            bd->disc_info.first_play = titles[index->num_titles + 1];
-        }
-        if (bd->disc_info.top_menu_supported) {
-            titles[0]->accessible = 1;
-            bd->disc_info.top_menu = titles[0];
-        }
+    _start_pl_prefetch(bd, t.playlist, t.num_playlists, 0);
+}
 
-        /* populate title names */
-        bd_get_meta(bd);
+static void _prefetch_button_playlists(BLURAY *bd, const struct mobj_cmd *cmds, unsigned num_cmds)
+{
+    HDMV_NAV_TARGETS t;
 
-        indx_free(&index);
+    if (!bd->pl_prefetch || !bd->hdmv_vm || !bd->disc_info.titles) {
+        return;
     }
 
-    if (bd->disc_info.bdj_detected) {
-        BDID_DATA *bdid = bdid_get(bd->disc); /* parse id.bdmv */
-        if (bdid) {
-            memcpy(bd->disc_info.bdj_org_id,  bdid->org_id,  sizeof(bd->disc_info.bdj_org_id));
-            memcpy(bd->disc_info.bdj_disc_id, bdid->disc_id, sizeof(bd->disc_info.bdj_disc_id));
-            bdid_free(&bdid);
-        }
-    }
+    memset(&t, 0, sizeof(t));
+    hdmv_nav_targets(cmds, num_cmds, &t);
+    _resolve_title_targets(bd, &t);
+
+    /* selected button first, then rest of the menu */
+    _start_pl_prefetch(bd, t.playlist, t.num_playlists, 1);
 }
 
 /*
- * bdj
+ * PG preroll after seek
+ *
+ * Subtitle display set visible at seek point may use objects and palettes
+ * from epoch start before it. Decode bounded window of main path PG stream
+ * before seek point from separate handle, and render the result.
  */
 
-#ifdef USING_BDJAVA
-const uint8_t *bd_get_aacs_data(BLURAY *bd, int type)
-{
-    return disc_get_data(bd->disc, type);
-}
-#endif
+#define PG_PREROLL_MAX_MS    10000
+#define PG_PREROLL_MAX_SIZE  (16 * 1024 * 1024)
 
-#ifdef USING_BDJAVA
-void bd_set_bdj_uo_mask(BLURAY *bd, unsigned mask)
+static void _preroll_pg(BLURAY *bd, uint32_t clip_pkt)
 {
-    bd->bdj_uo_mask.title_search = !!(mask & BDJ_TITLE_SEARCH_MASK);
-    bd->bdj_uo_mask.menu_call    = !!(mask & BDJ_MENU_CALL_MASK);
-}
-#endif
+    NAV_CLIP  *clip   = bd->st0.clip;
+    uint16_t   pg_pid = bd->st0.pg_pid;
+    BD_STREAM  st;
+    uint32_t   time, start_pkt;
+    uint64_t   end_pos, t0;
+    int        complete = 0;
 
-#ifdef USING_BDJAVA
-uint64_t bd_get_uo_mask(BLURAY *bd)
-{
-    /* internal function. Used by BD-J. */
-    union {
-      uint64_t u64;
-      BD_UO_MASK mask;
-    } mask = {0};
+    if (!bd->pg_preroll_ms || !pg_pid || !bd->graphics_controller || !clip || !clip->cl) {
+        return;
+    }
 
-    //bd_mutex_lock(&bd->mutex);
-    memcpy(&mask.mask, &bd->st0.uo_mask, sizeof(BD_UO_MASK));
-    //bd_mutex_unlock(&bd->mutex);
+    /* preroll start: access point before seek point - window */
+    clpi_access_point(clip->cl, clip_pkt, 0, 0, &time);
+    time = time > bd->pg_preroll_ms * 45 ? time - bd->pg_preroll_ms * 45 : 0;
+    start_pkt = clpi_lookup_spn(clip->cl, time, /*before=*/1,
+                                bd->title->pl->play_item[clip->ref].clip[clip->angle].stc_id);
+    start_pkt = BD_MAX(start_pkt, clip->start_pkt);
+    if (start_pkt >= clip_pkt) {
+        return;
+    }
 
-    return mask.u64;
-}
-#endif
+    end_pos = ((uint64_t)clip_pkt * 192 / 6144) * 6144;
 
-#ifdef USING_BDJAVA
-void bd_select_rate(BLURAY *bd, float rate, int reason)
-{
-    if (reason == BDJ_PLAYBACK_STOP) {
-        /* playback stop. Might want to wait for buffers empty here. */
+    memset(&st, 0, sizeof(st));
+    st.clip  = clip;
+    st.stats = &bd->stats_preload;
+
+    if (!_open_m2ts(bd, &st)) {
         return;
     }
 
-    if (reason == BDJ_PLAYBACK_START) {
-        /* playback is triggered by bd_select_rate() */
-        bd->bdj_wait_start = 0;
+    st.clip_pos       = (uint64_t)start_pkt * 192;
+    st.clip_block_pos = (st.clip_pos / 6144) * 6144;
+    if (end_pos - st.clip_block_pos > PG_PREROLL_MAX_SIZE) {
+        st.clip_block_pos = end_pos - PG_PREROLL_MAX_SIZE;
     }
+    st.int_buf_off = 6144;
+    _reset_read_buffer(&st);
 
-    if (rate < 0.5) {
-        _queue_event(bd, BD_EVENT_STILL, 1);
-    } else {
-        _queue_event(bd, BD_EVENT_STILL, 0);
-    }
-}
-#endif
+    t0 = bd_get_time_us();
 
-#ifdef USING_BDJAVA
-int bd_set_virtual_package(BLURAY *bd, const char *vp_path, int psr_init_backup)
-{
-    bd_mutex_lock(&bd->mutex);
+    while (st.clip_block_pos < end_pos && st.clip_block_pos + 6144 <= st.clip_size) {
+        uint8_t *unit;
 
-    if (bd->title) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_set_virtual_package() failed: playlist is playing\n");
-        return -1;
-    }
-    if (bd->title_type != title_bdj) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_set_virtual_package() failed: HDMV title\n");
-        return -1;
-    }
+        if (_read_unit(bd, &st, &unit) <= 0) {
+            BD_DEBUG(DBG_BLURAY|DBG_CRIT, "_preroll_pg(): error reading %s at %"PRIu64"\n",
+                  st.clip->name, st.clip_block_pos);
+            break;
+        }
 
-    if (psr_init_backup) {
-        bd_psr_reset_backup_registers(bd->regs);
+        /* keep ordering with main path units when PG decoding thread is used */
+        if (gc_decode_pg_async(bd->graphics_controller, pg_pid, unit, _unit_info(&st, unit)) < 0) {
+            complete |= gc_decode_ts(bd->graphics_controller, pg_pid, unit, _unit_info(&st, unit), 1, -1) > 0;
+        }
     }
 
-    disc_update(bd->disc, vp_path);
+    st.stats->s.decode_time += bd_get_time_us() - t0;
 
-    /* TODO: reload all cached information, update disc info, notify app */
+    /* render latest complete display set */
+    if (complete) {
+        gc_run(bd->graphics_controller, GC_CTRL_PG_UPDATE, 0, NULL);
+    }
 
-    bd_mutex_unlock(&bd->mutex);
+    BD_DEBUG(DBG_BLURAY, "_preroll_pg(): decoded PG stream from %s packets %u-%u\n",
+          st.clip->name, start_pkt, clip_pkt);
 
-    return 0;
+    _close_m2ts(&st);
 }
-#endif
 
-#ifdef USING_BDJAVA
-BD_DISC *bd_get_disc(BLURAY *bd)
+static int64_t _seek_stream(BLURAY *bd, BD_STREAM *st,
+                            NAV_CLIP *clip, uint32_t clip_pkt)
 {
-    return bd ? bd->disc : NULL;
-}
-#endif
+    if (!clip)
+        return -1;
 
-#ifdef USING_BDJAVA
-uint32_t bd_reg_read(BLURAY *bd, int psr, int reg)
-{
-    if (psr) {
-        return bd_psr_read(bd->regs, reg);
+    if (!st->fp || !st->clip || clip->ref != st->clip->ref) {
+        // The position is in a new clip
+        if (st == &bd->st0) {
+            /* keep current clip open: seeks often return to it */
+            _park_m2ts(bd, st);
+        }
+        st->clip = clip;
+        if (!_open_m2ts(bd, st)) {
+            return -1;
+        }
+    }
+
+    if (st->m2ts_filter) {
+        m2ts_filter_seek(st->m2ts_filter, 0, (int64_t)st->clip->in_time << 1);
+    }
+
+    st->clip_pos = (uint64_t)clip_pkt * 192;
+    st->clip_block_pos = (st->clip_pos / 6144) * 6144;
+    st->prefetch_pos = 0;
+    st->rd_err.active = 0;
+
+    _reset_read_buffer(st);
+
+    st->int_buf_off = 6144;
+    st->time_ref_valid = 0;
+    st->stats->s.seeks++;
+    BD_TRACE(st->stats->dec.trace, BD_TRACE_SEEK, st->clip_pos, st->clip->clip_id);
+
+    return st->clip_pos;
+}
+
+/*
+ * Graphics controller interface
+ */
+
+/* parse sound.bdmv (once). Called with bd->mutex locked. */
+static void _load_sound_effects(BLURAY *bd)
+{
+    if (!bd->sound_effects_loaded) {
+        bd->sound_effects_loaded = 1;
+        bd->sound_effects = sound_get(bd->disc);
+        if (bd->sound_effects) {
+            BD_DEBUG(DBG_BLURAY, "%d sound effects loaded\n", bd->sound_effects->num_sounds);
+        }
+    }
+}
+
+/*
+ * internal timers
+ */
+
+enum {
+    TIMER_GC      = 0,  /* IG effect, animation frame or user timeout */
+    TIMER_STILL   = 1,  /* end of timed still */
+    TIMER_METRICS = 2,  /* next metrics report */
+};
+
+static void _update_timers(BLURAY *bd)
+{
+    int64_t pts;
+
+    if (!bd->timers) {
+        return;
+    }
+
+    if (bd->title_type == title_hdmv && gc_next_timer(bd->graphics_controller, &pts)) {
+        int64_t delay = pts - (int64_t)bd_get_scr();
+        bd_timers_set(bd->timers, TIMER_GC, bd_get_time_us() + (delay > 0 ? (uint64_t)delay * 1000 / 90 : 0));
     } else {
-        return bd_gpr_read(bd->regs, reg);
+        bd_timers_cancel(bd->timers, TIMER_GC);
+    }
+
+    if (bd->still_active && bd->still_end_us) {
+        bd_timers_set(bd->timers, TIMER_STILL, bd->still_end_us);
+    } else {
+        bd_timers_cancel(bd->timers, TIMER_STILL);
+    }
+
+    if (bd->metrics.cb) {
+        bd_timers_set(bd->timers, TIMER_METRICS, bd->metrics.last_us + bd->metrics.interval_us);
+    } else {
+        bd_timers_cancel(bd->timers, TIMER_METRICS);
     }
 }
-#endif
 
-#ifdef USING_BDJAVA
-int bd_reg_write(BLURAY *bd, int psr, int reg, uint32_t value, uint32_t psr_value_mask)
+static int _run_gc(BLURAY *bd, gc_ctrl_e msg, uint32_t param)
 {
-    if (psr) {
-        if (psr < 102) {
-            /* avoid deadlocks (psr_write triggers callbacks that may lock this mutex) */
-            bd_mutex_lock(&bd->mutex);
+    int result = -1;
+
+    if (!bd) {
+        return -1;
+    }
+
+    if (bd->graphics_controller && bd->hdmv_vm) {
+        GC_NAV_CMDS cmds = {-1, NULL, -1, 0, 0, EMPTY_UO_MASK, 0, NULL};
+
+        result = gc_run(bd->graphics_controller, msg, param, &cmds);
+
+        if (cmds.num_nav_cmds > 0) {
+            hdmv_vm_set_object(bd->hdmv_vm, cmds.num_nav_cmds, cmds.nav_cmds);
+            bd->hdmv_suspended = !hdmv_vm_running(bd->hdmv_vm);
         }
-        int res = bd_psr_write_bits(bd->regs, reg, value, psr_value_mask);
-        if (psr < 102) {
-            bd_mutex_unlock(&bd->mutex);
+
+        if (cmds.status != bd->gc_status) {
+            uint32_t changed_flags = cmds.status ^ bd->gc_status;
+            bd->gc_status = cmds.status;
+            if (changed_flags & GC_STATUS_MENU_OPEN) {
+                _queue_event(bd, BD_EVENT_MENU, !!(bd->gc_status & GC_STATUS_MENU_OPEN));
+                if (bd->gc_status & GC_STATUS_MENU_OPEN) {
+                    /* have sound effects ready before first button sound */
+                    _load_sound_effects(bd);
+                    _prefetch_menu_playlists(bd);
+                }
+            }
+            if (changed_flags & GC_STATUS_POPUP) {
+                _queue_event(bd, BD_EVENT_POPUP, !!(bd->gc_status & GC_STATUS_POPUP));
+            }
+        }
+
+        /* after menu open: selected button targets go before rest of the menu */
+        if (cmds.num_hint_cmds > 0) {
+            _prefetch_button_playlists(bd, cmds.hint_cmds, cmds.num_hint_cmds);
+        }
+
+        if (cmds.sound_id_ref >= 0 && cmds.sound_id_ref < 0xff) {
+            _queue_event(bd, BD_EVENT_SOUND_EFFECT, cmds.sound_id_ref);
+        }
+
+    } else {
+        if (bd->gc_status & GC_STATUS_MENU_OPEN) {
+            _queue_event(bd, BD_EVENT_MENU, 0);
+        }
+        if (bd->gc_status & GC_STATUS_POPUP) {
+            _queue_event(bd, BD_EVENT_POPUP, 0);
+        }
+        bd->gc_status = GC_STATUS_NONE;
+    }
+
+    _update_timers(bd);
+
+    return result;
+}
+
+/*
+ * meta open
+ */
+
+static int _meta_open(BLURAY *bd)
+{
+    if (!bd->meta) {
+        char *key = NULL;
+
+        if (bd->nav_cache) {
+            key = nav_cache_key(bd->disc);
+            bd->meta = nav_cache_load_meta(bd->disc, key);
+        }
+        if (!bd->meta) {
+            bd->meta = meta_parse(bd->disc);
+            nav_cache_save_meta(bd->disc, key, bd->meta);
+        }
+        X_FREE(key);
+    }
+
+    return !!bd->meta;
+}
+
+/*
+ * disc info
+ */
+
+const BLURAY_STARTUP_PROFILE *bd_get_startup_profile(BLURAY *bd)
+{
+    if (!bd) {
+        return NULL;
+    }
+    return &bd->profile;
+}
+
+static void _fill_enc_info(BLURAY *bd, BD_ENC_INFO *enc_info)
+{
+    bd->disc_info.aacs_detected      = enc_info->aacs_detected;
+    bd->disc_info.libaacs_detected   = enc_info->libaacs_detected;
+    bd->disc_info.aacs_error_code    = enc_info->aacs_error_code;
+    bd->disc_info.aacs_handled       = enc_info->aacs_handled;
+    bd->disc_info.aacs_mkbv          = enc_info->aacs_mkbv;
+    memcpy(bd->disc_info.disc_id, enc_info->disc_id, 20);
+    bd->disc_info.bdplus_detected    = enc_info->bdplus_detected;
+    bd->disc_info.libbdplus_detected = enc_info->libbdplus_detected;
+    bd->disc_info.bdplus_handled     = enc_info->bdplus_handled;
+    bd->disc_info.bdplus_gen         = enc_info->bdplus_gen;
+    bd->disc_info.bdplus_date        = enc_info->bdplus_date;
+}
+
+const BLURAY_DISC_INFO *bd_get_disc_info(BLURAY *bd)
+{
+    if (bd->enc_info_pending) {
+        BD_ENC_INFO enc_info;
+
+        bd_mutex_lock(&bd->mutex);
+        if (bd->enc_info_pending && disc_get_enc_info(bd->disc, &enc_info)) {
+            _fill_enc_info(bd, &enc_info);
+            bd->enc_info_pending = 0;
+        }
+        bd_mutex_unlock(&bd->mutex);
+    }
+
+    return &bd->disc_info;
+}
+
+int bd_probe(const char *device_path, BLURAY_PROBE_INFO *info, uint32_t flags)
+{
+    BD_ENC_INFO enc_info;
+    BD_DISC    *disc;
+    INDX_ROOT  *index;
+    unsigned    ii;
+
+    if (!info) {
+        return 0;
+    }
+    memset(info, 0, sizeof(*info));
+
+    if (!device_path) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "No device path provided!\n");
+        return 0;
+    }
+
+    /* lazy decrypt init: only AACS / BD+ presence is detected */
+    memset(&enc_info, 0, sizeof(enc_info));
+    disc = disc_open(device_path, NULL, NULL, NULL, &enc_info, NULL,
+                     NULL, NULL, NULL, DEC_INIT_LAZY, 0);
+    if (!disc) {
+        return 0;
+    }
+
+    info->aacs_detected   = enc_info.aacs_detected;
+    info->bdplus_detected = enc_info.bdplus_detected;
+
+    index = indx_get(disc);
+    if (index) {
+        info->bluray_detected  = 1;
+        info->video_format     = index->app_info.video_format;
+        info->frame_rate       = index->app_info.frame_rate;
+        info->content_exist_3D = index->app_info.content_exist_flag;
+        info->num_titles       = index->num_titles;
+
+        for (ii = 0; ii < index->num_titles; ii++) {
+            if (index->titles[ii].object_type == indx_object_type_hdmv) {
+                info->num_hdmv_titles++;
+            }
+            if (index->titles[ii].object_type == indx_object_type_bdj) {
+                info->num_bdj_titles++;
+            }
+        }
+        info->bdj_detected = info->num_bdj_titles > 0 ||
+                             index->first_play.object_type == indx_object_type_bdj ||
+                             index->top_menu.object_type == indx_object_type_bdj;
+
+        indx_free(&index);
+    }
+
+    if (info->bdj_detected) {
+        BDID_DATA *bdid = bdid_get(disc); /* parse id.bdmv */
+        if (bdid) {
+            memcpy(info->bdj_org_id,  bdid->org_id,  sizeof(info->bdj_org_id));
+            memcpy(info->bdj_disc_id, bdid->disc_id, sizeof(info->bdj_disc_id));
+            bdid_free(&bdid);
+        }
+    }
+
+    if (info->bluray_detected && (flags & BD_PROBE_PLAYLISTS)) {
+        /* playlist headers only (no clip info) */
+        NAV_TITLE_LIST *title_list = nav_get_title_list(disc, TITLES_RELEVANT, 0, 0, NULL, NULL);
+        if (title_list) {
+            info->num_playlists = title_list->count;
+            if (title_list->count > 0) {
+                NAV_TITLE_INFO *main_title = &title_list->title_info[title_list->main_title_idx];
+                info->main_playlist       = main_title->mpls_id;
+                info->main_title_duration = (uint64_t)main_title->duration * 2;
+            }
+            nav_free_title_list(title_list);
+        }
+    }
+
+    disc_close(&disc);
+
+    BD_DEBUG(DBG_BLURAY, "bd_probe(%s): bluray %d, AACS %d, BD+ %d, BD-J %d, %u titles\n",
+             device_path, info->bluray_detected, info->aacs_detected, info->bdplus_detected,
+             info->bdj_detected, info->num_titles);
+
+    return info->bluray_detected;
+}
+
+static void _fill_disc_info(BLURAY *bd, BD_ENC_INFO *enc_info)
+{
+    INDX_ROOT *index;
+    uint64_t   t0;
+
+    _fill_enc_info(bd, enc_info);
+
+    bd->disc_info.udf_volume_id      = disc_volume_id(bd->disc);
+
+    bd->disc_info.bluray_detected        = 0;
+    bd->disc_info.top_menu_supported     = 0;
+    bd->disc_info.first_play_supported   = 0;
+    bd->disc_info.num_hdmv_titles        = 0;
+    bd->disc_info.num_bdj_titles         = 0;
+    bd->disc_info.num_unsupported_titles = 0;
+
+    bd->disc_info.bdj_detected    = 0;
+    bd->disc_info.bdj_supported   = 0;
+    bd->disc_info.libjvm_detected = 0;
+    bd->disc_info.bdj_handled     = 0;
+
+    bd->disc_info.num_titles  = 0;
+    bd->disc_info.titles      = NULL;
+    bd->disc_info.top_menu    = NULL;
+    bd->disc_info.first_play  = NULL;
+
+    array_free((void**)&bd->titles);
+
+    memset(bd->disc_info.bdj_org_id,  0, sizeof(bd->disc_info.bdj_org_id));
+    memset(bd->disc_info.bdj_disc_id, 0, sizeof(bd->disc_info.bdj_disc_id));
+
+    t0 = bd_get_time_us();
+    index = indx_get(bd->disc);
+    bd->profile.index_parse_us = bd_get_time_us() - t0;
+    if (index) {
+        INDX_PLAY_ITEM *pi;
+        unsigned        ii;
+
+        bd->disc_info.bluray_detected = 1;
+
+        /* application info */
+        bd->disc_info.video_format     = index->app_info.video_format;
+        bd->disc_info.frame_rate       = index->app_info.frame_rate;
+        bd->disc_info.content_exist_3D = index->app_info.content_exist_flag;
+        bd->disc_info.initial_output_mode_preference = index->app_info.initial_output_mode_preference;
+        memcpy(bd->disc_info.provider_data, index->app_info.user_data, sizeof(bd->disc_info.provider_data));
+
+        /* allocate array for title info */
+        BLURAY_TITLE **titles = (BLURAY_TITLE**)array_alloc(index->num_titles + 2, sizeof(BLURAY_TITLE));
+        if (!titles) {
+            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Can't allocate memory\n");
+            return;
+        }
+        bd->titles = titles;
+        bd->disc_info.titles = (const BLURAY_TITLE * const *)titles;
+        bd->disc_info.num_titles = index->num_titles;
+
+        /* count titles and fill title info */
+
+        for (ii = 0; ii < index->num_titles; ii++) {
+            if (index->titles[ii].object_type == indx_object_type_hdmv) {
+                bd->disc_info.num_hdmv_titles++;
+                titles[ii + 1]->interactive = (index->titles[ii].hdmv.playback_type == indx_hdmv_playback_type_interactive);
+                titles[ii + 1]->id_ref = index->titles[ii].hdmv.id_ref;
+            }
+            if (index->titles[ii].object_type == indx_object_type_bdj) {
+                bd->disc_info.num_bdj_titles++;
+                bd->disc_info.bdj_detected = 1;
+                titles[ii + 1]->bdj = 1;
+                titles[ii + 1]->interactive = (index->titles[ii].bdj.playback_type == indx_bdj_playback_type_interactive);
+                titles[ii + 1]->id_ref = atoi(index->titles[ii].bdj.name);
+            }
+
+            titles[ii + 1]->accessible =  !(index->titles[ii].access_type & INDX_ACCESS_PROHIBITED_MASK);
+            titles[ii + 1]->hidden     = !!(index->titles[ii].access_type & INDX_ACCESS_HIDDEN_MASK);
+        }
+
+        pi = &index->first_play;
+        if (pi->object_type == indx_object_type_bdj) {
+            bd->disc_info.bdj_detected = 1;
+            titles[index->num_titles + 1]->bdj = 1;
+            titles[index->num_titles + 1]->interactive = (pi->bdj.playback_type == indx_bdj_playback_type_interactive);
+            titles[index->num_titles + 1]->id_ref = atoi(pi->bdj.name);
+        }
+        if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
+            titles[index->num_titles + 1]->interactive = (pi->hdmv.playback_type == indx_hdmv_playback_type_interactive);
+            titles[index->num_titles + 1]->id_ref = pi->hdmv.id_ref;
+        }
+
+        pi = &index->top_menu;
+        if (pi->object_type == indx_object_type_bdj) {
+            bd->disc_info.bdj_detected = 1;
+            titles[0]->bdj = 1;
+            titles[0]->interactive = (pi->bdj.playback_type == indx_bdj_playback_type_interactive);
+            titles[0]->id_ref = atoi(pi->bdj.name);
+        }
+        if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
+            titles[0]->interactive = (pi->hdmv.playback_type == indx_hdmv_playback_type_interactive);
+            titles[0]->id_ref = pi->hdmv.id_ref;
+        }
+
+        /* check for BD-J capability */
+
+#ifdef USING_BDJAVA
+        if (bd->disc_info.bdj_detected) {
+            bd->disc_info.bdj_supported = 1;
+            /* BD-J titles found. Check if jvm + jar can be loaded ? */
+            switch (bdj_jvm_available(&bd->bdjstorage)) {
+                case 2: bd->disc_info.bdj_handled     = 1;
+                case 1: bd->disc_info.libjvm_detected = 1;
+                default:;
+            }
+        }
+#endif /* USING_BDJAVA */
+
+        /* mark supported titles */
+
+        if (bd->disc_info.bdj_detected && !bd->disc_info.bdj_handled) {
+            bd->disc_info.num_unsupported_titles = bd->disc_info.num_bdj_titles;
+        }
+
+        pi = &index->first_play;
+        if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
+            bd->disc_info.first_play_supported = 1;
+        }
+        if (pi->object_type == indx_object_type_bdj) {
+            bd->disc_info.first_play_supported = bd->disc_info.bdj_handled;
+        }
+
+        pi = &index->top_menu;
+        if (pi->object_type == indx_object_type_hdmv && pi->hdmv.id_ref != 0xffff) {
+            bd->disc_info.top_menu_supported = 1;
+        }
+        if (pi->object_type == indx_object_type_bdj) {
+            bd->disc_info.top_menu_supported = bd->disc_info.bdj_handled;
+        }
+
+        /* */
+
+        if (bd->disc_info.first_play_supported) {
+            titles[index->num_titles + 1]->accessible = 1;
+            bd->disc_info.first_play = titles[index->num_titles + 1];
+        }
+        if (bd->disc_info.top_menu_supported) {
+            titles[0]->accessible = 1;
+            bd->disc_info.top_menu = titles[0];
+        }
+
+        /* populate title names */
+        bd_get_meta(bd);
+
+        indx_free(&index);
+    }
+
+    if (bd->disc_info.bdj_detected) {
+        BDID_DATA *bdid = bdid_get(bd->disc); /* parse id.bdmv */
+        if (bdid) {
+            memcpy(bd->disc_info.bdj_org_id,  bdid->org_id,  sizeof(bd->disc_info.bdj_org_id));
+            memcpy(bd->disc_info.bdj_disc_id, bdid->disc_id, sizeof(bd->disc_info.bdj_disc_id));
+            bdid_free(&bdid);
+        }
+    }
+}
+
+static void _pace_wake(BLURAY *bd);
+
+/*
+ * bdj
+ */
+
+#ifdef USING_BDJAVA
+const uint8_t *bd_get_aacs_data(BLURAY *bd, int type)
+{
+    return disc_get_data(bd->disc, type);
+}
+#endif
+
+#ifdef USING_BDJAVA
+void bd_set_bdj_uo_mask(BLURAY *bd, unsigned mask)
+{
+    bd->bdj_uo_mask.title_search = !!(mask & BDJ_TITLE_SEARCH_MASK);
+    bd->bdj_uo_mask.menu_call    = !!(mask & BDJ_MENU_CALL_MASK);
+}
+#endif
+
+#ifdef USING_BDJAVA
+uint64_t bd_get_uo_mask(BLURAY *bd)
+{
+    /* internal function. Used by BD-J. */
+    union {
+      uint64_t u64;
+      BD_UO_MASK mask;
+    } mask = {0};
+
+    //bd_mutex_lock(&bd->mutex);
+    memcpy(&mask.mask, &bd->st0.uo_mask, sizeof(BD_UO_MASK));
+    //bd_mutex_unlock(&bd->mutex);
+
+    return mask.u64;
+}
+#endif
+
+#ifdef USING_BDJAVA
+void bd_select_rate(BLURAY *bd, float rate, int reason)
+{
+    if (reason == BDJ_PLAYBACK_STOP) {
+        /* playback stop. Might want to wait for buffers empty here. */
+        return;
+    }
+
+    if (reason == BDJ_PLAYBACK_START) {
+        /* playback is triggered by bd_select_rate() */
+        bd->bdj_wait_start = 0;
+    }
+
+    if (rate < 0.5) {
+        _queue_event(bd, BD_EVENT_STILL, 1);
+    } else {
+        _queue_event(bd, BD_EVENT_STILL, 0);
+    }
+
+    /* output pacing continues at new rate from next released unit */
+    bd->pace_rate  = rate;
+    bd->pace_valid = 0;
+    _pace_wake(bd);
+}
+#endif
+
+#ifdef USING_BDJAVA
+int bd_set_virtual_package(BLURAY *bd, const char *vp_path, int psr_init_backup)
+{
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->title) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_set_virtual_package() failed: playlist is playing\n");
+        return -1;
+    }
+    if (bd->title_type != title_bdj) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_set_virtual_package() failed: HDMV title\n");
+        return -1;
+    }
+
+    if (psr_init_backup) {
+        bd_psr_reset_backup_registers(bd->regs);
+    }
+
+    disc_update(bd->disc, vp_path);
+
+    /* TODO: reload all cached information, update disc info, notify app */
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return 0;
+}
+#endif
+
+#ifdef USING_BDJAVA
+BD_DISC *bd_get_disc(BLURAY *bd)
+{
+    return bd ? bd->disc : NULL;
+}
+#endif
+
+#ifdef USING_BDJAVA
+uint32_t bd_reg_read(BLURAY *bd, int psr, int reg)
+{
+    if (psr) {
+        return bd_psr_read(bd->regs, reg);
+    } else {
+        return bd_gpr_read(bd->regs, reg);
+    }
+}
+#endif
+
+#ifdef USING_BDJAVA
+int bd_reg_write(BLURAY *bd, int psr, int reg, uint32_t value, uint32_t psr_value_mask)
+{
+    if (psr) {
+        if (psr < 102) {
+            /* avoid deadlocks (psr_write triggers callbacks that may lock this mutex) */
+            bd_mutex_lock(&bd->mutex);
+        }
+        int res = bd_psr_write_bits(bd->regs, reg, value, psr_value_mask);
+        if (psr < 102) {
+            bd_mutex_unlock(&bd->mutex);
+        }
+        return res;
+    } else {
+        return bd_gpr_write(bd->regs, reg, value);
+    }
+}
+#endif
+
+/*
+ * triple-buffered ARGB frame buffer
+ */
+
+#define ARGB_NEW_FRAME 4  /* flip_state flag: published buffer not yet acquired */
+
+static unsigned _argb_xchg(unsigned *p, unsigned v)
+{
+    BD_ATOMIC_UINT *a = (BD_ATOMIC_UINT *)p;
+    unsigned old = bd_atomic_load(a);
+    while (!bd_atomic_cas(a, &old, v)) ;
+    return old;
+}
+
+const uint32_t *bd_argb_buffer_acquire(BD_ARGB_BUFFER_EXT *buf, int plane)
+{
+    if (!buf || buf->num_buffers != 3 || plane < 0 || plane > 1) {
+        return NULL;
+    }
+
+    if (bd_atomic_load((BD_ATOMIC_UINT *)&buf->flip_state[plane]) & ARGB_NEW_FRAME) {
+        buf->front[plane] = _argb_xchg(&buf->flip_state[plane], buf->front[plane]) & 3;
+    }
+
+    return buf->bufs[plane][buf->front[plane]];
+}
+
+#ifdef USING_BDJAVA
+static void _argb_buffer_init(BD_ARGB_BUFFER_EXT *buf)
+{
+    unsigned plane, ii;
+
+    for (plane = 0; plane < 2; plane++) {
+        buf->front[plane] = 0;
+        buf->back[plane]  = 2;
+        bd_atomic_store((BD_ATOMIC_UINT *)&buf->flip_state[plane], 1);
+        for (ii = 0; ii < 3; ii++) {
+            /* buffer content is unknown */
+            buf->stale[plane][ii].x0 = buf->stale[plane][ii].y0 = 0;
+            buf->stale[plane][ii].x1 = buf->stale[plane][ii].y1 = 0xffff;
+        }
+    }
+}
+
+uint32_t *bd_argb_buffer_back(BD_ARGB_BUFFER_EXT *buf, int plane, int *x0, int *y0, int *x1, int *y1)
+{
+    unsigned back = buf->back[plane];
+
+    if (buf->stale[plane][back].x0 <= buf->stale[plane][back].x1) {
+        *x0 = BD_MIN(*x0, buf->stale[plane][back].x0);
+        *y0 = BD_MIN(*y0, buf->stale[plane][back].y0);
+        *x1 = BD_MAX(*x1, buf->stale[plane][back].x1);
+        *y1 = BD_MAX(*y1, buf->stale[plane][back].y1);
+    }
+
+    return buf->bufs[plane][back];
+}
+
+uint32_t *bd_argb_buffer_flip(BD_ARGB_BUFFER_EXT *buf, int plane, int x0, int y0, int x1, int y1)
+{
+    unsigned back = buf->back[plane];
+    unsigned ii;
+
+    /* other buffers miss this update */
+    for (ii = 0; ii < 3; ii++) {
+        if (ii == back) {
+            buf->stale[plane][ii].x0 = buf->stale[plane][ii].y0 = 0xffff;
+            buf->stale[plane][ii].x1 = buf->stale[plane][ii].y1 = 0;
+        } else if (buf->stale[plane][ii].x0 > buf->stale[plane][ii].x1) {
+            buf->stale[plane][ii].x0 = x0;
+            buf->stale[plane][ii].y0 = y0;
+            buf->stale[plane][ii].x1 = x1;
+            buf->stale[plane][ii].y1 = y1;
+        } else {
+            buf->stale[plane][ii].x0 = BD_MIN(buf->stale[plane][ii].x0, x0);
+            buf->stale[plane][ii].y0 = BD_MIN(buf->stale[plane][ii].y0, y0);
+            buf->stale[plane][ii].x1 = BD_MAX(buf->stale[plane][ii].x1, x1);
+            buf->stale[plane][ii].y1 = BD_MAX(buf->stale[plane][ii].y1, y1);
+        }
+    }
+
+    /* page flip */
+    buf->back[plane] = _argb_xchg(&buf->flip_state[plane], back | ARGB_NEW_FRAME) & 3;
+
+    return buf->bufs[plane][back];
+}
+
+BD_ARGB_BUFFER *bd_lock_osd_buffer(BLURAY *bd)
+{
+    bd_mutex_lock(&bd->argb_buffer_mutex);
+    return bd->argb_buffer;
+}
+
+void bd_unlock_osd_buffer(BLURAY *bd)
+{
+    bd_mutex_unlock(&bd->argb_buffer_mutex);
+}
+
+BD_ARGB_BUFFER_EXT *bd_osd_buffer_ext(BLURAY *bd)
+{
+    return bd->argb_buffer_ext;
+}
+
+/*
+ * handle graphics updates from BD-J layer
+ */
+void bd_argb_buffer_set_dirty(BD_ARGB_BUFFER *buf, BD_ARGB_BUFFER_EXT *ext, int plane,
+                              const int *rects, int num_rects)
+{
+    int x0 = rects[0], y0 = rects[1], x1 = rects[2], y1 = rects[3];
+    int ii;
+
+    for (ii = 1; ii < num_rects; ii++) {
+        x0 = BD_MIN(x0, rects[ii * 4 + 0]);
+        y0 = BD_MIN(y0, rects[ii * 4 + 1]);
+        x1 = BD_MAX(x1, rects[ii * 4 + 2]);
+        y1 = BD_MAX(y1, rects[ii * 4 + 3]);
+    }
+
+    buf->dirty[plane].x0 = x0;
+    buf->dirty[plane].x1 = x1;
+    buf->dirty[plane].y0 = y0;
+    buf->dirty[plane].y1 = y1;
+
+    if (!ext) {
+        return;
+    }
+
+    if (num_rects > BD_ARGB_MAX_DIRTY_RECTS) {
+        /* too many rectangles, use bounding box */
+        rects = NULL;
+        num_rects = 1;
+    }
+    ext->num_dirty_rects[plane] = num_rects;
+    for (ii = 0; ii < num_rects; ii++) {
+        ext->dirty_rects[plane][ii].x0 = rects ? rects[ii * 4 + 0] : x0;
+        ext->dirty_rects[plane][ii].y0 = rects ? rects[ii * 4 + 1] : y0;
+        ext->dirty_rects[plane][ii].x1 = rects ? rects[ii * 4 + 2] : x1;
+        ext->dirty_rects[plane][ii].y1 = rects ? rects[ii * 4 + 3] : y1;
+    }
+}
+
+void bd_bdj_osd_cb(BLURAY *bd, const unsigned *img, int w, int h,
+                   int x0, int y0, int x1, int y1)
+{
+    int rect[4] = {x0, y0, x1, y1};
+
+    /* no changed pixels ? */
+    if (img && (x1 < x0 || y1 < y0)) {
+        return;
+    }
+
+    bd_bdj_osd_cb_rects(bd, img, w, h, rect, 1);
+}
+
+void bd_bdj_osd_cb_rects(BLURAY *bd, const unsigned *img, int w, int h,
+                         const int *rects, int num_rects)
+{
+    BD_ARGB_OVERLAY aov;
+    int ii;
+
+    if (!bd->argb_overlay_proc) {
+        _queue_event(bd, BD_EVENT_MENU, 0);
+        return;
+    }
+
+    memset(&aov, 0, sizeof(aov));
+    aov.pts   = -1;
+    aov.plane = BD_OVERLAY_IG;
+
+    /* no image data -> init or close */
+    if (!img) {
+        if (w > 0 && h > 0) {
+            aov.cmd = BD_ARGB_OVERLAY_INIT;
+            aov.w   = w;
+            aov.h   = h;
+            _queue_event(bd, BD_EVENT_MENU, 1);
+        } else {
+            aov.cmd = BD_ARGB_OVERLAY_CLOSE;
+            _queue_event(bd, BD_EVENT_MENU, 0);
+        }
+
+        bd->argb_overlay_proc(bd->argb_overlay_proc_handle, &aov);
+        return;
+    }
+
+    /* no changed pixels ? */
+    if (num_rects < 1) {
+        return;
+    }
+
+    if (bd->argb_buffer) {
+        /* set dirty region */
+        bd_argb_buffer_set_dirty(bd->argb_buffer, bd->argb_buffer_ext, BD_OVERLAY_IG, rects, num_rects);
+
+        if (bd->argb_buffer->width < w || bd->argb_buffer->height < h) {
+            /* buffer holds only the bounding box of changed region */
+            aov.cmd    = BD_ARGB_OVERLAY_DRAW;
+            aov.argb   = img;
+            aov.stride = w;
+            aov.x      = bd->argb_buffer->dirty[BD_OVERLAY_IG].x0;
+            aov.y      = bd->argb_buffer->dirty[BD_OVERLAY_IG].y0;
+            aov.w      = bd->argb_buffer->dirty[BD_OVERLAY_IG].x1 - aov.x + 1;
+            aov.h      = bd->argb_buffer->dirty[BD_OVERLAY_IG].y1 - aov.y + 1;
+            bd->argb_overlay_proc(bd->argb_overlay_proc_handle, &aov);
+            num_rects = 0;
+        }
+    }
+
+    /* draw changed regions */
+    aov.cmd    = BD_ARGB_OVERLAY_DRAW;
+    aov.stride = w;
+    for (ii = 0; ii < num_rects; ii++) {
+        const int *r = rects + ii * 4;
+        aov.argb = img + r[0] + r[1] * w;
+        aov.x    = r[0];
+        aov.y    = r[1];
+        aov.w    = r[2] - r[0] + 1;
+        aov.h    = r[3] - r[1] + 1;
+        bd->argb_overlay_proc(bd->argb_overlay_proc_handle, &aov);
+    }
+
+    /* commit changes */
+    aov.cmd = BD_ARGB_OVERLAY_FLUSH;
+    bd->argb_overlay_proc(bd->argb_overlay_proc_handle, &aov);
+
+    if (bd->argb_buffer) {
+        /* reset dirty region */
+        bd->argb_buffer->dirty[BD_OVERLAY_IG].x0 = bd->argb_buffer->width;
+        bd->argb_buffer->dirty[BD_OVERLAY_IG].x1 = bd->argb_buffer->height;
+        bd->argb_buffer->dirty[BD_OVERLAY_IG].y0 = 0;
+        bd->argb_buffer->dirty[BD_OVERLAY_IG].y1 = 0;
+        if (bd->argb_buffer_ext) {
+            bd->argb_buffer_ext->num_dirty_rects[BD_OVERLAY_IG] = 0;
+        }
+    }
+}
+#endif
+
+#ifdef USING_BDJAVA
+static void _bdj_psr_event(void *handle, BD_PSR_EVENT *ev)
+{
+    BLURAY *bd = (BLURAY*)handle;
+
+    if (ev->ev_type == BD_PSR_CHANGE || ev->ev_type == BD_PSR_RESTORE) {
+        bdj_psr_mirror_update(bd->bdjava, ev->psr_idx, ev->new_val);
+    }
+}
+
+static void _bdj_psr_mirror_start(BLURAY *bd)
+{
+    uint32_t psr[BD_PSR_COUNT];
+    int      i;
+
+    /* keep PSRs locked until callback is registered: no change is missed */
+    bd_psr_lock(bd->regs);
+
+    for (i = 0; i < BD_PSR_COUNT; i++) {
+        psr[i] = bd_psr_read(bd->regs, i);
+    }
+    if (bdj_psr_mirror_init(bd->bdjava, psr, BD_PSR_COUNT)) {
+        bd_psr_register_cb(bd->regs, _bdj_psr_event, bd);
+    }
+
+    bd_psr_unlock(bd->regs);
+}
+#endif
+
+static int _start_bdj(BLURAY *bd, unsigned title)
+{
+#ifdef USING_BDJAVA
+    if (bd->bdjava == NULL) {
+        const char *root = disc_root(bd->disc);
+        BDJ_PROFILE profile = {0, 0};
+        uint64_t    t0 = bd_get_time_us();
+
+        bd->bdjava = bdj_open(root, bd, bd->disc_info.bdj_disc_id, &bd->bdjstorage, &profile);
+
+        bd->profile.bdj_start_us  = bd_get_time_us() - t0;
+        bd->profile.create_jvm_us = profile.create_jvm_us;
+        bd->profile.bdj_init_us   = profile.bdj_init_us;
+
+        if (!bd->bdjava) {
+            return 0;
+        }
+
+        _bdj_psr_mirror_start(bd);
+    }
+
+    memset(&bd->bdj_uo_mask, 0, sizeof(BD_UO_MASK));
+
+    return !bdj_process_event(bd->bdjava, BDJ_EVENT_START, title);
+#else
+    (void)bd;
+    BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Title %d: BD-J not compiled in\n", title);
+    return 0;
+#endif
+}
+
+#ifdef USING_BDJAVA
+static int _bdj_event(BLURAY *bd, unsigned ev, unsigned param)
+{
+    if (bd->bdjava != NULL) {
+        uint64_t t0 = bd_get_time_us();
+        int result = bdj_process_event(bd->bdjava, ev, param);
+        bd->bdj_events++;
+        bd->bdj_event_time += bd_get_time_us() - t0;
+        return result;
+    }
+    return -1;
+}
+
+static void _bdj_flush_events(BLURAY *bd)
+{
+    if (bd->bdjava != NULL) {
+        bdj_flush_events(bd->bdjava);
+    }
+}
+#else
+#define _bdj_event(bd, ev, param) do{}while(0)
+#define _bdj_flush_events(bd) do{}while(0)
+#endif
+
+#ifdef USING_BDJAVA
+static void _stop_bdj(BLURAY *bd)
+{
+    if (bd->bdjava != NULL) {
+        bdj_process_event(bd->bdjava, BDJ_EVENT_STOP, 0);
+        _queue_event(bd, BD_EVENT_STILL, 0);
+    }
+}
+#else
+#define _stop_bdj(bd) do{}while(0)
+#endif
+
+#ifdef USING_BDJAVA
+static void _close_bdj(BLURAY *bd)
+{
+    if (bd->bdjava != NULL) {
+        bd_psr_unregister_cb(bd->regs, _bdj_psr_event, bd);
+        bdj_close(bd->bdjava, bd->bdj_keep_warm);
+        bd->bdjava = NULL;
+    }
+}
+#else
+#define _close_bdj(bd) do{}while(0)
+#endif
+
+#ifdef USING_BDJAVA
+static void _storage_free(BLURAY *bd)
+{
+    X_FREE(bd->bdjstorage.cache_root);
+    X_FREE(bd->bdjstorage.persistent_root);
+    X_FREE(bd->bdjstorage.classpath);
+    X_FREE(bd->bdjstorage.jvm_options);
+}
+#else
+#define _storage_free(bd) do{}while(0)
+#endif
+
+/*
+ * open / close
+ */
+
+#define FANOUT_MAX_UNITS  (256*1024*1024 / 6144) /* limit fan-out ring to 256M */
+
+static int _stream_read(void *handle, uint8_t *buf, int len)
+{
+    return bd_read((BLURAY *)handle, buf, len);
+}
+
+BLURAY *bd_init(void)
+{
+    BD_DEBUG(DBG_BLURAY, "libbluray version "BLURAY_VERSION_STRING"\n");
+
+    BLURAY *bd = calloc(1, sizeof(BLURAY));
+
+    if (!bd) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Can't allocate memory\n");
+        return NULL;
+    }
+
+    bd->st0.stats = &bd->stats_main;
+
+    bd->regs = bd_registers_init();
+    if (!bd->regs) {
+        BD_DEBUG(DBG_BLURAY, "bd_registers_init() failed\n");
+        X_FREE(bd);
+        return NULL;
+    }
+
+    bd_mutex_init(&bd->mutex);
+    bd_mutex_init(&bd->pl_prefetch_mutex);
+    bd_rwlock_init(&bd->pub.lock);
+    bd_cond_init(&bd->pace_cond);
+    bd_mutex_init(&bd->pace_mutex);
+    bd->pace_rate = 1.0f;
+#ifdef USING_BDJAVA
+    bd_mutex_init(&bd->argb_buffer_mutex);
+#endif
+
+    /* worker thread is started with first request */
+    bd->async_reader = async_reader_init(_stream_read, bd);
+
+    BD_DEBUG(DBG_BLURAY, "BLURAY initialized!\n");
+
+    return bd;
+}
+
+static int _bd_open(BLURAY *bd,
+                    const char *device_path, const char *keyfile_path,
+                    void *read_blocks_handle,
+                    int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks),
+                    void (*prefetch_blocks)(void *handle, int lba, int num_blocks))
+{
+    BD_ENC_INFO enc_info;
+    uint64_t    t0, t1;
+
+    if (!bd) {
+        return 0;
+    }
+    if (bd->disc) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Disc already open\n");
+        return 0;
+    }
+
+    memset(&bd->profile, 0, sizeof(bd->profile));
+    t0 = bd_get_time_us();
+
+    bd->disc = disc_open(device_path, read_blocks_handle, read_blocks, prefetch_blocks,
+                         &enc_info, keyfile_path,
+                         (void*)bd->regs, (void*)bd_psr_read, (void*)bd_psr_write,
+                         (bd->lazy_decrypt   ? DEC_INIT_LAZY   : 0) |
+                         (bd->shared_decrypt ? DEC_INIT_SHARED : 0),
+                         bd->direct_io);
+
+    if (!bd->disc) {
+        return 0;
+    }
+
+    t1 = bd_get_time_us();
+    bd->profile.disc_open_us = t1 - t0;
+    bd->profile.dec_init_us  = disc_dec_init_time(bd->disc);
+
+    if (bd->low_memory) {
+        disc_cache_set_limit(bd->disc, LOW_MEM_DISC_CACHE_SIZE);
+    }
+
+    _fill_disc_info(bd, &enc_info);
+
+    bd->profile.fill_disc_info_us = bd_get_time_us() - t1;
+    bd->profile.open_us           = bd_get_time_us() - t0;
+
+    bd->enc_info_pending = bd->lazy_decrypt && (enc_info.aacs_detected || enc_info.bdplus_detected);
+
+    if (device_path) {
+        bd->drive_path = str_dup(device_path);
+        _open_drive(bd);
+    }
+
+    return bd->disc_info.bluray_detected;
+}
+
+int bd_open_disc(BLURAY *bd, const char *device_path, const char *keyfile_path)
+{
+    if (!device_path) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "No device path provided!\n");
+        return 0;
+    }
+
+    return _bd_open(bd, device_path, keyfile_path, NULL, NULL, NULL);
+}
+
+int bd_open_stream(BLURAY *bd,
+                   void *read_blocks_handle,
+                   int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks))
+{
+    if (!read_blocks) {
+        return 0;
+    }
+
+    return _bd_open(bd, NULL, NULL, read_blocks_handle, read_blocks, NULL);
+}
+
+int bd_open_stream_prefetch(BLURAY *bd,
+                            void *read_blocks_handle,
+                            int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks),
+                            void (*prefetch_blocks)(void *handle, int lba, int num_blocks))
+{
+    if (!read_blocks) {
+        return 0;
+    }
+
+    return _bd_open(bd, NULL, NULL, read_blocks_handle, read_blocks, prefetch_blocks);
+}
+
+BLURAY *bd_open(const char *device_path, const char *keyfile_path)
+{
+    BLURAY *bd;
+
+    bd = bd_init();
+    if (!bd) {
+        return NULL;
+    }
+
+    bd_open_disc(bd, device_path, keyfile_path);
+
+    return bd;
+}
+
+void bd_close(BLURAY *bd)
+{
+    /* finish or cancel queued asynchronous reads */
+    async_reader_free(&bd->async_reader);
+    fanout_free(&bd->fanout);
+    bd_timers_free(&bd->timers);
+
+    bd_cancel_title_scan(bd);
+    _stop_pl_prefetch(bd);
+
+    _close_bdj(bd);
+
+    _close_m2ts(&bd->st0);
+    _close_preopen(&bd->st_next);
+    _flush_clip_handles(bd);
+    _close_preload(&bd->st_ig);
+    _close_preload(&bd->st_textst);
+    unit_cache_free(&bd->st0.cache);
+
+    if (bd->title_list != NULL) {
+        nav_free_title_list(bd->title_list);
+    }
+    if (bd->title != NULL) {
+        nav_title_close(bd->title);
+    }
+
+    hdmv_vm_free(&bd->hdmv_vm);
+
+    gc_free(&bd->graphics_controller);
+    meta_free(&bd->meta);
+    sound_free(&bd->sound_effects);
+    m2ts_demux_free(&bd->es_demux);
+    bd_registers_free(bd->regs);
+
+    _free_event_queue(bd);
+    array_free((void**)&bd->titles);
+    _storage_free(bd);
+
+    /* restore drive default speed */
+    drive_close(&bd->drive);
+    X_FREE(bd->drive_path);
+
+    disc_close(&bd->disc);
+
+    bd_trace_free(&bd->trace);
+
+    bd_cond_destroy(&bd->pace_cond);
+    bd_mutex_destroy(&bd->pace_mutex);
+    bd_mutex_destroy(&bd->pl_prefetch_mutex);
+    bd_mutex_destroy(&bd->mutex);
+    bd_rwlock_destroy(&bd->pub.lock);
+#ifdef USING_BDJAVA
+    bd_mutex_destroy(&bd->argb_buffer_mutex);
+#endif
+
+    BD_DEBUG(DBG_BLURAY, "BLURAY destroyed!\n");
+
+    X_FREE(bd);
+}
+
+/*
+ * PlayMark tracking
+ */
+
+static void _find_next_playmark(BLURAY *bd)
+{
+    unsigned ii;
+
+    bd->next_mark = -1;
+    bd->next_mark_pos = (uint64_t)-1;
+    for (ii = 0; ii < bd->title->mark_list.count; ii++) {
+        uint64_t pos;
+        nav_mark_load(bd->title, &bd->title->mark_list.mark[ii]);
+        pos = (uint64_t)bd->title->mark_list.mark[ii].title_pkt * 192L;
+        if (pos > bd->s_pos) {
+            bd->next_mark = ii;
+            bd->next_mark_pos = pos;
+            _update_chapter_psr(bd);
+            return;
+        }
+    }
+
+    _update_chapter_psr(bd);
+}
+
+static void _playmark_reached(BLURAY *bd)
+{
+    BD_DEBUG(DBG_BLURAY, "PlayMark %d reached (%"PRIu64")\n", bd->next_mark, bd->next_mark_pos);
+
+    _queue_event(bd, BD_EVENT_PLAYMARK, bd->next_mark);
+    _bdj_event(bd, BDJ_EVENT_MARK, bd->next_mark);
+
+    /* update next mark */
+    bd->next_mark++;
+    if ((unsigned)bd->next_mark < bd->title->mark_list.count) {
+        nav_mark_load(bd->title, &bd->title->mark_list.mark[bd->next_mark]);
+        bd->next_mark_pos = (uint64_t)bd->title->mark_list.mark[bd->next_mark].title_pkt * 192L;
+    } else {
+        bd->next_mark = -1;
+        bd->next_mark_pos = (uint64_t)-1;
+    }
+
+    /* chapter tracking */
+    _update_chapter_psr(bd);
+}
+
+/*
+ * seeking and current position
+ */
+
+/* drop partially received PES packets */
+static void _es_reset(BLURAY *bd)
+{
+    PES_BUFFER *pes[M2TS_DEMUX_MAX_PIDS];
+    unsigned    ii;
+
+    if (bd->es_demux) {
+        m2ts_demux_multi(bd->es_demux, NULL, NULL, pes);
+        for (ii = 0; ii < bd->es_num_pids; ii++) {
+            pes_buffer_free(&pes[ii]);
+        }
+    }
+}
+
+static int _seek_internal(BLURAY *bd,
+                          NAV_CLIP *clip, uint32_t title_pkt, uint32_t clip_pkt)
+{
+    if (_seek_stream(bd, &bd->st0, clip, clip_pkt) >= 0) {
+
+        _queue_event(bd, BD_EVENT_SEEK, 0);
+
+        /* update title position */
+        bd->s_pos = (uint64_t)title_pkt * 192;
+
+        /* trick-play continues from new position */
+        bd->trick_end_pkt = 0;
+        bd->st0.rd_limit = 0;
+
+        /* playmark tracking */
+        _find_next_playmark(bd);
+
+        _es_reset(bd);
+
+        bd->still_active = 0;
+
+        /* output pacing starts from new position */
+        bd->pace_valid = 0;
+        _pace_wake(bd);
+
+        /* reset PG decoder and controller */
+        if (bd->graphics_controller) {
+            gc_run(bd->graphics_controller, GC_CTRL_PG_RESET, 0, NULL);
+
+            _init_textst_timer(bd);
+
+            _preroll_pg(bd, clip_pkt);
+        }
+
+        BD_DEBUG(DBG_BLURAY, "Seek to %"PRIu64"\n", bd->s_pos);
+        return 0;
+    }
+
+    return -1;
+}
+
+/* _change_angle() should be used only before call to _seek_internal() ! */
+static void _change_angle(BLURAY *bd)
+{
+    if (bd->seamless_angle_change) {
+        bd->st0.clip = nav_set_angle(bd->title, bd->st0.clip, bd->request_angle);
+        bd->seamless_angle_change = 0;
+        bd_psr_write(bd->regs, PSR_ANGLE_NUMBER, bd->title->angle + 1);
+
+        /* force re-opening .m2ts file in _seek_internal() */
+        _close_m2ts(&bd->st0);
+    }
+}
+
+/* fill seek info: random access point and requested time in title and stream (clip) time.
+ * Times are in 45 kHz ticks. */
+static void _seek_info(NAV_CLIP *clip, uint32_t clip_pkt, uint32_t tick, BLURAY_SEEK_INFO *info)
+{
+    uint32_t target_pts = tick - clip->title_time + clip->in_time;
+    uint32_t ep_pts     = clip->in_time;
+
+    if (clip->cl) {
+        clpi_access_point(clip->cl, clip_pkt, /*next=*/0, /*angle_change=*/0, &ep_pts);
+        /* start of play item, or EP map lookup failed */
+        if (ep_pts < clip->in_time || ep_pts > target_pts) {
+            ep_pts = clip->in_time;
+        }
+    }
+
+    info->ep_time     = (uint64_t)(clip->title_time + ep_pts - clip->in_time) * 2;
+    info->target_time = (uint64_t)tick * 2;
+    info->ep_pts      = (uint64_t)ep_pts * 2;
+    info->target_pts  = (uint64_t)target_pts * 2;
+    info->clip_ref    = clip->ref;
+}
+
+static int64_t _seek_time(BLURAY *bd, uint64_t tick, BLURAY_SEEK_INFO *info, int events)
+{
+    uint32_t clip_pkt, out_pkt;
+    NAV_CLIP *clip;
+
+    if (tick >> 33) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_seek_time(%"PRIu64") failed: invalid timestamp\n", tick);
+        return bd->s_pos;
+    }
+
+    tick /= 2;
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->title &&
+        tick < bd->title->duration) {
+
+        _change_angle(bd);
+
+        // Find the closest access unit to the requested position
+        clip = nav_time_search(bd->title, (uint32_t)tick, &clip_pkt, &out_pkt);
+
+        if (_seek_internal(bd, clip, out_pkt, clip_pkt) >= 0 && (info || events)) {
+            BLURAY_SEEK_INFO si;
+
+            _seek_info(clip, clip_pkt, (uint32_t)tick, &si);
+            si.pos = bd->s_pos;
+
+            if (events) {
+                _queue_event(bd, BD_EVENT_SEEK_EP_PTS,     (uint32_t)(si.ep_pts / 2));
+                _queue_event(bd, BD_EVENT_SEEK_TARGET_PTS, (uint32_t)(si.target_pts / 2));
+            }
+            if (info) {
+                *info = si;
+            }
+        }
+
+    } else {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_seek_time(%u) failed\n", (unsigned int)tick);
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return bd->s_pos;
+}
+
+int64_t bd_seek_time(BLURAY *bd, uint64_t tick)
+{
+    return _seek_time(bd, tick, NULL, 0);
+}
+
+int64_t bd_seek_time_ext(BLURAY *bd, uint64_t tick, BLURAY_SEEK_INFO *info)
+{
+    if (info) {
+        memset(info, 0, sizeof(*info));
+    }
+
+    return _seek_time(bd, tick, info, 1);
+}
+
+static uint64_t _tell_time(BLURAY *bd)
+{
+    uint32_t clip_pkt = 0, out_pkt = 0, out_time = 0;
+    NAV_CLIP *clip;
+
+    if (bd->title) {
+        clip = nav_packet_search(bd->title, SPN(bd->s_pos), &clip_pkt, &out_pkt, &out_time);
+        if (clip) {
+            out_time += clip->title_time;
+        }
+    }
+
+    return ((uint64_t)out_time) * 2;
+}
+
+uint64_t bd_tell_time(BLURAY *bd)
+{
+    uint64_t ret;
+
+    if (!bd) {
+        return 0;
+    }
+
+    if (bd_mutex_trylock(&bd->mutex)) {
+        /* stream is being read. Use state published when reading started. */
+        bd_rwlock_rdlock(&bd->pub.lock);
+        ret = bd->pub.time;
+        bd_rwlock_unlock(&bd->pub.lock);
+        return ret;
+    }
+
+    ret = _tell_time(bd);
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return ret;
+}
+
+int64_t bd_seek_chapter(BLURAY *bd, unsigned chapter)
+{
+    uint32_t clip_pkt, out_pkt;
+    NAV_CLIP *clip;
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->title &&
+        chapter < bd->title->chap_list.count) {
+
+        _change_angle(bd);
+
+        // Find the closest access unit to the requested position
+        clip = nav_chapter_search(bd->title, chapter, &clip_pkt, &out_pkt);
+
+        _seek_internal(bd, clip, out_pkt, clip_pkt);
+
+    } else {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_seek_chapter(%u) failed\n", chapter);
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return bd->s_pos;
+}
+
+int64_t bd_chapter_pos(BLURAY *bd, unsigned chapter)
+{
+    uint32_t clip_pkt, out_pkt;
+    int64_t ret = -1;
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->title &&
+        chapter < bd->title->chap_list.count) {
+
+        // Find the closest access unit to the requested position
+        nav_chapter_search(bd->title, chapter, &clip_pkt, &out_pkt);
+        ret = (int64_t)out_pkt * 192;
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return ret;
+}
+
+static uint32_t _current_chapter(BLURAY *bd)
+{
+    if (bd->title) {
+        return nav_chapter_get_current(bd->st0.clip, SPN(bd->st0.clip_pos));
+    }
+    return 0;
+}
+
+uint32_t bd_get_current_chapter(BLURAY *bd)
+{
+    uint32_t ret;
+
+    if (bd_mutex_trylock(&bd->mutex)) {
+        bd_rwlock_rdlock(&bd->pub.lock);
+        ret = bd->pub.chapter;
+        bd_rwlock_unlock(&bd->pub.lock);
+        return ret;
+    }
+
+    ret = _current_chapter(bd);
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return ret;
+}
+
+void bd_dump_trace(BLURAY *bd)
+{
+    if (bd) {
+        bd_trace_dump(bd->trace);
+    }
+}
+
+int bd_get_hdmv_object_stats(BLURAY *bd, unsigned object, BLURAY_HDMV_OBJECT_STATS *stats,
+                             uint32_t *insn_hits, unsigned num_hits)
+{
+    HDMV_OBJECT_STATS hs;
+    int result = 0;
+
+    if (!bd || !stats) {
+        return 0;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->hdmv_vm && hdmv_vm_get_object_stats(bd->hdmv_vm, object, &hs, insn_hits, num_hits)) {
+        stats->calls        = hs.calls;
+        stats->instructions = hs.instructions;
+        stats->time_us      = hs.time_us;
+        stats->num_cmds     = hs.num_cmds;
+        result = 1;
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return result;
+}
+
+void bd_dump_hdmv_profile(BLURAY *bd)
+{
+    if (bd) {
+        bd_mutex_lock(&bd->mutex);
+        hdmv_vm_dump_profile(bd->hdmv_vm);
+        bd_mutex_unlock(&bd->mutex);
+    }
+}
+
+int bd_decode_graphics(BLURAY *bd, uint16_t pid, uint8_t *buf, unsigned num_units)
+{
+    int result = -1;
+
+    if (!bd || !buf) {
+        return -1;
+    }
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->graphics_controller) {
+        result = gc_decode_ts(bd->graphics_controller, pid, buf, NULL, num_units, -1);
+        if (result > 0) {
+            if (IS_HDMV_PID_IG(pid)) {
+                gc_run(bd->graphics_controller, GC_CTRL_INIT_MENU, 0, NULL);
+                gc_run(bd->graphics_controller, GC_CTRL_NOP, 0, NULL);
+            } else {
+                gc_run(bd->graphics_controller, GC_CTRL_PG_UPDATE, 0, NULL);
+            }
+        }
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return result;
+}
+
+static void _get_stream_stats(BLURAY_STREAM_STATS *out, const BD_STREAM_STATS *st)
+{
+    *out = st->s;
+    out->decrypt_time = st->dec.decrypt_time;
+    out->bdplus_time  = st->dec.bdplus_time;
+}
+
+int bd_set_trick_play(BLURAY *bd, int step)
+{
+    int result = 0;
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->title) {
+        bd->trick_step    = step;
+        bd->trick_end_pkt = 0;
+        bd->st0.rd_limit  = 0;
+        result = 1;
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return result;
+}
+
+int bd_get_stats(BLURAY *bd, BLURAY_STATS *stats)
+{
+    if (!bd || !stats) {
+        return 0;
+    }
+
+    bd_mutex_lock(&bd->mutex);
+
+    memset(stats, 0, sizeof(*stats));
+    _get_stream_stats(&stats->main,    &bd->stats_main);
+    _get_stream_stats(&stats->preload, &bd->stats_preload);
+    _get_stream_stats(&stats->textst,  &bd->stats_textst);
+    if (bd->event_queue) {
+        stats->event_queue_max = bd->event_queue->max_queued;
+    }
+    if (bd->graphics_controller) {
+        GC_MEMORY_STATS gs;
+        gc_get_memory_stats(bd->graphics_controller, &gs);
+        stats->graphics.num_objects    = gs.num_objects;
+        stats->graphics.object_bytes   = gs.object_bytes;
+        stats->graphics.cache_bytes    = gs.cache_bytes;
+        stats->graphics.retained_bytes = gs.retained_bytes;
+        stats->graphics.palette_bytes  = gs.palette_bytes;
+        stats->graphics.num_evicted    = gs.num_evicted;
+        stats->graphics.num_redecoded  = gs.num_redecoded;
+    }
+    if (bd->hdmv_vm) {
+        HDMV_VM_STATS hs;
+        hdmv_vm_get_stats(bd->hdmv_vm, &hs);
+        stats->hdmv.instructions  = hs.instructions;
+        stats->hdmv.gpr_writes    = hs.gpr_writes;
+        stats->hdmv.psr_writes    = hs.psr_writes;
+        stats->hdmv.budget_yields = hs.budget_yields;
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return 1;
+}
+
+/*
+ * periodic metrics
+ */
+
+/* bd->mutex must be locked */
+static void _get_metrics_counters(BLURAY *bd, BLURAY_METRICS *m)
+{
+    const BD_STREAM_STATS *st[3] = { &bd->stats_main, &bd->stats_preload, &bd->stats_textst };
+    unsigned ii;
+
+    memset(m, 0, sizeof(*m));
+
+    for (ii = 0; ii < 3; ii++) {
+        m->bytes_read   += st[ii]->s.bytes_read;
+        m->read_calls   += st[ii]->s.read_calls;
+        m->read_errors  += st[ii]->s.read_errors;
+        m->clip_opens   += st[ii]->s.clip_opens;
+        m->decrypt_time += st[ii]->dec.decrypt_time + st[ii]->dec.bdplus_time;
+    }
+
+    m->overlay_cmds = gc_get_overlay_cmds(bd->graphics_controller);
+
+    if (bd->hdmv_vm) {
+        HDMV_VM_STATS hs;
+        hdmv_vm_get_stats(bd->hdmv_vm, &hs);
+        m->hdmv_instructions = hs.instructions;
+    }
+
+    m->bdj_events     = bd->bdj_events;
+    m->bdj_event_time = bd->bdj_event_time;
+}
+
+/* counters may restart (ex. graphics controller or HDMV VM re-created) */
+#define METRIC_DELTA(d, cur, last, f) (d)->f = (cur)->f >= (last)->f ? (cur)->f - (last)->f : (cur)->f
+
+/* report metrics if interval has elapsed. bd->mutex must be locked. */
+static void _check_metrics(BLURAY *bd)
+{
+    BD_METRICS     *m = &bd->metrics;
+    BLURAY_METRICS  cur, d;
+    uint64_t        now;
+
+    if (!m->cb) {
+        return;
+    }
+
+    now = bd_get_time_us();
+    if (now < m->last_us + m->interval_us) {
+        return;
+    }
+
+    _get_metrics_counters(bd, &cur);
+
+    memset(&d, 0, sizeof(d));
+    d.interval_us = now - m->last_us;
+    METRIC_DELTA(&d, &cur, &m->last, bytes_read);
+    METRIC_DELTA(&d, &cur, &m->last, read_calls);
+    METRIC_DELTA(&d, &cur, &m->last, read_errors);
+    METRIC_DELTA(&d, &cur, &m->last, decrypt_time);
+    METRIC_DELTA(&d, &cur, &m->last, clip_opens);
+    METRIC_DELTA(&d, &cur, &m->last, overlay_cmds);
+    METRIC_DELTA(&d, &cur, &m->last, hdmv_instructions);
+    METRIC_DELTA(&d, &cur, &m->last, bdj_events);
+    METRIC_DELTA(&d, &cur, &m->last, bdj_event_time);
+
+    if (bd->event_queue) {
+        BD_EVENT_QUEUE *eq = bd->event_queue;
+        d.event_queue_depth = ((bd_atomic_load(&eq->in) - bd_atomic_load(&eq->out)) & MAX_EVENTS) +
+                              bd_atomic_load(&eq->num_pending);
+    }
+
+    m->last    = cur;
+    m->last_us = now;
+
+    m->cb(m->handle, &d);
+}
+
+void bd_register_metrics_cb(BLURAY *bd, unsigned interval_ms, void *handle, bd_metrics_cb_f cb)
+{
+    if (!bd) {
+        return;
+    }
+
+    bd_mutex_lock(&bd->mutex);
+
+    bd->metrics.cb          = interval_ms ? cb : NULL;
+    bd->metrics.handle      = handle;
+    bd->metrics.interval_us = (uint64_t)interval_ms * 1000;
+    bd->metrics.last_us     = bd_get_time_us();
+    _get_metrics_counters(bd, &bd->metrics.last);
+
+    _update_timers(bd);
+
+    bd_mutex_unlock(&bd->mutex);
+}
+
+int bd_get_memory_usage(BLURAY *bd, BLURAY_MEMORY_USAGE *usage)
+{
+    BD_STREAM *st;
+    unsigned   ii;
+
+    if (!bd || !usage) {
+        return 0;
+    }
+
+    bd_mutex_lock(&bd->mutex);
+
+    memset(usage, 0, sizeof(*usage));
+
+    if (bd->title) {
+        usage->playlist = nav_title_memory_size(bd->title);
+    }
+
+    if (bd->title_list) {
+        usage->title_list = nav_title_list_memory_size(bd->title_list);
+    }
+    if (bd->titles) {
+        usage->title_list += (bd->disc_info.num_titles + 2) * (sizeof(BLURAY_TITLE *) + sizeof(BLURAY_TITLE));
+    }
+
+    if (bd->graphics_controller) {
+        GC_MEMORY_STATS gs;
+        gc_get_memory_stats(bd->graphics_controller, &gs);
+        usage->graphics = gs.object_bytes + gs.cache_bytes + gs.retained_bytes + gs.palette_bytes;
+        usage->textst   = gs.textst_bytes;
+    }
+
+    if (bd->event_queue) {
+        usage->event_queue = sizeof(BD_EVENT_QUEUE) + bd->event_queue->pending_size * sizeof(BD_EVENT);
+    }
+
+    st = &bd->st0;
+    if (st->rd_buf) {
+        usage->read_buffers += STREAM_READ_UNITS * 6144;
+    }
+    usage->read_buffers += read_ahead_memory_size(st->fp);
+    usage->read_buffers += read_ahead_memory_size(bd->st_next.fp);
+    for (ii = 0; ii < CLIP_HANDLE_CACHE_SIZE; ii++) {
+        usage->read_buffers += read_ahead_memory_size(bd->clip_handles[ii].fp);
+    }
+    usage->read_buffers += unit_cache_memory_size(st->cache);
+    usage->read_buffers += fanout_memory_size(bd->fanout);
+
+    usage->total = usage->playlist + usage->title_list + usage->graphics + usage->textst +
+                   usage->event_queue + usage->read_buffers;
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return 1;
+}
+
+int64_t bd_seek_playitem(BLURAY *bd, unsigned clip_ref)
+{
+    uint32_t clip_pkt, out_pkt;
+    NAV_CLIP *clip;
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->title &&
+        clip_ref < bd->title->clip_list.count) {
+
+      _change_angle(bd);
+
+      clip     = &bd->title->clip_list.clip[clip_ref];
+      nav_clip_load(clip);
+      clip_pkt = clip->start_pkt;
+      out_pkt  = clip->title_pkt;
+
+      _seek_internal(bd, clip, out_pkt, clip_pkt);
+
+    } else {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_seek_playitem(%u) failed\n", clip_ref);
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return bd->s_pos;
+}
+
+int64_t bd_seek_mark(BLURAY *bd, unsigned mark)
+{
+    uint32_t clip_pkt, out_pkt;
+    NAV_CLIP *clip;
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->title &&
+        mark < bd->title->mark_list.count) {
+
+        _change_angle(bd);
+
+        // Find the closest access unit to the requested position
+        clip = nav_mark_search(bd->title, mark, &clip_pkt, &out_pkt);
+
+        _seek_internal(bd, clip, out_pkt, clip_pkt);
+
+    } else {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_seek_mark(%u) failed\n", mark);
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return bd->s_pos;
+}
+
+int64_t bd_seek(BLURAY *bd, uint64_t pos)
+{
+    uint32_t pkt, clip_pkt, out_pkt, out_time;
+    NAV_CLIP *clip;
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->title) {
+        /* title size is known only after all clips are loaded */
+        nav_title_load(bd->title);
+    }
+
+    if (bd->title &&
+        pos < (uint64_t)bd->title->packets * 192) {
+
+        pkt = SPN(pos);
+
+        _change_angle(bd);
+
+        // Find the closest access unit to the requested position
+        clip = nav_packet_search(bd->title, pkt, &clip_pkt, &out_pkt, &out_time);
+
+        _seek_internal(bd, clip, out_pkt, clip_pkt);
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return bd->s_pos;
+}
+
+uint64_t bd_get_title_size(BLURAY *bd)
+{
+    uint64_t ret = 0;
+
+    if (!bd) {
+        return 0;
+    }
+
+    bd_mutex_lock(&bd->mutex);
+
+    if (bd->title) {
+        nav_title_load(bd->title);
+        ret = (uint64_t)bd->title->packets * 192;
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return ret;
+}
+
+uint64_t bd_tell(BLURAY *bd)
+{
+    uint64_t ret = 0;
+
+    if (!bd) {
+        return 0;
+    }
+
+    if (bd_mutex_trylock(&bd->mutex)) {
+        bd_rwlock_rdlock(&bd->pub.lock);
+        ret = bd->pub.s_pos;
+        bd_rwlock_unlock(&bd->pub.lock);
+        return ret;
+    }
+
+    ret = bd->s_pos;
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return ret;
+}
+
+static int _user_input(BLURAY *bd, int64_t pts, uint32_t key);
+static void _check_preload(BLURAY *bd);
+
+/*
+ * Called with bd->mutex locked before reading stream:
+ * run input queued while the previous read was running, and publish
+ * current position for API calls made during the read.
+ */
+static void _run_pending_input(BLURAY *bd)
+{
+    int64_t  key_pts[MAX_PENDING_KEYS];
+    uint32_t key[MAX_PENDING_KEYS];
+    unsigned num_keys, ii;
+
+    bd_rwlock_wrlock(&bd->pub.lock);
+    num_keys = bd->pub.num_keys;
+    memcpy(key_pts, bd->pub.key_pts, sizeof(key_pts[0]) * num_keys);
+    memcpy(key,     bd->pub.key,     sizeof(key[0]) * num_keys);
+    bd->pub.num_keys = 0;
+    bd_rwlock_unlock(&bd->pub.lock);
+
+    for (ii = 0; ii < num_keys; ii++) {
+        _user_input(bd, key_pts[ii], key[ii]);
+    }
+}
+
+static void _start_read(BLURAY *bd)
+{
+    uint64_t time;
+    uint32_t chapter;
+
+    _run_pending_input(bd);
+    _check_preload(bd);
+    _check_metrics(bd);
+
+    time    = _tell_time(bd);
+    chapter = _current_chapter(bd);
+
+    bd_rwlock_wrlock(&bd->pub.lock);
+    bd->pub.s_pos   = bd->s_pos;
+    bd->pub.time    = time;
+    bd->pub.chapter = chapter;
+    bd_rwlock_unlock(&bd->pub.lock);
+}
+
+/*
+ * read
+ */
+
+static int64_t _clip_seek_time(BLURAY *bd, uint32_t tick)
+{
+    uint32_t clip_pkt, out_pkt;
+
+    if (tick < bd->st0.clip->out_time) {
+
+        // Find the closest access unit to the requested position
+        nav_clip_time_search(bd->st0.clip, tick, &clip_pkt, &out_pkt);
+
+        _seek_internal(bd, bd->st0.clip, out_pkt, clip_pkt);
+    }
+
+    return bd->s_pos;
+}
+
+/*
+ * Seamless angle change point reached
+ */
+static int _seamless_angle_change(BLURAY *bd)
+{
+    BD_STREAM *st = &bd->st0;
+
+    if (SPN(st->clip_pos) >= st->clip->end_pkt) {
+        st->clip = nav_next_clip(bd->title, st->clip);
+        if (!_open_m2ts(bd, st)) {
+            return -1;
+        }
+        bd->s_pos = (uint64_t)st->clip->title_pkt * 192L;
+    } else if (bd->angle_change_target_valid) {
+        /* continue from precomputed change point of the new angle */
+        uint32_t clip_pkt = bd->angle_change_target_pkt;
+        _change_angle(bd);
+        _seek_internal(bd, st->clip, st->clip->title_pkt + clip_pkt - st->clip->start_pkt, clip_pkt);
+    } else {
+        _change_angle(bd);
+        _clip_seek_time(bd, bd->angle_change_time);
+    }
+    bd->seamless_angle_change = 0;
+
+    return 0;
+}
+
+/*
+ * End of current clip reached. Handle still mode and move to next clip.
+ * return 1 if next clip was opened, 0 if reading should stop, -1 on error.
+ */
+static int _next_clip(BLURAY *bd)
+{
+    BD_STREAM *st = &bd->st0;
+    MPLS_PI *pi = &st->clip->title->pl->play_item[st->clip->ref];
+
+    // handle still mode clips
+    if (pi->still_mode == BLURAY_STILL_INFINITE) {
+        _queue_event(bd, BD_EVENT_STILL_TIME, 0);
+        if (bd->event_queue && !bd->still_active) {
+            bd->still_active = 1;
+            bd->still_end_us = 0;
+        }
+        return 0;
+    }
+    if (pi->still_mode == BLURAY_STILL_TIME) {
+        if (bd->event_queue) {
+            _queue_event(bd, BD_EVENT_STILL_TIME, pi->still_time);
+            if (!bd->still_active) {
+                /* still timer starts when still is reached first time */
+                bd->still_active = 1;
+                bd->still_end_us = bd_get_time_us() + (uint64_t)pi->still_time * 1000000;
+                _update_timers(bd);
+            }
+            return 0;
+        }
+    }
+
+    // find next clip
+    st->clip = nav_next_clip(bd->title, st->clip);
+    if (st->clip == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_STREAM, "End of title\n");
+        _queue_event(bd, BD_EVENT_END_OF_TITLE, 0);
+        bd->end_of_playlist |= 1;
+        return 0;
+    }
+    if (!_open_m2ts(bd, st)) {
+        return -1;
+    }
+
+    if (st->clip->connection == CONNECT_NON_SEAMLESS) {
+        /* application layer demuxer buffers must be reset here */
+        _queue_event(bd, BD_EVENT_DISCONTINUITY, st->clip->in_time);
+    }
+
+    return 1;
+}
+
+/*
+ * Trick-play: jump to next random access point.
+ * return 1 if reading can continue, -1 on error.
+ */
+static int _trick_play_next(BLURAY *bd)
+{
+    BD_STREAM *st = &bd->st0;
+    NAV_CLIP  *clip;
+    uint32_t   clip_pkt, end_pkt, pts;
+    uint32_t   pos = bd->trick_end_pkt ? bd->trick_pkt : SPN(st->clip_pos);
+
+    clip = nav_keyframe_step(bd->title, st->clip, pos, bd->trick_step, &clip_pkt, &end_pkt, &pts);
+    if (!clip) {
+        /* title start / end reached: continue with normal playback */
+        BD_DEBUG(DBG_BLURAY, "trick-play: %s of title reached\n", bd->trick_step > 0 ? "end" : "start");
+        if (bd->trick_step < 0) {
+            clip = &bd->title->clip_list.clip[0];
+            _seek_internal(bd, clip, 0, clip->start_pkt);
+        }
+        bd->trick_step = 0;
+        st->rd_limit = 0;
+        return st->fp ? 1 : -1;
+    }
+
+    _seek_internal(bd, clip, clip->title_pkt + clip_pkt - clip->start_pkt, clip_pkt);
+    if (!st->fp) {
+        return -1;
+    }
+
+    /* application layer demuxer buffers must be reset here */
+    _queue_event(bd, BD_EVENT_DISCONTINUITY, pts);
+
+    bd->trick_pkt     = clip_pkt;
+    bd->trick_end_pkt = end_pkt;
+    st->rd_limit      = (uint64_t)end_pkt * 192;
+
+    return 1;
+}
+
+#define CLIP_PREFETCH_SIZE  (4*1024*1024)  /* prefetch size and distance from clip end */
+
+/*
+ * Keep read-ahead hint window in front of current read position
+ */
+static void _prefetch_current_clip(BLURAY *bd)
+{
+    BD_STREAM *st = &bd->st0;
+    uint64_t   end = (uint64_t)st->clip->end_pkt * 192;
+    uint64_t   size;
+
+    if (st->prefetch_pos > st->clip_block_pos + CLIP_PREFETCH_SIZE / 2) {
+        return;
+    }
+    if (st->prefetch_pos < st->clip_block_pos) {
+        st->prefetch_pos = st->clip_block_pos;
+    }
+    if (st->prefetch_pos >= end) {
+        return;
+    }
+
+    size = BD_MIN(end - st->prefetch_pos, CLIP_PREFETCH_SIZE);
+    file_prefetch(st->fp, st->prefetch_pos, size);
+    st->prefetch_pos += size;
+}
+
+/*
+ * Give read-ahead hint for the next clip when playback is approaching clip end
+ */
+static void _prefetch_next_clip(BLURAY *bd)
+{
+    BD_STREAM *st = &bd->st0;
+    NAV_CLIP  *next;
+
+    if (st->clip_block_pos + CLIP_PREFETCH_SIZE < (uint64_t)st->clip->end_pkt * 192) {
+        return;
+    }
+
+    next = nav_next_clip(bd->title, st->clip);
+    if (!next || next == bd->prefetch_clip) {
+        return;
+    }
+    bd->prefetch_clip = next;
+
+    _preopen_next_clip(bd, next);
+    if (bd->st_next.fp) {
+        file_prefetch(bd->st_next.fp, ((uint64_t)next->start_pkt * 192 / 6144) * 6144, CLIP_PREFETCH_SIZE);
+    } else {
+        disc_prefetch_stream(bd->disc, next->name, ((uint64_t)next->start_pkt * 192 / 6144) * 6144, CLIP_PREFETCH_SIZE);
+    }
+}
+
+/*
+ * Read next aligned unit of main path to bd->int_buf and feed internal decoders.
+ */
+static void _es_deliver(BLURAY *bd, PES_BUFFER **pes)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < bd->es_num_pids; ii++) {
+        while (pes[ii]) {
+            PES_BUFFER  *p = pes[ii];
+            BD_ES_PACKET pkt;
+
+            pkt.pid  = bd->es_pids[ii];
+            pkt.data = p->buf;
+            pkt.size = p->len;
+            pkt.pts  = (p->ts_flags & PES_HAS_PTS) ? p->pts : -1;
+            pkt.dts  = (p->ts_flags & PES_HAS_DTS) ? p->dts : -1;
+
+            bd->es_proc(bd->es_proc_handle, &pkt);
+
+            pes_buffer_next(&pes[ii]);
+        }
+    }
+}
+
+/*
+ * Map PCR to title time. PCR precedes presentation time of the data by decoder delay.
+ */
+static void _update_time_ref(BD_STREAM *st, const uint8_t *unit)
+{
+    const M2TS_UNIT_INFO *info = _unit_info(st, unit);
+
+    if (info->pcr_packet < info->num_packets) {
+        /* 33-bit difference to clip in time */
+        int64_t diff = (int64_t)((info->pcr - 2 * (uint64_t)st->clip->in_time) & 0x1ffffffffULL);
+        if (diff >= (INT64_C(1) << 32)) {
+            diff -= INT64_C(1) << 33;
+        }
+
+        st->time_ref       = 2 * (int64_t)st->clip->title_time + diff;
+        st->ats_ref        = m2ts_packet_ats(unit + 192 * info->pcr_packet);
+        st->time_ref_valid = 1;
+    }
+}
+
+/* title time (90 kHz) of packet with given arrival time stamp, -1 if not known */
+static int64_t _packet_time(const BD_STREAM *st, uint32_t ats)
+{
+    if (st->time_ref_valid) {
+        /* 30-bit difference (reference PCR may be later in the same unit) */
+        int32_t diff = (int32_t)((ats - st->ats_ref) & 0x3fffffff);
+        if (diff >= (1 << 29)) {
+            diff -= (1 << 30);
+        }
+        return st->time_ref + diff / 300;
+    }
+    return -1;
+}
+
+/* report time of next delivered packet to bd_read_timed() caller */
+static void _report_unit_time(BLURAY *bd, BD_STREAM *st, uint32_t offset)
+{
+    BD_UNIT_TIME *t;
+
+    st->unit_time_reported = 1;
+
+    if (bd->num_unit_times >= bd->max_unit_times) {
+        return;
+    }
+
+    t = &bd->unit_times[bd->num_unit_times++];
+    t->offset = offset;
+    t->ats    = m2ts_packet_ats(bd->int_buf + (st->int_buf_off / 192) * 192);
+    t->time   = _packet_time(st, t->ats);
+}
+
+/*
+ * rate-paced output
+ *
+ * Units are released when wall clock reaches their title time (relative to anchor),
+ * minus configured lead. Anchor is set at first unit with known time after start / seek,
+ * and updated from bd_set_scr() and playback rate changes.
+ *
+ * Reader waits outside of bd->mutex (it may be locked recursively, and condition
+ * variables need a mutex locked once): _bd_readv() requests the wait, and public
+ * read functions wait in _pace_wait() after releasing bd->mutex.
+ */
+
+#define PACE_MAX_DRIFT_US  1000000  /* re-anchor when this much behind or ahead of schedule */
+#define PACE_HOLD_MS       100      /* re-check interval when output is held */
+
+/* wake up waiting reader. bd->mutex must be locked. */
+static void _pace_wake(BLURAY *bd)
+{
+    bd_mutex_lock(&bd->pace_mutex);
+    bd->pace_seq++;
+    bd_cond_signal(&bd->pace_cond);
+    bd_mutex_unlock(&bd->pace_mutex);
+}
+
+/* request reader wait. bd->mutex must be locked. */
+static void _pace_request_wait(BLURAY *bd, unsigned wait_ms)
+{
+    bd->pace_wait_ms = wait_ms;
+    bd_mutex_lock(&bd->pace_mutex);
+    bd->pace_wait_seq = bd->pace_seq;
+    bd_mutex_unlock(&bd->pace_mutex);
+}
+
+/* take requested wait time. bd->mutex must be locked. */
+static unsigned _pace_take_wait(BLURAY *bd, unsigned *seq)
+{
+    unsigned wait_ms = bd->pace_wait_ms;
+
+    *seq = bd->pace_wait_seq;
+    bd->pace_wait_ms = 0;
+
+    return wait_ms;
+}
+
+/* wait until release time or pacing change. bd->mutex must not be locked. Returns 1 if read should be retried. */
+static int _pace_wait(BLURAY *bd, unsigned wait_ms, unsigned seq)
+{
+    if (!wait_ms) {
+        return 0;
+    }
+
+    bd_mutex_lock(&bd->pace_mutex);
+    if (bd->pace_seq == seq) {
+        bd_cond_timedwait(&bd->pace_cond, &bd->pace_mutex, wait_ms);
+    }
+    bd_mutex_unlock(&bd->pace_mutex);
+
+    return 1;
+}
+
+/* 0 if unit at current read position can be released, else time to wait (ms) */
+static unsigned _pace_unit(BLURAY *bd, BD_STREAM *st)
+{
+    uint32_t ats  = m2ts_packet_ats(bd->int_buf + (st->int_buf_off / 192) * 192);
+    int64_t  t    = _packet_time(st, ats);
+    int64_t  lead = (int64_t)bd->pace_lead_ms * 1000;
+    int64_t  now  = (int64_t)bd_get_time_us();
+    int64_t  due;
+
+    if (bd->pace_rate <= 0.0f) {
+        /* paused */
+        return PACE_HOLD_MS;
+    }
+
+    if (t < 0) {
+        /* no PCR seen yet (start of playback or after seek) */
+        return 0;
+    }
+
+    if (!bd->pace_valid) {
+        bd->pace_wall  = (uint64_t)now;
+        bd->pace_time  = t;
+        bd->pace_valid = 1;
+    }
+
+    due = (int64_t)bd->pace_wall + (int64_t)((t - bd->pace_time) * 1000 / 90 / (double)bd->pace_rate) - lead;
+
+    if (due < now - lead - PACE_MAX_DRIFT_US || due > now + PACE_MAX_DRIFT_US) {
+        /* reader stalled or timestamp discontinuity */
+        BD_DEBUG_HOT(DBG_STREAM, "output pacing: re-anchoring (%"PRId64" us off)\n", due - now);
+        bd->pace_wall = (uint64_t)now;
+        bd->pace_time = t;
+        return 0;
+    }
+
+    if (due <= now) {
+        return 0;
+    }
+
+    return (unsigned)((due - now + 999) / 1000);
+}
+
+/* update pacing anchor from presentation time of player */
+static void _pace_set_scr(BLURAY *bd, int64_t pts)
+{
+    const NAV_CLIP *clip = bd->st0.clip;
+    int64_t diff;
+
+    if (!bd->pace_lead_ms || !clip) {
+        return;
+    }
+
+    /* 33-bit difference to clip in time */
+    diff = (int64_t)(((uint64_t)pts - 2 * (uint64_t)clip->in_time) & 0x1ffffffffULL);
+    if (diff > 2 * (int64_t)(clip->out_time - clip->in_time)) {
+        /* player is still presenting previous clip */
+        return;
+    }
+
+    bd->pace_wall  = bd_get_time_us();
+    bd->pace_time  = 2 * (int64_t)clip->title_time + diff;
+    bd->pace_valid = 1;
+    _pace_wake(bd);
+}
+
+static int _read_main_unit(BLURAY *bd)
+{
+    BD_STREAM *st = &bd->st0;
+
+    int r = _read_unit(bd, st, &bd->int_buf);
+    if (r > 0) {
+
+        st->unit_time_reported = 0;
+        st->unit_paced = 0;
+        if (bd->unit_timing || bd->pace_lead_ms) {
+            _update_time_ref(st, bd->int_buf);
+        }
+
+        if (st->ig_pid > 0 || st->pg_pid > 0) {
+            uint64_t t0 = bd_get_time_us();
+            uint16_t pg_pid = st->pg_pid;
+            int      decoded = 0;
+
+            /* hand PG stream to decoding thread */
+            if (pg_pid > 0 && gc_decode_pg_async(bd->graphics_controller, pg_pid,
+                                                 bd->int_buf, _unit_info(st, bd->int_buf)) >= 0) {
+                pg_pid = 0;
+            }
+
+            if (st->ig_pid > 0 || pg_pid > 0) {
+                decoded = gc_decode_unit(bd->graphics_controller, st->ig_pid, pg_pid,
+                                         bd->int_buf, _unit_info(st, bd->int_buf), -1);
+            }
+            st->stats->s.decode_time += bd_get_time_us() - t0;
+            if (decoded > 0 && (decoded & GC_DECODE_IG)) {
+                /* initialize menus */
+                _run_gc(bd, GC_CTRL_INIT_MENU, 0);
+            }
+            if (decoded > 0 && (decoded & GC_DECODE_PG)) {
+                /* render subtitles */
+                gc_run(bd->graphics_controller, GC_CTRL_PG_UPDATE, 0, NULL);
+            }
+        }
+        if (bd->es_demux) {
+            PES_BUFFER *pes[M2TS_DEMUX_MAX_PIDS];
+            if (m2ts_demux_multi(bd->es_demux, bd->int_buf, _unit_info(st, bd->int_buf), pes) >= 0) {
+                _es_deliver(bd, pes);
+            }
+        }
+        if (bd->st_textst.clip) {
+            _update_textst_timer(bd);
+        }
+
+        _prefetch_current_clip(bd);
+        _prefetch_next_clip(bd);
+
+        st->int_buf_off = st->clip_pos % 6144;
+    }
+
+    return r;
+}
+
+/* next clip continues current one without discontinuity (no still, seamless connection) */
+static int _seamless_next_clip(BLURAY *bd)
+{
+    NAV_CLIP *clip = bd->st0.clip;
+    NAV_CLIP *next;
+
+    if (clip->title->pl->play_item[clip->ref].still_mode != BLURAY_STILL_NONE) {
+        return 0;
+    }
+    next = nav_next_clip(bd->title, clip);
+    return next && next->connection == CONNECT_SEAMLESS;
+}
+
+/*
+ * Read to caller buffers.
+ * Read is split at clip boundary and trick-play jump, not at buffer boundaries.
+ * With BLURAY_PLAYER_SETTING_CONTINUOUS_READ seamless clip boundaries are not split.
+ */
+static int _bd_readv(BLURAY *bd, const BD_IOVEC *iov, unsigned iovcnt)
+{
+    BD_STREAM *st = &bd->st0;
+    unsigned   iov_idx = 0;
+    size_t     iov_off = 0;
+    int        out_len;
+    int        len = 0;
+
+    for (iov_idx = 0; iov_idx < iovcnt; iov_idx++) {
+        len = (int)BD_MIN((size_t)len + iov[iov_idx].len, (size_t)0x7fffffff);
+    }
+    iov_idx = 0;
+
+    if (st->fp) {
+        out_len = 0;
+        BD_TRACE(bd->trace, BD_TRACE_READ, bd->s_pos, (uint32_t)len);
+
+        while (len > 0) {
+            uint32_t     clip_pkt, new_clip_pkt;
+            unsigned int size;
+            int          r;
+
+            /* skip filled (and empty) buffers */
+            while (iov_off >= iov[iov_idx].len) {
+                iov_idx++;
+                iov_off = 0;
+            }
+
+            size = (unsigned int)BD_MIN((size_t)len, iov[iov_idx].len - iov_off);
+            // Do we need to read more data?
+            clip_pkt = SPN(st->clip_pos);
+            if (bd->seamless_angle_change) {
+                if (clip_pkt >= bd->angle_change_pkt) {
+                    if (_seamless_angle_change(bd) < 0) {
+                        return -1;
+                    }
+                } else {
+                    uint64_t angle_pos;
+
+                    angle_pos = (uint64_t)bd->angle_change_pkt * 192L;
+                    if (angle_pos - st->clip_pos < size) {
+                        size = (unsigned int)(angle_pos - st->clip_pos);
+                    }
+                }
+            }
+            if (st->clip == NULL) {
+                // We previously reached the last clip.  Nothing
+                // else to read.
+                _queue_event(bd, BD_EVENT_END_OF_TITLE, 0);
+                bd->end_of_playlist |= 1;
+                return 0;
+            }
+            if (bd->trick_step && clip_pkt >= bd->trick_end_pkt) {
+
+                // split read()'s at trick-play jump
+                if (out_len) {
+                    return out_len;
+                }
+                if (_trick_play_next(bd) < 0) {
+                    return -1;
+                }
+                clip_pkt = SPN(st->clip_pos);
+                size = (unsigned int)BD_MIN((size_t)len, iov[iov_idx].len - iov_off);
+            }
+            if (st->int_buf_off == 6144 || clip_pkt >= st->clip->end_pkt) {
+
+                // Do we need to get the next clip?
+                if (clip_pkt >= st->clip->end_pkt) {
+
+                    // split read()'s at clip boundary
+                    if (out_len && !(bd->continuous_read && _seamless_next_clip(bd))) {
+                        return out_len;
+                    }
+
+                    r = _next_clip(bd);
+                    if (r <= 0) {
+                        return out_len ? out_len : r;
+                    }
+                    if (out_len) {
+                        _queue_event(bd, BD_EVENT_SEAMLESS_CLIP, out_len);
+                    }
+                }
+
+                r = _read_main_unit(bd);
+                if (r == 0) {
+                    /* recoverable error (EOF, broken block) */
+                    return out_len;
+                } else if (r < 0) {
+                    /* fatal error */
+                    return -1;
+                }
+            }
+            if (size > (unsigned int)6144 - st->int_buf_off) {
+                size = 6144 - st->int_buf_off;
+            }
+
+            /* cut read at clip end packet */
+            new_clip_pkt = SPN(st->clip_pos + size);
+            if (new_clip_pkt > st->clip->end_pkt) {
+                BD_DEBUG_HOT(DBG_STREAM, "cut %d bytes at end of block\n", (new_clip_pkt - st->clip->end_pkt) * 192);
+                size -= (new_clip_pkt - st->clip->end_pkt) * 192;
+            }
+
+            if (bd->pace_lead_ms && !st->unit_paced) {
+                unsigned wait_ms = _pace_unit(bd, st);
+                if (wait_ms) {
+                    // split read()'s at units not yet due
+                    if (out_len) {
+                        return out_len;
+                    }
+                    /* caller waits without bd->mutex and retries (stream may be seeked or closed meanwhile) */
+                    _pace_request_wait(bd, wait_ms);
+                    return 0;
+                }
+                st->unit_paced = 1;
+            }
+
+            if (bd->unit_times && !st->unit_time_reported) {
+                _report_unit_time(bd, st, (uint32_t)out_len);
+            }
+
+            /* copy chunk */
+            memcpy((uint8_t *)iov[iov_idx].base + iov_off, bd->int_buf + st->int_buf_off, size);
+            iov_off += size;
+            len -= size;
+            out_len += size;
+            st->clip_pos += size;
+            st->int_buf_off += size;
+            bd->s_pos += size;
+        }
+
+        /* mark tracking */
+        if (bd->next_mark >= 0 && bd->s_pos > bd->next_mark_pos) {
+            _playmark_reached(bd);
+        }
+
+        return out_len;
+    }
+
+    BD_DEBUG(DBG_STREAM | DBG_CRIT, "bd_read(): no valid title selected!\n");
+
+    return -1;
+}
+
+static int _bd_read(BLURAY *bd, unsigned char *buf, int len)
+{
+    BD_IOVEC iov;
+
+    iov.base = buf;
+    iov.len  = len > 0 ? (size_t)len : 0;
+
+    return _bd_readv(bd, &iov, 1);
+}
+
+/*
+ * Zero-copy read of whole aligned units from the stream read buffer.
+ * Stops at clip boundary, seamless angle change point and end of read buffer.
+ */
+static int _bd_read_units(BLURAY *bd, BLURAY_UNITS *units, unsigned max_units)
+{
+    BD_STREAM *st = &bd->st0;
+    unsigned   num_units = 0;
+    int        r;
+
+    if (!st->fp) {
+        BD_DEBUG(DBG_STREAM | DBG_CRIT, "bd_read_units(): no valid title selected!\n");
+        return -1;
+    }
+    if (st->int_buf_off != 6144 && SPN(st->clip_pos) < st->clip->end_pkt) {
+        BD_DEBUG(DBG_STREAM | DBG_CRIT, "bd_read_units(): partial unit pending (mixed with bd_read() ?)\n");
+        return -1;
+    }
+
+    while (num_units < max_units) {
+        uint32_t clip_pkt = SPN(st->clip_pos);
+        uint32_t size;
+
+        if (bd->seamless_angle_change && clip_pkt >= bd->angle_change_pkt) {
+            if (num_units) {
+                break;
+            }
+            if (_seamless_angle_change(bd) < 0) {
+                return -1;
+            }
+            clip_pkt = SPN(st->clip_pos);
+        }
+        if (st->clip == NULL) {
+            _queue_event(bd, BD_EVENT_END_OF_TITLE, 0);
+            bd->end_of_playlist |= 1;
+            break;
+        }
+        if (bd->trick_step && clip_pkt >= bd->trick_end_pkt) {
+            if (num_units) {
+                break;
+            }
+            if (_trick_play_next(bd) < 0) {
+                return -1;
+            }
+            clip_pkt = SPN(st->clip_pos);
+        }
+        if (clip_pkt >= st->clip->end_pkt) {
+            if (num_units) {
+                break;
+            }
+            r = _next_clip(bd);
+            if (r <= 0) {
+                return r;
+            }
+        }
+
+        /* units must be contiguous in the same buffer.
+         * Stop before anything that refills it (buffer exhausted, damaged area recovery). */
+        if (num_units && (st->rd_buf_off >= st->rd_buf_len || st->rd_err.active)) {
+            break;
+        }
+
+        r = _read_main_unit(bd);
+        if (r < 0 && !num_units) {
+            return -1;
+        }
+        if (r <= 0) {
+            break;
+        }
+
+        if (!num_units) {
+            /* hand out reference to stream buffer. It must not be refilled in place from now on. */
+            bd_refcnt_inc(st->rd_buf);
+            st->rd_buf_shared = 1;
+            units->buffer = st->rd_buf;
+            units->data   = bd->int_buf;
+        }
+        num_units++;
+
+        /* whole unit is consumed. Do not count data after clip end packet to title position. */
+        size = 6144 - st->int_buf_off;
+        if (SPN(st->clip_pos + size) > st->clip->end_pkt) {
+            size -= (SPN(st->clip_pos + size) - st->clip->end_pkt) * 192;
+        }
+        st->clip_pos = st->clip_block_pos;
+        st->int_buf_off = 6144;
+        bd->s_pos += size;
+    }
+
+    if (num_units) {
+        units->num_units = num_units;
+
+        /* mark tracking */
+        if (bd->next_mark >= 0 && bd->s_pos > bd->next_mark_pos) {
+            _playmark_reached(bd);
         }
-        return res;
-    } else {
-        return bd_gpr_write(bd->regs, reg, value);
     }
-}
-#endif
 
-#ifdef USING_BDJAVA
-BD_ARGB_BUFFER *bd_lock_osd_buffer(BLURAY *bd)
-{
-    bd_mutex_lock(&bd->argb_buffer_mutex);
-    return bd->argb_buffer;
+    return num_units;
 }
 
-void bd_unlock_osd_buffer(BLURAY *bd)
+int bd_read(BLURAY *bd, unsigned char *buf, int len)
 {
-    bd_mutex_unlock(&bd->argb_buffer_mutex);
+    int      result;
+    unsigned wait_ms, seq;
+
+    do {
+        bd_mutex_lock(&bd->mutex);
+        _start_read(bd);
+        result  = _bd_read(bd, buf, len);
+        wait_ms = _pace_take_wait(bd, &seq);
+        bd_mutex_unlock(&bd->mutex);
+    } while (!result && _pace_wait(bd, wait_ms, seq));
+
+    return result;
 }
 
-/*
- * handle graphics updates from BD-J layer
- */
-void bd_bdj_osd_cb(BLURAY *bd, const unsigned *img, int w, int h,
-                   int x0, int y0, int x1, int y1)
+int bd_readv(BLURAY *bd, const BD_IOVEC *iov, unsigned iovcnt)
 {
-    BD_ARGB_OVERLAY aov;
+    int      result;
+    unsigned wait_ms, seq;
 
-    if (!bd->argb_overlay_proc) {
-        _queue_event(bd, BD_EVENT_MENU, 0);
-        return;
+    if (!iov && iovcnt) {
+        return -1;
     }
 
-    memset(&aov, 0, sizeof(aov));
-    aov.pts   = -1;
-    aov.plane = BD_OVERLAY_IG;
+    do {
+        bd_mutex_lock(&bd->mutex);
+        _start_read(bd);
+        result  = _bd_readv(bd, iov, iovcnt);
+        wait_ms = _pace_take_wait(bd, &seq);
+        bd_mutex_unlock(&bd->mutex);
+    } while (!result && _pace_wait(bd, wait_ms, seq));
 
-    /* no image data -> init or close */
-    if (!img) {
-        if (w > 0 && h > 0) {
-            aov.cmd = BD_ARGB_OVERLAY_INIT;
-            aov.w   = w;
-            aov.h   = h;
-            _queue_event(bd, BD_EVENT_MENU, 1);
-        } else {
-            aov.cmd = BD_ARGB_OVERLAY_CLOSE;
-            _queue_event(bd, BD_EVENT_MENU, 0);
-        }
+    return result;
+}
 
-        bd->argb_overlay_proc(bd->argb_overlay_proc_handle, &aov);
-        return;
-    }
+int bd_read_timed(BLURAY *bd, unsigned char *buf, int len, BD_UNIT_TIME *times, unsigned *num_times)
+{
+    int      result;
+    unsigned max_times, wait_ms, seq;
 
-    /* no changed pixels ? */
-    if (x1 < x0 || y1 < y0) {
-        return;
+    if (!num_times || (*num_times && !times)) {
+        return -1;
     }
+    max_times = *num_times;
 
-    /* pass only changed region */
-    if (bd->argb_buffer && (bd->argb_buffer->width < w || bd->argb_buffer->height < h)) {
-        aov.argb   = img;
-    } else {
-        aov.argb   = img + x0 + y0 * w;
-    }
-    aov.stride = w;
-    aov.x      = x0;
-    aov.y      = y0;
-    aov.w      = x1 - x0 + 1;
-    aov.h      = y1 - y0 + 1;
+    do {
+        bd_mutex_lock(&bd->mutex);
+        _start_read(bd);
 
-    if (bd->argb_buffer) {
-        /* set dirty region */
-        bd->argb_buffer->dirty[BD_OVERLAY_IG].x0 = x0;
-        bd->argb_buffer->dirty[BD_OVERLAY_IG].x1 = x1;
-        bd->argb_buffer->dirty[BD_OVERLAY_IG].y0 = y0;
-        bd->argb_buffer->dirty[BD_OVERLAY_IG].y1 = y1;
-    }
+        /* PCR is tracked from now on */
+        bd->unit_timing = 1;
 
-    /* draw */
-    aov.cmd = BD_ARGB_OVERLAY_DRAW;
-    bd->argb_overlay_proc(bd->argb_overlay_proc_handle, &aov);
+        bd->unit_times     = times;
+        bd->max_unit_times = max_times;
+        bd->num_unit_times = 0;
 
-    /* commit changes */
-    aov.cmd = BD_ARGB_OVERLAY_FLUSH;
-    bd->argb_overlay_proc(bd->argb_overlay_proc_handle, &aov);
+        /* first chunk may continue unit from previous read */
+        bd->st0.unit_time_reported = 0;
 
-    if (bd->argb_buffer) {
-        /* reset dirty region */
-        bd->argb_buffer->dirty[BD_OVERLAY_IG].x0 = bd->argb_buffer->width;
-        bd->argb_buffer->dirty[BD_OVERLAY_IG].x1 = bd->argb_buffer->height;
-        bd->argb_buffer->dirty[BD_OVERLAY_IG].y0 = 0;
-        bd->argb_buffer->dirty[BD_OVERLAY_IG].y1 = 0;
-    }
-}
-#endif
+        result = _bd_read(bd, buf, len);
 
-static int _start_bdj(BLURAY *bd, unsigned title)
-{
-#ifdef USING_BDJAVA
-    if (bd->bdjava == NULL) {
-        const char *root = disc_root(bd->disc);
-        bd->bdjava = bdj_open(root, bd, bd->disc_info.bdj_disc_id, &bd->bdjstorage);
-        if (!bd->bdjava) {
-            return 0;
-        }
-    }
+        *num_times     = bd->num_unit_times;
+        bd->unit_times = NULL;
 
-    memset(&bd->bdj_uo_mask, 0, sizeof(BD_UO_MASK));
+        wait_ms = _pace_take_wait(bd, &seq);
+        bd_mutex_unlock(&bd->mutex);
+    } while (!result && _pace_wait(bd, wait_ms, seq));
 
-    return !bdj_process_event(bd->bdjava, BDJ_EVENT_START, title);
-#else
-    (void)bd;
-    BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Title %d: BD-J not compiled in\n", title);
-    return 0;
-#endif
+    return result;
 }
 
-#ifdef USING_BDJAVA
-static int _bdj_event(BLURAY *bd, unsigned ev, unsigned param)
+int bd_read_async(BLURAY *bd, unsigned char *buf, int len, bd_read_cb_f func, void *ctx)
 {
-    if (bd->bdjava != NULL) {
-        return bdj_process_event(bd->bdjava, ev, param);
+    if (!bd || !buf || len <= 0) {
+        return 0;
     }
-    return -1;
-}
-#else
-#define _bdj_event(bd, ev, param) do{}while(0)
-#endif
 
-#ifdef USING_BDJAVA
-static void _stop_bdj(BLURAY *bd)
-{
-    if (bd->bdjava != NULL) {
-        bdj_process_event(bd->bdjava, BDJ_EVENT_STOP, 0);
-        _queue_event(bd, BD_EVENT_STILL, 0);
-    }
+    return async_reader_submit(bd->async_reader, buf, len, func, ctx);
 }
-#else
-#define _stop_bdj(bd) do{}while(0)
-#endif
 
-#ifdef USING_BDJAVA
-static void _close_bdj(BLURAY *bd)
+int bd_get_read_async_fd(BLURAY *bd)
 {
-    if (bd->bdjava != NULL) {
-        bdj_close(bd->bdjava);
-        bd->bdjava = NULL;
-    }
+    return bd ? async_reader_fd(bd->async_reader) : -1;
 }
-#else
-#define _close_bdj(bd) do{}while(0)
-#endif
 
-#ifdef USING_BDJAVA
-static void _storage_free(BLURAY *bd)
+int bd_dispatch_read_async(BLURAY *bd)
 {
-    X_FREE(bd->bdjstorage.cache_root);
-    X_FREE(bd->bdjstorage.persistent_root);
-    X_FREE(bd->bdjstorage.classpath);
+    return bd ? async_reader_dispatch(bd->async_reader) : 0;
 }
-#else
-#define _storage_free(bd) do{}while(0)
-#endif
-
-/*
- * open / close
- */
 
-BLURAY *bd_init(void)
+int bd_fanout_start(BLURAY *bd, unsigned num_readers, unsigned ring_units)
 {
-    BD_DEBUG(DBG_BLURAY, "libbluray version "BLURAY_VERSION_STRING"\n");
-
-    BLURAY *bd = calloc(1, sizeof(BLURAY));
-
-    if (!bd) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Can't allocate memory\n");
-        return NULL;
-    }
-
-    bd->regs = bd_registers_init();
-    if (!bd->regs) {
-        BD_DEBUG(DBG_BLURAY, "bd_registers_init() failed\n");
-        X_FREE(bd);
-        return NULL;
+    if (!bd || bd->fanout || !bd->st0.fp) {
+        return 0;
     }
 
-    bd_mutex_init(&bd->mutex);
-#ifdef USING_BDJAVA
-    bd_mutex_init(&bd->argb_buffer_mutex);
-#endif
-
-    BD_DEBUG(DBG_BLURAY, "BLURAY initialized!\n");
+    bd->fanout = fanout_init(_stream_read, bd, num_readers,
+                             BD_MIN(ring_units, bd->low_memory ? LOW_MEM_FANOUT_UNITS : FANOUT_MAX_UNITS) * 6144);
 
-    return bd;
+    return bd->fanout ? 1 : 0;
 }
 
-static int _bd_open(BLURAY *bd,
-                    const char *device_path, const char *keyfile_path,
-                    void *read_blocks_handle,
-                    int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks))
+int bd_fanout_read(BLURAY *bd, unsigned reader, unsigned char *buf, int len)
 {
-    BD_ENC_INFO enc_info;
+    return bd ? fanout_read(bd->fanout, reader, buf, len) : -1;
+}
 
-    if (!bd) {
-        return 0;
+void bd_fanout_detach(BLURAY *bd, unsigned reader)
+{
+    if (bd) {
+        fanout_detach(bd->fanout, reader);
     }
-    if (bd->disc) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Disc already open\n");
-        return 0;
+}
+
+void bd_fanout_stop(BLURAY *bd)
+{
+    if (bd) {
+        fanout_free(&bd->fanout);
     }
+}
 
-    bd->disc = disc_open(device_path, read_blocks_handle, read_blocks,
-                         &enc_info, keyfile_path,
-                         (void*)bd->regs, (void*)bd_psr_read, (void*)bd_psr_write);
+int bd_read_units(BLURAY *bd, BLURAY_UNITS *units, unsigned max_units)
+{
+    int result;
 
-    if (!bd->disc) {
-        return 0;
-    }
+    memset(units, 0, sizeof(*units));
 
-    _fill_disc_info(bd, &enc_info);
+    bd_mutex_lock(&bd->mutex);
+    _start_read(bd);
+    result = _bd_read_units(bd, units, max_units);
+    bd_mutex_unlock(&bd->mutex);
 
-    return bd->disc_info.bluray_detected;
+    return result;
 }
 
-int bd_open_disc(BLURAY *bd, const char *device_path, const char *keyfile_path)
+void bd_release_units(BLURAY_UNITS *units)
 {
-    if (!device_path) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "No device path provided!\n");
-        return 0;
+    if (units) {
+        bd_refcnt_dec(units->buffer);
+        memset(units, 0, sizeof(*units));
     }
-
-    return _bd_open(bd, device_path, keyfile_path, NULL, NULL);
 }
 
-int bd_open_stream(BLURAY *bd,
-                   void *read_blocks_handle,
-                   int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks))
+static int _skip_still(BLURAY *bd)
 {
-    if (!read_blocks) {
-        return 0;
+    BD_STREAM *st = &bd->st0;
+    int ret = 0;
+
+    if (st->clip) {
+        MPLS_PI *pi = &st->clip->title->pl->play_item[st->clip->ref];
+
+        if (pi->still_mode == BLURAY_STILL_TIME) {
+            bd->still_active = 0;
+            st->clip = nav_next_clip(bd->title, st->clip);
+            if (st->clip) {
+                ret = _open_m2ts(bd, st);
+            }
+        }
     }
 
-    return _bd_open(bd, NULL, NULL, read_blocks_handle, read_blocks);
+    return ret;
 }
 
-BLURAY *bd_open(const char *device_path, const char *keyfile_path)
+int bd_read_skip_still(BLURAY *bd)
 {
-    BLURAY *bd;
+    int ret;
 
-    bd = bd_init();
-    if (!bd) {
-        return NULL;
-    }
+    bd_mutex_lock(&bd->mutex);
+    ret = _skip_still(bd);
+    bd_mutex_unlock(&bd->mutex);
 
-    bd_open_disc(bd, device_path, keyfile_path);
+    /* release bd_wait_still() */
+    _wake_event_waiter(bd);
 
-    return bd;
+    return ret;
 }
 
-void bd_close(BLURAY *bd)
+static void _timer_expired(void *handle, unsigned id)
 {
-    _close_bdj(bd);
+    BLURAY *bd   = (BLURAY *)handle;
+    int     wake = 0;
 
-    _close_m2ts(&bd->st0);
-    _close_preload(&bd->st_ig);
-    _close_preload(&bd->st_textst);
+    bd_mutex_lock(&bd->mutex);
 
-    if (bd->title_list != NULL) {
-        nav_free_title_list(bd->title_list);
-    }
-    if (bd->title != NULL) {
-        nav_title_close(bd->title);
+    switch (id) {
+        case TIMER_GC:
+            if (bd->title_type == title_hdmv) {
+                /* overlays are updated from this thread */
+                _run_gc(bd, GC_CTRL_NOP, 0);
+                /* button timeout may have started navigation commands */
+                wake = !bd->hdmv_suspended;
+            }
+            break;
+        case TIMER_STILL:
+            if (bd->still_active && bd->still_end_us && bd_get_time_us() >= bd->still_end_us) {
+                _skip_still(bd);
+                wake = 1;
+            }
+            break;
+        case TIMER_METRICS:
+            _check_metrics(bd);
+            break;
     }
 
-    hdmv_vm_free(&bd->hdmv_vm);
-
-    gc_free(&bd->graphics_controller);
-    meta_free(&bd->meta);
-    sound_free(&bd->sound_effects);
-    bd_registers_free(bd->regs);
-
-    _free_event_queue(bd);
-    array_free((void**)&bd->titles);
-    _storage_free(bd);
-
-    disc_close(&bd->disc);
-
-    bd_mutex_destroy(&bd->mutex);
-#ifdef USING_BDJAVA
-    bd_mutex_destroy(&bd->argb_buffer_mutex);
-#endif
+    _update_timers(bd);
 
-    BD_DEBUG(DBG_BLURAY, "BLURAY destroyed!\n");
+    bd_mutex_unlock(&bd->mutex);
 
-    X_FREE(bd);
+    if (wake) {
+        _wake_event_waiter(bd);
+    }
 }
 
-/*
- * PlayMark tracking
- */
-
-static void _find_next_playmark(BLURAY *bd)
+int bd_wait_still(BLURAY *bd, unsigned timeout_ms)
 {
-    unsigned ii;
+    BD_EVENT_QUEUE *eq = bd->event_queue;
+    uint64_t        end_us, now;
+    int             still;
 
-    bd->next_mark = -1;
-    bd->next_mark_pos = (uint64_t)-1;
-    for (ii = 0; ii < bd->title->mark_list.count; ii++) {
-        uint64_t pos = (uint64_t)bd->title->mark_list.mark[ii].title_pkt * 192L;
-        if (pos > bd->s_pos) {
-            bd->next_mark = ii;
-            bd->next_mark_pos = pos;
-            _update_chapter_psr(bd);
-            return;
-        }
+    bd_mutex_lock(&bd->mutex);
+    still  = bd->still_active;
+    end_us = bd->still_end_us;
+    bd_mutex_unlock(&bd->mutex);
+
+    if (!still || !eq) {
+        return -1;
     }
 
-    _update_chapter_psr(bd);
-}
+    now = bd_get_time_us();
+    if (end_us && end_us > now) {
+        timeout_ms = (unsigned)BD_MIN((uint64_t)timeout_ms, (end_us - now + 999) / 1000);
+    }
 
-static void _playmark_reached(BLURAY *bd)
-{
-    BD_DEBUG(DBG_BLURAY, "PlayMark %d reached (%"PRIu64")\n", bd->next_mark, bd->next_mark_pos);
+    if (!end_us || end_us > now) {
+        bd_mutex_lock(&eq->mutex);
+        bd_atomic_store(&eq->waiting, 1);
+        bd_atomic_fence();
+        if (!eq->wakeup && bd_atomic_load(&eq->out) == bd_atomic_load(&eq->in) && timeout_ms) {
+            bd_cond_timedwait(&eq->cond, &eq->mutex, timeout_ms);
+        }
+        eq->wakeup = 0;
+        bd_atomic_store(&eq->waiting, 0);
+        bd_mutex_unlock(&eq->mutex);
+    }
 
-    _queue_event(bd, BD_EVENT_PLAYMARK, bd->next_mark);
-    _bdj_event(bd, BDJ_EVENT_MARK, bd->next_mark);
+    if (!end_us || bd_get_time_us() < end_us) {
+        return 0;
+    }
 
-    /* update next mark */
-    bd->next_mark++;
-    if ((unsigned)bd->next_mark < bd->title->mark_list.count) {
-        bd->next_mark_pos = (uint64_t)bd->title->mark_list.mark[bd->next_mark].title_pkt * 192L;
-    } else {
-        bd->next_mark = -1;
-        bd->next_mark_pos = (uint64_t)-1;
+    /* still time elapsed: continue playback */
+    bd_mutex_lock(&bd->mutex);
+    if (bd->still_active && bd->still_end_us == end_us) {
+        _skip_still(bd);
     }
+    bd_mutex_unlock(&bd->mutex);
 
-    /* chapter tracking */
-    _update_chapter_psr(bd);
+    return 1;
 }
 
 /*
- * seeking and current position
+ * synchronous sub paths
  */
 
-static void _seek_internal(BLURAY *bd,
-                           NAV_CLIP *clip, uint32_t title_pkt, uint32_t clip_pkt)
+static void _init_textst_subpath(BLURAY *bd)
 {
-    if (_seek_stream(bd, &bd->st0, clip, clip_pkt) >= 0) {
-
-        _queue_event(bd, BD_EVENT_SEEK, 0);
-
-        /* update title position */
-        bd->s_pos = (uint64_t)title_pkt * 192;
-
-        /* playmark tracking */
-        _find_next_playmark(bd);
-
-        /* reset PG decoder and controller */
-        if (bd->graphics_controller) {
-            gc_run(bd->graphics_controller, GC_CTRL_PG_RESET, 0, NULL);
+    unsigned ii;
 
-            _init_textst_timer(bd);
+    /* set fonts and encoding from clip info */
+    gc_add_font(bd->graphics_controller, NULL, -1);
+    for (ii = 0; ii < bd->st_textst.clip->cl->font_info.font_count; ii++) {
+        char file[10];
+        uint8_t *data = NULL;
+        size_t size;
+        memcpy(file, bd->st_textst.clip->cl->font_info.font[ii].file_id, 5);
+        memcpy(&file[5], ".otf", 5);
+        size = disc_read_file(bd->disc, "BDMV" DIR_SEP "AUXDATA", file, &data);
+        if (data && size > 0 && gc_add_font(bd->graphics_controller, data, size) < 0) {
+            X_FREE(data);
         }
-
-        BD_DEBUG(DBG_BLURAY, "Seek to %"PRIu64"\n", bd->s_pos);
     }
+    gc_run(bd->graphics_controller, GC_CTRL_PG_CHARCODE, bd->st_textst.char_code, NULL);
+
+    /* start presentation timer */
+    _init_textst_timer(bd);
 }
 
-/* _change_angle() should be used only before call to _seek_internal() ! */
-static void _change_angle(BLURAY *bd)
+static int _preload_textst_subpath(BLURAY *bd)
 {
-    if (bd->seamless_angle_change) {
-        bd->st0.clip = nav_set_angle(bd->title, bd->st0.clip, bd->request_angle);
-        bd->seamless_angle_change = 0;
-        bd_psr_write(bd->regs, PSR_ANGLE_NUMBER, bd->title->angle + 1);
+    uint8_t        char_code      = BLURAY_TEXT_CHAR_CODE_UTF8;
+    int            textst_subpath = -1;
+    unsigned       textst_subclip = 0;
+    uint16_t       textst_pid     = 0;
 
-        /* force re-opening .m2ts file in _seek_internal() */
-        _close_m2ts(&bd->st0);
+    if (!bd->graphics_controller) {
+        return 0;
     }
-}
 
-int64_t bd_seek_time(BLURAY *bd, uint64_t tick)
-{
-    uint32_t clip_pkt, out_pkt;
-    NAV_CLIP *clip;
+    if (!bd->decode_pg || !bd->title) {
+        return 0;
+    }
 
-    if (tick >> 33) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_seek_time(%"PRIu64") failed: invalid timestamp\n", tick);
-        return bd->s_pos;
+    _find_pg_stream(bd, &textst_pid, &textst_subpath, &textst_subclip, &char_code);
+    if (textst_subpath < 0) {
+        return 0;
     }
 
-    tick /= 2;
+    if (textst_subclip >= bd->title->sub_path[textst_subpath].clip_list.count) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_textst_subpath(): invalid subclip id\n");
+        return -1;
+    }
 
-    bd_mutex_lock(&bd->mutex);
+    if (bd->st_textst.clip == &bd->title->sub_path[textst_subpath].clip_list.clip[textst_subclip]) {
+        BD_DEBUG(DBG_BLURAY, "_preload_textst_subpath(): subpath already loaded");
+        return 1;
+    }
 
-    if (bd->title &&
-        tick < bd->title->duration) {
+    _stop_preload_thread(&bd->st_textst);
+    gc_run(bd->graphics_controller, GC_CTRL_PG_RESET, 0, NULL);
 
-        _change_angle(bd);
+    bd->st_textst.clip = &bd->title->sub_path[textst_subpath].clip_list.clip[textst_subclip];
+    nav_clip_load(bd->st_textst.clip);
+    if (!bd->st_textst.clip->cl) {
+        /* required for fonts */
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_textst_subpath(): missing clip data\n");
+        return -1;
+    }
 
-        // Find the closest access unit to the requested position
-        clip = nav_time_search(bd->title, (uint32_t)tick, &clip_pkt, &out_pkt);
+    bd->st_textst.char_code = char_code;
 
-        _seek_internal(bd, clip, out_pkt, clip_pkt);
+    if (bd->async_preload && _start_preload(bd, &bd->st_textst, 0x1800, 0)) {
+        /* completed in _check_preload() */
+        return 1;
+    }
 
-    } else {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_seek_time(%u) failed\n", (unsigned int)tick);
+    if (!_preload_m2ts(bd, &bd->st_textst, 0x1800, 0, 0)) {
+        gc_run(bd->graphics_controller, GC_CTRL_PG_RESET, 0, NULL);
+        _close_preload(&bd->st_textst);
+        return 0;
     }
 
-    bd_mutex_unlock(&bd->mutex);
+    _init_textst_subpath(bd);
 
-    return bd->s_pos;
+    return 1;
 }
 
-uint64_t bd_tell_time(BLURAY *bd)
-{
-    uint32_t clip_pkt = 0, out_pkt = 0, out_time = 0;
-    NAV_CLIP *clip;
-
-    if (!bd) {
-        return 0;
-    }
+/*
+ * preloader for asynchronous sub paths
+ */
 
-    bd_mutex_lock(&bd->mutex);
+static int _find_ig_stream(BLURAY *bd, uint16_t *pid, int *sub_path_idx, unsigned *sub_clip_idx)
+{
+    unsigned  main_clip_idx = bd->st0.clip ? bd->st0.clip->ref : 0;
+    MPLS_PI  *pi        = &bd->title->pl->play_item[main_clip_idx];
+    unsigned  ig_stream = bd_psr_read(bd->regs, PSR_IG_STREAM_ID);
 
-    if (bd->title) {
-        clip = nav_packet_search(bd->title, SPN(bd->s_pos), &clip_pkt, &out_pkt, &out_time);
-        if (clip) {
-            out_time += clip->title_time;
+    if (ig_stream > 0 && ig_stream <= pi->stn.num_ig) {
+        ig_stream--; /* stream number to table index */
+        if (pi->stn.ig[ig_stream].stream_type == 2) {
+            *sub_path_idx = pi->stn.ig[ig_stream].subpath_id;
+            *sub_clip_idx = pi->stn.ig[ig_stream].subclip_id;
         }
-    }
+        *pid = pi->stn.ig[ig_stream].pid;
 
-    bd_mutex_unlock(&bd->mutex);
+        BD_DEBUG(DBG_BLURAY, "_find_ig_stream(): current IG stream pid 0x%04x sub-path %d\n",
+              *pid, *sub_path_idx);
+        return 1;
+    }
 
-    return ((uint64_t)out_time) * 2;
+    return 0;
 }
 
-int64_t bd_seek_chapter(BLURAY *bd, unsigned chapter)
+static int _preload_ig_subpath(BLURAY *bd)
 {
-    uint32_t clip_pkt, out_pkt;
-    NAV_CLIP *clip;
+    int      ig_subpath = -1;
+    unsigned ig_subclip = 0;
+    uint16_t ig_pid     = 0;
 
-    bd_mutex_lock(&bd->mutex);
+    if (!bd->graphics_controller) {
+        return 0;
+    }
 
-    if (bd->title &&
-        chapter < bd->title->chap_list.count) {
+    _find_ig_stream(bd, &ig_pid, &ig_subpath, &ig_subclip);
 
-        _change_angle(bd);
+    if (ig_subpath < 0) {
+        return 0;
+    }
 
-        // Find the closest access unit to the requested position
-        clip = nav_chapter_search(bd->title, chapter, &clip_pkt, &out_pkt);
+    if (ig_subclip >= bd->title->sub_path[ig_subpath].clip_list.count) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_ig_subpath(): invalid subclip id\n");
+        return -1;
+    }
 
-        _seek_internal(bd, clip, out_pkt, clip_pkt);
+    if (bd->st_ig.clip == &bd->title->sub_path[ig_subpath].clip_list.clip[ig_subclip]) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_ig_subpath(): subpath already loaded");
+        //return 1;
+    }
 
-    } else {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_seek_chapter(%u) failed\n", chapter);
+    bd->st_ig.clip = &bd->title->sub_path[ig_subpath].clip_list.clip[ig_subclip];
+    /* load clip info here: sub path may be decoded in background thread */
+    nav_clip_load(bd->st_ig.clip);
+
+    if (bd->title->sub_path[ig_subpath].clip_list.count > 1) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_ig_subpath(): multi-clip sub paths not supported\n");
     }
 
-    bd_mutex_unlock(&bd->mutex);
+    /* IG sub path is streamed to graphics controller in _init_ig_stream() */
 
-    return bd->s_pos;
+    return 1;
 }
 
-int64_t bd_chapter_pos(BLURAY *bd, unsigned chapter)
+static int _preload_subpaths(BLURAY *bd)
 {
-    uint32_t clip_pkt, out_pkt;
-    int64_t ret = -1;
-
-    bd_mutex_lock(&bd->mutex);
-
-    if (bd->title &&
-        chapter < bd->title->chap_list.count) {
+    _close_preload(&bd->st_ig);
+    _close_preload(&bd->st_textst);
 
-        // Find the closest access unit to the requested position
-        nav_chapter_search(bd->title, chapter, &clip_pkt, &out_pkt);
-        ret = (int64_t)out_pkt * 192;
+    if (bd->title->pl->sub_count <= 0) {
+        return 0;
     }
 
-    bd_mutex_unlock(&bd->mutex);
-
-    return ret;
+    return _preload_ig_subpath(bd) | _preload_textst_subpath(bd);
 }
 
-uint32_t bd_get_current_chapter(BLURAY *bd)
+static int _init_ig_stream(BLURAY *bd)
 {
-    uint32_t ret = 0;
+    int      ig_subpath = -1;
+    unsigned ig_subclip = 0;
+    uint16_t ig_pid     = 0;
 
-    bd_mutex_lock(&bd->mutex);
+    bd->st0.ig_pid = 0;
 
-    if (bd->title) {
-        ret = nav_chapter_get_current(bd->st0.clip, SPN(bd->st0.clip_pos));
+    if (!bd->graphics_controller) {
+        return 0;
+    }
+
+    _find_ig_stream(bd, &ig_pid, &ig_subpath, &ig_subclip);
+
+    /* decode IG sub-path */
+    if (bd->st_ig.clip) {
+        if (bd->async_preload && _start_preload(bd, &bd->st_ig, ig_pid, 1)) {
+            /* menu is initialized in _check_preload() */
+            return 1;
+        }
+        if (!_preload_m2ts(bd, &bd->st_ig, ig_pid, 1, 0)) {
+            _close_preload(&bd->st_ig);
+            return 0;
+        }
+        return 1;
+    }
+
+    /* store PID of main path embedded IG stream */
+    if (ig_subpath < 0) {
+        bd->st0.ig_pid = ig_pid;
+        return 1;
     }
 
-    bd_mutex_unlock(&bd->mutex);
-
-    return ret;
+    return 0;
 }
 
-int64_t bd_seek_playitem(BLURAY *bd, unsigned clip_ref)
+/* complete background sub path loading */
+static void _check_preload(BLURAY *bd)
 {
-    uint32_t clip_pkt, out_pkt;
-    NAV_CLIP *clip;
+    uint32_t done;
 
-    bd_mutex_lock(&bd->mutex);
+    done = _join_preload(&bd->st_ig);
+    if (done == PRELOAD_DONE) {
+        BD_DEBUG(DBG_BLURAY, "IG sub path loaded\n");
+        _run_gc(bd, GC_CTRL_INIT_MENU, 0);
+        _queue_event(bd, BD_EVENT_SUBPATH_READY, 1);
+    } else if (done == PRELOAD_FAILED) {
+        _close_preload(&bd->st_ig);
+    }
 
-    if (bd->title &&
-        clip_ref < bd->title->clip_list.count) {
+    done = _join_preload(&bd->st_textst);
+    if (done == PRELOAD_DONE) {
+        BD_DEBUG(DBG_BLURAY, "TextST sub path loaded\n");
+        _init_textst_subpath(bd);
+        _queue_event(bd, BD_EVENT_SUBPATH_READY, 2);
+    } else if (done == PRELOAD_FAILED) {
+        gc_run(bd->graphics_controller, GC_CTRL_PG_RESET, 0, NULL);
+        _close_preload(&bd->st_textst);
+    }
+}
 
-      _change_angle(bd);
+/*
+ * select title / angle
+ */
 
-      clip     = &bd->title->clip_list.clip[clip_ref];
-      clip_pkt = clip->start_pkt;
-      out_pkt  = clip->title_pkt;
+static void _close_playlist(BLURAY *bd)
+{
+    /* sub path loading threads decode to graphics controller */
+    _stop_preload_thread(&bd->st_ig);
+    _stop_preload_thread(&bd->st_textst);
 
-      _seek_internal(bd, clip, out_pkt, clip_pkt);
+    if (bd->graphics_controller) {
+        gc_run(bd->graphics_controller, GC_CTRL_RESET, 0, NULL);
+    }
 
-    } else {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_seek_playitem(%u) failed\n", clip_ref);
+    /* stopping playback in middle of playlist ? */
+    if (bd->title && bd->st0.clip) {
+        if (bd->st0.clip->ref < bd->title->clip_list.count - 1) {
+            /* not last clip of playlist */
+            BD_DEBUG(DBG_BLURAY, "close playlist (not last clip)\n");
+            _queue_event(bd, BD_EVENT_PLAYLIST_STOP, 0);
+        } else {
+            /* last clip of playlist */
+            int clip_pkt = SPN(bd->st0.clip_pos);
+            int skip = bd->st0.clip->end_pkt - clip_pkt;
+            BD_DEBUG(DBG_BLURAY, "close playlist (last clip), packets skipped %d\n", skip);
+            if (skip > 100) {
+                _queue_event(bd, BD_EVENT_PLAYLIST_STOP, 0);
+            }
+        }
     }
 
-    bd_mutex_unlock(&bd->mutex);
+    _close_m2ts(&bd->st0);
+    _close_preload(&bd->st_ig);
+    _close_preload(&bd->st_textst);
 
-    return bd->s_pos;
+    _es_reset(bd);
+
+    bd->prefetch_clip = NULL;
+    _close_preopen(&bd->st_next);
+    _flush_clip_handles(bd);
+
+    bd->still_active  = 0;
+    bd->trick_step    = 0;
+    bd->trick_end_pkt = 0;
+    bd->st0.rd_limit  = 0;
+
+    if (bd->title) {
+        nav_title_close(bd->title);
+        bd->title = NULL;
+    }
 }
 
-int64_t bd_seek_mark(BLURAY *bd, unsigned mark)
+static int _open_playlist(BLURAY *bd, const char *f_name, unsigned angle)
 {
-    uint32_t clip_pkt, out_pkt;
-    NAV_CLIP *clip;
+    /* do not compete with playlist loading */
+    _stop_pl_prefetch(bd);
 
-    bd_mutex_lock(&bd->mutex);
+    _close_playlist(bd);
 
-    if (bd->title &&
-        mark < bd->title->mark_list.count) {
+    bd->title = nav_title_open(bd->disc, f_name, angle);
+    if (bd->title == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to open title %s!\n", f_name);
+        return 0;
+    }
 
-        _change_angle(bd);
+    bd->seamless_angle_change = 0;
+    bd->s_pos = 0;
+    bd->end_of_playlist = 0;
 
-        // Find the closest access unit to the requested position
-        clip = nav_mark_search(bd->title, mark, &clip_pkt, &out_pkt);
+    if (bd->title->angle_count > 1) {
+        nav_title_angle_points(bd->title);
+    }
+    bd->st0.ig_pid = 0;
 
-        _seek_internal(bd, clip, out_pkt, clip_pkt);
+    bd_psr_write(bd->regs, PSR_PLAYLIST, atoi(bd->title->name));
+    bd_psr_write(bd->regs, PSR_ANGLE_NUMBER, bd->title->angle + 1);
 
+    if (_is_interactive_title(bd)) {
+        bd_psr_write(bd->regs, PSR_CHAPTER, 0xffff);
     } else {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_seek_mark(%u) failed\n", mark);
+        bd_psr_write(bd->regs, PSR_CHAPTER, 1);
     }
 
-    bd_mutex_unlock(&bd->mutex);
-
-    return bd->s_pos;
-}
+    // Get the initial clip of the playlist
+    bd->st0.clip = nav_next_clip(bd->title, NULL);
+    if (_open_m2ts(bd, &bd->st0)) {
+        BD_DEBUG(DBG_BLURAY, "Title %s selected\n", f_name);
 
-int64_t bd_seek(BLURAY *bd, uint64_t pos)
-{
-    uint32_t pkt, clip_pkt, out_pkt, out_time;
-    NAV_CLIP *clip;
+        _find_next_playmark(bd);
 
-    bd_mutex_lock(&bd->mutex);
+        _preload_subpaths(bd);
 
-    if (bd->title &&
-        pos < (uint64_t)bd->title->packets * 192) {
+        return 1;
+    }
+    return 0;
+}
 
-        pkt = SPN(pos);
+int bd_select_playlist(BLURAY *bd, uint32_t playlist)
+{
+    char f_name[16];
+    int result;
 
-        _change_angle(bd);
+    snprintf(f_name, sizeof(f_name), "%05d.mpls", playlist);
 
-        // Find the closest access unit to the requested position
-        clip = nav_packet_search(bd->title, pkt, &clip_pkt, &out_pkt, &out_time);
+    bd_mutex_lock(&bd->mutex);
 
-        _seek_internal(bd, clip, out_pkt, clip_pkt);
+    if (bd->title_list) {
+        /* update current title */
+        unsigned i;
+        for (i = 0; i < bd->title_list->count; i++) {
+            if (playlist == bd->title_list->title_info[i].mpls_id) {
+                bd->title_idx = i;
+                break;
+            }
+        }
     }
 
+    result = _open_playlist(bd, f_name, 0);
+
     bd_mutex_unlock(&bd->mutex);
 
-    return bd->s_pos;
+    return result;
 }
 
-uint64_t bd_get_title_size(BLURAY *bd)
+#ifdef USING_BDJAVA
+int bd_bdj_seek(BLURAY *bd, int playitem, int playmark, int64_t time)
 {
-    uint64_t ret = 0;
-
-    if (!bd) {
-        return 0;
-    }
-
     bd_mutex_lock(&bd->mutex);
 
-    if (bd->title) {
-        ret = (uint64_t)bd->title->packets * 192;
+    if (playitem > 0) {
+        bd_seek_playitem(bd, playitem);
+    }
+    if (playmark >= 0) {
+        bd_seek_mark(bd, playmark);
+    }
+    if (time >= 0) {
+        bd_seek_time(bd, time);
     }
 
     bd_mutex_unlock(&bd->mutex);
 
-    return ret;
+    return 1;
 }
 
-uint64_t bd_tell(BLURAY *bd)
+static int _play_playlist_at(BLURAY *bd, int playlist, int playitem, int playmark, int64_t time)
 {
-    uint64_t ret = 0;
+    if (playlist < 0) {
+        _close_playlist(bd);
+        return 1;
+    }
 
-    if (!bd) {
+    if (!bd_select_playlist(bd, playlist)) {
         return 0;
     }
 
-    bd_mutex_lock(&bd->mutex);
-
-    ret = bd->s_pos;
+    bd->bdj_wait_start = 1;  /* playback is triggered by bd_select_rate() */
 
-    bd_mutex_unlock(&bd->mutex);
+    bd_bdj_seek(bd, playitem, playmark, time);
 
-    return ret;
+    return 1;
 }
 
-/*
- * read
- */
-
-static int64_t _clip_seek_time(BLURAY *bd, uint32_t tick)
+int bd_play_playlist_at(BLURAY *bd, int playlist, int playitem, int playmark, int64_t time)
 {
-    uint32_t clip_pkt, out_pkt;
-
-    if (tick < bd->st0.clip->out_time) {
-
-        // Find the closest access unit to the requested position
-        nav_clip_time_search(bd->st0.clip, tick, &clip_pkt, &out_pkt);
+    int result;
 
-        _seek_internal(bd, bd->st0.clip, out_pkt, clip_pkt);
-    }
+    /* select + seek should be atomic (= player can't read data between select and seek to start position) */
+    bd_mutex_lock(&bd->mutex);
+    result = _play_playlist_at(bd, playlist, playitem, playmark, time);
+    bd_mutex_unlock(&bd->mutex);
 
-    return bd->s_pos;
+    return result;
 }
+#endif /* USING_BDJAVA */
 
-static int _bd_read(BLURAY *bd, unsigned char *buf, int len)
+// Select a title for playback
+// The title index is an index into the list
+// established by bd_get_titles()
+int bd_select_title(BLURAY *bd, uint32_t title_idx)
 {
-    BD_STREAM *st = &bd->st0;
-    int out_len;
-
-    if (st->fp) {
-        out_len = 0;
-        BD_DEBUG(DBG_STREAM, "Reading [%d bytes] at %"PRIu64"...\n", len, bd->s_pos);
-
-        while (len > 0) {
-            uint32_t clip_pkt;
-
-            unsigned int size = len;
-            // Do we need to read more data?
-            clip_pkt = SPN(st->clip_pos);
-            if (bd->seamless_angle_change) {
-                if (clip_pkt >= bd->angle_change_pkt) {
-                    if (clip_pkt >= st->clip->end_pkt) {
-                        st->clip = nav_next_clip(bd->title, st->clip);
-                        if (!_open_m2ts(bd, st)) {
-                            return -1;
-                        }
-                        bd->s_pos = (uint64_t)st->clip->title_pkt * 192L;
-                    } else {
-                        _change_angle(bd);
-                        _clip_seek_time(bd, bd->angle_change_time);
-                    }
-                    bd->seamless_angle_change = 0;
-                } else {
-                    uint64_t angle_pos;
-
-                    angle_pos = (uint64_t)bd->angle_change_pkt * 192L;
-                    if (angle_pos - st->clip_pos < size) {
-                        size = (unsigned int)(angle_pos - st->clip_pos);
-                    }
-                }
-            }
-            if (st->clip == NULL) {
-                // We previously reached the last clip.  Nothing
-                // else to read.
-                _queue_event(bd, BD_EVENT_END_OF_TITLE, 0);
-                bd->end_of_playlist |= 1;
-                return 0;
-            }
-            if (st->int_buf_off == 6144 || clip_pkt >= st->clip->end_pkt) {
-
-                // Do we need to get the next clip?
-                if (clip_pkt >= st->clip->end_pkt) {
+    const char *f_name;
+    int result;
 
-                    // split read()'s at clip boundary
-                    if (out_len) {
-                        return out_len;
-                    }
+    // Open the playlist
+    if (bd->title_list == NULL) {
+        BD_DEBUG(DBG_CRIT | DBG_BLURAY, "Title list not yet read!\n");
+        return 0;
+    }
+    if (bd->title_list->count <= title_idx) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Invalid title index %d!\n", title_idx);
+        return 0;
+    }
 
-                    MPLS_PI *pi = &st->clip->title->pl->play_item[st->clip->ref];
+    bd_mutex_lock(&bd->mutex);
 
-                    // handle still mode clips
-                    if (pi->still_mode == BLURAY_STILL_INFINITE) {
-                        _queue_event(bd, BD_EVENT_STILL_TIME, 0);
-                        return 0;
-                    }
-                    if (pi->still_mode == BLURAY_STILL_TIME) {
-                        if (bd->event_queue) {
-                            _queue_event(bd, BD_EVENT_STILL_TIME, pi->still_time);
-                            return 0;
-                        }
-                    }
+    bd->title_idx = title_idx;
+    f_name = bd->title_list->title_info[title_idx].name;
 
-                    // find next clip
-                    st->clip = nav_next_clip(bd->title, st->clip);
-                    if (st->clip == NULL) {
-                        BD_DEBUG(DBG_BLURAY | DBG_STREAM, "End of title\n");
-                        _queue_event(bd, BD_EVENT_END_OF_TITLE, 0);
-                        bd->end_of_playlist |= 1;
-                        return 0;
-                    }
-                    if (!_open_m2ts(bd, st)) {
-                        return -1;
-                    }
+    result = _open_playlist(bd, f_name, 0);
 
-                    if (st->clip->connection == CONNECT_NON_SEAMLESS) {
-                        /* application layer demuxer buffers must be reset here */
-                        _queue_event(bd, BD_EVENT_DISCONTINUITY, st->clip->in_time);
-                    }
+    bd_mutex_unlock(&bd->mutex);
 
-                }
+    return result;
+}
 
-                int r = _read_block(bd, st, bd->int_buf);
-                if (r > 0) {
+uint32_t bd_get_current_title(BLURAY *bd)
+{
+    return bd->title_idx;
+}
 
-                    if (st->ig_pid > 0) {
-                        if (gc_decode_ts(bd->graphics_controller, st->ig_pid, bd->int_buf, 1, -1) > 0) {
-                            /* initialize menus */
-                            _run_gc(bd, GC_CTRL_INIT_MENU, 0);
-                        }
-                    }
-                    if (st->pg_pid > 0) {
-                        if (gc_decode_ts(bd->graphics_controller, st->pg_pid, bd->int_buf, 1, -1) > 0) {
-                            /* render subtitles */
-                            gc_run(bd->graphics_controller, GC_CTRL_PG_UPDATE, 0, NULL);
-                        }
-                    }
-                    if (bd->st_textst.clip) {
-                        _update_textst_timer(bd);
-                    }
+static int _bd_select_angle(BLURAY *bd, unsigned angle)
+{
+    unsigned orig_angle;
 
-                    st->int_buf_off = st->clip_pos % 6144;
+    if (bd->title == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Can't select angle: title not yet selected!\n");
+        return 0;
+    }
 
-                } else if (r == 0) {
-                    /* recoverable error (EOF, broken block) */
-                    return out_len;
-                } else {
-                    /* fatal error */
-                    return -1;
-                }
-            }
-            if (size > (unsigned int)6144 - st->int_buf_off) {
-                size = 6144 - st->int_buf_off;
-            }
+    orig_angle = bd->title->angle;
 
-            /* cut read at clip end packet */
-            uint32_t new_clip_pkt = SPN(st->clip_pos + size);
-            if (new_clip_pkt > st->clip->end_pkt) {
-                BD_DEBUG(DBG_STREAM, "cut %d bytes at end of block\n", (new_clip_pkt - st->clip->end_pkt) * 192);
-                size -= (new_clip_pkt - st->clip->end_pkt) * 192;
-            }
+    bd->st0.clip = nav_set_angle(bd->title, bd->st0.clip, angle);
 
-            /* copy chunk */
-            memcpy(buf, bd->int_buf + st->int_buf_off, size);
-            buf += size;
-            len -= size;
-            out_len += size;
-            st->clip_pos += size;
-            st->int_buf_off += size;
-            bd->s_pos += size;
-        }
+    if (orig_angle == bd->title->angle) {
+        return 1;
+    }
 
-        /* mark tracking */
-        if (bd->next_mark >= 0 && bd->s_pos > bd->next_mark_pos) {
-            _playmark_reached(bd);
-        }
+    bd_psr_write(bd->regs, PSR_ANGLE_NUMBER, bd->title->angle + 1);
 
-        BD_DEBUG(DBG_STREAM, "%d bytes read OK!\n", out_len);
-        return out_len;
+    if (!_open_m2ts(bd, &bd->st0)) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Error selecting angle %d !\n", angle);
+        return 0;
     }
 
-    BD_DEBUG(DBG_STREAM | DBG_CRIT, "bd_read(): no valid title selected!\n");
-
-    return -1;
+    return 1;
 }
 
-int bd_read(BLURAY *bd, unsigned char *buf, int len)
+int bd_select_angle(BLURAY *bd, unsigned angle)
 {
     int result;
+    bd_mutex_lock(&bd->mutex);
+    result = _bd_select_angle(bd, angle);
+    bd_mutex_unlock(&bd->mutex);
+    return result;
+}
+
+unsigned bd_get_current_angle(BLURAY *bd)
+{
+    int angle = 0;
 
     bd_mutex_lock(&bd->mutex);
-    result = _bd_read(bd, buf, len);
+    if (bd->title) {
+        angle = bd->title->angle;
+    }
     bd_mutex_unlock(&bd->mutex);
 
-    return result;
+    return angle;
 }
 
-int bd_read_skip_still(BLURAY *bd)
+
+void bd_seamless_angle_change(BLURAY *bd, unsigned angle)
 {
-    BD_STREAM *st = &bd->st0;
-    int ret = 0;
+    uint32_t clip_pkt;
 
     bd_mutex_lock(&bd->mutex);
 
-    if (st->clip) {
-        MPLS_PI *pi = &st->clip->title->pl->play_item[st->clip->ref];
+    clip_pkt = SPN(bd->st0.clip_pos + 191);
+    bd->angle_change_pkt = nav_angle_change_search(bd->st0.clip, clip_pkt,
+                                                   &bd->angle_change_time);
+    bd->request_angle = angle;
+    bd->seamless_angle_change = 1;
 
-        if (pi->still_mode == BLURAY_STILL_TIME) {
-            st->clip = nav_next_clip(bd->title, st->clip);
-            if (st->clip) {
-                ret = _open_m2ts(bd, st);
-            }
+    /* locate change point in the new angle and start reading it */
+    bd->angle_change_target_valid = 0;
+    if (bd->st0.clip && bd->angle_change_pkt < bd->st0.clip->end_pkt &&
+        nav_angle_change_point(bd->st0.clip, angle, bd->angle_change_time, &bd->angle_change_target_pkt)) {
+        char name[11];
+
+        bd->angle_change_target_valid = 1;
+        _preopen_clip(bd, bd->st0.clip, nav_angle_clip_name(bd->st0.clip, angle, name),
+                      bd->angle_change_target_pkt);
+        if (bd->st_next.fp) {
+            file_prefetch(bd->st_next.fp, ((uint64_t)bd->angle_change_target_pkt * 192 / 6144) * 6144, 6144);
         }
     }
 
     bd_mutex_unlock(&bd->mutex);
-
-    return ret;
 }
 
 /*
- * synchronous sub paths
+ * title lists
  */
 
-static int _preload_textst_subpath(BLURAY *bd)
+static NAV_TITLE_LIST *_get_title_list(BLURAY *bd, uint8_t flags, uint32_t min_title_length,
+                                       nav_title_list_cb cb, void *cb_handle)
 {
-    uint8_t        char_code      = BLURAY_TEXT_CHAR_CODE_UTF8;
-    int            textst_subpath = -1;
-    unsigned       textst_subclip = 0;
-    uint16_t       textst_pid     = 0;
-    unsigned       ii;
+    NAV_TITLE_LIST *title_list = NULL;
+    char *key = NULL;
+    uint64_t t0 = bd_get_time_us();
 
-    if (!bd->graphics_controller) {
-        return 0;
+    if (bd->nav_cache) {
+        key = nav_cache_key(bd->disc);
+        title_list = nav_cache_load(key, flags, min_title_length);
     }
 
-    if (!bd->decode_pg || !bd->title) {
-        return 0;
+    if (!title_list) {
+        title_list = nav_get_title_list(bd->disc, flags, min_title_length, bd->scan_threads, cb, cb_handle);
+        nav_cache_save(key, flags, min_title_length, title_list);
     }
+    X_FREE(key);
 
-    _find_pg_stream(bd, &textst_pid, &textst_subpath, &textst_subclip, &char_code);
-    if (textst_subpath < 0) {
+    bd->profile.title_scan_us = bd_get_time_us() - t0;
+
+    return title_list;
+}
+
+uint32_t bd_get_titles(BLURAY *bd, uint8_t flags, uint32_t min_title_length)
+{
+    if (!bd) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_get_titles(NULL) failed\n");
         return 0;
     }
 
-    if (textst_subclip >= bd->title->sub_path[textst_subpath].clip_list.count) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_textst_subpath(): invalid subclip id\n");
-        return -1;
-    }
+    bd_cancel_title_scan(bd);
 
-    if (bd->st_textst.clip == &bd->title->sub_path[textst_subpath].clip_list.clip[textst_subclip]) {
-        BD_DEBUG(DBG_BLURAY, "_preload_textst_subpath(): subpath already loaded");
-        return 1;
+    if (bd->title_list != NULL) {
+        nav_free_title_list(bd->title_list);
+        bd->title_list = NULL;
     }
 
-    gc_run(bd->graphics_controller, GC_CTRL_PG_RESET, 0, NULL);
+    bd->title_list = _get_title_list(bd, flags, min_title_length, NULL, NULL);
 
-    bd->st_textst.clip = &bd->title->sub_path[textst_subpath].clip_list.clip[textst_subclip];
-    if (!bd->st0.clip->cl) {
-        /* required for fonts */
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_textst_subpath(): missing clip data\n");
-        return -1;
+    if (!bd->title_list) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "nav_get_title_list(%s) failed\n", disc_root(bd->disc));
+        return 0;
     }
 
-    if (!_preload_m2ts(bd, &bd->st_textst)) {
-        _close_preload(&bd->st_textst);
-        return 0;
+    disc_event(bd->disc, DISC_EVENT_START, bd->disc_info.num_titles);
+
+    return bd->title_list->count;
+}
+
+/*
+ * asynchronous title scan
+ */
+
+static void _title_scan_report(BLURAY *bd, BLURAY_TITLE_SCAN *ts, const NAV_TITLE_LIST *title_list)
+{
+    ts->title_count = title_list ? title_list->count : 0;
+    ts->main_title  = title_list ? title_list->main_title_idx : 0;
+
+    if (ts->status == BD_TITLE_SCAN_TITLE) {
+        const NAV_TITLE_INFO *ti = &title_list->title_info[title_list->count - 1];
+        ts->title_idx = title_list->count - 1;
+        ts->playlist  = ti->mpls_id;
+        ts->duration  = (uint64_t)ti->duration * 2;
+    } else {
+        ts->title_idx = ts->playlist = 0;
+        ts->duration  = 0;
     }
 
-    gc_decode_ts(bd->graphics_controller, 0x1800, bd->st_textst.buf, SPN(bd->st_textst.clip_size) / 32, -1);
+    bd->title_scan_cb(bd->title_scan_handle, ts);
+}
 
-    /* set fonts and encoding from clip info */
-    gc_add_font(bd->graphics_controller, NULL, -1);
-    for (ii = 0; ii < bd->st_textst.clip->cl->font_info.font_count; ii++) {
-        char *file = str_printf("%s.otf", bd->st_textst.clip->cl->font_info.font[ii].file_id);
-        uint8_t *data = NULL;
-        size_t size = disc_read_file(bd->disc, "BDMV" DIR_SEP "AUXDATA", file, &data);
-        if (data && size > 0 && gc_add_font(bd->graphics_controller, data, size) < 0) {
-            X_FREE(data);
-        }
-        X_FREE(file);
+static int _title_scan_cb(void *handle, const NAV_TITLE_LIST *title_list, unsigned scanned, unsigned total)
+{
+    BLURAY *bd = (BLURAY *)handle;
+    BLURAY_TITLE_SCAN ts;
+
+    memset(&ts, 0, sizeof(ts));
+    ts.scanned = scanned;
+    ts.total   = total;
+    ts.status  = BD_TITLE_SCAN_PROGRESS;
+
+    bd->title_scan_total = total;
+
+    /* at most one title is added per playlist */
+    if (title_list->count > bd->title_scan_count) {
+        bd->title_scan_count = title_list->count;
+        ts.status = BD_TITLE_SCAN_TITLE;
     }
-    gc_run(bd->graphics_controller, GC_CTRL_PG_CHARCODE, char_code, NULL);
 
-    /* start presentation timer */
-    _init_textst_timer(bd);
+    _title_scan_report(bd, &ts, title_list);
 
-    return 1;
+    return !!bd_atomic_load(&bd->title_scan_cancel);
 }
 
-/*
- * preloader for asynchronous sub paths
- */
-
-static int _find_ig_stream(BLURAY *bd, uint16_t *pid, int *sub_path_idx, unsigned *sub_clip_idx)
+static void *_title_scan_thread(void *arg)
 {
-    unsigned  main_clip_idx = bd->st0.clip ? bd->st0.clip->ref : 0;
-    MPLS_PI  *pi        = &bd->title->pl->play_item[main_clip_idx];
-    unsigned  ig_stream = bd_psr_read(bd->regs, PSR_IG_STREAM_ID);
+    BLURAY *bd = (BLURAY *)arg;
+    BLURAY_TITLE_SCAN ts;
+    NAV_TITLE_LIST *title_list;
 
-    if (ig_stream > 0 && ig_stream <= pi->stn.num_ig) {
-        ig_stream--; /* stream number to table index */
-        if (pi->stn.ig[ig_stream].stream_type == 2) {
-            *sub_path_idx = pi->stn.ig[ig_stream].subpath_id;
-            *sub_clip_idx = pi->stn.ig[ig_stream].subclip_id;
+    title_list = _get_title_list(bd, bd->title_scan_flags, bd->title_scan_min_length, _title_scan_cb, bd);
+
+    memset(&ts, 0, sizeof(ts));
+
+    if (title_list && bd->title_scan_count < title_list->count) {
+        /* loaded from cache: report titles now */
+        NAV_TITLE_LIST partial = *title_list;
+        bd->title_scan_total = title_list->count;
+        for (partial.count = bd->title_scan_count + 1; partial.count <= title_list->count; partial.count++) {
+            ts.status  = BD_TITLE_SCAN_TITLE;
+            ts.scanned = partial.count;
+            ts.total   = title_list->count;
+            _title_scan_report(bd, &ts, &partial);
         }
-        *pid = pi->stn.ig[ig_stream].pid;
+        bd->title_scan_count = title_list->count;
+    }
 
-        BD_DEBUG(DBG_BLURAY, "_find_ig_stream(): current IG stream pid 0x%04x sub-path %d\n",
-              *pid, *sub_path_idx);
-        return 1;
+    if (!title_list) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "title scan of %s failed or cancelled\n", disc_root(bd->disc));
+        ts.status = BD_TITLE_SCAN_FAILED;
+        _title_scan_report(bd, &ts, NULL);
+        return NULL;
     }
 
-    return 0;
+    bd_mutex_lock(&bd->mutex);
+    bd->title_list = title_list;
+    bd_mutex_unlock(&bd->mutex);
+
+    disc_event(bd->disc, DISC_EVENT_START, bd->disc_info.num_titles);
+
+    ts.status  = BD_TITLE_SCAN_DONE;
+    ts.scanned = ts.total = bd->title_scan_total;
+    _title_scan_report(bd, &ts, title_list);
+
+    return NULL;
 }
 
-static int _preload_ig_subpath(BLURAY *bd)
+int bd_get_titles_async(BLURAY *bd, uint8_t flags, uint32_t min_title_length,
+                        void (*cb)(void *handle, const BLURAY_TITLE_SCAN *scan), void *handle)
 {
-    int      ig_subpath = -1;
-    unsigned ig_subclip = 0;
-    uint16_t ig_pid     = 0;
-
-    if (!bd->graphics_controller) {
+    if (!bd || !cb) {
         return 0;
     }
 
-    _find_ig_stream(bd, &ig_pid, &ig_subpath, &ig_subclip);
+    bd_cancel_title_scan(bd);
 
-    if (ig_subpath < 0) {
+    if (bd->title_list != NULL) {
+        nav_free_title_list(bd->title_list);
+        bd->title_list = NULL;
+    }
+
+    bd->title_scan_flags      = flags;
+    bd->title_scan_min_length = min_title_length;
+    bd->title_scan_cb         = cb;
+    bd->title_scan_handle     = handle;
+    bd->title_scan_count      = 0;
+    bd->title_scan_total      = 0;
+    bd_atomic_store(&bd->title_scan_cancel, 0);
+
+    if (bd_thread_create(&bd->title_scan_thread, "bd_title_scan", _title_scan_thread, bd) < 0) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "failed to start title scan thread\n");
         return 0;
     }
+    bd->title_scan_running = 1;
 
-    if (ig_subclip >= bd->title->sub_path[ig_subpath].clip_list.count) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_ig_subpath(): invalid subclip id\n");
+    return 1;
+}
+
+void bd_cancel_title_scan(BLURAY *bd)
+{
+    if (bd && bd->title_scan_running) {
+        bd_atomic_store(&bd->title_scan_cancel, 1);
+        bd_thread_join(&bd->title_scan_thread);
+        bd->title_scan_running = 0;
+    }
+}
+
+int bd_get_main_title(BLURAY *bd)
+{
+    if (bd->title_type != title_undef) {
+        BD_DEBUG(DBG_CRIT | DBG_BLURAY, "bd_get_main_title() can't be used with BluRay menus\n");
+    }
+
+    if (bd->title_list == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Title list not yet read!\n");
         return -1;
     }
 
-    if (bd->st_ig.clip == &bd->title->sub_path[ig_subpath].clip_list.clip[ig_subclip]) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_ig_subpath(): subpath already loaded");
-        //return 1;
+    return bd->title_list->main_title_idx;
+}
+
+static void _copy_streams(NAV_CLIP *clip, BLURAY_STREAM_INFO *streams, MPLS_STREAM *si, int count)
+{
+    int ii;
+
+    for (ii = 0; ii < count; ii++) {
+        streams[ii].coding_type = si[ii].coding_type;
+        streams[ii].format = si[ii].format;
+        streams[ii].rate = si[ii].rate;
+        streams[ii].char_code = si[ii].char_code;
+        memcpy(streams[ii].lang, si[ii].lang, 4);
+        streams[ii].pid = si[ii].pid;
+        streams[ii].aspect = nav_lookup_aspect(clip, si[ii].pid);
+        if ((si->stream_type == 2) || (si->stream_type == 3))
+            streams[ii].subpath_id = si->subpath_id;
+        else
+            streams[ii].subpath_id = -1;
     }
+}
 
-    bd->st_ig.clip = &bd->title->sub_path[ig_subpath].clip_list.clip[ig_subclip];
+/*
+ * title info allocation.
+ * bd_get_title_info() places title and all arrays in a single block sized in advance.
+ * bd_get_all_title_info() places all titles in a single block chain (arena).
+ */
 
-    if (bd->title->sub_path[ig_subpath].clip_list.count > 1) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "_preload_ig_subpath(): multi-clip sub paths not supported\n");
+typedef struct title_arena TITLE_ARENA;
+struct title_arena {
+    TITLE_ARENA *next;
+    size_t       size;
+    size_t       used;
+};
+
+#define TITLE_ARENA_HDR_SIZE   ((sizeof(TITLE_ARENA) + 15) & ~(size_t)15)
+#define TITLE_ARENA_BLOCK_SIZE (64*1024)
+#define TITLE_ARENA_ALIGN(n)   (((n) + 7) & ~(size_t)7)
+
+static TITLE_ARENA *_arena_new(size_t size)
+{
+    TITLE_ARENA *a = calloc(1, TITLE_ARENA_HDR_SIZE + size);
+    if (a) {
+        a->size = size;
+    }
+    return a;
+}
+
+static void _arena_free(TITLE_ARENA *a)
+{
+    while (a) {
+        TITLE_ARENA *next = a->next;
+        X_FREE(a);
+        a = next;
+    }
+}
+
+/* zeroed memory from arena. Space left in first block is used before chained blocks. */
+static void *_ti_calloc(TITLE_ARENA *arena, size_t nmemb, size_t size)
+{
+    TITLE_ARENA *cur;
+    size_t       len = TITLE_ARENA_ALIGN(nmemb * size);
+
+    if (!len) {
+        return NULL;
     }
 
-    if (!_preload_m2ts(bd, &bd->st_ig)) {
-        _close_preload(&bd->st_ig);
-        return 0;
+    cur = arena->size - arena->used >= len ? arena : arena->next;
+    if (!cur || cur->size - cur->used < len) {
+        cur = _arena_new(BD_MAX(len, TITLE_ARENA_BLOCK_SIZE));
+        if (!cur) {
+            return NULL;
+        }
+        cur->next   = arena->next;
+        arena->next = cur;
     }
 
-    return 1;
+    cur->used += len;
+    return (uint8_t *)cur + TITLE_ARENA_HDR_SIZE + cur->used - len;
 }
 
-static int _preload_subpaths(BLURAY *bd)
+/* arena space for title info arrays of one title */
+static size_t _title_info_size(const NAV_TITLE *title)
 {
-    _close_preload(&bd->st_ig);
-    _close_preload(&bd->st_textst);
+    size_t   size;
+    unsigned ii;
 
-    if (bd->title->pl->sub_count <= 0) {
-        return 0;
+    size  = TITLE_ARENA_ALIGN(title->chap_list.count * sizeof(BLURAY_TITLE_CHAPTER));
+    size += TITLE_ARENA_ALIGN(title->mark_list.count * sizeof(BLURAY_TITLE_MARK));
+    size += TITLE_ARENA_ALIGN(title->clip_list.count * sizeof(BLURAY_CLIP_INFO));
+    for (ii = 0; ii < title->clip_list.count; ii++) {
+        const MPLS_STN *stn = &title->pl->play_item[ii].stn;
+        size += TITLE_ARENA_ALIGN(stn->num_video * sizeof(BLURAY_STREAM_INFO));
+        size += TITLE_ARENA_ALIGN(stn->num_audio * sizeof(BLURAY_STREAM_INFO));
+        size += TITLE_ARENA_ALIGN((stn->num_pg + stn->num_pip_pg) * sizeof(BLURAY_STREAM_INFO));
+        size += TITLE_ARENA_ALIGN(stn->num_ig * sizeof(BLURAY_STREAM_INFO));
+        size += TITLE_ARENA_ALIGN(stn->num_secondary_video * sizeof(BLURAY_STREAM_INFO));
+        size += TITLE_ARENA_ALIGN(stn->num_secondary_audio * sizeof(BLURAY_STREAM_INFO));
     }
 
-    return _preload_ig_subpath(bd) | _preload_textst_subpath(bd);
+    return size;
 }
 
-static int _init_ig_stream(BLURAY *bd)
+static void _fill_title_info(BLURAY_TITLE_INFO *title_info, TITLE_ARENA *arena,
+                             NAV_TITLE* title, uint32_t title_idx, uint32_t playlist)
 {
-    int      ig_subpath = -1;
-    unsigned ig_subclip = 0;
-    uint16_t ig_pid     = 0;
+    unsigned int ii;
 
-    bd->st0.ig_pid = 0;
+    /* clip sizes and mark offsets */
+    nav_title_load(title);
 
-    if (!bd->graphics_controller) {
-        return 0;
+    title_info->idx = title_idx;
+    title_info->playlist = playlist;
+    title_info->duration = (uint64_t)title->duration * 2;
+    title_info->angle_count = title->angle_count;
+    title_info->chapter_count = title->chap_list.count;
+    title_info->chapters = _ti_calloc(arena, title_info->chapter_count, sizeof(BLURAY_TITLE_CHAPTER));
+    for (ii = 0; ii < title_info->chapter_count; ii++) {
+        title_info->chapters[ii].idx = ii;
+        title_info->chapters[ii].start = (uint64_t)title->chap_list.mark[ii].title_time * 2;
+        title_info->chapters[ii].duration = (uint64_t)title->chap_list.mark[ii].duration * 2;
+        title_info->chapters[ii].offset = (uint64_t)title->chap_list.mark[ii].title_pkt * 192L;
+        title_info->chapters[ii].clip_ref = title->chap_list.mark[ii].clip_ref;
     }
-
-    _find_ig_stream(bd, &ig_pid, &ig_subpath, &ig_subclip);
-
-    /* decode already preloaded IG sub-path */
-    if (bd->st_ig.clip) {
-        gc_decode_ts(bd->graphics_controller, ig_pid, bd->st_ig.buf, SPN(bd->st_ig.clip_size) / 32, -1);
-        return 1;
+    title_info->mark_count = title->mark_list.count;
+    title_info->marks = _ti_calloc(arena, title_info->mark_count, sizeof(BLURAY_TITLE_MARK));
+    for (ii = 0; ii < title_info->mark_count; ii++) {
+        title_info->marks[ii].idx = ii;
+        title_info->marks[ii].type = title->mark_list.mark[ii].mark_type;
+        title_info->marks[ii].start = (uint64_t)title->mark_list.mark[ii].title_time * 2;
+        title_info->marks[ii].duration = (uint64_t)title->mark_list.mark[ii].duration * 2;
+        title_info->marks[ii].offset = (uint64_t)title->mark_list.mark[ii].title_pkt * 192L;
+        title_info->marks[ii].clip_ref = title->mark_list.mark[ii].clip_ref;
     }
+    title_info->clip_count = title->clip_list.count;
+    title_info->clips = _ti_calloc(arena, title_info->clip_count, sizeof(BLURAY_CLIP_INFO));
+    for (ii = 0; ii < title_info->clip_count; ii++) {
+        MPLS_PI *pi = &title->pl->play_item[ii];
+        BLURAY_CLIP_INFO *ci = &title_info->clips[ii];
+        NAV_CLIP *nc = &title->clip_list.clip[ii];
 
-    /* store PID of main path embedded IG stream */
-    if (ig_subpath < 0) {
-        bd->st0.ig_pid = ig_pid;
-        return 1;
+        ci->pkt_count = nc->end_pkt - nc->start_pkt;
+        ci->start_time = (uint64_t)nc->title_time * 2;
+        ci->in_time = (uint64_t)pi->in_time * 2;
+        ci->out_time = (uint64_t)pi->out_time * 2;
+        ci->still_mode = pi->still_mode;
+        ci->still_time = pi->still_time;
+        ci->video_stream_count = pi->stn.num_video;
+        ci->audio_stream_count = pi->stn.num_audio;
+        ci->pg_stream_count = pi->stn.num_pg + pi->stn.num_pip_pg;
+        ci->ig_stream_count = pi->stn.num_ig;
+        ci->sec_video_stream_count = pi->stn.num_secondary_video;
+        ci->sec_audio_stream_count = pi->stn.num_secondary_audio;
+        ci->video_streams = _ti_calloc(arena, ci->video_stream_count, sizeof(BLURAY_STREAM_INFO));
+        ci->audio_streams = _ti_calloc(arena, ci->audio_stream_count, sizeof(BLURAY_STREAM_INFO));
+        ci->pg_streams = _ti_calloc(arena, ci->pg_stream_count, sizeof(BLURAY_STREAM_INFO));
+        ci->ig_streams = _ti_calloc(arena, ci->ig_stream_count, sizeof(BLURAY_STREAM_INFO));
+        ci->sec_video_streams = _ti_calloc(arena, ci->sec_video_stream_count, sizeof(BLURAY_STREAM_INFO));
+        ci->sec_audio_streams = _ti_calloc(arena, ci->sec_audio_stream_count, sizeof(BLURAY_STREAM_INFO));
+        _copy_streams(nc, ci->video_streams, pi->stn.video, ci->video_stream_count);
+        _copy_streams(nc, ci->audio_streams, pi->stn.audio, ci->audio_stream_count);
+        _copy_streams(nc, ci->pg_streams, pi->stn.pg, ci->pg_stream_count);
+        _copy_streams(nc, ci->ig_streams, pi->stn.ig, ci->ig_stream_count);
+        _copy_streams(nc, ci->sec_video_streams, pi->stn.secondary_video, ci->sec_video_stream_count);
+        _copy_streams(nc, ci->sec_audio_streams, pi->stn.secondary_audio, ci->sec_audio_stream_count);
     }
-
-    return 0;
 }
 
-/*
- * select title / angle
- */
-
-static void _close_playlist(BLURAY *bd)
+static BLURAY_TITLE_INFO *_get_title_info(BLURAY *bd, uint32_t title_idx, uint32_t playlist, const char *mpls_name,
+                                          unsigned angle)
 {
-    if (bd->graphics_controller) {
-        gc_run(bd->graphics_controller, GC_CTRL_RESET, 0, NULL);
-    }
+    NAV_TITLE *title;
+    BLURAY_TITLE_INFO *title_info = NULL;
+    TITLE_ARENA *arena;
+    size_t info_size = TITLE_ARENA_ALIGN(sizeof(BLURAY_TITLE_INFO));
 
-    /* stopping playback in middle of playlist ? */
-    if (bd->title && bd->st0.clip) {
-        if (bd->st0.clip->ref < bd->title->clip_list.count - 1) {
-            /* not last clip of playlist */
-            BD_DEBUG(DBG_BLURAY, "close playlist (not last clip)\n");
-            _queue_event(bd, BD_EVENT_PLAYLIST_STOP, 0);
-        } else {
-            /* last clip of playlist */
-            int clip_pkt = SPN(bd->st0.clip_pos);
-            int skip = bd->st0.clip->end_pkt - clip_pkt;
-            BD_DEBUG(DBG_BLURAY, "close playlist (last clip), packets skipped %d\n", skip);
-            if (skip > 100) {
-                _queue_event(bd, BD_EVENT_PLAYLIST_STOP, 0);
-            }
-        }
+    title = nav_title_open(bd->disc, mpls_name, angle);
+    if (title == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to open title %s!\n", mpls_name);
+        return NULL;
     }
 
-    _close_m2ts(&bd->st0);
-    _close_preload(&bd->st_ig);
-    _close_preload(&bd->st_textst);
-
-    if (bd->title) {
-        nav_title_close(bd->title);
-        bd->title = NULL;
+    /* title info followed by all arrays. Freed with single free(). */
+    arena = _arena_new(info_size + _title_info_size(title));
+    if (arena) {
+        arena->used = info_size;
+        title_info = (BLURAY_TITLE_INFO *)((uint8_t *)arena + TITLE_ARENA_HDR_SIZE);
+        _fill_title_info(title_info, arena, title, title_idx, playlist);
     }
+
+    nav_title_close(title);
+    return title_info;
 }
 
-static int _open_playlist(BLURAY *bd, const char *f_name, unsigned angle)
+BLURAY_TITLE_INFO* bd_get_title_info(BLURAY *bd, uint32_t title_idx, unsigned angle)
 {
-    _close_playlist(bd);
-
-    bd->title = nav_title_open(bd->disc, f_name, angle);
-    if (bd->title == NULL) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to open title %s!\n", f_name);
-        return 0;
+    if (bd->title_list == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Title list not yet read!\n");
+        return NULL;
     }
-
-    bd->seamless_angle_change = 0;
-    bd->s_pos = 0;
-    bd->end_of_playlist = 0;
-    bd->st0.ig_pid = 0;
-
-    bd_psr_write(bd->regs, PSR_PLAYLIST, atoi(bd->title->name));
-    bd_psr_write(bd->regs, PSR_ANGLE_NUMBER, bd->title->angle + 1);
-
-    if (_is_interactive_title(bd)) {
-        bd_psr_write(bd->regs, PSR_CHAPTER, 0xffff);
-    } else {
-        bd_psr_write(bd->regs, PSR_CHAPTER, 1);
+    if (bd->title_list->count <= title_idx) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Invalid title index %d!\n", title_idx);
+        return NULL;
     }
 
-    // Get the initial clip of the playlist
-    bd->st0.clip = nav_next_clip(bd->title, NULL);
-    if (_open_m2ts(bd, &bd->st0)) {
-        BD_DEBUG(DBG_BLURAY, "Title %s selected\n", f_name);
-
-        _find_next_playmark(bd);
-
-        _preload_subpaths(bd);
-
-        return 1;
-    }
-    return 0;
+    return _get_title_info(bd,
+                           title_idx, bd->title_list->title_info[title_idx].mpls_id,
+                           bd->title_list->title_info[title_idx].name,
+                           angle);
 }
 
-int bd_select_playlist(BLURAY *bd, uint32_t playlist)
+BLURAY_TITLE_INFO *bd_get_all_title_info(BLURAY *bd, unsigned angle, uint32_t *count)
 {
-    char *f_name = str_printf("%05d.mpls", playlist);
-    int result;
+    BLURAY_TITLE_INFO *title_info;
+    TITLE_ARENA *arena;
+    uint32_t ii, num;
 
-    bd_mutex_lock(&bd->mutex);
+    *count = 0;
 
-    if (bd->title_list) {
-        /* update current title */
-        unsigned i;
-        for (i = 0; i < bd->title_list->count; i++) {
-            if (playlist == bd->title_list->title_info[i].mpls_id) {
-                bd->title_idx = i;
-                break;
-            }
-        }
+    if (bd->title_list == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Title list not yet read!\n");
+        return NULL;
     }
 
-    result = _open_playlist(bd, f_name, 0);
+    num = bd->title_list->count;
+    arena = _arena_new(num * sizeof(BLURAY_TITLE_INFO));
+    if (!arena) {
+        return NULL;
+    }
+    arena->used = arena->size;  /* reserved for title array */
+    title_info = (BLURAY_TITLE_INFO *)((uint8_t *)arena + TITLE_ARENA_HDR_SIZE);
 
-    bd_mutex_unlock(&bd->mutex);
+    /* clip info objects are shared between titles by disc cache */
+    for (ii = 0; ii < num; ii++) {
+        NAV_TITLE_INFO *nti = &bd->title_list->title_info[ii];
+        NAV_TITLE *title;
 
-    X_FREE(f_name);
-    return result;
-}
+        title_info[ii].idx      = ii;
+        title_info[ii].playlist = nti->mpls_id;
 
-#ifdef USING_BDJAVA
-int bd_bdj_seek(BLURAY *bd, int playitem, int playmark, int64_t time)
-{
-    bd_mutex_lock(&bd->mutex);
+        title = nav_title_open(bd->disc, nti->name, angle);
+        if (title == NULL) {
+            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to open title %s!\n", nti->name);
+            continue;
+        }
 
-    if (playitem > 0) {
-        bd_seek_playitem(bd, playitem);
-    }
-    if (playmark >= 0) {
-        bd_seek_mark(bd, playmark);
+        _fill_title_info(&title_info[ii], arena, title, ii, nti->mpls_id);
+        nav_title_close(title);
     }
-    if (time >= 0) {
-        bd_seek_time(bd, time);
-    }
-
-    bd_mutex_unlock(&bd->mutex);
 
-    return 1;
+    *count = num;
+    return title_info;
 }
 
-static int _play_playlist_at(BLURAY *bd, int playlist, int playitem, int playmark, int64_t time)
+void bd_free_all_title_info(BLURAY_TITLE_INFO *title_info)
 {
-    if (playlist < 0) {
-        _close_playlist(bd);
-        return 1;
-    }
-
-    if (!bd_select_playlist(bd, playlist)) {
-        return 0;
+    if (title_info) {
+        _arena_free((TITLE_ARENA *)(void *)((uint8_t *)title_info - TITLE_ARENA_HDR_SIZE));
     }
+}
 
-    bd->bdj_wait_start = 1;  /* playback is triggered by bd_select_rate() */
+BLURAY_TITLE_INFO* bd_get_playlist_info(BLURAY *bd, uint32_t playlist, unsigned angle)
+{
+    char f_name[16];
 
-    bd_bdj_seek(bd, playitem, playmark, time);
+    snprintf(f_name, sizeof(f_name), "%05d.mpls", playlist);
 
-    return 1;
+    return _get_title_info(bd, 0, playlist, f_name, angle);
 }
 
-int bd_play_playlist_at(BLURAY *bd, int playlist, int playitem, int playmark, int64_t time)
+void bd_free_title_info(BLURAY_TITLE_INFO *title_info)
 {
-    int result;
-
-    /* select + seek should be atomic (= player can't read data between select and seek to start position) */
-    bd_mutex_lock(&bd->mutex);
-    result = _play_playlist_at(bd, playlist, playitem, playmark, time);
-    bd_mutex_unlock(&bd->mutex);
-
-    return result;
+    if (title_info) {
+        _arena_free((TITLE_ARENA *)(void *)((uint8_t *)title_info - TITLE_ARENA_HDR_SIZE));
+    }
 }
-#endif /* USING_BDJAVA */
 
-// Select a title for playback
-// The title index is an index into the list
-// established by bd_get_titles()
-int bd_select_title(BLURAY *bd, uint32_t title_idx)
+BLURAY_KEYFRAME* bd_get_keyframes(BLURAY *bd, uint32_t title_idx, unsigned angle, uint32_t *count)
 {
-    const char *f_name;
-    int result;
+    NAV_TITLE *title;
+    NAV_KEYFRAME *nav_kf;
+    BLURAY_KEYFRAME *kf = NULL;
+    unsigned ii, num = 0;
+
+    *count = 0;
 
-    // Open the playlist
     if (bd->title_list == NULL) {
-        BD_DEBUG(DBG_CRIT | DBG_BLURAY, "Title list not yet read!\n");
-        return 0;
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Title list not yet read!\n");
+        return NULL;
     }
     if (bd->title_list->count <= title_idx) {
         BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Invalid title index %d!\n", title_idx);
-        return 0;
+        return NULL;
     }
 
-    bd_mutex_lock(&bd->mutex);
+    title = nav_title_open(bd->disc, bd->title_list->title_info[title_idx].name, angle);
+    if (title == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to open title %s!\n", bd->title_list->title_info[title_idx].name);
+        return NULL;
+    }
 
-    bd->title_idx = title_idx;
-    f_name = bd->title_list->title_info[title_idx].name;
+    nav_kf = nav_title_keyframes(title, &num);
+    if (nav_kf && num) {
+        kf = calloc(num, sizeof(BLURAY_KEYFRAME));
+        if (kf) {
+            for (ii = 0; ii < num; ii++) {
+                kf[ii].time     = (uint64_t)nav_kf[ii].title_time * 2;
+                kf[ii].offset   = (uint64_t)nav_kf[ii].title_pkt * 192;
+                kf[ii].clip_ref = nav_kf[ii].clip_ref;
+                kf[ii].clip_pkt = nav_kf[ii].clip_pkt;
+            }
+            *count = num;
+        }
+    }
+    X_FREE(nav_kf);
+
+    nav_title_close(title);
+    return kf;
+}
+
+void bd_free_keyframes(BLURAY_KEYFRAME *keyframes)
+{
+    X_FREE(keyframes);
+}
+
+/*
+ * title fingerprint
+ *
+ * Playlist structure and a fixed set of decrypted units sampled at
+ * EP map entries spread evenly over the title.
+ */
+
+#define FP_MAX_SAMPLES  32
 
-    result = _open_playlist(bd, f_name, 0);
+static void _fp_u32(BD_SHA1 *h, uint32_t v)
+{
+    uint8_t b[4] = { v >> 24, v >> 16, v >> 8, v };
+    bd_sha1_update(h, b, 4);
+}
 
-    bd_mutex_unlock(&bd->mutex);
+static void _fp_streams(BD_SHA1 *h, const MPLS_STREAM *s, unsigned count)
+{
+    unsigned ii;
 
-    return result;
+    _fp_u32(h, count);
+    for (ii = 0; ii < count; ii++) {
+        _fp_u32(h, ((uint32_t)s[ii].coding_type << 16) | s[ii].pid);
+    }
 }
 
-uint32_t bd_get_current_title(BLURAY *bd)
+static void _fp_structure(BD_SHA1 *h, const NAV_TITLE *title)
 {
-    return bd->title_idx;
+    unsigned ii;
+
+    _fp_u32(h, title->clip_list.count);
+    _fp_u32(h, title->chap_list.count);
+    for (ii = 0; ii < title->clip_list.count; ii++) {
+        const NAV_CLIP *clip = &title->clip_list.clip[ii];
+        const MPLS_STN *stn  = &title->pl->play_item[clip->ref].stn;
+
+        bd_sha1_update(h, clip->name, 5);
+        _fp_u32(h, clip->in_time);
+        _fp_u32(h, clip->out_time);
+        _fp_streams(h, stn->video, stn->num_video);
+        _fp_streams(h, stn->audio, stn->num_audio);
+        _fp_streams(h, stn->pg,    stn->num_pg);
+    }
 }
 
-static int _bd_select_angle(BLURAY *bd, unsigned angle)
+static int _fp_samples(BLURAY *bd, BD_SHA1 *h, NAV_TITLE *title)
 {
-    unsigned orig_angle;
+    BD_STREAM_STATS stats;
+    BD_STREAM       st;
+    NAV_KEYFRAME   *kf;
+    unsigned        ii, num = 0, num_samples;
+    int             result = 0;
 
-    if (bd->title == NULL) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Can't select angle: title not yet selected!\n");
+    kf = nav_title_keyframes(title, &num);
+    if (!kf || !num) {
+        X_FREE(kf);
         return 0;
     }
 
-    orig_angle = bd->title->angle;
-
-    bd->st0.clip = nav_set_angle(bd->title, bd->st0.clip, angle);
+    memset(&stats, 0, sizeof(stats));
+    memset(&st, 0, sizeof(st));
+    st.stats = &stats;
+
+    num_samples = BD_MIN(num, FP_MAX_SAMPLES);
+    for (ii = 0; ii < num_samples; ii++) {
+        const NAV_KEYFRAME *k = &kf[(2 * ii + 1) * (uint64_t)num / (2 * num_samples)];
+        NAV_CLIP           *clip = &title->clip_list.clip[k->clip_ref];
+        uint8_t            *unit;
+
+        if (st.clip != clip) {
+            st.clip = clip;
+            if (!_open_m2ts(bd, &st)) {
+                result = -1;
+                break;
+            }
+        }
 
-    if (orig_angle == bd->title->angle) {
-        return 1;
-    }
+        /* read only the sampled unit */
+        st.clip_block_pos = ((uint64_t)k->clip_pkt * 192 / 6144) * 6144;
+        st.rd_limit       = st.clip_block_pos + 6144;
+        _reset_read_buffer(&st);
 
-    bd_psr_write(bd->regs, PSR_ANGLE_NUMBER, bd->title->angle + 1);
+        if (_read_unit(bd, &st, &unit) <= 0) {
+            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "title fingerprint: error reading %s at %"PRIu64"\n",
+                     clip->name, st.clip_block_pos);
+            result = -1;
+            break;
+        }
 
-    if (!_open_m2ts(bd, &bd->st0)) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Error selecting angle %d !\n", angle);
-        return 0;
+        _fp_u32(h, k->clip_ref);
+        _fp_u32(h, k->clip_pkt);
+        bd_sha1_update(h, unit, 6144);
     }
 
-    return 1;
-}
+    _close_m2ts(&st);
+    X_FREE(kf);
 
-int bd_select_angle(BLURAY *bd, unsigned angle)
-{
-    int result;
-    bd_mutex_lock(&bd->mutex);
-    result = _bd_select_angle(bd, angle);
-    bd_mutex_unlock(&bd->mutex);
     return result;
 }
 
-unsigned bd_get_current_angle(BLURAY *bd)
+int bd_get_title_fingerprint(BLURAY *bd, uint32_t title_idx, uint8_t fingerprint[20])
 {
-    int angle = 0;
+    NAV_TITLE *title;
+    BD_SHA1    h;
+    int        result;
 
-    bd_mutex_lock(&bd->mutex);
-    if (bd->title) {
-        angle = bd->title->angle;
+    if (bd->title_list == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Title list not yet read!\n");
+        return 0;
+    }
+    if (bd->title_list->count <= title_idx) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Invalid title index %d!\n", title_idx);
+        return 0;
     }
-    bd_mutex_unlock(&bd->mutex);
-
-    return angle;
-}
-
 
-void bd_seamless_angle_change(BLURAY *bd, unsigned angle)
-{
-    uint32_t clip_pkt;
+    title = nav_title_open(bd->disc, bd->title_list->title_info[title_idx].name, 0);
+    if (title == NULL) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to open title %s!\n", bd->title_list->title_info[title_idx].name);
+        return 0;
+    }
 
-    bd_mutex_lock(&bd->mutex);
+    bd_sha1_init(&h);
+    _fp_structure(&h, title);
+    result = _fp_samples(bd, &h, title);
+    bd_sha1_final(&h, fingerprint);
 
-    clip_pkt = SPN(bd->st0.clip_pos + 191);
-    bd->angle_change_pkt = nav_angle_change_search(bd->st0.clip, clip_pkt,
-                                                   &bd->angle_change_time);
-    bd->request_angle = angle;
-    bd->seamless_angle_change = 1;
+    nav_title_close(title);
 
-    bd_mutex_unlock(&bd->mutex);
+    return result < 0 ? 0 : 1;
 }
 
 /*
- * title lists
+ * player settings
  */
 
-uint32_t bd_get_titles(BLURAY *bd, uint8_t flags, uint32_t min_title_length)
+#define READ_AHEAD_MAX_UNITS  (64*1024*1024 / 6144)  /* limit read-ahead buffer to 64M */
+#define UNIT_CACHE_MAX_UNITS  (256*1024*1024 / 6144) /* limit decrypted unit cache to 256M */
+#define PACE_MAX_LEAD_MS      10000
+
+static void _set_low_memory(BLURAY *bd, int enable)
 {
-    if (!bd) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_get_titles(NULL) failed\n");
-        return 0;
-    }
+    bd->low_memory = !!enable;
 
-    if (bd->title_list != NULL) {
-        nav_free_title_list(bd->title_list);
+    if (bd->event_queue) {
+        /* already queued events are kept */
+        bd->event_queue->max_pending = enable ? LOW_MEM_PENDING_EVENTS : MAX_PENDING_EVENTS;
+    }
+    if (bd->disc) {
+        disc_cache_set_limit(bd->disc, enable ? LOW_MEM_DISC_CACHE_SIZE : 0);
     }
-    bd->title_list = nav_get_title_list(bd->disc, flags, min_title_length);
 
-    if (!bd->title_list) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "nav_get_title_list(%s) failed\n", disc_root(bd->disc));
-        return 0;
+    if (!enable) {
+        /* other limits are kept until changed with player settings */
+        return;
     }
 
-    disc_event(bd->disc, DISC_EVENT_START, bd->disc_info.num_titles);
+    /* read-ahead: applied when next clip is opened */
+    bd->read_ahead_units = BD_MIN(bd->read_ahead_units, LOW_MEM_READ_AHEAD_UNITS);
 
-    return bd->title_list->count;
+    if (bd->st0.cache && unit_cache_size(bd->st0.cache) > LOW_MEM_UNIT_CACHE_UNITS) {
+        unit_cache_free(&bd->st0.cache);
+        bd->st0.cache = unit_cache_init(LOW_MEM_UNIT_CACHE_UNITS);
+    }
+
+    if (!bd->graphics_memory_kb || bd->graphics_memory_kb > LOW_MEM_GRAPHICS_KB) {
+        bd->graphics_memory_kb = LOW_MEM_GRAPHICS_KB;
+        gc_set_memory_limit(bd->graphics_controller, (uint64_t)bd->graphics_memory_kb * 1024);
+    }
 }
 
-int bd_get_main_title(BLURAY *bd)
+int bd_set_player_setting(BLURAY *bd, uint32_t idx, uint32_t value)
 {
-    if (bd->title_type != title_undef) {
-        BD_DEBUG(DBG_CRIT | DBG_BLURAY, "bd_get_main_title() can't be used with BluRay menus\n");
+    static const struct { uint32_t idx; uint32_t  psr; } map[] = {
+        { BLURAY_PLAYER_SETTING_PARENTAL,       PSR_PARENTAL },
+        { BLURAY_PLAYER_SETTING_AUDIO_CAP,      PSR_AUDIO_CAP },
+        { BLURAY_PLAYER_SETTING_AUDIO_LANG,     PSR_AUDIO_LANG },
+        { BLURAY_PLAYER_SETTING_PG_LANG,        PSR_PG_AND_SUB_LANG },
+        { BLURAY_PLAYER_SETTING_MENU_LANG,      PSR_MENU_LANG },
+        { BLURAY_PLAYER_SETTING_COUNTRY_CODE,   PSR_COUNTRY },
+        { BLURAY_PLAYER_SETTING_REGION_CODE,    PSR_REGION },
+        { BLURAY_PLAYER_SETTING_OUTPUT_PREFER,  PSR_OUTPUT_PREFER },
+        { BLURAY_PLAYER_SETTING_DISPLAY_CAP,    PSR_DISPLAY_CAP },
+        { BLURAY_PLAYER_SETTING_3D_CAP,         PSR_3D_CAP },
+        { BLURAY_PLAYER_SETTING_VIDEO_CAP,      PSR_VIDEO_CAP },
+        { BLURAY_PLAYER_SETTING_TEXT_CAP,       PSR_TEXT_CAP },
+        { BLURAY_PLAYER_SETTING_PLAYER_PROFILE, PSR_PROFILE_VERSION },
+    };
+
+    unsigned i;
+    int result;
+
+    if (idx == BLURAY_PLAYER_SETTING_READ_AHEAD) {
+        bd_mutex_lock(&bd->mutex);
+        /* applied when next clip is opened */
+        bd->read_ahead_units = BD_MIN(value, bd->low_memory ? LOW_MEM_READ_AHEAD_UNITS : READ_AHEAD_MAX_UNITS);
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
     }
 
-    if (bd->title_list == NULL) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Title list not yet read!\n");
-        return -1;
+    if (idx == BLURAY_PLAYER_SETTING_NAV_CACHE) {
+        bd_mutex_lock(&bd->mutex);
+        bd->nav_cache = !!value;
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
     }
 
-    return bd->title_list->main_title_idx;
-}
+    if (idx == BLURAY_PLAYER_SETTING_LAZY_DECRYPT) {
+        bd_mutex_lock(&bd->mutex);
+        /* applied when disc is opened */
+        bd->lazy_decrypt = !!value;
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-static void _copy_streams(NAV_CLIP *clip, BLURAY_STREAM_INFO *streams, MPLS_STREAM *si, int count)
-{
-    int ii;
+    if (idx == BLURAY_PLAYER_SETTING_PACING) {
+        bd_mutex_lock(&bd->mutex);
+        bd->pace_lead_ms = BD_MIN(value, PACE_MAX_LEAD_MS);
+        bd->pace_valid   = 0;
+        _pace_wake(bd);
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-    for (ii = 0; ii < count; ii++) {
-        streams[ii].coding_type = si[ii].coding_type;
-        streams[ii].format = si[ii].format;
-        streams[ii].rate = si[ii].rate;
-        streams[ii].char_code = si[ii].char_code;
-        memcpy(streams[ii].lang, si[ii].lang, 4);
-        streams[ii].pid = si[ii].pid;
-        streams[ii].aspect = nav_lookup_aspect(clip, si[ii].pid);
-        if ((si->stream_type == 2) || (si->stream_type == 3))
-            streams[ii].subpath_id = si->subpath_id;
-        else
-            streams[ii].subpath_id = -1;
+    if (idx == BLURAY_PLAYER_SETTING_TIMER_THREAD) {
+        BD_TIMERS *timers = NULL;
+        int        applied;
+
+        bd_mutex_lock(&bd->mutex);
+        if (!value) {
+            timers = bd->timers;
+            bd->timers = NULL;
+        } else if (!bd->timers) {
+            bd->timers = bd_timers_init(_timer_expired, bd);
+            _update_timers(bd);
+        }
+        applied = !value || bd->timers;
+        bd_mutex_unlock(&bd->mutex);
+
+        /* timer callback may be waiting for bd->mutex */
+        bd_timers_free(&timers);
+        return applied;
     }
-}
 
-static BLURAY_TITLE_INFO* _fill_title_info(NAV_TITLE* title, uint32_t title_idx, uint32_t playlist)
-{
-    BLURAY_TITLE_INFO *title_info;
-    unsigned int ii;
+    if (idx == BLURAY_PLAYER_SETTING_ASYNC_PRELOAD) {
+        bd_mutex_lock(&bd->mutex);
+        /* applied when next sub path is loaded */
+        bd->async_preload = !!value;
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-    title_info = calloc(1, sizeof(BLURAY_TITLE_INFO));
-    title_info->idx = title_idx;
-    title_info->playlist = playlist;
-    title_info->duration = (uint64_t)title->duration * 2;
-    title_info->angle_count = title->angle_count;
-    title_info->chapter_count = title->chap_list.count;
-    title_info->chapters = calloc(title_info->chapter_count, sizeof(BLURAY_TITLE_CHAPTER));
-    for (ii = 0; ii < title_info->chapter_count; ii++) {
-        title_info->chapters[ii].idx = ii;
-        title_info->chapters[ii].start = (uint64_t)title->chap_list.mark[ii].title_time * 2;
-        title_info->chapters[ii].duration = (uint64_t)title->chap_list.mark[ii].duration * 2;
-        title_info->chapters[ii].offset = (uint64_t)title->chap_list.mark[ii].title_pkt * 192L;
-        title_info->chapters[ii].clip_ref = title->chap_list.mark[ii].clip_ref;
+    if (idx == BLURAY_PLAYER_SETTING_CONTINUOUS_READ) {
+        bd_mutex_lock(&bd->mutex);
+        bd->continuous_read = !!value;
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
     }
-    title_info->mark_count = title->mark_list.count;
-    title_info->marks = calloc(title_info->mark_count, sizeof(BLURAY_TITLE_MARK));
-    for (ii = 0; ii < title_info->mark_count; ii++) {
-        title_info->marks[ii].idx = ii;
-        title_info->marks[ii].type = title->mark_list.mark[ii].mark_type;
-        title_info->marks[ii].start = (uint64_t)title->mark_list.mark[ii].title_time * 2;
-        title_info->marks[ii].duration = (uint64_t)title->mark_list.mark[ii].duration * 2;
-        title_info->marks[ii].offset = (uint64_t)title->mark_list.mark[ii].title_pkt * 192L;
-        title_info->marks[ii].clip_ref = title->mark_list.mark[ii].clip_ref;
+
+    if (idx == BLURAY_PLAYER_SETTING_LOW_MEMORY) {
+        bd_mutex_lock(&bd->mutex);
+        _set_low_memory(bd, value);
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
     }
-    title_info->clip_count = title->clip_list.count;
-    title_info->clips = calloc(title_info->clip_count, sizeof(BLURAY_CLIP_INFO));
-    for (ii = 0; ii < title_info->clip_count; ii++) {
-        MPLS_PI *pi = &title->pl->play_item[ii];
-        BLURAY_CLIP_INFO *ci = &title_info->clips[ii];
-        NAV_CLIP *nc = &title->clip_list.clip[ii];
 
-        ci->pkt_count = nc->end_pkt - nc->start_pkt;
-        ci->start_time = (uint64_t)nc->title_time * 2;
-        ci->in_time = (uint64_t)pi->in_time * 2;
-        ci->out_time = (uint64_t)pi->out_time * 2;
-        ci->still_mode = pi->still_mode;
-        ci->still_time = pi->still_time;
-        ci->video_stream_count = pi->stn.num_video;
-        ci->audio_stream_count = pi->stn.num_audio;
-        ci->pg_stream_count = pi->stn.num_pg + pi->stn.num_pip_pg;
-        ci->ig_stream_count = pi->stn.num_ig;
-        ci->sec_video_stream_count = pi->stn.num_secondary_video;
-        ci->sec_audio_stream_count = pi->stn.num_secondary_audio;
-        ci->video_streams = calloc(ci->video_stream_count, sizeof(BLURAY_STREAM_INFO));
-        ci->audio_streams = calloc(ci->audio_stream_count, sizeof(BLURAY_STREAM_INFO));
-        ci->pg_streams = calloc(ci->pg_stream_count, sizeof(BLURAY_STREAM_INFO));
-        ci->ig_streams = calloc(ci->ig_stream_count, sizeof(BLURAY_STREAM_INFO));
-        ci->sec_video_streams = calloc(ci->sec_video_stream_count, sizeof(BLURAY_STREAM_INFO));
-        ci->sec_audio_streams = calloc(ci->sec_audio_stream_count, sizeof(BLURAY_STREAM_INFO));
-        _copy_streams(nc, ci->video_streams, pi->stn.video, ci->video_stream_count);
-        _copy_streams(nc, ci->audio_streams, pi->stn.audio, ci->audio_stream_count);
-        _copy_streams(nc, ci->pg_streams, pi->stn.pg, ci->pg_stream_count);
-        _copy_streams(nc, ci->ig_streams, pi->stn.ig, ci->ig_stream_count);
-        _copy_streams(nc, ci->sec_video_streams, pi->stn.secondary_video, ci->sec_video_stream_count);
-        _copy_streams(nc, ci->sec_audio_streams, pi->stn.secondary_audio, ci->sec_audio_stream_count);
+    if (idx == BLURAY_PLAYER_SETTING_SHARED_DECRYPT) {
+        bd_mutex_lock(&bd->mutex);
+        /* applied when disc is opened */
+        bd->shared_decrypt = !!value;
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
     }
 
-    return title_info;
-}
+    if (idx == BLURAY_PLAYER_SETTING_PLAYLIST_PREFETCH) {
+        bd_mutex_lock(&bd->mutex);
+        /* applied when next HDMV menu is opened */
+        bd->pl_prefetch = !!value;
+        if (!value) {
+            _stop_pl_prefetch(bd);
+        }
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-static BLURAY_TITLE_INFO *_get_title_info(BLURAY *bd, uint32_t title_idx, uint32_t playlist, const char *mpls_name,
-                                          unsigned angle)
-{
-    NAV_TITLE *title;
-    BLURAY_TITLE_INFO *title_info;
+    if (idx == BLURAY_PLAYER_SETTING_DIRECT_IO) {
+        bd_mutex_lock(&bd->mutex);
+        /* applied when disc is opened */
+        bd->direct_io = !!value;
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-    title = nav_title_open(bd->disc, mpls_name, angle);
-    if (title == NULL) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Unable to open title %s!\n", mpls_name);
-        return NULL;
+    if (idx == BLURAY_PLAYER_SETTING_GRAPHICS_THREAD) {
+        int started = 0;
+
+        bd_mutex_lock(&bd->mutex);
+        bd->graphics_thread = !!value;
+        if (bd->graphics_controller) {
+            if (value) {
+                started = gc_start_pg_thread(bd->graphics_controller);
+                gc_start_textst_thread(bd->graphics_controller);
+            } else {
+                gc_stop_pg_thread(bd->graphics_controller);
+                gc_stop_textst_thread(bd->graphics_controller);
+            }
+        }
+        bd_mutex_unlock(&bd->mutex);
+        return started < 0 ? 0 : 1;
+    }
+
+    if (idx == BLURAY_PLAYER_SETTING_PG_PREROLL) {
+        bd_mutex_lock(&bd->mutex);
+        /* applied at next seek */
+        bd->pg_preroll_ms = BD_MIN(value, PG_PREROLL_MAX_MS);
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
+
+    if (idx == BLURAY_PLAYER_SETTING_OVERLAY_INDEX) {
+        bd_mutex_lock(&bd->mutex);
+        bd->overlay_index = !!value;
+        gc_set_overlay_index(bd->graphics_controller, bd->overlay_index);
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
     }
 
-    title_info = _fill_title_info(title, title_idx, playlist);
+    if (idx == BLURAY_PLAYER_SETTING_OVERLAY_ARGB) {
+        bd_mutex_lock(&bd->mutex);
+        bd->overlay_argb = !!value;
+        gc_set_overlay_argb(bd->graphics_controller, bd->overlay_argb);
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-    nav_title_close(title);
-    return title_info;
-}
+    if (idx == BLURAY_PLAYER_SETTING_HDMV_PROFILE) {
+        bd_mutex_lock(&bd->mutex);
+        bd->hdmv_profile = !!value;
+        hdmv_vm_set_profiling(bd->hdmv_vm, bd->hdmv_profile);
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-BLURAY_TITLE_INFO* bd_get_title_info(BLURAY *bd, uint32_t title_idx, unsigned angle)
-{
-    if (bd->title_list == NULL) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Title list not yet read!\n");
-        return NULL;
+    if (idx == BLURAY_PLAYER_SETTING_HDMV_BUDGET) {
+        bd_mutex_lock(&bd->mutex);
+        bd->hdmv_insn_budget = value;
+        hdmv_vm_set_insn_budget(bd->hdmv_vm, bd->hdmv_insn_budget);
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
     }
-    if (bd->title_list->count <= title_idx) {
-        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "Invalid title index %d!\n", title_idx);
-        return NULL;
+
+    if (idx == BLURAY_PLAYER_SETTING_BDJ_KEEP_WARM) {
+        bd_mutex_lock(&bd->mutex);
+        /* applied when BD-J is closed */
+        bd->bdj_keep_warm = !!value;
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
     }
 
-    return _get_title_info(bd,
-                           title_idx, bd->title_list->title_info[title_idx].mpls_id,
-                           bd->title_list->title_info[title_idx].name,
-                           angle);
-}
+    if (idx == BLURAY_PLAYER_SETTING_GRAPHICS_MEMORY) {
+        bd_mutex_lock(&bd->mutex);
+        if (bd->low_memory && (!value || value > LOW_MEM_GRAPHICS_KB)) {
+            value = LOW_MEM_GRAPHICS_KB;
+        }
+        bd->graphics_memory_kb = value;
+        gc_set_memory_limit(bd->graphics_controller, (uint64_t)value * 1024);
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-BLURAY_TITLE_INFO* bd_get_playlist_info(BLURAY *bd, uint32_t playlist, unsigned angle)
-{
-    char *f_name = str_printf("%05d.mpls", playlist);
-    BLURAY_TITLE_INFO *title_info;
+    if (idx == BLURAY_PLAYER_SETTING_DRIVE_SPEED) {
+        bd_mutex_lock(&bd->mutex);
+        bd->drive_speed = value;
+        if (!value) {
+            drive_close(&bd->drive);
+        } else {
+            _open_drive(bd);
+            _update_drive_speed(bd);
+        }
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-    title_info = _get_title_info(bd, 0, playlist, f_name, angle);
+    if (idx == BLURAY_PLAYER_SETTING_READ_ERROR_BUDGET) {
+        bd_mutex_lock(&bd->mutex);
+        bd->read_error_budget_ms = value;
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-    X_FREE(f_name);
+    if (idx == BLURAY_PLAYER_SETTING_IG_DECODE_THREADS) {
+        bd_mutex_lock(&bd->mutex);
+        bd->ig_decode_threads = value;
+        gc_set_ig_decode_threads(bd->graphics_controller, value);
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-    return title_info;
-}
+    if (idx == BLURAY_PLAYER_SETTING_SHARED_CACHE) {
+        char *key = NULL;
+        int   shared;
 
-void bd_free_title_info(BLURAY_TITLE_INFO *title_info)
-{
-    unsigned int ii;
+        bd_mutex_lock(&bd->mutex);
+        if (!bd->disc) {
+            bd_mutex_unlock(&bd->mutex);
+            return 0;
+        }
+        if (value) {
+            key = nav_cache_key(bd->disc);
+            if (!key) {
+                bd_mutex_unlock(&bd->mutex);
+                return 0;
+            }
+        }
+        shared = disc_cache_share(bd->disc, key);
+        if (bd->low_memory) {
+            disc_cache_set_limit(bd->disc, LOW_MEM_DISC_CACHE_SIZE);
+        }
+        bd_mutex_unlock(&bd->mutex);
 
-    X_FREE(title_info->chapters);
-    X_FREE(title_info->marks);
-    for (ii = 0; ii < title_info->clip_count; ii++) {
-        X_FREE(title_info->clips[ii].video_streams);
-        X_FREE(title_info->clips[ii].audio_streams);
-        X_FREE(title_info->clips[ii].pg_streams);
-        X_FREE(title_info->clips[ii].ig_streams);
-        X_FREE(title_info->clips[ii].sec_video_streams);
-        X_FREE(title_info->clips[ii].sec_audio_streams);
+        X_FREE(key);
+        return shared < 0 ? 0 : 1;
     }
-    X_FREE(title_info->clips);
-    X_FREE(title_info);
-}
 
-/*
- * player settings
- */
+    if (idx == BLURAY_PLAYER_SETTING_SCAN_THREADS) {
+        bd_mutex_lock(&bd->mutex);
+        bd->scan_threads = value;
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
-int bd_set_player_setting(BLURAY *bd, uint32_t idx, uint32_t value)
-{
-    static const struct { uint32_t idx; uint32_t  psr; } map[] = {
-        { BLURAY_PLAYER_SETTING_PARENTAL,       PSR_PARENTAL },
-        { BLURAY_PLAYER_SETTING_AUDIO_CAP,      PSR_AUDIO_CAP },
-        { BLURAY_PLAYER_SETTING_AUDIO_LANG,     PSR_AUDIO_LANG },
-        { BLURAY_PLAYER_SETTING_PG_LANG,        PSR_PG_AND_SUB_LANG },
-        { BLURAY_PLAYER_SETTING_MENU_LANG,      PSR_MENU_LANG },
-        { BLURAY_PLAYER_SETTING_COUNTRY_CODE,   PSR_COUNTRY },
-        { BLURAY_PLAYER_SETTING_REGION_CODE,    PSR_REGION },
-        { BLURAY_PLAYER_SETTING_OUTPUT_PREFER,  PSR_OUTPUT_PREFER },
-        { BLURAY_PLAYER_SETTING_DISPLAY_CAP,    PSR_DISPLAY_CAP },
-        { BLURAY_PLAYER_SETTING_3D_CAP,         PSR_3D_CAP },
-        { BLURAY_PLAYER_SETTING_VIDEO_CAP,      PSR_VIDEO_CAP },
-        { BLURAY_PLAYER_SETTING_TEXT_CAP,       PSR_TEXT_CAP },
-        { BLURAY_PLAYER_SETTING_PLAYER_PROFILE, PSR_PROFILE_VERSION },
-    };
+    if (idx == BLURAY_PLAYER_SETTING_TRACE) {
+        bd_mutex_lock(&bd->mutex);
+        if (!bd->trace && value) {
+            /* buffer is kept until bd_close(): stream and read-ahead threads may still be using it */
+            bd->trace = bd_trace_init(value);
+            bd->stats_main.dec.trace    = bd->trace;
+            bd->stats_preload.dec.trace = bd->trace;
+            bd->stats_textst.dec.trace  = bd->trace;
+        } else if (bd->trace) {
+            bd_trace_enable(bd->trace, !!value);
+        }
+        bd_mutex_unlock(&bd->mutex);
+        return !value || bd->trace;
+    }
 
-    unsigned i;
-    int result;
+    if (idx == BLURAY_PLAYER_SETTING_UNIT_CACHE) {
+        bd_mutex_lock(&bd->mutex);
+        unit_cache_free(&bd->st0.cache);
+        bd->st0.cache = unit_cache_init(BD_MIN(value, bd->low_memory ? LOW_MEM_UNIT_CACHE_UNITS : UNIT_CACHE_MAX_UNITS));
+        bd_mutex_unlock(&bd->mutex);
+        return !value || bd->st0.cache;
+    }
+
+    if (idx == BLURAY_PLAYER_SETTING_DECRYPT_THREADS) {
+        bd_mutex_lock(&bd->mutex);
+        if (bd->disc) {
+            disc_set_decrypt_threads(bd->disc, value);
+        }
+        bd_mutex_unlock(&bd->mutex);
+        return 1;
+    }
 
     if (idx == BLURAY_PLAYER_SETTING_DECODE_PG) {
         bd_mutex_lock(&bd->mutex);
@@ -2605,6 +6618,7 @@ int bd_set_player_setting_str(BLURAY *bd, uint32_t idx, const char *s)
 #ifdef USING_BDJAVA
         case BLURAY_PLAYER_CACHE_ROOT:
         case BLURAY_PLAYER_PERSISTENT_ROOT:
+        case BLURAY_PLAYER_JVM_OPTIONS:
             switch (idx) {
                 case BLURAY_PLAYER_CACHE_ROOT:
                     bd_mutex_lock(&bd->mutex);
@@ -2621,6 +6635,14 @@ int bd_set_player_setting_str(BLURAY *bd, uint32_t idx, const char *s)
                     bd_mutex_unlock(&bd->mutex);
                     BD_DEBUG(DBG_BDJ, "Persistent root dir set to %s\n", bd->bdjstorage.persistent_root);
                     return 1;
+
+                case BLURAY_PLAYER_JVM_OPTIONS:
+                    bd_mutex_lock(&bd->mutex);
+                    X_FREE(bd->bdjstorage.jvm_options);
+                    bd->bdjstorage.jvm_options = str_dup(s);
+                    bd_mutex_unlock(&bd->mutex);
+                    BD_DEBUG(DBG_BDJ, "JVM options set to %s\n", bd->bdjstorage.jvm_options);
+                    return 1;
             }
 #endif /* USING_BDJAVA */
         default:
@@ -2877,6 +6899,28 @@ static void _process_psr_event(void *handle, BD_PSR_EVENT *ev)
     }
 }
 
+static void _register_psr_cb(BLURAY *bd)
+{
+    /* registers handled in _process_psr_event() */
+    static const unsigned psrs[] = {
+        PSR_IG_STREAM_ID,
+        PSR_PRIMARY_AUDIO_ID,
+        PSR_PG_STREAM,
+        PSR_ANGLE_NUMBER,
+        PSR_TITLE_NUMBER,
+        PSR_CHAPTER,
+        PSR_PLAYLIST,
+        PSR_PLAYITEM,
+        PSR_TIME,
+        PSR_SECONDARY_AUDIO_VIDEO,
+        PSR_3D_STATUS,
+        102,
+        103,
+    };
+
+    bd_psr_register_cb_filter(bd->regs, _process_psr_event, bd, psrs, sizeof(psrs) / sizeof(psrs[0]));
+}
+
 static void _queue_initial_psr_events(BLURAY *bd)
 {
     const uint32_t psrs[] = {
@@ -2926,8 +6970,13 @@ static int _play_hdmv(BLURAY *bd, unsigned id_ref)
     bd->title_type = title_hdmv;
 
     if (!bd->hdmv_vm) {
+        uint64_t t0 = bd_get_time_us();
         bd->hdmv_vm = hdmv_vm_init(bd->disc, bd->regs, bd->disc_info.num_titles,
                                    bd->disc_info.first_play_supported, bd->disc_info.top_menu_supported);
+        bd->profile.mobj_parse_us = bd_get_time_us() - t0;
+
+        hdmv_vm_set_profiling(bd->hdmv_vm, bd->hdmv_profile);
+        hdmv_vm_set_insn_budget(bd->hdmv_vm, bd->hdmv_insn_budget);
     }
 
     if (hdmv_vm_select_object(bd->hdmv_vm, id_ref)) {
@@ -3028,9 +7077,12 @@ int bd_play_title_internal(BLURAY *bd, unsigned title)
 int bd_play(BLURAY *bd)
 {
     int result;
+    uint64_t t0;
 
     bd_mutex_lock(&bd->mutex);
 
+    t0 = bd_get_time_us();
+
     /* reset player state */
 
     bd->title_type = title_undef;
@@ -3043,7 +7095,7 @@ int bd_play(BLURAY *bd)
         _init_event_queue(bd);
 
         bd_psr_lock(bd->regs);
-        bd_psr_register_cb(bd->regs, _process_psr_event, bd);
+        _register_psr_cb(bd);
         _queue_initial_psr_events(bd);
         bd_psr_unlock(bd->regs);
     }
@@ -3054,6 +7106,8 @@ int bd_play(BLURAY *bd)
 
     result = _play_title(bd, BLURAY_TITLE_FIRST_PLAY);
 
+    bd->profile.first_title_us = bd_get_time_us() - t0;
+
     bd_mutex_unlock(&bd->mutex);
 
     return result;
@@ -3203,6 +7257,11 @@ static void _process_hdmv_vm_event(BLURAY *bd, HDMV_EVENT *hev)
             _run_gc(bd, GC_CTRL_IG_END, 0);
             break;
 
+        case HDMV_EVENT_YIELD:
+            /* instruction budget used. Return to application, continue in next bd_read_ext() call. */
+            _queue_event(bd, BD_EVENT_IDLE, 0);
+            break;
+
         case HDMV_EVENT_END:
         case HDMV_EVENT_NONE:
         default:
@@ -3313,10 +7372,19 @@ static int _read_ext(BLURAY *bd, unsigned char *buf, int len, BD_EVENT *event)
 
 int bd_read_ext(BLURAY *bd, unsigned char *buf, int len, BD_EVENT *event)
 {
-    int ret;
-    bd_mutex_lock(&bd->mutex);
-    ret = _read_ext(bd, buf, len, event);
-    bd_mutex_unlock(&bd->mutex);
+    int      ret;
+    unsigned wait_ms, seq;
+
+    do {
+        bd_mutex_lock(&bd->mutex);
+        _start_read(bd);
+        ret = _read_ext(bd, buf, len, event);
+        /* deliver BD-J notifications queued while reading */
+        _bdj_flush_events(bd);
+        wait_ms = _pace_take_wait(bd, &seq);
+        bd_mutex_unlock(&bd->mutex);
+        /* pending event is returned before waiting */
+    } while (!ret && (!event || event->event == BD_EVENT_NONE) && _pace_wait(bd, wait_ms, seq));
     return ret;
 }
 
@@ -3325,7 +7393,7 @@ int bd_get_event(BLURAY *bd, BD_EVENT *event)
     if (!bd->event_queue) {
         _init_event_queue(bd);
 
-        bd_psr_register_cb(bd->regs, _process_psr_event, bd);
+        _register_psr_cb(bd);
         _queue_initial_psr_events(bd);
     }
 
@@ -3336,6 +7404,58 @@ int bd_get_event(BLURAY *bd, BD_EVENT *event)
     return 0;
 }
 
+int bd_wait_event(BLURAY *bd, BD_EVENT *event, unsigned timeout_ms)
+{
+    if (!bd->event_queue) {
+        bd_get_event(bd, NULL);
+    }
+
+    return _wait_event(bd, event, timeout_ms);
+}
+
+int bd_get_event_fd(BLURAY *bd)
+{
+#ifdef HAVE_EVENT_FD
+    BD_EVENT_QUEUE *eq;
+    int fd;
+
+    if (!bd->event_queue) {
+        bd_get_event(bd, NULL);
+    }
+    eq = bd->event_queue;
+    if (!eq) {
+        return -1;
+    }
+
+    bd_mutex_lock(&eq->mutex);
+
+    if (eq->notify[0] < 0) {
+        int notify[2];
+        if (pipe(notify) < 0) {
+            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "failed creating event notification pipe\n");
+        } else {
+            fcntl(notify[0], F_SETFL, fcntl(notify[0], F_GETFL) | O_NONBLOCK);
+            fcntl(notify[1], F_SETFL, fcntl(notify[1], F_GETFL) | O_NONBLOCK);
+            fcntl(notify[0], F_SETFD, FD_CLOEXEC);
+            fcntl(notify[1], F_SETFD, FD_CLOEXEC);
+            eq->notify[0] = notify[0];
+            eq->notify[1] = notify[1];
+
+            /* events queued before fd was created */
+            _notify_event(eq);
+        }
+    }
+    fd = eq->notify[0];
+
+    bd_mutex_unlock(&eq->mutex);
+
+    return fd;
+#else
+    (void)bd;
+    return -1;
+#endif
+}
+
 /*
  * user interaction
  */
@@ -3344,6 +7464,7 @@ static void _set_scr(BLURAY *bd, int64_t pts)
 {
     if (pts >= 0) {
         bd_psr_write(bd->regs, PSR_TIME, (uint32_t)(((uint64_t)pts) >> 1));
+        _pace_set_scr(bd, pts);
     }
 }
 
@@ -3371,12 +7492,10 @@ int bd_mouse_select(BLURAY *bd, int64_t pts, uint16_t x, uint16_t y)
     return result;
 }
 
-int bd_user_input(BLURAY *bd, int64_t pts, uint32_t key)
+static int _user_input(BLURAY *bd, int64_t pts, uint32_t key)
 {
     int result = -1;
 
-    bd_mutex_lock(&bd->mutex);
-
     _set_scr(bd, pts);
 
     if (bd->title_type == title_hdmv) {
@@ -3387,12 +7506,43 @@ int bd_user_input(BLURAY *bd, int64_t pts, uint32_t key)
 #endif
     }
 
+    return result;
+}
+
+int bd_user_input(BLURAY *bd, int64_t pts, uint32_t key)
+{
+    int result;
+
+    if (bd_mutex_trylock(&bd->mutex)) {
+        /* stream is being read. Queue input for the reading thread. */
+        bd_rwlock_wrlock(&bd->pub.lock);
+        if (bd->pub.num_keys < MAX_PENDING_KEYS) {
+            bd->pub.key_pts[bd->pub.num_keys] = pts;
+            bd->pub.key[bd->pub.num_keys]     = key;
+            bd->pub.num_keys++;
+            bd_rwlock_unlock(&bd->pub.lock);
+            _wake_event_waiter(bd);
+            return 0;
+        }
+        bd_rwlock_unlock(&bd->pub.lock);
+
+        bd_mutex_lock(&bd->mutex);
+    }
+
+    /* keep input order */
+    _run_pending_input(bd);
+
+    result = _user_input(bd, pts, key);
+
     bd_mutex_unlock(&bd->mutex);
 
+    _wake_event_waiter(bd);
+
     return result;
 }
 
-void bd_register_overlay_proc(BLURAY *bd, void *handle, bd_overlay_proc_f func)
+static void _register_overlay_proc(BLURAY *bd, void *handle, bd_overlay_proc_f func,
+                                   bd_overlay_list_proc_f list_func)
 {
     if (!bd) {
         return;
@@ -3400,18 +7550,43 @@ void bd_register_overlay_proc(BLURAY *bd, void *handle, bd_overlay_proc_f func)
 
     bd_mutex_lock(&bd->mutex);
 
+    _stop_preload_thread(&bd->st_ig);
+    _stop_preload_thread(&bd->st_textst);
+
     gc_free(&bd->graphics_controller);
 
-    if (func) {
+    if (func || list_func) {
         bd->graphics_controller = gc_init(bd->regs, handle, func);
+        if (list_func) {
+            gc_set_overlay_list_proc(bd->graphics_controller, handle, list_func);
+        }
+        gc_set_overlay_index(bd->graphics_controller, bd->overlay_index);
+        gc_set_overlay_argb(bd->graphics_controller, bd->overlay_argb);
+        gc_set_memory_limit(bd->graphics_controller, (uint64_t)bd->graphics_memory_kb * 1024);
+        gc_set_ig_decode_threads(bd->graphics_controller, bd->ig_decode_threads);
+        if (bd->graphics_controller && bd->graphics_thread) {
+            gc_start_pg_thread(bd->graphics_controller);
+            gc_start_textst_thread(bd->graphics_controller);
+        }
     }
 
     bd_mutex_unlock(&bd->mutex);
 }
 
-void bd_register_argb_overlay_proc(BLURAY *bd, void *handle, bd_argb_overlay_proc_f func, BD_ARGB_BUFFER *buf)
+void bd_register_overlay_proc(BLURAY *bd, void *handle, bd_overlay_proc_f func)
+{
+    _register_overlay_proc(bd, handle, func, NULL);
+}
+
+void bd_register_overlay_list_proc(BLURAY *bd, void *handle, bd_overlay_list_proc_f func)
 {
+    _register_overlay_proc(bd, handle, NULL, func);
+}
+
 #ifdef USING_BDJAVA
+static void _register_argb_overlay_proc(BLURAY *bd, void *handle, bd_argb_overlay_proc_f func,
+                                        BD_ARGB_BUFFER *buf, BD_ARGB_BUFFER_EXT *ext)
+{
     if (!bd) {
         return;
     }
@@ -3421,8 +7596,32 @@ void bd_register_argb_overlay_proc(BLURAY *bd, void *handle, bd_argb_overlay_pro
     bd->argb_overlay_proc        = func;
     bd->argb_overlay_proc_handle = handle;
     bd->argb_buffer              = buf;
+    bd->argb_buffer_ext          = ext;
+
+    if (ext && ext->num_buffers == 3) {
+        _argb_buffer_init(ext);
+    }
 
     bd_mutex_unlock(&bd->argb_buffer_mutex);
+}
+#endif
+
+void bd_register_argb_overlay_proc(BLURAY *bd, void *handle, bd_argb_overlay_proc_f func, BD_ARGB_BUFFER *buf)
+{
+#ifdef USING_BDJAVA
+    _register_argb_overlay_proc(bd, handle, func, buf, NULL);
+#else
+    (void)bd;
+    (void)handle;
+    (void)func;
+    (void)buf;
+#endif
+}
+
+void bd_register_argb_overlay_proc2(BLURAY *bd, void *handle, bd_argb_overlay_proc_f func, BD_ARGB_BUFFER_EXT *buf)
+{
+#ifdef USING_BDJAVA
+    _register_argb_overlay_proc(bd, handle, func, buf ? &buf->base : NULL, buf);
 #else
     (void)bd;
     (void)handle;
@@ -3431,31 +7630,73 @@ void bd_register_argb_overlay_proc(BLURAY *bd, void *handle, bd_argb_overlay_pro
 #endif
 }
 
+int bd_set_es_pids(BLURAY *bd, const uint16_t *pids, unsigned num_pids, void *handle, bd_es_proc_f func)
+{
+    M2TS_DEMUX *demux = NULL;
+    unsigned    ii;
+
+    if (!bd || num_pids > BD_ES_MAX_PIDS || (num_pids && !pids)) {
+        return 0;
+    }
+
+    if (num_pids && func) {
+        demux = m2ts_demux_init(pids[0]);
+        if (!demux) {
+            return 0;
+        }
+        for (ii = 1; ii < num_pids; ii++) {
+            if (m2ts_demux_add_pid(demux, pids[ii]) < 0) {
+                m2ts_demux_free(&demux);
+                return 0;
+            }
+        }
+    }
+
+    bd_mutex_lock(&bd->mutex);
+
+    m2ts_demux_free(&bd->es_demux);
+
+    bd->es_demux       = demux;
+    bd->es_num_pids    = demux ? num_pids : 0;
+    bd->es_proc        = demux ? func : NULL;
+    bd->es_proc_handle = demux ? handle : NULL;
+    for (ii = 0; ii < bd->es_num_pids; ii++) {
+        bd->es_pids[ii] = pids[ii];
+    }
+
+    bd_mutex_unlock(&bd->mutex);
+
+    return 1;
+}
+
 int bd_get_sound_effect(BLURAY *bd, unsigned sound_id, BLURAY_SOUND_EFFECT *effect)
 {
+    int result = 0;
+
     if (!bd || !effect) {
         return -1;
     }
 
-    if (!bd->sound_effects) {
+    bd_mutex_lock(&bd->mutex);
 
-        bd->sound_effects = sound_get(bd->disc);
-        if (!bd->sound_effects) {
-            return -1;
-        }
-    }
+    _load_sound_effects(bd);
 
-    if (sound_id < bd->sound_effects->num_sounds) {
+    if (!bd->sound_effects) {
+        result = -1;
+
+    } else if (sound_id < bd->sound_effects->num_sounds) {
         SOUND_OBJECT *o = &bd->sound_effects->sounds[sound_id];
 
         effect->num_channels = o->num_channels;
         effect->num_frames   = o->num_frames;
         effect->samples      = (const int16_t *)o->samples;
 
-        return 1;
+        result = 1;
     }
 
-    return 0;
+    bd_mutex_unlock(&bd->mutex);
+
+    return result;
 }
 
 /*
@@ -3500,6 +7741,7 @@ struct clpi_cl *bd_get_clpi(BLURAY *bd, unsigned clip_ref)
 {
     if (bd->title && clip_ref < bd->title->clip_list.count) {
         NAV_CLIP *clip = &bd->title->clip_list.clip[clip_ref];
+        nav_clip_load(clip);
         return clpi_copy(clip->cl);
     }
     return NULL;
@@ -3515,6 +7757,21 @@ void bd_free_clpi(struct clpi_cl *cl)
     clpi_free(cl);
 }
 
+uint32_t bd_clpi_lookup_spn(const struct clpi_cl *cl, uint32_t timestamp, int before, uint8_t stc_id)
+{
+    return clpi_lookup_spn(cl, timestamp, before, stc_id);
+}
+
+uint32_t bd_clpi_access_point(const struct clpi_cl *cl, uint32_t pkt, int next, int angle_change, uint32_t *time)
+{
+    return clpi_access_point(cl, pkt, next, angle_change, time);
+}
+
+size_t bd_clpi_memory_size(const struct clpi_cl *cl)
+{
+    return clpi_memory_size(cl);
+}
+
 struct mpls_pl *bd_read_mpls(const char *mpls_file)
 {
     return mpls_parse(mpls_file);
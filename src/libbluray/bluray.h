@@ -31,6 +31,7 @@ extern "C" {
  * external API header
  */
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define TITLES_ALL              0    /**< all titles. */
@@ -285,6 +286,95 @@ typedef struct bd_sound_effect {
  */
 void bd_get_version(int *major, int *minor, int *micro);
 
+/*
+ * Thread placement
+ */
+
+typedef void (*bd_thread_start_f)(void *handle, const char *name);
+
+/**
+ *  Register thread start callback
+ *
+ *  Callback is called in each thread created by the library, before the thread
+ *  does any work. Application can use it to set priority, CPU affinity etc.
+ *  of the calling thread.
+ *  name identifies thread role ("bd_read_ahead", "bd_preload", "bd_pg", ...).
+ *  Where supported, the same name is also set as OS thread name.
+ *
+ *  BD-J: callback is called in BD-J thread pool and application proxy threads
+ *  (name is Java thread name). Threads created internally by the JVM
+ *  (garbage collector, compiler, ...) are not covered.
+ *
+ *  Global setting. Should be changed only when no library threads are
+ *  running (ex. before opening any discs).
+ *
+ * @param handle  opaque handle passed to callback
+ * @param func    callback function (NULL to disable)
+ */
+void bd_set_thread_start_handler(void *handle, bd_thread_start_f func);
+
+/*
+ * AACS decryptor plugin
+ *
+ * Replaces libaacs in AACS unit decryption (ex. with a hardware crypto
+ * engine). libaacs is still required: it authenticates the drive and provides
+ * the CPS unit keys. Plugin is not used if bus encryption is enabled or if
+ * libaacs can't provide the unit key; libaacs decrypts the stream then.
+ *
+ * Units are 6144-byte aligned units (32 source packets). Decryption is done
+ * in place.
+ */
+
+typedef struct bd_decryptor {
+    void *handle;  /* opaque handle passed to open() */
+
+    /* create decryption context for 16-byte CPS unit key (key must be copied).
+     * Called when stream is opened and when title (unit key) changes.
+     * Return NULL to let libaacs decrypt the units. */
+    void *(*open)(void *handle, const uint8_t *unit_key);
+
+    /* release decryption context */
+    void  (*close)(void *ctx);
+
+    /* decrypt num_units units. Return 0 on success, -1 on error. */
+    int   (*decrypt)(void *ctx, uint8_t *buf, unsigned num_units);
+
+    /* optional asynchronous interface (both or none).
+     * submit() queues units for decryption, wait() blocks until all queued
+     * units are decrypted. Stream data is read while earlier units are being
+     * decrypted. Return 0 on success, -1 on error. */
+    int   (*submit)(void *ctx, uint8_t *buf, unsigned num_units);
+    int   (*wait)(void *ctx);
+} BD_DECRYPTOR;
+
+/**
+ *  Register AACS decryptor plugin
+ *
+ *  Global setting. Used by discs opened after the call.
+ *  Callbacks may be called from several threads, but each context is
+ *  used by one thread at a time.
+ *
+ * @param decryptor  plugin functions (copied), NULL to use libaacs only
+ */
+void bd_set_decryptor(const BD_DECRYPTOR *decryptor);
+
+/**
+ *  Record file I/O trace
+ *
+ *  Every file open, seek, read and close done by the library (and UDF image
+ *  block reads) is written to trace file with offsets, sizes and timing.
+ *  Trace can be replayed with io_replay (examples).
+ *
+ *  With bd_open_stream(), application read_blocks() calls are recorded as
+ *  block reads.
+ *
+ *  Global setting. Should be changed only when no discs are open.
+ *
+ * @param trace_file  trace file to create, NULL to stop tracing
+ * @return 1 on success, 0 on error
+ */
+int bd_set_io_trace(const char *trace_file);
+
 /*
  * Disc functions
  */
@@ -331,6 +421,26 @@ int bd_open_stream(BLURAY *bd,
                    void *read_blocks_handle,
                    int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks));
 
+/**
+ *  Open BluRay disc with read-ahead hints
+ *
+ *  Like bd_open_stream(), but the library also tells which disc blocks will
+ *  be read soon (ex. start of next clip). Stream inputs with high latency
+ *  (network) can use the hints to issue requests ahead of time.
+ *
+ *  prefetch_blocks() is called from library threads and must not block.
+ *
+ * @param bd  BLURAY object
+ * @param handle  opaque handle for read_blocks and prefetch_blocks
+ * @param read_blocks  function used to read disc blocks
+ * @param prefetch_blocks  function receiving read-ahead hints (lba, number of blocks)
+ * @return 1 on success, 0 if error
+ */
+int bd_open_stream_prefetch(BLURAY *bd,
+                            void *read_blocks_handle,
+                            int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks),
+                            void (*prefetch_blocks)(void *handle, int lba, int num_blocks));
+
 /**
  *  Close BluRay disc
  *
@@ -347,6 +457,79 @@ void bd_close(BLURAY *bd);
  */
 const BLURAY_DISC_INFO *bd_get_disc_info(BLURAY *bd);
 
+/*
+ * Lightweight disc probing
+ */
+
+#define BD_PROBE_PLAYLISTS  0x01  /* scan playlist headers (playlist count, main title). Slower. */
+
+typedef struct bd_probe_info {
+    uint8_t  bluray_detected;
+    uint8_t  aacs_detected;       /* AACS is used (libaacs is not loaded) */
+    uint8_t  bdplus_detected;     /* BD+ is used (libbdplus is not loaded) */
+    uint8_t  bdj_detected;        /* disc uses BD-J */
+
+    uint32_t num_titles;
+    uint32_t num_hdmv_titles;
+    uint32_t num_bdj_titles;
+
+    uint8_t  video_format;        /* bd_video_format_e */
+    uint8_t  frame_rate;          /* bd_frame_rate_e */
+    uint8_t  content_exist_3D;
+
+    char     bdj_org_id[9];       /* (BD-J) disc organization ID */
+    char     bdj_disc_id[33];     /* (BD-J) disc ID */
+
+    /* BD_PROBE_PLAYLISTS */
+    uint32_t num_playlists;       /* relevant playlists (duplicates filtered) */
+    uint32_t main_playlist;       /* mpls file number of main title */
+    uint64_t main_title_duration; /* 90 kHz */
+} BLURAY_PROBE_INFO;
+
+/**
+ *
+ *  Get basic information about disc without opening it for playback.
+ *  Reads only index.bdmv, id.bdmv and AACS / BD+ presence files (and playlist
+ *  headers with BD_PROBE_PLAYLISTS). Decryption libraries, BD-J and HDMV VM
+ *  are not initialized. Intended for media library scanning.
+ *
+ * @param device_path  path to mounted Blu-ray disc, device or image file
+ * @param info  probe result
+ * @param flags  BD_PROBE_* flags
+ * @return 1 if Blu-ray disc was detected, 0 otherwise
+ */
+int bd_probe(const char *device_path, BLURAY_PROBE_INFO *info, uint32_t flags);
+
+/*
+ * Startup profiling
+ */
+
+/* startup phase durations in microseconds (monotonic clock). 0 = phase not run. */
+typedef struct bd_startup_profile {
+    uint64_t open_us;            /* bd_open_disc() / bd_open_stream() total */
+    uint64_t disc_open_us;       /* filesystem / UDF image open (includes dec_init_us) */
+    uint64_t dec_init_us;        /* AACS / BD+ initialization */
+    uint64_t fill_disc_info_us;  /* disc info (includes index_parse_us) */
+    uint64_t index_parse_us;     /* index.bdmv */
+    uint64_t title_scan_us;      /* latest bd_get_titles() / bd_get_titles_async() playlist scan */
+    uint64_t mobj_parse_us;      /* HDMV VM initialization (MovieObject.bdmv) */
+    uint64_t create_jvm_us;      /* Java VM creation */
+    uint64_t bdj_init_us;        /* BD-J environment initialization */
+    uint64_t bdj_start_us;       /* BD-J start (includes create_jvm_us and bdj_init_us) */
+    uint64_t first_title_us;     /* bd_play(): first play title start */
+} BLURAY_STARTUP_PROFILE;
+
+/**
+ *
+ *  Get startup phase timings
+ *
+ *  Phases are recorded as they are run (disc open, bd_get_titles(), bd_play(), BD-J start).
+ *
+ * @param bd  BLURAY object
+ * @return pointer to BLURAY_STARTUP_PROFILE object, NULL on error
+ */
+const BLURAY_STARTUP_PROFILE *bd_get_startup_profile(BLURAY *bd);
+
 /**
  *
  *  Get meta information about current BluRay disc.
@@ -381,6 +564,60 @@ const struct meta_dl *bd_get_meta(BLURAY *bd);
  */
 uint32_t bd_get_titles(BLURAY *bd, uint8_t flags, uint32_t min_title_length);
 
+/* bd_get_titles_async() callback status */
+typedef enum {
+    BD_TITLE_SCAN_PROGRESS = 0,  /* playlist processed, no new title */
+    BD_TITLE_SCAN_TITLE    = 1,  /* new title found (title_idx, playlist, duration) */
+    BD_TITLE_SCAN_DONE     = 2,  /* scan complete, title list is available */
+    BD_TITLE_SCAN_FAILED   = 3,  /* scan failed or was cancelled */
+} bd_title_scan_status_e;
+
+typedef struct bd_title_scan {
+    uint32_t status;       /* bd_title_scan_status_e */
+    uint32_t scanned;      /* playlists processed */
+    uint32_t total;        /* playlists to process */
+    uint32_t title_count;  /* titles found so far */
+    uint32_t main_title;   /* current main title guess (title index) */
+
+    /* new title (BD_TITLE_SCAN_TITLE) */
+    uint32_t title_idx;
+    uint32_t playlist;
+    uint64_t duration;     /* 90 kHz */
+} BLURAY_TITLE_SCAN;
+
+/**
+ *
+ *  Start asynchronous title list scan
+ *
+ *  Same as bd_get_titles(), but playlists are parsed in background thread.
+ *  Titles are reported to callback (from scan thread) as they are found.
+ *  Titles are found in the same order and with the same indexes as from bd_get_titles().
+ *  Title list functions (bd_select_title(), bd_get_title_info(), ...) can be used
+ *  after BD_TITLE_SCAN_DONE has been reported.
+ *  Playlists can be played with bd_select_playlist() while the scan is running.
+ *
+ * @param bd  BLURAY object
+ * @param flags  title flags
+ * @param min_title_length  filter out titles shorter than min_title_length seconds
+ * @param cb  progress callback
+ * @param handle  application handle passed to callback
+ * @return 1 if scan was started, 0 on error
+ */
+int bd_get_titles_async(BLURAY *bd, uint8_t flags, uint32_t min_title_length,
+                        void (*cb)(void *handle, const BLURAY_TITLE_SCAN *scan), void *handle);
+
+/**
+ *
+ *  Cancel asynchronous title list scan
+ *
+ *  Waits until scan thread has stopped. If the scan was not complete,
+ *  BD_TITLE_SCAN_FAILED is reported and title list is not available.
+ *  Must not be called from the scan callback.
+ *
+ * @param bd  BLURAY object
+ */
+void bd_cancel_title_scan(BLURAY *bd);
+
 /**
  *
  *  Get main title
@@ -410,6 +647,74 @@ BLURAY_TITLE_INFO* bd_get_title_info(BLURAY *bd, uint32_t title_idx, unsigned an
  */
 void bd_free_title_info(BLURAY_TITLE_INFO *title_info);
 
+/**
+ *
+ *  Get information about all titles in title list
+ *
+ *  Playlists and clip info files are parsed only once for all titles.
+ *  Titles that can't be opened have only idx and playlist set.
+ *
+ * @param bd  BLURAY object
+ * @param angle angle number (chapter offsets and clip size depend on selected angle)
+ * @param count number of titles in returned array
+ * @return array of BLURAY_TITLE_INFO objects indexed by title number, NULL on error.
+ *         Must be freed with bd_free_all_title_info().
+ */
+BLURAY_TITLE_INFO *bd_get_all_title_info(BLURAY *bd, unsigned angle, uint32_t *count);
+
+/**
+ *
+ *  Free BLURAY_TITLE_INFO array from bd_get_all_title_info()
+ *
+ * @param title_info  array returned by bd_get_all_title_info()
+ */
+void bd_free_all_title_info(BLURAY_TITLE_INFO *title_info);
+
+/* random access point */
+typedef struct bd_keyframe {
+    uint64_t        time;      /* title time (1/90000 s) */
+    uint64_t        offset;    /* title byte position (bd_seek()) */
+    uint32_t        clip_ref;  /* play item (clip) index */
+    uint32_t        clip_pkt;  /* source packet (192 bytes) in clip .m2ts file */
+} BLURAY_KEYFRAME;
+
+/**
+ *
+ *  Get random access points (EP map entries) of a title
+ *
+ * @param bd  BLURAY object
+ * @param title_idx title index number
+ * @param angle angle number
+ * @param count number of returned entries is stored here
+ * @return allocated array of BLURAY_KEYFRAME entries (in title order), NULL on error or if there are no entries
+ */
+BLURAY_KEYFRAME* bd_get_keyframes(BLURAY *bd, uint32_t title_idx, unsigned angle, uint32_t *count);
+
+/**
+ *
+ *  Free BLURAY_KEYFRAME array
+ *
+ * @param keyframes  array returned by bd_get_keyframes()
+ */
+void bd_free_keyframes(BLURAY_KEYFRAME *keyframes);
+
+/**
+ *
+ *  Get content fingerprint of a title
+ *
+ *  Fingerprint is SHA-1 of the playlist structure (clips, chapters, streams)
+ *  and of decrypted aligned units sampled at up to 32 random access points
+ *  spread evenly over the title. Sample positions are deterministic, so the
+ *  same title on different pressings gives the same fingerprint.
+ *  Only the sampled units are read from disc.
+ *
+ * @param bd  BLURAY object
+ * @param title_idx title index number
+ * @param fingerprint  20-byte buffer for fingerprint
+ * @return 1 on success, 0 on error
+ */
+int bd_get_title_fingerprint(BLURAY *bd, uint32_t title_idx, uint8_t fingerprint[20]);
+
 /**
  *
  *  Select the title from the list created by bd_get_titles()
@@ -450,6 +755,212 @@ uint32_t bd_get_current_title(BLURAY *bd);
  */
 int bd_read(BLURAY *bd, unsigned char *buf, int len);
 
+typedef struct bd_iovec {
+    void   *base;
+    size_t  len;
+} BD_IOVEC;
+
+/**
+ *
+ *  Read from currently selected title file to multiple buffers
+ *
+ *  Like bd_read(), but data is copied from internal aligned unit buffer
+ *  directly to the buffers, in order. Buffers are filled completely before
+ *  moving to next one. As with bd_read(), read may return less data at clip
+ *  boundary. Total size is limited to INT_MAX.
+ *
+ * @param bd  BLURAY object
+ * @param iov  buffers to read data into
+ * @param iovcnt  number of buffers
+ * @return size of data read, -1 if error, 0 if EOF
+ */
+int bd_readv(BLURAY *bd, const BD_IOVEC *iov, unsigned iovcnt);
+
+/*
+ * Reading with timing information
+ */
+
+typedef struct bd_unit_time {
+    uint32_t offset;  /* offset of data in read buffer */
+    uint32_t ats;     /* arrival time stamp of source packet at offset (27 MHz, 30 bits) */
+    int64_t  time;    /* title time of source packet at offset (90 kHz), -1 if unknown */
+} BD_UNIT_TIME;
+
+/**
+ *
+ *  Read from currently selected title file with per-unit timing
+ *
+ *  Like bd_read(), but an entry is returned for each aligned unit that
+ *  returned data comes from. Entry tells offset where data of the unit starts
+ *  in buf, and time of the (first complete) source packet there.
+ *
+ *  Time is system clock (PCR) mapped to title timeline, interpolated with
+ *  arrival time stamps between PCRs. It can be used to pace output in real
+ *  time; presentation time of the data is later by decoder delay.
+ *  PCRs are tracked after first call to this function. Time is -1 after seek
+ *  or clip change until first PCR has been read.
+ *
+ * @param bd  BLURAY object
+ * @param buf buffer to read data into
+ * @param len size of data to be read
+ * @param times  timing entries
+ * @param num_times  in: size of times array, out: number of entries filled
+ * @return size of data read, -1 if error, 0 if EOF
+ */
+int bd_read_timed(BLURAY *bd, unsigned char *buf, int len, BD_UNIT_TIME *times, unsigned *num_times);
+
+/*
+ * Asynchronous reading
+ */
+
+typedef void (*bd_read_cb_f)(void *ctx, unsigned char *buf, int result);
+
+/**
+ *
+ *  Queue read from currently selected title file
+ *
+ *  Requests are executed in order by a library thread, with the same
+ *  semantics as bd_read(). Result (size of data read, -1 if error, 0 if EOF)
+ *  is passed to the callback function.
+ *
+ *  Callback is called from the library thread. After bd_get_read_async_fd()
+ *  has been called, callbacks are called only from bd_dispatch_read_async().
+ *  bd_close() waits for the request being executed and cancels other
+ *  requests (callback is called with result -1).
+ *
+ *  Not usable in navigation mode (use bd_read_ext()).
+ *
+ * @param bd  BLURAY object
+ * @param buf buffer to read data into. Must stay valid until callback has been called.
+ * @param len size of data to be read
+ * @param func  callback function
+ * @param ctx  application-specific handle that will be passed to callback function
+ * @return 1 if request was queued, 0 if error
+ */
+int bd_read_async(BLURAY *bd, unsigned char *buf, int len, bd_read_cb_f func, void *ctx);
+
+/**
+ *
+ *  Get file descriptor for polling asynchronous read completion
+ *
+ *  Descriptor becomes readable when queued reads have completed.
+ *  Application should then call bd_dispatch_read_async().
+ *  Descriptor is owned by the library and closed in bd_close().
+ *
+ * @param bd  BLURAY object
+ * @return file descriptor, -1 if not supported on this platform
+ */
+int bd_get_read_async_fd(BLURAY *bd);
+
+/**
+ *
+ *  Call callbacks of completed asynchronous reads
+ *
+ *  Callbacks are called from the calling thread.
+ *
+ * @param bd  BLURAY object
+ * @return number of completed requests
+ */
+int bd_dispatch_read_async(BLURAY *bd);
+
+/*
+ * Fan-out reading: one stream delivered to multiple consumers
+ */
+
+/**
+ *
+ *  Start reading currently selected title for multiple consumers
+ *
+ *  A library thread reads (and decrypts) the title once into a shared ring buffer.
+ *  Each reader (0 ... num_readers-1) consumes the whole stream from current
+ *  position with its own cursor. Ring space is reused when all readers have
+ *  consumed it: the slowest reader limits the read rate.
+ *
+ *  Readers that stop early must call bd_fanout_detach().
+ *  Other reading and seeking functions must not be used until bd_fanout_stop().
+ *  Not usable in navigation mode.
+ *
+ * @param bd  BLURAY object
+ * @param num_readers  number of consumers
+ * @param ring_units  size of shared ring buffer (number of aligned units, 6144 bytes each)
+ * @return 1 on success, 0 if error
+ */
+int bd_fanout_start(BLURAY *bd, unsigned num_readers, unsigned ring_units);
+
+/**
+ *
+ *  Read data for one consumer
+ *
+ *  Blocks until data is available. Can be called from a different thread for each reader.
+ *
+ * @param bd  BLURAY object
+ * @param reader  reader index
+ * @param buf  buffer to read data into
+ * @param len  size of buffer
+ * @return size of data read, -1 if error, 0 if EOF
+ */
+int bd_fanout_read(BLURAY *bd, unsigned reader, unsigned char *buf, int len);
+
+/**
+ *
+ *  Stop consuming data
+ *
+ *  Releases ring space held by the reader. When all readers are detached,
+ *  the library thread stops reading.
+ *
+ * @param bd  BLURAY object
+ * @param reader  reader index
+ */
+void bd_fanout_detach(BLURAY *bd, unsigned reader);
+
+/**
+ *
+ *  Stop fan-out reading
+ *
+ *  No reader may be blocked in bd_fanout_read(). Called automatically from bd_close().
+ *
+ * @param bd  BLURAY object
+ */
+void bd_fanout_stop(BLURAY *bd);
+
+/*
+ * Zero-copy access to aligned units
+ */
+
+typedef struct bd_units {
+    const uint8_t *data;       /* first aligned unit (6144 bytes per unit) */
+    unsigned       num_units;  /* number of contiguous units at data */
+    const void    *buffer;     /* internal: reference-counted buffer holding the units */
+} BLURAY_UNITS;
+
+/**
+ *
+ *  Read whole decrypted aligned units from currently selected title without copying.
+ *
+ *  Returned units point to library internal buffer. Units stay valid until
+ *  released with bd_release_units(), also after following read or seek calls.
+ *  All units must be released before bd_close().
+ *
+ *  Units are returned as they are stored on disc (after stream filtering):
+ *  first unit after seek and last unit of a clip may contain packets outside of the clip range.
+ *  Can't be mixed with bd_read() in the middle of an aligned unit.
+ *  Not usable in navigation mode (use bd_read_ext()).
+ *
+ * @param bd  BLURAY object
+ * @param units  filled with returned units
+ * @param max_units  maximum number of units to return
+ * @return number of units read, -1 if error, 0 if EOF
+ */
+int bd_read_units(BLURAY *bd, BLURAY_UNITS *units, unsigned max_units);
+
+/**
+ *
+ *  Release units returned by bd_read_units()
+ *
+ * @param units  units to release
+ */
+void bd_release_units(BLURAY_UNITS *units);
+
 
 /*
  * Playback control functions
@@ -474,6 +985,34 @@ int64_t bd_seek(BLURAY *bd, uint64_t pos);
  */
 int64_t bd_seek_time(BLURAY *bd, uint64_t tick);
 
+/* result of bd_seek_time_ext() */
+typedef struct bd_seek_info {
+    uint64_t  pos;          /* title byte position (same as return value) */
+    uint64_t  ep_time;      /* title time of random access point where reading continues (90 kHz) */
+    uint64_t  target_time;  /* requested title time (90 kHz) */
+    uint64_t  ep_pts;       /* stream PTS of random access point (90 kHz) */
+    uint64_t  target_pts;   /* stream PTS of requested time (90 kHz) */
+    uint32_t  clip_ref;     /* play item (clip) index */
+} BLURAY_SEEK_INFO;
+
+/**
+ *
+ * Seek to specific time in 90Khz ticks, with target timestamps
+ *
+ * Like bd_seek_time(), reading continues from random access point (EP map entry)
+ * at or before requested time. Stream timestamps of random access point and
+ * requested time are returned in info, and queued as BD_EVENT_SEEK_EP_PTS and
+ * BD_EVENT_SEEK_TARGET_PTS events after BD_EVENT_SEEK.
+ * Decoder can drop frames before target PTS without displaying them, and
+ * skip decoding of non-reference frames before it.
+ *
+ * @param bd    BLURAY ojbect
+ * @param tick  tick count
+ * @param info  seek result is stored here (can be NULL)
+ * @return current seek position
+ */
+int64_t bd_seek_time_ext(BLURAY *bd, uint64_t tick, BLURAY_SEEK_INFO *info);
+
 /**
  *
  *  Seek to a chapter. First chapter is 0
@@ -623,8 +1162,36 @@ typedef enum {
     BLURAY_PLAYER_SETTING_PLAYER_PROFILE = 31,    /* Player profile and version. */
 
     BLURAY_PLAYER_SETTING_DECODE_PG      = 0x100, /* Enable/disable PG (subtitle) decoder. Integer. */
+    BLURAY_PLAYER_SETTING_READ_AHEAD     = 0x101, /* Background read-ahead of main stream. Integer (number of aligned units, 0 = disabled). */
+    BLURAY_PLAYER_SETTING_DECRYPT_THREADS = 0x102, /* Number of AACS decryption threads. Integer (0 = decrypt in reading thread). */
+    BLURAY_PLAYER_SETTING_UNIT_CACHE     = 0x103, /* Cache of decrypted main stream units. Integer (number of aligned units, 0 = disabled). */
+    BLURAY_PLAYER_SETTING_TRACE          = 0x104, /* Binary trace of stream access. Integer (number of trace records, 0 = disabled). */
+    BLURAY_PLAYER_SETTING_SCAN_THREADS   = 0x105, /* Playlist parsing threads in bd_get_titles(). Integer (0 = number of CPUs, max 8). */
+    BLURAY_PLAYER_SETTING_NAV_CACHE      = 0x106, /* Persistent bd_get_titles() and bd_get_meta() result cache in user cache directory. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_SHARED_CACHE   = 0x107, /* Share parsed playlists and clip info with other BLURAY objects that have the same disc open in this process. Set after opening the disc. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_LAZY_DECRYPT   = 0x108, /* Load libaacs / libbdplus when first protected stream is opened. Set before opening the disc. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_GRAPHICS_THREAD = 0x109, /* Decode and render main path PG (subtitle) stream in separate thread instead of bd_read(), and pre-render upcoming TextST dialogs in background. PG overlay callbacks are called from that thread. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_PG_PREROLL     = 0x10A, /* After seek, decode main path PG stream from this window before seek point so that subtitle visible at seek point is shown. Integer (milliseconds, 0 = disabled (default), max 10000). */
+    BLURAY_PLAYER_SETTING_OVERLAY_INDEX  = 0x10B, /* Include 8-bit palette index image (BD_OVERLAY.index_img) in overlay DRAW events, for GPU-side palette lookup. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_GRAPHICS_MEMORY = 0x10C, /* Memory budget for decoded IG menu objects. Objects not used in current menu page are freed and decoded again when needed. Applies to objects decoded after setting. Integer (kilobytes, 0 = unlimited (default)). */
+    BLURAY_PLAYER_SETTING_HDMV_PROFILE   = 0x10D, /* Collect per-movie object HDMV VM statistics (bd_get_hdmv_object_stats(), bd_dump_hdmv_profile()). Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_HDMV_BUDGET    = 0x10E, /* Max. HDMV instructions executed in one bd_read_ext() / bd_get_event() call. When used, BD_EVENT_IDLE is returned and execution continues in next call. Integer (0 = unlimited (default)). */
+    BLURAY_PLAYER_SETTING_BDJ_KEEP_WARM  = 0x10F, /* Keep BD-J stack (action queue threads, FreeType library, system fonts) running when BD-J is stopped or disc is closed. Only disc state is released; next disc starts faster. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_SHARED_DECRYPT = 0x110, /* Share AACS session (libaacs instance) with other BLURAY objects that have the same device path and key file open in this process. AACS is initialized only once; BD+ is not shared. Set before opening the disc. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_PACING         = 0x111, /* Rate-paced output: main path units are returned from bd_read() and friends at playback rate, this much ahead of wall clock. Anchored at start / seek, steered with bd_set_scr(). Reading blocks until next unit is due. Integer (lead in milliseconds, 0 = disabled (default), max 10000). */
+    BLURAY_PLAYER_SETTING_TIMER_THREAD   = 0x112, /* Run IG menu effects, animations and user timeouts, and end timed stills, from internal timer thread instead of bd_read_ext() / bd_get_event(). IG overlay callbacks are called from that thread. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_LOW_MEMORY     = 0x113, /* Low-memory profile for embedded players. Caps read-ahead, unit cache and fan-out buffers (1M / 1M / 2M), IG object memory (4M), parsed playlist / clip info cache (1M) and event queue growth. Explicit larger values of other settings are reduced while enabled. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_ASYNC_PRELOAD  = 0x114, /* Load IG (menu) and TextST (subtitle) sub path clips in background thread instead of blocking playlist start. BD_EVENT_SUBPATH_READY is queued when loading completes. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_CONTINUOUS_READ = 0x115, /* Do not split bd_read() / bd_read_ext() at seamless clip boundaries. Boundary position in returned data is reported with BD_EVENT_SEAMLESS_CLIP. Reads are still split at non-seamless boundaries, angle changes and trick-play jumps. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_DIRECT_IO      = 0x116, /* Read m2ts stream files with unbuffered (O_DIRECT / FILE_FLAG_NO_BUFFERING) I/O, bypassing OS page cache. For servers streaming many discs at once. Metadata files are still read with buffered I/O. Falls back to buffered I/O if not supported. Set before opening the disc. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_PLAYLIST_PREFETCH = 0x117, /* When HDMV menu is opened, parse playlists and clip info files that menu buttons can start (directly or through title movie object) and prefetch start of first clip in background thread. Targets of selected button are loaded first. Reduces playback start delay after button activation. Integer (0 = disabled (default), 1 = enabled). */
+    BLURAY_PLAYER_SETTING_IG_DECODE_THREADS = 0x118, /* Number of threads decoding HDMV menu (IG) graphic objects. Objects of display set are decoded in parallel, reducing menu start delay when menu has many (animated) buttons. Integer (0 = decode in calling thread (default), max 9). */
+    BLURAY_PLAYER_SETTING_READ_ERROR_BUDGET = 0x119, /* Adaptive skipping of damaged disc areas. After read error, skip distance is doubled after each failed unit and moved to next entry point; start of readable data is then searched with binary search for at most given time. Integer (milliseconds, 0 = skip one unit after each read error (default)). */
+    BLURAY_PLAYER_SETTING_DRIVE_SPEED = 0x11A, /* Optical drive read speed control (Linux). Drive is slowed down to reduce noise and power use; main path read-ahead is enabled to cover drive spin-up. Integer (KB/s, 0 = drive default (default), 1 = automatic: clip recording rate + 50%, at least 1x BD speed). */
+    BLURAY_PLAYER_SETTING_OVERLAY_ARGB = 0x11B, /* Include palette-applied ARGB image (BD_OVERLAY.argb_img) in overlay DRAW events. Images are cached in graphics objects; all button state and animation images of current menu page are expanded when page is shown, so button state changes only reference cached images (identified by object_serial and palette_serial). Integer (0 = disabled (default), 1 = enabled). */
     BLURAY_PLAYER_PERSISTENT_ROOT        = 400,   /* Root path to the BD_J persistent storage location. String. */
     BLURAY_PLAYER_CACHE_ROOT             = 401,   /* Root path to the BD_J cache storage location. String. */
+    BLURAY_PLAYER_JVM_OPTIONS            = 402,   /* Extra Java VM options (heap size, GC, JIT), appended after built-in options and LIBBLURAY_JVM_OPTIONS environment variable. Used when JVM is created (first BD-J title in process). String (whitespace-separated options; "low-latency" = preset for short GC pauses and fast JIT warm-up: -XX:+UseG1GC -XX:MaxGCPauseMillis=10 -XX:TieredStopAtLevel=1). */
 } bd_player_setting;
 
 /**
@@ -715,7 +1282,8 @@ typedef enum {
      * status
      */
 
-    /* Nothing to do. Playlist is not playing, but title applet is running. */
+    /* Nothing to do. Playlist is not playing, but title applet is running.
+     * Also returned when HDMV program is still running after BLURAY_PLAYER_SETTING_HDMV_BUDGET instructions. */
     BD_EVENT_IDLE                   = 29,
 
     /* Pop-Up menu available */
@@ -727,7 +1295,17 @@ typedef enum {
     /* 3D */
     BD_EVENT_STEREOSCOPIC_STATUS    = 27,  /* 0 - 2D, 1 - 3D */
 
-    /*BD_EVENT_LAST = 31, */
+    /* Sub path loaded in background (BLURAY_PLAYER_SETTING_ASYNC_PRELOAD) */
+    BD_EVENT_SUBPATH_READY          = 32,  /* 1 - IG (menu), 2 - TextST (subtitles) */
+
+    /* Seamless clip boundary inside last read (BLURAY_PLAYER_SETTING_CONTINUOUS_READ) */
+    BD_EVENT_SEAMLESS_CLIP          = 33,  /* byte offset of next clip in returned data */
+
+    /* Seek target (bd_seek_time_ext()). Queued after BD_EVENT_SEEK. */
+    BD_EVENT_SEEK_EP_PTS            = 34,  /* PTS of random access point where reading continues (45 kHz) */
+    BD_EVENT_SEEK_TARGET_PTS        = 35,  /* requested PTS (45 kHz). Frames before it are not displayed. */
+
+    /*BD_EVENT_LAST = 35, */
 
 } bd_event_e;
 
@@ -758,6 +1336,32 @@ typedef struct {
  */
 int  bd_get_event(BLURAY *bd, BD_EVENT *event);
 
+/**
+ *
+ *  Wait for event from libbluray event queue.
+ *
+ *  Can be used from a thread other than the one calling bd_read().
+ *
+ * @param bd  BLURAY object
+ * @param event next BD_EVENT from event queue
+ * @param timeout_ms maximum time to wait (may return earlier)
+ * @return 1 on success, 0 if no events
+ */
+int  bd_wait_event(BLURAY *bd, BD_EVENT *event, unsigned timeout_ms);
+
+/**
+ *
+ *  Get file descriptor for polling libbluray event queue.
+ *
+ *  Descriptor is readable while events are queued. Application should then
+ *  call bd_get_event() until it returns 0 (this clears the descriptor).
+ *  Descriptor is owned by the library and closed in bd_close().
+ *
+ * @param bd  BLURAY object
+ * @return file descriptor, -1 if not supported on this platform
+ */
+int  bd_get_event_fd(BLURAY *bd);
+
 
 /*
  * On-screen display
@@ -766,7 +1370,10 @@ int  bd_get_event(BLURAY *bd, BD_EVENT *event);
 struct bd_overlay_s;      /* defined in overlay.h */
 struct bd_argb_overlay_s; /* defined in overlay.h */
 struct bd_argb_buffer_s;  /* defined in overlay.h */
+struct bd_argb_buffer_ext_s; /* defined in overlay.h */
+struct bd_overlay_list_s; /* defined in overlay.h */
 typedef void (*bd_overlay_proc_f)(void *, const struct bd_overlay_s * const);
+typedef void (*bd_overlay_list_proc_f)(void *, const struct bd_overlay_list_s * const);
 typedef void (*bd_argb_overlay_proc_f)(void *, const struct bd_argb_overlay_s * const);
 
 /**
@@ -790,6 +1397,23 @@ typedef void (*bd_argb_overlay_proc_f)(void *, const struct bd_argb_overlay_s *
  */
 void bd_register_overlay_proc(BLURAY *bd, void *handle, bd_overlay_proc_f func);
 
+/**
+ *
+ *  Register handler for batched compressed YUV overlays
+ *
+ *  Alternative to bd_register_overlay_proc(): overlay events of each plane are
+ *  collected and delivered as one command list per FLUSH (see BD_OVERLAY_LIST).
+ *  Callback is called after internal graphics locks have been released.
+ *  Callback is called with NULL list when overlays are closed.
+ *
+ *  Registering this handler replaces handler registered with bd_register_overlay_proc().
+ *
+ * @param bd  BLURAY object
+ * @param handle  application-specific handle that will be passed to handler function
+ * @param func  handler function pointer
+ */
+void bd_register_overlay_list_proc(BLURAY *bd, void *handle, bd_overlay_list_proc_f func);
+
 /**
  *
  *  Register handler for ARGB overlays
@@ -807,6 +1431,59 @@ void bd_register_overlay_proc(BLURAY *bd, void *handle, bd_overlay_proc_f func);
  */
 void bd_register_argb_overlay_proc(BLURAY *bd, void *handle, bd_argb_overlay_proc_f func, struct bd_argb_buffer_s *buf);
 
+/**
+ *
+ *  Register handler for ARGB overlays with extended frame buffer
+ *
+ *  Same as bd_register_argb_overlay_proc(), but the application-allocated
+ *  frame buffer is BD_ARGB_BUFFER_EXT (triple buffering).
+ *  Since BD_OVERLAY_INTERFACE_VERSION 3.
+ *
+ * @param bd  BLURAY object
+ * @param handle  application-specific handle that will be passed to handler function
+ * @param func  handler function pointer
+ * @param buf  optional application-allocated extended frame buffer
+ */
+void bd_register_argb_overlay_proc2(BLURAY *bd, void *handle, bd_argb_overlay_proc_f func, struct bd_argb_buffer_ext_s *buf);
+
+
+/*
+ * Elementary stream extraction
+ */
+
+#define BD_ES_MAX_PIDS  8
+
+typedef struct bd_es_packet_s {
+    uint16_t       pid;
+    const uint8_t *data;  /* PES payload (valid only during callback) */
+    uint32_t       size;
+    int64_t        pts;   /* 90 kHz clip timestamp, -1 if not present */
+    int64_t        dts;   /* 90 kHz clip timestamp, -1 if not present */
+} BD_ES_PACKET;
+
+typedef void (*bd_es_proc_f)(void *, const BD_ES_PACKET * const);
+
+/**
+ *
+ *  Extract elementary streams of current playlist
+ *
+ *  Main path packets of the selected pids are reassembled to PES packets while
+ *  stream is read with bd_read() / bd_read_ext() / bd_read_units(). Each
+ *  complete PES payload is passed to handler function. Partially received
+ *  packets are dropped when playback position changes (seek, title change).
+ *
+ *  Callback function is called from the thread reading the stream, while
+ *  library internal lock is held. It must not call bd_*() functions.
+ *
+ * @param bd  BLURAY object
+ * @param pids  pids to extract (max. BD_ES_MAX_PIDS)
+ * @param num_pids  number of pids, 0 to stop extraction
+ * @param handle  application-specific handle that will be passed to handler function
+ * @param func  handler function pointer, NULL to stop extraction
+ * @return 1 on success, 0 if error
+ */
+int bd_set_es_pids(BLURAY *bd, const uint16_t *pids, unsigned num_pids, void *handle, bd_es_proc_f func);
+
 
 /*
  * Playback with on-disc menus
@@ -872,6 +1549,41 @@ int  bd_read_ext(BLURAY *bd, unsigned char *buf, int len, BD_EVENT *event);
  */
 int bd_read_skip_still(BLURAY *bd);
 
+/**
+ *
+ *  Wait in still mode clip
+ *
+ *  Blocks until still time elapses, user input is given (bd_user_input() from
+ *  another thread), an event is queued (HDMV / BD-J action), or timeout.
+ *  When still time elapses, playback continues as with bd_read_skip_still().
+ *  Still timer runs in the library: it starts when the still clip is reached.
+ *
+ *  Only in navigation mode (bd_read_ext()).
+ *
+ * @param bd  BLURAY object
+ * @param timeout_ms  maximum time to wait
+ * @return 1 if still ended and reading continues, 0 if woken up or timed out (check events), -1 if not in still mode
+ */
+int bd_wait_still(BLURAY *bd, unsigned timeout_ms);
+
+/**
+ *
+ *  Enable or disable trick-play (fast forward / rewind) reading.
+ *
+ *  In trick-play mode bd_read() and bd_read_units() return only the aligned units
+ *  of random access points (I-frames). After each I-frame reading jumps 'step'
+ *  EP map entries forward (step > 0) or backward (step < 0).
+ *  BD_EVENT_SEEK and BD_EVENT_DISCONTINUITY are queued at each jump.
+ *
+ *  Normal playback is resumed when title start or end is reached.
+ *  Trick-play is disabled when playlist changes.
+ *
+ * @param bd  BLURAY object
+ * @param step  EP map entries to advance after each I-frame, 0 to disable
+ * @return 1 on success, 0 if no playlist is playing
+ */
+int bd_set_trick_play(BLURAY *bd, int step);
+
 /**
  *
  *  Get information about a playlist
@@ -938,6 +1650,178 @@ int bd_mouse_select(BLURAY *bd, int64_t pts, uint16_t x, uint16_t y);
  * Testing and debugging
  */
 
+/* stream statistics. Times are in microseconds. */
+typedef struct {
+    uint64_t bytes_read;    /* bytes read from clip files */
+    uint32_t read_calls;    /* number of file reads */
+    uint32_t read_errors;   /* failed or short reads */
+    uint32_t clip_opens;    /* clip files opened */
+    uint32_t seeks;
+
+    uint64_t read_time;     /* time spent in file read (including decryption) */
+    uint64_t decrypt_time;  /* time spent in AACS decryption */
+    uint64_t bdplus_time;   /* time spent in BD+ fixup */
+    uint64_t filter_time;   /* time spent in m2ts filter */
+    uint64_t decode_time;   /* time spent in IG / PG / TextST decoding */
+} BLURAY_STREAM_STATS;
+
+typedef struct {
+    BLURAY_STREAM_STATS main;     /* main path */
+    BLURAY_STREAM_STATS preload;  /* preloaded IG sub path */
+    BLURAY_STREAM_STATS textst;   /* preloaded TextST sub path */
+
+    uint32_t event_queue_max;     /* event queue high-water mark */
+
+    /* decoded PG / IG graphics (current state) */
+    struct {
+        uint32_t num_objects;
+        uint64_t object_bytes;    /* decoded object images */
+        uint64_t cache_bytes;     /* cropped and palette index images */
+        uint64_t retained_bytes;  /* encoded objects kept for re-decoding (BLURAY_PLAYER_SETTING_GRAPHICS_MEMORY) */
+        uint64_t palette_bytes;
+        uint32_t num_evicted;     /* objects freed to stay in memory budget */
+        uint32_t num_redecoded;   /* freed objects decoded again */
+    } graphics;
+
+    /* HDMV VM */
+    struct {
+        uint64_t instructions;    /* executed instructions */
+        uint64_t gpr_writes;
+        uint64_t psr_writes;
+        uint32_t budget_yields;   /* execution suspended by BLURAY_PLAYER_SETTING_HDMV_BUDGET */
+    } hdmv;
+} BLURAY_STATS;
+
+/**
+ *
+ *  Get I/O and decoding statistics.
+ *  Counters are accumulated from bd_open() and never reset.
+ *
+ * @param bd  BLURAY object
+ * @param stats  statistics are stored here
+ * @return 1 on success, 0 on error
+ */
+int bd_get_stats(BLURAY *bd, BLURAY_STATS *stats);
+
+/* counter changes since previous report (bd_register_metrics_cb()). Times are in microseconds. */
+typedef struct bd_metrics {
+    uint64_t interval_us;        /* time since previous report */
+
+    uint64_t bytes_read;         /* bytes read from clip files (all streams) */
+    uint32_t read_calls;         /* number of file reads */
+    uint32_t read_errors;        /* failed or short reads */
+    uint64_t decrypt_time;       /* AACS decryption and BD+ fixup */
+    uint32_t clip_opens;         /* clip files opened (clip switches) */
+
+    uint32_t event_queue_depth;  /* events currently queued (not a delta) */
+    uint32_t overlay_cmds;       /* overlay commands sent to application */
+    uint64_t hdmv_instructions;  /* executed HDMV VM instructions */
+
+    uint32_t bdj_events;         /* events delivered to BD-J */
+    uint64_t bdj_event_time;     /* total time spent delivering BD-J events */
+} BLURAY_METRICS;
+
+typedef void (*bd_metrics_cb_f)(void *handle, const BLURAY_METRICS *metrics);
+
+/**
+ *
+ *  Register periodic metrics callback.
+ *
+ *  Callback receives counter changes since previous report. It is called
+ *  from bd_read*() when at least interval_ms has elapsed, and from the
+ *  internal timer thread (BLURAY_PLAYER_SETTING_TIMER_THREAD) when stream
+ *  is not being read.
+ *  Callback is called with BLURAY object locked: it must not call
+ *  libbluray functions with the same BLURAY object.
+ *
+ * @param bd  BLURAY object
+ * @param interval_ms  reporting interval (0 = disable reporting)
+ * @param handle  passed to callback
+ * @param cb  callback function
+ */
+void bd_register_metrics_cb(BLURAY *bd, unsigned interval_ms, void *handle, bd_metrics_cb_f cb);
+
+/* heap memory held by BLURAY object (bytes, approximate) */
+typedef struct {
+    uint64_t playlist;      /* current title: parsed playlist, clip info and EP maps */
+    uint64_t title_list;    /* title list and disc index titles */
+    uint64_t graphics;      /* decoded PG / IG objects, image caches, retained segments and palettes */
+    uint64_t textst;        /* TextST dialogs, styles, fonts and glyph cache */
+    uint64_t event_queue;
+    uint64_t read_buffers;  /* stream read buffer, read-ahead, unit cache and fan-out ring */
+    uint64_t total;
+} BLURAY_MEMORY_USAGE;
+
+/**
+ *
+ *  Get memory usage of BLURAY object.
+ *
+ *  Preloaded IG and TextST sub path clips are decoded incrementally and are
+ *  included in graphics and textst. Objects shared with other BLURAY objects
+ *  (disc cache) are included in each user. BD-J (Java heap) is not included.
+ *
+ * @param bd  BLURAY object
+ * @param usage  memory usage is stored here
+ * @return 1 on success, 0 on error
+ */
+int bd_get_memory_usage(BLURAY *bd, BLURAY_MEMORY_USAGE *usage);
+
+/**
+ *
+ *  Write recorded trace (BLURAY_PLAYER_SETTING_TRACE) to debug log.
+ *
+ * @param bd  BLURAY object
+ */
+void bd_dump_trace(BLURAY *bd);
+
+/* HDMV movie object statistics (BLURAY_PLAYER_SETTING_HDMV_PROFILE). Time is in microseconds. */
+typedef struct {
+    uint32_t calls;         /* object starts */
+    uint64_t instructions;  /* executed instructions */
+    uint64_t time_us;       /* time spent executing object */
+    uint32_t num_cmds;      /* number of instructions in object */
+} BLURAY_HDMV_OBJECT_STATS;
+
+/**
+ *
+ *  Get HDMV movie object statistics.
+ *  Object number equal to number of movie objects returns statistics of all IG button commands.
+ *
+ * @param bd  BLURAY object
+ * @param object  movie object number
+ * @param stats  statistics are stored here
+ * @param insn_hits  optional per-instruction execution counts are stored here, or NULL
+ * @param num_hits  size of insn_hits array
+ * @return 1 on success, 0 if profiling is not enabled, HDMV VM is not running or object is invalid
+ */
+int bd_get_hdmv_object_stats(BLURAY *bd, unsigned object, BLURAY_HDMV_OBJECT_STATS *stats,
+                             uint32_t *insn_hits, unsigned num_hits);
+
+/**
+ *
+ *  Write HDMV VM statistics (BLURAY_PLAYER_SETTING_HDMV_PROFILE) to debug log.
+ *
+ * @param bd  BLURAY object
+ */
+void bd_dump_hdmv_profile(BLURAY *bd);
+
+/**
+ *
+ *  Decode captured IG / PG stream packets and render completed display sets
+ *  to the registered overlay callback (for testing and benchmarking).
+ *
+ *  Data must be in aligned units (32 x 192-byte source packets).
+ *  Packets with other PIDs are ignored. PG is rendered only when enabled with
+ *  bd_select_stream().
+ *
+ * @param bd  BLURAY object
+ * @param pid  mpeg-ts PID of IG or PG stream
+ * @param buf  aligned units
+ * @param num_units  number of aligned units in buf
+ * @return <0 on error or if no overlay callback is registered, 0 when not complete, >0 when display set was rendered
+ */
+int bd_decode_graphics(BLURAY *bd, uint16_t pid, uint8_t *buf, unsigned num_units);
+
 /* access to internal information */
 
 struct clpi_cl;
@@ -960,6 +1844,11 @@ struct clpi_cl *bd_read_clpi(const char *clpi_file);
  */
 void bd_free_clpi(struct clpi_cl *cl);
 
+/* EP map queries used in seeking and angle change (for testing and benchmarking) */
+uint32_t bd_clpi_lookup_spn(const struct clpi_cl *cl, uint32_t timestamp, int before, uint8_t stc_id); /* timestamp: 45 kHz */
+uint32_t bd_clpi_access_point(const struct clpi_cl *cl, uint32_t pkt, int next, int angle_change, uint32_t *time);
+size_t   bd_clpi_memory_size(const struct clpi_cl *cl); /* heap memory used by parsed clip info (bytes, approximate) */
+
 
 struct mpls_pl;
 struct mpls_pl *bd_read_mpls(const char *mpls_file);
@@ -79,11 +79,30 @@ BD_PRIVATE int      bd_bdj_seek(struct bluray *bd, int playitem, int playmark, i
  */
 
 struct bd_argb_buffer_s;
+struct bd_argb_buffer_ext_s;
 
 BD_PRIVATE struct bd_argb_buffer_s *bd_lock_osd_buffer(struct bluray *bd);
 BD_PRIVATE void                     bd_unlock_osd_buffer(struct bluray *bd);
+/* extended buffer (or NULL) of locked osd buffer */
+BD_PRIVATE struct bd_argb_buffer_ext_s *bd_osd_buffer_ext(struct bluray *bd);
 
 BD_PRIVATE void  bd_bdj_osd_cb(struct bluray *bd, const unsigned *img, int w, int h,
                                int x0, int y0, int x1, int y1);
+/* rects: num_rects * {x0, y0, x1, y1}, disjoint and inside frame */
+BD_PRIVATE void  bd_bdj_osd_cb_rects(struct bluray *bd, const unsigned *img, int w, int h,
+                                     const int *rects, int num_rects);
+
+/* set dirty area of application frame buffer.
+ * Rectangle list is written only to extended buffer (ext may be NULL). */
+BD_PRIVATE void  bd_argb_buffer_set_dirty(struct bd_argb_buffer_s *buf, struct bd_argb_buffer_ext_s *ext,
+                                          int plane, const int *rects, int num_rects);
+
+/* triple-buffered application frame buffer.
+ * bd_argb_buffer_back() returns back buffer and extends dirty area with area the buffer has missed.
+ * bd_argb_buffer_flip() publishes back buffer and returns it. */
+BD_PRIVATE uint32_t *bd_argb_buffer_back(struct bd_argb_buffer_ext_s *buf, int plane,
+                                         int *x0, int *y0, int *x1, int *y1);
+BD_PRIVATE uint32_t *bd_argb_buffer_flip(struct bd_argb_buffer_ext_s *buf, int plane,
+                                         int x0, int y0, int x1, int y1);
 
 #endif  /* _BLURAY_INTERNAL_H_ */
@@ -24,26 +24,85 @@
 #include "graphics_controller.h"
 
 #include "graphics_processor.h"
+#include "pg_decode.h"
 #include "hdmv_pids.h"
+#include "m2ts_demux.h"
+#include "m2ts_scan.h"
+#include "pes_buffer.h"
 #include "ig.h"
 #include "overlay.h"
 #include "textst_render.h"
 #include "rle.h"
 
+#include "util/atomic.h"
 #include "util/macro.h"
 #include "util/logging.h"
 #include "util/mutex.h"
+#include "util/thread.h"
 #include "util/time.h"
 
 #include "../register.h"
 #include "../keys.h"
 
 #include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define GC_ERROR(...) BD_DEBUG(DBG_GC | DBG_CRIT, __VA_ARGS__)
 #define GC_TRACE(...) BD_DEBUG(DBG_GC,            __VA_ARGS__)
 
+/*
+ * PG decoding thread
+ *
+ * Single-producer, single-consumer queue of aligned units.
+ * Reader thread only copies units with PG packets to the queue,
+ * worker thread decodes and renders them.
+ */
+
+#define GC_PG_QUEUE_SIZE 16  /* aligned units */
+
+typedef struct {
+    uint8_t    unit[6144];
+    uint16_t   pid;
+    unsigned   generation;   /* PG decoder generation when queued */
+} GC_PG_UNIT;
+
+typedef struct {
+    BD_MUTEX       mutex;        /* protects cond only */
+    BD_COND        cond;
+    BD_THREAD      thread;
+
+    GC_PG_UNIT    *units;
+    BD_ATOMIC_UINT write_idx;    /* updated by reader thread */
+    BD_ATOMIC_UINT read_idx;     /* updated by worker thread */
+    BD_ATOMIC_UINT generation;   /* incremented when PG decoder is reset */
+
+    BD_ATOMIC_UINT worker_idle;
+    BD_ATOMIC_UINT reader_waiting;
+    BD_ATOMIC_UINT exit;
+} GC_PG_THREAD;
+
+/*
+ * TextST pre-rendering thread
+ *
+ * Next dialogs are rendered to RLE images ahead of their presentation time.
+ */
+
+#define TEXTST_PRERENDER_DIALOGS 4
+
+typedef struct {
+    int             dialog_idx;  /* -1 if unused */
+    BD_PG_RLE_ELEM *rle[2];      /* rendered regions */
+} TEXTST_PRERENDERED;
+
+typedef struct {
+    BD_COND            cond;     /* used with gc->textst_mutex */
+    BD_THREAD          thread;
+    unsigned           next;     /* next dialog to be presented */
+    unsigned           exit;
+    TEXTST_PRERENDERED cache[TEXTST_PRERENDER_DIALOGS];
+} TEXTST_THREAD;
+
 /*
  *
  */
@@ -56,15 +115,83 @@ typedef struct {
     int      effect_running;  /* single-loop animation not yet complete */
 } BOG_DATA;
 
+/*
+ * button hit-testing index
+ *
+ * Plane is divided to GC_HIT_GRID x GC_HIT_GRID cells. Each cell lists
+ * (in ascending order) button overlap groups whose enabled button covers the cell.
+ */
+
+#define GC_HIT_GRID 16
+
+typedef struct {
+    uint16_t x0, y0, x1, y1;  /* x1, y1: first pixel outside of button */
+} GC_HIT_RECT;
+
+typedef struct {
+    uint8_t      valid;
+    uint16_t     page_id;
+    unsigned     cell_w, cell_h;
+    unsigned     num_bogs;
+    GC_HIT_RECT *rect;                                  /* enabled button area of each bog */
+    unsigned     cell_start[GC_HIT_GRID * GC_HIT_GRID + 1]; /* index to cell_bogs */
+    uint16_t    *cell_bogs;
+} GC_HIT_INDEX;
+
+/*
+ * batched overlay output
+ */
+
+typedef struct {
+    BD_PG_PALETTE_ENTRY entry[256];  /* must be first: commands point to entries */
+    uint32_t            argb[256];
+    uint32_t            serial;
+} GC_OV_PALETTE;
+
+typedef struct gc_ov_list_s GC_OV_LIST;
+struct gc_ov_list_s {
+    BD_OVERLAY_LIST  list;  /* must be first: application gets pointer to list */
+    GC_OV_LIST      *next;
+};
+
+typedef struct {
+    BD_OVERLAY    *cmd;
+    unsigned       num_cmds;
+    unsigned       cmds_size;
+    GC_OV_PALETTE *palette;  /* last copied palette */
+} GC_OV_BUILDER;
+
 struct graphics_controller_s {
 
     BD_REGISTERS   *regs;
 
-    BD_MUTEX        mutex;
+    BD_RWLOCK       mutex;
 
     /* overlay output */
     void           *overlay_proc_handle;
     void          (*overlay_proc)(void *, const struct bd_overlay_s * const);
+    uint8_t         overlay_index;  /* include palette index image in DRAW events */
+    uint8_t         overlay_argb;   /* include ARGB image in DRAW events */
+
+    /* batched overlay output (optional) */
+    gc_overlay_list_proc_f overlay_list_proc;
+    void                  *overlay_list_handle;
+    GC_OV_BUILDER          ov_build[2];     /* commands of current list of each plane */
+    GC_OV_LIST            *ov_ready;        /* completed lists waiting for delivery */
+    BD_MUTEX               ov_queue_mutex;  /* protects ov_ready */
+    BD_MUTEX               ov_deliver_mutex;/* keeps lists in order when delivered from multiple threads */
+    unsigned               lock_depth;      /* write lock recursion */
+
+    /* decoded IG object memory budget (0 = unlimited) */
+    uint64_t        memory_limit;
+    uint32_t        num_evicted;
+    uint32_t        num_redecoded;
+
+    /* overlay commands sent to application (statistics) */
+    uint64_t        num_overlay_cmds;
+
+    /* IG object decoding threads (0 = decode in calling thread) */
+    unsigned        ig_decode_threads;
 
     /* state */
     unsigned        ig_open;
@@ -76,9 +203,11 @@ struct graphics_controller_s {
     unsigned        popup_visible;
     unsigned        valid_mouse_position;
     unsigned        auto_action_triggered;
+    unsigned        hint_pending;   /* selected button changed, prefetch hint not yet returned */
     BOG_DATA       *bog_data;
     BOG_DATA       *saved_bog_data;
     BD_UO_MASK      page_uo_mask;
+    GC_HIT_INDEX    hit_index;      /* rebuilt when page or enabled buttons change */
 
     /* page effects */
     int                    effect_idx;
@@ -104,24 +233,35 @@ struct graphics_controller_s {
     GRAPHICS_PROCESSOR *igp;
     GRAPHICS_PROCESSOR *tgp;  /* TextST */
 
+    /* main path demuxer for IG and PG streams */
+    M2TS_DEMUX         *demux;
+    uint16_t            demux_ig_pid;
+    uint16_t            demux_pg_pid;
+
     /* */
     TEXTST_RENDER  *textst_render;
     int             next_dialog_idx;
     int             textst_user_style;
+    uint8_t         textst_sorted;  /* dialog start times are ascending (binary search allowed) */
+
+    /* PG decoding thread (optional) */
+    GC_PG_THREAD   *pg_thread;
+
+    /* TextST pre-rendering thread (optional) */
+    BD_MUTEX        textst_mutex;  /* protects tgs, textst_render and pre-rendered dialogs */
+    TEXTST_THREAD  *textst_thread;
 };
 
 /*
  * object lookup
+ *
+ * Lookup tables are maintained by graphics processor.
  */
 
 static BD_PG_OBJECT *_find_object(PG_DISPLAY_SET *s, unsigned object_id)
 {
-    unsigned ii;
-
-    for (ii = 0; ii < s->num_object; ii++) {
-        if (s->object[ii].id == object_id) {
-            return &s->object[ii];
-        }
+    if (object_id < s->object_index_size && s->object_index[object_id]) {
+        return &s->object[s->object_index[object_id] - 1];
     }
 
     return NULL;
@@ -129,12 +269,8 @@ static BD_PG_OBJECT *_find_object(PG_DISPLAY_SET *s, unsigned object_id)
 
 static BD_PG_PALETTE *_find_palette(PG_DISPLAY_SET *s, unsigned palette_id)
 {
-    unsigned ii;
-
-    for (ii = 0; ii < s->num_palette; ii++) {
-        if (s->palette[ii].id == palette_id) {
-            return &s->palette[ii];
-        }
+    if (palette_id < 256 && s->palette_index[palette_id]) {
+        return &s->palette[s->palette_index[palette_id] - 1];
     }
 
     return NULL;
@@ -155,16 +291,12 @@ static BD_IG_BUTTON *_find_button_bog(BD_IG_BOG *bog, unsigned button_id)
 
 static BD_IG_BUTTON *_find_button_page(BD_IG_PAGE *page, unsigned button_id, unsigned *bog_idx)
 {
-    unsigned ii;
-
-    for (ii = 0; ii < page->num_bogs; ii++) {
-        BD_IG_BUTTON *button = _find_button_bog(&page->bog[ii], button_id);
-        if (button) {
-            if (bog_idx) {
-                *bog_idx = ii;
-            }
-            return button;
+    if (button_id < page->button_index_size && page->button_index[button_id]) {
+        uint32_t ref = page->button_index[button_id] - 1;
+        if (bog_idx) {
+            *bog_idx = ref >> 16;
         }
+        return &page->bog[ref >> 16].button[ref & 0xffff];
     }
 
     return NULL;
@@ -172,12 +304,8 @@ static BD_IG_BUTTON *_find_button_page(BD_IG_PAGE *page, unsigned button_id, uns
 
 static BD_IG_PAGE *_find_page(BD_IG_INTERACTIVE_COMPOSITION *c, unsigned page_id)
 {
-    unsigned ii;
-
-    for (ii = 0; ii < c->num_pages; ii++) {
-        if (c->page[ii].id == page_id) {
-            return &c->page[ii];
-        }
+    if (page_id < 256 && c->page_index[page_id]) {
+        return &c->page[c->page_index[page_id] - 1];
     }
 
     return NULL;
@@ -398,6 +526,7 @@ static int _restore_page_state(GRAPHICS_CONTROLLER *gc)
         }
         gc->bog_data       = gc->saved_bog_data;
         gc->saved_bog_data = NULL;
+        gc->hit_index.valid = 0;
 
         return 1;
     }
@@ -418,6 +547,8 @@ static void _reset_page_state(GRAPHICS_CONTROLLER *gc)
         return;
     }
 
+    gc->hit_index.valid = 0;
+
     size_t size = page->num_bogs * sizeof(*gc->bog_data);
     gc->bog_data = realloc(gc->bog_data, size);
 
@@ -450,6 +581,207 @@ static void _reset_page_state(GRAPHICS_CONTROLLER *gc)
     _reset_user_timeout(gc);
 }
 
+/*
+ * batched overlay output
+ *
+ * Overlay events are collected to per-plane command list. Completed lists
+ * are queued and delivered when graphics controller write lock is released.
+ */
+
+static void _ov_release_cmds(const BD_OVERLAY *cmd, unsigned num_cmds)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < num_cmds; ii++) {
+        bd_refcnt_dec(cmd[ii].img);
+        bd_refcnt_dec(cmd[ii].index_img);
+        bd_refcnt_dec(cmd[ii].argb_img);
+        bd_refcnt_dec(cmd[ii].palette);
+    }
+}
+
+static void _ov_list_cleanup(void *p)
+{
+    GC_OV_LIST *l = (GC_OV_LIST *)p;
+
+    _ov_release_cmds(l->list.cmds, l->list.num_cmds);
+}
+
+static GC_OV_PALETTE *_ov_copy_palette(GC_OV_BUILDER *b, const BD_OVERLAY *ov)
+{
+    GC_OV_PALETTE *pal = b->palette;
+
+    if (pal && ov->palette_serial && pal->serial == ov->palette_serial &&
+        (!ov->palette_argb || !memcmp(pal->argb, ov->palette_argb, sizeof(pal->argb)))) {
+        bd_refcnt_inc(pal);
+        return pal;
+    }
+
+    pal = refcnt_realloc(NULL, sizeof(*pal), NULL);
+    if (!pal) {
+        return NULL;
+    }
+    memcpy(pal->entry, ov->palette, sizeof(pal->entry));
+    if (ov->palette_argb) {
+        memcpy(pal->argb, ov->palette_argb, sizeof(pal->argb));
+    }
+    pal->serial = ov->palette_serial;
+
+    /* builder keeps one reference */
+    bd_refcnt_dec(b->palette);
+    b->palette = pal;
+    bd_refcnt_inc(pal);
+
+    return pal;
+}
+
+static void _ov_list_finish(GRAPHICS_CONTROLLER *gc, GC_OV_BUILDER *b, int plane, int64_t pts)
+{
+    GC_OV_LIST  *l, **tail;
+    BD_OVERLAY  *cmds;
+
+    l = refcnt_realloc(NULL, sizeof(*l) + b->num_cmds * sizeof(*cmds), _ov_list_cleanup);
+    if (!l) {
+        GC_ERROR("_ov_list_finish(): out of memory\n");
+        _ov_release_cmds(b->cmd, b->num_cmds);
+        b->num_cmds = 0;
+        return;
+    }
+
+    cmds = (BD_OVERLAY *)(void *)(l + 1);
+    memcpy(cmds, b->cmd, b->num_cmds * sizeof(*cmds));
+
+    l->list.pts      = pts;
+    l->list.plane    = plane;
+    l->list.num_cmds = b->num_cmds;
+    l->list.cmds     = cmds;
+    l->next          = NULL;
+
+    b->num_cmds = 0;
+
+    bd_mutex_lock(&gc->ov_queue_mutex);
+    tail = &gc->ov_ready;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = l;
+    bd_mutex_unlock(&gc->ov_queue_mutex);
+}
+
+/* overlay callback used with command lists */
+static void _ov_list_queue(void *handle, const BD_OVERLAY * const ov)
+{
+    GRAPHICS_CONTROLLER *gc = (GRAPHICS_CONTROLLER *)handle;
+    GC_OV_BUILDER       *b;
+    BD_OVERLAY          *cmd;
+
+    if (!ov) {
+        /* closing is handled in gc_free() */
+        return;
+    }
+
+    b = &gc->ov_build[ov->plane ? 1 : 0];
+
+    if (b->num_cmds >= b->cmds_size) {
+        unsigned size = BD_MAX(16, b->cmds_size * 2);
+        cmd = realloc(b->cmd, size * sizeof(*cmd));
+        if (!cmd) {
+            GC_ERROR("_ov_list_queue(): out of memory\n");
+            return;
+        }
+        b->cmd       = cmd;
+        b->cmds_size = size;
+    }
+
+    cmd = &b->cmd[b->num_cmds];
+    *cmd = *ov;
+
+    if (ov->palette) {
+        GC_OV_PALETTE *pal = _ov_copy_palette(b, ov);
+        cmd->palette      = pal ? pal->entry : NULL;
+        cmd->palette_argb = (pal && ov->palette_argb) ? pal->argb : NULL;
+    }
+    bd_refcnt_inc(cmd->img);
+    bd_refcnt_inc(cmd->index_img);
+    bd_refcnt_inc(cmd->argb_img);
+
+    b->num_cmds++;
+
+    if (ov->cmd == BD_OVERLAY_FLUSH || ov->cmd == BD_OVERLAY_CLOSE) {
+        _ov_list_finish(gc, b, ov->plane, ov->cmd == BD_OVERLAY_FLUSH ? ov->pts : -1);
+    }
+}
+
+static void _ov_list_deliver(GRAPHICS_CONTROLLER *gc)
+{
+    GC_OV_LIST *l;
+
+    if (!gc->overlay_list_proc) {
+        return;
+    }
+
+    bd_mutex_lock(&gc->ov_deliver_mutex);
+
+    do {
+        bd_mutex_lock(&gc->ov_queue_mutex);
+        l = gc->ov_ready;
+        if (l) {
+            gc->ov_ready = l->next;
+        }
+        bd_mutex_unlock(&gc->ov_queue_mutex);
+
+        if (l) {
+            gc->overlay_list_proc(gc->overlay_list_handle, &l->list);
+            bd_refcnt_dec(l);
+        }
+    } while (l);
+
+    bd_mutex_unlock(&gc->ov_deliver_mutex);
+}
+
+static void _ov_list_free(GRAPHICS_CONTROLLER *gc)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < 2; ii++) {
+        GC_OV_BUILDER *b = &gc->ov_build[ii];
+        _ov_release_cmds(b->cmd, b->num_cmds);
+        X_FREE(b->cmd);
+        bd_refcnt_dec(b->palette);
+        memset(b, 0, sizeof(*b));
+    }
+
+    while (gc->ov_ready) {
+        GC_OV_LIST *l = gc->ov_ready;
+        gc->ov_ready = l->next;
+        bd_refcnt_dec(l);
+    }
+}
+
+/*
+ * locking
+ *
+ * Write lock is recursive. Overlay command lists are delivered when
+ * the outermost write lock is released.
+ */
+
+static void _gc_lock(GRAPHICS_CONTROLLER *gc)
+{
+    bd_rwlock_wrlock(&gc->mutex);
+    gc->lock_depth++;
+}
+
+static void _gc_unlock(GRAPHICS_CONTROLLER *gc)
+{
+    unsigned depth = --gc->lock_depth;
+
+    bd_rwlock_unlock(&gc->mutex);
+
+    if (!depth) {
+        _ov_list_deliver(gc);
+    }
+}
+
 /*
  * overlay operations
  */
@@ -458,6 +790,12 @@ static void _reset_page_state(GRAPHICS_CONTROLLER *gc)
 #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
 #endif
 
+static void _overlay_cmd(GRAPHICS_CONTROLLER *gc, const BD_OVERLAY *ov)
+{
+    gc->num_overlay_cmds++;
+    gc->overlay_proc(gc->overlay_proc_handle, ov);
+}
+
 static void _open_osd(GRAPHICS_CONTROLLER *gc, int plane,
                       unsigned x0, unsigned y0,
                       unsigned width, unsigned height)
@@ -472,7 +810,7 @@ static void _open_osd(GRAPHICS_CONTROLLER *gc, int plane,
         ov.w            = width;
         ov.h            = height;
 
-        gc->overlay_proc(gc->overlay_proc_handle, &ov);
+        _overlay_cmd(gc, &ov);
 
         if (plane == BD_OVERLAY_IG) {
             gc->ig_open = 1;
@@ -490,7 +828,7 @@ static void _close_osd(GRAPHICS_CONTROLLER *gc, int plane)
         ov.pts     = -1;
         ov.plane   = plane;
 
-        gc->overlay_proc(gc->overlay_proc_handle, &ov);
+        _overlay_cmd(gc, &ov);
     }
 
     if (plane == BD_OVERLAY_IG) {
@@ -510,7 +848,7 @@ static void _flush_osd(GRAPHICS_CONTROLLER *gc, int plane, int64_t pts)
         ov.pts     = pts;
         ov.plane   = plane;
 
-        gc->overlay_proc(gc->overlay_proc_handle, &ov);
+        _overlay_cmd(gc, &ov);
     }
 }
 
@@ -521,7 +859,7 @@ static void _hide_osd(GRAPHICS_CONTROLLER *gc, int plane)
         ov.cmd     = BD_OVERLAY_HIDE;
         ov.plane   = plane;
 
-        gc->overlay_proc(gc->overlay_proc_handle, &ov);
+        _overlay_cmd(gc, &ov);
     }
 }
 
@@ -539,7 +877,7 @@ static void _clear_osd_area(GRAPHICS_CONTROLLER *gc, int plane, int64_t pts,
         ov.w       = w;
         ov.h       = h;
 
-        gc->overlay_proc(gc->overlay_proc_handle, &ov);
+        _overlay_cmd(gc, &ov);
     }
 }
 
@@ -552,7 +890,7 @@ static void _clear_osd(GRAPHICS_CONTROLLER *gc, int plane)
         ov.pts     = -1;
         ov.plane   = plane;
 
-        gc->overlay_proc(gc->overlay_proc_handle, &ov);
+        _overlay_cmd(gc, &ov);
     }
 
     if (plane == BD_OVERLAY_IG) {
@@ -575,13 +913,152 @@ static void _clear_bog_area(GRAPHICS_CONTROLLER *gc, BOG_DATA *bog_data)
     }
 }
 
+/* converted ARGB table is cached in palette until palette changes */
+static void _update_palette_argb(GRAPHICS_CONTROLLER *gc, unsigned plane, BD_PG_PALETTE *palette)
+{
+    const PG_DISPLAY_SET *s = (plane == BD_OVERLAY_IG) ? gc->igs : gc->pgs;
+    unsigned height = 1080;
+    int      bt709;
+
+    if (s && s->ics) {
+        height = s->ics->video_descriptor.video_height;
+    } else if (s && s->pcs) {
+        height = s->pcs->video_descriptor.video_height;
+    }
+    bt709 = height >= 720;
+
+    if (palette->argb_serial != palette->serial || palette->argb_bt709 != bt709) {
+        bd_pg_palette_to_argb(palette->entry, palette->argb, bt709);
+        palette->argb_serial = palette->serial;
+        palette->argb_bt709  = bt709;
+    }
+}
+
+/* palette for overlay */
+static void _set_palette(GRAPHICS_CONTROLLER *gc, BD_OVERLAY *ov, BD_PG_PALETTE *palette)
+{
+    _update_palette_argb(gc, ov->plane, palette);
+
+    ov->palette        = palette->entry;
+    ov->palette_serial = palette->serial;
+    ov->palette_argb   = palette->argb;
+}
+
+/* send DRAW event. Palette index and ARGB images of uncached image are valid only during callback. */
+static void _draw_overlay(GRAPHICS_CONTROLLER *gc, BD_OVERLAY *ov)
+{
+    uint8_t  *index_img = NULL;
+    uint32_t *argb_img  = NULL;
+
+    if (gc->overlay_index && !ov->index_img && ov->img) {
+        index_img = refcnt_realloc(NULL, (size_t)ov->w * ov->h, NULL);
+        if (index_img) {
+            bd_rle_decode8(ov->img, ov->w, ov->h, index_img, ov->w);
+        }
+        ov->index_img = index_img;
+    }
+    if (gc->overlay_argb && !ov->argb_img && ov->img && ov->palette_argb) {
+        argb_img = refcnt_realloc(NULL, (size_t)ov->w * ov->h * sizeof(uint32_t), NULL);
+        if (argb_img) {
+            bd_rle_decode32(ov->img, ov->w, ov->h, ov->palette_argb, argb_img, ov->w);
+        }
+        ov->argb_img = argb_img;
+    }
+
+    _overlay_cmd(gc, ov);
+
+    bd_refcnt_dec(index_img);
+    bd_refcnt_dec(argb_img);
+}
+
+/* palette index image is cached in object until object is replaced or crop rect changes */
+static const uint8_t *_index_object(BD_PG_OBJECT *object, const BD_PG_RLE_ELEM *img,
+                                    uint32_t serial, unsigned w, unsigned h)
+{
+    if (object->index_img && object->index_serial == serial) {
+        return object->index_img;
+    }
+
+    bd_refcnt_dec(object->index_img);
+    object->index_img    = NULL;
+    object->index_serial = 0;
+    object->index_size   = 0;
+
+    if (!img || !w || !h) {
+        return NULL;
+    }
+
+    object->index_img = refcnt_realloc(NULL, (size_t)w * h, NULL);
+    if (!object->index_img) {
+        GC_ERROR("_index_object(): out of memory\n");
+        return NULL;
+    }
+    if (bd_rle_decode8(img, w, h, object->index_img, w) < 0) {
+        GC_TRACE("_index_object(): corrupted image\n");
+    }
+    object->index_serial = serial;
+    object->index_size   = w * h;
+
+    return object->index_img;
+}
+
+/* ARGB image is cached in object until object, crop rect or palette changes.
+ * Objects of IG display set hold expanded images of all button states of current page. */
+static const uint32_t *_argb_object(BD_PG_OBJECT *object, const BD_PG_RLE_ELEM *img,
+                                    uint32_t serial, unsigned w, unsigned h,
+                                    const BD_PG_PALETTE *palette)
+{
+    if (object->argb_img && object->argb_serial == serial &&
+        object->argb_palette_serial == palette->serial && object->argb_bt709 == palette->argb_bt709) {
+        return object->argb_img;
+    }
+
+    bd_refcnt_dec(object->argb_img);
+    object->argb_img    = NULL;
+    object->argb_serial = 0;
+    object->argb_size   = 0;
+
+    if (!img || !w || !h) {
+        return NULL;
+    }
+
+    object->argb_img = refcnt_realloc(NULL, (size_t)w * h * sizeof(uint32_t), NULL);
+    if (!object->argb_img) {
+        GC_ERROR("_argb_object(): out of memory\n");
+        return NULL;
+    }
+    if (bd_rle_decode32(img, w, h, palette->argb, object->argb_img, w) < 0) {
+        GC_TRACE("_argb_object(): corrupted image\n");
+    }
+    object->argb_serial         = serial;
+    object->argb_palette_serial = palette->serial;
+    object->argb_bt709          = palette->argb_bt709;
+    object->argb_size           = w * h * sizeof(uint32_t);
+
+    return object->argb_img;
+}
+
+/* evicted object is re-decoded from retained segment when it is needed again */
+static int _load_object(GRAPHICS_CONTROLLER *gc, BD_PG_OBJECT *object)
+{
+    if (object->img || !object->data) {
+        return 1;
+    }
+    if (!pg_redecode_object(object)) {
+        GC_ERROR("object #%d not available\n", object->id);
+        return 0;
+    }
+    gc->num_redecoded++;
+    return 1;
+}
+
 static void _render_object(GRAPHICS_CONTROLLER *gc,
                            int64_t pts, unsigned plane,
                            uint16_t x, uint16_t y,
                            BD_PG_OBJECT *object,
                            BD_PG_PALETTE *palette)
 {
-    if (gc->overlay_proc) {
+    if (gc->overlay_proc && _load_object(gc, object)) {
         BD_OVERLAY ov = {0};
         ov.cmd     = BD_OVERLAY_DRAW;
         ov.pts     = pts;
@@ -590,13 +1067,47 @@ static void _render_object(GRAPHICS_CONTROLLER *gc,
         ov.y       = y;
         ov.w       = object->width;
         ov.h       = object->height;
-        ov.palette = palette->entry;
         ov.img     = object->img;
+        ov.object_serial = object->serial;
+
+        _set_palette(gc, &ov, palette);
+
+        if (gc->overlay_index) {
+            ov.index_img = _index_object(object, ov.img, ov.object_serial, ov.w, ov.h);
+        }
+        if (gc->overlay_argb) {
+            ov.argb_img = _argb_object(object, ov.img, ov.object_serial, ov.w, ov.h, palette);
+        }
 
-        gc->overlay_proc(gc->overlay_proc_handle, &ov);
+        _draw_overlay(gc, &ov);
     }
 }
 
+/* cropped image is cached in object until object is replaced or crop rect changes */
+static const BD_PG_RLE_ELEM *_crop_object(BD_PG_OBJECT *object, BD_PG_COMPOSITION_OBJECT *cobj)
+{
+    if (object->crop_img &&
+        object->crop_version == object->version &&
+        object->crop_x == cobj->crop_x && object->crop_y == cobj->crop_y &&
+        object->crop_w == cobj->crop_w && object->crop_h == cobj->crop_h) {
+        return object->crop_img;
+    }
+
+    bd_refcnt_dec(object->crop_img);
+    object->crop_size = 0;
+    object->crop_img = rle_crop_object(object->img, object->width,
+                                       cobj->crop_x, cobj->crop_y, cobj->crop_w, cobj->crop_h,
+                                       &object->crop_size);
+    object->crop_version = object->version;
+    object->crop_x       = cobj->crop_x;
+    object->crop_y       = cobj->crop_y;
+    object->crop_w       = cobj->crop_w;
+    object->crop_h       = cobj->crop_h;
+    object->crop_serial  = pg_new_serial();
+
+    return object->crop_img;
+}
+
 static void _render_composition_object(GRAPHICS_CONTROLLER *gc,
                                        int64_t pts, unsigned plane,
                                        BD_PG_COMPOSITION_OBJECT *cobj,
@@ -604,8 +1115,7 @@ static void _render_composition_object(GRAPHICS_CONTROLLER *gc,
                                        BD_PG_PALETTE *palette,
                                        int palette_update_flag)
 {
-    if (gc->overlay_proc) {
-        BD_PG_RLE_ELEM *cropped_img = NULL;
+    if (gc->overlay_proc && _load_object(gc, object)) {
         BD_OVERLAY ov = {0};
         ov.cmd     = BD_OVERLAY_DRAW;
         ov.pts     = pts;
@@ -614,13 +1124,18 @@ static void _render_composition_object(GRAPHICS_CONTROLLER *gc,
         ov.y       = cobj->y;
         ov.w       = object->width;
         ov.h       = object->height;
-        ov.palette = palette->entry;
         ov.img     = object->img;
+        ov.object_serial = object->serial;
+
+        _set_palette(gc, &ov, palette);
 
         if (cobj->crop_flag) {
             if (cobj->crop_x || cobj->crop_y || cobj->crop_w != object->width) {
-                ov.img = cropped_img = rle_crop_object(object->img, object->width,
-                                                       cobj->crop_x, cobj->crop_y, cobj->crop_w, cobj->crop_h);
+                ov.img = _crop_object(object, cobj);
+                ov.object_serial = object->crop_serial;
+            } else if (cobj->crop_h != object->height) {
+                /* same image data, fewer lines */
+                ov.object_serial = 0;
             }
             ov.w  = cobj->crop_w;
             ov.h  = cobj->crop_h;
@@ -628,9 +1143,14 @@ static void _render_composition_object(GRAPHICS_CONTROLLER *gc,
 
         ov.palette_update_flag = palette_update_flag;
 
-        gc->overlay_proc(gc->overlay_proc_handle, &ov);
+        if (gc->overlay_index && ov.object_serial) {
+            ov.index_img = _index_object(object, ov.img, ov.object_serial, ov.w, ov.h);
+        }
+        if (gc->overlay_argb && ov.object_serial) {
+            ov.argb_img = _argb_object(object, ov.img, ov.object_serial, ov.w, ov.h, palette);
+        }
 
-        bd_refcnt_dec(cropped_img);
+        _draw_overlay(gc, &ov);
     }
 }
 
@@ -653,7 +1173,7 @@ static void _render_rle(GRAPHICS_CONTROLLER *gc,
         ov.palette = palette;
         ov.img     = img;
 
-        gc->overlay_proc(gc->overlay_proc_handle, &ov);
+        _draw_overlay(gc, &ov);
     }
 }
 
@@ -677,6 +1197,7 @@ static void _select_button(GRAPHICS_CONTROLLER *gc, uint32_t button_id)
     /* select page */
     bd_psr_write(gc->regs, PSR_SELECTED_BUTTON_ID, button_id);
     gc->auto_action_triggered = 0;
+    gc->hint_pending = 1;
 }
 
 static void _select_page(GRAPHICS_CONTROLLER *gc, uint16_t page_id, int out_effects)
@@ -713,8 +1234,34 @@ static void _select_page(GRAPHICS_CONTROLLER *gc, uint16_t page_id, int out_effe
     }
 }
 
+static void _textst_cache_clear(GRAPHICS_CONTROLLER *gc)
+{
+    /* must be called with textst_mutex locked */
+    if (gc->textst_thread) {
+        unsigned ii;
+        for (ii = 0; ii < TEXTST_PRERENDER_DIALOGS; ii++) {
+            TEXTST_PRERENDERED *d = &gc->textst_thread->cache[ii];
+            bd_refcnt_dec(d->rle[0]);
+            bd_refcnt_dec(d->rle[1]);
+            d->rle[0] = d->rle[1] = NULL;
+            d->dialog_idx = -1;
+        }
+        bd_cond_signal(&gc->textst_thread->cond);
+    }
+}
+
+static void _discard_pg_queue(GRAPHICS_CONTROLLER *gc)
+{
+    /* units queued before reset are dropped by the worker */
+    if (gc->pg_thread) {
+        bd_atomic_add(&gc->pg_thread->generation, 1);
+    }
+}
+
 static void _gc_reset(GRAPHICS_CONTROLLER *gc)
 {
+    _discard_pg_queue(gc);
+
     if (gc->pg_open) {
         _close_osd(gc, BD_OVERLAY_PG);
     }
@@ -729,21 +1276,35 @@ static void _gc_reset(GRAPHICS_CONTROLLER *gc)
     graphics_processor_free(&gc->igp);
     graphics_processor_free(&gc->pgp);
     graphics_processor_free(&gc->tgp);
+    m2ts_demux_free(&gc->demux);
 
     pg_display_set_free(&gc->pgs);
     pg_display_set_free(&gc->igs);
-    pg_display_set_free(&gc->tgs);
 
+    bd_mutex_lock(&gc->textst_mutex);
+    _textst_cache_clear(gc);
+    pg_display_set_free(&gc->tgs);
     textst_render_free(&gc->textst_render);
     gc->next_dialog_idx = 0;
+    gc->textst_sorted = 0;
+    bd_mutex_unlock(&gc->textst_mutex);
+
     gc->textst_user_style = -1;
 
     X_FREE(gc->bog_data);
+
+    X_FREE(gc->hit_index.rect);
+    X_FREE(gc->hit_index.cell_bogs);
+    gc->hit_index.valid = 0;
 }
 
 /*
  * register hook
  */
+
+/* menu page state is saved / restored with PSR backup registers */
+static const unsigned _gc_psrs[] = { PSR_MENU_PAGE_ID };
+
 static void _process_psr_event(void *handle, BD_PSR_EVENT *ev)
 {
     GRAPHICS_CONTROLLER *gc = (GRAPHICS_CONTROLLER *)handle;
@@ -752,9 +1313,9 @@ static void _process_psr_event(void *handle, BD_PSR_EVENT *ev)
         BD_DEBUG(DBG_GC, "PSR SAVE event\n");
 
         /* save menu page state */
-        bd_mutex_lock(&gc->mutex);
+        _gc_lock(gc);
         _save_page_state(gc);
-        bd_mutex_unlock(&gc->mutex);
+        _gc_unlock(gc);
 
         return;
     }
@@ -767,9 +1328,9 @@ static void _process_psr_event(void *handle, BD_PSR_EVENT *ev)
 
             case PSR_MENU_PAGE_ID:
                 /* restore menus */
-                bd_mutex_lock(&gc->mutex);
+                _gc_lock(gc);
                 _restore_page_state(gc);
-                bd_mutex_unlock(&gc->mutex);
+                _gc_unlock(gc);
                 return;
 
             default:
@@ -796,21 +1357,43 @@ GRAPHICS_CONTROLLER *gc_init(BD_REGISTERS *regs, void *handle, gc_overlay_proc_f
     p->overlay_proc_handle = handle;
     p->overlay_proc        = func;
 
-    bd_mutex_init(&p->mutex);
+    bd_rwlock_init(&p->mutex);
+    bd_mutex_init(&p->textst_mutex);
+    bd_mutex_init(&p->ov_queue_mutex);
+    bd_mutex_init(&p->ov_deliver_mutex);
 
-    bd_psr_register_cb(regs, _process_psr_event, p);
+    bd_psr_register_cb_filter(regs, _process_psr_event, p, _gc_psrs, sizeof(_gc_psrs) / sizeof(_gc_psrs[0]));
 
     p->textst_user_style = -1;
 
     return p;
 }
 
+void gc_set_overlay_list_proc(GRAPHICS_CONTROLLER *gc, void *handle, gc_overlay_list_proc_f func)
+{
+    if (!gc) {
+        return;
+    }
+
+    _gc_lock(gc);
+
+    gc->overlay_list_proc   = func;
+    gc->overlay_list_handle = handle;
+    gc->overlay_proc        = func ? _ov_list_queue : NULL;
+    gc->overlay_proc_handle = func ? gc : NULL;
+
+    _gc_unlock(gc);
+}
+
 void gc_free(GRAPHICS_CONTROLLER **p)
 {
     if (p && *p) {
 
         GRAPHICS_CONTROLLER *gc = *p;
 
+        gc_stop_pg_thread(gc);
+        gc_stop_textst_thread(gc);
+
         bd_psr_unregister_cb(gc->regs, _process_psr_event, gc);
 
         _gc_reset(gc);
@@ -818,46 +1401,326 @@ void gc_free(GRAPHICS_CONTROLLER **p)
         if (gc->overlay_proc) {
             gc->overlay_proc(gc->overlay_proc_handle, NULL);
         }
+        if (gc->overlay_list_proc) {
+            _ov_list_deliver(gc);
+            gc->overlay_list_proc(gc->overlay_list_handle, NULL);
+        }
+        _ov_list_free(gc);
 
-        bd_mutex_destroy(&gc->mutex);
+        bd_rwlock_destroy(&gc->mutex);
+        bd_mutex_destroy(&gc->textst_mutex);
+        bd_mutex_destroy(&gc->ov_queue_mutex);
+        bd_mutex_destroy(&gc->ov_deliver_mutex);
 
         X_FREE(*p);
     }
 }
 
 /*
- * graphics stream input
+ * decoded object memory
  */
 
-int gc_decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned num_blocks, int64_t stc)
+static int _object_in_range(unsigned id, unsigned start, unsigned end)
 {
-    if (!gc) {
-        GC_TRACE("gc_decode_ts(): no graphics controller\n");
-        return -1;
+    if (start == 0xffff) {
+        return 0;
     }
+    if (end == 0xffff || end < start) {
+        return id == start;
+    }
+    return id >= start && id <= end;
+}
 
-    if (IS_HDMV_PID_IG(pid)) {
-        /* IG stream */
+static int _effects_use_object(const BD_IG_EFFECT_SEQUENCE *e, unsigned id)
+{
+    unsigned ii, jj;
 
-        if (!gc->igp) {
-            gc->igp = graphics_processor_init();
-            if (!gc->igp) {
-                return -1;
+    for (ii = 0; e && ii < e->num_effects; ii++) {
+        for (jj = 0; jj < e->effect[ii].num_composition_objects; jj++) {
+            if (e->effect[ii].composition_object[jj].object_id_ref == id) {
+                return 1;
             }
         }
+    }
+    return 0;
+}
+
+static int _page_uses_object(const BD_IG_PAGE *page, unsigned id)
+{
+    unsigned ii, jj;
+
+    for (ii = 0; ii < page->num_bogs; ii++) {
+        for (jj = 0; jj < page->bog[ii].num_buttons; jj++) {
+            const BD_IG_BUTTON *b = &page->bog[ii].button[jj];
+            if (_object_in_range(id, b->normal_start_object_id_ref,    b->normal_end_object_id_ref) ||
+                _object_in_range(id, b->selected_start_object_id_ref,  b->selected_end_object_id_ref) ||
+                _object_in_range(id, b->activated_start_object_id_ref, b->activated_end_object_id_ref)) {
+                return 1;
+            }
+        }
+    }
+
+    return _effects_use_object(&page->in_effects, id) || _effects_use_object(&page->out_effects, id);
+}
+
+static uint64_t _decoded_bytes(const BD_PG_OBJECT *object)
+{
+    return (uint64_t)object->img_size + object->crop_size + object->index_size + object->argb_size;
+}
+
+/* evict IG objects not used in current page until decoded images fit in memory limit */
+static void _check_memory_limit(GRAPHICS_CONTROLLER *gc)
+{
+    PG_DISPLAY_SET *s = gc->igs;
+    BD_IG_PAGE     *page;
+    uint64_t        total = 0;
+    unsigned        ii;
+
+    if (!gc->memory_limit || !s || !s->ics || !s->complete) {
+        return;
+    }
+
+    for (ii = 0; ii < s->num_object; ii++) {
+        total += _decoded_bytes(&s->object[ii]);
+    }
+    if (total <= gc->memory_limit) {
+        return;
+    }
+
+    page = _find_page(&s->ics->interactive_composition, bd_psr_read(gc->regs, PSR_MENU_PAGE_ID));
+
+    for (ii = 0; ii < s->num_object && total > gc->memory_limit; ii++) {
+        BD_PG_OBJECT *object = &s->object[ii];
+
+        if (!object->data || !object->img) {
+            continue;
+        }
+        if ((page && _page_uses_object(page, object->id)) ||
+            _effects_use_object(gc->in_effects, object->id) ||
+            _effects_use_object(gc->out_effects, object->id)) {
+            continue;
+        }
+
+        total -= pg_evict_object(object);
+        gc->num_evicted++;
+    }
+
+    if (total > gc->memory_limit) {
+        GC_TRACE("decoded objects use %"PRIu64" bytes (limit %"PRIu64")\n", total, gc->memory_limit);
+    }
+}
+
+static void _add_memory_stats(const PG_DISPLAY_SET *s, GC_MEMORY_STATS *stats)
+{
+    unsigned ii;
+
+    if (!s) {
+        return;
+    }
+
+    for (ii = 0; ii < s->num_object; ii++) {
+        const BD_PG_OBJECT *object = &s->object[ii];
+        stats->num_objects++;
+        stats->object_bytes   += object->img_size;
+        stats->cache_bytes    += object->crop_size + object->index_size + object->argb_size;
+        stats->retained_bytes += object->data_size;
+    }
+    stats->palette_bytes += (uint64_t)s->num_palette * sizeof(BD_PG_PALETTE);
+}
+
+/* decoded TextST dialogs and style. Must be called with textst_mutex locked. */
+static uint64_t _textst_memory_size(const PG_DISPLAY_SET *s)
+{
+    uint64_t size = 0;
+    unsigned ii, jj;
+
+    if (!s) {
+        return 0;
+    }
+
+    if (s->style) {
+        size += sizeof(BD_TEXTST_DIALOG_STYLE);
+        size += s->style->region_style_count * sizeof(BD_TEXTST_REGION_STYLE);
+        size += s->style->user_style_count * sizeof(BD_TEXTST_USER_STYLE);
+    }
+    if (s->dialog) {
+        size += (uint64_t)s->total_dialog * sizeof(BD_TEXTST_DIALOG_PRESENTATION);
+        for (ii = 0; ii < s->num_dialog; ii++) {
+            const BD_TEXTST_DIALOG_PRESENTATION *d = &s->dialog[ii];
+            if (d->palette_update) {
+                size += 256 * sizeof(BD_PG_PALETTE_ENTRY);
+            }
+            /* elements are variable-sized: this is lower bound */
+            for (jj = 0; jj < d->region_count; jj++) {
+                size += d->region[jj].elem_count * sizeof(BD_TEXTST_DATA);
+            }
+        }
+    }
+
+    return size;
+}
+
+void gc_get_memory_stats(GRAPHICS_CONTROLLER *gc, GC_MEMORY_STATS *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    if (!gc) {
+        return;
+    }
+
+    bd_rwlock_rdlock(&gc->mutex);
+
+    _add_memory_stats(gc->pgs, stats);
+    _add_memory_stats(gc->igs, stats);
+    stats->num_evicted   = gc->num_evicted;
+    stats->num_redecoded = gc->num_redecoded;
+
+    bd_mutex_lock(&gc->textst_mutex);
+    stats->textst_bytes  = _textst_memory_size(gc->tgs);
+    stats->textst_bytes += textst_render_memory_size(gc->textst_render);
+    bd_mutex_unlock(&gc->textst_mutex);
+
+    bd_rwlock_unlock(&gc->mutex);
+}
+
+uint64_t gc_get_overlay_cmds(GRAPHICS_CONTROLLER *gc)
+{
+    uint64_t count;
+
+    if (!gc) {
+        return 0;
+    }
+
+    bd_rwlock_rdlock(&gc->mutex);
+    count = gc->num_overlay_cmds;
+    bd_rwlock_unlock(&gc->mutex);
+
+    return count;
+}
+
+void gc_set_memory_limit(GRAPHICS_CONTROLLER *gc, uint64_t bytes)
+{
+    if (!gc) {
+        return;
+    }
+
+    _gc_lock(gc);
+
+    gc->memory_limit = bytes;
+    /* encoded segments are retained for objects decoded after this */
+    graphics_processor_retain_objects(gc->igp, bytes > 0);
+    _check_memory_limit(gc);
+
+    _gc_unlock(gc);
+}
+
+void gc_set_ig_decode_threads(GRAPHICS_CONTROLLER *gc, unsigned num_threads)
+{
+    if (!gc) {
+        return;
+    }
+
+    _gc_lock(gc);
 
-        bd_mutex_lock(&gc->mutex);
+    /* applied when next IG segments are decoded */
+    gc->ig_decode_threads = num_threads;
 
-        if (!graphics_processor_decode_ts(gc->igp, &gc->igs,
-                                          pid, block, num_blocks,
-                                          stc)) {
+    _gc_unlock(gc);
+}
+
+/*
+ * navigation commands
+ */
+
+void gc_scan_nav_cmds(GRAPHICS_CONTROLLER *gc,
+                      void (*cb)(void *handle, const struct mobj_cmd *cmds, unsigned num_cmds),
+                      void *handle)
+{
+    unsigned page_idx, bog_idx, ii;
+
+    if (!gc) {
+        return;
+    }
+
+    bd_rwlock_rdlock(&gc->mutex);
+
+    if (gc->igs && gc->igs->ics) {
+        BD_IG_INTERACTIVE_COMPOSITION *c = &gc->igs->ics->interactive_composition;
+
+        for (page_idx = 0; page_idx < c->num_pages; page_idx++) {
+            BD_IG_PAGE *page = &c->page[page_idx];
+            for (bog_idx = 0; bog_idx < page->num_bogs; bog_idx++) {
+                BD_IG_BOG *bog = &page->bog[bog_idx];
+                for (ii = 0; ii < bog->num_buttons; ii++) {
+                    if (bog->button[ii].num_nav_cmds) {
+                        cb(handle, bog->button[ii].nav_cmds, bog->button[ii].num_nav_cmds);
+                    }
+                }
+            }
+        }
+    }
+
+    bd_rwlock_unlock(&gc->mutex);
+}
+
+/*
+ * graphics stream input
+ */
+
+/* feed graphics processor with either aligned units or already demuxed PES packets */
+static int _gp_decode(GRAPHICS_PROCESSOR *gp, PG_DISPLAY_SET **s, uint16_t pid,
+                      uint8_t *block, const M2TS_UNIT_INFO *info, unsigned num_blocks,
+                      PES_BUFFER *pes, int64_t stc)
+{
+    if (block) {
+        return graphics_processor_decode_ts(gp, s, pid, block, info, num_blocks, stc);
+    }
+    return graphics_processor_decode_pes_list(gp, s, pid, pes, stc);
+}
+
+static int _textst_check_sorted(const PG_DISPLAY_SET *s)
+{
+    unsigned ii;
+
+    for (ii = 1; ii < s->num_dialog; ii++) {
+        if (s->dialog[ii].start_pts < s->dialog[ii - 1].start_pts) {
+            GC_ERROR("TextST dialogs are not in presentation order\n");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int _decode(GRAPHICS_CONTROLLER *gc, uint16_t pid,
+                   uint8_t *block, const M2TS_UNIT_INFO *info, unsigned num_blocks,
+                   PES_BUFFER *pes, int64_t stc)
+{
+    if (IS_HDMV_PID_IG(pid)) {
+        /* IG stream */
+
+        if (!gc->igp) {
+            gc->igp = graphics_processor_init();
+            if (!gc->igp) {
+                pes_buffer_free(&pes);
+                return -1;
+            }
+        }
+
+        _gc_lock(gc);
+
+        graphics_processor_retain_objects(gc->igp, gc->memory_limit > 0);
+        graphics_processor_set_threads(gc->igp, gc->ig_decode_threads);
+
+        if (!_gp_decode(gc->igp, &gc->igs,
+                        pid, block, info, num_blocks, pes,
+                        stc)) {
             /* no new complete display set */
-            bd_mutex_unlock(&gc->mutex);
+            _gc_unlock(gc);
             return 0;
         }
 
         if (!gc->igs || !gc->igs->complete) {
-            bd_mutex_unlock(&gc->mutex);
+            _gc_unlock(gc);
             return 0;
         }
 
@@ -875,7 +1738,12 @@ int gc_decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned
             }
         }
 
-        bd_mutex_unlock(&gc->mutex);
+        _check_memory_limit(gc);
+
+        /* objects may have changed */
+        gc->hit_index.valid = 0;
+
+        _gc_unlock(gc);
 
         return 1;
     }
@@ -885,12 +1753,13 @@ int gc_decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned
         if (!gc->pgp) {
             gc->pgp = graphics_processor_init();
             if (!gc->pgp) {
+                pes_buffer_free(&pes);
                 return -1;
             }
         }
-        graphics_processor_decode_ts(gc->pgp, &gc->pgs,
-                                     pid, block, num_blocks,
-                                     stc);
+        _gp_decode(gc->pgp, &gc->pgs,
+                   pid, block, info, num_blocks, pes,
+                   stc);
 
         if (!gc->pgs || !gc->pgs->complete) {
             return 0;
@@ -904,87 +1773,581 @@ int gc_decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block, unsigned
         if (!gc->tgp) {
             gc->tgp = graphics_processor_init();
             if (!gc->tgp) {
+                pes_buffer_free(&pes);
                 return -1;
             }
         }
-        graphics_processor_decode_ts(gc->tgp, &gc->tgs,
-                                     pid, block, num_blocks,
-                                     stc);
+        bd_mutex_lock(&gc->textst_mutex);
+
+        _textst_cache_clear(gc);
+        _gp_decode(gc->tgp, &gc->tgs,
+                   pid, block, info, num_blocks, pes,
+                   stc);
+
+        if (!gc->tgs || !gc->tgs->complete) {
+            gc->textst_sorted = 0;
+            bd_mutex_unlock(&gc->textst_mutex);
+            return 0;
+        }
+
+        gc->textst_sorted = _textst_check_sorted(gc->tgs);
+
+        bd_mutex_unlock(&gc->textst_mutex);
+        return 1;
+    }
+
+    pes_buffer_free(&pes);
+    return -1;
+}
+
+int gc_decode_ts(GRAPHICS_CONTROLLER *gc, uint16_t pid, uint8_t *block,
+                 const M2TS_UNIT_INFO *info, unsigned num_blocks, int64_t stc)
+{
+    if (!gc) {
+        BD_DEBUG_HOT(DBG_GC, "gc_decode_ts(): no graphics controller\n");
+        return -1;
+    }
+
+    return _decode(gc, pid, block, info, num_blocks, NULL, stc);
+}
+
+int gc_decode_unit(GRAPHICS_CONTROLLER *gc, uint16_t ig_pid, uint16_t pg_pid,
+                   uint8_t *block, const M2TS_UNIT_INFO *info, int64_t stc)
+{
+    PES_BUFFER *pes[2];
+    int         result = 0;
+
+    if (!gc) {
+        BD_DEBUG_HOT(DBG_GC, "gc_decode_unit(): no graphics controller\n");
+        return -1;
+    }
+
+    if (!ig_pid || !pg_pid) {
+        /* single stream */
+        if (ig_pid && gc_decode_ts(gc, ig_pid, block, info, 1, stc) > 0) {
+            result |= GC_DECODE_IG;
+        }
+        if (pg_pid && gc_decode_ts(gc, pg_pid, block, info, 1, stc) > 0) {
+            result |= GC_DECODE_PG;
+        }
+        return result;
+    }
+
+    if (!gc->demux || gc->demux_ig_pid != ig_pid || gc->demux_pg_pid != pg_pid) {
+        m2ts_demux_free(&gc->demux);
+        gc->demux = m2ts_demux_init(ig_pid);
+        if (!gc->demux) {
+            return -1;
+        }
+        if (m2ts_demux_add_pid(gc->demux, pg_pid) != 1) {
+            m2ts_demux_free(&gc->demux);
+            return -1;
+        }
+        gc->demux_ig_pid = ig_pid;
+        gc->demux_pg_pid = pg_pid;
+    }
+
+    /* split both streams in single pass */
+    if (m2ts_demux_multi(gc->demux, block, info, pes) < 0) {
+        return 0;
+    }
+
+    if (_decode(gc, ig_pid, NULL, NULL, 0, pes[0], stc) > 0) {
+        result |= GC_DECODE_IG;
+    }
+    if (_decode(gc, pg_pid, NULL, NULL, 0, pes[1], stc) > 0) {
+        result |= GC_DECODE_PG;
+    }
+
+    return result;
+}
+
+/*
+ * PG decoding thread
+ */
+
+#ifdef BD_HAVE_ATOMICS
+static void _pg_thread_wait(GC_PG_THREAD *t, BD_ATOMIC_UINT *flag, unsigned full)
+{
+    /* wait until queue is not empty (full == 0) or not full (full == 1) */
+    bd_mutex_lock(&t->mutex);
+    bd_atomic_store(flag, 1);
+    bd_atomic_fence();
+    while (!bd_atomic_load(&t->exit)) {
+        unsigned used = bd_atomic_load(&t->write_idx) - bd_atomic_load(&t->read_idx);
+        if (full ? used < GC_PG_QUEUE_SIZE : used > 0) {
+            break;
+        }
+        bd_cond_wait(&t->cond, &t->mutex);
+    }
+    bd_atomic_store(flag, 0);
+    bd_mutex_unlock(&t->mutex);
+}
+
+static void _pg_thread_wake(GC_PG_THREAD *t, BD_ATOMIC_UINT *flag)
+{
+    bd_atomic_fence();
+    if (bd_atomic_load(flag)) {
+        bd_mutex_lock(&t->mutex);
+        bd_cond_signal(&t->cond);
+        bd_mutex_unlock(&t->mutex);
+    }
+}
+
+static void *_pg_thread_worker(void *p)
+{
+    GRAPHICS_CONTROLLER *gc = (GRAPHICS_CONTROLLER *)p;
+    GC_PG_THREAD        *t  = gc->pg_thread;
+
+    while (!bd_atomic_load(&t->exit)) {
+        unsigned idx = bd_atomic_load(&t->read_idx);
+
+        if (bd_atomic_load(&t->write_idx) == idx) {
+            _pg_thread_wait(t, &t->worker_idle, 0);
+            continue;
+        }
+
+        GC_PG_UNIT *u = &t->units[idx % GC_PG_QUEUE_SIZE];
+
+        _gc_lock(gc);
+        if (u->generation == bd_atomic_load(&t->generation)) {
+            if (gc_decode_ts(gc, u->pid, u->unit, NULL, 1, -1) > 0) {
+                /* render subtitles */
+                gc_run(gc, GC_CTRL_PG_UPDATE, 0, NULL);
+            }
+        }
+        _gc_unlock(gc);
+
+        bd_atomic_store(&t->read_idx, idx + 1);
+        _pg_thread_wake(t, &t->reader_waiting);
+    }
+
+    return NULL;
+}
+#endif /* BD_HAVE_ATOMICS */
+
+int gc_start_pg_thread(GRAPHICS_CONTROLLER *gc)
+{
+#ifdef BD_HAVE_ATOMICS
+    GC_PG_THREAD *t;
+
+    if (!gc) {
+        return -1;
+    }
+    if (gc->pg_thread) {
+        return 0;
+    }
+
+    t = calloc(1, sizeof(*t));
+    if (!t) {
+        GC_ERROR("gc_start_pg_thread(): out of memory\n");
+        return -1;
+    }
+    t->units = malloc(GC_PG_QUEUE_SIZE * sizeof(*t->units));
+    if (!t->units) {
+        GC_ERROR("gc_start_pg_thread(): out of memory\n");
+        X_FREE(t);
+        return -1;
+    }
+
+    bd_mutex_init(&t->mutex);
+    bd_cond_init(&t->cond);
+
+    _gc_lock(gc);
+    gc->pg_thread = t;
+    _gc_unlock(gc);
+
+    if (bd_thread_create(&t->thread, "bd_pg", _pg_thread_worker, gc) < 0) {
+        _gc_lock(gc);
+        gc->pg_thread = NULL;
+        _gc_unlock(gc);
+        bd_cond_destroy(&t->cond);
+        bd_mutex_destroy(&t->mutex);
+        X_FREE(t->units);
+        X_FREE(t);
+        return -1;
+    }
+
+    GC_TRACE("PG decoding thread started\n");
+    return 0;
+#else
+    (void)gc;
+    GC_ERROR("gc_start_pg_thread(): atomic operations not supported\n");
+    return -1;
+#endif
+}
+
+void gc_stop_pg_thread(GRAPHICS_CONTROLLER *gc)
+{
+#ifdef BD_HAVE_ATOMICS
+    GC_PG_THREAD *t;
+
+    if (!gc || !gc->pg_thread) {
+        return;
+    }
+    t = gc->pg_thread;
+
+    bd_mutex_lock(&t->mutex);
+    bd_atomic_store(&t->exit, 1);
+    bd_cond_broadcast(&t->cond);
+    bd_mutex_unlock(&t->mutex);
+
+    bd_thread_join(&t->thread);
+
+    _gc_lock(gc);
+    gc->pg_thread = NULL;
+    _gc_unlock(gc);
+
+    bd_cond_destroy(&t->cond);
+    bd_mutex_destroy(&t->mutex);
+    X_FREE(t->units);
+    X_FREE(t);
+
+    GC_TRACE("PG decoding thread stopped\n");
+#else
+    (void)gc;
+#endif
+}
+
+int gc_decode_pg_async(GRAPHICS_CONTROLLER *gc, uint16_t pg_pid,
+                       const uint8_t *block, const M2TS_UNIT_INFO *info)
+{
+#ifdef BD_HAVE_ATOMICS
+    GC_PG_THREAD *t;
+    unsigned      idx;
+
+    if (!gc || !gc->pg_thread) {
+        return -1;
+    }
+    t = gc->pg_thread;
+
+    /* skip units without PG packets */
+    if (info && !m2ts_scan_has_pid(info, pg_pid)) {
+        return 0;
+    }
+
+    idx = bd_atomic_load(&t->write_idx);
+    if (idx - bd_atomic_load(&t->read_idx) >= GC_PG_QUEUE_SIZE) {
+        GC_TRACE("gc_decode_pg_async(): queue full\n");
+        _pg_thread_wait(t, &t->reader_waiting, 1);
+        if (bd_atomic_load(&t->exit)) {
+            return -1;
+        }
+    }
+
+    GC_PG_UNIT *u = &t->units[idx % GC_PG_QUEUE_SIZE];
+    memcpy(u->unit, block, sizeof(u->unit));
+    u->pid        = pg_pid;
+    u->generation = bd_atomic_load(&t->generation);
+
+    bd_atomic_store(&t->write_idx, idx + 1);
+    _pg_thread_wake(t, &t->worker_idle);
+
+    return 1;
+#else
+    (void)gc; (void)pg_pid; (void)block; (void)info;
+    return -1;
+#endif
+}
+
+/*
+ * overlay output options
+ */
+
+void gc_set_overlay_index(GRAPHICS_CONTROLLER *gc, int enable)
+{
+    if (!gc) {
+        return;
+    }
+
+    _gc_lock(gc);
+    gc->overlay_index = !!enable;
+    _gc_unlock(gc);
+}
+
+void gc_set_overlay_argb(GRAPHICS_CONTROLLER *gc, int enable)
+{
+    if (!gc) {
+        return;
+    }
+
+    _gc_lock(gc);
+    gc->overlay_argb = !!enable;
+    _gc_unlock(gc);
+}
+
+/*
+ * TextST rendering
+ */
+
+static int _textst_style_select(GRAPHICS_CONTROLLER *p, int user_style_idx)
+{
+    p->textst_user_style = user_style_idx;
+
+    GC_ERROR("User style selection not implemented\n");
+    return -1;
+}
+
+int gc_add_font(GRAPHICS_CONTROLLER *p, void *data, size_t size)
+{
+    int result;
+
+    if (!p) {
+        return -1;
+    }
+
+    bd_mutex_lock(&p->textst_mutex);
+
+    _textst_cache_clear(p);
+
+    if (!data) {
+        textst_render_free(&p->textst_render);
+        bd_mutex_unlock(&p->textst_mutex);
+        return 0;
+    }
+
+    if (!p->textst_render) {
+        p->textst_render = textst_render_init();
+        if (!p->textst_render) {
+            bd_mutex_unlock(&p->textst_mutex);
+            return -1;
+        }
+    }
+
+    result = textst_render_add_font(p->textst_render, data, size);
+
+    bd_mutex_unlock(&p->textst_mutex);
+
+    return result;
+}
+
+/* render one dialog region to RLE image. Must be called with textst_mutex locked. */
+static BD_PG_RLE_ELEM *_textst_region_rle(GRAPHICS_CONTROLLER *p, const BD_TEXTST_REGION_STYLE *style,
+                                          const BD_TEXTST_DIALOG_REGION *region)
+{
+    BD_PG_RLE_ELEM *img;
+    unsigned bmp_y;
+    uint16_t y;
+    RLE_ENC  rle;
+
+    TEXTST_BITMAP bmp = {NULL, style->text_box.width, style->text_box.height, style->text_box.width, 0};
+    bmp.mem = malloc((size_t)bmp.width * bmp.height);
+    if (!bmp.mem) {
+        GC_ERROR("_render_textst(): out of memory\n");
+        return NULL;
+    }
+
+    memset(bmp.mem, style->region_info.background_color, (size_t)bmp.width * bmp.height);
+
+    textst_render(p->textst_render, &bmp, style, region);
+
+    rle_begin(&rle);
+
+    for (y = 0, bmp_y = 0; y < style->region_info.region.height; y++) {
+        if (y < style->text_box.ypos || y >= style->text_box.ypos + style->text_box.height) {
+            rle_add_bite(&rle, style->region_info.background_color, style->region_info.region.width);
+        } else {
+            rle_add_bite(&rle, style->region_info.background_color, style->text_box.xpos);
+            rle_compress_chunk(&rle, bmp.mem + bmp.stride * bmp_y, bmp.width);
+            bmp_y++;
+            rle_add_bite(&rle, style->region_info.background_color,
+                         style->region_info.region.width - style->text_box.width - style->text_box.xpos);
+        }
+
+        rle_add_eol(&rle);
+    }
+
+    X_FREE(bmp.mem);
+
+    /* keep reference to encoded image */
+    img = rle_get(&rle);
+    rle.elem = NULL;
+
+    return img;
+}
+
+/* get pre-rendered region or render it now */
+static BD_PG_RLE_ELEM *_textst_get_region_rle(GRAPHICS_CONTROLLER *p, unsigned dialog_idx, unsigned region_idx,
+                                              const BD_TEXTST_REGION_STYLE *style,
+                                              const BD_TEXTST_DIALOG_REGION *region)
+{
+    BD_PG_RLE_ELEM *img = NULL;
+
+    bd_mutex_lock(&p->textst_mutex);
+
+    if (p->textst_thread) {
+        TEXTST_PRERENDERED *d = &p->textst_thread->cache[dialog_idx % TEXTST_PRERENDER_DIALOGS];
+        if (d->dialog_idx == (int)dialog_idx && region_idx < 2) {
+            img = d->rle[region_idx];
+            d->rle[region_idx] = NULL;
+        }
+    }
+    if (!img) {
+        img = _textst_region_rle(p, style, region);
+    }
+
+    bd_mutex_unlock(&p->textst_mutex);
+
+    return img;
+}
+
+/* notify pre-rendering thread about presentation position */
+static void _textst_thread_update(GRAPHICS_CONTROLLER *p)
+{
+    if (p->textst_thread) {
+        bd_mutex_lock(&p->textst_mutex);
+        p->textst_thread->next = p->next_dialog_idx;
+        bd_cond_signal(&p->textst_thread->cond);
+        bd_mutex_unlock(&p->textst_mutex);
+    }
+}
+
+/*
+ * TextST pre-rendering thread
+ */
+
+/* render next not yet rendered dialog. Must be called with textst_mutex locked. */
+static int _textst_prerender_next(GRAPHICS_CONTROLLER *gc)
+{
+    TEXTST_THREAD  *t = gc->textst_thread;
+    PG_DISPLAY_SET *s = gc->tgs;
+    unsigned        ii, jj;
+
+    if (!s || !s->complete || !s->dialog || !s->style || !gc->textst_render) {
+        return 0;
+    }
+
+    for (ii = t->next; ii < s->num_dialog && ii < t->next + TEXTST_PRERENDER_DIALOGS; ii++) {
+        BD_TEXTST_DIALOG_PRESENTATION *dialog = &s->dialog[ii];
+        TEXTST_PRERENDERED            *d      = &t->cache[ii % TEXTST_PRERENDER_DIALOGS];
+
+        if (d->dialog_idx == (int)ii) {
+            continue;
+        }
+
+        bd_refcnt_dec(d->rle[0]);
+        bd_refcnt_dec(d->rle[1]);
+        d->rle[0] = d->rle[1] = NULL;
+        d->dialog_idx = ii;
+
+        if (dialog->palette_update) {
+            continue;
+        }
 
-        if (!gc->tgs || !gc->tgs->complete) {
-            return 0;
+        for (jj = 0; jj < dialog->region_count && jj < 2; jj++) {
+            BD_TEXTST_DIALOG_REGION *region = &dialog->region[jj];
+            BD_TEXTST_REGION_STYLE  *style  = _find_region_style(s->style, region->region_style_id_ref);
+            if (style) {
+                d->rle[jj] = _textst_region_rle(gc, style, region);
+            }
         }
 
+        GC_TRACE("TextST dialog #%d pre-rendered\n", ii);
         return 1;
     }
 
-    return -1;
+    return 0;
 }
 
-/*
- * TextST rendering
- */
-
-static int _textst_style_select(GRAPHICS_CONTROLLER *p, int user_style_idx)
+static void *_textst_thread_worker(void *p)
 {
-    p->textst_user_style = user_style_idx;
+    GRAPHICS_CONTROLLER *gc = (GRAPHICS_CONTROLLER *)p;
+    TEXTST_THREAD       *t  = gc->textst_thread;
 
-    GC_ERROR("User style selection not implemented\n");
-    return -1;
+    bd_mutex_lock(&gc->textst_mutex);
+
+    while (!t->exit) {
+        if (!_textst_prerender_next(gc)) {
+            bd_cond_wait(&t->cond, &gc->textst_mutex);
+        }
+    }
+
+    bd_mutex_unlock(&gc->textst_mutex);
+
+    return NULL;
 }
 
-int gc_add_font(GRAPHICS_CONTROLLER *p, void *data, size_t size)
+int gc_start_textst_thread(GRAPHICS_CONTROLLER *gc)
 {
-    if (!p) {
+    TEXTST_THREAD *t;
+    unsigned       ii;
+
+    if (!gc) {
         return -1;
     }
-
-    if (!data) {
-        textst_render_free(&p->textst_render);
+    if (gc->textst_thread) {
         return 0;
     }
 
-    if (!p->textst_render) {
-        p->textst_render = textst_render_init();
-        if (!p->textst_render) {
-            return -1;
-        }
+    t = calloc(1, sizeof(*t));
+    if (!t) {
+        GC_ERROR("gc_start_textst_thread(): out of memory\n");
+        return -1;
+    }
+    for (ii = 0; ii < TEXTST_PRERENDER_DIALOGS; ii++) {
+        t->cache[ii].dialog_idx = -1;
+    }
+    bd_cond_init(&t->cond);
+
+    bd_mutex_lock(&gc->textst_mutex);
+    t->next = gc->next_dialog_idx;
+    gc->textst_thread = t;
+    bd_mutex_unlock(&gc->textst_mutex);
+
+    if (bd_thread_create(&t->thread, "bd_textst", _textst_thread_worker, gc) < 0) {
+        bd_mutex_lock(&gc->textst_mutex);
+        gc->textst_thread = NULL;
+        bd_mutex_unlock(&gc->textst_mutex);
+        bd_cond_destroy(&t->cond);
+        X_FREE(t);
+        return -1;
     }
 
-    return textst_render_add_font(p->textst_render, data, size);
+    GC_TRACE("TextST pre-rendering thread started\n");
+    return 0;
 }
 
-static int _render_textst_region(GRAPHICS_CONTROLLER *p, int64_t pts, BD_TEXTST_REGION_STYLE *style, TEXTST_BITMAP *bmp,
-                                 BD_PG_PALETTE_ENTRY *palette)
+void gc_stop_textst_thread(GRAPHICS_CONTROLLER *gc)
 {
-    unsigned bmp_y;
-    uint16_t y;
-    RLE_ENC  rle;
+    TEXTST_THREAD *t;
 
-    rle_begin(&rle);
+    if (!gc || !gc->textst_thread) {
+        return;
+    }
+    t = gc->textst_thread;
 
-    for (y = 0, bmp_y = 0; y < style->region_info.region.height; y++) {
-        if (y < style->text_box.ypos || y >= style->text_box.ypos + style->text_box.height) {
-            rle_add_bite(&rle, style->region_info.background_color, style->region_info.region.width);
-        } else {
-            rle_add_bite(&rle, style->region_info.background_color, style->text_box.xpos);
-            rle_compress_chunk(&rle, bmp->mem + bmp->stride * bmp_y, bmp->width);
-            bmp_y++;
-            rle_add_bite(&rle, style->region_info.background_color,
-                         style->region_info.region.width - style->text_box.width - style->text_box.xpos);
-        }
+    bd_mutex_lock(&gc->textst_mutex);
+    t->exit = 1;
+    bd_cond_signal(&t->cond);
+    bd_mutex_unlock(&gc->textst_mutex);
 
-        rle_add_eol(&rle);
-    }
+    bd_thread_join(&t->thread);
 
-    _render_rle(p, pts, rle_get(&rle),
-                style->region_info.region.xpos, style->region_info.region.ypos,
-                style->region_info.region.width, style->region_info.region.height,
-                palette);
+    bd_mutex_lock(&gc->textst_mutex);
+    _textst_cache_clear(gc);
+    gc->textst_thread = NULL;
+    bd_mutex_unlock(&gc->textst_mutex);
 
-    rle_end(&rle);
+    bd_cond_destroy(&t->cond);
+    X_FREE(t);
 
-    return 0;
+    GC_TRACE("TextST pre-rendering thread stopped\n");
+}
+
+/* first dialog starting at or after pts (dialogs sorted by start time) */
+static unsigned _textst_find_dialog(const PG_DISPLAY_SET *s, unsigned first, int64_t pts)
+{
+    unsigned lo = first, hi = s->num_dialog;
+
+    while (lo < hi) {
+        unsigned mid = lo + (hi - lo) / 2;
+        if (s->dialog[mid].start_pts < pts) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
 }
 
 static int _render_textst(GRAPHICS_CONTROLLER *p, uint32_t stc, GC_NAV_CMDS *cmds)
@@ -1005,6 +2368,12 @@ static int _render_textst(GRAPHICS_CONTROLLER *p, uint32_t stc, GC_NAV_CMDS *cmd
 
     dialog = s->dialog;
 
+    /* skip dialogs with start time passed (ex. after seek) */
+    if (p->textst_sorted && now >= 1 && (unsigned)p->next_dialog_idx < s->num_dialog &&
+        dialog[p->next_dialog_idx].start_pts < now - 45000) {
+        p->next_dialog_idx = _textst_find_dialog(s, p->next_dialog_idx, now - 45000);
+    }
+
     /* loop over all matching dialogs */
     for (ii = p->next_dialog_idx; ii < s->num_dialog; ii++) {
 
@@ -1015,6 +2384,7 @@ static int _render_textst(GRAPHICS_CONTROLLER *p, uint32_t stc, GC_NAV_CMDS *cmd
             if (cmds) {
                 cmds->wakeup_time = (uint32_t)(dialog[ii].start_pts / 2);
             }
+            _textst_thread_update(p);
             return 1;
         }
 
@@ -1073,18 +2443,13 @@ static int _render_textst(GRAPHICS_CONTROLLER *p, uint32_t stc, GC_NAV_CMDS *cmd
                 continue;
             }
 
-            TEXTST_BITMAP bmp = {NULL, style->text_box.width, style->text_box.height, style->text_box.width, 0};
-            bmp.mem = malloc((size_t)bmp.width * bmp.height);
-            if (bmp.mem) {
-                memset(bmp.mem, style->region_info.background_color, (size_t)bmp.width * bmp.height);
-
-                textst_render(p->textst_render, &bmp, style, region);
-
-                _render_textst_region(p, dialog[ii].start_pts, style, &bmp, s->style->palette);
-
-                X_FREE(bmp.mem);
-            } else {
-                GC_ERROR("_render_textst(): out of memory\n");
+            BD_PG_RLE_ELEM *img = _textst_get_region_rle(p, ii, jj, style, region);
+            if (img) {
+                _render_rle(p, dialog[ii].start_pts, img,
+                            style->region_info.region.xpos, style->region_info.region.ypos,
+                            style->region_info.region.width, style->region_info.region.height,
+                            s->style->palette);
+                bd_refcnt_dec(img);
             }
         }
 
@@ -1118,6 +2483,8 @@ static int _render_textst(GRAPHICS_CONTROLLER *p, uint32_t stc, GC_NAV_CMDS *cmd
         _flush_osd(p, BD_OVERLAY_PG, dialog[ii].end_pts);
     }
 
+    _textst_thread_update(p);
+
     return 0;
 }
 
@@ -1216,7 +2583,10 @@ static int _render_pg(GRAPHICS_CONTROLLER *gc)
 
 static void _reset_pg(GRAPHICS_CONTROLLER *gc)
 {
+    _discard_pg_queue(gc);
+
     graphics_processor_free(&gc->pgp);
+    m2ts_demux_free(&gc->demux);
 
     pg_display_set_free(&gc->pgs);
 
@@ -1225,12 +2595,70 @@ static void _reset_pg(GRAPHICS_CONTROLLER *gc)
     }
 
     gc->next_dialog_idx = 0;
+    _textst_thread_update(gc);
 }
 
 /*
  * IG rendering
  */
 
+static void _clear_bog_strip(GRAPHICS_CONTROLLER *gc, BOG_DATA *bog_data,
+                             unsigned x0, unsigned y0, unsigned x1, unsigned y1)
+{
+    BOG_DATA strip;
+    unsigned ii;
+
+    if (x1 <= x0 || y1 <= y0) {
+        return;
+    }
+
+    strip.x = x0;
+    strip.y = y0;
+    strip.w = x1 - x0;
+    strip.h = y1 - y0;
+
+    /* make sure we won't wipe other buttons */
+    for (ii = 0; &gc->bog_data[ii] != bog_data; ii++) {
+        if (gc->bog_data[ii].w && _areas_overlap(&strip, &gc->bog_data[ii])) {
+            GC_TRACE("  ** NOT ** clearing background at %d,%d %dx%d (overlaps bog %d)\n",
+                     strip.x, strip.y, strip.w, strip.h, ii);
+            return;
+        }
+    }
+
+    GC_TRACE("  clearing background at %d,%d %dx%d\n", strip.x, strip.y, strip.w, strip.h);
+
+    _clear_osd_area(gc, BD_OVERLAY_IG, -1, strip.x, strip.y, strip.w, strip.h);
+    gc->ig_dirty = 1;
+}
+
+/* wipe part of drawn button area that is not covered by new object */
+static void _clear_uncovered_bog_area(GRAPHICS_CONTROLLER *gc, BOG_DATA *bog_data,
+                                      unsigned x, unsigned y, unsigned w, unsigned h)
+{
+    unsigned ox0 = bog_data->x, ox1 = bog_data->x + bog_data->w;
+    unsigned oy0 = bog_data->y, oy1 = bog_data->y + bog_data->h;
+    unsigned ix0 = BD_MAX(ox0, x), ix1 = BD_MIN(ox1, x + w);
+    unsigned iy0 = BD_MAX(oy0, y), iy1 = BD_MIN(oy1, y + h);
+
+    if (!gc->ig_drawn || !bog_data->w || !bog_data->h) {
+        return;
+    }
+
+    GC_TRACE("object size changed (%d,%d %dx%d -> %d,%d %dx%d)\n",
+             bog_data->x, bog_data->y, bog_data->w, bog_data->h, x, y, w, h);
+
+    if (ix0 >= ix1 || iy0 >= iy1) {
+        /* no overlap */
+        _clear_bog_strip(gc, bog_data, ox0, oy0, ox1, oy1);
+    } else {
+        _clear_bog_strip(gc, bog_data, ox0, oy0, ox1, iy0); /* top */
+        _clear_bog_strip(gc, bog_data, ox0, iy1, ox1, oy1); /* bottom */
+        _clear_bog_strip(gc, bog_data, ox0, iy0, ix0, iy1); /* left */
+        _clear_bog_strip(gc, bog_data, ix1, iy0, ox1, iy1); /* right */
+    }
+}
+
 static void _render_button(GRAPHICS_CONTROLLER *gc, BD_IG_BUTTON *button, BD_PG_PALETTE *palette,
                            int state, BOG_DATA *bog_data)
 {
@@ -1261,21 +2689,7 @@ static void _render_button(GRAPHICS_CONTROLLER *gc, BD_IG_BUTTON *button, BD_PG_
         bog_data->x != button->x_pos ||
         bog_data->y != button->y_pos) {
 
-        /* make sure we won't wipe other buttons */
-        unsigned ii, skip = 0;
-        for (ii = 0; &gc->bog_data[ii] != bog_data; ii++) {
-            if (_areas_overlap(bog_data, &gc->bog_data[ii]))
-                skip = 1;
-            /* FIXME: clean non-overlapping area */
-        }
-
-        GC_TRACE("object size changed, %sclearing background at %d,%d %dx%d\n",
-                 skip ? " ** NOT ** " : "",
-                 bog_data->x, bog_data->y, bog_data->w, bog_data->h);
-
-        if (!skip) {
-            _clear_bog_area(gc, bog_data);
-        }
+        _clear_uncovered_bog_area(gc, bog_data, button->x_pos, button->y_pos, object->width, object->height);
     }
 
     GC_TRACE("render button #%d using object #%d at %d,%d %dx%d\n",
@@ -1347,6 +2761,52 @@ static int _render_effect(GRAPHICS_CONTROLLER *gc, BD_IG_EFFECT *effect)
     return 0;
 }
 
+/* expand all button state images (including animation frames) of page to ARGB cache.
+ * Later state changes and animation steps reference cached images. */
+static void _prerender_page(GRAPHICS_CONTROLLER *gc, BD_IG_PAGE *page, BD_PG_PALETTE *palette)
+{
+    unsigned ii, jj, state, id;
+
+    _update_palette_argb(gc, BD_OVERLAY_IG, palette);
+
+    for (ii = 0; ii < page->num_bogs; ii++) {
+        BD_IG_BOG *bog = &page->bog[ii];
+
+        for (jj = 0; jj < bog->num_buttons; jj++) {
+            BD_IG_BUTTON *button = &bog->button[jj];
+
+            for (state = BTN_NORMAL; state <= BTN_ACTIVATED; state++) {
+                unsigned start = 0xffff, end = 0xffff;
+
+                switch (state) {
+                    case BTN_NORMAL:
+                        start = button->normal_start_object_id_ref;
+                        end   = button->normal_end_object_id_ref;
+                        break;
+                    case BTN_SELECTED:
+                        start = button->selected_start_object_id_ref;
+                        end   = button->selected_end_object_id_ref;
+                        break;
+                    case BTN_ACTIVATED:
+                        start = button->activated_start_object_id_ref;
+                        end   = button->activated_end_object_id_ref;
+                        break;
+                }
+                if (end == 0xffff || end < start) {
+                    end = start;
+                }
+
+                for (id = start; id <= end && id < 0xffff; id++) {
+                    BD_PG_OBJECT *object = _find_object(gc->igs, id);
+                    if (object && _load_object(gc, object)) {
+                        _argb_object(object, object->img, object->serial, object->width, object->height, palette);
+                    }
+                }
+            }
+        }
+    }
+}
+
 static int _render_page(GRAPHICS_CONTROLLER *gc,
                          unsigned activated_button_id,
                          GC_NAV_CMDS *cmds)
@@ -1406,6 +2866,10 @@ static int _render_page(GRAPHICS_CONTROLLER *gc,
     GC_TRACE("rendering page #%d using palette #%d. page has %d bogs\n",
           page->id, page->palette_id_ref, page->num_bogs);
 
+    if (gc->overlay_argb) {
+        _prerender_page(gc, page, palette);
+    }
+
     if (!gc->ig_open) {
         _open_osd(gc, BD_OVERLAY_IG, 0, 0,
                   s->ics->video_descriptor.video_width,
@@ -1682,6 +3146,7 @@ static void _set_button_page(GRAPHICS_CONTROLLER *gc, uint32_t param)
 
     if (button) {
         gc->bog_data[bog_idx].enabled_button = button_id;
+        gc->hit_index.valid = 0;
         _select_button(gc, button_id);
     }
 
@@ -1713,6 +3178,8 @@ static void _enable_button(GRAPHICS_CONTROLLER *gc, uint32_t button_id, unsigned
         return;
     }
 
+    gc->hit_index.valid = 0;
+
     if (enable) {
         if (gc->bog_data[bog_idx].enabled_button == cur_btn_id) {
             /* selected button goes to disabled state */
@@ -1753,14 +3220,152 @@ static void _update_selected_button(GRAPHICS_CONTROLLER *gc)
     }
 }
 
+static unsigned _hit_cell(unsigned v, unsigned cell_size)
+{
+    v /= cell_size;
+    return v < GC_HIT_GRID ? v : GC_HIT_GRID - 1;
+}
+
+static int _build_hit_index(GRAPHICS_CONTROLLER *gc, BD_IG_PAGE *page, unsigned page_id)
+{
+    GC_HIT_INDEX   *hi = &gc->hit_index;
+    PG_DISPLAY_SET *s  = gc->igs;
+    unsigned        count[GC_HIT_GRID * GC_HIT_GRID] = {0};
+    unsigned        ii, cx, cy;
+
+    if (hi->num_bogs != page->num_bogs || !hi->rect) {
+        GC_HIT_RECT *tmp = realloc(hi->rect, (page->num_bogs + 1) * sizeof(*hi->rect));
+        if (!tmp) {
+            GC_ERROR("_build_hit_index(): out of memory\n");
+            return 0;
+        }
+        hi->rect     = tmp;
+        hi->num_bogs = page->num_bogs;
+    }
+
+    hi->cell_w = (s->ics->video_descriptor.video_width  + GC_HIT_GRID - 1) / GC_HIT_GRID;
+    hi->cell_h = (s->ics->video_descriptor.video_height + GC_HIT_GRID - 1) / GC_HIT_GRID;
+    if (!hi->cell_w) hi->cell_w = 1;
+    if (!hi->cell_h) hi->cell_h = 1;
+
+    /* button areas */
+    for (ii = 0; ii < page->num_bogs; ii++) {
+        BD_IG_BUTTON *button = _find_button_bog(&page->bog[ii], gc->bog_data[ii].enabled_button);
+        BD_PG_OBJECT *object = button ? _find_object_for_button(s, button, BTN_SELECTED, NULL) : NULL;
+        GC_HIT_RECT  *r      = &hi->rect[ii];
+
+        r->x0 = r->y0 = r->x1 = r->y1 = 0;
+        if (!object || !object->width || !object->height) {
+            continue;
+        }
+        r->x0 = button->x_pos;
+        r->y0 = button->y_pos;
+        r->x1 = BD_MIN(0xffff, button->x_pos + object->width);
+        r->y1 = BD_MIN(0xffff, button->y_pos + object->height);
+
+        for (cy = _hit_cell(r->y0, hi->cell_h); cy <= _hit_cell(r->y1 - 1, hi->cell_h); cy++) {
+            for (cx = _hit_cell(r->x0, hi->cell_w); cx <= _hit_cell(r->x1 - 1, hi->cell_w); cx++) {
+                count[cy * GC_HIT_GRID + cx]++;
+            }
+        }
+    }
+
+    /* cell lists */
+    hi->cell_start[0] = 0;
+    for (ii = 0; ii < GC_HIT_GRID * GC_HIT_GRID; ii++) {
+        hi->cell_start[ii + 1] = hi->cell_start[ii] + count[ii];
+        count[ii] = hi->cell_start[ii];
+    }
+
+    X_FREE(hi->cell_bogs);
+    if (hi->cell_start[GC_HIT_GRID * GC_HIT_GRID]) {
+        hi->cell_bogs = malloc(hi->cell_start[GC_HIT_GRID * GC_HIT_GRID] * sizeof(*hi->cell_bogs));
+        if (!hi->cell_bogs) {
+            GC_ERROR("_build_hit_index(): out of memory\n");
+            return 0;
+        }
+    }
+
+    for (ii = 0; ii < page->num_bogs; ii++) {
+        GC_HIT_RECT *r = &hi->rect[ii];
+        if (r->x1 <= r->x0 || r->y1 <= r->y0) {
+            continue;
+        }
+        for (cy = _hit_cell(r->y0, hi->cell_h); cy <= _hit_cell(r->y1 - 1, hi->cell_h); cy++) {
+            for (cx = _hit_cell(r->x0, hi->cell_w); cx <= _hit_cell(r->x1 - 1, hi->cell_w); cx++) {
+                hi->cell_bogs[count[cy * GC_HIT_GRID + cx]++] = ii;
+            }
+        }
+    }
+
+    hi->page_id = page_id;
+    hi->valid   = 1;
+
+    return 1;
+}
+
+/* find button overlap group of enabled button at (x,y). Returns -1 if none. */
+static int _hit_test(GRAPHICS_CONTROLLER *gc, BD_IG_PAGE *page, unsigned page_id, uint16_t x, uint16_t y)
+{
+    GC_HIT_INDEX *hi = &gc->hit_index;
+    unsigned      cell, ii;
+
+    if (!hi->valid || hi->page_id != page_id || hi->num_bogs != page->num_bogs) {
+        if (!_build_hit_index(gc, page, page_id)) {
+            hi->valid = 0;
+            return -2;
+        }
+    }
+
+    cell = _hit_cell(y, hi->cell_h) * GC_HIT_GRID + _hit_cell(x, hi->cell_w);
+
+    for (ii = hi->cell_start[cell]; ii < hi->cell_start[cell + 1]; ii++) {
+        const GC_HIT_RECT *r = &hi->rect[hi->cell_bogs[ii]];
+        if (x >= r->x0 && y >= r->y0 && x < r->x1 && y < r->y1) {
+            return hi->cell_bogs[ii];
+        }
+    }
+
+    return -1;
+}
+
+/* linear search (used if index can't be allocated) */
+static int _hit_test_linear(GRAPHICS_CONTROLLER *gc, BD_IG_PAGE *page, uint16_t x, uint16_t y)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < page->num_bogs; ii++) {
+        BD_IG_BOG    *bog      = &page->bog[ii];
+        unsigned      valid_id = gc->bog_data[ii].enabled_button;
+        BD_IG_BUTTON *button   = _find_button_bog(bog, valid_id);
+
+        if (!button)
+            continue;
+
+        if (x < button->x_pos || y < button->y_pos)
+            continue;
+
+        BD_PG_OBJECT *object = _find_object_for_button(gc->igs, button, BTN_SELECTED, NULL);
+        if (!object)
+            continue;
+
+        if (x >= button->x_pos + object->width || y >= button->y_pos + object->height)
+            continue;
+
+        return ii;
+    }
+
+    return -1;
+}
+
 static int _mouse_move(GRAPHICS_CONTROLLER *gc, uint16_t x, uint16_t y, GC_NAV_CMDS *cmds)
 {
     PG_DISPLAY_SET *s          = gc->igs;
     BD_IG_PAGE     *page       = NULL;
+    BD_IG_BUTTON   *button     = NULL;
     unsigned        page_id    = bd_psr_read(gc->regs, PSR_MENU_PAGE_ID);
     unsigned        cur_btn_id = bd_psr_read(gc->regs, PSR_SELECTED_BUTTON_ID);
-    unsigned        new_btn_id = 0xffff;
-    unsigned        ii;
+    int             bog_idx;
 
     gc->valid_mouse_position = 0;
 
@@ -1781,25 +3386,16 @@ static int _mouse_move(GRAPHICS_CONTROLLER *gc, uint16_t x, uint16_t y, GC_NAV_C
         return -1;
     }
 
-    for (ii = 0; ii < page->num_bogs; ii++) {
-        BD_IG_BOG    *bog      = &page->bog[ii];
-        unsigned      valid_id = gc->bog_data[ii].enabled_button;
-        BD_IG_BUTTON *button   = _find_button_bog(bog, valid_id);
-
-        if (!button)
-            continue;
-
-        if (x < button->x_pos || y < button->y_pos)
-            continue;
-
-        /* Check for SELECTED state object (button that can be selected) */
-        BD_PG_OBJECT *object = _find_object_for_button(s, button, BTN_SELECTED, NULL);
-        if (!object)
-            continue;
-
-        if (x >= button->x_pos + object->width || y >= button->y_pos + object->height)
-            continue;
+    /* Check for SELECTED state object (button that can be selected) */
+    bog_idx = _hit_test(gc, page, page_id, x, y);
+    if (bog_idx < -1) {
+        bog_idx = _hit_test_linear(gc, page, x, y);
+    }
+    if (bog_idx >= 0) {
+        button = _find_button_bog(&page->bog[bog_idx], gc->bog_data[bog_idx].enabled_button);
+    }
 
+    if (button) {
         /* mouse is over button */
         gc->valid_mouse_position = 1;
 
@@ -1808,17 +3404,11 @@ static int _mouse_move(GRAPHICS_CONTROLLER *gc, uint16_t x, uint16_t y, GC_NAV_C
             return 1;
         }
 
-        new_btn_id = button->id;
-
         if (cmds) {
             cmds->sound_id_ref = button->selected_sound_id_ref;
         }
 
-        break;
-    }
-
-    if (new_btn_id != 0xffff) {
-        _select_button(gc, new_btn_id);
+        _select_button(gc, button->id);
 
         _render_page(gc, -1, cmds);
 
@@ -1907,6 +3497,63 @@ static int _run_timers(GRAPHICS_CONTROLLER *gc, GC_NAV_CMDS *cmds)
     return result;
 }
 
+int gc_next_timer(GRAPHICS_CONTROLLER *gc, int64_t *pts)
+{
+    int64_t next = -1;
+
+    if (!gc) {
+        return 0;
+    }
+
+    bd_rwlock_rdlock(&gc->mutex);
+
+    if (gc->ig_open) {
+        /* same conditions as in _animate() and _run_timers() */
+        if (gc->out_effects) {
+            next = gc->next_effect_time + gc->out_effects->effect[gc->effect_idx].duration;
+        } else if (gc->in_effects) {
+            next = gc->next_effect_time + gc->in_effects->effect[gc->effect_idx].duration;
+        } else if (gc->button_animation_running) {
+            next = gc->next_effect_time + gc->frame_interval;
+        }
+
+        /* expired timeout stays set until it is reset by user input */
+        if (gc->user_timeout && gc->user_timeout >= (int64_t)bd_get_scr() &&
+            (next < 0 || gc->user_timeout + 1 < next)) {
+            next = gc->user_timeout + 1;
+        }
+    }
+
+    bd_rwlock_unlock(&gc->mutex);
+
+    if (next < 0) {
+        return 0;
+    }
+
+    *pts = next;
+    return 1;
+}
+
+/* navigation commands of selected button may tell what is played next */
+static void _selected_button_hint(GRAPHICS_CONTROLLER *gc, GC_NAV_CMDS *cmds)
+{
+    unsigned      page_id   = bd_psr_read(gc->regs, PSR_MENU_PAGE_ID);
+    unsigned      button_id = bd_psr_read(gc->regs, PSR_SELECTED_BUTTON_ID);
+    BD_IG_PAGE   *page;
+    BD_IG_BUTTON *button = NULL;
+
+    gc->hint_pending = 0;
+
+    page = _find_page(&gc->igs->ics->interactive_composition, page_id);
+    if (page) {
+        button = _find_button_page(page, button_id, NULL);
+    }
+    if (button && button->num_nav_cmds && !cmds->num_nav_cmds) {
+        cmds->num_hint_cmds = button->num_nav_cmds;
+        cmds->hint_cmds     = button->nav_cmds;
+    }
+}
+
 int gc_run(GRAPHICS_CONTROLLER *gc, gc_ctrl_e ctrl, uint32_t param, GC_NAV_CMDS *cmds)
 {
     int result = -1;
@@ -1917,6 +3564,8 @@ int gc_run(GRAPHICS_CONTROLLER *gc, gc_ctrl_e ctrl, uint32_t param, GC_NAV_CMDS
         cmds->sound_id_ref = -1;
         cmds->status       = GC_STATUS_NONE;
         cmds->page_uo_mask = bd_empty_uo_mask();
+        cmds->num_hint_cmds = 0;
+        cmds->hint_cmds     = NULL;
     }
 
     if (!gc) {
@@ -1924,14 +3573,14 @@ int gc_run(GRAPHICS_CONTROLLER *gc, gc_ctrl_e ctrl, uint32_t param, GC_NAV_CMDS
         return result;
     }
 
-    bd_mutex_lock(&gc->mutex);
+    _gc_lock(gc);
 
     /* always accept reset */
     switch (ctrl) {
         case GC_CTRL_RESET:
             _gc_reset(gc);
 
-            bd_mutex_unlock(&gc->mutex);
+            _gc_unlock(gc);
             return 0;
         case GC_CTRL_PG_UPDATE:
             if (gc->pgs && gc->pgs->pcs) {
@@ -1940,26 +3589,29 @@ int gc_run(GRAPHICS_CONTROLLER *gc, gc_ctrl_e ctrl, uint32_t param, GC_NAV_CMDS
             if (gc->tgs && gc->tgs->dialog) {
                 result = _render_textst(gc, param, cmds);
             }
-            bd_mutex_unlock(&gc->mutex);
+            _gc_unlock(gc);
             return result;
 
         case GC_CTRL_STYLE_SELECT:
             result = _textst_style_select(gc, param);
-            bd_mutex_unlock(&gc->mutex);
+            _gc_unlock(gc);
             return result;
 
         case GC_CTRL_PG_CHARCODE:
+            bd_mutex_lock(&gc->textst_mutex);
             if (gc->textst_render) {
+                _textst_cache_clear(gc);
                 textst_render_set_char_code(gc->textst_render, param);
                 result = 0;
             }
-            bd_mutex_unlock(&gc->mutex);
+            bd_mutex_unlock(&gc->textst_mutex);
+            _gc_unlock(gc);
             return result;
 
         case GC_CTRL_PG_RESET:
             _reset_pg(gc);
 
-            bd_mutex_unlock(&gc->mutex);
+            _gc_unlock(gc);
             return 0;
 
         default:;
@@ -1968,7 +3620,7 @@ int gc_run(GRAPHICS_CONTROLLER *gc, gc_ctrl_e ctrl, uint32_t param, GC_NAV_CMDS
     /* other operations require complete display set */
     if (!gc->igs || !gc->igs->ics || !gc->igs->complete) {
         GC_TRACE("gc_run(): no interactive composition\n");
-        bd_mutex_unlock(&gc->mutex);
+        _gc_unlock(gc);
         return result;
     }
 
@@ -2037,6 +3689,8 @@ int gc_run(GRAPHICS_CONTROLLER *gc, gc_ctrl_e ctrl, uint32_t param, GC_NAV_CMDS
             break;
     }
 
+    _check_memory_limit(gc);
+
     if (cmds) {
         if (gc->igs->ics->interactive_composition.ui_model == IG_UI_MODEL_POPUP) {
             cmds->status |= GC_STATUS_POPUP;
@@ -2056,9 +3710,13 @@ int gc_run(GRAPHICS_CONTROLLER *gc, gc_ctrl_e ctrl, uint32_t param, GC_NAV_CMDS
         if (gc->ig_open && !gc->out_effects) {
             cmds->page_uo_mask = gc->page_uo_mask;
         }
+
+        if (gc->hint_pending && gc->ig_open) {
+            _selected_button_hint(gc, cmds);
+        }
     }
 
-    bd_mutex_unlock(&gc->mutex);
+    _gc_unlock(gc);
 
     return result;
 }
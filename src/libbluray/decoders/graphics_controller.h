@@ -33,6 +33,8 @@
 
 struct bd_registers_s;
 struct bd_overlay_s;
+struct bd_overlay_list_s;
+struct m2ts_unit_info_s;
 
 /*
  * types
@@ -41,6 +43,7 @@ struct bd_overlay_s;
 typedef struct graphics_controller_s GRAPHICS_CONTROLLER;
 
 typedef void (*gc_overlay_proc_f)(void *, const struct bd_overlay_s * const);
+typedef void (*gc_overlay_list_proc_f)(void *, const struct bd_overlay_list_s * const);
 
 typedef enum {
     /* */
@@ -91,6 +94,10 @@ typedef struct {
 
     BD_UO_MASK page_uo_mask;
 
+    /* navigation commands of newly selected button (not executed, prefetch hint) */
+    int   num_hint_cmds;
+    void *hint_cmds;
+
 } GC_NAV_CMDS;
 
 /*
@@ -102,6 +109,10 @@ BD_PRIVATE GRAPHICS_CONTROLLER *gc_init(struct bd_registers_s *regs,
 
 BD_PRIVATE void                 gc_free(GRAPHICS_CONTROLLER **p);
 
+/* deliver overlay events as one command list per FLUSH, after graphics controller is unlocked.
+ * Replaces overlay callback given to gc_init(). Must be called before any overlays are rendered. */
+BD_PRIVATE void                 gc_set_overlay_list_proc(GRAPHICS_CONTROLLER *p, void *handle, gc_overlay_list_proc_f func);
+
 /**
  *
  *  Decode data from MPEG-TS input stream
@@ -109,15 +120,75 @@ BD_PRIVATE void                 gc_free(GRAPHICS_CONTROLLER **p);
  * @param p  GRAPHICS_CONTROLLER object
  * @param pid  mpeg-ts PID to decode (HDMV IG/PG stream)
  * @param block  mpeg-ts data
+ * @param info  parsed packet headers of each unit (from m2ts_scan_unit()), or NULL
  * @param num_blocks  number of aligned units in data
  * @param stc  current playback time
  * @return <0 on error, 0 when not complete, >0 when complete
  */
 BD_PRIVATE int                  gc_decode_ts(GRAPHICS_CONTROLLER *p,
                                              uint16_t pid,
-                                             uint8_t *block, unsigned num_blocks,
+                                             uint8_t *block,
+                                             const struct m2ts_unit_info_s *info,
+                                             unsigned num_blocks,
                                              int64_t stc);
 
+/**
+ *
+ *  Decode IG and PG streams from one aligned unit of main path
+ *
+ *  Both streams are demuxed in single pass.
+ *
+ * @param p  GRAPHICS_CONTROLLER object
+ * @param ig_pid  mpeg-ts PID of IG stream (0 = none)
+ * @param pg_pid  mpeg-ts PID of PG stream (0 = none)
+ * @param block  aligned unit
+ * @param info  parsed packet headers of the unit (from m2ts_scan_unit()), or NULL
+ * @param stc  current playback time
+ * @return <0 on error, bit mask of GC_DECODE_* flags for completed display sets
+ */
+#define GC_DECODE_IG  0x01
+#define GC_DECODE_PG  0x02
+
+BD_PRIVATE int                  gc_decode_unit(GRAPHICS_CONTROLLER *p,
+                                               uint16_t ig_pid, uint16_t pg_pid,
+                                               uint8_t *block,
+                                               const struct m2ts_unit_info_s *info,
+                                               int64_t stc);
+
+/*
+ * PG decoding thread
+ *
+ * When running, main path PG stream is decoded and rendered in separate thread.
+ * Overlay callback for PG plane is called from that thread.
+ */
+
+BD_PRIVATE int                  gc_start_pg_thread(GRAPHICS_CONTROLLER *p);
+BD_PRIVATE void                 gc_stop_pg_thread(GRAPHICS_CONTROLLER *p);
+
+/*
+ * TextST pre-rendering thread
+ *
+ * When running, next TextST dialogs are rendered ahead of presentation time.
+ */
+
+BD_PRIVATE int                  gc_start_textst_thread(GRAPHICS_CONTROLLER *p);
+BD_PRIVATE void                 gc_stop_textst_thread(GRAPHICS_CONTROLLER *p);
+
+/**
+ *
+ *  Queue one aligned unit of main path for PG decoding thread
+ *
+ * @param p  GRAPHICS_CONTROLLER object
+ * @param pg_pid  mpeg-ts PID of PG stream
+ * @param block  aligned unit (copied)
+ * @param info  parsed packet headers of the unit (from m2ts_scan_unit()), or NULL
+ * @return <0 if PG decoding thread is not running, 0 if unit has no PG packets, 1 if queued
+ */
+BD_PRIVATE int                  gc_decode_pg_async(GRAPHICS_CONTROLLER *p,
+                                                   uint16_t pg_pid,
+                                                   const uint8_t *block,
+                                                   const struct m2ts_unit_info_s *info);
+
 /*
  * run graphics controller
  */
@@ -127,6 +198,64 @@ BD_PRIVATE int                  gc_run(GRAPHICS_CONTROLLER *p,
                                        /* out */ GC_NAV_CMDS *cmds);
 
 
+/*
+ * Next IG effect, animation frame or user timeout (bd_get_scr() clock, 90 kHz).
+ * Returns 0 if no timer is running. Timers are run with GC_CTRL_NOP.
+ */
+
+BD_PRIVATE int                  gc_next_timer(GRAPHICS_CONTROLLER *p, int64_t *pts);
+
+
+/*
+ * Include 8-bit palette index image (BD_OVERLAY.index_img) in DRAW events
+ */
+
+BD_PRIVATE void                 gc_set_overlay_index(GRAPHICS_CONTROLLER *p, int enable);
+
+/*
+ * Include palette-applied ARGB image (BD_OVERLAY.argb_img) in DRAW events.
+ * Button state images of current IG page are expanded when page is rendered.
+ */
+
+BD_PRIVATE void                 gc_set_overlay_argb(GRAPHICS_CONTROLLER *p, int enable);
+
+/*
+ * Decoded object memory
+ */
+
+typedef struct {
+    uint32_t num_objects;
+    uint64_t object_bytes;    /* decoded object images */
+    uint64_t cache_bytes;     /* cropped and palette index images */
+    uint64_t retained_bytes;  /* encoded object segments retained for re-decoding */
+    uint64_t palette_bytes;
+    uint32_t num_evicted;     /* objects evicted to stay in memory limit */
+    uint32_t num_redecoded;   /* evicted objects decoded again */
+    uint64_t textst_bytes;    /* TextST dialogs, styles, fonts and glyph cache */
+} GC_MEMORY_STATS;
+
+BD_PRIVATE void                 gc_get_memory_stats(GRAPHICS_CONTROLLER *p, GC_MEMORY_STATS *stats);
+
+/* number of overlay commands sent to application */
+BD_PRIVATE uint64_t             gc_get_overlay_cmds(GRAPHICS_CONTROLLER *p);
+
+/* limit memory used by decoded IG objects (0 = unlimited). Objects not used in current page are evicted. */
+BD_PRIVATE void                 gc_set_memory_limit(GRAPHICS_CONTROLLER *p, uint64_t bytes);
+
+/* decode IG object segments of display set in parallel (0 = decode in calling thread) */
+BD_PRIVATE void                 gc_set_ig_decode_threads(GRAPHICS_CONTROLLER *p, unsigned num_threads);
+
+/*
+ * Enumerate button navigation commands of loaded IG menu (all pages).
+ * Callback is called with graphics controller locked: it must not call gc_*() functions.
+ */
+
+struct mobj_cmd;
+
+BD_PRIVATE void                 gc_scan_nav_cmds(GRAPHICS_CONTROLLER *p,
+                                                 void (*cb)(void *handle, const struct mobj_cmd *cmds, unsigned num_cmds),
+                                                 void *handle);
+
 /*
  * Add TextST font
  */
@@ -24,10 +24,13 @@
 #include "textst_decode.h"
 #include "pes_buffer.h"
 #include "m2ts_demux.h"
+#include "m2ts_scan.h"
 
 #include "util/macro.h"
 #include "util/logging.h"
 #include "util/bits.h"
+#include "util/mutex.h"
+#include "util/thread.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -52,6 +55,15 @@ typedef enum {
     TGS_DIALOG_PRESENTATION = 0x82,
 } pgs_segment_type_e;
 
+/* queued object segment (see _queue_ods()) */
+struct gp_ods_job_s {
+    PES_BUFFER *pes;
+    unsigned    idx;     /* index in s->object */
+    uint16_t    id;
+    uint8_t     is_new;  /* object slot was added when segment was queued */
+    uint8_t     ok;
+};
+
 /*
  * PG_DISPLAY_SET
  */
@@ -83,6 +95,12 @@ void pg_display_set_free(PG_DISPLAY_SET **s)
         X_FREE((*s)->window);
         X_FREE((*s)->object);
         X_FREE((*s)->palette);
+        X_FREE((*s)->object_index);
+
+        for (ii = 0; ii < (*s)->num_pending_ods; ii++) {
+            pes_buffer_free(&(*s)->pending_ods[ii].pes);
+        }
+        X_FREE((*s)->pending_ods);
 
         _free_dialogs(*s);
 
@@ -104,26 +122,36 @@ static PES_BUFFER *_find_segment_by_idv(PES_BUFFER *p,
     return p;
 }
 
-static void _join_fragments(PES_BUFFER *p1, PES_BUFFER *p2, int data_pos)
+static unsigned _fragment_data_len(const PES_BUFFER *p, unsigned data_pos)
 {
-    unsigned new_len = p1->len + p2->len - data_pos;
+    return p->len > data_pos ? p->len - data_pos : 0;
+}
 
-    if (p1->size < new_len) {
-        uint8_t *tmp;
-        p1->size = new_len + 1;
-        tmp = realloc(p1->buf, p1->size);
-        if (!tmp) {
+/* append payload of num_fragments next fragments to p1. Size of joined segment is total_len. */
+static void _join_fragments(PES_BUFFER *p1, unsigned num_fragments, unsigned total_len,
+                            unsigned id_pos, unsigned id_len, unsigned data_pos)
+{
+    PES_BUFFER *next;
+
+    /* allocate once for complete segment */
+    if (p1->size < total_len) {
+        if (!pes_buffer_reserve(p1, total_len + 1)) {
             BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
-            p1->size = 0;
             p1->len = 0;
-            return;
         }
-        p1->buf = tmp;
     }
 
-    memcpy(p1->buf + p1->len, p2->buf + data_pos, p2->len - data_pos);
-    p1->len = new_len;
-    p2->len = 0;
+    while (num_fragments-- > 0 &&
+           NULL != (next = _find_segment_by_idv(p1->next, p1->buf[0], id_pos, p1->buf + id_pos, id_len))) {
+
+        if (p1->len) {
+            unsigned len = _fragment_data_len(next, data_pos);
+            memcpy(p1->buf + p1->len, next->buf + data_pos, len);
+            p1->len += len;
+        }
+
+        pes_buffer_remove(&p1, next);
+    }
 }
 
 /* return 1 if segment is ready for decoding, 0 if more data is needed */
@@ -167,27 +195,121 @@ static int _join_segment_fragments(struct pes_buffer_s *p)
         return 1;
     }
 
-    /* find next fragment(s) */
+    /* find next fragment(s) and size of complete segment */
 
-    PES_BUFFER *next;
-    while (NULL != (next = _find_segment_by_idv(p->next, p->buf[0], id_pos, p->buf + id_pos, id_len))) {
+    PES_BUFFER *next      = p;
+    unsigned    total_len = p->len;
+    unsigned    num_fragments = 0;
+    int         complete  = 0;
+
+    while (NULL != (next = _find_segment_by_idv(next->next, p->buf[0], id_pos, p->buf + id_pos, id_len))) {
+
+        total_len += _fragment_data_len(next, data_pos);
+        num_fragments++;
 
         bb_init(&bb, next->buf + sd_pos, 3);
         pg_decode_sequence_descriptor(&bb, &sd);
 
-        _join_fragments(p, next, data_pos);
+        if (sd.last_in_seq) {
+            complete = 1;
+            break;
+        }
+    }
 
-        pes_buffer_remove(&p, next);
+    if (!complete) {
+        /* do not delay decoding if there are other segments queued (missing fragment ?) */
+        unsigned num_queued = 0;
+        for (next = p->next; next; next = next->next) {
+            num_queued++;
+        }
+        if (num_queued <= num_fragments) {
+            /* wait for next fragment */
+            return 0;
+        }
+    }
 
-        if (sd.last_in_seq) {
-            /* set first + last in sequence descriptor */
-            p->buf[sd_pos] = 0xff;
-            return 1;
+    _join_fragments(p, num_fragments, total_len, id_pos, id_len, data_pos);
+
+    if (complete && p->len) {
+        /* set first + last in sequence descriptor */
+        p->buf[sd_pos] = 0xff;
+    }
+
+    return 1;
+}
+
+/*
+ * lookup tables
+ */
+
+static int _set_object_index(PG_DISPLAY_SET *s, uint16_t id, unsigned idx)
+{
+    if (id >= s->object_index_size) {
+        unsigned  size = (id + 256) & ~255u;
+        uint16_t *tmp  = realloc(s->object_index, size * sizeof(*tmp));
+        if (!tmp) {
+            BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
+            return 0;
         }
+        memset(tmp + s->object_index_size, 0, (size - s->object_index_size) * sizeof(*tmp));
+        s->object_index      = tmp;
+        s->object_index_size = size;
     }
 
-    /* do not delay decoding if there are other segments queued (missing fragment ?) */
-    return !!p->next;
+    s->object_index[id] = idx + 1;
+    return 1;
+}
+
+static void _clear_index(PG_DISPLAY_SET *s)
+{
+    memset(s->palette_index, 0, sizeof(s->palette_index));
+    if (s->object_index) {
+        memset(s->object_index, 0, s->object_index_size * sizeof(*s->object_index));
+    }
+}
+
+static void _index_interactive(BD_IG_INTERACTIVE_COMPOSITION *c)
+{
+    unsigned ii, jj, kk;
+
+    memset(c->page_index, 0, sizeof(c->page_index));
+
+    for (ii = 0; ii < c->num_pages; ii++) {
+        BD_IG_PAGE *page = &c->page[ii];
+        unsigned    max_id = 0;
+
+        if (!c->page_index[page->id]) {
+            c->page_index[page->id] = ii + 1;
+        }
+
+        for (jj = 0; jj < page->num_bogs; jj++) {
+            for (kk = 0; kk < page->bog[jj].num_buttons; kk++) {
+                max_id = BD_MAX(max_id, page->bog[jj].button[kk].id);
+            }
+        }
+
+        X_FREE(page->button_index);
+        page->button_index_size = 0;
+        if (!page->num_bogs) {
+            continue;
+        }
+
+        page->button_index = calloc(max_id + 1, sizeof(*page->button_index));
+        if (!page->button_index) {
+            BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
+            continue;
+        }
+        page->button_index_size = max_id + 1;
+
+        for (jj = 0; jj < page->num_bogs; jj++) {
+            for (kk = 0; kk < page->bog[jj].num_buttons; kk++) {
+                uint16_t id = page->bog[jj].button[kk].id;
+                if (!page->button_index[id]) {
+                    page->button_index[id] = ((jj << 16) | kk) + 1;
+                }
+            }
+        }
+    }
 }
 
 /*
@@ -202,7 +324,7 @@ static int _decode_wds(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
     (void)p;
 
     if (!s->decoding) {
-        BD_DEBUG(DBG_DECODE, "skipping orphan window definition segment\n");
+        BD_DEBUG_HOT(DBG_DECODE, "skipping orphan window definition segment\n");
         return 0;
     }
 
@@ -223,7 +345,7 @@ static int _decode_wds(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
 static int _decode_ods(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
 {
     if (!s->decoding) {
-        BD_DEBUG(DBG_DECODE, "skipping orphan object definition segment\n");
+        BD_DEBUG_HOT(DBG_DECODE, "skipping orphan object definition segment\n");
         return 0;
     }
 
@@ -232,17 +354,17 @@ static int _decode_ods(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
     if (s->object) {
         BITBUFFER bb_tmp = *bb;
         uint16_t  id     = bb_read(&bb_tmp, 16);
-        unsigned  ii;
 
-        for (ii = 0; ii < s->num_object; ii++) {
-            if (s->object[ii].id == id) {
-                if (pg_decode_object(bb, &s->object[ii])) {
-                    s->object[ii].pts = p->pts;
-                    return 1;
-                }
-                pg_clean_object(&s->object[ii]);
-                return 0;
+        if (id < s->object_index_size && s->object_index[id]) {
+            unsigned ii = s->object_index[id] - 1;
+
+            if (pg_decode_object(bb, &s->object[ii])) {
+                s->object[ii].pts = p->pts;
+                pg_retain_object_data(&s->object[ii], s->retain_objects ? p->buf : NULL, p->len);
+                return 1;
             }
+            pg_clean_object(&s->object[ii]);
+            return 0;
         }
     }
 
@@ -256,8 +378,12 @@ static int _decode_ods(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
     s->object = tmp;
     memset(&s->object[s->num_object], 0, sizeof(s->object[0]));
 
-    if (pg_decode_object(bb, &s->object[s->num_object])) {
+    if (pg_decode_object(bb, &s->object[s->num_object]) &&
+        _set_object_index(s, s->object[s->num_object].id, s->num_object)) {
         s->object[s->num_object].pts = p->pts;
+        if (s->retain_objects) {
+            pg_retain_object_data(&s->object[s->num_object], p->buf, p->len);
+        }
         s->num_object++;
         return 1;
     }
@@ -267,10 +393,298 @@ static int _decode_ods(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
     return 0;
 }
 
+/*
+ * parallel object decoding
+ *
+ * Object segments are queued and decoded in worker threads and the calling
+ * thread when next non-object segment (usually END_OF_DISPLAY) is seen.
+ * Object slots are assigned in stream order when segments are queued,
+ * so object order and lookup match serial decoding.
+ * PES buffers are released in calling thread (buffer pool is not thread-safe).
+ */
+
+#define GP_MAX_THREADS  8
+
+typedef struct {
+    BD_MUTEX   mutex;
+    BD_COND    work_cond;
+    BD_COND    done_cond;
+
+    unsigned   num_threads; /* configured number of decoding threads */
+    unsigned   num_workers; /* running worker threads */
+    BD_THREAD  workers[GP_MAX_THREADS];
+    int        exit;
+
+    /* current job */
+    PG_DISPLAY_SET *s;
+    unsigned   num_jobs;
+    unsigned   next_job;   /* first job not yet taken */
+    unsigned   pending;    /* jobs not yet decoded */
+} GP_POOL;
+
+static void _decode_queued_ods(PG_DISPLAY_SET *s, struct gp_ods_job_s *job)
+{
+    BD_PG_OBJECT *obj = &s->object[job->idx];
+    PES_BUFFER   *p   = job->pes;
+    BITBUFFER     bb;
+
+    bb_init(&bb, p->buf, p->len);
+    bb_skip(&bb, 24); /* segment type and length */
+
+    if (pg_decode_object(&bb, obj)) {
+        obj->pts = p->pts;
+        pg_retain_object_data(obj, s->retain_objects ? p->buf : NULL, p->len);
+        job->ok = 1;
+    } else {
+        pg_clean_object(obj);
+        job->ok = 0;
+    }
+}
+
+/* mutex must be locked */
+static void _pool_run_jobs(GP_POOL *p)
+{
+    while (p->next_job < p->num_jobs) {
+        PG_DISPLAY_SET      *s   = p->s;
+        struct gp_ods_job_s *job = &s->pending_ods[p->next_job++];
+
+        bd_mutex_unlock(&p->mutex);
+
+        _decode_queued_ods(s, job);
+
+        bd_mutex_lock(&p->mutex);
+        p->pending--;
+        if (!p->pending) {
+            bd_cond_signal(&p->done_cond);
+        }
+    }
+}
+
+static void *_pool_worker(void *arg)
+{
+    GP_POOL *p = (GP_POOL *)arg;
+
+    bd_mutex_lock(&p->mutex);
+
+    while (!p->exit) {
+        if (p->next_job < p->num_jobs) {
+            _pool_run_jobs(p);
+        } else {
+            bd_cond_wait(&p->work_cond, &p->mutex);
+        }
+    }
+
+    bd_mutex_unlock(&p->mutex);
+
+    return NULL;
+}
+
+static void _pool_init(GP_POOL *p)
+{
+    bd_mutex_init(&p->mutex);
+    bd_cond_init(&p->work_cond);
+    bd_cond_init(&p->done_cond);
+}
+
+static void _pool_stop(GP_POOL *p)
+{
+    unsigned ii;
+
+    if (!p->num_workers) {
+        return;
+    }
+
+    bd_mutex_lock(&p->mutex);
+    p->exit = 1;
+    bd_cond_broadcast(&p->work_cond);
+    bd_mutex_unlock(&p->mutex);
+
+    for (ii = 0; ii < p->num_workers; ii++) {
+        bd_thread_join(&p->workers[ii]);
+    }
+
+    p->num_workers = 0;
+    p->exit        = 0;
+}
+
+static void _pool_start(GP_POOL *p)
+{
+    while (p->num_workers + 1 < p->num_threads) {
+        if (bd_thread_create(&p->workers[p->num_workers], "bd_ig_decode", _pool_worker, p) < 0) {
+            BD_DEBUG(DBG_DECODE | DBG_CRIT, "failed creating object decoding thread\n");
+            break;
+        }
+        p->num_workers++;
+    }
+
+    BD_DEBUG(DBG_DECODE, "object decoding using %u worker threads\n", p->num_workers);
+}
+
+static void _pool_close(GP_POOL *p)
+{
+    _pool_stop(p);
+
+    bd_cond_destroy(&p->done_cond);
+    bd_cond_destroy(&p->work_cond);
+    bd_mutex_destroy(&p->mutex);
+}
+
+static int _is_object_segment(const PES_BUFFER *p)
+{
+    /* segment type, length and object id */
+    return p->len >= 5 && p->buf[0] == PGS_OBJECT;
+}
+
+/* takes ownership of p */
+static int _queue_ods(PG_DISPLAY_SET *s, PES_BUFFER *p)
+{
+    struct gp_ods_job_s *job;
+    unsigned  idx, ii;
+    uint16_t  id;
+    int       is_new;
+
+    if (!s->decoding) {
+        BD_DEBUG_HOT(DBG_DECODE, "skipping orphan object definition segment\n");
+        pes_buffer_free(&p);
+        return 0;
+    }
+
+    id     = (p->buf[3] << 8) | p->buf[4];
+    is_new = !(id < s->object_index_size && s->object_index[id]);
+
+    if (!is_new) {
+        idx = s->object_index[id] - 1;
+
+        /* object updated again in same display set: only last segment is used */
+        for (ii = 0; ii < s->num_pending_ods; ii++) {
+            if (s->pending_ods[ii].idx == idx) {
+                pes_buffer_free(&s->pending_ods[ii].pes);
+                s->pending_ods[ii].pes = p;
+                return 1;
+            }
+        }
+    }
+
+    if (s->num_pending_ods >= s->pending_ods_size) {
+        unsigned size = BD_MAX(32, s->pending_ods_size * 2);
+        job = realloc(s->pending_ods, size * sizeof(*job));
+        if (!job) {
+            goto oom;
+        }
+        s->pending_ods      = job;
+        s->pending_ods_size = size;
+    }
+
+    if (is_new) {
+        /* reserve slot for new object */
+        BD_PG_OBJECT *tmp = realloc(s->object, sizeof(s->object[0]) * (s->num_object + 1));
+        if (!tmp) {
+            goto oom;
+        }
+        s->object = tmp;
+        memset(&s->object[s->num_object], 0, sizeof(s->object[0]));
+        s->object[s->num_object].id = id;
+        if (!_set_object_index(s, id, s->num_object)) {
+            pes_buffer_free(&p);
+            return 0;
+        }
+        idx = s->num_object++;
+    }
+
+    job = &s->pending_ods[s->num_pending_ods++];
+    job->pes    = p;
+    job->idx    = idx;
+    job->id     = id;
+    job->is_new = is_new;
+    job->ok     = 0;
+
+    return 1;
+
+ oom:
+    BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
+    pes_buffer_free(&p);
+    return 0;
+}
+
+/* decode queued object segments */
+static void _flush_ods(GP_POOL *p, PG_DISPLAY_SET *s)
+{
+    unsigned num_jobs = s->num_pending_ods;
+    unsigned ii, jj;
+
+    if (!num_jobs) {
+        return;
+    }
+
+    if (p && num_jobs > 1 && !p->num_workers) {
+        _pool_start(p);
+        if (!p->num_workers) {
+            p->num_threads = 0;
+        }
+    }
+
+    if (p && p->num_workers && num_jobs > 1) {
+        bd_mutex_lock(&p->mutex);
+
+        p->s        = s;
+        p->num_jobs = num_jobs;
+        p->next_job = 0;
+        p->pending  = num_jobs;
+
+        bd_cond_broadcast(&p->work_cond);
+
+        /* take part in decoding */
+        _pool_run_jobs(p);
+
+        while (p->pending) {
+            bd_cond_wait(&p->done_cond, &p->mutex);
+        }
+
+        p->s        = NULL;
+        p->num_jobs = 0;
+        p->next_job = 0;
+
+        bd_mutex_unlock(&p->mutex);
+
+    } else {
+        for (ii = 0; ii < num_jobs; ii++) {
+            _decode_queued_ods(s, &s->pending_ods[ii]);
+        }
+    }
+
+    /* drop slots of new objects that failed to decode.
+     * New slots were appended in the same order as jobs were queued. */
+    jj = s->num_object;
+    for (ii = 0; ii < num_jobs; ii++) {
+        struct gp_ods_job_s *job = &s->pending_ods[ii];
+        if (!job->is_new) {
+            continue;
+        }
+        if (jj > job->idx) {
+            jj = job->idx;
+        }
+        if (!job->ok) {
+            s->object_index[job->id] = 0;
+            continue;
+        }
+        if (jj != job->idx) {
+            s->object[jj] = s->object[job->idx];
+            _set_object_index(s, job->id, jj);
+        }
+        jj++;
+    }
+    s->num_object = jj;
+
+    for (ii = 0; ii < num_jobs; ii++) {
+        pes_buffer_free(&s->pending_ods[ii].pes);
+    }
+    s->num_pending_ods = 0;
+}
+
 static int _decode_pds(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
 {
     if (!s->decoding) {
-        BD_DEBUG(DBG_DECODE, "skipping orphan palette definition segment\n");
+        BD_DEBUG_HOT(DBG_DECODE, "skipping orphan palette definition segment\n");
         return 0;
     }
 
@@ -279,24 +693,23 @@ static int _decode_pds(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
     if (s->palette) {
         BITBUFFER bb_tmp = *bb;
         uint8_t   id     = bb_read(&bb_tmp, 8);
-        unsigned  ii;
-
-        for (ii = 0; ii < s->num_palette; ii++) {
-            if (s->palette[ii].id == id) {
-                int rr;
-                if ( (s->ics && s->ics->composition_descriptor.state == 0) ||
-                     (s->pcs && s->pcs->composition_descriptor.state == 0)) {
-                    /* 8.8.3.1.1 */
-                    rr = pg_decode_palette_update(bb, &s->palette[ii]);
-                } else {
-                    rr = pg_decode_palette(bb, &s->palette[ii]);
-                }
-                if (rr) {
-                    s->palette[ii].pts = p->pts;
-                    return 1;
-                }
-                return 0;
+
+        if (s->palette_index[id]) {
+            unsigned ii = s->palette_index[id] - 1;
+            int      rr;
+
+            if ( (s->ics && s->ics->composition_descriptor.state == 0) ||
+                 (s->pcs && s->pcs->composition_descriptor.state == 0)) {
+                /* 8.8.3.1.1 */
+                rr = pg_decode_palette_update(bb, &s->palette[ii]);
+            } else {
+                rr = pg_decode_palette(bb, &s->palette[ii]);
             }
+            if (rr) {
+                s->palette[ii].pts = p->pts;
+                return 1;
+            }
+            return 0;
         }
     }
 
@@ -312,6 +725,7 @@ static int _decode_pds(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
 
     if (pg_decode_palette(bb, &s->palette[s->num_palette])) {
         s->palette[s->num_palette].pts = p->pts;
+        s->palette_index[s->palette[s->num_palette].id] = s->num_palette + 1;
         s->num_palette++;
         return 1;
     }
@@ -333,6 +747,7 @@ static void _check_epoch_start(PG_DISPLAY_SET *s)
         s->num_palette = 0;
         s->num_window  = 0;
         s->num_object  = 0;
+        _clear_index(s);
 
         s->epoch_start = 1;
 
@@ -389,6 +804,8 @@ static int _decode_ics(PG_DISPLAY_SET *s, BITBUFFER *bb, PES_BUFFER *p)
         return 0;
     }
 
+    _index_interactive(&s->ics->interactive_composition);
+
     s->ics->pts  = p->pts;
     s->valid_pts = p->pts;
 
@@ -436,14 +853,14 @@ static int _decode_dialog_style(PG_DISPLAY_SET *s, BITBUFFER *bb)
         return 0;
     }
 
-    BD_DEBUG(DBG_DECODE, "_decode_dialog_style(): %d dialogs in stream\n", s->total_dialog);
+    BD_DEBUG_HOT(DBG_DECODE, "_decode_dialog_style(): %d dialogs in stream\n", s->total_dialog);
     return 1;
 }
 
 static int _decode_dialog_presentation(PG_DISPLAY_SET *s, BITBUFFER *bb)
 {
     if (!s->style || s->total_dialog < 1) {
-        BD_DEBUG(DBG_DECODE, "_decode_dialog_presentation() failed: style segment not decoded\n");
+        BD_DEBUG_HOT(DBG_DECODE, "_decode_dialog_presentation() failed: style segment not decoded\n");
         return 0;
     }
     if (s->num_dialog >= s->total_dialog) {
@@ -491,7 +908,7 @@ static int _decode_segment(PG_DISPLAY_SET *s, PES_BUFFER *p)
         case PGS_END_OF_DISPLAY:
             if (!s->decoding) {
                 /* avoid duplicate initialization / presenataton */
-                BD_DEBUG(DBG_DECODE, "skipping orphan end of display segment\n");
+                BD_DEBUG_HOT(DBG_DECODE, "skipping orphan end of display segment\n");
                 return 0;
             }
             s->complete = 1;
@@ -516,7 +933,8 @@ static int _decode_segment(PG_DISPLAY_SET *s, PES_BUFFER *p)
  * mpeg-pes interface
  */
 #define MAX_STC_DTS_DIFF (INT64_C(90000 * 30)) /* 30 seconds */
-static int graphics_processor_decode_pes(PG_DISPLAY_SET **s, PES_BUFFER **p, int64_t stc)
+static int graphics_processor_decode_pes(PG_DISPLAY_SET **s, PES_BUFFER **p, int64_t stc, int retain_objects,
+                                         GP_POOL *pool)
 {
     if (!s) {
         return 0;
@@ -530,6 +948,8 @@ static int graphics_processor_decode_pes(PG_DISPLAY_SET **s, PES_BUFFER **p, int
         }
     }
 
+    (*s)->retain_objects = retain_objects;
+
     while (*p) {
 
         /* time to decode next segment ? */
@@ -551,7 +971,7 @@ static int graphics_processor_decode_pes(PG_DISPLAY_SET **s, PES_BUFFER **p, int
         }
 
         if ((*p)->len <= 2) {
-            BD_DEBUG(DBG_DECODE, "segment too short, skipping (%d bytes)\n", (*p)->len);
+            BD_DEBUG_HOT(DBG_DECODE, "segment too short, skipping (%d bytes)\n", (*p)->len);
             pes_buffer_next(p);
             continue;
         }
@@ -561,6 +981,14 @@ static int graphics_processor_decode_pes(PG_DISPLAY_SET **s, PES_BUFFER **p, int
         GP_TRACE("Decoding segment, dts %010"PRId64" pts %010"PRId64" len %d\n",
                  (*p)->dts, (*p)->pts, (*p)->len);
 
+        if (pool && _is_object_segment(*p)) {
+            _queue_ods(*s, pes_buffer_detach(p));
+            continue;
+        }
+
+        /* queued objects are decoded before next segment */
+        _flush_ods(pool, *s);
+
         _decode_segment(*s, *p);
 
         pes_buffer_next(p);
@@ -582,18 +1010,25 @@ struct graphics_processor_s {
     uint16_t    pid;
     M2TS_DEMUX  *demux;
     PES_BUFFER  *queue;
+    uint8_t     retain_objects;
+    GP_POOL     pool;
 };
 
 GRAPHICS_PROCESSOR *graphics_processor_init(void)
 {
     GRAPHICS_PROCESSOR *p = calloc(1, sizeof(*p));
 
+    if (p) {
+        _pool_init(&p->pool);
+    }
+
     return p;
 }
 
 void graphics_processor_free(GRAPHICS_PROCESSOR **p)
 {
     if (p && *p) {
+        _pool_close(&(*p)->pool);
         m2ts_demux_free(&(*p)->demux);
         pes_buffer_free(&(*p)->queue);
 
@@ -601,34 +1036,82 @@ void graphics_processor_free(GRAPHICS_PROCESSOR **p)
     }
 }
 
+void graphics_processor_retain_objects(GRAPHICS_PROCESSOR *p, int retain)
+{
+    if (p) {
+        p->retain_objects = !!retain;
+    }
+}
+
+void graphics_processor_set_threads(GRAPHICS_PROCESSOR *p, unsigned num_threads)
+{
+    if (p) {
+        num_threads = BD_MIN(num_threads, GP_MAX_THREADS + 1);
+        if (num_threads != p->pool.num_threads) {
+            /* workers are (re-)started when next object segments are decoded */
+            _pool_stop(&p->pool);
+            p->pool.num_threads = num_threads;
+        }
+    }
+}
+
+static GP_POOL *_get_pool(GRAPHICS_PROCESSOR *p)
+{
+    return p->pool.num_threads > 1 ? &p->pool : NULL;
+}
+
+static void _set_pid(GRAPHICS_PROCESSOR *p, uint16_t pid)
+{
+    if (pid != p->pid) {
+        m2ts_demux_free(&p->demux);
+        pes_buffer_free(&p->queue);
+        p->pid = pid;
+    }
+}
+
 int graphics_processor_decode_ts(GRAPHICS_PROCESSOR *p,
                                  PG_DISPLAY_SET **s,
-                                 uint16_t pid, uint8_t *unit, unsigned num_units,
+                                 uint16_t pid, uint8_t *unit,
+                                 const M2TS_UNIT_INFO *info, unsigned num_units,
                                  int64_t stc)
 {
     unsigned ii;
     int result = 0;
 
-    if (pid != p->pid) {
-        m2ts_demux_free(&p->demux);
-        pes_buffer_free(&p->queue);
-    }
+    _set_pid(p, pid);
     if (!p->demux) {
         p->demux = m2ts_demux_init(pid);
         if (!p->demux) {
             return 0;
         }
-        p->pid   = pid;
     }
 
     for (ii = 0; ii < num_units; ii++) {
-        pes_buffer_append(&p->queue, m2ts_demux(p->demux, unit));
+        pes_buffer_append(&p->queue, m2ts_demux(p->demux, unit, info ? &info[ii] : NULL));
         unit += 6144;
     }
 
     if (p->queue) {
-        result = graphics_processor_decode_pes(s, &p->queue, stc);
+        result = graphics_processor_decode_pes(s, &p->queue, stc, p->retain_objects, _get_pool(p));
     }
 
     return result;
 }
+
+int graphics_processor_decode_pes_list(GRAPHICS_PROCESSOR *p,
+                                       PG_DISPLAY_SET **s,
+                                       uint16_t pid, PES_BUFFER *pes,
+                                       int64_t stc)
+{
+    /* data comes from external demuxer */
+    _set_pid(p, pid);
+    m2ts_demux_free(&p->demux);
+
+    pes_buffer_append(&p->queue, pes);
+
+    if (p->queue) {
+        return graphics_processor_decode_pes(s, &p->queue, stc, p->retain_objects, _get_pool(p));
+    }
+
+    return 0;
+}
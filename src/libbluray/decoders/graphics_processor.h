@@ -30,6 +30,8 @@
 
 typedef struct graphics_processor_s GRAPHICS_PROCESSOR;
 struct pes_buffer_s;
+struct gp_ods_job_s;
+struct m2ts_unit_info_s;
 
 /*
  * PG_DISPLAY_SET
@@ -51,12 +53,23 @@ typedef struct {
     BD_PG_WINDOW  *window;
     BD_TEXTST_DIALOG_PRESENTATION *dialog;
 
+    /* lookup tables: id -> array index + 1, 0 if not present */
+    uint16_t      palette_index[256];
+    unsigned      object_index_size;
+    uint16_t     *object_index;
+
     /* only one of the following segments can be present */
     BD_IG_INTERACTIVE   *ics;
     BD_PG_COMPOSITION   *pcs;
     BD_TEXTST_DIALOG_STYLE *style;
 
     uint8_t decoding; /* internal flag: PCS/ICS decoded, but no end of presentation seen yet */
+    uint8_t retain_objects; /* internal flag: keep encoded object segments for re-decoding */
+
+    /* internal: object segments queued for parallel decoding (decoded before next non-object segment) */
+    unsigned             num_pending_ods;
+    unsigned             pending_ods_size;
+    struct gp_ods_job_s *pending_ods;
 
 } PG_DISPLAY_SET;
 
@@ -69,6 +82,12 @@ BD_PRIVATE void pg_display_set_free(PG_DISPLAY_SET **s);
 BD_PRIVATE GRAPHICS_PROCESSOR *graphics_processor_init(void);
 BD_PRIVATE void                graphics_processor_free(GRAPHICS_PROCESSOR **p);
 
+/* keep encoded object segments in display set (see pg_evict_object()) */
+BD_PRIVATE void                graphics_processor_retain_objects(GRAPHICS_PROCESSOR *p, int retain);
+
+/* decode object segments of display set in parallel (0 or 1 = decode in calling thread) */
+BD_PRIVATE void                graphics_processor_set_threads(GRAPHICS_PROCESSOR *p, unsigned num_threads);
+
 /**
  *
  *  Decode data from MPEG-TS input stream
@@ -80,6 +99,7 @@ BD_PRIVATE void                graphics_processor_free(GRAPHICS_PROCESSOR **p);
  * @param s  display set
  * @param pid  mpeg-ts PID to decode (HDMV IG/PG stream)
  * @param unit  mpeg-ts data
+ * @param info  parsed packet headers of each unit (from m2ts_scan_unit()), or NULL
  * @param num_units  number of aligned units in data
  * @param stc  current playback time
  * @return 1 if display set was completed, 0 otherwise
@@ -87,7 +107,25 @@ BD_PRIVATE void                graphics_processor_free(GRAPHICS_PROCESSOR **p);
 BD_PRIVATE int
 graphics_processor_decode_ts(GRAPHICS_PROCESSOR *p,
                              PG_DISPLAY_SET **s,
-                             uint16_t pid, uint8_t *unit, unsigned num_units,
+                             uint16_t pid, uint8_t *unit,
+                             const struct m2ts_unit_info_s *info, unsigned num_units,
                              int64_t stc);
 
+/**
+ *
+ *  Decode PES packets demuxed elsewhere
+ *
+ * @param p  GRAPHICS_PROCESSOR object
+ * @param s  display set
+ * @param pid  mpeg-ts PID of the PES packets
+ * @param pes  PES packet list (ownership is transferred)
+ * @param stc  current playback time
+ * @return 1 if display set was completed, 0 otherwise
+ */
+BD_PRIVATE int
+graphics_processor_decode_pes_list(GRAPHICS_PROCESSOR *p,
+                                   PG_DISPLAY_SET **s,
+                                   uint16_t pid, struct pes_buffer_s *pes,
+                                   int64_t stc);
+
 #endif // _GRAPHICS_PROCESSOR_H_
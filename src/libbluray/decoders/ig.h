@@ -112,6 +112,11 @@ typedef struct bd_ig_page_s {
     unsigned      num_bogs;
     BD_IG_BOG    *bog;
 
+    /* button lookup table (graphics processor):
+     * button id -> (bog index << 16 | button index) + 1, 0 if not present */
+    unsigned      button_index_size;
+    uint32_t     *button_index;
+
 } BD_IG_PAGE;
 
 typedef struct bd_ig_interactive_composition_s {
@@ -125,6 +130,9 @@ typedef struct bd_ig_interactive_composition_s {
     unsigned      num_pages;
     BD_IG_PAGE   *page;
 
+    /* page lookup table (graphics processor): page id -> page index + 1, 0 if not present */
+    uint16_t      page_index[256];
+
 } BD_IG_INTERACTIVE_COMPOSITION;
 
 #define IG_UI_MODEL_ALWAYS_ON 0
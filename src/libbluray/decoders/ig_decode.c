@@ -254,6 +254,7 @@ static void _clean_page(BD_IG_PAGE *p)
     }
 
     X_FREE(p->bog);
+    X_FREE(p->button_index);
 }
 
 static uint64_t bb_read_u64(BITBUFFER *bb, int i_count)
@@ -274,7 +275,7 @@ static int _decode_interactive_composition(BITBUFFER *bb, BD_IG_INTERACTIVE_COMP
     uint32_t data_len = bb_read(bb, 24);
     uint32_t buf_len  = bb->p_end - bb->p;
     if (data_len != buf_len) {
-        BD_DEBUG(DBG_DECODE, "ig_decode_interactive(): buffer size mismatch (expected %d, have %d)\n", data_len, buf_len);
+        BD_DEBUG_HOT(DBG_DECODE, "ig_decode_interactive(): buffer size mismatch (expected %d, have %d)\n", data_len, buf_len);
         return 0;
     }
 
@@ -333,15 +334,15 @@ int ig_decode_interactive(BITBUFFER *bb, BD_IG_INTERACTIVE *p)
     pg_decode_sequence_descriptor(bb, &sd);
 
     if (!sd.first_in_seq) {
-        BD_DEBUG(DBG_DECODE, "ig_decode_interactive(): not first in seq\n");
+        BD_DEBUG_HOT(DBG_DECODE, "ig_decode_interactive(): not first in seq\n");
         return 0;
     }
     if (!sd.last_in_seq) {
-        BD_DEBUG(DBG_DECODE, "ig_decode_interactive(): not last in seq\n");
+        BD_DEBUG_HOT(DBG_DECODE, "ig_decode_interactive(): not last in seq\n");
         return 0;
     }
     if (!bb_is_align(bb, 0x07)) {
-        BD_DEBUG(DBG_DECODE, "ig_decode_interactive(): alignment error\n");
+        BD_DEBUG_HOT(DBG_DECODE, "ig_decode_interactive(): alignment error\n");
         return 0;
     }
 
@@ -18,6 +18,7 @@
  */
 
 #include "m2ts_demux.h"
+#include "m2ts_scan.h"
 #include "pes_buffer.h"
 
 #include "util/logging.h"
@@ -33,11 +34,18 @@
  *
  */
 
-struct m2ts_demux_s
-{
+typedef struct {
     uint16_t    pid;
     uint32_t    pes_length;
     PES_BUFFER *buf;
+} M2TS_PES_ASSEMBLER;
+
+struct m2ts_demux_s
+{
+    unsigned           num_pids;
+    M2TS_PES_ASSEMBLER pes[M2TS_DEMUX_MAX_PIDS];
+
+    PES_BUFFER_POOL   *pool;
 };
 
 M2TS_DEMUX *m2ts_demux_init(uint16_t pid)
@@ -45,16 +53,36 @@ M2TS_DEMUX *m2ts_demux_init(uint16_t pid)
     M2TS_DEMUX *p = calloc(1, sizeof(*p));
 
     if (p) {
-        p->pid = pid;
+        p->pes[0].pid = pid;
+        p->num_pids   = 1;
+        p->pool       = pes_buffer_pool_init();
     }
 
     return p;
 }
 
+int m2ts_demux_add_pid(M2TS_DEMUX *p, uint16_t pid)
+{
+    if (p->num_pids >= M2TS_DEMUX_MAX_PIDS) {
+        BD_DEBUG(DBG_DECODE | DBG_CRIT, "m2ts_demux_add_pid(): too many pids\n");
+        return -1;
+    }
+
+    memset(&p->pes[p->num_pids], 0, sizeof(p->pes[0]));
+    p->pes[p->num_pids].pid = pid;
+
+    return p->num_pids++;
+}
+
 void m2ts_demux_free(M2TS_DEMUX **p)
 {
     if (p && *p) {
-        pes_buffer_free(&(*p)->buf);
+        unsigned ii;
+        for (ii = 0; ii < (*p)->num_pids; ii++) {
+            pes_buffer_free(&(*p)->pes[ii].buf);
+        }
+        /* buffers already returned keep the pool alive until they are freed */
+        pes_buffer_pool_free(&(*p)->pool);
         X_FREE(*p);
     }
 }
@@ -86,11 +114,11 @@ static int _add_ts(PES_BUFFER *p, unsigned pusi, uint8_t *buf, unsigned len)
     if (pusi) {
 
         if (len < 6) {
-            BD_DEBUG(DBG_DECODE, "invalid BDAV TS (PES header not in single TS packet)\n");
+            BD_DEBUG_HOT(DBG_DECODE, "invalid BDAV TS (PES header not in single TS packet)\n");
             return -1;
         }
         if (buf[0] || buf[1] || buf[2] != 1) {
-            BD_DEBUG(DBG_DECODE, "invalid PES header (00 00 01)");
+            BD_DEBUG_HOT(DBG_DECODE, "invalid PES header (00 00 01)");
             return -1;
         }
 
@@ -102,7 +130,7 @@ static int _add_ts(PES_BUFFER *p, unsigned pusi, uint8_t *buf, unsigned len)
         if (pes_pid != 0xbf) {
 
             if (len < 9) {
-                BD_DEBUG(DBG_DECODE, "invalid BDAV TS (PES header not in single TS packet)\n");
+                BD_DEBUG_HOT(DBG_DECODE, "invalid BDAV TS (PES header not in single TS packet)\n");
                 return -1;
             }
 
@@ -111,15 +139,17 @@ static int _add_ts(PES_BUFFER *p, unsigned pusi, uint8_t *buf, unsigned len)
             hdr_len += buf[8] + 3;
 
             if (len < hdr_len) {
-                BD_DEBUG(DBG_DECODE, "invalid BDAV TS (PES header not in single TS packet)\n");
+                BD_DEBUG_HOT(DBG_DECODE, "invalid BDAV TS (PES header not in single TS packet)\n");
                 return -1;
             }
 
             if (pts_exists) {
                 p->pts = _parse_timestamp(buf + 9);
+                p->ts_flags |= PES_HAS_PTS;
             }
             if (dts_exists) {
                 p->dts = _parse_timestamp(buf + 14);
+                p->ts_flags |= PES_HAS_DTS;
             }
         }
 
@@ -127,20 +157,21 @@ static int _add_ts(PES_BUFFER *p, unsigned pusi, uint8_t *buf, unsigned len)
         len -= hdr_len;
 
         result = pes_length + 6 - hdr_len;
+
+        // PES header tells the final payload size
+        if (!pes_buffer_reserve(p, BD_MAX(result, len))) {
+            BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
+            return -1;
+        }
     }
 
     // realloc
     if (p->size < p->len + len) {
-        uint8_t *tmp;
-        p->size *= 2;
-        p->size = BD_MAX(p->size, BD_MAX(result, 0x100));
-        tmp     = realloc(p->buf, p->size);
-        if (!tmp) {
+        unsigned size = BD_MAX(p->size * 2, BD_MAX(result, 0x100));
+        if (!pes_buffer_reserve(p, BD_MAX(size, p->len + len))) {
             BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
-            p->size = 0;
             return -1;
         }
-        p->buf = tmp;
     }
 
     // append
@@ -150,77 +181,120 @@ static int _add_ts(PES_BUFFER *p, unsigned pusi, uint8_t *buf, unsigned len)
     return result;
 }
 
-PES_BUFFER *m2ts_demux(M2TS_DEMUX *p, uint8_t *buf)
+static int _find_pid(const M2TS_DEMUX *p, uint16_t pid)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < p->num_pids; ii++) {
+        if (p->pes[ii].pid == pid) {
+            return ii;
+        }
+    }
+    return -1;
+}
+
+int m2ts_demux_multi(M2TS_DEMUX *p, uint8_t *buf, const M2TS_UNIT_INFO *info, PES_BUFFER **result)
 {
-    uint8_t   *end = buf + 6144;
-    PES_BUFFER *result = NULL;
+    M2TS_UNIT_INFO local_info;
+    unsigned       ii;
+
+    for (ii = 0; ii < p->num_pids; ii++) {
+        result[ii] = NULL;
+    }
 
     if (!buf) {
         // flush
-        result = p->buf;
-        p->buf = NULL;
-        return result;
+        for (ii = 0; ii < p->num_pids; ii++) {
+            result[ii]     = p->pes[ii].buf;
+            p->pes[ii].buf = NULL;
+        }
+        return 0;
     }
 
-    for (; buf < end; buf += 192) {
+    if (!info) {
+        m2ts_scan_unit(buf, &local_info);
+        info = &local_info;
+    }
 
-        unsigned tp_error       = buf[4+1] & 0x80;
-        unsigned pusi           = buf[4+1] & 0x40;
-        uint16_t pid            = ((buf[4+1] & 0x1f) << 8) | buf[4+2];
-        unsigned payload_exists = buf[4+3] & 0x10;
-        int      payload_offset = (buf[4+3] & 0x20) ? buf[4+4] + 5 : 4;
+    for (ii = 0; ii < info->num_packets; ii++, buf += 192) {
 
-        if (buf[4] != 0x47) {
-            BD_DEBUG(DBG_DECODE, "missing sync byte. scrambled data ?\n");
-            return NULL;
-        }
-        if (pid != p->pid) {
-            M2TS_TRACE("skipping packet (pid %d)\n", pid);
-            continue;
-        }
-        if (tp_error) {
-            BD_DEBUG(DBG_DECODE, "skipping packet (transport error)\n");
+        unsigned flags          = info->flags[ii];
+        unsigned pusi           = flags & M2TS_FLAG_PUSI;
+        int      payload_offset = info->payload_offset[ii];
+        int      idx            = _find_pid(p, info->pid[ii]);
+        M2TS_PES_ASSEMBLER *pes;
+
+        if (idx < 0) {
+            M2TS_TRACE("skipping packet (pid %d)\n", info->pid[ii]);
             continue;
         }
-        if (!payload_exists) {
-            M2TS_TRACE("skipping packet (no payload)\n");
+        if (flags & M2TS_FLAG_ERROR) {
+            BD_DEBUG_HOT(DBG_DECODE, "skipping packet (transport error)\n");
             continue;
         }
-        if (payload_offset >= 188) {
-            BD_DEBUG(DBG_DECODE, "skipping packet (invalid payload start address)\n");
+        if (!(flags & M2TS_FLAG_PAYLOAD)) {
+            if (payload_offset >= 188) {
+                BD_DEBUG_HOT(DBG_DECODE, "skipping packet (invalid payload start address)\n");
+            } else {
+                M2TS_TRACE("skipping packet (no payload)\n");
+            }
             continue;
         }
 
+        pes = &p->pes[idx];
+
         if (pusi) {
-            if (p->buf) {
-                BD_DEBUG(DBG_DECODE, "PES length mismatch: have %d, expected %d\n",
-                      p->buf->len, p->pes_length);
-                pes_buffer_free(&p->buf);
+            if (pes->buf) {
+                BD_DEBUG_HOT(DBG_DECODE, "PES length mismatch: have %d, expected %d\n",
+                      pes->buf->len, pes->pes_length);
+                pes_buffer_free(&pes->buf);
             }
-            p->buf = pes_buffer_alloc();
+            pes->buf = pes_buffer_pool_alloc(p->pool);
         }
 
-        if (!p->buf) {
-            BD_DEBUG(DBG_DECODE, "skipping packet (no pusi seen)\n");
+        if (!pes->buf) {
+            BD_DEBUG_HOT(DBG_DECODE, "skipping packet (no pusi seen)\n");
             continue;
         }
 
-        int r = _add_ts(p->buf, pusi, buf + 4 + payload_offset, 188 - payload_offset);
+        int r = _add_ts(pes->buf, pusi, buf + 4 + payload_offset, 188 - payload_offset);
         if (r) {
             if (r < 0) {
-                BD_DEBUG(DBG_DECODE, "skipping block (PES header error)\n");
-                pes_buffer_free(&p->buf);
+                BD_DEBUG_HOT(DBG_DECODE, "skipping block (PES header error)\n");
+                pes_buffer_free(&pes->buf);
                 continue;
             }
-            p->pes_length = r;
+            pes->pes_length = r;
         }
 
-        if (p->buf->len == p->pes_length) {
-            M2TS_TRACE("PES complete (%d bytes)\n", p->pes_length);
-            pes_buffer_append(&result, p->buf);
-            p->buf = NULL;
+        if (pes->buf->len == pes->pes_length) {
+            M2TS_TRACE("PES complete (%d bytes)\n", pes->pes_length);
+            pes_buffer_append(&result[idx], pes->buf);
+            pes->buf = NULL;
         }
     }
 
-    return result;
+    if (info->num_packets < M2TS_UNIT_PACKETS) {
+        BD_DEBUG_HOT(DBG_DECODE, "missing sync byte. scrambled data ?\n");
+        for (ii = 0; ii < p->num_pids; ii++) {
+            pes_buffer_free(&result[ii]);
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+PES_BUFFER *m2ts_demux(M2TS_DEMUX *p, uint8_t *buf, const M2TS_UNIT_INFO *info)
+{
+    PES_BUFFER *result[M2TS_DEMUX_MAX_PIDS];
+    unsigned    ii;
+
+    m2ts_demux_multi(p, buf, info, result);
+
+    for (ii = 1; ii < p->num_pids; ii++) {
+        pes_buffer_append(&result[0], result[ii]);
+    }
+
+    return result[0];
 }
@@ -25,22 +25,39 @@
 #include <stdint.h>
 
 /*
- * simple single-pid demuxer for BDAV m2ts.
+ * simple demuxer for BDAV m2ts.
+ * Demuxer starts with single pid. More pids can be added, all pids are
+ * demuxed in single pass over the aligned unit.
  */
 
 struct pes_buffer_s;
+struct m2ts_unit_info_s;
 typedef struct m2ts_demux_s M2TS_DEMUX;
 
+#define M2TS_DEMUX_MAX_PIDS  8
+
 BD_PRIVATE M2TS_DEMUX *m2ts_demux_init(uint16_t pid);
 BD_PRIVATE void        m2ts_demux_free(M2TS_DEMUX **);
 
+/* add pid to demuxer. Returns index of pid in m2ts_demux_multi() output, -1 on error. */
+BD_PRIVATE int         m2ts_demux_add_pid(M2TS_DEMUX *, uint16_t pid);
+
 /*
  *   Demux aligned unit (mpeg-ts + pes).
  *   input:  aligned unit (6144 bytes). NULL to flush demuxer buffer.
+ *           parsed packet headers of the unit (from m2ts_scan_unit()), or NULL.
  *   output: PES payload
  *   Flush demuxer internal cache if block == NULL.
  */
-BD_PRIVATE struct pes_buffer_s *m2ts_demux(M2TS_DEMUX *, uint8_t *block);
+BD_PRIVATE struct pes_buffer_s *m2ts_demux(M2TS_DEMUX *, uint8_t *block, const struct m2ts_unit_info_s *info);
+
+/*
+ *   Demux aligned unit to separate PES payload lists.
+ *   output: result[i] is PES payload of i'th pid (in the order pids were added).
+ *   Returns -1 if unit is corrupted.
+ */
+BD_PRIVATE int m2ts_demux_multi(M2TS_DEMUX *, uint8_t *block, const struct m2ts_unit_info_s *info,
+                                struct pes_buffer_s **result);
 
 
 #endif // _M2TS_DEMUX_H_
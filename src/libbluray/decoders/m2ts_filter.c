@@ -24,6 +24,7 @@
 #include "m2ts_filter.h"
 
 #include "hdmv_pids.h"
+#include "m2ts_scan.h"
 
 #include "util/logging.h"
 #include "util/macro.h"
@@ -36,7 +37,7 @@
 #include <stdio.h>
 #endif
 
-#define M2TS_TRACE(...) BD_DEBUG(DBG_STREAM,__VA_ARGS__)
+#define M2TS_TRACE(...) BD_DEBUG_HOT(DBG_STREAM,__VA_ARGS__)
 //#define M2TS_TRACE(...) do {} while(0)
 
 /*
@@ -52,6 +53,8 @@ struct m2ts_filter_s
     int64_t  out_pts;
     uint32_t pat_packets; /* how many packets to search for PAT (seeked pat_packets packets before the actual seek point) */
     uint8_t  pat_seen;
+
+    uint64_t out_pos;     /* units before this clip position can't reach out_pts */
 };
 
 M2TS_FILTER *m2ts_filter_init(int64_t in_pts, int64_t out_pts,
@@ -160,12 +163,12 @@ static int64_t _parse_timestamp(const uint8_t *p)
 static int64_t _es_timestamp(const uint8_t *buf, unsigned len)
 {
     if (buf[0] || buf[1] || buf[2] != 1) {
-        BD_DEBUG(DBG_DECODE, "invalid BDAV TS\n");
+        BD_DEBUG_HOT(DBG_DECODE, "invalid BDAV TS\n");
         return -1;
     }
 
     if (len < 9) {
-        BD_DEBUG(DBG_DECODE, "invalid BDAV TS (no payload ?)\n");
+        BD_DEBUG_HOT(DBG_DECODE, "invalid BDAV TS (no payload ?)\n");
         return -1;
     }
 
@@ -201,19 +204,22 @@ void m2ts_filter_seek(M2TS_FILTER *p, uint32_t pat_packets, int64_t in_pts)
     p->pat_packets = pat_packets;
 }
 
-static int _filter_es_pts(M2TS_FILTER *p, const uint8_t *buf, uint16_t pid)
+void m2ts_filter_set_out_pos(M2TS_FILTER *p, uint64_t out_pos)
 {
-    unsigned tp_error       = buf[4+1] & 0x80;
-    unsigned payload_exists = buf[4+3] & 0x10;
-    int      payload_offset = (buf[4+3] & 0x20) ? buf[4+4] + 5 : 4;
+    p->out_pos = out_pos;
+}
 
-    if (buf[4] != 0x47) {
-        BD_DEBUG(DBG_DECODE | DBG_CRIT, "missing sync byte. scrambled data ? Filtering aborted.\n");
-        return -1;
-    }
-    if (tp_error || !payload_exists || payload_offset >= 188) {
+int m2ts_filter_idle(const M2TS_FILTER *p, uint64_t pos)
+{
+    /* wipe list is empty after all streams have passed in_pts, and refilled on seek */
+    return !p->wipe_pid[0] && !p->pat_packets && pos + 6144 <= p->out_pos;
+}
+
+static void _filter_es_pts(M2TS_FILTER *p, const uint8_t *buf, uint16_t pid, unsigned flags, unsigned payload_offset)
+{
+    if ((flags & M2TS_FLAG_ERROR) || !(flags & M2TS_FLAG_PAYLOAD)) {
         M2TS_TRACE("skipping packet (no payload)\n");
-        return 0;
+        return;
     }
 
     if (_pid_in_list(p->wipe_pid, pid)) {
@@ -253,8 +259,6 @@ static int _filter_es_pts(M2TS_FILTER *p, const uint8_t *buf, uint16_t pid)
             }
         }
     }
-
-    return 0;
 }
 
 static void _wipe_packet(uint8_t *p)
@@ -264,14 +268,21 @@ static void _wipe_packet(uint8_t *p)
     p[4 + 1] |= 0x1f;
 }
 
-int m2ts_filter(M2TS_FILTER *p, uint8_t *buf)
+int m2ts_filter(M2TS_FILTER *p, uint8_t *buf, M2TS_UNIT_INFO *info)
 {
-    uint8_t *end    = buf + 6144;
-    int      result = 0;
+    M2TS_UNIT_INFO local_info;
+    unsigned       ii;
+    int            result = 0;
+
+    if (!info) {
+        m2ts_scan_unit(buf, &local_info);
+        info = &local_info;
+    }
 
-    for (; buf < end; buf += 192) {
+    for (ii = 0; ii < M2TS_UNIT_PACKETS; ii++, buf += 192) {
 
-        uint16_t pid = ((buf[4+1] & 0x1f) << 8) | buf[4+2];
+        int      synced = ii < info->num_packets;
+        uint16_t pid    = synced ? info->pid[ii] : (((buf[4+1] & 0x1f) << 8) | buf[4+2]);
         if (pid == HDMV_PID_PAT) {
             p->pat_seen = 1;
             p->pat_packets = 0;
@@ -282,6 +293,9 @@ int m2ts_filter(M2TS_FILTER *p, uint8_t *buf)
             if (!p->pat_seen) {
                 M2TS_TRACE("Wiping pid 0x%04x (inside seek buffer, no PAT)\n", pid);
                 _wipe_packet(buf);
+                if (synced) {
+                    info->pid[ii] = 0x1fff;
+                }
                 continue;
             }
             M2TS_TRACE("NOT Wiping pid 0x%04x (inside seek buffer, PAT seen)\n", pid);
@@ -301,16 +315,22 @@ int m2ts_filter(M2TS_FILTER *p, uint8_t *buf)
         }
 #endif
         /* payload start indicator ? check ES timestamp */
-        unsigned pusi = buf[4+1] & 0x40;
+        unsigned pusi = synced ? (info->flags[ii] & M2TS_FLAG_PUSI) : (buf[4+1] & 0x40);
         if (pusi) {
-            if (_filter_es_pts(p, buf, pid) < 0)
+            if (!synced) {
+                BD_DEBUG(DBG_DECODE | DBG_CRIT, "missing sync byte. scrambled data ? Filtering aborted.\n");
                 return -1;
+            }
+            _filter_es_pts(p, buf, pid, info->flags[ii], info->payload_offset[ii]);
         }
 
         if (_pid_in_list(p->wipe_pid, pid)) {
             /* Wipe packet (pid -> padding stream) */
             M2TS_TRACE("Wiping pid 0x%04x\n", pid);
             _wipe_packet(buf);
+            if (synced) {
+                info->pid[ii] = 0x1fff;
+            }
         }
     }
 
@@ -30,6 +30,7 @@
  */
 
 typedef struct m2ts_filter_s M2TS_FILTER;
+struct m2ts_unit_info_s;
 
 BD_PRIVATE M2TS_FILTER *m2ts_filter_init(int64_t in_pts, int64_t out_pts,
                                          unsigned num_video, unsigned num_audio,
@@ -43,8 +44,9 @@ BD_PRIVATE void         m2ts_filter_close(M2TS_FILTER **);
  *
  *   - drop packets before PAT in seek buffer
  *
+ *   Parsed packet headers (info, may be NULL) are updated when packets are dropped.
  */
-BD_PRIVATE int m2ts_filter(M2TS_FILTER *, uint8_t *block);
+BD_PRIVATE int m2ts_filter(M2TS_FILTER *, uint8_t *block, struct m2ts_unit_info_s *info);
 
 /*
  * Notify seek. All streams are discarded until next PUSI.
@@ -52,5 +54,18 @@ BD_PRIVATE int m2ts_filter(M2TS_FILTER *, uint8_t *block);
  */
 BD_PRIVATE void  m2ts_filter_seek(M2TS_FILTER *, uint32_t pat_packets, int64_t in_pts);
 
+/*
+ * Set clip byte position where OUT timestamp checking must start
+ * (estimated from EP map, with margin). Default 0 (check all units).
+ */
+BD_PRIVATE void  m2ts_filter_set_out_pos(M2TS_FILTER *, uint64_t out_pos);
+
+/*
+ * Returns 1 if unit at clip byte position pos can be passed without filtering:
+ * all streams have passed IN timestamp, no seek is pending and unit is
+ * before OUT position.
+ */
+BD_PRIVATE int   m2ts_filter_idle(const M2TS_FILTER *, uint64_t pos);
+
 
 #endif // _M2TS_FILTER_H_
@@ -0,0 +1,77 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "m2ts_scan.h"
+
+int m2ts_scan_unit(const uint8_t *unit, M2TS_UNIT_INFO *info)
+{
+    unsigned ii;
+
+    info->pcr_packet = M2TS_UNIT_PACKETS;
+
+    /* Source packets are 192 bytes apart, so there is nothing to gain from
+     * vector loads here. Keep the loop simple and branch-light instead. */
+
+    for (ii = 0; ii < M2TS_UNIT_PACKETS; ii++) {
+        const uint8_t *ts = unit + 192 * ii + 4;
+        unsigned adapt, offset;
+
+        if (ts[0] != 0x47) {
+            info->num_packets = ii;
+            return -1;
+        }
+
+        adapt  = ts[3] & 0x20;
+        offset = adapt ? ts[4] + 5u : 4u;
+
+        info->pid[ii]            = ((ts[1] & 0x1f) << 8) | ts[2];
+        info->payload_offset[ii] = (uint8_t)(offset < 188 ? offset : 188);
+        info->flags[ii]          = ((ts[1] & 0x40) ? M2TS_FLAG_PUSI  : 0) |
+                                   ((ts[1] & 0x80) ? M2TS_FLAG_ERROR : 0) |
+                                   ((ts[3] & 0x10) && offset < 188 ? M2TS_FLAG_PAYLOAD : 0) |
+                                   (adapt ? M2TS_FLAG_ADAPT : 0);
+
+        /* adaptation field with PCR_flag */
+        if (adapt && ts[4] >= 7 && (ts[5] & 0x10) && info->pcr_packet == M2TS_UNIT_PACKETS) {
+            info->pcr_packet = ii;
+            info->pcr = ((uint64_t)ts[6] << 25) | ((uint64_t)ts[7] << 17) | ((uint64_t)ts[8] << 9) |
+                        ((uint64_t)ts[9] << 1) | (ts[10] >> 7);
+        }
+    }
+
+    info->num_packets = M2TS_UNIT_PACKETS;
+    return 0;
+}
+
+int m2ts_scan_has_pid(const M2TS_UNIT_INFO *info, uint16_t pid)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < info->num_packets; ii++) {
+        if (info->pid[ii] == pid) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+#if !defined(_M2TS_SCAN_H_)
+#define _M2TS_SCAN_H_
+
+#include "util/attributes.h"
+
+#include <stdint.h>
+
+/*
+ * aligned unit packet header scanner.
+ * Headers of all source packets in an aligned unit are parsed once,
+ * and the result is shared by the stream filter and demuxers.
+ */
+
+#define M2TS_UNIT_PACKETS  32  /* source packets in aligned unit */
+
+#define M2TS_FLAG_PUSI     0x01  /* payload unit start indicator */
+#define M2TS_FLAG_ERROR    0x02  /* transport error indicator */
+#define M2TS_FLAG_PAYLOAD  0x04  /* packet has valid payload */
+#define M2TS_FLAG_ADAPT    0x08  /* adaptation field present */
+
+typedef struct m2ts_unit_info_s {
+    unsigned num_packets;                        /* packets before first missing sync byte */
+    uint16_t pid[M2TS_UNIT_PACKETS];
+    uint8_t  flags[M2TS_UNIT_PACKETS];
+    uint8_t  payload_offset[M2TS_UNIT_PACKETS];  /* from start of TS packet */
+
+    unsigned pcr_packet;                         /* first packet with PCR, M2TS_UNIT_PACKETS if none */
+    uint64_t pcr;                                /* PCR base (90 kHz) of pcr_packet */
+} M2TS_UNIT_INFO;
+
+/*
+ * Parse headers of aligned unit (6144 bytes).
+ * Returns 0 if all sync bytes were found, -1 otherwise.
+ */
+BD_PRIVATE int m2ts_scan_unit(const uint8_t *unit, M2TS_UNIT_INFO *info);
+
+/* arrival time stamp (27 MHz, 30 bits) from TP_extra_header of source packet */
+static inline uint32_t m2ts_packet_ats(const uint8_t *sp)
+{
+    return ((uint32_t)(sp[0] & 0x3f) << 24) | ((uint32_t)sp[1] << 16) | ((uint32_t)sp[2] << 8) | sp[3];
+}
+
+/* true if unit has any packets with pid */
+BD_PRIVATE int m2ts_scan_has_pid(const M2TS_UNIT_INFO *info, uint16_t pid);
+
+#endif // _M2TS_SCAN_H_
@@ -22,7 +22,7 @@
 
 #include <stdint.h>
 
-#define BD_OVERLAY_INTERFACE_VERSION 2
+#define BD_OVERLAY_INTERFACE_VERSION 3
 
 typedef enum {
     BD_OVERLAY_PG = 0,  /* Presentation Graphics plane */
@@ -81,6 +81,21 @@ typedef struct bd_overlay_s {
     uint16_t crop_h; /* deprecated: cropping is executed by libbluray */
 
     uint8_t palette_update_flag; /* only palette was changed */
+
+    /* since BD_OVERLAY_INTERFACE_VERSION 3 */
+    uint32_t         palette_serial; /* changes when palette content changes (0 = unknown) */
+    const uint32_t * palette_argb;   /* palette as ARGB lookup table (BT.709 for HD, BT.601 for SD video), or NULL.
+                                        Valid only during overlay callback. */
+    uint32_t         object_serial;  /* unique id of image content (img, index_img, w, h), or 0 if image is not cached.
+                                        Same id means same pixels: application can re-use previously decoded
+                                        or uploaded copy (ex. GPU texture atlas entry) instead of decoding img. */
+    const uint8_t  * index_img;      /* image as 8-bit palette indexes ('h' lines, line length 'w' pixels), or NULL.
+                                        Set only when BLURAY_PLAYER_SETTING_OVERLAY_INDEX is enabled.
+                                        Reference-counted like img. */
+    const uint32_t * argb_img;       /* image with palette applied (palette_argb), 'h' lines, line length 'w' pixels, or NULL.
+                                        Set only when BLURAY_PLAYER_SETTING_OVERLAY_ARGB is enabled.
+                                        Same (object_serial, palette_serial) means same pixels.
+                                        Reference-counted like img. */
 } BD_OVERLAY;
 
 /*
@@ -91,6 +106,49 @@ typedef struct bd_overlay_s {
 void bd_refcnt_inc(const void *);
 void bd_refcnt_dec(const void *);
 
+/*
+  Overlay command lists (since BD_OVERLAY_INTERFACE_VERSION 3)
+
+  Commands of one overlay plane are collected and delivered as a single list
+  ending with FLUSH (or CLOSE) event. Commands are in the same order as they
+  would be passed to overlay callback.
+
+  List is immutable and reference-counted: palettes, ARGB palettes and images
+  (img, index_img, argb_img) of all commands stay valid until the list is released.
+  List is valid during callback; application can keep it with bd_refcnt_inc()
+  and release it later with bd_refcnt_dec().
+*/
+
+typedef struct bd_overlay_list_s {
+    int64_t  pts;      /* pts of FLUSH event, -1 if list ends with CLOSE */
+    uint8_t  plane;    /* bd_overlay_plane_e */
+
+    unsigned           num_cmds;
+    const BD_OVERLAY * cmds;
+} BD_OVERLAY_LIST;
+
+/*
+  RLE decoding helpers.
+
+  Palette is converted to 256-entry lookup table of packed 32-bit pixels
+  (A:8 in bits 24..31). RLE image is expanded to caller-provided buffer
+  of 'h' lines, line length 'stride' pixels.
+*/
+
+/* ARGB lookup table. Colors are converted using BT.709 (bt709 != 0) or BT.601 matrix. */
+void bd_pg_palette_to_argb(const BD_PG_PALETTE_ENTRY *palette, uint32_t *lut, int bt709);
+
+/* AYUV lookup table (A:8 Y:8 Cb:8 Cr:8, no color conversion) */
+void bd_pg_palette_to_ayuv(const BD_PG_PALETTE_ENTRY *palette, uint32_t *lut);
+
+/* expand image to 32-bit pixels. Returns 0 on success, -1 if image is corrupted (buffer is still fully written). */
+int bd_rle_decode32(const BD_PG_RLE_ELEM *img, unsigned w, unsigned h,
+                    const uint32_t *lut, uint32_t *dst, unsigned stride);
+
+/* expand image to 8-bit palette indexes */
+int bd_rle_decode8(const BD_PG_RLE_ELEM *img, unsigned w, unsigned h,
+                   uint8_t *dst, unsigned stride);
+
 #if 0
 BD_OVERLAY *bd_overlay_copy(const BD_OVERLAY *src)
 {
@@ -165,6 +223,8 @@ typedef struct bd_argb_overlay_s {
  *
  * DRAW events can still be used for optimizations.
  */
+#define BD_ARGB_MAX_DIRTY_RECTS 8
+
 typedef struct bd_argb_buffer_s {
     /* optional lock / unlock functions
      *  - Set by application
@@ -199,4 +259,80 @@ typedef struct bd_argb_buffer_s {
 
 } BD_ARGB_BUFFER;
 
+/*
+ * Extended application-allocated frame buffer (since BD_OVERLAY_INTERFACE_VERSION 3)
+ *
+ * Registered with bd_register_argb_overlay_proc2(). Fields after 'base'
+ * are never accessed when the buffer is registered with
+ * bd_register_argb_overlay_proc().
+ */
+
+typedef struct bd_argb_buffer_ext_s {
+    /* lock() / unlock() are called with &base */
+    BD_ARGB_BUFFER base;
+
+    /* optional triple buffering
+     * - Enabled by application: set num_buffers = 3 before bd_register_argb_overlay_proc2().
+     * - Application allocates three full-size buffers bufs[plane][0..2] (base.buf[] is not used).
+     * - Library draws to a back buffer without calling lock() / unlock(), and
+     *   publishes it with atomic page flip before BD_ARGB_OVERLAY_FLUSH.
+     * - Application gets latest complete frame with bd_argb_buffer_acquire().
+     */
+    int       num_buffers;  /* 0 or 1: single buffer (base.buf[]), 3: triple buffering (bufs[]) */
+    uint32_t *bufs[2][3];
+
+    /* private to libbluray */
+    unsigned  flip_state[2]; /* published buffer index, new frame flag */
+    unsigned  front[2];      /* buffer owned by application */
+    unsigned  back[2];       /* buffer owned by library */
+    struct {
+        uint16_t x0, y0, x1, y1;
+    } stale[2][3];           /* area not yet updated to buffer */
+
+    /* dirty rectangles of frame buffers
+     * - Updated by library before lock() call, together with base.dirty[].
+     * - Disjoint areas inside base.dirty[] bounding box. When there are more than
+     *   BD_ARGB_MAX_DIRTY_RECTS separate areas, the list contains only base.dirty[].
+     * - Reset after each BD_ARGB_OVERLAY_FLUSH.
+     */
+    int num_dirty_rects[2];
+    struct {
+        uint16_t x0, y0, x1, y1;
+    } dirty_rects[2][BD_ARGB_MAX_DIRTY_RECTS];
+
+} BD_ARGB_BUFFER_EXT;
+
+/*
+  Get latest complete frame of triple-buffered ARGB overlay plane.
+  Lock-free, can be called from any thread. Returned buffer is not modified
+  by libbluray until next call. Returns NULL if triple buffering is not used.
+*/
+const uint32_t *bd_argb_buffer_acquire(BD_ARGB_BUFFER_EXT *buf, int plane);
+
+/*
+  Overlay compositor (since BD_OVERLAY_INTERFACE_VERSION 3)
+
+  Renders PG (RLE) and IG (RLE or ARGB) overlays and composes them to a
+  single premultiplied ARGB plane (IG over PG).
+
+  Register bd_overlay_compositor_overlay_proc() with bd_register_overlay_proc()
+  and/or bd_overlay_compositor_argb_overlay_proc() with bd_register_argb_overlay_proc(),
+  using the compositor as handle.
+
+  Output is written to out->base.buf[0] (out->base.width x out->base.height pixels).
+  Only changed areas are updated; the areas are listed in out->base.dirty[0] and
+  out->dirty_rects[0] when flush_cb is called. lock() / unlock() are
+  called around updates (with &out->base).
+*/
+
+typedef struct bd_overlay_compositor_s BD_OVERLAY_COMPOSITOR;
+
+BD_OVERLAY_COMPOSITOR *bd_overlay_compositor_init(BD_ARGB_BUFFER_EXT *out,
+                                                  void (*flush_cb)(void *handle, BD_ARGB_BUFFER_EXT *out, int64_t pts),
+                                                  void *handle);
+void bd_overlay_compositor_free(BD_OVERLAY_COMPOSITOR **);
+
+void bd_overlay_compositor_overlay_proc(void *handle, const BD_OVERLAY * const);
+void bd_overlay_compositor_argb_overlay_proc(void *handle, const BD_ARGB_OVERLAY * const);
+
 #endif // BD_OVERLAY_H_
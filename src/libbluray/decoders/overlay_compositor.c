@@ -0,0 +1,586 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "overlay.h"
+
+#include "util/logging.h"
+#include "util/macro.h"
+#include "util/mutex.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_BLEND 1
+#endif
+
+#define COMP_ERROR(...) BD_DEBUG(DBG_GC | DBG_CRIT, __VA_ARGS__)
+#define COMP_TRACE(...) BD_DEBUG(DBG_GC,            __VA_ARGS__)
+
+/*
+ * data
+ */
+
+typedef struct {
+    uint32_t *argb;      /* premultiplied ARGB, w * h */
+    uint16_t  w, h;
+} COMP_PLANE;
+
+struct bd_overlay_compositor_s {
+    BD_MUTEX        mutex;     /* PG and IG events may come from different threads */
+
+    COMP_PLANE      plane[2];  /* [0] - PG plane, [1] - IG plane */
+
+    /* output */
+    BD_ARGB_BUFFER_EXT *out;
+    void              (*flush_cb)(void *, BD_ARGB_BUFFER_EXT *, int64_t);
+    void               *flush_handle;
+
+    /* pending changes */
+    unsigned        num_dirty;
+    struct {
+        uint16_t x0, y0, x1, y1;
+    } dirty[BD_ARGB_MAX_DIRTY_RECTS];
+
+    /* premultiplied palette */
+    uint32_t        lut[256];
+    uint32_t        lut_serial;
+};
+
+/*
+ * pixel helpers
+ */
+
+/* exact round(t / 255) for 0 <= t <= 65535 */
+static inline uint32_t _div255(uint32_t t)
+{
+    t += 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static uint32_t _premultiply(uint32_t c)
+{
+    uint32_t a = c >> 24;
+
+    if (a == 255) {
+        return c;
+    }
+    if (a == 0) {
+        return 0;
+    }
+    return (a << 24) |
+           (_div255(((c >> 16) & 0xff) * a) << 16) |
+           (_div255(((c >>  8) & 0xff) * a) <<  8) |
+            _div255(( c        & 0xff) * a);
+}
+
+static inline uint32_t _over(uint32_t top, uint32_t bottom)
+{
+    uint32_t ia = 255 - (top >> 24);
+
+    if (ia == 0) {
+        return top;
+    }
+    if (ia == 255) {
+        return bottom;
+    }
+    return top + ((_div255(( bottom >> 24        ) * ia) << 24) |
+                  (_div255(((bottom >> 16) & 0xff) * ia) << 16) |
+                  (_div255(((bottom >>  8) & 0xff) * ia) <<  8) |
+                   _div255(( bottom        & 0xff) * ia));
+}
+
+/* dst = top over dst (premultiplied alpha) */
+static void _blend_row(uint32_t *dst, const uint32_t *top, unsigned n)
+{
+    unsigned ii = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i c255 = _mm_set1_epi16(255);
+    const __m128i c257 = _mm_set1_epi16(257);
+
+    for (; ii + 4 <= n; ii += 4) {
+        __m128i t = _mm_loadu_si128((const __m128i *)(top + ii));
+        __m128i b = _mm_loadu_si128((const __m128i *)(dst + ii));
+
+        /* broadcast 255 - alpha of top pixels to all channels */
+        __m128i a    = _mm_srli_epi32(t, 24);
+        a            = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+        __m128i a_lo = _mm_sub_epi16(c255, _mm_shufflelo_epi16(_mm_unpacklo_epi32(a, a), 0xa0));
+        __m128i a_hi = _mm_sub_epi16(c255, _mm_shufflelo_epi16(_mm_unpackhi_epi32(a, a), 0xa0));
+        a_lo = _mm_shufflehi_epi16(a_lo, 0xa0);
+        a_hi = _mm_shufflehi_epi16(a_hi, 0xa0);
+
+        __m128i b_lo = _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), a_lo);
+        __m128i b_hi = _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), a_hi);
+
+        /* exact division by 255: ((x + 128) * 257) >> 16 */
+        b_lo = _mm_mulhi_epu16(_mm_add_epi16(b_lo, c128), c257);
+        b_hi = _mm_mulhi_epu16(_mm_add_epi16(b_hi, c128), c257);
+
+        _mm_storeu_si128((__m128i *)(dst + ii), _mm_add_epi8(t, _mm_packus_epi16(b_lo, b_hi)));
+    }
+#elif defined(HAVE_NEON_BLEND)
+    for (; ii + 4 <= n; ii += 4) {
+        uint8x16_t t = vreinterpretq_u8_u32(vld1q_u32(top + ii));
+        uint8x16_t b = vreinterpretq_u8_u32(vld1q_u32(dst + ii));
+
+        /* broadcast 255 - alpha of top pixels to all channels */
+        uint32x4_t a32 = vshrq_n_u32(vreinterpretq_u32_u8(t), 24);
+        a32 = vmulq_n_u32(a32, 0x01010101);
+        uint8x16_t ia = vmvnq_u8(vreinterpretq_u8_u32(a32));
+
+        uint16x8_t lo = vmull_u8(vget_low_u8(b),  vget_low_u8(ia));
+        uint16x8_t hi = vmull_u8(vget_high_u8(b), vget_high_u8(ia));
+
+        /* exact division by 255: (x + 128 + ((x + 128) >> 8)) >> 8 */
+        lo = vaddq_u16(lo, vdupq_n_u16(128));
+        hi = vaddq_u16(hi, vdupq_n_u16(128));
+        uint8x8_t rlo = vshrn_n_u16(vsraq_n_u16(lo, lo, 8), 8);
+        uint8x8_t rhi = vshrn_n_u16(vsraq_n_u16(hi, hi, 8), 8);
+
+        vst1q_u32(dst + ii, vreinterpretq_u32_u8(vaddq_u8(t, vcombine_u8(rlo, rhi))));
+    }
+#endif
+
+    for (; ii < n; ii++) {
+        dst[ii] = _over(top[ii], dst[ii]);
+    }
+}
+
+/*
+ * dirty area tracking
+ */
+
+static void _add_dirty(BD_OVERLAY_COMPOSITOR *c, int x0, int y0, int x1, int y1)
+{
+    unsigned ii;
+
+    if (x1 < x0 || y1 < y0) {
+        return;
+    }
+
+    /* merge with overlapping rectangle */
+    for (ii = 0; ii < c->num_dirty; ii++) {
+        if (x0 <= c->dirty[ii].x1 + 1 && x1 + 1 >= c->dirty[ii].x0 &&
+            y0 <= c->dirty[ii].y1 + 1 && y1 + 1 >= c->dirty[ii].y0) {
+            x0 = BD_MIN(x0, c->dirty[ii].x0);
+            y0 = BD_MIN(y0, c->dirty[ii].y0);
+            x1 = BD_MAX(x1, c->dirty[ii].x1);
+            y1 = BD_MAX(y1, c->dirty[ii].y1);
+            c->dirty[ii] = c->dirty[--c->num_dirty];
+            _add_dirty(c, x0, y0, x1, y1);
+            return;
+        }
+    }
+
+    if (c->num_dirty >= BD_ARGB_MAX_DIRTY_RECTS) {
+        /* too many rectangles: use bounding box */
+        for (ii = 0; ii < c->num_dirty; ii++) {
+            x0 = BD_MIN(x0, c->dirty[ii].x0);
+            y0 = BD_MIN(y0, c->dirty[ii].y0);
+            x1 = BD_MAX(x1, c->dirty[ii].x1);
+            y1 = BD_MAX(y1, c->dirty[ii].y1);
+        }
+        c->num_dirty = 0;
+    }
+
+    c->dirty[c->num_dirty].x0 = x0;
+    c->dirty[c->num_dirty].y0 = y0;
+    c->dirty[c->num_dirty].x1 = x1;
+    c->dirty[c->num_dirty].y1 = y1;
+    c->num_dirty++;
+}
+
+/*
+ * planes
+ */
+
+static void _plane_close(BD_OVERLAY_COMPOSITOR *c, unsigned plane)
+{
+    COMP_PLANE *p = &c->plane[plane];
+
+    if (p->argb) {
+        _add_dirty(c, 0, 0, p->w - 1, p->h - 1);
+        X_FREE(p->argb);
+    }
+    p->w = p->h = 0;
+}
+
+static void _plane_open(BD_OVERLAY_COMPOSITOR *c, unsigned plane, unsigned w, unsigned h)
+{
+    COMP_PLANE *p = &c->plane[plane];
+
+    if (p->argb && p->w == w && p->h == h) {
+        return;
+    }
+
+    _plane_close(c, plane);
+
+    if (!w || !h) {
+        return;
+    }
+
+    p->argb = calloc((size_t)w * h, sizeof(uint32_t));
+    if (!p->argb) {
+        COMP_ERROR("overlay compositor: out of memory\n");
+        return;
+    }
+    p->w = w;
+    p->h = h;
+}
+
+static void _plane_clear(BD_OVERLAY_COMPOSITOR *c, unsigned plane, int x, int y, int w, int h)
+{
+    COMP_PLANE *p = &c->plane[plane];
+    int         yy;
+
+    if (!p->argb) {
+        return;
+    }
+
+    /* clip */
+    w = BD_MIN(w, p->w - x);
+    h = BD_MIN(h, p->h - y);
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    for (yy = y; yy < y + h; yy++) {
+        memset(p->argb + (size_t)yy * p->w + x, 0, (size_t)w * sizeof(uint32_t));
+    }
+
+    _add_dirty(c, x, y, x + w - 1, y + h - 1);
+}
+
+/*
+ * output
+ */
+
+static void _compose(BD_OVERLAY_COMPOSITOR *c, int64_t pts)
+{
+    BD_ARGB_BUFFER_EXT *ext = c->out;
+    BD_ARGB_BUFFER *out = &ext->base;
+    const COMP_PLANE *pg = &c->plane[BD_OVERLAY_PG];
+    const COMP_PLANE *ig = &c->plane[BD_OVERLAY_IG];
+    unsigned ii, num_rects = 0;
+
+    if (!c->num_dirty) {
+        return;
+    }
+
+    /* clip dirty area to output buffer and set dirty info before lock() */
+    for (ii = 0; ii < c->num_dirty; ii++) {
+        int x1 = BD_MIN(c->dirty[ii].x1, out->width - 1);
+        int y1 = BD_MIN(c->dirty[ii].y1, out->height - 1);
+        if (c->dirty[ii].x0 <= x1 && c->dirty[ii].y0 <= y1) {
+            ext->dirty_rects[0][num_rects].x0 = c->dirty[ii].x0;
+            ext->dirty_rects[0][num_rects].y0 = c->dirty[ii].y0;
+            ext->dirty_rects[0][num_rects].x1 = x1;
+            ext->dirty_rects[0][num_rects].y1 = y1;
+            if (!num_rects) {
+                out->dirty[0].x0 = c->dirty[ii].x0;
+                out->dirty[0].y0 = c->dirty[ii].y0;
+                out->dirty[0].x1 = x1;
+                out->dirty[0].y1 = y1;
+            } else {
+                out->dirty[0].x0 = BD_MIN(out->dirty[0].x0, c->dirty[ii].x0);
+                out->dirty[0].y0 = BD_MIN(out->dirty[0].y0, c->dirty[ii].y0);
+                out->dirty[0].x1 = BD_MAX(out->dirty[0].x1, x1);
+                out->dirty[0].y1 = BD_MAX(out->dirty[0].y1, y1);
+            }
+            num_rects++;
+        }
+    }
+    ext->num_dirty_rects[0] = num_rects;
+    c->num_dirty = 0;
+
+    if (!num_rects) {
+        return;
+    }
+
+    if (out->lock) {
+        out->lock(out);
+    }
+
+    if (!out->buf[0]) {
+        COMP_ERROR("overlay compositor: output buffer missing\n");
+        if (out->unlock) {
+            out->unlock(out);
+        }
+        return;
+    }
+
+    for (ii = 0; ii < num_rects; ii++) {
+        unsigned x0 = ext->dirty_rects[0][ii].x0, x1 = ext->dirty_rects[0][ii].x1;
+        unsigned y0 = ext->dirty_rects[0][ii].y0, y1 = ext->dirty_rects[0][ii].y1;
+        unsigned y;
+
+        for (y = y0; y <= y1; y++) {
+            uint32_t *dst = out->buf[0] + (size_t)y * out->width;
+
+            /* PG plane */
+            if (pg->argb && y < pg->h && x0 < pg->w) {
+                unsigned n = BD_MIN(x1 + 1, pg->w) - x0;
+                memcpy(dst + x0, pg->argb + (size_t)y * pg->w + x0, n * sizeof(uint32_t));
+                if (x0 + n <= x1) {
+                    memset(dst + x0 + n, 0, (x1 + 1 - x0 - n) * sizeof(uint32_t));
+                }
+            } else {
+                memset(dst + x0, 0, (x1 + 1 - x0) * sizeof(uint32_t));
+            }
+
+            /* IG plane on top */
+            if (ig->argb && y < ig->h && x0 < ig->w) {
+                unsigned n = BD_MIN(x1 + 1, ig->w) - x0;
+                _blend_row(dst + x0, ig->argb + (size_t)y * ig->w + x0, n);
+            }
+        }
+    }
+
+    if (out->unlock) {
+        out->unlock(out);
+    }
+
+    if (c->flush_cb) {
+        c->flush_cb(c->flush_handle, ext, pts);
+    }
+
+    ext->num_dirty_rects[0] = 0;
+}
+
+/*
+ * event handlers
+ */
+
+static void _draw_rle(BD_OVERLAY_COMPOSITOR *c, const BD_OVERLAY * const ov)
+{
+    COMP_PLANE *p = &c->plane[ov->plane];
+    uint32_t    argb[256];
+    unsigned    ii;
+
+    if (!p->argb || !ov->img || !ov->palette) {
+        return;
+    }
+
+    /* premultiplied palette */
+    if (!ov->palette_serial || ov->palette_serial != c->lut_serial) {
+        if (ov->palette_argb) {
+            memcpy(argb, ov->palette_argb, sizeof(argb));
+        } else {
+            bd_pg_palette_to_argb(ov->palette, argb, p->h >= 720);
+        }
+        for (ii = 0; ii < 256; ii++) {
+            c->lut[ii] = _premultiply(argb[ii]);
+        }
+        c->lut_serial = ov->palette_serial;
+    }
+
+    if (ov->x + ov->w <= p->w && ov->y + ov->h <= p->h) {
+        bd_rle_decode32(ov->img, ov->w, ov->h, c->lut, p->argb + (size_t)ov->y * p->w + ov->x, p->w);
+    } else {
+        /* decode to temporary buffer and clip */
+        uint32_t *tmp = malloc((size_t)ov->w * ov->h * sizeof(uint32_t));
+        int       w   = BD_MIN(ov->w, p->w - ov->x);
+        int       y;
+        if (!tmp) {
+            COMP_ERROR("overlay compositor: out of memory\n");
+            return;
+        }
+        bd_rle_decode32(ov->img, ov->w, ov->h, c->lut, tmp, ov->w);
+        for (y = 0; w > 0 && y < ov->h && ov->y + y < p->h; y++) {
+            memcpy(p->argb + (size_t)(ov->y + y) * p->w + ov->x, tmp + (size_t)y * ov->w, w * sizeof(uint32_t));
+        }
+        X_FREE(tmp);
+    }
+
+    _add_dirty(c, ov->x, ov->y, BD_MIN(ov->x + ov->w, p->w) - 1, BD_MIN(ov->y + ov->h, p->h) - 1);
+}
+
+static void _draw_argb(BD_OVERLAY_COMPOSITOR *c, const BD_ARGB_OVERLAY * const ov)
+{
+    COMP_PLANE *p = &c->plane[ov->plane];
+    int         w, h, x, y;
+
+    if (!p->argb || !ov->argb) {
+        return;
+    }
+
+    w = BD_MIN(ov->w, p->w - ov->x);
+    h = BD_MIN(ov->h, p->h - ov->y);
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    for (y = 0; y < h; y++) {
+        const uint32_t *src = ov->argb + (size_t)y * ov->stride;
+        uint32_t       *dst = p->argb + (size_t)(ov->y + y) * p->w + ov->x;
+        for (x = 0; x < w; x++) {
+            dst[x] = _premultiply(src[x]);
+        }
+    }
+
+    _add_dirty(c, ov->x, ov->y, ov->x + w - 1, ov->y + h - 1);
+}
+
+/*
+ * public API
+ */
+
+BD_OVERLAY_COMPOSITOR *bd_overlay_compositor_init(BD_ARGB_BUFFER_EXT *out,
+                                                  void (*flush_cb)(void *handle, BD_ARGB_BUFFER_EXT *out, int64_t pts),
+                                                  void *handle)
+{
+    BD_OVERLAY_COMPOSITOR *c;
+
+    if (!out) {
+        return NULL;
+    }
+
+    c = calloc(1, sizeof(*c));
+    if (!c) {
+        COMP_ERROR("overlay compositor: out of memory\n");
+        return NULL;
+    }
+
+    c->out          = out;
+    c->flush_cb     = flush_cb;
+    c->flush_handle = handle;
+
+    bd_mutex_init(&c->mutex);
+
+    return c;
+}
+
+void bd_overlay_compositor_free(BD_OVERLAY_COMPOSITOR **pp)
+{
+    if (pp && *pp) {
+        BD_OVERLAY_COMPOSITOR *c = *pp;
+
+        X_FREE(c->plane[0].argb);
+        X_FREE(c->plane[1].argb);
+        bd_mutex_destroy(&c->mutex);
+
+        X_FREE(*pp);
+    }
+}
+
+void bd_overlay_compositor_overlay_proc(void *handle, const BD_OVERLAY * const ov)
+{
+    BD_OVERLAY_COMPOSITOR *c = (BD_OVERLAY_COMPOSITOR *)handle;
+
+    if (!c) {
+        return;
+    }
+
+    bd_mutex_lock(&c->mutex);
+
+    if (!ov) {
+        /* close all planes */
+        _plane_close(c, BD_OVERLAY_PG);
+        _plane_close(c, BD_OVERLAY_IG);
+        _compose(c, -1);
+        bd_mutex_unlock(&c->mutex);
+        return;
+    }
+
+    if (ov->plane > BD_OVERLAY_IG) {
+        bd_mutex_unlock(&c->mutex);
+        return;
+    }
+
+    switch (ov->cmd) {
+        case BD_OVERLAY_INIT:
+            _plane_open(c, ov->plane, ov->w, ov->h);
+            break;
+        case BD_OVERLAY_CLOSE:
+            _plane_close(c, ov->plane);
+            _compose(c, ov->pts);
+            break;
+        case BD_OVERLAY_CLEAR:
+            _plane_clear(c, ov->plane, 0, 0, c->plane[ov->plane].w, c->plane[ov->plane].h);
+            break;
+        case BD_OVERLAY_WIPE:
+            _plane_clear(c, ov->plane, ov->x, ov->y, ov->w, ov->h);
+            break;
+        case BD_OVERLAY_DRAW:
+            _draw_rle(c, ov);
+            break;
+        case BD_OVERLAY_FLUSH:
+            _compose(c, ov->pts);
+            break;
+        case BD_OVERLAY_HIDE:
+        default:
+            break;
+    }
+
+    bd_mutex_unlock(&c->mutex);
+}
+
+void bd_overlay_compositor_argb_overlay_proc(void *handle, const BD_ARGB_OVERLAY * const ov)
+{
+    BD_OVERLAY_COMPOSITOR *c = (BD_OVERLAY_COMPOSITOR *)handle;
+
+    if (!c) {
+        return;
+    }
+
+    bd_mutex_lock(&c->mutex);
+
+    if (!ov) {
+        _plane_close(c, BD_OVERLAY_IG);
+        _compose(c, -1);
+        bd_mutex_unlock(&c->mutex);
+        return;
+    }
+
+    if (ov->plane > BD_OVERLAY_IG) {
+        bd_mutex_unlock(&c->mutex);
+        return;
+    }
+
+    switch (ov->cmd) {
+        case BD_ARGB_OVERLAY_INIT:
+            _plane_open(c, ov->plane, ov->w, ov->h);
+            break;
+        case BD_ARGB_OVERLAY_CLOSE:
+            _plane_close(c, ov->plane);
+            _compose(c, ov->pts);
+            break;
+        case BD_ARGB_OVERLAY_DRAW:
+            _draw_argb(c, ov);
+            break;
+        case BD_ARGB_OVERLAY_FLUSH:
+            _compose(c, ov->pts);
+            break;
+        default:
+            break;
+    }
+
+    bd_mutex_unlock(&c->mutex);
+}
@@ -24,24 +24,214 @@
 #include <stdlib.h>
 #include <string.h>
 
+/*
+ * payload size classes: 256 bytes ... 64 KB (max. PES packet size)
+ */
+
+#define POOL_MIN_SHIFT     8
+#define POOL_NUM_CLASSES   9
+#define POOL_MAX_FREE      16  /* cached payloads / class */
+#define POOL_MAX_FREE_BUF  64  /* cached PES_BUFFER nodes */
+
+typedef struct pool_payload_s POOL_PAYLOAD;
+struct pool_payload_s {
+    POOL_PAYLOAD *next;
+};
+
+struct pes_buffer_pool_s {
+    PES_BUFFER   *free_buf;
+    unsigned      num_free_buf;
+
+    POOL_PAYLOAD *free_payload[POOL_NUM_CLASSES];
+    unsigned      num_free_payload[POOL_NUM_CLASSES];
+
+    unsigned      in_use;   /* buffers allocated from pool and not yet freed */
+    uint8_t       closed;   /* owner released the pool */
+};
+
+static int _size_class(unsigned size)
+{
+    int cls = 0;
+    while (cls < POOL_NUM_CLASSES && (1u << (cls + POOL_MIN_SHIFT)) < size) {
+        cls++;
+    }
+    return cls < POOL_NUM_CLASSES ? cls : -1;
+}
+
+static void _pool_destroy(PES_BUFFER_POOL *pool)
+{
+    unsigned ii;
+
+    while (pool->free_buf) {
+        PES_BUFFER *p = pool->free_buf;
+        pool->free_buf = p->next;
+        X_FREE(p);
+    }
+    for (ii = 0; ii < POOL_NUM_CLASSES; ii++) {
+        while (pool->free_payload[ii]) {
+            POOL_PAYLOAD *p = pool->free_payload[ii];
+            pool->free_payload[ii] = p->next;
+            X_FREE(p);
+        }
+    }
+    X_FREE(pool);
+}
+
+static void _pool_release_payload(PES_BUFFER_POOL *pool, uint8_t *buf, unsigned size)
+{
+    int cls = _size_class(size);
+
+    if (buf && cls >= 0 && (1u << (cls + POOL_MIN_SHIFT)) == size &&
+        pool->num_free_payload[cls] < POOL_MAX_FREE) {
+        POOL_PAYLOAD *p = (POOL_PAYLOAD *)(void *)buf;
+        p->next = pool->free_payload[cls];
+        pool->free_payload[cls] = p;
+        pool->num_free_payload[cls]++;
+        return;
+    }
+
+    X_FREE(buf);
+}
+
+PES_BUFFER_POOL *pes_buffer_pool_init(void)
+{
+    return calloc(1, sizeof(PES_BUFFER_POOL));
+}
+
+void pes_buffer_pool_free(PES_BUFFER_POOL **pp)
+{
+    if (pp && *pp) {
+        PES_BUFFER_POOL *pool = *pp;
+        *pp = NULL;
+
+        pool->closed = 1;
+        if (!pool->in_use) {
+            _pool_destroy(pool);
+        }
+    }
+}
+
+PES_BUFFER *pes_buffer_pool_alloc(PES_BUFFER_POOL *pool)
+{
+    PES_BUFFER *p;
+
+    if (!pool) {
+        return pes_buffer_alloc();
+    }
+
+    p = pool->free_buf;
+    if (p) {
+        pool->free_buf = p->next;
+        pool->num_free_buf--;
+        memset(p, 0, sizeof(*p));
+    } else {
+        p = calloc(1, sizeof(*p));
+        if (!p) {
+            return NULL;
+        }
+    }
+
+    p->pool = pool;
+    p->prev = p;
+    pool->in_use++;
+
+    return p;
+}
+
 PES_BUFFER *pes_buffer_alloc(void)
 {
     PES_BUFFER *p = calloc(1, sizeof(*p));
 
+    if (p) {
+        p->prev = p;
+    }
+
     return p;
 }
 
-void pes_buffer_free(PES_BUFFER **p)
+void pes_buffer_free(PES_BUFFER **head)
 {
-    if (p && *p) {
-        if ((*p)->next) {
-            pes_buffer_free(&(*p)->next);
+    if (head) {
+        while (*head) {
+            PES_BUFFER      *p    = *head;
+            PES_BUFFER_POOL *pool = p->pool;
+
+            *head = p->next;
+
+            if (!pool) {
+                X_FREE(p->buf);
+                X_FREE(p);
+                continue;
+            }
+
+            _pool_release_payload(pool, p->buf, p->size);
+
+            pool->in_use--;
+            if (pool->closed) {
+                X_FREE(p);
+                if (!pool->in_use) {
+                    _pool_destroy(pool);
+                }
+            } else if (pool->num_free_buf < POOL_MAX_FREE_BUF) {
+                p->next = pool->free_buf;
+                pool->free_buf = p;
+                pool->num_free_buf++;
+            } else {
+                X_FREE(p);
+            }
         }
-        X_FREE ((*p)->buf);
-        X_FREE (*p);
     }
 }
 
+int pes_buffer_reserve(PES_BUFFER *p, unsigned size)
+{
+    PES_BUFFER_POOL *pool = p->pool;
+    uint8_t         *tmp;
+    int              cls;
+
+    if (p->size >= size) {
+        return 1;
+    }
+
+    cls = _size_class(size);
+    if (!pool || cls < 0 || pool->closed) {
+        tmp = realloc(p->buf, size);
+        if (!tmp) {
+            return 0;
+        }
+        p->buf  = tmp;
+        p->size = size;
+        return 1;
+    }
+
+    /* take payload of next size class from pool */
+    if (pool->free_payload[cls]) {
+        tmp = (uint8_t *)(void *)pool->free_payload[cls];
+        pool->free_payload[cls] = pool->free_payload[cls]->next;
+        pool->num_free_payload[cls]--;
+    } else {
+        tmp = malloc(1u << (cls + POOL_MIN_SHIFT));
+        if (!tmp) {
+            return 0;
+        }
+    }
+
+    if (p->len) {
+        memcpy(tmp, p->buf, p->len);
+    }
+    _pool_release_payload(pool, p->buf, p->size);
+
+    p->buf  = tmp;
+    p->size = 1u << (cls + POOL_MIN_SHIFT);
+
+    return 1;
+}
+
+/*
+ * Lists are doubly linked. prev of the list head points to the last buffer,
+ * so appending and removing are O(1).
+ */
+
 void pes_buffer_append(PES_BUFFER **head, PES_BUFFER *buf)
 {
     if (!head) {
@@ -54,39 +244,41 @@ void pes_buffer_append(PES_BUFFER **head, PES_BUFFER *buf)
     }
 
     if (buf) {
-        PES_BUFFER *tail = *head;
-        for (; tail->next; tail = tail->next) ;
-        tail->next = buf;
+        PES_BUFFER *tail     = (*head)->prev;
+        PES_BUFFER *buf_tail = buf->prev;
+
+        tail->next    = buf;
+        buf->prev     = tail;
+        (*head)->prev = buf_tail;
     }
 }
 
-static PES_BUFFER *_prev_buffer(PES_BUFFER *head, PES_BUFFER *buf)
+static void _unlink(PES_BUFFER **head, PES_BUFFER *p)
 {
-    while (head) {
-        if (head->next == buf) {
-            return head;
+    if (*head == p) {
+        *head = p->next;
+        if (*head) {
+            (*head)->prev = p->prev;
+        }
+    } else {
+        p->prev->next = p->next;
+        if (p->next) {
+            p->next->prev = p->prev;
+        } else {
+            /* removed last buffer */
+            (*head)->prev = p->prev;
         }
-        head = head->next;
     }
 
-    return NULL;
+    p->next = NULL;
+    p->prev = p;
 }
 
 void pes_buffer_remove(PES_BUFFER **head, PES_BUFFER *p)
 {
     if (head && *head && p) {
-        if (*head == p) {
-            *head = (*head)->next;
-            p->next = NULL;
-            pes_buffer_free(&p);
-        } else {
-            PES_BUFFER *prev = _prev_buffer(*head, p);
-            if (prev) {
-                prev->next = p->next;
-                p->next = NULL;
-                pes_buffer_free(&p);
-            }
-        }
+        _unlink(head, p);
+        pes_buffer_free(&p);
     }
 }
 
@@ -94,8 +286,18 @@ void pes_buffer_next(PES_BUFFER **head)
 {
     if (head && *head) {
         PES_BUFFER *p = *head;
-        *head = (*head)->next;
-        p->next = NULL;
+        _unlink(head, p);
         pes_buffer_free(&p);
     }
 }
+
+PES_BUFFER *pes_buffer_detach(PES_BUFFER **head)
+{
+    PES_BUFFER *p = NULL;
+
+    if (head && *head) {
+        p = *head;
+        _unlink(head, p);
+    }
+    return p;
+}
@@ -25,6 +25,8 @@
 #include <stdint.h>
 
 
+typedef struct pes_buffer_pool_s PES_BUFFER_POOL;
+
 typedef struct pes_buffer_s PES_BUFFER;
 struct pes_buffer_s {
     uint8_t  *buf;
@@ -33,17 +35,41 @@ struct pes_buffer_s {
 
     int64_t   pts;
     int64_t   dts;
+    uint8_t   ts_flags; // PES_HAS_PTS / PES_HAS_DTS (pts and dts are 0 if not present)
 
     struct pes_buffer_s *next;
+    struct pes_buffer_s *prev; // previous buffer. In list head: last buffer of the list.
+
+    PES_BUFFER_POOL *pool; // pool this buffer is returned to (NULL = heap)
 };
 
 
+#define PES_HAS_PTS  0x01
+#define PES_HAS_DTS  0x02
+
 BD_PRIVATE PES_BUFFER *pes_buffer_alloc(void) BD_ATTR_MALLOC;
 BD_PRIVATE void        pes_buffer_free(PES_BUFFER **); // free list of buffers
 
-BD_PRIVATE void        pes_buffer_append(PES_BUFFER **head, PES_BUFFER *buf); // append buf to list
-BD_PRIVATE void        pes_buffer_remove(PES_BUFFER **head, PES_BUFFER *buf); // remove buf from list and free it
+BD_PRIVATE int         pes_buffer_reserve(PES_BUFFER *buf, unsigned size); // make room for size bytes of payload. Returns 0 on error.
+
+/*
+ * PES buffer pool
+ *
+ * Freed buffers and payloads are kept for re-use.
+ * Pool is shared by producer (demuxer) and consumer (graphics processor),
+ * and it must be accessed from a single thread (or under the same lock).
+ * Pool released with pes_buffer_pool_free() is destroyed when the last
+ * buffer allocated from it is freed.
+ */
+
+BD_PRIVATE PES_BUFFER_POOL *pes_buffer_pool_init(void);
+BD_PRIVATE void             pes_buffer_pool_free(PES_BUFFER_POOL **);
+BD_PRIVATE PES_BUFFER      *pes_buffer_pool_alloc(PES_BUFFER_POOL *);
+
+BD_PRIVATE void        pes_buffer_append(PES_BUFFER **head, PES_BUFFER *buf); // append buf (or list) to list
+BD_PRIVATE void        pes_buffer_remove(PES_BUFFER **head, PES_BUFFER *buf); // remove buf from list and free it. buf must be in the list.
 
 BD_PRIVATE void        pes_buffer_next(PES_BUFFER **head); // free first buffer and advance head to next buffer
+BD_PRIVATE PES_BUFFER *pes_buffer_detach(PES_BUFFER **head); // unlink first buffer and advance head to next buffer. Returns unlinked buffer.
 
 #endif // _PES_BUFFER_H_
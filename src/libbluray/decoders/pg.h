@@ -70,6 +70,13 @@ typedef struct {
     uint8_t version;
 
     BD_PG_PALETTE_ENTRY entry[256];
+
+    uint32_t serial;        /* unique id of palette content */
+
+    /* ARGB conversion cache (graphics controller) */
+    uint32_t argb_serial;
+    uint8_t  argb_bt709;
+    uint32_t argb[256];
 } BD_PG_PALETTE;
 
 typedef struct {
@@ -82,6 +89,32 @@ typedef struct {
     uint16_t height;
 
     BD_PG_RLE_ELEM *img;
+    uint32_t        img_size;   /* bytes allocated for img */
+
+    uint32_t serial;        /* unique id of image content */
+
+    /* encoded object segment, retained for re-decoding evicted img (or NULL) */
+    uint8_t        *data;
+    uint32_t        data_size;
+
+    /* cropped image cache (graphics controller) */
+    BD_PG_RLE_ELEM *crop_img;
+    uint8_t         crop_version;
+    uint16_t        crop_x, crop_y, crop_w, crop_h;
+    uint32_t        crop_serial;
+    uint32_t        crop_size;
+
+    /* palette index image cache (graphics controller) */
+    uint8_t        *index_img;
+    uint32_t        index_serial;
+    uint32_t        index_size;
+
+    /* ARGB image cache (graphics controller) */
+    uint32_t       *argb_img;
+    uint32_t        argb_serial;          /* image serial */
+    uint32_t        argb_palette_serial;
+    uint8_t         argb_bt709;
+    uint32_t        argb_size;
 
 } BD_PG_OBJECT;
 
@@ -19,6 +19,7 @@
 
 #include "pg_decode.h"
 
+#include "util/atomic.h"
 #include "util/refcnt.h"
 #include "util/macro.h"
 #include "util/logging.h"
@@ -96,6 +97,20 @@ void pg_decode_palette_entry(BITBUFFER *bb, BD_PG_PALETTE_ENTRY *entry)
  * segments
  */
 
+static BD_ATOMIC_UINT serial_counter;
+
+uint32_t pg_new_serial(void)
+{
+    uint32_t serial;
+
+    /* process-wide unique, never 0 */
+    do {
+        serial = bd_atomic_add(&serial_counter, 1) + 1;
+    } while (!serial);
+
+    return serial;
+}
+
 int pg_decode_palette_update(BITBUFFER *bb, BD_PG_PALETTE *p)
 {
     p->id      = bb_read(bb, 8);
@@ -105,6 +120,8 @@ int pg_decode_palette_update(BITBUFFER *bb, BD_PG_PALETTE *p)
         pg_decode_palette_entry(bb, p->entry);
     }
 
+    p->serial = pg_new_serial();
+
     return 1;
 }
 
@@ -115,71 +132,83 @@ int pg_decode_palette(BITBUFFER *bb, BD_PG_PALETTE *p)
     return pg_decode_palette_update(bb, p);
 }
 
+/* next byte of RLE data (zero after end of data, like bb_read()) */
+static inline uint8_t _rle_byte(const uint8_t **q, const uint8_t *end)
+{
+    return *q < end ? *(*q)++ : 0;
+}
+
 static int _decode_rle(BITBUFFER *bb, BD_PG_OBJECT *p)
 {
     BD_PG_RLE_ELEM *tmp;
+    const uint8_t  *q   = bb->p;
+    const uint8_t  *end = bb->p_end;
     int pixels_left = p->width * p->height;
     int num_rle     = 0;
-    int rle_size    = p->width * p->height / 4;
+    int rle_size;
+
+    /* data is byte-aligned (checked in pg_decode_object()) */
+    if (bb->i_left != 8) {
+        BD_DEBUG_HOT(DBG_DECODE, "pg_decode_object(): alignment error\n");
+        return 0;
+    }
 
-    if (rle_size < 1)
-        rle_size = 1;
+    /* each run takes at least one byte: allocate for upper bound */
+    rle_size = (int)(end - q) + 1;
 
-    tmp = refcnt_realloc(p->img, rle_size * sizeof(BD_PG_RLE_ELEM));
+    tmp = refcnt_realloc(p->img, rle_size * sizeof(BD_PG_RLE_ELEM), NULL);
     if (!tmp) {
         BD_DEBUG(DBG_DECODE | DBG_CRIT, "pg_decode_object(): realloc failed\n");
         return 0;
     }
-    p->img = tmp;
+    p->img      = tmp;
+    p->img_size = rle_size * sizeof(BD_PG_RLE_ELEM);
 
-    while (!bb_eof(bb)) {
+    while (q < end) {
         uint32_t len   = 1;
-        uint8_t  color = 0;
-
-        if (!(color = bb_read(bb, 8))) {
-            if (!bb_read(bb, 1)) {
-                if (!bb_read(bb, 1)) {
-                    len = bb_read(bb, 6);
-                } else {
-                    len = bb_read(bb, 14);
-                }
-            } else {
-                if (!bb_read(bb, 1)) {
-                    len = bb_read(bb, 6);
-                } else {
-                    len = bb_read(bb, 14);
-                }
-                color = bb_read(bb, 8);
+        uint8_t  color = *q++;
+
+        if (!color) {
+            uint8_t flags = _rle_byte(&q, end);
+
+            len = flags & 0x3f;
+            if (flags & 0x40) {
+                len = (len << 8) | _rle_byte(&q, end);
+            }
+            if (flags & 0x80) {
+                color = _rle_byte(&q, end);
             }
         }
 
-        p->img[num_rle].len   = len;
-        p->img[num_rle].color = color;
+        tmp[num_rle].len   = len;
+        tmp[num_rle].color = color;
+        num_rle++;
 
         pixels_left -= len;
 
         if (pixels_left < 0) {
-            BD_DEBUG(DBG_DECODE, "pg_decode_object(): too many pixels (%d)\n", -pixels_left);
+            BD_DEBUG_HOT(DBG_DECODE, "pg_decode_object(): too many pixels (%d)\n", -pixels_left);
+            bb->p = end;
             return 0;
         }
-
-        num_rle++;
-        if (num_rle >= rle_size) {
-            rle_size *= 2;
-            tmp = refcnt_realloc(p->img, rle_size * sizeof(BD_PG_RLE_ELEM));
-            if (!tmp) {
-                BD_DEBUG(DBG_DECODE | DBG_CRIT, "pg_decode_object(): realloc failed\n");
-                return 0;
-            }
-            p->img = tmp;
-        }
     }
 
+    bb->p = end;
+
     if (pixels_left > 0) {
-        BD_DEBUG(DBG_DECODE, "pg_decode_object(): missing %d pixels\n", pixels_left);
+        BD_DEBUG_HOT(DBG_DECODE, "pg_decode_object(): missing %d pixels\n", pixels_left);
         return 0;
     }
 
+    /* release unused space (upper bound is up to 4x the run count) */
+    if (num_rle + 1 < rle_size - rle_size / 4) {
+        tmp = refcnt_realloc(p->img, (num_rle + 1) * sizeof(BD_PG_RLE_ELEM), NULL);
+        if (tmp) {
+            p->img      = tmp;
+            p->img_size = (num_rle + 1) * sizeof(BD_PG_RLE_ELEM);
+        }
+    }
+
     return 1;
 }
 
@@ -187,6 +216,16 @@ int pg_decode_object(BITBUFFER *bb, BD_PG_OBJECT *p)
 {
     BD_PG_SEQUENCE_DESCRIPTOR sd;
 
+    /* object is replaced */
+    bd_refcnt_dec(p->crop_img);
+    p->crop_img = NULL;
+    bd_refcnt_dec(p->index_img);
+    p->index_img = NULL;
+    bd_refcnt_dec(p->argb_img);
+    p->argb_img  = NULL;
+    p->crop_size = p->index_size = p->argb_size = 0;
+    p->serial    = pg_new_serial();
+
     p->id      = bb_read(bb, 16);
     p->version = bb_read(bb, 8);
 
@@ -194,23 +233,23 @@ int pg_decode_object(BITBUFFER *bb, BD_PG_OBJECT *p)
 
     /* splitted segments should be already joined */
     if (!sd.first_in_seq) {
-        BD_DEBUG(DBG_DECODE, "pg_decode_object(): not first in sequence\n");
+        BD_DEBUG_HOT(DBG_DECODE, "pg_decode_object(): not first in sequence\n");
         return 0;
     }
     if (!sd.last_in_seq) {
-        BD_DEBUG(DBG_DECODE, "pg_decode_object(): not last in sequence\n");
+        BD_DEBUG_HOT(DBG_DECODE, "pg_decode_object(): not last in sequence\n");
         return 0;
     }
 
     if (!bb_is_align(bb, 0x07)) {
-      BD_DEBUG(DBG_DECODE, "pg_decode_object(): alignment error\n");
+      BD_DEBUG_HOT(DBG_DECODE, "pg_decode_object(): alignment error\n");
       return 0;
     }
 
     uint32_t data_len = bb_read(bb, 24);
     uint32_t buf_len  = bb->p_end - bb->p;
     if (data_len != buf_len) {
-        BD_DEBUG(DBG_DECODE, "pg_decode_object(): buffer size mismatch (expected %d, have %d)\n", data_len, buf_len);
+        BD_DEBUG_HOT(DBG_DECODE, "pg_decode_object(): buffer size mismatch (expected %d, have %d)\n", data_len, buf_len);
         return 0;
     }
 
@@ -220,6 +259,79 @@ int pg_decode_object(BITBUFFER *bb, BD_PG_OBJECT *p)
     return _decode_rle(bb, p);
 }
 
+int pg_retain_object_data(BD_PG_OBJECT *p, const uint8_t *segment, uint32_t size)
+{
+    X_FREE(p->data);
+    p->data_size = 0;
+
+    if (!segment || !size) {
+        return 1;
+    }
+
+    p->data = malloc(size);
+    if (!p->data) {
+        BD_DEBUG(DBG_DECODE | DBG_CRIT, "out of memory\n");
+        return 0;
+    }
+    memcpy(p->data, segment, size);
+    p->data_size = size;
+
+    return 1;
+}
+
+uint32_t pg_evict_object(BD_PG_OBJECT *p)
+{
+    uint32_t freed;
+
+    if (!p->data || !p->img) {
+        return 0;
+    }
+
+    freed = p->img_size + p->crop_size + p->index_size + p->argb_size;
+
+    bd_refcnt_dec(p->img);
+    bd_refcnt_dec(p->crop_img);
+    bd_refcnt_dec(p->index_img);
+    bd_refcnt_dec(p->argb_img);
+    p->img       = NULL;
+    p->crop_img  = NULL;
+    p->index_img = NULL;
+    p->argb_img  = NULL;
+    p->img_size  = p->crop_size = p->index_size = p->argb_size = 0;
+
+    return freed;
+}
+
+int pg_redecode_object(BD_PG_OBJECT *p)
+{
+    BITBUFFER bb;
+    uint32_t  serial = p->serial;
+    int64_t   pts    = p->pts;
+
+    if (p->img) {
+        return 1;
+    }
+    if (!p->data || p->data_size < 3) {
+        return 0;
+    }
+
+    /* skip segment type and length */
+    bb_init(&bb, p->data + 3, p->data_size - 3);
+
+    if (!pg_decode_object(&bb, p)) {
+        bd_refcnt_dec(p->img);
+        p->img      = NULL;
+        p->img_size = 0;
+        return 0;
+    }
+
+    /* same content */
+    p->serial = serial;
+    p->pts    = pts;
+
+    return 1;
+}
+
 int pg_decode_composition(BITBUFFER *bb, BD_PG_COMPOSITION *p)
 {
     unsigned ii;
@@ -273,6 +385,15 @@ void pg_clean_object(BD_PG_OBJECT *p)
     if (p) {
         bd_refcnt_dec(p->img);
         p->img = NULL;
+        bd_refcnt_dec(p->crop_img);
+        p->crop_img = NULL;
+        bd_refcnt_dec(p->index_img);
+        p->index_img = NULL;
+        bd_refcnt_dec(p->argb_img);
+        p->argb_img = NULL;
+        X_FREE(p->data);
+        p->data_size = 0;
+        p->img_size = p->crop_size = p->index_size = p->argb_size = 0;
     }
 }
 
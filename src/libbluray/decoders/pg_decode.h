@@ -40,12 +40,26 @@ BD_PRIVATE void pg_decode_palette_entry(BITBUFFER *bb, BD_PG_PALETTE_ENTRY *p);
  * segments
  */
 
+/* process-wide unique id for decoded content (never 0) */
+BD_PRIVATE uint32_t pg_new_serial(void);
+
 BD_PRIVATE int pg_decode_palette_update(BITBUFFER *bb, BD_PG_PALETTE *p);
 BD_PRIVATE int pg_decode_palette(BITBUFFER *bb, BD_PG_PALETTE *p);
 BD_PRIVATE int pg_decode_object(BITBUFFER *bb, BD_PG_OBJECT *p);
 BD_PRIVATE int pg_decode_composition(BITBUFFER *bb, BD_PG_COMPOSITION *p);
 BD_PRIVATE int pg_decode_windows(BITBUFFER *bb, BD_PG_WINDOWS *p);
 
+/*
+ * object memory management
+ */
+
+/* keep copy of encoded object segment (NULL: drop retained copy) */
+BD_PRIVATE int      pg_retain_object_data(BD_PG_OBJECT *p, const uint8_t *segment, uint32_t size);
+/* free decoded images of object with retained data. Returns number of bytes freed. */
+BD_PRIVATE uint32_t pg_evict_object(BD_PG_OBJECT *p);
+/* re-decode evicted object from retained data */
+BD_PRIVATE int      pg_redecode_object(BD_PG_OBJECT *p);
+
 /*
  * cleanup
  */
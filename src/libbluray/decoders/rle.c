@@ -21,6 +21,8 @@
 
 #include "util/logging.h"
 
+#include <string.h>
+
 /*
  * util
  */
@@ -31,7 +33,7 @@ static void _rle_ensure_size(RLE_ENC *p)
         BD_PG_RLE_ELEM *start = rle_get(p);
         /* realloc to 2x */
         p->free_elem = p->num_elem;
-        start = refcnt_realloc(start, p->num_elem * 2 * sizeof(BD_PG_RLE_ELEM));
+        start = refcnt_realloc(start, p->num_elem * 2 * sizeof(BD_PG_RLE_ELEM), NULL);
         p->elem = start + p->num_elem;
         p->num_elem *= 2;
     }
@@ -58,7 +60,8 @@ static void _enc_eol(RLE_ENC *p)
 }
 
 BD_PG_RLE_ELEM *rle_crop_object(const BD_PG_RLE_ELEM *orig, int width,
-                                       int crop_x, int crop_y, int crop_w, int crop_h)
+                                       int crop_x, int crop_y, int crop_w, int crop_h,
+                                       uint32_t *alloc_size)
 {
     RLE_ENC  rle;
     int      x0 = crop_x;
@@ -115,6 +118,10 @@ BD_PG_RLE_ELEM *rle_crop_object(const BD_PG_RLE_ELEM *orig, int width,
         _enc_eol(&rle);
     }
 
+    if (alloc_size) {
+        *alloc_size = rle.elem ? rle.num_elem * sizeof(BD_PG_RLE_ELEM) : 0;
+    }
+
     return rle_get(&rle);
 }
 
@@ -163,3 +170,136 @@ void rle_compress_chunk(RLE_ENC *p, const uint8_t *mem, unsigned width)
         rle_add_bite(p, mem[ii], 1);
     }
 }
+
+/*
+ * decoding
+ */
+
+static uint8_t _clip_u8(int v)
+{
+    return v < 0 ? 0 : v > 255 ? 255 : (uint8_t)v;
+}
+
+void bd_pg_palette_to_argb(const BD_PG_PALETTE_ENTRY *palette, uint32_t *lut, int bt709)
+{
+    /* limited range YCbCr -> RGB, 10-bit fixed point */
+    const int cr_r = bt709 ? 1836 : 1634;
+    const int cb_g = bt709 ?  218 :  401;
+    const int cr_g = bt709 ?  546 :  833;
+    const int cb_b = bt709 ? 2163 : 2066;
+    unsigned ii;
+
+    for (ii = 0; ii < 256; ii++) {
+        int y  = 1192 * (palette[ii].Y - 16) + 512;
+        int cb = palette[ii].Cb - 128;
+        int cr = palette[ii].Cr - 128;
+
+        lut[ii] = ((uint32_t)palette[ii].T << 24) |
+                  ((uint32_t)_clip_u8((y + cr_r * cr) >> 10) << 16) |
+                  ((uint32_t)_clip_u8((y - cb_g * cb - cr_g * cr) >> 10) << 8) |
+                   (uint32_t)_clip_u8((y + cb_b * cb) >> 10);
+    }
+}
+
+void bd_pg_palette_to_ayuv(const BD_PG_PALETTE_ENTRY *palette, uint32_t *lut)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < 256; ii++) {
+        lut[ii] = ((uint32_t)palette[ii].T << 24) | ((uint32_t)palette[ii].Y << 16) |
+                  ((uint32_t)palette[ii].Cb << 8) | palette[ii].Cr;
+    }
+}
+
+/* span fill. Written so that compiler can vectorize the inner loop. */
+static void _fill32(uint32_t *dst, uint32_t v, unsigned len)
+{
+    while (len >= 8) {
+        dst[0] = v; dst[1] = v; dst[2] = v; dst[3] = v;
+        dst[4] = v; dst[5] = v; dst[6] = v; dst[7] = v;
+        dst += 8;
+        len -= 8;
+    }
+    while (len--) {
+        *dst++ = v;
+    }
+}
+
+int bd_rle_decode32(const BD_PG_RLE_ELEM *img, unsigned w, unsigned h,
+                    const uint32_t *lut, uint32_t *dst, unsigned stride)
+{
+    int      result = 0;
+    unsigned x, y;
+
+    if (!img || !lut || !dst) {
+        return -1;
+    }
+
+    for (y = 0; y < h; y++, dst += stride) {
+        for (x = 0; x < w; img++) {
+            unsigned len = img->len;
+
+            if (BD_UNLIKELY(!len)) {
+                /* eol marker in middle of line: pad with color 0xff */
+                _fill32(dst + x, lut[0xff], w - x);
+                result = -1;
+                break;
+            }
+            if (BD_UNLIKELY(len > w - x)) {
+                len = w - x;
+                result = -1;
+            }
+
+            if (len == 1) {
+                /* anti-aliased edges: mostly single pixels */
+                dst[x] = lut[img->color & 0xff];
+            } else {
+                _fill32(dst + x, lut[img->color & 0xff], len);
+            }
+            x += len;
+        }
+
+        /* skip eol marker */
+        if (BD_LIKELY(!img->len)) {
+            img++;
+        }
+    }
+
+    return result;
+}
+
+int bd_rle_decode8(const BD_PG_RLE_ELEM *img, unsigned w, unsigned h,
+                   uint8_t *dst, unsigned stride)
+{
+    int      result = 0;
+    unsigned x, y;
+
+    if (!img || !dst) {
+        return -1;
+    }
+
+    for (y = 0; y < h; y++, dst += stride) {
+        for (x = 0; x < w; img++) {
+            unsigned len = img->len;
+
+            if (BD_UNLIKELY(!len)) {
+                memset(dst + x, 0xff, w - x);
+                result = -1;
+                break;
+            }
+            if (BD_UNLIKELY(len > w - x)) {
+                len = w - x;
+                result = -1;
+            }
+
+            memset(dst + x, img->color, len);
+            x += len;
+        }
+
+        if (BD_LIKELY(!img->len)) {
+            img++;
+        }
+    }
+
+    return result;
+}
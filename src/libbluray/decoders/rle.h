@@ -43,14 +43,16 @@ typedef struct {
 #include "util/refcnt.h"
 #include "util/macro.h"
 
+/* alloc_size (optional): bytes allocated for cropped image */
 BD_PRIVATE BD_PG_RLE_ELEM *rle_crop_object(const BD_PG_RLE_ELEM *orig, int width,
-                                           int crop_x, int crop_y, int crop_w, int crop_h);
+                                           int crop_x, int crop_y, int crop_w, int crop_h,
+                                           uint32_t *alloc_size);
 
 static inline void rle_begin(RLE_ENC *p)
 {
     p->num_elem = 1024;
     p->free_elem = 1024;
-    p->elem = refcnt_realloc(NULL, p->num_elem * sizeof(BD_PG_RLE_ELEM));
+    p->elem = refcnt_realloc(NULL, p->num_elem * sizeof(BD_PG_RLE_ELEM), NULL);
 
     p->elem->len = 0;
     p->elem->color = 0xffff;
@@ -133,7 +133,7 @@ static int _decode_dialog_region(BITBUFFER *bb, BD_TEXTST_DIALOG_REGION *p)
         uint8_t code = bb_read(bb, 8);
         bytes_read++;
         if (code != 0x1b) {
-            BD_DEBUG(DBG_DECODE, "_decode_dialog_region(): missing escape\n");
+            BD_DEBUG_HOT(DBG_DECODE, "_decode_dialog_region(): missing escape\n");
             continue;
         }
 
@@ -188,7 +188,7 @@ static int _decode_dialog_region(BITBUFFER *bb, BD_TEXTST_DIALOG_REGION *p)
             case BD_TEXTST_DATA_RESET_STYLE:
                 break;
             default:
-                BD_DEBUG(DBG_DECODE, "_decode_dialog_region(): unknown marker %d (len %d)\n", type, length);
+                BD_DEBUG_HOT(DBG_DECODE, "_decode_dialog_region(): unknown marker %d (len %d)\n", type, length);
                 bb_skip(bb, 8 * length);
                 continue;
         }
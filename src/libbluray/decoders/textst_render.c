@@ -26,6 +26,8 @@
 #include "libbluray/bluray.h"          /* bd_char_code_e */
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #ifdef HAVE_FT2
 #include <ft2build.h>
@@ -50,9 +52,53 @@ typedef struct {
 
   FT_Face  face;
   void    *mem;
+  size_t   size;
 
 } FONT_DATA;
 
+/*
+ * glyph cache
+ *
+ * Rendered glyphs (or glyph metrics only) are cached with LRU replacement.
+ * Key is (face, size, style flags, character).
+ */
+
+#define GLYPH_CACHE_BUCKETS   256
+#define GLYPH_CACHE_MAX_COUNT 1024          /* max. cached glyphs */
+#define GLYPH_CACHE_MAX_SIZE  (1024 * 1024) /* max. cached bitmap bytes */
+
+#define GLYPH_FLAG_RENDER  0x01  /* bitmap rendered */
+#define GLYPH_FLAG_BOLD    0x02  /* synthetic bold */
+#define GLYPH_FLAG_ITALIC  0x04  /* synthetic italic */
+
+typedef struct glyph_s GLYPH;
+struct glyph_s {
+  GLYPH     *hash_next;
+  GLYPH     *lru_prev;   /* more recently used */
+  GLYPH     *lru_next;   /* less recently used */
+
+  /* key */
+  FT_Face    face;
+  unsigned   char_code;
+  uint16_t   size;
+  uint8_t    flags;
+
+  /* glyph */
+  uint8_t    loaded;     /* 0 if FT_Load_Char() failed */
+  int        left, top;  /* bitmap position */
+  int        advance;
+  unsigned   width, rows;
+  uint8_t   *bitmap;     /* rows * width bytes */
+};
+
+typedef struct {
+  GLYPH     *hash[GLYPH_CACHE_BUCKETS];
+  GLYPH     *lru_head;
+  GLYPH     *lru_tail;
+  unsigned   count;
+  size_t     size;
+} GLYPH_CACHE;
+
 struct textst_render {
 
   FT_Library     ft_lib;
@@ -62,9 +108,158 @@ struct textst_render {
 
   bd_char_code_e char_code;
 
+  /* current face size */
+  FT_Face        size_face;
+  unsigned       size;
+
+  GLYPH_CACHE    glyphs;
 };
 #endif
 
+/*
+ * glyph cache
+ */
+
+#ifdef HAVE_FT2
+
+static unsigned _glyph_hash(FT_Face face, unsigned char_code, unsigned size, unsigned flags)
+{
+    uintptr_t h = (uintptr_t)face >> 4;
+    h = h * 31 + char_code;
+    h = h * 31 + size;
+    h = h * 31 + flags;
+    return (unsigned)(h % GLYPH_CACHE_BUCKETS);
+}
+
+static void _glyph_lru_unlink(GLYPH_CACHE *c, GLYPH *g)
+{
+    if (g->lru_prev) {
+        g->lru_prev->lru_next = g->lru_next;
+    } else {
+        c->lru_head = g->lru_next;
+    }
+    if (g->lru_next) {
+        g->lru_next->lru_prev = g->lru_prev;
+    } else {
+        c->lru_tail = g->lru_prev;
+    }
+    g->lru_prev = g->lru_next = NULL;
+}
+
+static void _glyph_lru_push(GLYPH_CACHE *c, GLYPH *g)
+{
+    g->lru_prev = NULL;
+    g->lru_next = c->lru_head;
+    if (c->lru_head) {
+        c->lru_head->lru_prev = g;
+    } else {
+        c->lru_tail = g;
+    }
+    c->lru_head = g;
+}
+
+static void _glyph_remove(GLYPH_CACHE *c, GLYPH *g)
+{
+    GLYPH **pp = &c->hash[_glyph_hash(g->face, g->char_code, g->size, g->flags)];
+
+    while (*pp && *pp != g) {
+        pp = &(*pp)->hash_next;
+    }
+    if (*pp) {
+        *pp = g->hash_next;
+    }
+
+    _glyph_lru_unlink(c, g);
+
+    c->count--;
+    c->size -= g->width * g->rows;
+
+    X_FREE(g->bitmap);
+    X_FREE(g);
+}
+
+static void _glyph_cache_clear(GLYPH_CACHE *c)
+{
+    while (c->lru_head) {
+        _glyph_remove(c, c->lru_head);
+    }
+}
+
+static const GLYPH *_glyph_get(TEXTST_RENDER *p, FT_Face face, unsigned char_code, unsigned flags)
+{
+    GLYPH_CACHE *c = &p->glyphs;
+    unsigned     h = _glyph_hash(face, char_code, p->size, flags);
+    GLYPH       *g;
+
+    for (g = c->hash[h]; g; g = g->hash_next) {
+        if (g->face == face && g->char_code == char_code && g->size == p->size && g->flags == flags) {
+            /* move to LRU head */
+            _glyph_lru_unlink(c, g);
+            _glyph_lru_push(c, g);
+            return g;
+        }
+    }
+
+    /* not cached, load glyph */
+
+    g = calloc(1, sizeof(*g));
+    if (!g) {
+        TEXTST_ERROR("out of memory\n");
+        return NULL;
+    }
+    g->face      = face;
+    g->char_code = char_code;
+    g->size      = p->size;
+    g->flags     = flags;
+
+    if (FT_Load_Char(face, char_code, (flags & GLYPH_FLAG_RENDER) ? FT_LOAD_RENDER : FT_LOAD_DEFAULT /*| FT_LOAD_MONOCHROME*/) == 0) {
+
+        if (flags & GLYPH_FLAG_BOLD) {
+            FT_GlyphSlot_Embolden( face->glyph );
+        }
+        if (flags & GLYPH_FLAG_ITALIC) {
+            FT_GlyphSlot_Oblique( face->glyph );
+        }
+
+        g->loaded  = 1;
+        g->advance = face->glyph->metrics.horiAdvance >> 6;
+
+        if ((flags & GLYPH_FLAG_RENDER) && face->glyph->bitmap.rows && face->glyph->bitmap.width) {
+            unsigned jj;
+
+            g->left = face->glyph->bitmap_left;
+            g->top  = face->glyph->bitmap_top;
+            g->bitmap = malloc(face->glyph->bitmap.rows * face->glyph->bitmap.width);
+            if (g->bitmap) {
+                g->width = face->glyph->bitmap.width;
+                g->rows  = face->glyph->bitmap.rows;
+                for (jj = 0; jj < g->rows; jj++) {
+                    memcpy(g->bitmap + jj * g->width,
+                           face->glyph->bitmap.buffer + jj * face->glyph->bitmap.pitch, g->width);
+                }
+            } else {
+                TEXTST_ERROR("out of memory\n");
+            }
+        }
+    }
+
+    /* enforce limits */
+    while (c->lru_tail && (c->count >= GLYPH_CACHE_MAX_COUNT ||
+                           c->size + g->width * g->rows > GLYPH_CACHE_MAX_SIZE)) {
+        _glyph_remove(c, c->lru_tail);
+    }
+
+    g->hash_next = c->hash[h];
+    c->hash[h] = g;
+    _glyph_lru_push(c, g);
+    c->count++;
+    c->size += g->width * g->rows;
+
+    return g;
+}
+
+#endif /* HAVE_FT2 */
+
 /*
  * init / free
  */
@@ -92,6 +287,8 @@ void textst_render_free(TEXTST_RENDER **pp)
 #ifdef HAVE_FT2
         TEXTST_RENDER *p = *pp;
 
+        _glyph_cache_clear(&p->glyphs);
+
         if (p->ft_lib) {
             /* free fonts */
             unsigned ii;
@@ -109,6 +306,27 @@ void textst_render_free(TEXTST_RENDER **pp)
     }
 }
 
+size_t textst_render_memory_size(const TEXTST_RENDER *p)
+{
+    size_t size = 0;
+
+#ifdef HAVE_FT2
+    if (p) {
+        unsigned ii;
+
+        size += sizeof(*p);
+        for (ii = 0; ii < p->font_count; ii++) {
+            size += sizeof(FONT_DATA) + p->font[ii].size;
+        }
+        size += p->glyphs.count * sizeof(GLYPH) + p->glyphs.size;
+    }
+#else
+    (void)p;
+#endif
+
+    return size;
+}
+
 /*
  * settings
  */
@@ -129,7 +347,8 @@ int textst_render_add_font(TEXTST_RENDER *p, void *data, size_t size)
     }
 
     if (!FT_New_Memory_Face(p->ft_lib, (const FT_Byte*)data, (FT_Long)size, 0, &p->font[p->font_count].face)) {
-        p->font[p->font_count].mem = data;
+        p->font[p->font_count].mem  = data;
+        p->font[p->font_count].size = size;
         p->font_count++;
         return 0;
     }
@@ -211,7 +430,7 @@ static unsigned _utf8_char_get(const uint8_t *s, int char_size)
 
 #ifdef HAVE_FT2
 
-static int _draw_string(FT_Face face, const uint8_t *string, int length,
+static int _draw_string(TEXTST_RENDER *p, FT_Face face, const uint8_t *string, int length,
                         TEXTST_BITMAP *bmp, int x, int y,
                         BD_TEXTST_REGION_STYLE *style,
                         int *baseline_pos)
@@ -220,15 +439,19 @@ static int _draw_string(FT_Face face, const uint8_t *string, int length,
     unsigned char_code;
     int      ii;
     unsigned jj, kk;
-    unsigned flags;
+    unsigned flags = 0;
 
     if (length <= 0) {
         return -1;
     }
-    if (!bmp) {
-        flags = FT_LOAD_DEFAULT;
-    } else {
-        flags = FT_LOAD_RENDER;
+    if (bmp) {
+        flags |= GLYPH_FLAG_RENDER;
+    }
+    if (style->font_style.bold && !(face->style_flags & FT_STYLE_FLAG_BOLD)) {
+        flags |= GLYPH_FLAG_BOLD;
+    }
+    if (style->font_style.italic && !(face->style_flags & FT_STYLE_FLAG_ITALIC)) {
+        flags |= GLYPH_FLAG_ITALIC;
     }
 
     for (ii = 0; ii < length; ii++) {
@@ -238,23 +461,21 @@ static int _draw_string(FT_Face face, const uint8_t *string, int length,
             ii += char_size - 1;
         /*}*/
 
-        if (FT_Load_Char(face, char_code, flags /*| FT_LOAD_MONOCHROME*/) == 0) {
+        const GLYPH *g = _glyph_get(p, face, char_code, flags);
 
-            if (style->font_style.bold && !(face->style_flags & FT_STYLE_FLAG_BOLD)) {
-                FT_GlyphSlot_Embolden( face->glyph );
-            }
-            if (style->font_style.italic && !(face->style_flags & FT_STYLE_FLAG_ITALIC)) {
-                FT_GlyphSlot_Oblique( face->glyph );
-            }
+        if (g && g->loaded) {
 
-            if (bmp) {
-                for (jj = 0; jj < face->glyph->bitmap.rows; jj++) {
-                    for (kk = 0; kk < face->glyph->bitmap.width; kk++) {
-                        uint8_t pixel = face->glyph->bitmap.buffer[jj * face->glyph->bitmap.pitch + kk];
-                        if (pixel & 0x80) {
-                            int xpos = x + face->glyph->bitmap_left + kk;
-                            int ypos = y - face->glyph->bitmap_top + jj;
-                            if (xpos >= 0 && xpos < bmp->width && ypos >= 0 && ypos < bmp->height) {
+            if (bmp && g->bitmap) {
+                for (jj = 0; jj < g->rows; jj++) {
+                    const uint8_t *src  = g->bitmap + jj * g->width;
+                    int            ypos = y - g->top + jj;
+                    if (ypos < 0 || ypos >= bmp->height) {
+                        continue;
+                    }
+                    for (kk = 0; kk < g->width; kk++) {
+                        if (src[kk] & 0x80) {
+                            int xpos = x + g->left + kk;
+                            if (xpos >= 0 && xpos < bmp->width) {
                                 bmp->mem[xpos + ypos * bmp->stride] = color;
                             }
                         }
@@ -267,7 +488,7 @@ static int _draw_string(FT_Face face, const uint8_t *string, int length,
                 *baseline_pos = BD_MAX(*baseline_pos, (face->size->metrics.ascender >> 6) + 1);
             }
 
-            x += face->glyph->metrics.horiAdvance >> 6;
+            x += g->advance;
         }
     }
 
@@ -284,7 +505,13 @@ static void _update_face(TEXTST_RENDER *p, FT_Face *face, const BD_TEXTST_REGION
     } else {
         *face = p->font[style->font_id_ref].face;
     }
-    FT_Set_Char_Size(*face, 0, style->font_size << 6, 0, 0);
+
+    /* face size is kept between regions and dialogs */
+    if (*face != p->size_face || style->font_size != p->size) {
+        FT_Set_Char_Size(*face, 0, style->font_size << 6, 0, 0);
+        p->size_face = *face;
+        p->size      = style->font_size;
+    }
 }
 
 static int _render_line(TEXTST_RENDER *p, TEXTST_BITMAP *bmp,
@@ -305,7 +532,7 @@ static int _render_line(TEXTST_RENDER *p, TEXTST_BITMAP *bmp,
 
         switch (elem->type) {
             case BD_TEXTST_DATA_STRING:
-                xpos = _draw_string(face, elem->data.text.string, elem->data.text.length,
+                xpos = _draw_string(p, face, elem->data.text.string, elem->data.text.length,
                                     bmp, xpos, ypos, style, baseline_pos);
                 (*p_ptr) += elem->data.text.length;
                 break;
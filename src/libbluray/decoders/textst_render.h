@@ -48,6 +48,9 @@ typedef struct {
 BD_PRIVATE TEXTST_RENDER *textst_render_init(void);
 BD_PRIVATE void           textst_render_free(TEXTST_RENDER **pp);
 
+/* font data and glyph cache (FreeType internal data is not included) */
+BD_PRIVATE size_t         textst_render_memory_size(const TEXTST_RENDER *p);
+
 /*
  *
  */
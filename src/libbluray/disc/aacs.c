@@ -37,12 +37,15 @@ struct bd_aacs {
 
     /* function pointers */
     fptr_int       decrypt_unit;
+    fptr_int       decrypt_units; /* optional, multi-unit decryption */
 
     fptr_p_void    get_vid;
     fptr_p_void    get_pmsn;
     fptr_p_void    get_device_binding_id;
     fptr_p_void    get_device_nonce;
     fptr_p_void    get_media_key;
+    fptr_p_void    get_unit_key;       /* optional, for decryptor plugins */
+    fptr_int       get_bus_encryption;
 };
 
 
@@ -114,11 +117,14 @@ BD_AACS *libaacs_load(void)
     BD_DEBUG(DBG_BLURAY, "Loading aacs library (%p)\n", p->h_libaacs);
 
     *(void **)(&p->decrypt_unit) = dl_dlsym(p->h_libaacs, "aacs_decrypt_unit");
+    *(void **)(&p->decrypt_units) = dl_dlsym(p->h_libaacs, "aacs_decrypt_units");
     *(void **)(&p->get_vid)      = dl_dlsym(p->h_libaacs, "aacs_get_vid");
     *(void **)(&p->get_pmsn)     = dl_dlsym(p->h_libaacs, "aacs_get_pmsn");
     *(void **)(&p->get_device_binding_id) = dl_dlsym(p->h_libaacs, "aacs_get_device_binding_id");
     *(void **)(&p->get_device_nonce)      = dl_dlsym(p->h_libaacs, "aacs_get_device_nonce");
     *(void **)(&p->get_media_key)         = dl_dlsym(p->h_libaacs, "aacs_get_mk");
+    *(void **)(&p->get_unit_key)          = dl_dlsym(p->h_libaacs, "aacs_get_unit_key");
+    *(void **)(&p->get_bus_encryption)    = dl_dlsym(p->h_libaacs, "aacs_get_bus_encryption");
 
     if (!p->decrypt_unit) {
         BD_DEBUG(DBG_BLURAY | DBG_CRIT, "libaacs dlsym failed! (%p)\n", p->h_libaacs);
@@ -126,7 +132,8 @@ BD_AACS *libaacs_load(void)
         return NULL;
     }
 
-    BD_DEBUG(DBG_BLURAY, "Loaded libaacs (%p)\n", p->h_libaacs);
+    BD_DEBUG(DBG_BLURAY, "Loaded libaacs (%p)%s\n", p->h_libaacs,
+             p->decrypt_units ? " (multi-unit decryption)" : "");
 
     if (file_open != file_open_default()) {
         BD_DEBUG(DBG_BLURAY, "Registering libaacs filesystem handler %p (%p)\n", (void *)(intptr_t)file_open, p->h_libaacs);
@@ -210,6 +217,28 @@ int libaacs_decrypt_unit(BD_AACS *p, uint8_t *buf)
     return 0;
 }
 
+int libaacs_decrypt_units(BD_AACS *p, uint8_t *buf, unsigned num_units)
+{
+    int result = 0;
+
+    if (p && p->aacs) {
+        if (p->decrypt_units) {
+            /* let the library process all units in one pass */
+            if (!p->decrypt_units(p->aacs, buf, num_units)) {
+                BD_DEBUG(DBG_AACS | DBG_CRIT, "Unable decrypt units (AACS)!\n");
+                return -1;
+            }
+            return 0;
+        }
+
+        for (; num_units > 0; num_units--, buf += 6144) {
+            result |= libaacs_decrypt_unit(p, buf);
+        }
+    }
+
+    return result;
+}
+
 /*
  *
  */
@@ -269,6 +298,27 @@ uint32_t libaacs_get_mkbv(BD_AACS *p)
     return p ? p->mkbv : 0;
 }
 
+int libaacs_get_bus_encryption(BD_AACS *p)
+{
+    if (!p || !p->aacs || !p->get_bus_encryption) {
+        return 0;
+    }
+    return p->get_bus_encryption(p->aacs);
+}
+
+const uint8_t *libaacs_get_unit_key(BD_AACS *p, uint32_t title)
+{
+    if (!p || !p->aacs) {
+        return NULL;
+    }
+    if (!p->get_unit_key) {
+        BD_DEBUG(DBG_BLURAY, "aacs_get_unit_key() not available\n");
+        return NULL;
+    }
+
+    return (const uint8_t*)p->get_unit_key(p->aacs, title);
+}
+
 static const char *_type2str(int type)
 {
     switch (type) {
@@ -36,9 +36,16 @@ BD_PRIVATE void libaacs_unload(BD_AACS **p);
 
 BD_PRIVATE void libaacs_select_title(BD_AACS *p, uint32_t title);
 BD_PRIVATE int  libaacs_decrypt_unit(BD_AACS *p, uint8_t *buf);
+BD_PRIVATE int  libaacs_decrypt_units(BD_AACS *p, uint8_t *buf, unsigned num_units);
 
 BD_PRIVATE uint32_t libaacs_get_mkbv(BD_AACS *p);
 
+/* non-zero if bus encryption is enabled (units can be decrypted only by libaacs) */
+BD_PRIVATE int  libaacs_get_bus_encryption(BD_AACS *p);
+
+/* CPS unit key (16 bytes) used for title. NULL if not available. */
+BD_PRIVATE const uint8_t *libaacs_get_unit_key(BD_AACS *p, uint32_t title);
+
 #define BD_AACS_DISC_ID            1
 #define BD_AACS_MEDIA_VID          2
 #define BD_AACS_MEDIA_PMSN         3
@@ -27,19 +27,455 @@
 #include "aacs.h"
 #include "bdplus.h"
 
+#include "libbluray/bluray.h"
+
 #include "file/file.h"
 #include "util/logging.h"
 #include "util/macro.h"
+#include "util/mutex.h"
 #include "util/strutl.h"
+#include "util/thread.h"
+#include "util/time.h"
 
+#include <inttypes.h>
+#include <stdio.h>   // SEEK_SET
 #include <string.h>
 
+/*
+ * AACS decryption worker pool
+ *
+ * Multi-unit reads are split to slices that are decrypted in parallel by
+ * the worker threads and the calling thread. Units are independent in AACS,
+ * and libaacs does not modify shared state when decrypting a unit.
+ */
+
+#define DEC_MAX_THREADS  32
+
+typedef struct {
+    BD_MUTEX   call_mutex; /* one job at a time */
+    BD_MUTEX   mutex;
+    BD_COND    work_cond;
+    BD_COND    done_cond;
+
+    unsigned   num_threads; /* configured number of decrypting threads */
+    unsigned   num_workers; /* running worker threads */
+    BD_THREAD  workers[DEC_MAX_THREADS];
+    int        exit;
+
+    /* current job */
+    BD_AACS   *aacs;
+    uint8_t   *buf;
+    unsigned   num_units;
+    unsigned   next_unit;  /* first unit not yet taken */
+    unsigned   slice;      /* units taken at once */
+    unsigned   pending;    /* units not yet decrypted */
+} DEC_POOL;
+
+/*
+ * Decryptor plugin
+ *
+ * Plugin context is per stream, so plugins need no locking. Context is
+ * re-created with the new unit key when the title changes.
+ */
+
+#define DEC_PLUGIN_CHUNK  (32 * 6144)  /* read size when decrypting asynchronously */
+
+static BD_DECRYPTOR decryptor;  /* set before opening discs */
+
+void dec_set_decryptor(const BD_DECRYPTOR *p)
+{
+    if (p && p->open && p->close && p->decrypt) {
+        decryptor = *p;
+        if (!decryptor.submit || !decryptor.wait) {
+            decryptor.submit = NULL;
+            decryptor.wait   = NULL;
+        }
+    } else {
+        if (p) {
+            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "decryptor plugin ignored (missing functions)\n");
+        }
+        memset(&decryptor, 0, sizeof(decryptor));
+    }
+}
+
+/*
+ * Shared AACS session
+ *
+ * BLURAY objects that have the same disc (and key file) open can share one
+ * libaacs instance, so AACS initialization and drive authentication are done
+ * only once. Keys are read-only after aacs_open(). The selected CPS unit
+ * (title) is the only mutable state: decryption with different titles is
+ * serialized, decryption with the same title runs in parallel.
+ *
+ * libbdplus is never shared: each BD_DEC has its own instance (it is bound to
+ * the player registers) and each stream its own BD+ context.
+ */
+
+#define DEC_NO_TITLE  0xffffffff
+
+typedef struct dec_session DEC_SESSION;
+struct dec_session {
+    DEC_SESSION *next;
+    char        *key;
+    unsigned     ref;      /* protected by session_lock */
+
+    BD_MUTEX     mutex;    /* locked by creator during initialization */
+    BD_COND      cond;
+    BD_AACS     *aacs;
+    int          result;   /* _libaacs_init() result */
+    BD_ENC_INFO  enc_info; /* AACS part of initialization result */
+    uint32_t     title;    /* currently selected title */
+    unsigned     active;   /* decrypt calls in progress */
+};
+
 struct bd_dec {
     int        use_menus;
     BD_AACS   *aacs;
     BD_BDPLUS *bdplus;
+    DEC_POOL   pool;
+
+    /* shared AACS session (aacs is owned by the session) */
+    int          shared;
+    DEC_SESSION *session;
+    uint32_t     aacs_title; /* title selected by this BD_DEC */
+
+    BD_DECRYPTOR decryptor;  /* plugin registered when BD_DEC was created */
+    uint32_t     cur_title;  /* last selected title (plugin unit key) */
+
+    /* deferred initialization (first stream open or key request) */
+    BD_MUTEX        init_mutex;
+    int             init_pending;
+    int             init_done;     /* deferred initialization has been run */
+    struct dec_dev  dev;
+    char           *root;
+    char           *device;
+    char           *keyfile_path;
+    void           *regs, *psr_read, *psr_write;
+    BD_ENC_INFO     enc_info;
+
+    /* events received before deferred initialization */
+    int             started;
+    uint32_t        num_titles;
+    int             title_set;
+    uint32_t        title;
 };
 
+/* mutex must be locked */
+static void _pool_run_slices(DEC_POOL *p)
+{
+    while (p->next_unit < p->num_units) {
+        unsigned first = p->next_unit;
+        unsigned count = BD_MIN(p->slice, p->num_units - first);
+        BD_AACS *aacs  = p->aacs;
+        uint8_t *buf   = p->buf + (size_t)first * 6144;
+
+        p->next_unit += count;
+        bd_mutex_unlock(&p->mutex);
+
+        if (libaacs_decrypt_units(aacs, buf, count)) {
+            /* failure is detected from TP header */
+        }
+
+        bd_mutex_lock(&p->mutex);
+        p->pending -= count;
+        if (!p->pending) {
+            bd_cond_signal(&p->done_cond);
+        }
+    }
+}
+
+static void *_pool_worker(void *arg)
+{
+    DEC_POOL *p = (DEC_POOL *)arg;
+
+    bd_mutex_lock(&p->mutex);
+
+    while (!p->exit) {
+        if (p->next_unit < p->num_units) {
+            _pool_run_slices(p);
+        } else {
+            bd_cond_wait(&p->work_cond, &p->mutex);
+        }
+    }
+
+    bd_mutex_unlock(&p->mutex);
+
+    return NULL;
+}
+
+static void _pool_init(DEC_POOL *p)
+{
+    bd_mutex_init(&p->call_mutex);
+    bd_mutex_init(&p->mutex);
+    bd_cond_init(&p->work_cond);
+    bd_cond_init(&p->done_cond);
+}
+
+/* call_mutex must be locked */
+static void _pool_stop(DEC_POOL *p)
+{
+    unsigned ii;
+
+    if (!p->num_workers) {
+        return;
+    }
+
+    bd_mutex_lock(&p->mutex);
+    p->exit = 1;
+    bd_cond_broadcast(&p->work_cond);
+    bd_mutex_unlock(&p->mutex);
+
+    for (ii = 0; ii < p->num_workers; ii++) {
+        bd_thread_join(&p->workers[ii]);
+    }
+
+    p->num_workers = 0;
+    p->exit        = 0;
+}
+
+/* call_mutex must be locked */
+static void _pool_start(DEC_POOL *p)
+{
+    while (p->num_workers + 1 < p->num_threads) {
+        if (bd_thread_create(&p->workers[p->num_workers], "bd_decrypt", _pool_worker, p) < 0) {
+            BD_DEBUG(DBG_BLURAY | DBG_CRIT, "failed creating AACS decryption thread\n");
+            break;
+        }
+        p->num_workers++;
+    }
+
+    BD_DEBUG(DBG_BLURAY, "AACS decryption using %u worker threads\n", p->num_workers);
+}
+
+static void _pool_close(DEC_POOL *p)
+{
+    bd_mutex_lock(&p->call_mutex);
+    _pool_stop(p);
+    bd_mutex_unlock(&p->call_mutex);
+
+    bd_cond_destroy(&p->done_cond);
+    bd_cond_destroy(&p->work_cond);
+    bd_mutex_destroy(&p->mutex);
+    bd_mutex_destroy(&p->call_mutex);
+}
+
+/* returns 0 if units were not decrypted */
+static int _pool_decrypt(DEC_POOL *p, BD_AACS *aacs, uint8_t *buf, unsigned num_units)
+{
+    if (!p || p->num_threads < 2 || num_units < 2) {
+        return 0;
+    }
+
+    bd_mutex_lock(&p->call_mutex);
+
+    if (!p->num_workers) {
+        _pool_start(p);
+        if (!p->num_workers) {
+            p->num_threads = 0;
+            bd_mutex_unlock(&p->call_mutex);
+            return 0;
+        }
+    }
+
+    bd_mutex_lock(&p->mutex);
+
+    p->aacs      = aacs;
+    p->buf       = buf;
+    p->num_units = num_units;
+    p->next_unit = 0;
+    p->pending   = num_units;
+    p->slice     = (num_units + p->num_workers) / (p->num_workers + 1);
+
+    bd_cond_broadcast(&p->work_cond);
+
+    /* take part in decrypting */
+    _pool_run_slices(p);
+
+    while (p->pending) {
+        bd_cond_wait(&p->done_cond, &p->mutex);
+    }
+
+    p->aacs      = NULL;
+    p->buf       = NULL;
+    p->num_units = 0;
+    p->next_unit = 0;
+
+    bd_mutex_unlock(&p->mutex);
+    bd_mutex_unlock(&p->call_mutex);
+
+    return 1;
+}
+
+/*
+ * shared AACS session
+ */
+
+static BD_MUTEX     session_lock;   /* protects sessions and DEC_SESSION.ref. Initialized on first use. */
+static DEC_SESSION *sessions;
+
+static int _session_lock(void)
+{
+    if (bd_mutex_init_once(&session_lock) < 0) {
+        return -1;
+    }
+    return bd_mutex_lock(&session_lock);
+}
+
+static void _session_unlock(void)
+{
+    bd_mutex_unlock(&session_lock);
+}
+
+static void _session_free(DEC_SESSION **ps)
+{
+    if (ps && *ps) {
+        DEC_SESSION *s = *ps;
+        libaacs_unload(&s->aacs);
+        bd_cond_destroy(&s->cond);
+        bd_mutex_destroy(&s->mutex);
+        X_FREE(s->key);
+        X_FREE(*ps);
+    }
+}
+
+static DEC_SESSION *_session_new(const char *key)
+{
+    DEC_SESSION *s = calloc(1, sizeof(DEC_SESSION));
+    if (s) {
+        s->key = str_dup(key);
+        if (!s->key) {
+            X_FREE(s);
+            return NULL;
+        }
+        s->ref   = 1;
+        s->title = DEC_NO_TITLE;
+        bd_mutex_init(&s->mutex);
+        bd_cond_init(&s->cond);
+    }
+    return s;
+}
+
+/* returns session for key (new reference). New session (*created = 1) is returned locked. */
+static DEC_SESSION *_session_get(const char *key, int *created)
+{
+    DEC_SESSION *s, *n = NULL;
+
+    *created = 0;
+
+    while (1) {
+        if (_session_lock() < 0) {
+            if (n) {
+                bd_mutex_unlock(&n->mutex);
+                _session_free(&n);
+            }
+            return NULL;
+        }
+        for (s = sessions; s; s = s->next) {
+            if (!strcmp(s->key, key)) {
+                s->ref++;
+                break;
+            }
+        }
+        if (!s && n) {
+            n->next  = sessions;
+            sessions = n;
+            s = n;
+            n = NULL;
+            *created = 1;
+        }
+        _session_unlock();
+
+        if (s) {
+            /* lost race to another thread ? */
+            if (n) {
+                bd_mutex_unlock(&n->mutex);
+                _session_free(&n);
+            }
+            return s;
+        }
+
+        /* allocate outside of lock */
+        n = _session_new(key);
+        if (!n) {
+            return NULL;
+        }
+        bd_mutex_lock(&n->mutex);
+    }
+}
+
+static void _session_release(DEC_SESSION **ps)
+{
+    DEC_SESSION  *s = *ps;
+    DEC_SESSION **pn;
+    unsigned      ref;
+
+    if (!s) {
+        return;
+    }
+    *ps = NULL;
+
+    /* session was registered, so the lock has been initialized */
+    _session_lock();
+    ref = --s->ref;
+    if (!ref) {
+        for (pn = &sessions; *pn; pn = &(*pn)->next) {
+            if (*pn == s) {
+                *pn = s->next;
+                break;
+            }
+        }
+    }
+    _session_unlock();
+
+    if (ref) {
+        return;
+    }
+
+    BD_DEBUG(DBG_BLURAY, "Closing shared AACS session\n");
+    _session_free(&s);
+}
+
+/* select title and mark decryption active */
+static void _session_enter(DEC_SESSION *s, uint32_t title)
+{
+    bd_mutex_lock(&s->mutex);
+
+    if (title != DEC_NO_TITLE) {
+        /* wait until units of other title have been decrypted */
+        while (s->title != title && s->active) {
+            bd_cond_wait(&s->cond, &s->mutex);
+        }
+        if (s->title != title) {
+            libaacs_select_title(s->aacs, title);
+            s->title = title;
+        }
+    }
+    s->active++;
+
+    bd_mutex_unlock(&s->mutex);
+}
+
+static void _session_leave(DEC_SESSION *s)
+{
+    bd_mutex_lock(&s->mutex);
+    if (!--s->active) {
+        bd_cond_broadcast(&s->cond);
+    }
+    bd_mutex_unlock(&s->mutex);
+}
+
+static void _select_title(BD_DEC *dec, uint32_t title)
+{
+    dec->cur_title = title;
+
+    if (dec->session) {
+        /* applied when next unit is decrypted */
+        dec->aacs_title = title;
+    } else {
+        libaacs_select_title(dec->aacs, title);
+    }
+}
+
 /*
  * stream
  */
@@ -47,45 +483,268 @@ struct bd_dec {
 typedef struct {
     BD_FILE_H    *fp;
     BD_AACS      *aacs;
+    BD_DEC       *dec;
+    DEC_POOL     *pool;
     BD_BDPLUS_ST *bdplus;
+    int64_t       pos;        /* current position of fp */
+    int64_t       bdplus_pos; /* stream position expected by libbdplus */
+    DEC_STATS    *stats;
+
+    /* decryptor plugin (NULL if libaacs is used) */
+    const BD_DECRYPTOR *plugin;
+    void         *plugin_ctx;
+    int           plugin_open;  /* plugin_ctx is valid for plugin_title */
+    uint32_t      plugin_title;
 } DEC_STREAM;
 
+static void _plugin_close(DEC_STREAM *st)
+{
+    if (st->plugin_ctx) {
+        st->plugin->close(st->plugin_ctx);
+        st->plugin_ctx = NULL;
+    }
+}
+
+/* returns plugin context for current title, NULL if libaacs must be used */
+static void *_plugin_ctx(DEC_STREAM *st)
+{
+    uint32_t title = st->dec->cur_title;
+    const uint8_t *key;
+
+    if (st->plugin_open && st->plugin_title == title) {
+        return st->plugin_ctx;
+    }
+
+    _plugin_close(st);
+    st->plugin_open  = 1;
+    st->plugin_title = title;
+
+    key = libaacs_get_unit_key(st->aacs, title);
+    if (key) {
+        st->plugin_ctx = st->plugin->open(st->plugin->handle, key);
+    }
+    if (!st->plugin_ctx) {
+        BD_DEBUG(DBG_BLURAY, "decryptor plugin not used for title %u\n", title);
+    }
+
+    return st->plugin_ctx;
+}
+
+/* AACS decryption with libaacs */
+static void _decrypt_aacs(DEC_STREAM *st, uint8_t *buf, unsigned num_units)
+{
+    if (st->dec->session) {
+        _session_enter(st->dec->session, st->dec->aacs_title);
+    }
+    if (!_pool_decrypt(st->pool, st->aacs, buf, num_units)) {
+        if (libaacs_decrypt_units(st->aacs, buf, num_units)) {
+            /* failure is detected from TP header */
+        }
+    }
+    if (st->dec->session) {
+        _session_leave(st->dec->session);
+    }
+}
+
+/* short read: incomplete aligned unit at the end can't be decrypted, drop it */
+static int64_t _whole_units(int64_t result)
+{
+    if (result > 0 && result % 6144) {
+        BD_DEBUG(DBG_CRIT, "read %"PRId64" bytes, incomplete aligned unit dropped\n", result);
+        result -= result % 6144;
+    }
+    return result;
+}
+
+/* aacs_done: AACS decryption was already done while reading (asynchronous plugin) */
+static int64_t _decrypt(DEC_STREAM *st, uint8_t *buf, int64_t result, int aacs_done)
+{
+    unsigned num_units = (unsigned)(result / 6144);
+    uint64_t t0 = 0, t1;
+
+    if (st->stats) {
+        t0 = bd_get_time_us();
+    }
+
+    if (st->aacs && !aacs_done) {
+        void *ctx = st->plugin ? _plugin_ctx(st) : NULL;
+        if (!ctx) {
+            _decrypt_aacs(st, buf, num_units);
+        } else if (st->plugin->decrypt(ctx, buf, num_units) < 0) {
+            BD_DEBUG(DBG_AACS | DBG_CRIT, "Unable decrypt units (decryptor plugin)!\n");
+        }
+    }
+
+    if (st->stats && st->aacs && !aacs_done) {
+        t1 = bd_get_time_us();
+        st->stats->decrypt_time += t1 - t0;
+        BD_TRACE(st->stats->trace, BD_TRACE_DECRYPT, num_units, (uint32_t)(t1 - t0));
+        t0 = t1;
+    }
+
+    if (st->bdplus) {
+        if (libbdplus_fixup(st->bdplus, buf, (int)result) < 0) {
+          /* there's no way to verify if the stream was decoded correctly */
+        }
+        st->bdplus_pos += result;
+
+        if (st->stats) {
+            st->stats->bdplus_time += bd_get_time_us() - t0;
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Read and decrypt in chunks with asynchronous plugin: next chunk is read
+ * while previous chunks are being decrypted.
+ * offset < 0: sequential read. Returns bytes read, *done = 1 if AACS
+ * decryption was done.
+ */
+static int64_t _read_async(DEC_STREAM *st, int64_t offset, uint8_t *buf, int64_t size, int *done)
+{
+    void    *ctx = NULL;
+    int64_t  pos = 0, got = 0;
+    int      submitted = 0;
+    uint64_t t0, wait_time = 0;
+
+    *done = 0;
+
+    if (st->aacs && st->plugin && st->plugin->submit && size > DEC_PLUGIN_CHUNK) {
+        ctx = _plugin_ctx(st);
+    }
+    if (!ctx) {
+        return offset < 0 ? st->fp->read(st->fp, buf, size) : file_read_at(st->fp, offset, buf, size);
+    }
+
+    while (pos < size) {
+        int64_t len = BD_MIN(size - pos, DEC_PLUGIN_CHUNK);
+
+        got = offset < 0 ? st->fp->read(st->fp, buf + pos, len) : file_read_at(st->fp, offset + pos, buf + pos, len);
+        if (got <= 0) {
+            break;
+        }
+
+        if (got >= 6144) {
+            unsigned num_units = (unsigned)(got / 6144);
+
+            t0 = st->stats ? bd_get_time_us() : 0;
+            if (st->plugin->submit(ctx, buf + pos, num_units) < 0) {
+                /* decrypt synchronously */
+                if (st->plugin->decrypt(ctx, buf + pos, num_units) < 0) {
+                    BD_DEBUG(DBG_AACS | DBG_CRIT, "Unable decrypt units (decryptor plugin)!\n");
+                }
+            } else {
+                submitted = 1;
+            }
+            if (st->stats) {
+                wait_time += bd_get_time_us() - t0;
+            }
+        }
+
+        pos += got;
+        if (got < len) {
+            break;
+        }
+    }
+
+    if (submitted) {
+        t0 = st->stats ? bd_get_time_us() : 0;
+        if (st->plugin->wait(ctx) < 0) {
+            BD_DEBUG(DBG_AACS | DBG_CRIT, "Unable decrypt units (decryptor plugin)!\n");
+        }
+        if (st->stats) {
+            wait_time += bd_get_time_us() - t0;
+        }
+    }
+
+    if (st->stats) {
+        st->stats->decrypt_time += wait_time;
+        BD_TRACE(st->stats->trace, BD_TRACE_DECRYPT, (unsigned)(pos / 6144), (uint32_t)wait_time);
+    }
+
+    *done = 1;
+    return pos > 0 ? pos : got;
+}
+
 static int64_t _stream_read(BD_FILE_H *fp, uint8_t *buf, int64_t size)
 {
     DEC_STREAM *st = (DEC_STREAM *)fp->internal;
     int64_t     result;
+    int         aacs_done;
 
-    if (size != 6144) {
+    /* size must be multiple of aligned unit size (one or more units) */
+    if (size <= 0 || size % 6144) {
         BD_DEBUG(DBG_CRIT, "read size != unit size\n");
         return 0;
     }
 
-    result = st->fp->read(st->fp, buf, size);
+    if (st->bdplus && st->bdplus_pos != st->pos) {
+        /* previous read was positional */
+        st->bdplus_pos = st->pos;
+        libbdplus_seek(st->bdplus, st->pos);
+    }
+
+    result = _read_async(st, -1, buf, size, &aacs_done);
     if (result <= 0) {
         return result;
     }
-
-    if (st->aacs) {
-        if (libaacs_decrypt_unit(st->aacs, buf)) {
-            /* failure is detected from TP header */
+    if (result % 6144) {
+        /* next read must start from unit boundary */
+        result = _whole_units(result);
+        if (st->fp->seek(st->fp, st->pos + result, SEEK_SET) < 0) {
+            BD_DEBUG(DBG_CRIT, "seek to aligned unit boundary failed\n");
+        }
+        if (!result) {
+            return 0;
         }
     }
+    st->pos += result;
 
-    if (st->bdplus) {
-        if (libbdplus_fixup(st->bdplus, buf, (int)size) < 0) {
-          /* there's no way to verify if the stream was decoded correctly */
-        }
+    return _decrypt(st, buf, result, aacs_done);
+}
+
+static int64_t _stream_read_at(BD_FILE_H *fp, int64_t offset, uint8_t *buf, int64_t size)
+{
+    DEC_STREAM *st = (DEC_STREAM *)fp->internal;
+    int64_t     result;
+    int         aacs_done;
+
+    if (size <= 0 || size % 6144) {
+        BD_DEBUG(DBG_CRIT, "read size != unit size\n");
+        return 0;
     }
 
-    return result;
+    if (st->bdplus && st->bdplus_pos != offset) {
+        st->bdplus_pos = offset;
+        libbdplus_seek(st->bdplus, offset);
+    }
+
+    result = _whole_units(_read_async(st, offset, buf, size, &aacs_done));
+    if (result <= 0) {
+        return result;
+    }
+
+    return _decrypt(st, buf, result, aacs_done);
+}
+
+static void _stream_prefetch(BD_FILE_H *fp, int64_t offset, int64_t size)
+{
+    DEC_STREAM *st = (DEC_STREAM *)fp->internal;
+    file_prefetch(st->fp, offset, size);
 }
 
 static int64_t _stream_seek(BD_FILE_H *fp, int64_t offset, int32_t origin)
 {
     DEC_STREAM *st = (DEC_STREAM *)fp->internal;
     int64_t result = st->fp->seek(st->fp, offset, origin);
-    if (result >= 0 && st->bdplus) {
-        libbdplus_seek(st->bdplus, st->fp->tell(st->fp));
+    if (result >= 0) {
+        st->pos = st->fp->tell(st->fp);
+        if (st->bdplus) {
+            st->bdplus_pos = st->pos;
+            libbdplus_seek(st->bdplus, st->pos);
+        }
     }
     return result;
 }
@@ -102,15 +761,26 @@ static void _stream_close(BD_FILE_H *fp)
     if (st->bdplus) {
         libbdplus_m2ts_close(&st->bdplus);
     }
+    _plugin_close(st);
     st->fp->close(st->fp);
     X_FREE(fp->internal);
     X_FREE(fp);
 }
 
-BD_FILE_H *dec_open_stream(BD_DEC *dec, BD_FILE_H *fp, uint32_t clip_id)
+static void _dec_lazy_init(BD_DEC *dec);
+
+BD_FILE_H *dec_open_stream(BD_DEC *dec, BD_FILE_H *fp, uint32_t clip_id, DEC_STATS *stats)
 {
     DEC_STREAM *st;
-    BD_FILE_H  *p = calloc(1, sizeof(BD_FILE_H));
+    BD_FILE_EXT_H *p;
+
+    _dec_lazy_init(dec);
+    if (!dec->aacs && !dec->bdplus) {
+        /* nothing to decode */
+        return NULL;
+    }
+
+    p = file_ext_alloc();
     if (!p) {
         return NULL;
     }
@@ -120,7 +790,9 @@ BD_FILE_H *dec_open_stream(BD_DEC *dec, BD_FILE_H *fp, uint32_t clip_id)
         X_FREE(p);
         return NULL;
     }
-    st->fp = fp;
+    st->fp    = fp;
+    st->pos   = fp->tell(fp);
+    st->stats = stats;
 
     if (dec->bdplus) {
         st->bdplus = libbdplus_m2ts(dec->bdplus, clip_id, 0);
@@ -128,19 +800,30 @@ BD_FILE_H *dec_open_stream(BD_DEC *dec, BD_FILE_H *fp, uint32_t clip_id)
 
     if (dec->aacs) {
         st->aacs = dec->aacs;
+        st->dec  = dec;
+        st->pool = &dec->pool;
+        if (dec->decryptor.decrypt) {
+            if (libaacs_get_bus_encryption(dec->aacs)) {
+                BD_DEBUG(DBG_BLURAY, "bus encryption enabled, decryptor plugin not used\n");
+            } else {
+                st->plugin = &dec->decryptor;
+            }
+        }
         if (!dec->use_menus) {
             /* There won't be title events --> need to manually reset AACS CPS */
-            libaacs_select_title(dec->aacs, 0xffff);
+            _select_title(dec, 0xffff);
         }
     }
 
-    p->internal = st;
-    p->read  = _stream_read;
-    p->seek  = _stream_seek;
-    p->tell  = _stream_tell;
-    p->close = _stream_close;
+    p->h.internal = st;
+    p->h.read  = _stream_read;
+    p->h.seek  = _stream_seek;
+    p->h.tell  = _stream_tell;
+    p->h.close = _stream_close;
+    p->read_at = _stream_read_at;
+    p->prefetch = _stream_prefetch;
 
-    return p;
+    return &p->h;
 }
 
 /*
@@ -155,11 +838,12 @@ static int _bdrom_have_file(void *p, const char *dir, const char *file)
 {
     struct dec_dev *dev = (struct dec_dev *)p;
     BD_FILE_H *fp;
+    char buf[STR_PATH_BUF_SIZE];
     char *path;
 
-    path = str_printf("%s" DIR_SEP "%s", dir, file);
+    path = str_cat3(buf, sizeof(buf), dir, DIR_SEP, file);
     fp = dev->pf_file_open_bdrom(dev->file_open_bdrom_handle, path);
-    X_FREE(path);
+    str_cat_free(buf, path);
 
     if (fp) {
         file_close(fp);
@@ -169,13 +853,13 @@ static int _bdrom_have_file(void *p, const char *dir, const char *file)
     return 0;
 }
 
-static int _libaacs_init(BD_DEC *dec, struct dec_dev *dev,
+static int _libaacs_init(BD_AACS **paacs, struct dec_dev *dev,
                          BD_ENC_INFO *i, const char *keyfile_path)
 {
     int result;
     const uint8_t *disc_id;
 
-    libaacs_unload(&dec->aacs);
+    libaacs_unload(paacs);
 
     i->aacs_detected = libaacs_required((void*)dev, _bdrom_have_file);
     if (!i->aacs_detected) {
@@ -183,26 +867,26 @@ static int _libaacs_init(BD_DEC *dec, struct dec_dev *dev,
         return 1; /* no error if libaacs is not needed */
     }
 
-    dec->aacs = libaacs_load();
-    i->libaacs_detected = !!dec->aacs;
-    if (!dec->aacs) {
+    *paacs = libaacs_load();
+    i->libaacs_detected = !!*paacs;
+    if (!*paacs) {
         /* no libaacs */
         return 0;
     }
 
-    result = libaacs_open(dec->aacs, dev->device, dev->file_open_vfs_handle, (void*)dev->pf_file_open_vfs, keyfile_path);
+    result = libaacs_open(*paacs, dev->device, dev->file_open_vfs_handle, (void*)dev->pf_file_open_vfs, keyfile_path);
 
     i->aacs_error_code = result;
     i->aacs_handled    = !result;
-    i->aacs_mkbv       = libaacs_get_mkbv(dec->aacs);
-    disc_id = libaacs_get_aacs_data(dec->aacs, BD_AACS_DISC_ID);
+    i->aacs_mkbv       = libaacs_get_mkbv(*paacs);
+    disc_id = libaacs_get_aacs_data(*paacs, BD_AACS_DISC_ID);
     if (disc_id) {
         memcpy(i->disc_id, disc_id, 20);
     }
 
     if (result) {
         BD_DEBUG(DBG_BLURAY | DBG_CRIT, "aacs_open() failed!\n");
-        libaacs_unload(&dec->aacs);
+        libaacs_unload(paacs);
         return 0;
     }
 
@@ -210,6 +894,54 @@ static int _libaacs_init(BD_DEC *dec, struct dec_dev *dev,
     return 1;
 }
 
+static int _dec_aacs_init(BD_DEC *dec, struct dec_dev *dev,
+                          BD_ENC_INFO *i, const char *keyfile_path)
+{
+    DEC_SESSION *s = NULL;
+    int          created = 0;
+    int          result;
+
+    if (dec->shared && dev->device) {
+        char *key = str_printf("%s\n%s", dev->device, keyfile_path ? keyfile_path : "");
+        if (key) {
+            s = _session_get(key, &created);
+            X_FREE(key);
+        }
+    }
+    if (!s) {
+        return _libaacs_init(&dec->aacs, dev, i, keyfile_path);
+    }
+
+    if (created) {
+        /* libaacs reads disc files only when opening. Session may outlive this BD_DEC. */
+        s->result = _libaacs_init(&s->aacs, dev, &s->enc_info, keyfile_path);
+        BD_DEBUG(DBG_BLURAY, "Created shared AACS session\n");
+    } else {
+        /* wait until creator has initialized the session */
+        bd_mutex_lock(&s->mutex);
+        BD_DEBUG(DBG_BLURAY, "Using shared AACS session\n");
+    }
+    bd_mutex_unlock(&s->mutex);
+
+    i->aacs_detected    = s->enc_info.aacs_detected;
+    i->libaacs_detected = s->enc_info.libaacs_detected;
+    i->aacs_handled     = s->enc_info.aacs_handled;
+    i->aacs_error_code  = s->enc_info.aacs_error_code;
+    i->aacs_mkbv        = s->enc_info.aacs_mkbv;
+    memcpy(i->disc_id, s->enc_info.disc_id, sizeof(i->disc_id));
+    result = s->result;
+
+    if (!s->aacs) {
+        _session_release(&s);
+        return result;
+    }
+
+    dec->session    = s;
+    dec->aacs       = s->aacs;
+    dec->aacs_title = DEC_NO_TITLE;
+    return result;
+}
+
 static int _libbdplus_init(BD_DEC *dec, struct dec_dev *dev,
                            BD_ENC_INFO *i,
                            void *regs, void *psr_read, void *psr_write)
@@ -262,29 +994,136 @@ static int _libbdplus_init(BD_DEC *dec, struct dec_dev *dev,
  *
  */
 
+/* store everything needed for initialization later */
+static BD_DEC *_dec_init_lazy(struct dec_dev *dev, BD_ENC_INFO *enc_info,
+                              const char *keyfile_path,
+                              void *regs, void *psr_read, void *psr_write,
+                              int shared)
+{
+    BD_DEC *dec;
+
+    /* detection does not need libaacs or libbdplus */
+    enc_info->aacs_detected   = libaacs_required((void*)dev, _bdrom_have_file);
+    enc_info->bdplus_detected = libbdplus_required((void*)dev, _bdrom_have_file);
+    if (!enc_info->aacs_detected && !enc_info->bdplus_detected) {
+        return NULL;
+    }
+
+    dec = calloc(1, sizeof(BD_DEC));
+    if (!dec) {
+        return NULL;
+    }
+
+    dec->dev          = *dev;
+    dec->root         = dev->root   ? str_dup(dev->root)   : NULL;
+    dec->device       = dev->device ? str_dup(dev->device) : NULL;
+    dec->keyfile_path = keyfile_path ? str_dup(keyfile_path) : NULL;
+    dec->dev.root     = dec->root;
+    dec->dev.device   = dec->device;
+    dec->regs         = regs;
+    dec->psr_read     = psr_read;
+    dec->psr_write    = psr_write;
+    dec->shared       = shared;
+    dec->decryptor    = decryptor;
+    dec->init_pending = 1;
+    bd_mutex_init(&dec->init_mutex);
+    _pool_init(&dec->pool);
+
+    BD_DEBUG(DBG_BLURAY, "AACS/BD+ initialization deferred until first stream is opened\n");
+    return dec;
+}
+
+static void _dec_lazy_init(BD_DEC *dec)
+{
+    if (!dec->init_pending) {
+        return;
+    }
+
+    bd_mutex_lock(&dec->init_mutex);
+
+    if (dec->init_pending) {
+        uint64_t t0 = bd_get_time_us();
+
+        _dec_aacs_init(dec, &dec->dev, &dec->enc_info, dec->keyfile_path);
+        _libbdplus_init(dec, &dec->dev, &dec->enc_info, dec->regs, dec->psr_read, dec->psr_write);
+
+        BD_DEBUG(DBG_BLURAY, "deferred AACS/BD+ initialization took %"PRIu64" ms\n", (bd_get_time_us() - t0) / 1000);
+
+        /* replay status events */
+        if (dec->started) {
+            dec_start(dec, dec->num_titles);
+        }
+        if (dec->title_set) {
+            dec_title(dec, dec->title);
+        }
+
+        dec->init_done    = 1;
+        dec->init_pending = 0;
+    }
+
+    bd_mutex_unlock(&dec->init_mutex);
+}
+
 BD_DEC *dec_init(struct dec_dev *dev, BD_ENC_INFO *enc_info,
                  const char *keyfile_path,
-                 void *regs, void *psr_read, void *psr_write)
+                 void *regs, void *psr_read, void *psr_write,
+                 int flags)
 {
-    BD_DEC *dec = calloc(1, sizeof(BD_DEC));
+    BD_DEC *dec;
+
+    memset(enc_info, 0, sizeof(*enc_info));
+
+    if (flags & DEC_INIT_LAZY) {
+        return _dec_init_lazy(dev, enc_info, keyfile_path, regs, psr_read, psr_write,
+                              !!(flags & DEC_INIT_SHARED));
+    }
+
+    dec = calloc(1, sizeof(BD_DEC));
     if (dec) {
-        memset(enc_info, 0, sizeof(*enc_info));
-        _libaacs_init(dec, dev, enc_info, keyfile_path);
+        dec->shared    = !!(flags & DEC_INIT_SHARED);
+        dec->decryptor = decryptor;
+        _dec_aacs_init(dec, dev, enc_info, keyfile_path);
         _libbdplus_init(dec, dev, enc_info, regs, psr_read, psr_write);
 
         if (!enc_info->bdplus_handled && !enc_info->aacs_handled) {
             X_FREE(dec);
+        } else {
+            bd_mutex_init(&dec->init_mutex);
+            _pool_init(&dec->pool);
         }
     }
     return dec;
 }
 
+int dec_get_enc_info(BD_DEC *dec, BD_ENC_INFO *enc_info)
+{
+    int result = 0;
+
+    bd_mutex_lock(&dec->init_mutex);
+    if (dec->init_done) {
+        *enc_info = dec->enc_info;
+        result = 1;
+    }
+    bd_mutex_unlock(&dec->init_mutex);
+
+    return result;
+}
+
 void dec_close(BD_DEC **pp)
 {
     if (pp && *pp) {
         BD_DEC *p = *pp;
+        _pool_close(&p->pool);
+        if (p->session) {
+            p->aacs = NULL;
+            _session_release(&p->session);
+        }
         libaacs_unload(&p->aacs);
         libbdplus_unload(&p->bdplus);
+        bd_mutex_destroy(&p->init_mutex);
+        X_FREE(p->root);
+        X_FREE(p->device);
+        X_FREE(p->keyfile_path);
         X_FREE(*pp);
     }
 }
@@ -295,14 +1134,42 @@ void dec_close(BD_DEC **pp)
 
 const uint8_t *dec_data(BD_DEC *dec, int type)
 {
+    /* keys requested */
+    _dec_lazy_init(dec);
+
     if (dec->aacs) {
         return libaacs_get_aacs_data(dec->aacs, type);
     }
     return NULL;
 }
 
+void dec_set_threads(BD_DEC *dec, unsigned num_threads)
+{
+    DEC_POOL *p = &dec->pool;
+
+    bd_mutex_lock(&p->call_mutex);
+
+    /* workers are (re-)started when next multi-unit block is decrypted */
+    _pool_stop(p);
+    p->num_threads = BD_MIN(num_threads, DEC_MAX_THREADS + 1);
+
+    bd_mutex_unlock(&p->call_mutex);
+}
+
 void dec_start(BD_DEC *dec, uint32_t num_titles)
 {
+    if (dec->init_pending) {
+        bd_mutex_lock(&dec->init_mutex);
+        if (dec->init_pending) {
+            dec->started    = 1;
+            dec->num_titles = num_titles;
+            dec->use_menus  = (num_titles == 0);
+            bd_mutex_unlock(&dec->init_mutex);
+            return;
+        }
+        bd_mutex_unlock(&dec->init_mutex);
+    }
+
     if (num_titles == 0) {
         dec->use_menus = 1;
         if (dec->bdplus) {
@@ -318,8 +1185,19 @@ void dec_start(BD_DEC *dec, uint32_t num_titles)
 
 void dec_title(BD_DEC *dec, uint32_t title)
 {
+    if (dec->init_pending) {
+        bd_mutex_lock(&dec->init_mutex);
+        if (dec->init_pending) {
+            dec->title_set = 1;
+            dec->title     = title;
+            bd_mutex_unlock(&dec->init_mutex);
+            return;
+        }
+        bd_mutex_unlock(&dec->init_mutex);
+    }
+
     if (dec->aacs) {
-        libaacs_select_title(dec->aacs, title);
+        _select_title(dec, title);
     }
     if (dec->bdplus) {
         libbdplus_event(dec->bdplus, 0x110, title, 0);
@@ -30,6 +30,8 @@
 
 struct bd_file_s;
 struct bd_enc_info;
+struct bd_trace_buf_s;
+struct bd_decryptor;
 
 typedef struct bd_file_s * (*file_openFp)(void *, const char *);
 
@@ -45,22 +47,46 @@ struct dec_dev {
 
 typedef struct bd_dec BD_DEC;
 
+/* dec_init() flags */
+#define DEC_INIT_LAZY    0x01  /* defer libaacs / libbdplus loading */
+#define DEC_INIT_SHARED  0x02  /* share libaacs instance with other BD_DECs using the same device and key file */
+
 BD_PRIVATE BD_DEC *dec_init(struct dec_dev *dev,
                             struct bd_enc_info *enc_info,
                             const char *keyfile_path,
-                            void *regs, void *psr_read, void *psr_write);
+                            void *regs, void *psr_read, void *psr_write,
+                            int flags);
 BD_PRIVATE void dec_close(BD_DEC **);
 
+/* DEC_INIT_LAZY: libaacs / libbdplus are loaded when first stream is opened (or keys are requested).
+ * dec_init() fills only aacs_detected and bdplus_detected. Returns 1 and complete info after
+ * deferred initialization has been run. */
+BD_PRIVATE int dec_get_enc_info(BD_DEC *, struct bd_enc_info *enc_info);
+
 /* get decoder data */
 BD_PRIVATE const uint8_t *dec_data(BD_DEC *, int type);
 
+/* AACS decryptor plugin for BD_DECs created after the call (global, NULL = libaacs only) */
+BD_PRIVATE void dec_set_decryptor(const struct bd_decryptor *decryptor);
+
+/* number of threads used for decrypting multi-unit reads (0 or 1 = no worker threads) */
+BD_PRIVATE void dec_set_threads(BD_DEC *, unsigned num_threads);
+
 /* status events from upper layers */
 BD_PRIVATE void dec_start(BD_DEC *, uint32_t num_titles);
 BD_PRIVATE void dec_title(BD_DEC *, uint32_t title);
 BD_PRIVATE void dec_application(BD_DEC *, uint32_t data);
 
-/* open low-level stream */
-BD_PRIVATE struct bd_file_s *dec_open_stream(BD_DEC *dec, struct bd_file_s *fp, uint32_t clip_id);
+/* stream decoding statistics. May be updated from the thread reading the stream. */
+typedef struct dec_stats_s {
+    uint64_t decrypt_time; /* us spent in AACS decryption */
+    uint64_t bdplus_time;  /* us spent in BD+ fixup */
+    struct bd_trace_buf_s *trace; /* optional binary trace */
+} DEC_STATS;
+
+/* open low-level stream. stats (optional) must stay valid until the stream is closed. */
+BD_PRIVATE struct bd_file_s *dec_open_stream(BD_DEC *dec, struct bd_file_s *fp, uint32_t clip_id,
+                                             DEC_STATS *stats);
 
 
 #endif /* _BD_DISC_DEC_H_ */
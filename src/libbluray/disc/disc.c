@@ -26,20 +26,124 @@
 #include "dec.h"
 
 #include "util/logging.h"
+#include "util/refcnt.h"
 #include "util/macro.h"
 #include "util/mutex.h"
 #include "util/strutl.h"
+#include "util/thread.h"
+#include "util/time.h"
 #include "file/file.h"
 #include "file/mount.h"
 
+#include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef ENABLE_UDF
 #include "udf_fs.h"
 #endif
 
+#define DISC_CACHE_MAX_SIZE  (16*1024*1024)  /* evict least recently used objects above this */
+#define DISC_CACHE_HASH_SIZE 256
+#define PATH_CACHE_MAX_ENTRIES 4096            /* flush path cache above this */
+#define DIR_CACHE_MAX_ENTRIES  64              /* flush directory listing cache above this */
+#define FILE_CACHE_MAX_THREADS 4               /* asynchronous BD-ROM file copy */
+#define OVL_SCAN_MAX_FILES     PATH_CACHE_MAX_ENTRIES /* flush all caches if virtual package is larger */
+#define OVL_SCAN_MAX_DEPTH     8
+
+typedef struct disc_cache_entry_s DISC_CACHE_ENTRY;
+struct disc_cache_entry_s {
+    DISC_CACHE_ENTRY *next;      /* hash chain */
+    char              name[11];  /* "00000.mpls" */
+    void             *data;
+    size_t            size;
+    uint32_t          last_use;
+};
+
+typedef struct disc_cache_s DISC_CACHE;
+struct disc_cache_s {
+    DISC_CACHE       *next;      /* list of shared caches */
+    char             *key;       /* disc identity (NULL if cache is private) */
+    unsigned          ref;       /* number of BD_DISC objects using this cache */
+
+    BD_FAST_MUTEX     mutex;     /* leaf lock */
+    DISC_CACHE_ENTRY *entry[DISC_CACHE_HASH_SIZE];
+    size_t            size;
+    size_t            max_size;  /* evict least recently used objects above this */
+    uint32_t          tick;
+};
+
+/* file path resolution cache */
+enum {
+    PATH_NOT_FOUND = 0,
+    PATH_OVERLAY,
+    PATH_BDROM,
+};
+
+typedef struct path_cache_entry_s PATH_CACHE_ENTRY;
+struct path_cache_entry_s {
+    PATH_CACHE_ENTRY *next;      /* hash chain */
+    int               layer;     /* PATH_* */
+    char              path[1];   /* relative path (allocated with entry) */
+};
+
+/* merged directory listing (refcounted, shared by open directory handles) */
+typedef struct {
+    unsigned  count;
+    char     *name[1];   /* VLA. Strings are stored after the pointer table. */
+} DIR_LISTING;
+
+typedef struct dir_cache_entry_s DIR_CACHE_ENTRY;
+struct dir_cache_entry_s {
+    DIR_CACHE_ENTRY   *next;     /* hash chain */
+    const DIR_LISTING *list;     /* NULL if directory does not exist */
+    char               dir[1];   /* relative path (allocated with entry) */
+};
+
+/* asynchronous BD-ROM file copy */
+enum {
+    JOB_PENDING = 0,
+    JOB_RUNNING,
+    JOB_DONE,
+};
+
+typedef struct cache_job_s CACHE_JOB;
+struct cache_job_s {
+    CACHE_JOB *next;
+    char      *rel_path;
+    char      *cache_path;
+    int        state;     /* JOB_* */
+    int        result;
+};
+
+/* files in overlay filesystem (virtual package) */
+typedef struct {
+    unsigned  count;
+    unsigned  size;
+    char    **path;      /* relative paths */
+} OVL_FILES;
+
 struct bd_disc {
     BD_MUTEX  ovl_mutex;     /* protect access to overlay root */
+    OVL_FILES ovl_files;     /* files in current overlay (protected by ovl_mutex) */
+    int       ovl_files_invalid; /* ovl_files is incomplete */
+
+    BD_MUTEX          cache_mutex;
+    DISC_CACHE       *cache;          /* parsed objects (private or shared) */
+
+    PATH_CACHE_ENTRY *path_cache[DISC_CACHE_HASH_SIZE]; /* protected by cache_mutex */
+    unsigned          path_cache_count;
+    uint32_t          path_cache_gen;  /* incremented when virtual package changes */
+
+    DIR_CACHE_ENTRY  *dir_cache[DISC_CACHE_HASH_SIZE];  /* protected by cache_mutex */
+    unsigned          dir_cache_count;
+
+    BD_MUTEX          job_mutex;
+    BD_COND           job_cond;       /* new job queued or job completed */
+    CACHE_JOB        *jobs;           /* FIFO */
+    BD_THREAD         job_thread[FILE_CACHE_MAX_THREADS];
+    unsigned          num_job_threads;
+    int               job_exit;
 
     char     *disc_root;     /* disc filesystem root (if disc is mounted) */
     char     *overlay_root;  /* overlay filesystem root (if set) */
@@ -52,8 +156,26 @@ struct bd_disc {
     void        (*pf_fs_close)(void *);
 
     const char   *udf_volid;
+
+    int           direct_io;     /* use unbuffered I/O for stream files */
+
+    uint64_t      dec_init_us;   /* startup profiling */
 };
 
+static uint32_t _str_hash(const char *name)
+{
+    uint32_t h = 0;
+    while (*name) {
+        h = h * 31 + (uint8_t)*name++;
+    }
+    return h;
+}
+
+static unsigned _cache_hash(const char *name)
+{
+    return _str_hash(name) % DISC_CACHE_HASH_SIZE;
+}
+
 /*
  * BD-ROM filesystem
  */
@@ -62,11 +184,17 @@ static BD_FILE_H *_bdrom_open_path(void *p, const char *rel_path)
 {
     BD_DISC *disc = (BD_DISC *)p;
     BD_FILE_H *fp;
+    char buf[STR_PATH_BUF_SIZE];
     char *abs_path;
 
-    abs_path = str_printf("%s%s", disc->disc_root, rel_path);
+    /* no filesystem root (stream input) */
+    if (!disc->disc_root) {
+        return NULL;
+    }
+
+    abs_path = str_cat3(buf, sizeof(buf), disc->disc_root, rel_path, "");
     fp = file_open(abs_path, "rb");
-    X_FREE(abs_path);
+    str_cat_free(buf, abs_path);
 
     return fp;
 }
@@ -75,11 +203,16 @@ static BD_DIR_H *_bdrom_open_dir(void *p, const char *dir)
 {
     BD_DISC *disc = (BD_DISC *)p;
     BD_DIR_H *dp;
+    char buf[STR_PATH_BUF_SIZE];
     char *path;
 
-    path = str_printf("%s%s", disc->disc_root, dir);
+    if (!disc->disc_root) {
+        return NULL;
+    }
+
+    path = str_cat3(buf, sizeof(buf), disc->disc_root, dir, "");
     dp = dir_open(path);
-    X_FREE(path);
+    str_cat_free(buf, path);
 
     return dp;
 }
@@ -95,9 +228,10 @@ static BD_FILE_H *_overlay_open_path(BD_DISC *p, const char *rel_path)
     bd_mutex_lock(&p->ovl_mutex);
 
     if (p->overlay_root) {
-        char *abs_path = str_printf("%s%s", p->overlay_root, rel_path);
+        char  buf[STR_PATH_BUF_SIZE];
+        char *abs_path = str_cat3(buf, sizeof(buf), p->overlay_root, rel_path, "");
         fp = file_open_default()(abs_path, "rb");
-        X_FREE(abs_path);
+        str_cat_free(buf, abs_path);
     }
 
     bd_mutex_unlock(&p->ovl_mutex);
@@ -112,9 +246,10 @@ static BD_DIR_H *_overlay_open_dir(BD_DISC *p, const char *dir)
     bd_mutex_lock(&p->ovl_mutex);
 
     if (p->overlay_root) {
-        char *abs_path = str_printf("%s%s", p->disc_root, dir);
+        char  buf[STR_PATH_BUF_SIZE];
+        char *abs_path = str_cat3(buf, sizeof(buf), p->disc_root, dir, "");
         dp = dir_open_default()(abs_path);
-        X_FREE(abs_path);
+        str_cat_free(buf, abs_path);
     }
 
     bd_mutex_unlock(&p->ovl_mutex);
@@ -122,18 +257,107 @@ static BD_DIR_H *_overlay_open_dir(BD_DISC *p, const char *dir)
     return dp;
 }
 
+/*
+ * overlay file list
+ */
+
+static void _ovl_files_free(OVL_FILES *f)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < f->count; ii++) {
+        X_FREE(f->path[ii]);
+    }
+    X_FREE(f->path);
+    f->count = f->size = 0;
+}
+
+static int _ovl_files_add(OVL_FILES *f, const char *rel_path)
+{
+    if (f->count >= OVL_SCAN_MAX_FILES) {
+        return -1;
+    }
+    if (f->count >= f->size) {
+        unsigned size = f->size ? f->size * 2 : 64;
+        char **tmp = realloc(f->path, size * sizeof(char *));
+        if (!tmp) {
+            return -1;
+        }
+        f->path = tmp;
+        f->size = size;
+    }
+
+    f->path[f->count] = str_dup(rel_path);
+    if (!f->path[f->count]) {
+        return -1;
+    }
+    f->count++;
+
+    return 0;
+}
+
+/* collect relative paths of all files under overlay root.
+ * Returns -1 if virtual package is too large or on error. */
+static int _ovl_scan(OVL_FILES *f, const char *root, const char *rel_dir, int depth)
+{
+    BD_DIR_H  *dp;
+    BD_DIRENT  ent;
+    char      *path;
+    int        result = 0;
+
+    path = str_printf("%s%s", root, rel_dir);
+    dp = path ? dir_open_default()(path) : NULL;
+    X_FREE(path);
+    if (!dp) {
+        return 0;
+    }
+
+    while (!result && !dir_read(dp, &ent)) {
+        BD_DIR_H *sub;
+        char     *rel_path;
+
+        if (!strcmp(ent.d_name, ".") || !strcmp(ent.d_name, "..")) {
+            continue;
+        }
+
+        rel_path = rel_dir[0] ? str_printf("%s" DIR_SEP "%s", rel_dir, ent.d_name) : str_dup(ent.d_name);
+        path     = rel_path ? str_printf("%s%s", root, rel_path) : NULL;
+        if (!path) {
+            X_FREE(rel_path);
+            result = -1;
+            break;
+        }
+
+        sub = dir_open_default()(path);
+        if (sub) {
+            dir_close(sub);
+            result = depth < OVL_SCAN_MAX_DEPTH ? _ovl_scan(f, root, rel_path, depth + 1) : -1;
+        } else {
+            result = _ovl_files_add(f, rel_path);
+        }
+
+        X_FREE(path);
+        X_FREE(rel_path);
+    }
+
+    dir_close(dp);
+
+    return result;
+}
+
 /*
  * directory combining
  */
 
 typedef struct {
-    unsigned int count;
-    unsigned int pos;
-    BD_DIRENT    entry[1]; /* VLA */
+    const DIR_LISTING *list;
+    unsigned int       pos;
 } COMB_DIR;
 
 static void _comb_dir_close(BD_DIR_H *dp)
 {
+    COMB_DIR *priv = (COMB_DIR *)dp->internal;
+    bd_refcnt_dec(priv->list);
     X_FREE(dp->internal);
     X_FREE(dp);
 }
@@ -141,62 +365,346 @@ static void _comb_dir_close(BD_DIR_H *dp)
 static int _comb_dir_read(BD_DIR_H *dp, BD_DIRENT *entry)
 {
     COMB_DIR *priv = (COMB_DIR *)dp->internal;
-    if (priv->pos < priv->count) {
-        strcpy(entry->d_name, priv->entry[priv->pos++].d_name);
+    if (priv->pos < priv->list->count) {
+        strcpy(entry->d_name, priv->list->name[priv->pos++]);
         return 0;
     }
     return 1;
 }
 
-static void _comb_dir_append(BD_DIR_H *dp, BD_DIRENT *entry)
+/* takes a new reference to list */
+static BD_DIR_H *_comb_dir_open(const DIR_LISTING *list)
 {
-    COMB_DIR *priv = (COMB_DIR *)dp->internal;
-    unsigned int i;
+    BD_DIR_H *dp   = calloc(1, sizeof(BD_DIR_H));
+    COMB_DIR *priv = calloc(1, sizeof(COMB_DIR));
 
-    if (!priv) {
-        return;
+    if (!dp || !priv) {
+        X_FREE(dp);
+        X_FREE(priv);
+        return NULL;
+    }
+
+    bd_refcnt_inc(list);
+    priv->list   = list;
+    dp->internal = priv;
+    dp->read     = _comb_dir_read;
+    dp->close    = _comb_dir_close;
+
+    return dp;
+}
+
+typedef struct {
+    char     *names;      /* concatenated, nul-terminated names */
+    size_t    names_len;
+    size_t    names_size;
+    uint32_t *offset;     /* name offsets, directory order */
+    unsigned  count;
+    unsigned  size;
+    uint32_t *hash;       /* open addressing table of (index + 1), size is power of 2 */
+    unsigned  hash_size;
+} DIR_BUILDER;
+
+static int _dir_builder_grow_hash(DIR_BUILDER *b)
+{
+    unsigned  new_size = b->hash_size ? 2 * b->hash_size : 64;
+    uint32_t *tmp      = calloc(new_size, sizeof(uint32_t));
+    unsigned  ii;
+
+    if (!tmp) {
+        return -1;
+    }
+    for (ii = 0; ii < b->count; ii++) {
+        unsigned h = _str_hash(b->names + b->offset[ii]) & (new_size - 1);
+        while (tmp[h]) {
+            h = (h + 1) & (new_size - 1);
+        }
+        tmp[h] = ii + 1;
+    }
+
+    X_FREE(b->hash);
+    b->hash      = tmp;
+    b->hash_size = new_size;
+    return 0;
+}
+
+/* returns 0 if name was appended or already exists */
+static int _dir_builder_add(DIR_BUILDER *b, const char *name)
+{
+    size_t   len = strlen(name) + 1;
+    unsigned h;
+
+    /* keep load factor below 1/2 */
+    if (2 * (b->count + 1) > b->hash_size && _dir_builder_grow_hash(b) < 0) {
+        return -1;
     }
 
     /* no duplicates */
-    for (i = 0; i < priv->count; i++) {
-        if (!strcmp(priv->entry[i].d_name, entry->d_name)) {
-            return;
+    for (h = _str_hash(name) & (b->hash_size - 1); b->hash[h]; h = (h + 1) & (b->hash_size - 1)) {
+        if (!strcmp(b->names + b->offset[b->hash[h] - 1], name)) {
+            return 0;
         }
     }
 
-    /* append */
-    priv = realloc(priv, sizeof(*priv) + priv->count * sizeof(BD_DIRENT));
-    if (!priv) {
-        return;
+    if (b->count >= b->size) {
+        unsigned  new_size = b->size ? 2 * b->size : 32;
+        uint32_t *tmp = realloc(b->offset, new_size * sizeof(uint32_t));
+        if (!tmp) {
+            return -1;
+        }
+        b->offset = tmp;
+        b->size   = new_size;
     }
-    strcpy(priv->entry[priv->count].d_name, entry->d_name);
-    priv->count++;
-    dp->internal = (void*)priv;
+    if (b->names_len + len > b->names_size) {
+        size_t new_size = BD_MAX(2 * b->names_size, b->names_len + len + 1024);
+        char  *tmp = realloc(b->names, new_size);
+        if (!tmp) {
+            return -1;
+        }
+        b->names      = tmp;
+        b->names_size = new_size;
+    }
+
+    memcpy(b->names + b->names_len, name, len);
+    b->offset[b->count] = (uint32_t)b->names_len;
+    b->names_len += len;
+    b->hash[h] = ++b->count;
+
+    return 0;
 }
 
-static BD_DIR_H *_combine_dirs(BD_DIR_H *ovl, BD_DIR_H *rom)
+/* overlay entries first, then BD-ROM entries. Closes both directories. */
+static const DIR_LISTING *_combine_dirs(BD_DIR_H *ovl, BD_DIR_H *rom)
 {
-    BD_DIR_H *dp = calloc(1, sizeof(BD_DIR_H));
-    BD_DIRENT entry;
+    DIR_BUILDER  b;
+    DIR_LISTING *list = NULL;
+    BD_DIRENT    entry;
+    size_t       table_size;
+    unsigned     ii;
+    int          err = 0;
+
+    memset(&b, 0, sizeof(b));
+
+    if (ovl) {
+        while (!err && !dir_read(ovl, &entry)) {
+            err = _dir_builder_add(&b, entry.d_name);
+        }
+        dir_close(ovl);
+    }
+    if (rom) {
+        while (!err && !dir_read(rom, &entry)) {
+            err = _dir_builder_add(&b, entry.d_name);
+        }
+        dir_close(rom);
+    }
 
-    if (dp) {
-        dp->read     = _comb_dir_read;
-        dp->close    = _comb_dir_close;
-        dp->internal = calloc(1, sizeof(COMB_DIR));
+    if (!err) {
+        table_size = sizeof(DIR_LISTING) + b.count * sizeof(char *);
+        list = refcnt_realloc(NULL, table_size + b.names_len, NULL);
+    }
+    if (list) {
+        char *names = (char *)list + table_size;
+        if (b.names_len) {
+            memcpy(names, b.names, b.names_len);
+        }
+        for (ii = 0; ii < b.count; ii++) {
+            list->name[ii] = names + b.offset[ii];
+        }
+        list->count = b.count;
+    } else {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "out of memory\n");
+    }
+
+    X_FREE(b.names);
+    X_FREE(b.offset);
+    X_FREE(b.hash);
+
+    return list;
+}
 
-        while (!dir_read(ovl, &entry)) {
-            _comb_dir_append(dp, &entry);
+/*
+ * path resolution cache
+ *
+ * BD-J titles open lots of small files. Remember which layer holds
+ * each file (or that it does not exist) to skip failing lookups.
+ */
+
+/* cache_mutex must be locked */
+static PATH_CACHE_ENTRY **_path_cache_find(BD_DISC *p, const char *rel_path)
+{
+    PATH_CACHE_ENTRY **pe = &p->path_cache[_cache_hash(rel_path)];
+
+    while (*pe && strcmp((*pe)->path, rel_path)) {
+        pe = &(*pe)->next;
+    }
+    return pe;
+}
+
+/* cache_mutex must be locked */
+static void _path_cache_clean(BD_DISC *p)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < DISC_CACHE_HASH_SIZE; ii++) {
+        while (p->path_cache[ii]) {
+            PATH_CACHE_ENTRY *e = p->path_cache[ii];
+            p->path_cache[ii] = e->next;
+            X_FREE(e);
         }
-        while (!dir_read(rom, &entry)) {
-            _comb_dir_append(dp, &entry);
+    }
+    p->path_cache_count = 0;
+}
+
+/* returns PATH_* or -1 if not cached. *gen receives current cache generation. */
+static int _path_cache_get(BD_DISC *p, const char *rel_path, uint32_t *gen)
+{
+    PATH_CACHE_ENTRY *e;
+    int layer = -1;
+
+    bd_mutex_lock(&p->cache_mutex);
+
+    e = *_path_cache_find(p, rel_path);
+    if (e) {
+        layer = e->layer;
+    }
+    *gen = p->path_cache_gen;
+
+    bd_mutex_unlock(&p->cache_mutex);
+
+    return layer;
+}
+
+static void _path_cache_put(BD_DISC *p, const char *rel_path, int layer, uint32_t gen)
+{
+    PATH_CACHE_ENTRY **pe, *e;
+    size_t len = strlen(rel_path);
+
+    bd_mutex_lock(&p->cache_mutex);
+
+    /* virtual package changed while resolving ? */
+    if (gen != p->path_cache_gen) {
+        goto out;
+    }
+
+    pe = _path_cache_find(p, rel_path);
+    if (*pe) {
+        (*pe)->layer = layer;
+        goto out;
+    }
+
+    if (p->path_cache_count >= PATH_CACHE_MAX_ENTRIES) {
+        _path_cache_clean(p);
+        pe = _path_cache_find(p, rel_path);
+    }
+
+    e = malloc(sizeof(PATH_CACHE_ENTRY) + len);
+    if (e) {
+        memcpy(e->path, rel_path, len + 1);
+        e->layer = layer;
+        e->next  = NULL;
+        *pe = e;
+        p->path_cache_count++;
+    }
+
+ out:
+    bd_mutex_unlock(&p->cache_mutex);
+}
+
+/*
+ * directory listing cache
+ */
+
+/* cache_mutex must be locked */
+static DIR_CACHE_ENTRY **_dir_cache_find(BD_DISC *p, const char *dir)
+{
+    DIR_CACHE_ENTRY **pe = &p->dir_cache[_cache_hash(dir)];
+
+    while (*pe && strcmp((*pe)->dir, dir)) {
+        pe = &(*pe)->next;
+    }
+    return pe;
+}
+
+/* cache_mutex must be locked */
+static void _dir_cache_clean(BD_DISC *p)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < DISC_CACHE_HASH_SIZE; ii++) {
+        while (p->dir_cache[ii]) {
+            DIR_CACHE_ENTRY *e = p->dir_cache[ii];
+            p->dir_cache[ii] = e->next;
+            if (e->list) {
+                bd_refcnt_dec(e->list);
+            }
+            X_FREE(e);
         }
     }
-    dir_close(ovl);
-    dir_close(rom);
+    p->dir_cache_count = 0;
+}
 
-    return dp;
+/* returns 1 if cached. *list receives new reference (or NULL if directory does not exist). */
+static int _dir_cache_get(BD_DISC *p, const char *dir, const DIR_LISTING **list, uint32_t *gen)
+{
+    DIR_CACHE_ENTRY *e;
+
+    bd_mutex_lock(&p->cache_mutex);
+
+    e = *_dir_cache_find(p, dir);
+    *list = e ? e->list : NULL;
+    if (*list) {
+        bd_refcnt_inc(*list);
+    }
+    *gen = p->path_cache_gen;
+
+    bd_mutex_unlock(&p->cache_mutex);
+
+    return !!e;
+}
+
+static void _dir_cache_put(BD_DISC *p, const char *dir, const DIR_LISTING *list, uint32_t gen)
+{
+    DIR_CACHE_ENTRY **pe, *e;
+    size_t len = strlen(dir);
+
+    bd_mutex_lock(&p->cache_mutex);
+
+    /* virtual package changed while reading ? */
+    if (gen != p->path_cache_gen) {
+        goto out;
+    }
+
+    pe = _dir_cache_find(p, dir);
+    if (*pe) {
+        goto out;
+    }
+
+    if (p->dir_cache_count >= DIR_CACHE_MAX_ENTRIES) {
+        _dir_cache_clean(p);
+        pe = _dir_cache_find(p, dir);
+    }
+
+    e = malloc(sizeof(DIR_CACHE_ENTRY) + len);
+    if (e) {
+        memcpy(e->dir, dir, len + 1);
+        e->list = list;
+        e->next = NULL;
+        if (list) {
+            bd_refcnt_inc(list);
+        }
+        *pe = e;
+        p->dir_cache_count++;
+    }
+
+ out:
+    bd_mutex_unlock(&p->cache_mutex);
 }
 
+static void _cache_jobs_stop(BD_DISC *p);
+static DISC_CACHE *_cache_new(const char *key);
+static void _cache_release(DISC_CACHE **pc);
+static DISC_CACHE_ENTRY **_cache_find(DISC_CACHE *c, const char *name);
+static void _cache_remove(DISC_CACHE *c, DISC_CACHE_ENTRY **pe);
+
 /*
  * disc open / close
  */
@@ -206,6 +714,10 @@ static BD_DISC *_disc_init()
     BD_DISC *p = calloc(1, sizeof(BD_DISC));
     if (p) {
         bd_mutex_init(&p->ovl_mutex);
+        bd_mutex_init(&p->cache_mutex);
+        p->cache = _cache_new(NULL);
+        bd_mutex_init(&p->job_mutex);
+        bd_cond_init(&p->job_cond);
 
         /* default file access functions */
         p->fs_handle          = (void*)p;
@@ -233,20 +745,23 @@ static void _set_paths(BD_DISC *p, const char *device_path)
 BD_DISC *disc_open(const char *device_path,
                    void *read_blocks_handle,
                    int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks),
+                   void (*prefetch_blocks)(void *handle, int lba, int num_blocks),
                    struct bd_enc_info *enc_info,
                    const char *keyfile_path,
-                   void *regs, void *psr_read, void *psr_write)
+                   void *regs, void *psr_read, void *psr_write,
+                   int decrypt_flags, int direct_io)
 {
     BD_DISC *p = _disc_init();
 
     if (p) {
         _set_paths(p, device_path);
+        p->direct_io = direct_io;
 
 #ifdef ENABLE_UDF
         /* check if disc root directory can be opened. If not, treat it as device/image file. */
         BD_DIR_H *dp_img = device_path ? dir_open(device_path) : NULL;
         if (!dp_img) {
-            void *udf = udf_image_open(device_path, read_blocks_handle, read_blocks);
+            void *udf = udf_image_open(device_path, read_blocks_handle, read_blocks, prefetch_blocks, direct_io);
             if (!udf) {
                 BD_DEBUG(DBG_FILE | DBG_CRIT, "failed opening UDF image %s\n", device_path);
             } else {
@@ -267,10 +782,13 @@ BD_DISC *disc_open(const char *device_path,
 #else
         (void)read_blocks_handle;
         (void)read_blocks;
+        (void)prefetch_blocks;
 #endif
 
         struct dec_dev dev = { p->fs_handle, p->pf_file_open_bdrom, p, (file_openFp)disc_open_path, p->disc_root, device_path };
-        p->dec = dec_init(&dev, enc_info, keyfile_path, regs, psr_read, psr_write);
+        uint64_t t0 = bd_get_time_us();
+        p->dec = dec_init(&dev, enc_info, keyfile_path, regs, psr_read, psr_write, decrypt_flags);
+        p->dec_init_us = bd_get_time_us() - t0;
     }
 
     return p;
@@ -281,15 +799,26 @@ void disc_close(BD_DISC **pp)
     if (pp && *pp) {
         BD_DISC *p = *pp;
 
+        _cache_jobs_stop(p);
+
         dec_close(&p->dec);
 
         if (p->pf_fs_close) {
             p->pf_fs_close(p->fs_handle);
         }
 
+        _cache_release(&p->cache);
+        _path_cache_clean(p);
+        _dir_cache_clean(p);
+        _ovl_files_free(&p->ovl_files);
+
         bd_mutex_destroy(&p->ovl_mutex);
+        bd_mutex_destroy(&p->cache_mutex);
+        bd_mutex_destroy(&p->job_mutex);
+        bd_cond_destroy(&p->job_cond);
 
         X_FREE(p->disc_root);
+        X_FREE(p->overlay_root);
         X_FREE(*pp);
     }
 }
@@ -319,54 +848,90 @@ BD_DIR_H *disc_open_bdrom_dir(BD_DISC *p, const char *rel_path)
 
 BD_FILE_H *disc_open_path(BD_DISC *p, const char *rel_path)
 {
-    BD_FILE_H *fp;
+    BD_FILE_H *fp = NULL;
+    uint32_t   gen;
+    int        layer;
+
+    layer = _path_cache_get(p, rel_path, &gen);
+
+    if (layer == PATH_NOT_FOUND) {
+        BD_DEBUG(DBG_FILE, "error opening file %s (cached)\n", rel_path);
+        return NULL;
+    }
 
     /* search file from overlay */
-    fp = _overlay_open_path(p, rel_path);
+    if (layer != PATH_BDROM) {
+        fp = _overlay_open_path(p, rel_path);
+        layer = PATH_OVERLAY;
+    }
 
     /* if not found, try BD-ROM */
     if (!fp) {
         fp = p->pf_file_open_bdrom(p->fs_handle, rel_path);
+        layer = PATH_BDROM;
 
         if (!fp) {
             BD_DEBUG(DBG_FILE | DBG_CRIT, "error opening file %s\n", rel_path);
+            layer = PATH_NOT_FOUND;
         }
     }
 
+    _path_cache_put(p, rel_path, layer, gen);
+
     return fp;
 }
 
 BD_FILE_H *disc_open_file(BD_DISC *p, const char *dir, const char *file)
 {
     BD_FILE_H *fp;
+    char buf[STR_PATH_BUF_SIZE];
     char *path;
 
-    path = str_printf("%s" DIR_SEP "%s", dir, file);
+    path = str_cat3(buf, sizeof(buf), dir, DIR_SEP, file);
     fp = disc_open_path(p, path);
-    X_FREE(path);
+    str_cat_free(buf, path);
 
     return fp;
 }
 
 BD_DIR_H *disc_open_dir(BD_DISC *p, const char *dir)
 {
+    const DIR_LISTING *list;
     BD_DIR_H *dp_rom;
     BD_DIR_H *dp_ovl;
+    BD_DIR_H *dp;
+    uint32_t  gen;
+
+    if (_dir_cache_get(p, dir, &list, &gen)) {
+        if (!list) {
+            BD_DEBUG(DBG_FILE, "error opening dir %s (cached)\n", dir);
+            return NULL;
+        }
+        dp = _comb_dir_open(list);
+        bd_refcnt_dec(list);
+        return dp;
+    }
 
     dp_rom = p->pf_dir_open_bdrom(p->fs_handle, dir);
     dp_ovl = _overlay_open_dir(p, dir);
 
-    if (!dp_ovl) {
-        if (!dp_rom) {
-            BD_DEBUG(DBG_FILE, "error opening dir %s\n", dir);
-        }
-        return dp_rom;
+    if (!dp_ovl && !dp_rom) {
+        BD_DEBUG(DBG_FILE, "error opening dir %s\n", dir);
+        _dir_cache_put(p, dir, NULL, gen);
+        return NULL;
     }
-    if (!dp_rom) {
-        return dp_ovl;
+
+    list = _combine_dirs(dp_ovl, dp_rom);
+    if (!list) {
+        return NULL;
     }
 
-    return _combine_dirs(dp_ovl, dp_rom);
+    /* handle takes one reference, cache another */
+    dp = _comb_dir_open(list);
+    _dir_cache_put(p, dir, list, gen);
+    bd_refcnt_dec(list);
+
+    return dp;
 }
 
 size_t disc_read_file(BD_DISC *disc, const char *dir, const char *file,
@@ -408,8 +973,81 @@ size_t disc_read_file(BD_DISC *disc, const char *dir, const char *file,
  * filesystem update
  */
 
+/* cache_mutex must be locked */
+static void _path_cache_remove(BD_DISC *p, const char *rel_path)
+{
+    PATH_CACHE_ENTRY **pe = _path_cache_find(p, rel_path);
+
+    if (*pe) {
+        PATH_CACHE_ENTRY *e = *pe;
+        *pe = e->next;
+        X_FREE(e);
+        p->path_cache_count--;
+    }
+}
+
+/* cache_mutex must be locked. Drop listings of all directories containing rel_path. */
+static void _dir_cache_remove_parents(BD_DISC *p, const char *rel_path)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < DISC_CACHE_HASH_SIZE; ii++) {
+        DIR_CACHE_ENTRY **pe = &p->dir_cache[ii];
+        while (*pe) {
+            DIR_CACHE_ENTRY *e = *pe;
+            size_t len = strlen(e->dir);
+            if (!len || (!strncmp(e->dir, rel_path, len) &&
+                         (rel_path[len] == DIR_SEP_CHAR || e->dir[len - 1] == DIR_SEP_CHAR))) {
+                *pe = e->next;
+                if (e->list) {
+                    bd_refcnt_dec(e->list);
+                }
+                X_FREE(e);
+                p->dir_cache_count--;
+            } else {
+                pe = &e->next;
+            }
+        }
+    }
+}
+
+/* cache_mutex must be locked. Drop cached state of files. */
+static void _ovl_invalidate(BD_DISC *p, const OVL_FILES *f)
+{
+    DISC_CACHE_ENTRY **pe;
+    unsigned ii;
+
+    for (ii = 0; ii < f->count; ii++) {
+        const char *name = strrchr(f->path[ii], DIR_SEP_CHAR);
+        name = name ? name + 1 : f->path[ii];
+
+        _path_cache_remove(p, f->path[ii]);
+        _dir_cache_remove_parents(p, f->path[ii]);
+
+        /* parsed objects are cached by file name */
+        if (p->cache) {
+            bd_fast_mutex_lock(&p->cache->mutex);
+            pe = _cache_find(p->cache, name);
+            if (*pe) {
+                _cache_remove(p->cache, pe);
+            }
+            bd_fast_mutex_unlock(&p->cache->mutex);
+        }
+    }
+}
+
 void disc_update(BD_DISC *p, const char *overlay_root)
 {
+    OVL_FILES files, old_files;
+    int       full = 0;
+
+    /* Only files in old or new overlay can resolve differently or have
+     * different content after update: BD-ROM files are not modified. */
+    memset(&files, 0, sizeof(files));
+    if (overlay_root && _ovl_scan(&files, overlay_root, "", 0) < 0) {
+        full = 1;
+    }
+
     bd_mutex_lock(&p->ovl_mutex);
 
     X_FREE(p->overlay_root);
@@ -417,10 +1055,44 @@ void disc_update(BD_DISC *p, const char *overlay_root)
         p->overlay_root = str_dup(overlay_root);
     }
 
+    old_files = p->ovl_files;
+    full |= p->ovl_files_invalid;
+    p->ovl_files = files;
+    p->ovl_files_invalid = full;
+
     bd_mutex_unlock(&p->ovl_mutex);
+
+    if (!full && !old_files.count && !files.count) {
+        /* nothing changed */
+        return;
+    }
+
+    /* files may have changed */
+    if (disc_cache_is_shared(p)) {
+        /* do not modify other users' cache */
+        disc_cache_share(p, NULL);
+    } else if (full) {
+        disc_cache_clean(p, NULL);
+    }
+
+    bd_mutex_lock(&p->cache_mutex);
+    if (full) {
+        BD_DEBUG(DBG_FILE, "virtual package update: flushing all cached files\n");
+        _path_cache_clean(p);
+        _dir_cache_clean(p);
+    } else {
+        BD_DEBUG(DBG_FILE, "virtual package update: %u old and %u new overlay files\n",
+                 old_files.count, files.count);
+        _ovl_invalidate(p, &old_files);
+        _ovl_invalidate(p, &files);
+    }
+    p->path_cache_gen++;
+    bd_mutex_unlock(&p->cache_mutex);
+
+    _ovl_files_free(&old_files);
 }
 
-int disc_cache_bdrom_file(BD_DISC *p, const char *rel_path, const char *cache_path)
+static int _cache_bdrom_file(BD_DISC *p, const char *rel_path, const char *cache_path)
 {
     BD_FILE_H *fp_in;
     BD_FILE_H *fp_out;
@@ -465,19 +1137,590 @@ int disc_cache_bdrom_file(BD_DISC *p, const char *rel_path, const char *cache_pa
     return 0;
 }
 
+/*
+ * asynchronous BD-ROM file caching
+ *
+ * BD-J title startup copies all JAR files (and fonts) to local cache.
+ * Copies are started as soon as the files are known (BDJO is parsed). Class
+ * loading waits only for the file it needs.
+ */
+
+/* job_mutex must be locked */
+static CACHE_JOB *_cache_job_find(BD_DISC *p, const char *cache_path)
+{
+    CACHE_JOB *job;
+    for (job = p->jobs; job; job = job->next) {
+        if (!strcmp(job->cache_path, cache_path)) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+static void *_cache_job_worker(void *arg)
+{
+    BD_DISC *p = (BD_DISC *)arg;
+
+    bd_mutex_lock(&p->job_mutex);
+
+    while (!p->job_exit) {
+        CACHE_JOB *job;
+
+        for (job = p->jobs; job && job->state != JOB_PENDING; job = job->next) ;
+
+        if (!job) {
+            bd_cond_wait(&p->job_cond, &p->job_mutex);
+            continue;
+        }
+
+        /* strings are not modified while job is running */
+        job->state = JOB_RUNNING;
+        bd_mutex_unlock(&p->job_mutex);
+
+        int result = _cache_bdrom_file(p, job->rel_path, job->cache_path);
+
+        bd_mutex_lock(&p->job_mutex);
+        job->result = result;
+        job->state  = JOB_DONE;
+        bd_cond_broadcast(&p->job_cond);
+    }
+
+    bd_mutex_unlock(&p->job_mutex);
+
+    return NULL;
+}
+
+/* job_mutex must be locked */
+static void _cache_jobs_start_thread(BD_DISC *p)
+{
+    /* UDF image reader is not thread-safe */
+    unsigned max_threads = p->udf_volid ? 1 : FILE_CACHE_MAX_THREADS;
+    unsigned pending = 0;
+    CACHE_JOB *job;
+
+    for (job = p->jobs; job; job = job->next) {
+        pending += (job->state == JOB_PENDING);
+    }
+
+    if (p->num_job_threads < max_threads && pending > 0) {
+        if (bd_thread_create(&p->job_thread[p->num_job_threads], "bd_cache", _cache_job_worker, p) < 0) {
+            BD_DEBUG(DBG_FILE | DBG_CRIT, "failed creating file cache thread\n");
+        } else {
+            p->num_job_threads++;
+        }
+    }
+}
+
+static void _cache_jobs_stop(BD_DISC *p)
+{
+    unsigned ii;
+
+    bd_mutex_lock(&p->job_mutex);
+    p->job_exit = 1;
+    bd_cond_broadcast(&p->job_cond);
+    bd_mutex_unlock(&p->job_mutex);
+
+    /* running copies are completed */
+    for (ii = 0; ii < p->num_job_threads; ii++) {
+        bd_thread_join(&p->job_thread[ii]);
+    }
+    p->num_job_threads = 0;
+
+    while (p->jobs) {
+        CACHE_JOB *job = p->jobs;
+        p->jobs = job->next;
+        if (job->state == JOB_PENDING) {
+            BD_DEBUG(DBG_FILE, "cancelled caching of %s\n", job->rel_path);
+        }
+        X_FREE(job->rel_path);
+        X_FREE(job->cache_path);
+        X_FREE(job);
+    }
+}
+
+int disc_cache_bdrom_file_async(BD_DISC *p, const char *rel_path, const char *cache_path)
+{
+    CACHE_JOB *job, **tail;
+    int result = 0;
+
+    bd_mutex_lock(&p->job_mutex);
+
+    job = _cache_job_find(p, cache_path);
+    if (job && job->state != JOB_DONE) {
+        /* already queued */
+        goto out;
+    }
+
+    if (!job) {
+        job = calloc(1, sizeof(*job));
+        if (job) {
+            job->cache_path = str_dup(cache_path);
+        }
+        if (!job || !job->cache_path) {
+            X_FREE(job);
+            result = -1;
+            goto out;
+        }
+        for (tail = &p->jobs; *tail; tail = &(*tail)->next) ;
+        *tail = job;
+    }
+
+    X_FREE(job->rel_path);
+    job->rel_path = str_dup(rel_path);
+    job->state    = job->rel_path ? JOB_PENDING : JOB_DONE;
+    job->result   = -1;
+    if (!job->rel_path) {
+        result = -1;
+        goto out;
+    }
+
+    _cache_jobs_start_thread(p);
+    bd_cond_broadcast(&p->job_cond);
+
+ out:
+    bd_mutex_unlock(&p->job_mutex);
+
+    if (result < 0) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "error queuing file %s for caching\n", rel_path);
+    }
+    return result;
+}
+
+int disc_cache_bdrom_file_wait(BD_DISC *p, const char *cache_path)
+{
+    CACHE_JOB *job;
+    int result = 1;
+
+    bd_mutex_lock(&p->job_mutex);
+
+    job = _cache_job_find(p, cache_path);
+    if (job) {
+        while (job->state != JOB_DONE && !p->job_exit) {
+            if (!p->num_job_threads) {
+                /* no worker thread: copy here */
+                job->state = JOB_RUNNING;
+                bd_mutex_unlock(&p->job_mutex);
+                job->result = _cache_bdrom_file(p, job->rel_path, job->cache_path);
+                bd_mutex_lock(&p->job_mutex);
+                job->state = JOB_DONE;
+                bd_cond_broadcast(&p->job_cond);
+                break;
+            }
+            bd_cond_wait(&p->job_cond, &p->job_mutex);
+        }
+        result = job->state == JOB_DONE ? job->result : -1;
+    }
+
+    bd_mutex_unlock(&p->job_mutex);
+
+    return result;
+}
+
+int disc_cache_bdrom_file(BD_DISC *p, const char *rel_path, const char *cache_path)
+{
+    /* do not write the same file from two threads */
+    int result = disc_cache_bdrom_file_wait(p, cache_path);
+    if (result <= 0) {
+        return result;
+    }
+
+    return _cache_bdrom_file(p, rel_path, cache_path);
+}
+
+/*
+ * parsed object cache
+ *
+ * Cache can be shared between all BD_DISC objects (in this process) that
+ * have opened the same disc. Shared caches are kept in a global list and
+ * released when the last user detaches.
+ */
+
+static DISC_CACHE *_cache_new(const char *key)
+{
+    DISC_CACHE *c = calloc(1, sizeof(DISC_CACHE));
+    if (!c) {
+        return NULL;
+    }
+    if (key) {
+        c->key = str_dup(key);
+        if (!c->key) {
+            X_FREE(c);
+            return NULL;
+        }
+    }
+    c->ref = 1;
+    c->max_size = DISC_CACHE_MAX_SIZE;
+    bd_fast_mutex_init(&c->mutex);
+    return c;
+}
+
+/* c->mutex must be locked. Returns pointer to link pointing to entry. */
+static DISC_CACHE_ENTRY **_cache_find(DISC_CACHE *c, const char *name)
+{
+    DISC_CACHE_ENTRY **pe = &c->entry[_cache_hash(name)];
+
+    while (*pe && strcmp((*pe)->name, name)) {
+        pe = &(*pe)->next;
+    }
+    return pe;
+}
+
+/* c->mutex must be locked */
+static void _cache_remove(DISC_CACHE *c, DISC_CACHE_ENTRY **pe)
+{
+    DISC_CACHE_ENTRY *e = *pe;
+
+    *pe = e->next;
+    c->size -= e->size;
+    bd_refcnt_dec(e->data);
+    X_FREE(e);
+}
+
+/* c->mutex must be locked */
+static void _cache_evict_lru(DISC_CACHE *c)
+{
+    DISC_CACHE_ENTRY **lru = NULL;
+    unsigned ii;
+
+    for (ii = 0; ii < DISC_CACHE_HASH_SIZE; ii++) {
+        DISC_CACHE_ENTRY **pe;
+        for (pe = &c->entry[ii]; *pe; pe = &(*pe)->next) {
+            if (!lru || c->tick - (*pe)->last_use > c->tick - (*lru)->last_use) {
+                lru = pe;
+            }
+        }
+    }
+    if (lru) {
+        _cache_remove(c, lru);
+    }
+}
+
+/* c->mutex must be locked */
+static void _cache_clean_all(DISC_CACHE *c)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < DISC_CACHE_HASH_SIZE; ii++) {
+        while (c->entry[ii]) {
+            _cache_remove(c, &c->entry[ii]);
+        }
+    }
+}
+
+static void _cache_free(DISC_CACHE **pc)
+{
+    DISC_CACHE *c = *pc;
+    if (c) {
+        _cache_clean_all(c);
+        bd_fast_mutex_destroy(&c->mutex);
+        X_FREE(c->key);
+        X_FREE(*pc);
+    }
+}
+
+static BD_MUTEX    shared_lock;   /* protects shared_caches and DISC_CACHE.ref. Initialized on first use. */
+static DISC_CACHE *shared_caches;
+
+static int _shared_lock(void)
+{
+    if (bd_mutex_init_once(&shared_lock) < 0) {
+        return -1;
+    }
+    return bd_mutex_lock(&shared_lock);
+}
+
+static void _shared_unlock(void)
+{
+    bd_mutex_unlock(&shared_lock);
+}
+
+static void _cache_release(DISC_CACHE **pc)
+{
+    DISC_CACHE *c = *pc;
+
+    if (!c) {
+        return;
+    }
+    *pc = NULL;
+
+    if (c->key) {
+        DISC_CACHE **pn;
+        unsigned ref;
+
+        /* cache was registered, so the lock has been initialized */
+        _shared_lock();
+        ref = --c->ref;
+        if (!ref) {
+            for (pn = &shared_caches; *pn; pn = &(*pn)->next) {
+                if (*pn == c) {
+                    *pn = c->next;
+                    break;
+                }
+            }
+        }
+        _shared_unlock();
+
+        if (ref) {
+            return;
+        }
+    }
+
+    _cache_free(&c);
+}
+
+/* returns shared cache for key (new reference) */
+static DISC_CACHE *_cache_get_shared(const char *key)
+{
+    DISC_CACHE *c, *n = NULL;
+
+    while (1) {
+        if (_shared_lock() < 0) {
+            _cache_free(&n);
+            return NULL;
+        }
+        for (c = shared_caches; c; c = c->next) {
+            if (!strcmp(c->key, key)) {
+                c->ref++;
+                break;
+            }
+        }
+        if (!c && n) {
+            n->next = shared_caches;
+            shared_caches = n;
+            c = n;
+            n = NULL;
+        }
+        _shared_unlock();
+
+        if (c) {
+            /* lost race to another thread ? */
+            _cache_free(&n);
+            return c;
+        }
+
+        /* allocate outside of lock */
+        n = _cache_new(key);
+        if (!n) {
+            return NULL;
+        }
+    }
+}
+
+int disc_cache_share(BD_DISC *p, const char *key)
+{
+    DISC_CACHE *c, *old;
+
+    if (!p) {
+        return -1;
+    }
+
+    if (key) {
+        c = _cache_get_shared(key);
+    } else {
+        c = _cache_new(NULL);
+    }
+    if (!c) {
+        BD_DEBUG(DBG_FILE | DBG_CRIT, "disc cache sharing not available\n");
+        return -1;
+    }
+
+    bd_mutex_lock(&p->cache_mutex);
+    old = p->cache;
+    p->cache = c;
+    bd_mutex_unlock(&p->cache_mutex);
+
+    _cache_release(&old);
+
+    BD_DEBUG(DBG_FILE, "using %s parsed object cache %s\n", key ? "shared" : "private", key ? key : "");
+    return 0;
+}
+
+int disc_cache_is_shared(BD_DISC *p)
+{
+    int shared;
+
+    bd_mutex_lock(&p->cache_mutex);
+    shared = p->cache && p->cache->key;
+    bd_mutex_unlock(&p->cache_mutex);
+
+    return shared;
+}
+
+void *disc_cache_get(BD_DISC *p, const char *name)
+{
+    DISC_CACHE_ENTRY *e;
+    DISC_CACHE *c;
+    void *data = NULL;
+
+    if (!p) {
+        return NULL;
+    }
+
+    bd_mutex_lock(&p->cache_mutex);
+    c = p->cache;
+    if (c) {
+        bd_fast_mutex_lock(&c->mutex);
+
+        e = *_cache_find(c, name);
+        if (e) {
+            e->last_use = ++c->tick;
+            data = e->data;
+            bd_refcnt_inc(data);
+        }
+
+        bd_fast_mutex_unlock(&c->mutex);
+    }
+    bd_mutex_unlock(&p->cache_mutex);
+
+    return data;
+}
+
+void disc_cache_put(BD_DISC *p, const char *name, void *data, size_t size)
+{
+    DISC_CACHE_ENTRY **pe, *e;
+    DISC_CACHE *c;
+
+    if (!p || !data || strlen(name) >= sizeof(e->name)) {
+        return;
+    }
+
+    e = calloc(1, sizeof(DISC_CACHE_ENTRY));
+    if (!e) {
+        return;
+    }
+
+    bd_refcnt_inc(data);
+    strcpy(e->name, name);
+    e->data = data;
+    e->size = size;
+
+    bd_mutex_lock(&p->cache_mutex);
+    c = p->cache;
+    if (!c) {
+        bd_mutex_unlock(&p->cache_mutex);
+        bd_refcnt_dec(data);
+        X_FREE(e);
+        return;
+    }
+    bd_fast_mutex_lock(&c->mutex);
+
+    pe = _cache_find(c, name);
+    if (*pe) {
+        _cache_remove(c, pe);
+    }
+
+    /* keep at least the new object */
+    while (c->size > 0 && c->size + size > c->max_size) {
+        _cache_evict_lru(c);
+    }
+
+    e->last_use = ++c->tick;
+    e->next     = c->entry[_cache_hash(name)];
+    c->entry[_cache_hash(name)] = e;
+    c->size += size;
+
+    bd_fast_mutex_unlock(&c->mutex);
+    bd_mutex_unlock(&p->cache_mutex);
+}
+
+void disc_cache_set_limit(BD_DISC *p, size_t max_size)
+{
+    DISC_CACHE *c;
+
+    if (!p) {
+        return;
+    }
+
+    bd_mutex_lock(&p->cache_mutex);
+    c = p->cache;
+    if (c) {
+        bd_fast_mutex_lock(&c->mutex);
+
+        c->max_size = max_size ? max_size : DISC_CACHE_MAX_SIZE;
+        while (c->size > c->max_size) {
+            _cache_evict_lru(c);
+        }
+
+        bd_fast_mutex_unlock(&c->mutex);
+    }
+    bd_mutex_unlock(&p->cache_mutex);
+}
+
+void disc_cache_clean(BD_DISC *p, const char *name)
+{
+    DISC_CACHE_ENTRY **pe;
+    DISC_CACHE *c;
+
+    if (!p) {
+        return;
+    }
+
+    bd_mutex_lock(&p->cache_mutex);
+    c = p->cache;
+    if (c) {
+        bd_fast_mutex_lock(&c->mutex);
+
+        if (!name) {
+            _cache_clean_all(c);
+        } else {
+            pe = _cache_find(c, name);
+            if (*pe) {
+                _cache_remove(c, pe);
+            }
+        }
+
+        bd_fast_mutex_unlock(&c->mutex);
+    }
+    bd_mutex_unlock(&p->cache_mutex);
+}
+
 /*
  * streams
  */
 
-BD_FILE_H *disc_open_stream(BD_DISC *disc, const char *file)
+/* unbuffered access to BD-ROM directory. NULL if not possible (file may be in overlay). */
+static BD_FILE_H *_open_stream_direct(BD_DISC *p, const char *file)
 {
-  BD_FILE_H *fp = disc_open_file(disc, "BDMV" DIR_SEP "STREAM", file);
+    BD_FILE_H *fp = NULL;
+    int        ovl;
+
+    /* application file I/O or UDF image (handled in udf_fs.c) */
+    if (p->pf_file_open_bdrom != _bdrom_open_path || file_open != file_open_default() || !p->disc_root) {
+        return NULL;
+    }
+
+    bd_mutex_lock(&p->ovl_mutex);
+    ovl = !!p->overlay_root;
+    bd_mutex_unlock(&p->ovl_mutex);
+
+    if (!ovl) {
+        char  buf[STR_PATH_BUF_SIZE];
+        char *abs_path = str_cat3(buf, sizeof(buf), p->disc_root, "BDMV" DIR_SEP "STREAM" DIR_SEP, file);
+        if (abs_path) {
+            fp = file_open_direct(abs_path);
+        }
+        str_cat_free(buf, abs_path);
+    }
+
+    return fp;
+}
+
+BD_FILE_H *disc_open_stream(BD_DISC *disc, const char *file, DEC_STATS *stats)
+{
+  BD_FILE_H *fp = NULL;
+
+  if (disc->direct_io) {
+      fp = _open_stream_direct(disc, file);
+  }
+  if (!fp) {
+      fp = disc_open_file(disc, "BDMV" DIR_SEP "STREAM", file);
+  }
   if (!fp) {
       return NULL;
   }
 
   if (disc->dec) {
-      BD_FILE_H *st = dec_open_stream(disc->dec, fp, atoi(file));
+      BD_FILE_H *st = dec_open_stream(disc->dec, fp, atoi(file), stats);
       if (st) {
           return st;
       }
@@ -486,6 +1729,23 @@ BD_FILE_H *disc_open_stream(BD_DISC *disc, const char *file)
   return fp;
 }
 
+void disc_prefetch_stream(BD_DISC *disc, const char *file, int64_t offset, int64_t size)
+{
+    BD_FILE_H *fp = disc_open_file(disc, "BDMV" DIR_SEP "STREAM", file);
+    if (fp) {
+        BD_DEBUG(DBG_FILE, "prefetch %s: %"PRId64" bytes at %"PRId64"\n", file, size, offset);
+        file_prefetch(fp, offset, size);
+        file_close(fp);
+    }
+}
+
+void disc_set_decrypt_threads(BD_DISC *disc, unsigned num_threads)
+{
+    if (disc->dec) {
+        dec_set_threads(disc->dec, num_threads);
+    }
+}
+
 const uint8_t *disc_get_data(BD_DISC *disc, int type)
 {
     if (disc->dec) {
@@ -494,6 +1754,19 @@ const uint8_t *disc_get_data(BD_DISC *disc, int type)
     return NULL;
 }
 
+uint64_t disc_dec_init_time(BD_DISC *disc)
+{
+    return disc->dec_init_us;
+}
+
+int disc_get_enc_info(BD_DISC *disc, struct bd_enc_info *enc_info)
+{
+    if (disc->dec) {
+        return dec_get_enc_info(disc->dec, enc_info);
+    }
+    return 0;
+}
+
 void disc_event(BD_DISC *disc, uint32_t event, uint32_t param)
 {
     if (disc->dec) {
@@ -28,6 +28,7 @@
 struct bd_file_s;
 struct bd_dir_s;
 struct bd_enc_info;
+struct dec_stats_s;
 
 /*
  * BluRay Virtual File System
@@ -40,9 +41,12 @@ typedef struct bd_disc BD_DISC;
 BD_PRIVATE BD_DISC *disc_open(const char *device_path,
                               void *read_blocks_handle,
                               int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks),
+                              void (*prefetch_blocks)(void *handle, int lba, int num_blocks),
                               struct bd_enc_info *enc_info,
                               const char *keyfile_path,
-                              void *regs, void *psr_read, void *psr_write);
+                              void *regs, void *psr_read, void *psr_write,
+                              int decrypt_flags,   /* DEC_INIT_* */
+                              int direct_io);      /* unbuffered stream file access */
 
 BD_PRIVATE void     disc_close(BD_DISC **);
 
@@ -63,11 +67,32 @@ BD_PRIVATE struct bd_dir_s *disc_open_dir (BD_DISC *disc, const char *dir);
 BD_PRIVATE size_t disc_read_file(BD_DISC *disc, const char *dir, const char *file,
                                   uint8_t **data);
 
-/* Update virtual package */
+/* Update virtual package. Cached state of files in old and new overlay is dropped. */
 BD_PRIVATE void disc_update(BD_DISC *disc, const char *overlay_root);
 
 BD_PRIVATE int  disc_cache_bdrom_file(BD_DISC *p, const char *rel_path, const char *cache_path);
 
+/* Copy BD-ROM file to local cache in background thread. Returns 0 if copy was queued. */
+BD_PRIVATE int  disc_cache_bdrom_file_async(BD_DISC *p, const char *rel_path, const char *cache_path);
+/* Wait for queued copy. Returns copy result (0 or -1), or 1 if cache_path was not queued. */
+BD_PRIVATE int  disc_cache_bdrom_file_wait(BD_DISC *p, const char *cache_path);
+
+/*
+ * cache of parsed (reference-counted) objects, keyed by file name
+ */
+
+/* returns new reference or NULL */
+BD_PRIVATE void *disc_cache_get(BD_DISC *disc, const char *name);
+/* cache takes own reference. size: approximate memory usage. */
+BD_PRIVATE void  disc_cache_put(BD_DISC *disc, const char *name, void *data, size_t size);
+/* limit cache memory usage (shared cache: all users). 0: use default limit. */
+BD_PRIVATE void  disc_cache_set_limit(BD_DISC *disc, size_t max_size);
+/* name == NULL: drop all objects */
+BD_PRIVATE void  disc_cache_clean(BD_DISC *disc, const char *name);
+/* share cache with other BD_DISC objects using the same key (disc identity). key == NULL: use private cache. */
+BD_PRIVATE int   disc_cache_share(BD_DISC *disc, const char *key);
+BD_PRIVATE int   disc_cache_is_shared(BD_DISC *disc);
+
 /* open BD-ROM directory (relative to disc root) */
 BD_PRIVATE struct bd_dir_s  *disc_open_bdrom_dir(BD_DISC *disc, const char *path);
 
@@ -75,7 +100,14 @@ BD_PRIVATE struct bd_dir_s  *disc_open_bdrom_dir(BD_DISC *disc, const char *path
  * m2ts stream interface
  */
 
-BD_PRIVATE struct bd_file_s *disc_open_stream(BD_DISC *disc, const char *file);
+/* stats (optional): decryption statistics, must stay valid until the stream is closed */
+BD_PRIVATE struct bd_file_s *disc_open_stream(BD_DISC *disc, const char *file, struct dec_stats_s *stats);
+
+/* hint that stream data will be needed soon (warm up OS cache / drive) */
+BD_PRIVATE void disc_prefetch_stream(BD_DISC *disc, const char *file, int64_t offset, int64_t size);
+
+/* set number of stream decryption threads */
+BD_PRIVATE void disc_set_decrypt_threads(BD_DISC *disc, unsigned num_threads);
 
 /*
  *
@@ -83,6 +115,12 @@ BD_PRIVATE struct bd_file_s *disc_open_stream(BD_DISC *disc, const char *file);
 
 BD_PRIVATE const uint8_t *disc_get_data(BD_DISC *, int type);
 
+/* Time spent in AACS/BD+ initialization when disc was opened (microseconds) */
+BD_PRIVATE uint64_t disc_dec_init_time(BD_DISC *);
+
+/* Returns 1 and fills enc_info if deferred (lazy_decrypt) AACS/BD+ initialization has been run */
+BD_PRIVATE int disc_get_enc_info(BD_DISC *, struct bd_enc_info *enc_info);
+
 enum {
     DISC_EVENT_START,       /* param: number of titles, 0 if playing with menus */
     DISC_EVENT_TITLE,       /* param: title number */
@@ -0,0 +1,314 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "read_ahead.h"
+
+#include "file/file.h"
+#include "util/buffer.h"
+#include "util/logging.h"
+#include "util/macro.h"
+#include "util/mutex.h"
+#include "util/thread.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RA_UNIT_SIZE   6144
+/*
+ * Size of single read request to source.
+ * Large requests are split to several concurrent device requests by the OS,
+ * so queue depth at device grows with request size.
+ */
+#define RA_MIN_READ_UNITS  32
+#define RA_MAX_READ_UNITS  256
+
+typedef struct {
+    BD_FILE_H  *fp;        /* source stream. Accessed only from worker thread after startup */
+
+    BD_MUTEX    mutex;
+    BD_COND     cond;
+    BD_THREAD   thread;
+
+    /* ring buffer */
+    uint8_t    *buf;
+    size_t      size;
+    size_t      start;     /* offset of first buffered byte */
+    size_t      len;       /* number of buffered bytes */
+    size_t      max_read;  /* max. size of single read from source */
+
+    uint64_t    pos;       /* stream position of first buffered byte */
+    int64_t     file_size;
+
+    unsigned    generation; /* incremented when buffer is invalidated */
+    uint8_t     eof;        /* source returned EOF or error at pos + len */
+    uint8_t     exit;
+} RA_STREAM;
+
+/*
+ * worker
+ */
+
+static void *_worker(void *p)
+{
+    RA_STREAM *st = (RA_STREAM *)p;
+
+    bd_mutex_lock(&st->mutex);
+
+    while (!st->exit) {
+
+        if (st->eof || st->len >= st->size) {
+            bd_cond_wait(&st->cond, &st->mutex);
+            continue;
+        }
+
+        /* read to contiguous free space at end of buffered data */
+        unsigned generation = st->generation;
+        uint64_t read_pos   = st->pos + st->len;
+        size_t   end        = (st->start + st->len) % st->size;
+        size_t   read_size  = BD_MIN(st->size - st->len, st->size - end);
+        read_size = BD_MIN(read_size, st->max_read);
+
+        bd_mutex_unlock(&st->mutex);
+
+        int64_t got = file_read_at(st->fp, read_pos, st->buf + end, read_size);
+
+        bd_mutex_lock(&st->mutex);
+
+        if (generation != st->generation) {
+            /* buffer was invalidated while reading */
+            continue;
+        }
+        if (got > 0) {
+            st->len += got;
+        }
+        if (got < (int64_t)read_size) {
+            st->eof = 1;
+        }
+        bd_cond_broadcast(&st->cond);
+    }
+
+    bd_mutex_unlock(&st->mutex);
+
+    return NULL;
+}
+
+/*
+ * BD_FILE_H
+ */
+
+static int64_t _ra_read(BD_FILE_H *fp, uint8_t *buf, int64_t size)
+{
+    RA_STREAM *st = (RA_STREAM *)fp->internal;
+    int64_t    result = 0;
+
+    if (size <= 0) {
+        return 0;
+    }
+
+    bd_mutex_lock(&st->mutex);
+
+    while (result < size) {
+
+        if (!st->len) {
+            if (st->eof) {
+                break;
+            }
+            bd_cond_wait(&st->cond, &st->mutex);
+            continue;
+        }
+
+        size_t chunk = BD_MIN(st->len, st->size - st->start);
+        chunk = (size_t)BD_MIN((int64_t)chunk, size - result);
+
+        memcpy(buf + result, st->buf + st->start, chunk);
+
+        result    += chunk;
+        st->start  = (st->start + chunk) % st->size;
+        st->len   -= chunk;
+        st->pos   += chunk;
+
+        bd_cond_broadcast(&st->cond);
+    }
+
+    bd_mutex_unlock(&st->mutex);
+
+    return result;
+}
+
+static int64_t _ra_seek(BD_FILE_H *fp, int64_t offset, int32_t origin)
+{
+    RA_STREAM *st = (RA_STREAM *)fp->internal;
+    int64_t    pos;
+
+    bd_mutex_lock(&st->mutex);
+
+    switch (origin) {
+        case SEEK_CUR: pos = (int64_t)st->pos + offset;  break;
+        case SEEK_END: pos = st->file_size + offset;     break;
+        case SEEK_SET:
+        default:       pos = offset;                     break;
+    }
+
+    if (pos < 0) {
+        bd_mutex_unlock(&st->mutex);
+        return -1;
+    }
+
+    if ((uint64_t)pos != st->pos) {
+        if ((uint64_t)pos > st->pos && (uint64_t)pos <= st->pos + st->len) {
+            /* skip forward inside buffered data */
+            size_t skip = (size_t)(pos - st->pos);
+            st->start = (st->start + skip) % st->size;
+            st->len  -= skip;
+        } else {
+            /* discard buffered data */
+            st->start = 0;
+            st->len   = 0;
+            st->eof   = 0;
+            st->generation++;
+        }
+        st->pos = pos;
+        bd_cond_broadcast(&st->cond);
+    }
+
+    bd_mutex_unlock(&st->mutex);
+
+    return pos;
+}
+
+static int64_t _ra_tell(BD_FILE_H *fp)
+{
+    RA_STREAM *st = (RA_STREAM *)fp->internal;
+    int64_t    pos;
+
+    bd_mutex_lock(&st->mutex);
+    pos = st->pos;
+    bd_mutex_unlock(&st->mutex);
+
+    return pos;
+}
+
+static void _ra_free(RA_STREAM *st)
+{
+    bd_cond_destroy(&st->cond);
+    bd_mutex_destroy(&st->mutex);
+    bd_buffer_free(st->buf, st->size);
+    X_FREE(st);
+}
+
+static void _ra_close(BD_FILE_H *fp)
+{
+    RA_STREAM *st = (RA_STREAM *)fp->internal;
+
+    bd_mutex_lock(&st->mutex);
+    st->exit = 1;
+    bd_cond_broadcast(&st->cond);
+    bd_mutex_unlock(&st->mutex);
+
+    bd_thread_join(&st->thread);
+
+    st->fp->close(st->fp);
+
+    _ra_free(st);
+    X_FREE(fp);
+}
+
+BD_FILE_H *read_ahead_open(BD_FILE_H *fp, unsigned num_units)
+{
+    RA_STREAM *st;
+    BD_FILE_H *p;
+    int64_t    pos;
+
+    if (!fp || !num_units) {
+        return fp;
+    }
+
+    pos = file_tell(fp);
+    if (pos < 0) {
+        return fp;
+    }
+
+    p  = calloc(1, sizeof(BD_FILE_H));
+    st = calloc(1, sizeof(RA_STREAM));
+    if (!p || !st) {
+        goto fail;
+    }
+
+    st->size = (size_t)num_units * RA_UNIT_SIZE;
+
+    /* read in quarters of the buffer: keeps the buffer mostly full and request size large */
+    st->max_read = BD_MAX(num_units / 4, RA_MIN_READ_UNITS);
+    st->max_read = BD_MIN(st->max_read, RA_MAX_READ_UNITS);
+    st->max_read = BD_MIN(st->max_read, num_units) * RA_UNIT_SIZE;
+    st->buf  = bd_buffer_alloc(st->size);
+    if (!st->buf) {
+        goto fail;
+    }
+
+    if (bd_mutex_init(&st->mutex) < 0) {
+        goto fail;
+    }
+    if (bd_cond_init(&st->cond) < 0) {
+        bd_mutex_destroy(&st->mutex);
+        goto fail;
+    }
+
+    st->fp        = fp;
+    st->pos       = pos;
+    st->file_size = file_size(fp);
+
+    if (bd_thread_create(&st->thread, "bd_read_ahead", _worker, st) < 0) {
+        _ra_free(st);
+        X_FREE(p);
+        return fp;
+    }
+
+    p->internal = st;
+    p->read  = _ra_read;
+    p->seek  = _ra_seek;
+    p->tell  = _ra_tell;
+    p->close = _ra_close;
+
+    BD_DEBUG(DBG_FILE, "read-ahead started (%u units)\n", num_units);
+
+    return p;
+
+ fail:
+    BD_DEBUG(DBG_FILE | DBG_CRIT, "read-ahead: out of memory\n");
+    if (st) {
+        bd_buffer_free(st->buf, st->size);
+    }
+    X_FREE(st);
+    X_FREE(p);
+    return fp;
+}
+
+size_t read_ahead_memory_size(BD_FILE_H *fp)
+{
+    if (!fp || fp->close != _ra_close) {
+        return 0;
+    }
+    return sizeof(RA_STREAM) + ((RA_STREAM *)fp->internal)->size;
+}
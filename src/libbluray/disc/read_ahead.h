@@ -0,0 +1,45 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined(_BD_DISC_READ_AHEAD_H_)
+#define _BD_DISC_READ_AHEAD_H_
+
+/*
+ * background read-ahead for sequential stream access
+ */
+
+#include "util/attributes.h"
+
+#include <stddef.h>
+
+struct bd_file_s;
+
+/*
+ * Wrap stream in read-ahead layer.
+ * Worker thread keeps up to num_units aligned units buffered ahead of current read position.
+ * Seeking discards buffered data.
+ * Wrapped stream is closed when returned stream is closed.
+ * Returns original stream if read-ahead could not be started.
+ */
+BD_PRIVATE struct bd_file_s *read_ahead_open(struct bd_file_s *fp, unsigned num_units);
+
+/* read-ahead buffer size of stream returned by read_ahead_open(). 0 if stream is not read-ahead layer. */
+BD_PRIVATE size_t read_ahead_memory_size(struct bd_file_s *fp);
+
+#endif /* _BD_DISC_READ_AHEAD_H_ */
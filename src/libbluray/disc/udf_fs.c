@@ -24,9 +24,11 @@
 #include "udf_fs.h"
 
 #include "file/file.h"
+#include "file/io_trace.h"
 #include "util/macro.h"
 #include "util/mutex.h"
 #include "util/logging.h"
+#include "util/time.h"
 
 #include "udfread.h"
 #include "blockinput.h"
@@ -36,14 +38,38 @@
 #include <string.h>
 #include <inttypes.h>
 
+/*
+ * disc image
+ */
+
+#define UDF_MAX_READ_BLOCKS  (64*1024*1024 / UDF_BLOCK_SIZE)  /* single request size limit */
+
+typedef struct {
+    udfread *udf;
+
+    /* block input (NULL if image was opened by libudfread) */
+    struct udfread_block_input *input;
+
+    /* optional read-ahead hint for application stream input */
+    void  *read_block_handle;
+    void (*prefetch_blocks)(void *handle, int lba, int num_blocks);
+} UDF_IMAGE;
+
 /*
  * file access
  */
 
+typedef struct {
+    UDFFILE   *fp;
+    UDF_IMAGE *img;
+} UDF_FILE;
+
 static void _file_close(BD_FILE_H *file)
 {
     if (file) {
-        udfread_file_close((UDFFILE*)file->internal);
+        UDF_FILE *f = (UDF_FILE *)file->internal;
+        udfread_file_close(f->fp);
+        X_FREE(f);
         BD_DEBUG(DBG_FILE, "Closed UDF file (%p)\n", (void*)file);
         X_FREE(file);
     }
@@ -51,22 +77,155 @@ static void _file_close(BD_FILE_H *file)
 
 static int64_t _file_seek(BD_FILE_H *file, int64_t offset, int32_t origin)
 {
-    return udfread_file_seek((UDFFILE*)file->internal, offset, origin);
+    return udfread_file_seek(((UDF_FILE*)file->internal)->fp, offset, origin);
 }
 
 static int64_t _file_tell(BD_FILE_H *file)
 {
-    return udfread_file_tell((UDFFILE*)file->internal);
+    return udfread_file_tell(((UDF_FILE*)file->internal)->fp);
 }
 
 static int64_t _file_read(BD_FILE_H *file, uint8_t *buf, int64_t size)
 {
-    return udfread_file_read((UDFFILE*)file->internal, buf, size);
+    return udfread_file_read(((UDF_FILE*)file->internal)->fp, buf, size);
+}
+
+/*
+ * Positional read directly from block input.
+ * Contiguous file blocks are read with single request.
+ * Inline files, unrecorded (sparse) areas and partial last block are read with libudfread.
+ */
+static int64_t _file_read_at(BD_FILE_H *file, int64_t offset, uint8_t *buf, int64_t size)
+{
+    UDF_FILE *f = (UDF_FILE *)file->internal;
+    struct udfread_block_input *input = f->img->input;
+    int64_t   file_size = udfread_file_size(f->fp);
+    int64_t   done = 0;
+    uint32_t  block;
+
+    if (offset < 0 || size < 0 || file_size < 0) {
+        return -1;
+    }
+    if (offset >= file_size) {
+        return 0;
+    }
+    size = BD_MIN(size, file_size - offset);
+
+    /* unaligned: let libudfread handle partial blocks */
+    if ((offset % UDF_BLOCK_SIZE) || ((size % UDF_BLOCK_SIZE) && offset + size < file_size)) {
+        if (udfread_file_seek(f->fp, offset, SEEK_SET) < 0) {
+            return -1;
+        }
+        return udfread_file_read(f->fp, buf, (size_t)size);
+    }
+
+    block = (uint32_t)(offset / UDF_BLOCK_SIZE);
+
+    while (size - done >= UDF_BLOCK_SIZE) {
+        uint32_t lba = udfread_file_lba(f->fp, block);
+        uint32_t num_blocks = 1;
+        uint32_t max_blocks = (uint32_t)BD_MIN((size - done) / UDF_BLOCK_SIZE, UDF_MAX_READ_BLOCKS);
+        int      got;
+
+        if (!lba) {
+            /* no disc block (inline file or unrecorded area) */
+            break;
+        }
+        while (num_blocks < max_blocks && udfread_file_lba(f->fp, block + num_blocks) == lba + num_blocks) {
+            num_blocks++;
+        }
+
+        got = input->read(input, lba, buf + done, num_blocks, 0);
+        if (got <= 0) {
+            BD_DEBUG(DBG_FILE | DBG_CRIT, "read error at lba %u\n", lba);
+            return done > 0 ? done : -1;
+        }
+        done  += (int64_t)got * UDF_BLOCK_SIZE;
+        block += got;
+        if ((uint32_t)got < num_blocks) {
+            return done;
+        }
+    }
+
+    if (done < size) {
+        int64_t got;
+        if (udfread_file_seek(f->fp, offset + done, SEEK_SET) < 0) {
+            return done > 0 ? done : -1;
+        }
+        got = udfread_file_read(f->fp, buf + done, (size_t)(size - done));
+        if (got < 0) {
+            return done > 0 ? done : -1;
+        }
+        done += got;
+    }
+
+    return done;
+}
+
+/* translate file range to disc blocks and pass hint to application */
+static void _file_prefetch(BD_FILE_H *file, int64_t offset, int64_t size)
+{
+    UDF_FILE *f = (UDF_FILE *)file->internal;
+    int64_t   file_size = udfread_file_size(f->fp);
+    uint32_t  block, end;
+    uint32_t  run_lba = 0, run_len = 0;
+
+    if (offset < 0 || size <= 0 || offset >= file_size) {
+        return;
+    }
+    size = BD_MIN(size, file_size - offset);
+
+    block = (uint32_t)(offset / UDF_BLOCK_SIZE);
+    end   = (uint32_t)((offset + size + UDF_BLOCK_SIZE - 1) / UDF_BLOCK_SIZE);
+
+    for (; block < end; block++) {
+        uint32_t lba = udfread_file_lba(f->fp, block);
+        if (!lba) {
+            /* no disc block (inline file or unrecorded area) */
+            if (run_len) {
+                f->img->prefetch_blocks(f->img->read_block_handle, run_lba, run_len);
+            }
+            run_len = 0;
+            continue;
+        }
+        if (run_len && lba == run_lba + run_len) {
+            run_len++;
+            continue;
+        }
+        if (run_len) {
+            f->img->prefetch_blocks(f->img->read_block_handle, run_lba, run_len);
+        }
+        run_lba = lba;
+        run_len = 1;
+    }
+
+    if (run_len) {
+        f->img->prefetch_blocks(f->img->read_block_handle, run_lba, run_len);
+    }
 }
 
 BD_FILE_H *udf_file_open(void *udf, const char *filename)
 {
-    BD_FILE_H *file = calloc(1, sizeof(BD_FILE_H));
+    UDF_IMAGE *img = (UDF_IMAGE *)udf;
+    BD_FILE_H *file;
+    UDF_FILE  *f;
+
+    if (img->input) {
+        BD_FILE_EXT_H *ext = file_ext_alloc();
+        if (ext) {
+            ext->read_at  = _file_read_at;
+            ext->prefetch = img->prefetch_blocks ? _file_prefetch : NULL;
+        }
+        file = (BD_FILE_H *)ext;
+    } else {
+        file = calloc(1, sizeof(BD_FILE_H));
+    }
+    f = calloc(1, sizeof(UDF_FILE));
+    if (!file || !f) {
+        X_FREE(file);
+        X_FREE(f);
+        return NULL;
+    }
 
     BD_DEBUG(DBG_FILE, "Opening UDF file %s... (%p)\n", filename, (void*)file);
 
@@ -75,13 +234,16 @@ BD_FILE_H *udf_file_open(void *udf, const char *filename)
     file->read  = _file_read;
     file->write = NULL;
     file->tell  = _file_tell;
-    file->eof   = NULL;
 
-    file->internal = udfread_file_open((udfread*)udf, filename);
-    if (!file->internal) {
+    f->img = img;
+    f->fp  = udfread_file_open(img->udf, filename);
+    if (!f->fp) {
         BD_DEBUG(DBG_FILE, "Error opening file %s!\n", filename);
+        X_FREE(f);
         X_FREE(file);
+        return NULL;
     }
+    file->internal = f;
 
     return file;
 }
@@ -122,7 +284,7 @@ BD_DIR_H *udf_dir_open(void *udf, const char* dirname)
     dir->close = _dir_close;
     dir->read  = _dir_read;
 
-    dir->internal = udfread_opendir((udfread*)udf, dirname);
+    dir->internal = udfread_opendir(((UDF_IMAGE*)udf)->udf, dirname);
     if (!dir->internal) {
         BD_DEBUG(DBG_DIR, "Error opening %s\n", dirname);
         X_FREE(dir);
@@ -135,9 +297,12 @@ BD_DIR_H *udf_dir_open(void *udf, const char* dirname)
  * UDF image access
  */
 
+#define UDF_DIRECT_MIN_READ  16   /* blocks. Smaller reads (metadata) use buffered file. */
+
 typedef struct {
     struct udfread_block_input i;
     BD_FILE_H *fp;
+    BD_FILE_H *fp_direct;   /* unbuffered handle for stream data (optional) */
     BD_MUTEX mutex;
 } UDF_BI;
 
@@ -145,6 +310,9 @@ static int _bi_close(struct udfread_block_input *bi_gen)
 {
     UDF_BI *bi = (UDF_BI *)bi_gen;
     file_close(bi->fp);
+    if (bi->fp_direct) {
+        file_close(bi->fp_direct);
+    }
     bd_mutex_destroy(&bi->mutex);
     X_FREE(bi);
     return 0;
@@ -161,15 +329,23 @@ static int _bi_read(struct udfread_block_input *bi_gen, uint32_t lba, void *buf,
     (void)flags;
     UDF_BI *bi = (UDF_BI *)bi_gen;
     int got = -1;
+    int64_t bytes;
 
-    /* seek + read must be atomic */
-    bd_mutex_lock(&bi->mutex);
-
-    if (file_seek(bi->fp, SEEK_SET, (int64_t)lba * UDF_BLOCK_SIZE) >= 0) {
-        int64_t bytes = file_read(bi->fp, (uint8_t*)buf, (int64_t)nblocks * UDF_BLOCK_SIZE);
+    /* direct file supports concurrent positional reads */
+    if (bi->fp_direct && nblocks >= UDF_DIRECT_MIN_READ) {
+        bytes = file_read_at(bi->fp_direct, (int64_t)lba * UDF_BLOCK_SIZE, (uint8_t*)buf, (int64_t)nblocks * UDF_BLOCK_SIZE);
         if (bytes > 0) {
-            got = bytes / UDF_BLOCK_SIZE;
+            return bytes / UDF_BLOCK_SIZE;
         }
+        /* fall back to buffered read */
+    }
+
+    /* seek + read must be atomic (file_read_at() may fall back to seek + read) */
+    bd_mutex_lock(&bi->mutex);
+
+    bytes = file_read_at(bi->fp, (int64_t)lba * UDF_BLOCK_SIZE, (uint8_t*)buf, (int64_t)nblocks * UDF_BLOCK_SIZE);
+    if (bytes > 0) {
+        got = bytes / UDF_BLOCK_SIZE;
     }
 
     bd_mutex_unlock(&bi->mutex);
@@ -177,7 +353,7 @@ static int _bi_read(struct udfread_block_input *bi_gen, uint32_t lba, void *buf,
     return got;
 }
 
-static struct udfread_block_input *_block_input(const char *img)
+static struct udfread_block_input *_block_input(const char *img, int direct_io)
 {
     BD_FILE_H *fp = file_open(img, "rb");
     if (fp) {
@@ -188,6 +364,11 @@ static struct udfread_block_input *_block_input(const char *img)
             bi->i.read  = _bi_read;
             bi->i.size  = _bi_size;
             bd_mutex_init(&bi->mutex);
+
+            /* application file I/O is never bypassed */
+            if (direct_io && file_open == file_open_default()) {
+                bi->fp_direct = file_open_direct(img);
+            }
             return &bi->i;
         }
         file_close(fp);
@@ -229,36 +410,258 @@ static struct udfread_block_input *_stream_input(void *read_block_handle,
     return NULL;
 }
 
+/*
+ * I/O trace
+ */
+
+typedef struct {
+    struct udfread_block_input  i;
+    struct udfread_block_input *input;
+    void *trace;
+} UDF_TI;
+
+static int _ti_close(struct udfread_block_input *bi_gen)
+{
+    UDF_TI *ti = (UDF_TI *)bi_gen;
+    int result = ti->input->close(ti->input);
+    io_trace_unref(ti->trace);
+    X_FREE(ti);
+    return result;
+}
+
+static uint32_t _ti_size(struct udfread_block_input *bi_gen)
+{
+    UDF_TI *ti = (UDF_TI *)bi_gen;
+    return ti->input->size(ti->input);
+}
+
+static int _ti_read(struct udfread_block_input *bi_gen, uint32_t lba, void *buf, uint32_t nblocks, int flags)
+{
+    UDF_TI *ti = (UDF_TI *)bi_gen;
+    uint64_t t = bd_get_time_us();
+    int got;
+
+    got = ti->input->read(ti->input, lba, buf, nblocks, flags);
+    io_trace_block(ti->trace, t, lba, nblocks, got);
+
+    return got;
+}
+
+/* record raw block reads (below cache) when I/O trace is active */
+static struct udfread_block_input *_trace_input(struct udfread_block_input *input)
+{
+    UDF_TI *ti;
+    void   *trace;
+
+    if (!input || !(trace = io_trace_ref())) {
+        return input;
+    }
+
+    ti = calloc(1, sizeof(*ti));
+    if (!ti) {
+        io_trace_unref(trace);
+        return input;
+    }
+
+    ti->input   = input;
+    ti->trace   = trace;
+    ti->i.close = _ti_close;
+    ti->i.read  = _ti_read;
+    ti->i.size  = input->size ? _ti_size : NULL;
+
+    return &ti->i;
+}
+
+
+/*
+ * small LRU block cache for metadata reads
+ *
+ * libudfread re-reads file entries and directory blocks each time a file is opened.
+ * Large (stream data) reads bypass the cache.
+ * Adjacent missing blocks are fetched with single read.
+ */
+
+#define UDF_CACHE_BLOCKS    128  /* 256 KB */
+#define UDF_CACHE_MAX_READ  2    /* larger reads are not cached */
+
+typedef struct {
+    uint32_t lba;
+    uint32_t last_use;  /* 0 = unused entry */
+} UDF_CACHE_ENTRY;
+
+typedef struct {
+    struct udfread_block_input  i;
+    struct udfread_block_input *input;
+
+    BD_MUTEX        mutex;
+    uint32_t        tick;
+    UDF_CACHE_ENTRY entry[UDF_CACHE_BLOCKS];
+    uint8_t         data[UDF_CACHE_BLOCKS][UDF_BLOCK_SIZE];
+    uint8_t         tmp[UDF_CACHE_MAX_READ * UDF_BLOCK_SIZE];
+} UDF_CI;
+
+static int _ci_close(struct udfread_block_input *bi_gen)
+{
+    UDF_CI *ci = (UDF_CI *)bi_gen;
+    int result = ci->input->close(ci->input);
+    bd_mutex_destroy(&ci->mutex);
+    X_FREE(ci);
+    return result;
+}
+
+static uint32_t _ci_size(struct udfread_block_input *bi_gen)
+{
+    UDF_CI *ci = (UDF_CI *)bi_gen;
+    return ci->input->size(ci->input);
+}
+
+static int _ci_find(const UDF_CI *ci, uint32_t lba)
+{
+    unsigned ii;
+    for (ii = 0; ii < UDF_CACHE_BLOCKS; ii++) {
+        if (ci->entry[ii].last_use && ci->entry[ii].lba == lba) {
+            return ii;
+        }
+    }
+    return -1;
+}
+
+static void _ci_store(UDF_CI *ci, uint32_t lba, const uint8_t *data)
+{
+    unsigned ii, lru = 0;
+
+    for (ii = 1; ii < UDF_CACHE_BLOCKS && ci->entry[lru].last_use; ii++) {
+        if (ci->entry[ii].last_use < ci->entry[lru].last_use) {
+            lru = ii;
+        }
+    }
+
+    ci->entry[lru].lba      = lba;
+    ci->entry[lru].last_use = ++ci->tick;
+    memcpy(ci->data[lru], data, UDF_BLOCK_SIZE);
+}
+
+static int _ci_read(struct udfread_block_input *bi_gen, uint32_t lba, void *buf, uint32_t nblocks, int flags)
+{
+    UDF_CI   *ci  = (UDF_CI *)bi_gen;
+    uint8_t  *dst = (uint8_t *)buf;
+    uint32_t  ii  = 0;
+    int       got = -1;
+
+    if (nblocks > UDF_CACHE_MAX_READ) {
+        return ci->input->read(ci->input, lba, buf, nblocks, flags);
+    }
+
+    bd_mutex_lock(&ci->mutex);
+
+    /* tick wrap-around: forget everything */
+    if (ci->tick > UINT32_MAX - UDF_CACHE_BLOCKS) {
+        memset(ci->entry, 0, sizeof(ci->entry));
+        ci->tick = 0;
+    }
+
+    while (ii < nblocks) {
+        int      e = _ci_find(ci, lba + ii);
+        uint32_t run, jj;
+
+        if (e >= 0) {
+            ci->entry[e].last_use = ++ci->tick;
+            memcpy(dst + ii * UDF_BLOCK_SIZE, ci->data[e], UDF_BLOCK_SIZE);
+            ii++;
+            continue;
+        }
+
+        /* coalesce adjacent missing blocks */
+        for (run = 1; ii + run < nblocks && _ci_find(ci, lba + ii + run) < 0; run++) ;
+
+        got = ci->input->read(ci->input, lba + ii, ci->tmp, run, flags);
+        if (got <= 0) {
+            break;
+        }
+        if ((uint32_t)got > run) {
+            got = run;
+        }
+
+        for (jj = 0; jj < (uint32_t)got; jj++) {
+            _ci_store(ci, lba + ii + jj, ci->tmp + jj * UDF_BLOCK_SIZE);
+        }
+        memcpy(dst + ii * UDF_BLOCK_SIZE, ci->tmp, (size_t)got * UDF_BLOCK_SIZE);
+        ii += got;
+
+        if ((uint32_t)got < run) {
+            break;
+        }
+    }
+
+    bd_mutex_unlock(&ci->mutex);
+
+    return ii > 0 ? (int)ii : got;
+}
+
+static struct udfread_block_input *_cache_input(struct udfread_block_input *input)
+{
+    UDF_CI *ci;
+
+    if (!input) {
+        return NULL;
+    }
+
+    ci = calloc(1, sizeof(*ci));
+    if (!ci) {
+        /* run without cache */
+        return input;
+    }
+
+    ci->input   = input;
+    ci->i.close = _ci_close;
+    ci->i.read  = _ci_read;
+    ci->i.size  = input->size ? _ci_size : NULL;
+    bd_mutex_init(&ci->mutex);
+
+    return &ci->i;
+}
+
 
 void *udf_image_open(const char *img_path,
                      void *read_block_handle,
-                     int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks))
+                     int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks),
+                     void (*prefetch_blocks)(void *handle, int lba, int num_blocks),
+                     int direct_io)
 {
+    UDF_IMAGE *img = calloc(1, sizeof(UDF_IMAGE));
     udfread *udf = udfread_init();
     int result = -1;
 
-    if (!udf) {
+    if (!udf || !img) {
+        if (udf) {
+            udfread_close(udf);
+        }
+        X_FREE(img);
         return NULL;
     }
 
     /* stream ? */
     if (read_blocks) {
-        struct udfread_block_input *si = _stream_input(read_block_handle, read_blocks);
+        struct udfread_block_input *si = _cache_input(_trace_input(_stream_input(read_block_handle, read_blocks)));
         if (si) {
             result = udfread_open_input(udf, si);
             if (result < 0) {
                 si->close(si);
+            } else {
+                img->input = si;
             }
         }
     } else {
 
-    /* app handles file I/O ? */
-    if (result < 0 && file_open != file_open_default()) {
-        struct udfread_block_input *bi = _block_input(img_path);
+    /* app handles file I/O (or I/O trace is active) or direct I/O requested ? */
+    if (result < 0 && (file_open != file_open_default() || direct_io)) {
+        struct udfread_block_input *bi = _cache_input(_trace_input(_block_input(img_path, direct_io)));
         if (bi) {
             result = udfread_open_input(udf, bi);
             if (result < 0) {
                 bi->close(bi);
+            } else {
+                img->input = bi;
             }
         }
     }
@@ -270,18 +673,29 @@ void *udf_image_open(const char *img_path,
 
     if (result < 0) {
         udfread_close(udf);
+        X_FREE(img);
         return NULL;
     }
 
-    return (void*)udf;
+    img->udf = udf;
+    if (read_blocks && prefetch_blocks) {
+        img->read_block_handle = read_block_handle;
+        img->prefetch_blocks   = prefetch_blocks;
+    }
+
+    return (void*)img;
 }
 
 const char *udf_volume_id(void *udf)
 {
-    return udfread_get_volume_id((udfread*)udf);
+    return udfread_get_volume_id(((UDF_IMAGE*)udf)->udf);
 }
 
 void udf_image_close(void *udf)
 {
-    udfread_close((udfread*)udf);
+    UDF_IMAGE *img = (UDF_IMAGE *)udf;
+    if (img) {
+        udfread_close(img->udf);
+        X_FREE(img);
+    }
 }
@@ -27,7 +27,9 @@ struct bd_dir_s;
 
 BD_PRIVATE void *udf_image_open(const char *img_path,
                                 void *read_block_handle,
-                                 int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks));
+                                int (*read_blocks)(void *handle, void *buf, int lba, int num_blocks),
+                                void (*prefetch_blocks)(void *handle, int lba, int num_blocks),
+                                int direct_io);  /* use unbuffered I/O for stream data */
 BD_PRIVATE void  udf_image_close(void *udf);
 
 BD_PRIVATE const char       *udf_volume_id(void *udf);
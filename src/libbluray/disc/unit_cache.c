@@ -0,0 +1,245 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "unit_cache.h"
+
+#include "util/buffer.h"
+#include "util/logging.h"
+#include "util/macro.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UNIT_SIZE  6144
+#define NO_ENTRY   ((unsigned)-1)
+
+typedef struct {
+    uint64_t key;
+    unsigned prev;  /* LRU list, towards most recently used */
+    unsigned next;  /* LRU list, towards least recently used */
+    unsigned hnext; /* hash chain */
+} UC_ENTRY;
+
+struct unit_cache_s {
+    unsigned  num_units;
+    unsigned  used;       /* number of entries in use */
+    unsigned  hash_size;  /* power of 2 */
+    unsigned *hash;
+    UC_ENTRY *entry;
+    uint8_t  *data;
+
+    unsigned  head;       /* most recently used */
+    unsigned  tail;       /* least recently used */
+
+    uint64_t  hits;
+    uint64_t  misses;
+};
+
+static uint64_t _key(uint32_t clip_id, uint64_t pos)
+{
+    return ((uint64_t)clip_id << 40) | (pos / UNIT_SIZE);
+}
+
+static unsigned _hash(const UNIT_CACHE *c, uint64_t key)
+{
+    /* units of the same clip are mostly accessed in sequence */
+    key ^= key >> 29;
+    key *= UINT64_C(0x9e3779b97f4a7c15);
+    return (unsigned)(key >> 32) & (c->hash_size - 1);
+}
+
+static void _lru_unlink(UNIT_CACHE *c, unsigned i)
+{
+    UC_ENTRY *e = &c->entry[i];
+
+    if (e->prev != NO_ENTRY) {
+        c->entry[e->prev].next = e->next;
+    } else {
+        c->head = e->next;
+    }
+    if (e->next != NO_ENTRY) {
+        c->entry[e->next].prev = e->prev;
+    } else {
+        c->tail = e->prev;
+    }
+}
+
+static void _lru_push_front(UNIT_CACHE *c, unsigned i)
+{
+    UC_ENTRY *e = &c->entry[i];
+
+    e->prev = NO_ENTRY;
+    e->next = c->head;
+    if (c->head != NO_ENTRY) {
+        c->entry[c->head].prev = i;
+    } else {
+        c->tail = i;
+    }
+    c->head = i;
+}
+
+static void _hash_remove(UNIT_CACHE *c, unsigned i)
+{
+    unsigned *pi = &c->hash[_hash(c, c->entry[i].key)];
+
+    while (*pi != NO_ENTRY) {
+        if (*pi == i) {
+            *pi = c->entry[i].hnext;
+            return;
+        }
+        pi = &c->entry[*pi].hnext;
+    }
+}
+
+static unsigned _find(UNIT_CACHE *c, uint64_t key)
+{
+    unsigned i = c->hash[_hash(c, key)];
+
+    while (i != NO_ENTRY && c->entry[i].key != key) {
+        i = c->entry[i].hnext;
+    }
+    return i;
+}
+
+UNIT_CACHE *unit_cache_init(unsigned num_units)
+{
+    UNIT_CACHE *c;
+    unsigned    ii;
+
+    if (!num_units) {
+        return NULL;
+    }
+
+    c = calloc(1, sizeof(*c));
+    if (!c) {
+        return NULL;
+    }
+
+    c->num_units = num_units;
+    c->hash_size = 1;
+    while (c->hash_size < num_units) {
+        c->hash_size <<= 1;
+    }
+
+    c->hash  = malloc(c->hash_size * sizeof(*c->hash));
+    c->entry = calloc(num_units, sizeof(*c->entry));
+    c->data  = bd_buffer_alloc((size_t)num_units * UNIT_SIZE);
+    if (!c->hash || !c->entry || !c->data) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "out of memory\n");
+        unit_cache_free(&c);
+        return NULL;
+    }
+
+    for (ii = 0; ii < c->hash_size; ii++) {
+        c->hash[ii] = NO_ENTRY;
+    }
+    c->head = c->tail = NO_ENTRY;
+
+    return c;
+}
+
+void unit_cache_free(UNIT_CACHE **pp)
+{
+    if (pp && *pp) {
+        UNIT_CACHE *c = *pp;
+
+        BD_DEBUG(DBG_BLURAY, "unit cache: %"PRIu64" hits, %"PRIu64" misses\n", c->hits, c->misses);
+
+        X_FREE(c->hash);
+        X_FREE(c->entry);
+        bd_buffer_free(c->data, (size_t)c->num_units * UNIT_SIZE);
+        X_FREE(*pp);
+    }
+}
+
+int unit_cache_lookup(UNIT_CACHE *c, uint32_t clip_id, uint64_t pos, uint8_t *buf)
+{
+    unsigned i = _find(c, _key(clip_id, pos));
+
+    if (i == NO_ENTRY) {
+        c->misses++;
+        return 0;
+    }
+
+    c->hits++;
+
+    if (c->head != i) {
+        _lru_unlink(c, i);
+        _lru_push_front(c, i);
+    }
+
+    memcpy(buf, c->data + (size_t)i * UNIT_SIZE, UNIT_SIZE);
+    return 1;
+}
+
+void unit_cache_insert(UNIT_CACHE *c, uint32_t clip_id, uint64_t pos, const uint8_t *buf)
+{
+    uint64_t key = _key(clip_id, pos);
+    unsigned i   = _find(c, key);
+    unsigned h;
+
+    if (i != NO_ENTRY) {
+        /* refresh existing entry */
+        _lru_unlink(c, i);
+
+    } else {
+        if (c->used < c->num_units) {
+            i = c->used++;
+        } else {
+            /* evict least recently used unit */
+            i = c->tail;
+            _lru_unlink(c, i);
+            _hash_remove(c, i);
+        }
+
+        c->entry[i].key = key;
+        h = _hash(c, key);
+        c->entry[i].hnext = c->hash[h];
+        c->hash[h] = i;
+    }
+
+    _lru_push_front(c, i);
+    memcpy(c->data + (size_t)i * UNIT_SIZE, buf, UNIT_SIZE);
+}
+
+void unit_cache_stats(UNIT_CACHE *c, uint64_t *hits, uint64_t *misses)
+{
+    *hits   = c ? c->hits : 0;
+    *misses = c ? c->misses : 0;
+}
+
+unsigned unit_cache_size(UNIT_CACHE *c)
+{
+    return c ? c->num_units : 0;
+}
+
+size_t unit_cache_memory_size(UNIT_CACHE *c)
+{
+    if (!c) {
+        return 0;
+    }
+    return sizeof(*c) + c->hash_size * sizeof(*c->hash) +
+           c->num_units * (sizeof(*c->entry) + (size_t)UNIT_SIZE);
+}
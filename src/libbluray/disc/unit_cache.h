@@ -0,0 +1,49 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+#if !defined(_BD_DISC_UNIT_CACHE_H_)
+#define _BD_DISC_UNIT_CACHE_H_
+
+/*
+ * size-bounded LRU cache of decrypted aligned units
+ */
+
+#include "util/attributes.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct unit_cache_s UNIT_CACHE;
+
+/* Units are identified by clip (m2ts file) id and byte position in the clip file */
+
+BD_PRIVATE UNIT_CACHE *unit_cache_init(unsigned num_units);
+BD_PRIVATE void        unit_cache_free(UNIT_CACHE **);
+
+/* copy cached unit to buf. Returns 1 on hit, 0 on miss. */
+BD_PRIVATE int  unit_cache_lookup(UNIT_CACHE *, uint32_t clip_id, uint64_t pos, uint8_t *buf);
+BD_PRIVATE void unit_cache_insert(UNIT_CACHE *, uint32_t clip_id, uint64_t pos, const uint8_t *buf);
+
+BD_PRIVATE void unit_cache_stats(UNIT_CACHE *, uint64_t *hits, uint64_t *misses);
+
+BD_PRIVATE unsigned unit_cache_size(UNIT_CACHE *); /* capacity (units) */
+BD_PRIVATE size_t unit_cache_memory_size(UNIT_CACHE *);
+
+#endif /* _BD_DISC_UNIT_CACHE_H_ */
@@ -0,0 +1,292 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fanout.h"
+
+#include "util/logging.h"
+#include "util/macro.h"
+#include "util/mutex.h"
+#include "util/thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SLOT_SIZE  (16 * 6144)  /* 16 aligned units */
+#define MIN_SLOTS  2
+
+typedef struct {
+    uint8_t  *data;
+    int       len;
+    unsigned  refs;      /* readers that have not yet consumed this slot */
+} FANOUT_SLOT;
+
+typedef struct {
+    uint64_t  seq;       /* next slot to read */
+    int       off;       /* read offset in slot */
+    uint8_t   attached;
+} FANOUT_CURSOR;
+
+struct bd_fanout_s {
+    fanout_read_f  read;
+    void          *handle;
+
+    BD_MUTEX       mutex;
+    BD_COND        cond;     /* slot filled or released */
+    BD_THREAD      thread;
+    int            running;
+    int            exit;
+
+    uint8_t        end;      /* producer has finished */
+    int            result;   /* final read result: 0 = EOF, -1 = error */
+
+    FANOUT_SLOT   *slots;
+    unsigned       num_slots;
+    uint64_t       head;     /* next slot to be filled */
+
+    FANOUT_CURSOR *cursors;
+    unsigned       num_readers;
+    unsigned       num_attached;
+};
+
+static void *_producer(void *arg)
+{
+    BD_FANOUT *p = (BD_FANOUT *)arg;
+
+    bd_mutex_lock(&p->mutex);
+
+    while (!p->exit && p->num_attached) {
+        FANOUT_SLOT *slot = &p->slots[p->head % p->num_slots];
+        int          r;
+
+        if (slot->refs) {
+            /* ring full: wait for slowest reader */
+            bd_cond_wait(&p->cond, &p->mutex);
+            continue;
+        }
+
+        bd_mutex_unlock(&p->mutex);
+        r = p->read(p->handle, slot->data, SLOT_SIZE);
+        bd_mutex_lock(&p->mutex);
+
+        if (r <= 0) {
+            p->result = r < 0 ? -1 : 0;
+            break;
+        }
+
+        slot->len  = r;
+        slot->refs = p->num_attached;
+        p->head++;
+        bd_cond_broadcast(&p->cond);
+    }
+
+    p->end = 1;
+    bd_cond_broadcast(&p->cond);
+
+    bd_mutex_unlock(&p->mutex);
+
+    return NULL;
+}
+
+static void _free_slots(BD_FANOUT *p)
+{
+    unsigned ii;
+
+    if (p->slots) {
+        for (ii = 0; ii < p->num_slots; ii++) {
+            X_FREE(p->slots[ii].data);
+        }
+    }
+    X_FREE(p->slots);
+    X_FREE(p->cursors);
+}
+
+BD_FANOUT *fanout_init(fanout_read_f read, void *handle, unsigned num_readers, unsigned ring_size)
+{
+    BD_FANOUT *p;
+    unsigned   ii;
+
+    if (!num_readers) {
+        return NULL;
+    }
+
+    p = calloc(1, sizeof(*p));
+    if (!p) {
+        return NULL;
+    }
+
+    p->read         = read;
+    p->handle       = handle;
+    p->num_slots    = BD_MAX(ring_size / SLOT_SIZE, MIN_SLOTS);
+    p->num_readers  = num_readers;
+    p->num_attached = num_readers;
+    p->slots        = calloc(p->num_slots, sizeof(*p->slots));
+    p->cursors      = calloc(num_readers, sizeof(*p->cursors));
+    if (!p->slots || !p->cursors) {
+        goto error;
+    }
+    for (ii = 0; ii < p->num_slots; ii++) {
+        p->slots[ii].data = malloc(SLOT_SIZE);
+        if (!p->slots[ii].data) {
+            goto error;
+        }
+    }
+    for (ii = 0; ii < num_readers; ii++) {
+        p->cursors[ii].attached = 1;
+    }
+
+    bd_mutex_init(&p->mutex);
+    bd_cond_init(&p->cond);
+
+    if (bd_thread_create(&p->thread, "bd_fanout", _producer, p) < 0) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "failed creating fan-out reader thread\n");
+        bd_cond_destroy(&p->cond);
+        bd_mutex_destroy(&p->mutex);
+        goto error;
+    }
+    p->running = 1;
+
+    return p;
+
+ error:
+    BD_DEBUG(DBG_BLURAY | DBG_CRIT, "fanout_init() failed\n");
+    _free_slots(p);
+    X_FREE(p);
+    return NULL;
+}
+
+void fanout_free(BD_FANOUT **pp)
+{
+    if (pp && *pp) {
+        BD_FANOUT *p = *pp;
+
+        if (p->running) {
+            bd_mutex_lock(&p->mutex);
+            p->exit = 1;
+            bd_cond_broadcast(&p->cond);
+            bd_mutex_unlock(&p->mutex);
+
+            bd_thread_join(&p->thread);
+        }
+
+        bd_cond_destroy(&p->cond);
+        bd_mutex_destroy(&p->mutex);
+        _free_slots(p);
+        X_FREE(*pp);
+    }
+}
+
+/* called with mutex locked */
+static void _consume_slot(BD_FANOUT *p, FANOUT_CURSOR *c)
+{
+    FANOUT_SLOT *slot = &p->slots[c->seq % p->num_slots];
+
+    c->seq++;
+    c->off = 0;
+    if (--slot->refs == 0) {
+        bd_cond_broadcast(&p->cond);
+    }
+}
+
+int fanout_read(BD_FANOUT *p, unsigned reader, uint8_t *buf, int len)
+{
+    FANOUT_CURSOR *c;
+    int            out_len = 0;
+
+    if (!p || reader >= p->num_readers || len < 0) {
+        return -1;
+    }
+
+    c = &p->cursors[reader];
+
+    bd_mutex_lock(&p->mutex);
+
+    if (!c->attached) {
+        bd_mutex_unlock(&p->mutex);
+        return -1;
+    }
+
+    while (c->seq == p->head && !p->end) {
+        bd_cond_wait(&p->cond, &p->mutex);
+    }
+
+    if (c->seq == p->head) {
+        /* all data consumed */
+        int result = p->result;
+        bd_mutex_unlock(&p->mutex);
+        return result;
+    }
+
+    while (out_len < len && c->seq < p->head) {
+        FANOUT_SLOT *slot = &p->slots[c->seq % p->num_slots];
+        int          size = BD_MIN(len - out_len, slot->len - c->off);
+
+        /* slot is not re-used while this reader holds a reference */
+        bd_mutex_unlock(&p->mutex);
+        memcpy(buf + out_len, slot->data + c->off, size);
+        bd_mutex_lock(&p->mutex);
+
+        out_len += size;
+        c->off  += size;
+        if (c->off >= slot->len) {
+            _consume_slot(p, c);
+        }
+    }
+
+    bd_mutex_unlock(&p->mutex);
+
+    return out_len;
+}
+
+void fanout_detach(BD_FANOUT *p, unsigned reader)
+{
+    FANOUT_CURSOR *c;
+
+    if (!p || reader >= p->num_readers) {
+        return;
+    }
+
+    c = &p->cursors[reader];
+
+    bd_mutex_lock(&p->mutex);
+
+    if (c->attached) {
+        while (c->seq < p->head) {
+            _consume_slot(p, c);
+        }
+        c->attached = 0;
+        p->num_attached--;
+        /* producer stops when last reader is gone */
+        bd_cond_broadcast(&p->cond);
+    }
+
+    bd_mutex_unlock(&p->mutex);
+}
+
+size_t fanout_memory_size(BD_FANOUT *p)
+{
+    if (!p) {
+        return 0;
+    }
+    return sizeof(*p) + p->num_slots * (sizeof(FANOUT_SLOT) + (size_t)SLOT_SIZE) +
+           p->num_readers * sizeof(FANOUT_CURSOR);
+}
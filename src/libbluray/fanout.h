@@ -0,0 +1,55 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined(_BD_FANOUT_H_)
+#define _BD_FANOUT_H_
+
+/*
+ * fan-out reading
+ *
+ * Producer thread reads the stream once into a ring of reference-counted slots.
+ * Each reader has its own cursor; slot is re-used when all attached readers
+ * have consumed it (slowest reader throttles the producer).
+ */
+
+#include "util/attributes.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct bd_fanout_s BD_FANOUT;
+
+typedef int (*fanout_read_f)(void *handle, uint8_t *buf, int len);
+
+/* start producer thread. ring_size is in bytes. */
+BD_PRIVATE BD_FANOUT *fanout_init(fanout_read_f read, void *handle, unsigned num_readers, unsigned ring_size);
+
+/* stop producer thread. Readers must not be blocked in fanout_read(). */
+BD_PRIVATE void fanout_free(BD_FANOUT **);
+
+/* read available data (blocks until some is available). Returns 0 at end of stream, -1 on error. */
+BD_PRIVATE int  fanout_read(BD_FANOUT *, unsigned reader, uint8_t *buf, int len);
+
+/* release all data held by reader. Reader can't be used after this. */
+BD_PRIVATE void fanout_detach(BD_FANOUT *, unsigned reader);
+
+/* ring buffer and state */
+BD_PRIVATE size_t fanout_memory_size(BD_FANOUT *);
+
+#endif /* _BD_FANOUT_H_ */
@@ -127,4 +127,83 @@ typedef enum {
     INSN_SETSYSTEM_0x10  = 0x10,
 } hdmv_insn_setsystem;
 
+/*
+ * pre-decoded instructions
+ *
+ * Commands are translated once (mobj_parse_cmd()) to a flat opcode and
+ * operand fetch modes, so the interpreter does not need to re-decode
+ * group / sub-group / option bitfields on every step.
+ */
+
+typedef enum {
+    HDMV_OP_INVALID = 0,
+
+    /* BRANCH */
+    HDMV_OP_NOP,
+    HDMV_OP_GOTO,
+    HDMV_OP_BREAK,
+    HDMV_OP_JUMP_OBJECT,
+    HDMV_OP_JUMP_TITLE,
+    HDMV_OP_CALL_OBJECT,
+    HDMV_OP_CALL_TITLE,
+    HDMV_OP_RESUME,
+    HDMV_OP_PLAY_PL,
+    HDMV_OP_PLAY_PL_PI,
+    HDMV_OP_PLAY_PL_PM,
+    HDMV_OP_TERMINATE_PL,
+    HDMV_OP_LINK_PI,
+    HDMV_OP_LINK_MK,
+
+    /* CMP */
+    HDMV_OP_BC,
+    HDMV_OP_EQ,
+    HDMV_OP_NE,
+    HDMV_OP_GE,
+    HDMV_OP_GT,
+    HDMV_OP_LE,
+    HDMV_OP_LT,
+
+    /* SET */
+    HDMV_OP_MOVE,
+    HDMV_OP_SWAP,
+    HDMV_OP_ADD,
+    HDMV_OP_SUB,
+    HDMV_OP_MUL,
+    HDMV_OP_DIV,
+    HDMV_OP_MOD,
+    HDMV_OP_RND,
+    HDMV_OP_AND,
+    HDMV_OP_OR,
+    HDMV_OP_XOR,
+    HDMV_OP_BITSET,
+    HDMV_OP_BITCLR,
+    HDMV_OP_SHL,
+    HDMV_OP_SHR,
+
+    /* SETSYSTEM */
+    HDMV_OP_SET_STREAM,
+    HDMV_OP_SET_SEC_STREAM,
+    HDMV_OP_SET_NV_TIMER,
+    HDMV_OP_SET_BUTTON_PAGE,
+    HDMV_OP_ENABLE_BUTTON,
+    HDMV_OP_DISABLE_BUTTON,
+    HDMV_OP_POPUP_OFF,
+    HDMV_OP_STILL_ON,
+    HDMV_OP_STILL_OFF,
+    HDMV_OP_SET_OUTPUT_MODE,
+    HDMV_OP_SET_STREAM_SS,
+    HDMV_OP_SETSYSTEM_0x10,
+
+    HDMV_OP_COUNT
+} hdmv_op;
+
+/* operand fetch modes */
+typedef enum {
+    HDMV_OPND_NONE        = 0,  /* operand not used */
+    HDMV_OPND_IMM         = 1,  /* immediate value */
+    HDMV_OPND_REG         = 2,  /* GPR / PSR */
+    HDMV_OPND_STREAM_REGS = 3,  /* SET_STREAM / SET_SEC_STREAM register pair */
+    HDMV_OPND_BUTTON_REG  = 4,  /* SET_BUTTON_PAGE register */
+} hdmv_opnd;
+
 #endif // _HDMV_INSN_H_
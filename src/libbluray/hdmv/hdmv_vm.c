@@ -28,7 +28,9 @@
 #include "util/macro.h"
 #include "util/logging.h"
 #include "util/mutex.h"
+#include "util/time.h"
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -40,6 +42,13 @@ typedef struct {
     uint32_t mobj_id;
 } NV_TIMER;
 
+typedef struct {
+    uint32_t  calls;
+    uint64_t  instructions;
+    uint64_t  time_us;
+    uint32_t *insn_hits;   /* [num_cmds], movie objects only */
+} OBJECT_PROFILE;
+
 struct hdmv_vm_s {
 
     BD_MUTEX       mutex;
@@ -69,6 +78,14 @@ struct hdmv_vm_s {
     uint8_t  have_top_menu;
     uint8_t  have_first_play;
     uint16_t num_titles;
+
+    /* instruction budget */
+    unsigned       insn_budget;   /* max. instructions per hdmv_vm_run() call (0 = unlimited) */
+    unsigned       run_insns;     /* instructions since program was started or last event */
+
+    /* statistics */
+    HDMV_VM_STATS  stats;
+    OBJECT_PROFILE *profile;      /* [num_objects + 1], last entry is IG object. NULL if disabled. */
 };
 
 /*
@@ -91,6 +108,12 @@ static int _is_valid_reg(uint32_t reg)
     return 1;
 }
 
+static void _psr_write(HDMV_VM *p, uint32_t reg, uint32_t val)
+{
+    p->stats.psr_writes++;
+    bd_psr_write(p->regs, reg, val);
+}
+
 static int _store_reg(HDMV_VM *p, uint32_t reg, uint32_t val)
 {
     if (!_is_valid_reg(reg)) {
@@ -102,6 +125,7 @@ static int _store_reg(HDMV_VM *p, uint32_t reg, uint32_t val)
         BD_DEBUG(DBG_HDMV, "_store_reg(): storing to PSR is not allowed\n");
         return -1;
     }  else {
+        p->stats.gpr_writes++;
         return bd_gpr_write(p->regs, reg, val);
     }
 }
@@ -166,43 +190,81 @@ static int _store_result(HDMV_VM *p, MOBJ_CMD *cmd, uint32_t src, uint32_t dst,
     return ret;
 }
 
-static uint32_t _fetch_operand(HDMV_VM *p, int setstream, int setbuttonpage, int imm, uint32_t value)
+static uint32_t _fetch_operand(HDMV_VM *p, unsigned mode, uint32_t value)
 {
-    if (imm) {
-        return value;
+    switch (mode) {
+        case HDMV_OPND_IMM:         return value;
+        case HDMV_OPND_REG:         return _read_reg(p, value);
+        case HDMV_OPND_STREAM_REGS: return _read_setstream_regs(p, value);
+        case HDMV_OPND_BUTTON_REG:  return _read_setbuttonpage_reg(p, value);
+        default:                    return 0;
     }
+}
 
-    if (setstream) {
-        return _read_setstream_regs(p, value);
+static void _fetch_operands(HDMV_VM *p, MOBJ_CMD *cmd, uint32_t *dst, uint32_t *src)
+{
+    *dst = *src = 0;
 
-    } else if (setbuttonpage) {
-        return _read_setbuttonpage_reg(p, value);
+    if (cmd->dst_mode != HDMV_OPND_NONE) {
+        *dst = _fetch_operand(p, cmd->dst_mode, cmd->dst);
+    }
 
-    } else {
-        return _read_reg(p, value);
+    if (cmd->src_mode != HDMV_OPND_NONE) {
+        *src = _fetch_operand(p, cmd->src_mode, cmd->src);
     }
 }
 
-static void _fetch_operands(HDMV_VM *p, MOBJ_CMD *cmd, uint32_t *dst, uint32_t *src)
+/*
+ * profiling
+ */
+
+static int _profile_slot(HDMV_VM *p, const MOBJ_OBJECT *object)
 {
-    HDMV_INSN *insn = &cmd->insn;
+    if (object >= p->movie_objects->objects &&
+        object <  p->movie_objects->objects + p->movie_objects->num_objects) {
+        return object - p->movie_objects->objects;
+    }
+    return p->movie_objects->num_objects;
+}
 
-    int setstream = (insn->grp     == INSN_GROUP_SET &&
-                     insn->sub_grp == SET_SETSYSTEM  &&
-                     (  insn->set_opt == INSN_SET_STREAM ||
-                        insn->set_opt == INSN_SET_SEC_STREAM));
-    int setbuttonpage = (insn->grp     == INSN_GROUP_SET &&
-                         insn->sub_grp == SET_SETSYSTEM  &&
-                         insn->set_opt == INSN_SET_BUTTON_PAGE);
+static void _profile_call(HDMV_VM *p)
+{
+    if (p->profile) {
+        p->profile[_profile_slot(p, p->object)].calls++;
+    }
+}
 
-    *dst = *src = 0;
+static void _free_profile(HDMV_VM *p)
+{
+    if (p->profile) {
+        unsigned ii;
+        for (ii = 0; ii < p->movie_objects->num_objects; ii++) {
+            X_FREE(p->profile[ii].insn_hits);
+        }
+        X_FREE(p->profile);
+    }
+}
 
-    if (insn->op_cnt > 0) {
-        *dst = _fetch_operand(p, setstream, setbuttonpage, insn->imm_op1, cmd->dst);
+static void _alloc_profile(HDMV_VM *p)
+{
+    unsigned ii, num_objects = p->movie_objects->num_objects;
+
+    p->profile = calloc(num_objects + 1, sizeof(OBJECT_PROFILE));
+    if (!p->profile) {
+        BD_DEBUG(DBG_CRIT, "out of memory\n");
+        return;
     }
 
-    if (insn->op_cnt > 1) {
-        *src = _fetch_operand(p, setstream, setbuttonpage, insn->imm_op2, cmd->src);
+    for (ii = 0; ii < num_objects; ii++) {
+        unsigned num_cmds = p->movie_objects->objects[ii].num_cmds;
+        if (num_cmds) {
+            p->profile[ii].insn_hits = calloc(num_cmds, sizeof(uint32_t));
+            if (!p->profile[ii].insn_hits) {
+                BD_DEBUG(DBG_CRIT, "out of memory\n");
+                _free_profile(p);
+                return;
+            }
+        }
     }
 }
 
@@ -283,6 +345,8 @@ void hdmv_vm_free(HDMV_VM **p)
 
         bd_mutex_destroy(&(*p)->mutex);
 
+        _free_profile(*p);
+
         mobj_free(&(*p)->movie_objects);
 
         _free_ig_object(*p);
@@ -300,12 +364,9 @@ static int _suspended_at_play_pl(HDMV_VM *p)
     int play_pl = 0;
     if (p && p->suspended_object) {
         MOBJ_CMD  *cmd  = &p->suspended_object->cmds[p->suspended_pc];
-        HDMV_INSN *insn = &cmd->insn;
-        play_pl = (insn->grp     == INSN_GROUP_BRANCH &&
-                   insn->sub_grp == BRANCH_PLAY  &&
-                   (  insn->branch_opt == INSN_PLAY_PL ||
-                      insn->branch_opt == INSN_PLAY_PL_PI ||
-                      insn->branch_opt == INSN_PLAY_PL_PM));
+        play_pl = (cmd->op == HDMV_OP_PLAY_PL ||
+                   cmd->op == HDMV_OP_PLAY_PL_PI ||
+                   cmd->op == HDMV_OP_PLAY_PL_PM);
     }
 
     return play_pl;
@@ -457,6 +518,8 @@ static int _jump_object(HDMV_VM *p, uint32_t object)
     p->pc     = 0;
     p->object = &p->movie_objects->objects[object];
 
+    _profile_call(p);
+
     /* suspended object is not discarded */
 
     return 0;
@@ -578,25 +641,25 @@ static void _set_stream(HDMV_VM *p, uint32_t dst, uint32_t src)
 {
     BD_DEBUG(DBG_HDMV, "_set_stream(0x%x, 0x%x)\n", dst, src);
 
+    bd_psr_begin(p->regs);
+
     /* primary audio stream */
     if (dst & 0x80000000) {
-        bd_psr_write(p->regs, PSR_PRIMARY_AUDIO_ID, (dst >> 16) & 0xfff);
+        _psr_write(p, PSR_PRIMARY_AUDIO_ID, (dst >> 16) & 0xfff);
     }
 
     /* IG stream */
     if (src & 0x80000000) {
-        bd_psr_write(p->regs, PSR_IG_STREAM_ID, (src >> 16) & 0xff);
+        _psr_write(p, PSR_IG_STREAM_ID, (src >> 16) & 0xff);
     }
 
     /* angle number */
     if (src & 0x8000) {
-        bd_psr_write(p->regs, PSR_ANGLE_NUMBER, src & 0xff);
+        _psr_write(p, PSR_ANGLE_NUMBER, src & 0xff);
     }
 
     /* PSR2 */
 
-    bd_psr_lock(p->regs);
-
     uint32_t psr2 = bd_psr_read(p->regs, PSR_PG_STREAM);
 
     /* PG TextST stream number */
@@ -609,9 +672,9 @@ static void _set_stream(HDMV_VM *p, uint32_t dst, uint32_t src)
     uint32_t disp_s_flag = (dst & 0x4000) << 17;
     psr2 = disp_s_flag | (psr2 & 0x7fffffff);
 
-    bd_psr_write(p->regs, PSR_PG_STREAM, psr2);
+    _psr_write(p, PSR_PG_STREAM, psr2);
 
-    bd_psr_unlock(p->regs);
+    bd_psr_commit(p->regs);
 }
 
 static void _set_sec_stream(HDMV_VM *p, uint32_t dst, uint32_t src)
@@ -624,7 +687,7 @@ static void _set_sec_stream(HDMV_VM *p, uint32_t dst, uint32_t src)
 
     /* PSR14 */
 
-    bd_psr_lock(p->regs);
+    bd_psr_begin(p->regs);
 
     uint32_t psr14 = bd_psr_read(p->regs, PSR_SECONDARY_AUDIO_VIDEO);
 
@@ -649,7 +712,7 @@ static void _set_sec_stream(HDMV_VM *p, uint32_t dst, uint32_t src)
     psr14 = (disp_v_flag << 31) | (psr14 & 0x7fffffff);
     psr14 = (disp_a_flag << 30) | (psr14 & 0xbfffffff);
 
-    bd_psr_write(p->regs, PSR_SECONDARY_AUDIO_VIDEO, psr14);
+    _psr_write(p, PSR_SECONDARY_AUDIO_VIDEO, psr14);
 
     /* PSR2 */
 
@@ -663,9 +726,9 @@ static void _set_sec_stream(HDMV_VM *p, uint32_t dst, uint32_t src)
 
     psr2 = (text_st_flags << 30) | (psr2 & 0x3fffffff);
 
-    bd_psr_write(p->regs, PSR_PG_STREAM, psr2);
+    _psr_write(p, PSR_PG_STREAM, psr2);
 
-    bd_psr_unlock(p->regs);
+    bd_psr_commit(p->regs);
 }
 
 static void _set_stream_ss(HDMV_VM *p, uint32_t dst, uint32_t src)
@@ -687,8 +750,8 @@ static void _setsystem_0x10(HDMV_VM *p, uint32_t dst, uint32_t src)
     bd_psr_lock(p->regs);
 
     /* just a guess ... */
-    //bd_psr_write(p->regs, 104, 0);
-    bd_psr_write(p->regs, 103, dst);
+    //_psr_write(p, 104, 0);
+    _psr_write(p, 103, dst);
 
     bd_psr_unlock(p->regs);
 }
@@ -716,12 +779,12 @@ static void _set_button_page(HDMV_VM *p, uint32_t dst, uint32_t src)
 
     /* selected button */
     if (dst & 0x80000000) {
-        bd_psr_write(p->regs, PSR_SELECTED_BUTTON_ID, dst & 0xffff);
+        _psr_write(p, PSR_SELECTED_BUTTON_ID, dst & 0xffff);
     }
 
     /* active page */
     if (src & 0x80000000) {
-        bd_psr_write(p->regs, PSR_MENU_PAGE_ID, src & 0xff);
+        _psr_write(p, PSR_MENU_PAGE_ID, src & 0xff);
     }
 }
 
@@ -775,7 +838,7 @@ static void _set_output_mode(HDMV_VM *p, uint32_t dst)
       psr22 &= ~1;
     }
 
-    bd_psr_write(p->regs, PSR_3D_STATUS, psr22);
+    _psr_write(p, PSR_3D_STATUS, psr22);
 
     bd_psr_unlock(p->regs);
 }
@@ -793,7 +856,7 @@ static void _set_nv_timer(HDMV_VM *p, uint32_t dst, uint32_t src)
     /* cancel timer */
     p->nv_timer.time = 0;
 
-    bd_psr_write(p->regs, PSR_NAV_TIMER, 0);
+    _psr_write(p, PSR_NAV_TIMER, 0);
 
     return;
   }
@@ -816,7 +879,7 @@ static void _set_nv_timer(HDMV_VM *p, uint32_t dst, uint32_t src)
 
   p->nv_timer.mobj_id = mobj_id;
 
-  bd_psr_write(p->regs, PSR_NAV_TIMER, timeout);
+  _psr_write(p, PSR_NAV_TIMER, timeout);
 }
 
 /* Unused function.
@@ -829,7 +892,7 @@ static int _check_nv_timer(HDMV_VM *p)
         if (now >= p->nv_timer.time) {
             BD_DEBUG(DBG_HDMV, "navigation timer expired, jumping to object %d\n", p->nv_timer.mobj_id);
 
-            bd_psr_write(p->regs, PSR_NAV_TIMER, 0);
+            _psr_write(p, PSR_NAV_TIMER, 0);
 
             p->nv_timer.time = 0;
             _jump_object(p, p->nv_timer.mobj_id);
@@ -837,7 +900,7 @@ static int _check_nv_timer(HDMV_VM *p)
             return 0;
         }
 
-        bd_psr_write(p->regs, PSR_NAV_TIMER, (p->nv_timer.time - now));
+        _psr_write(p, PSR_NAV_TIMER, (p->nv_timer.time - now));
     }
 
     return -1;
@@ -918,164 +981,95 @@ static inline uint32_t MUL_u32(uint32_t a, uint32_t b)
 static int _hdmv_step(HDMV_VM *p)
 {
     MOBJ_CMD  *cmd  = &p->object->cmds[p->pc];
-    HDMV_INSN *insn = &cmd->insn;
     uint32_t   src  = 0;
     uint32_t   dst  = 0;
+    uint32_t   src0, dst0;
     int        inc_pc = 1;
 
     /* fetch operand values */
     _fetch_operands(p, cmd, &dst, &src);
+    src0 = src;
+    dst0 = dst;
 
     /* trace */
     _hdmv_trace_cmd(p->pc, cmd);
 
     /* execute */
-    switch (insn->grp) {
-        case INSN_GROUP_BRANCH:
-            switch (insn->sub_grp) {
-                case BRANCH_GOTO:
-                    if (insn->op_cnt > 1) {
-                        BD_DEBUG(DBG_HDMV|DBG_CRIT, "too many operands in BRANCH/GOTO opcode 0x%08x\n", *(uint32_t*)insn);
-                    }
-                    switch (insn->branch_opt) {
-                        case INSN_NOP:                      break;
-                        case INSN_GOTO:  p->pc   = dst - 1; break;
-                        case INSN_BREAK: p->pc   = 1 << 17; break;
-                        default:
-                            BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown BRANCH/GOTO option %d in opcode 0x%08x\n",
-                                     insn->branch_opt, *(uint32_t*)insn);
-                            break;
-                    }
-                    break;
-                case BRANCH_JUMP:
-                    if (insn->op_cnt > 1) {
-                        BD_DEBUG(DBG_HDMV|DBG_CRIT, "too many operands in BRANCH/JUMP opcode 0x%08x\n", *(uint32_t*)insn);
-                    }
-                    switch (insn->branch_opt) {
-                        case INSN_JUMP_TITLE:  _jump_title(p, dst); break;
-                        case INSN_CALL_TITLE:  _call_title(p, dst); break;
-                        case INSN_RESUME:      _resume_object(p, 1);   break;
-                        case INSN_JUMP_OBJECT: if (!_jump_object(p, dst)) { inc_pc = 0; } break;
-                        case INSN_CALL_OBJECT: if (!_call_object(p, dst)) { inc_pc = 0; } break;
-                        default:
-                            BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown BRANCH/JUMP option %d in opcode 0x%08x\n",
-                                     insn->branch_opt, *(uint32_t*)insn);
-                            break;
-                    }
-                    break;
-                case BRANCH_PLAY:
-                    switch (insn->branch_opt) {
-                        case INSN_PLAY_PL:      _play_at(p, dst,  -1,  -1); break;
-                        case INSN_PLAY_PL_PI:   _play_at(p, dst, src,  -1); break;
-                        case INSN_PLAY_PL_PM:   _play_at(p, dst,  -1, src); break;
-                        case INSN_TERMINATE_PL: _play_stop(p);              break;
-                        case INSN_LINK_PI:      _play_at(p,  -1, dst,  -1); break;
-                        case INSN_LINK_MK:      _play_at(p,  -1,  -1, dst); break;
-                        default:
-                            BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown BRANCH/PLAY option %d in opcode 0x%08x\n",
-                                     insn->branch_opt, *(uint32_t*)insn);
-                            break;
-                    }
-                    break;
-
-                default:
-                    BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown BRANCH subgroup %d in opcode 0x%08x\n",
-                             insn->sub_grp, *(uint32_t*)insn);
-                    break;
-            }
-            break; /* INSN_GROUP_BRANCH */
-
-        case INSN_GROUP_CMP:
-            if (insn->op_cnt < 2) {
-                BD_DEBUG(DBG_HDMV|DBG_CRIT, "missing operand in BRANCH/JUMP opcode 0x%08x\n", *(uint32_t*)insn);
-            }
-            switch (insn->cmp_opt) {
-                case INSN_BC: p->pc += !!(dst & ~src); break;
-                case INSN_EQ: p->pc += !(dst == src); break;
-                case INSN_NE: p->pc += !(dst != src); break;
-                case INSN_GE: p->pc += !(dst >= src); break;
-                case INSN_GT: p->pc += !(dst >  src); break;
-                case INSN_LE: p->pc += !(dst <= src); break;
-                case INSN_LT: p->pc += !(dst <  src); break;
-                default:
-                    BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown COMPARE option %d in opcode 0x%08x\n",
-                             insn->cmp_opt, *(uint32_t*)insn);
-                    break;
-            }
-            break; /* INSN_GROUP_CMP */
-
-        case INSN_GROUP_SET:
-            switch (insn->sub_grp) {
-                case SET_SET: {
-                    uint32_t src0 = src;
-                    uint32_t dst0 = dst;
-
-                    if (insn->op_cnt < 2) {
-                        BD_DEBUG(DBG_HDMV|DBG_CRIT, "missing operand in SET/SET opcode 0x%08x\n", *(uint32_t*)insn);
-                    }
-                    switch (insn->set_opt) {
-                        case INSN_MOVE:   dst  = src;         break;
-                        case INSN_SWAP:   SWAP_u32(src, dst);   break;
-                        case INSN_SUB:    dst  = dst > src ? dst - src :          0; break;
-                        case INSN_DIV:    dst  = src > 0   ? dst / src : 0xffffffff; break;
-                        case INSN_MOD:    dst  = src > 0   ? dst % src : 0xffffffff; break;
-                        case INSN_ADD:    dst  = ADD_u32(src, dst);  break;
-                        case INSN_MUL:    dst  = MUL_u32(dst, src);  break;
-                        case INSN_RND:    dst  = RAND_u32(src);      break;
-                        case INSN_AND:    dst &= src;         break;
-                        case INSN_OR:     dst |= src;         break;
-                        case INSN_XOR:    dst ^= src;         break;
-                        case INSN_BITSET: dst |=  (1 << src); break;
-                        case INSN_BITCLR: dst &= ~(1 << src); break;
-                        case INSN_SHL:    dst <<= src;        break;
-                        case INSN_SHR:    dst >>= src;        break;
-                        default:
-                            BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown SET option %d in opcode 0x%08x\n",
-                                     insn->set_opt, *(uint32_t*)insn);
-                            break;
-                    }
-
-                    /* store result(s) */
-                    if (dst != dst0 || src != src0) {
-
-                        _hdmv_trace_res(src, dst, src0, dst0);
-
-                        _store_result(p, cmd, src, dst, src0, dst0);
-                    }
-                    break;
-                }
-                case SET_SETSYSTEM:
-                    switch (insn->set_opt) {
-                        case INSN_SET_STREAM:      _set_stream     (p, dst, src); break;
-                        case INSN_SET_SEC_STREAM:  _set_sec_stream (p, dst, src); break;
-                        case INSN_SET_NV_TIMER:    _set_nv_timer   (p, dst, src); break;
-                        case INSN_SET_BUTTON_PAGE: _set_button_page(p, dst, src); break;
-                        case INSN_ENABLE_BUTTON:   _enable_button  (p, dst,   1); break;
-                        case INSN_DISABLE_BUTTON:  _enable_button  (p, dst,   0); break;
-                        case INSN_POPUP_OFF:       _popup_off      (p);           break;
-                        case INSN_STILL_ON:        _set_still_mode (p,   1);      break;
-                        case INSN_STILL_OFF:       _set_still_mode (p,   0);      break;
-                        case INSN_SET_OUTPUT_MODE: _set_output_mode(p, dst);      break;
-                        case INSN_SET_STREAM_SS:   _set_stream_ss  (p, dst, src); break;
-                        case INSN_SETSYSTEM_0x10:  _setsystem_0x10 (p, dst, src); break;
-                        default:
-                            BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown SETSYSTEM option %d in opcode 0x%08x\n", insn->set_opt, *(uint32_t*)insn);
-                            break;
-                    }
-                    break;
-                default:
-                    BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown SET subgroup %d in opcode 0x%08x\n",
-                             insn->sub_grp, *(uint32_t*)insn);
-                    break;
-            }
-            break; /* INSN_GROUP_SET */
+    switch (cmd->op) {
+
+        /* BRANCH */
+        case HDMV_OP_NOP:                                    break;
+        case HDMV_OP_GOTO:         p->pc = dst - 1;          break;
+        case HDMV_OP_BREAK:        p->pc = 1 << 17;          break;
+
+        case HDMV_OP_JUMP_TITLE:   _jump_title(p, dst);      break;
+        case HDMV_OP_CALL_TITLE:   _call_title(p, dst);      break;
+        case HDMV_OP_RESUME:       _resume_object(p, 1);     break;
+        case HDMV_OP_JUMP_OBJECT:  if (!_jump_object(p, dst)) { inc_pc = 0; } break;
+        case HDMV_OP_CALL_OBJECT:  if (!_call_object(p, dst)) { inc_pc = 0; } break;
+
+        case HDMV_OP_PLAY_PL:      _play_at(p, dst,  -1,  -1); break;
+        case HDMV_OP_PLAY_PL_PI:   _play_at(p, dst, src,  -1); break;
+        case HDMV_OP_PLAY_PL_PM:   _play_at(p, dst,  -1, src); break;
+        case HDMV_OP_TERMINATE_PL: _play_stop(p);              break;
+        case HDMV_OP_LINK_PI:      _play_at(p,  -1, dst,  -1); break;
+        case HDMV_OP_LINK_MK:      _play_at(p,  -1,  -1, dst); break;
+
+        /* CMP */
+        case HDMV_OP_BC: p->pc += !!(dst & ~src); break;
+        case HDMV_OP_EQ: p->pc += !(dst == src); break;
+        case HDMV_OP_NE: p->pc += !(dst != src); break;
+        case HDMV_OP_GE: p->pc += !(dst >= src); break;
+        case HDMV_OP_GT: p->pc += !(dst >  src); break;
+        case HDMV_OP_LE: p->pc += !(dst <= src); break;
+        case HDMV_OP_LT: p->pc += !(dst <  src); break;
+
+        /* SET */
+        case HDMV_OP_MOVE:   dst  = src;         break;
+        case HDMV_OP_SWAP:   SWAP_u32(src, dst);   break;
+        case HDMV_OP_SUB:    dst  = dst > src ? dst - src :          0; break;
+        case HDMV_OP_DIV:    dst  = src > 0   ? dst / src : 0xffffffff; break;
+        case HDMV_OP_MOD:    dst  = src > 0   ? dst % src : 0xffffffff; break;
+        case HDMV_OP_ADD:    dst  = ADD_u32(src, dst);  break;
+        case HDMV_OP_MUL:    dst  = MUL_u32(dst, src);  break;
+        case HDMV_OP_RND:    dst  = RAND_u32(src);      break;
+        case HDMV_OP_AND:    dst &= src;         break;
+        case HDMV_OP_OR:     dst |= src;         break;
+        case HDMV_OP_XOR:    dst ^= src;         break;
+        case HDMV_OP_BITSET: dst |=  (1 << src); break;
+        case HDMV_OP_BITCLR: dst &= ~(1 << src); break;
+        case HDMV_OP_SHL:    dst <<= src;        break;
+        case HDMV_OP_SHR:    dst >>= src;        break;
+
+        /* SETSYSTEM */
+        case HDMV_OP_SET_STREAM:      _set_stream     (p, dst, src); break;
+        case HDMV_OP_SET_SEC_STREAM:  _set_sec_stream (p, dst, src); break;
+        case HDMV_OP_SET_NV_TIMER:    _set_nv_timer   (p, dst, src); break;
+        case HDMV_OP_SET_BUTTON_PAGE: _set_button_page(p, dst, src); break;
+        case HDMV_OP_ENABLE_BUTTON:   _enable_button  (p, dst,   1); break;
+        case HDMV_OP_DISABLE_BUTTON:  _enable_button  (p, dst,   0); break;
+        case HDMV_OP_POPUP_OFF:       _popup_off      (p);           break;
+        case HDMV_OP_STILL_ON:        _set_still_mode (p,   1);      break;
+        case HDMV_OP_STILL_OFF:       _set_still_mode (p,   0);      break;
+        case HDMV_OP_SET_OUTPUT_MODE: _set_output_mode(p, dst);      break;
+        case HDMV_OP_SET_STREAM_SS:   _set_stream_ss  (p, dst, src); break;
+        case HDMV_OP_SETSYSTEM_0x10:  _setsystem_0x10 (p, dst, src); break;
 
         default:
-            BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown operation group %d in opcode 0x%08x\n",
-                     insn->grp, *(uint32_t*)insn);
+            /* invalid commands are reported when parsing */
             break;
     }
 
+    /* store result(s) of SET/SET */
+    if (dst != dst0 || src != src0) {
+        if (cmd->op >= HDMV_OP_MOVE && cmd->op <= HDMV_OP_SHR) {
+
+            _hdmv_trace_res(src, dst, src0, dst0);
+
+            _store_result(p, cmd, src, dst, src0, dst0);
+        }
+    }
+
     /* inc program counter to next instruction */
     p->pc += inc_pc;
 
@@ -1124,6 +1118,8 @@ static int _set_object(HDMV_VM *p, int num_nav_cmds, void *nav_cmds)
     p->ig_object = ig_object;
     p->object    = ig_object;
 
+    _profile_call(p);
+
     return 0;
 }
 
@@ -1254,7 +1250,10 @@ int hdmv_vm_suspend_pl(HDMV_VM *p)
 
 static int _vm_run(HDMV_VM *p, HDMV_EVENT *ev)
 {
-    int max_loop = MAX_LOOP;
+    const MOBJ_OBJECT *profiled = NULL;
+    uint64_t           t0       = 0;
+    unsigned           executed = 0;
+    int                result   = 0;
 
     /* pending events ? */
     if (!_get_event(p, ev)) {
@@ -1267,13 +1266,18 @@ static int _vm_run(HDMV_VM *p, HDMV_EVENT *ev)
         return -1;
     }
 
-    while (--max_loop > 0) {
+    if (p->profile) {
+        profiled = p->object;
+        t0       = bd_get_time_us();
+    }
+
+    while (1) {
 
         /* suspended ? */
         if (!p->object) {
             BD_DEBUG(DBG_HDMV, "hdmv_vm_run(): object suspended\n");
             _get_event(p, ev);
-            return 0;
+            break;
         }
 
         /* terminated ? */
@@ -1287,24 +1291,68 @@ static int _vm_run(HDMV_VM *p, HDMV_EVENT *ev)
                 _free_ig_object(p);
             }
 
-            return 0;
+            break;
+        }
+
+        /* infinite loop ? */
+        if (p->run_insns >= MAX_LOOP - 1) {
+            BD_DEBUG(DBG_HDMV|DBG_CRIT, "hdmv_vm: infinite program ? terminated after %d instructions.\n", MAX_LOOP);
+            p->object = NULL;
+            result = -1;
+            break;
+        }
+
+        /* instruction budget used ? */
+        if (p->insn_budget && executed >= p->insn_budget) {
+            BD_DEBUG(DBG_HDMV, "hdmv_vm_run(): instruction budget used, yielding at PC=%d\n", p->pc);
+            p->stats.budget_yields++;
+            ev->event = HDMV_EVENT_YIELD;
+            ev->param = 0;
+            break;
+        }
+
+        executed++;
+        p->run_insns++;
+        p->stats.instructions++;
+
+        if (p->profile) {
+            OBJECT_PROFILE *op = &p->profile[_profile_slot(p, p->object)];
+            op->instructions++;
+            if (op->insn_hits) {
+                op->insn_hits[p->pc]++;
+            }
         }
 
         /* next instruction */
         if (_hdmv_step(p) < 0) {
             p->object = NULL;
-            return -1;
+            result = -1;
+            break;
+        }
+
+        /* object changed ? update time spent in object */
+        if (profiled && p->object != profiled && p->object) {
+            uint64_t t1 = bd_get_time_us();
+            p->profile[_profile_slot(p, profiled)].time_us += t1 - t0;
+            profiled = p->object;
+            t0       = t1;
         }
 
         /* events ? */
         if (!_get_event(p, ev)) {
-            return 0;
+            break;
         }
     }
 
-    BD_DEBUG(DBG_HDMV|DBG_CRIT, "hdmv_vm: infinite program ? terminated after %d instructions.\n", MAX_LOOP);
-    p->object = NULL;
-    return -1;
+    if (profiled && p->profile) {
+        p->profile[_profile_slot(p, profiled)].time_us += bd_get_time_us() - t0;
+    }
+
+    if (ev->event != HDMV_EVENT_YIELD) {
+        p->run_insns = 0;
+    }
+
+    return result;
 }
 
 int hdmv_vm_run(HDMV_VM *p, HDMV_EVENT *ev)
@@ -1322,3 +1370,189 @@ int hdmv_vm_run(HDMV_VM *p, HDMV_EVENT *ev)
     bd_mutex_unlock(&p->mutex);
     return result;
 }
+
+/*
+ * profiling and instruction budget
+ */
+
+void hdmv_vm_set_insn_budget(HDMV_VM *p, unsigned budget)
+{
+    if (p) {
+        bd_mutex_lock(&p->mutex);
+        p->insn_budget = budget;
+        bd_mutex_unlock(&p->mutex);
+    }
+}
+
+void hdmv_vm_set_profiling(HDMV_VM *p, int enable)
+{
+    if (!p) {
+        return;
+    }
+
+    bd_mutex_lock(&p->mutex);
+
+    if (enable && !p->profile) {
+        _alloc_profile(p);
+    } else if (!enable) {
+        _free_profile(p);
+    }
+
+    bd_mutex_unlock(&p->mutex);
+}
+
+void hdmv_vm_get_stats(HDMV_VM *p, HDMV_VM_STATS *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    if (p) {
+        bd_mutex_lock(&p->mutex);
+        *stats = p->stats;
+        bd_mutex_unlock(&p->mutex);
+    }
+}
+
+int hdmv_vm_get_object_stats(HDMV_VM *p, unsigned object, HDMV_OBJECT_STATS *stats,
+                             uint32_t *insn_hits, unsigned num_hits)
+{
+    int result = 0;
+
+    memset(stats, 0, sizeof(*stats));
+
+    if (!p) {
+        return 0;
+    }
+
+    bd_mutex_lock(&p->mutex);
+
+    if (p->profile && object <= p->movie_objects->num_objects) {
+        const OBJECT_PROFILE *op = &p->profile[object];
+
+        stats->calls        = op->calls;
+        stats->instructions = op->instructions;
+        stats->time_us      = op->time_us;
+
+        if (object < p->movie_objects->num_objects) {
+            stats->num_cmds = p->movie_objects->objects[object].num_cmds;
+            if (insn_hits && num_hits) {
+                unsigned n = BD_MIN(num_hits, stats->num_cmds);
+                memcpy(insn_hits, op->insn_hits, n * sizeof(uint32_t));
+            }
+        }
+
+        result = 1;
+    }
+
+    bd_mutex_unlock(&p->mutex);
+    return result;
+}
+
+void hdmv_vm_dump_profile(HDMV_VM *p)
+{
+    unsigned ii, jj;
+
+    if (!p) {
+        return;
+    }
+
+    bd_mutex_lock(&p->mutex);
+
+    BD_DEBUG(DBG_HDMV|DBG_CRIT, "HDMV VM: %"PRIu64" instructions, %"PRIu64" GPR writes, %"PRIu64" PSR writes, %u budget yields\n",
+             p->stats.instructions, p->stats.gpr_writes, p->stats.psr_writes, p->stats.budget_yields);
+
+    if (!p->profile) {
+        BD_DEBUG(DBG_HDMV|DBG_CRIT, "HDMV VM: profiling not enabled\n");
+        bd_mutex_unlock(&p->mutex);
+        return;
+    }
+
+    for (ii = 0; ii <= p->movie_objects->num_objects; ii++) {
+        const OBJECT_PROFILE *op = &p->profile[ii];
+
+        if (!op->calls && !op->instructions) {
+            continue;
+        }
+
+        if (ii < p->movie_objects->num_objects) {
+            BD_DEBUG(DBG_HDMV|DBG_CRIT, "object %u: %u calls, %"PRIu64" instructions, %"PRIu64" us\n",
+                     ii, op->calls, op->instructions, op->time_us);
+        } else {
+            BD_DEBUG(DBG_HDMV|DBG_CRIT, "IG objects: %u calls, %"PRIu64" instructions, %"PRIu64" us\n",
+                     op->calls, op->instructions, op->time_us);
+        }
+
+        if (op->insn_hits) {
+            const MOBJ_OBJECT *obj = &p->movie_objects->objects[ii];
+            for (jj = 0; jj < obj->num_cmds; jj++) {
+                if (op->insn_hits[jj]) {
+                    char buf[384];
+                    mobj_sprint_cmd(buf, &obj->cmds[jj]);
+                    BD_DEBUG(DBG_HDMV|DBG_CRIT, "  %04u: %10u  %s\n", jj, op->insn_hits[jj], buf);
+                }
+            }
+        }
+    }
+
+    bd_mutex_unlock(&p->mutex);
+}
+
+/*
+ * branch targets
+ */
+
+static void _add_target(uint32_t *list, unsigned *count, uint32_t value)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < *count; ii++) {
+        if (list[ii] == value) {
+            return;
+        }
+    }
+    if (*count < HDMV_MAX_NAV_TARGETS) {
+        list[(*count)++] = value;
+    }
+}
+
+void hdmv_nav_targets(const MOBJ_CMD *cmds, unsigned num_cmds, HDMV_NAV_TARGETS *t)
+{
+    unsigned ii;
+
+    for (ii = 0; ii < num_cmds; ii++) {
+        const MOBJ_CMD *cmd = &cmds[ii];
+
+        if (cmd->dst_mode != HDMV_OPND_IMM) {
+            continue;
+        }
+
+        switch (cmd->op) {
+            case HDMV_OP_PLAY_PL:
+            case HDMV_OP_PLAY_PL_PI:
+            case HDMV_OP_PLAY_PL_PM:
+                _add_target(t->playlist, &t->num_playlists, cmd->dst);
+                break;
+            case HDMV_OP_JUMP_TITLE:
+            case HDMV_OP_CALL_TITLE:
+                _add_target(t->title, &t->num_titles, cmd->dst);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void hdmv_vm_object_nav_targets(HDMV_VM *p, uint32_t object, HDMV_NAV_TARGETS *t)
+{
+    if (!p) {
+        return;
+    }
+
+    bd_mutex_lock(&p->mutex);
+
+    if (object < p->movie_objects->num_objects) {
+        const MOBJ_OBJECT *obj = &p->movie_objects->objects[object];
+        hdmv_nav_targets(obj->cmds, obj->num_cmds, t);
+    }
+
+    bd_mutex_unlock(&p->mutex);
+}
@@ -53,6 +53,11 @@ typedef enum {
     HDMV_EVENT_DISABLE_BUTTON,
     HDMV_EVENT_POPUP_OFF,
 
+    /*
+     * instruction budget used, program is still running
+     */
+    HDMV_EVENT_YIELD,
+
 } hdmv_event_e;
 
 typedef struct hdmv_vm_event_s {
@@ -119,4 +124,59 @@ BD_PRIVATE int      hdmv_vm_suspend_pl(HDMV_VM *p);
  */
 BD_PRIVATE int      hdmv_vm_resume(HDMV_VM *p);
 
+/*
+ * profiling and instruction budget
+ */
+
+typedef struct {
+    uint64_t instructions;   /* executed instructions */
+    uint64_t gpr_writes;
+    uint64_t psr_writes;
+    uint32_t budget_yields;  /* hdmv_vm_run() returned HDMV_EVENT_YIELD */
+} HDMV_VM_STATS;
+
+typedef struct {
+    uint32_t calls;          /* object starts (select / jump / call, IG button activation) */
+    uint64_t instructions;
+    uint64_t time_us;
+    uint32_t num_cmds;       /* number of per-instruction counters (0 for IG objects) */
+} HDMV_OBJECT_STATS;
+
+/* limit executed instructions per hdmv_vm_run() call (0 = unlimited).
+ * When budget is used, hdmv_vm_run() returns HDMV_EVENT_YIELD and continues from same position in next call. */
+BD_PRIVATE void     hdmv_vm_set_insn_budget(HDMV_VM *p, unsigned budget);
+
+/* enable / disable per-object counters. Disabling discards collected counters. */
+BD_PRIVATE void     hdmv_vm_set_profiling(HDMV_VM *p, int enable);
+
+BD_PRIVATE void     hdmv_vm_get_stats(HDMV_VM *p, HDMV_VM_STATS *stats);
+
+/* object == number of movie objects: all IG objects. Returns 0 if profiling is not enabled or object is invalid. */
+BD_PRIVATE int      hdmv_vm_get_object_stats(HDMV_VM *p, unsigned object, HDMV_OBJECT_STATS *stats,
+                                             uint32_t *insn_hits, unsigned num_hits);
+
+/* write statistics and per-instruction hit counts to debug log */
+BD_PRIVATE void     hdmv_vm_dump_profile(HDMV_VM *p);
+
+/*
+ * Statically known branch targets (immediate operands) of navigation commands.
+ * Used for speculative playlist prefetch.
+ */
+
+#define HDMV_MAX_NAV_TARGETS 16
+
+typedef struct {
+    unsigned num_playlists;
+    uint32_t playlist[HDMV_MAX_NAV_TARGETS];  /* PlayPL / PlayPLatPI / PlayPLatMK */
+    unsigned num_titles;
+    uint32_t title[HDMV_MAX_NAV_TARGETS];     /* JumpTitle / CallTitle */
+} HDMV_NAV_TARGETS;
+
+struct mobj_cmd;
+
+/* add targets of command sequence to t (duplicates are skipped) */
+BD_PRIVATE void     hdmv_nav_targets(const struct mobj_cmd *cmds, unsigned num_cmds, HDMV_NAV_TARGETS *t);
+/* add targets of movie object to t */
+BD_PRIVATE void     hdmv_vm_object_nav_targets(HDMV_VM *p, uint32_t object, HDMV_NAV_TARGETS *t);
+
 #endif // _HDMV_VM_H_
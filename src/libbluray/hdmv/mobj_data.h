@@ -43,6 +43,11 @@ typedef struct mobj_cmd {
     HDMV_INSN insn;
     uint32_t  dst;
     uint32_t  src;
+
+    /* pre-decoded instruction (set by mobj_parse_cmd()) */
+    uint8_t   op;        /* hdmv_op */
+    uint8_t   dst_mode;  /* hdmv_opnd */
+    uint8_t   src_mode;  /* hdmv_opnd */
 } MOBJ_CMD;
 
 typedef struct {
@@ -20,12 +20,14 @@
 #include "mobj_parse.h"
 
 #include "mobj_data.h"
+#include "hdmv_insn.h"
 
 #include "disc/disc.h"
 
 #include "file/file.h"
 #include "util/bits.h"
 #include "util/logging.h"
+#include "util/refcnt.h"
 #include "util/macro.h"
 #include "util/strutl.h"
 
@@ -57,6 +59,150 @@ static int _mobj_parse_header(BITSTREAM *bs, int *extension_data_start)
     return 1;
 }
 
+/*
+ * instruction pre-decoding
+ */
+
+static const uint8_t _goto_ops[16] = {
+    [INSN_NOP]          = HDMV_OP_NOP,
+    [INSN_GOTO]         = HDMV_OP_GOTO,
+    [INSN_BREAK]        = HDMV_OP_BREAK,
+};
+
+static const uint8_t _jump_ops[16] = {
+    [INSN_JUMP_OBJECT]  = HDMV_OP_JUMP_OBJECT,
+    [INSN_JUMP_TITLE]   = HDMV_OP_JUMP_TITLE,
+    [INSN_CALL_OBJECT]  = HDMV_OP_CALL_OBJECT,
+    [INSN_CALL_TITLE]   = HDMV_OP_CALL_TITLE,
+    [INSN_RESUME]       = HDMV_OP_RESUME,
+};
+
+static const uint8_t _play_ops[16] = {
+    [INSN_PLAY_PL]      = HDMV_OP_PLAY_PL,
+    [INSN_PLAY_PL_PI]   = HDMV_OP_PLAY_PL_PI,
+    [INSN_PLAY_PL_PM]   = HDMV_OP_PLAY_PL_PM,
+    [INSN_TERMINATE_PL] = HDMV_OP_TERMINATE_PL,
+    [INSN_LINK_PI]      = HDMV_OP_LINK_PI,
+    [INSN_LINK_MK]      = HDMV_OP_LINK_MK,
+};
+
+static const uint8_t _cmp_ops[16] = {
+    [INSN_BC] = HDMV_OP_BC,
+    [INSN_EQ] = HDMV_OP_EQ,
+    [INSN_NE] = HDMV_OP_NE,
+    [INSN_GE] = HDMV_OP_GE,
+    [INSN_GT] = HDMV_OP_GT,
+    [INSN_LE] = HDMV_OP_LE,
+    [INSN_LT] = HDMV_OP_LT,
+};
+
+static const uint8_t _set_ops[32] = {
+    [INSN_MOVE]   = HDMV_OP_MOVE,
+    [INSN_SWAP]   = HDMV_OP_SWAP,
+    [INSN_ADD]    = HDMV_OP_ADD,
+    [INSN_SUB]    = HDMV_OP_SUB,
+    [INSN_MUL]    = HDMV_OP_MUL,
+    [INSN_DIV]    = HDMV_OP_DIV,
+    [INSN_MOD]    = HDMV_OP_MOD,
+    [INSN_RND]    = HDMV_OP_RND,
+    [INSN_AND]    = HDMV_OP_AND,
+    [INSN_OR]     = HDMV_OP_OR,
+    [INSN_XOR]    = HDMV_OP_XOR,
+    [INSN_BITSET] = HDMV_OP_BITSET,
+    [INSN_BITCLR] = HDMV_OP_BITCLR,
+    [INSN_SHL]    = HDMV_OP_SHL,
+    [INSN_SHR]    = HDMV_OP_SHR,
+};
+
+static const uint8_t _setsystem_ops[32] = {
+    [INSN_SET_STREAM]      = HDMV_OP_SET_STREAM,
+    [INSN_SET_SEC_STREAM]  = HDMV_OP_SET_SEC_STREAM,
+    [INSN_SET_NV_TIMER]    = HDMV_OP_SET_NV_TIMER,
+    [INSN_SET_BUTTON_PAGE] = HDMV_OP_SET_BUTTON_PAGE,
+    [INSN_ENABLE_BUTTON]   = HDMV_OP_ENABLE_BUTTON,
+    [INSN_DISABLE_BUTTON]  = HDMV_OP_DISABLE_BUTTON,
+    [INSN_POPUP_OFF]       = HDMV_OP_POPUP_OFF,
+    [INSN_STILL_ON]        = HDMV_OP_STILL_ON,
+    [INSN_STILL_OFF]       = HDMV_OP_STILL_OFF,
+    [INSN_SET_OUTPUT_MODE] = HDMV_OP_SET_OUTPUT_MODE,
+    [INSN_SET_STREAM_SS]   = HDMV_OP_SET_STREAM_SS,
+    [INSN_SETSYSTEM_0x10]  = HDMV_OP_SETSYSTEM_0x10,
+};
+
+static void _decode_insn(MOBJ_CMD *cmd, const uint8_t *buf)
+{
+    HDMV_INSN *insn = &cmd->insn;
+    uint32_t   code = MKINT_BE32(buf);
+    uint8_t    opnd = HDMV_OPND_REG;
+
+    cmd->op = HDMV_OP_INVALID;
+
+    switch (insn->grp) {
+        case INSN_GROUP_BRANCH:
+            switch (insn->sub_grp) {
+                case BRANCH_GOTO:  cmd->op = _goto_ops[insn->branch_opt]; break;
+                case BRANCH_JUMP:  cmd->op = _jump_ops[insn->branch_opt]; break;
+                case BRANCH_PLAY:  cmd->op = _play_ops[insn->branch_opt]; break;
+                default:
+                    BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown BRANCH subgroup %d in opcode 0x%08x\n", insn->sub_grp, code);
+                    return;
+            }
+            if (insn->sub_grp != BRANCH_PLAY && insn->op_cnt > 1) {
+                BD_DEBUG(DBG_HDMV|DBG_CRIT, "too many operands in BRANCH opcode 0x%08x\n", code);
+            }
+            if (cmd->op == HDMV_OP_INVALID) {
+                BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown BRANCH option %d in opcode 0x%08x\n", insn->branch_opt, code);
+            }
+            break;
+
+        case INSN_GROUP_CMP:
+            if (insn->op_cnt < 2) {
+                BD_DEBUG(DBG_HDMV|DBG_CRIT, "missing operand in COMPARE opcode 0x%08x\n", code);
+            }
+            cmd->op = _cmp_ops[insn->cmp_opt];
+            if (cmd->op == HDMV_OP_INVALID) {
+                BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown COMPARE option %d in opcode 0x%08x\n", insn->cmp_opt, code);
+            }
+            break;
+
+        case INSN_GROUP_SET:
+            switch (insn->sub_grp) {
+                case SET_SET:
+                    if (insn->op_cnt < 2) {
+                        BD_DEBUG(DBG_HDMV|DBG_CRIT, "missing operand in SET/SET opcode 0x%08x\n", code);
+                    }
+                    cmd->op = _set_ops[insn->set_opt];
+                    break;
+                case SET_SETSYSTEM:
+                    cmd->op = _setsystem_ops[insn->set_opt];
+                    if (cmd->op == HDMV_OP_SET_STREAM || cmd->op == HDMV_OP_SET_SEC_STREAM) {
+                        opnd = HDMV_OPND_STREAM_REGS;
+                    } else if (cmd->op == HDMV_OP_SET_BUTTON_PAGE) {
+                        opnd = HDMV_OPND_BUTTON_REG;
+                    }
+                    break;
+                default:
+                    BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown SET subgroup %d in opcode 0x%08x\n", insn->sub_grp, code);
+                    return;
+            }
+            if (cmd->op == HDMV_OP_INVALID) {
+                BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown SET option %d in opcode 0x%08x\n", insn->set_opt, code);
+            }
+            break;
+
+        default:
+            BD_DEBUG(DBG_HDMV|DBG_CRIT, "unknown operation group %d in opcode 0x%08x\n", insn->grp, code);
+            return;
+    }
+
+    if (insn->op_cnt > 0) {
+        cmd->dst_mode = insn->imm_op1 ? HDMV_OPND_IMM : opnd;
+    }
+    if (insn->op_cnt > 1) {
+        cmd->src_mode = insn->imm_op2 ? HDMV_OPND_IMM : opnd;
+    }
+}
+
 void mobj_parse_cmd(uint8_t *buf, MOBJ_CMD *cmd)
 {
     BITBUFFER bb;
@@ -79,6 +225,9 @@ void mobj_parse_cmd(uint8_t *buf, MOBJ_CMD *cmd)
 
     cmd->dst = bb_read(&bb, 32);
     cmd->src = bb_read(&bb, 32);
+
+    cmd->dst_mode = cmd->src_mode = HDMV_OPND_NONE;
+    _decode_insn(cmd, buf);
 }
 
 static int _mobj_parse_object(BITSTREAM *bs, MOBJ_OBJECT *obj)
@@ -107,20 +256,27 @@ static int _mobj_parse_object(BITSTREAM *bs, MOBJ_OBJECT *obj)
     return 1;
 }
 
-void mobj_free(MOBJ_OBJECTS **p)
+/* refcnt cleanup callback: free object contents */
+static void _clean_objects(void *p)
 {
-    if (p && *p) {
-
-        if ((*p)->objects) {
-            int i;
-            for (i = 0 ; i < (*p)->num_objects; i++) {
-                X_FREE((*p)->objects[i].cmds);
-            }
+    MOBJ_OBJECTS *objects = (MOBJ_OBJECTS *)p;
 
-            X_FREE((*p)->objects);
+    if (objects->objects) {
+        int i;
+        for (i = 0 ; i < objects->num_objects; i++) {
+            X_FREE(objects->objects[i].cmds);
         }
 
-        X_FREE(*p);
+        X_FREE(objects->objects);
+    }
+}
+
+void mobj_free(MOBJ_OBJECTS **p)
+{
+    if (p && *p) {
+        /* release reference (object may be shared with disc cache) */
+        bd_refcnt_dec(*p);
+        *p = NULL;
     }
 }
 
@@ -152,11 +308,12 @@ static MOBJ_OBJECTS *_mobj_parse(BD_FILE_H *fp)
         goto error;
     }
 
-    objects = calloc(1, sizeof(MOBJ_OBJECTS));
+    objects = refcnt_realloc(NULL, sizeof(MOBJ_OBJECTS), _clean_objects);
     if (!objects) {
         BD_DEBUG(DBG_CRIT, "out of memory\n");
         goto error;
     }
+    memset(objects, 0, sizeof(MOBJ_OBJECTS));
 
     bs_skip(&bs, 32); /* reserved */
     num_objects = bs_read(&bs, 16);
@@ -175,10 +332,12 @@ static MOBJ_OBJECTS *_mobj_parse(BD_FILE_H *fp)
         }
     }
 
+    bs_close(&bs);
     return objects;
 
  error:
     mobj_free(&objects);
+    bs_close(&bs);
     return NULL;
 }
 
@@ -198,7 +357,7 @@ MOBJ_OBJECTS *mobj_parse(const char *file_name)
     return objects;
 }
 
-static MOBJ_OBJECTS *_mobj_get(BD_DISC *disc, const char *path)
+static MOBJ_OBJECTS *_mobj_get(BD_DISC *disc, const char *path, size_t *size)
 {
     BD_FILE_H    *fp;
     MOBJ_OBJECTS *objects;
@@ -209,6 +368,7 @@ static MOBJ_OBJECTS *_mobj_get(BD_DISC *disc, const char *path)
     }
 
     objects = _mobj_parse(fp);
+    *size = sizeof(MOBJ_OBJECTS) + (size_t)file_size(fp);
     file_close(fp);
     return objects;
 }
@@ -216,13 +376,19 @@ static MOBJ_OBJECTS *_mobj_get(BD_DISC *disc, const char *path)
 MOBJ_OBJECTS *mobj_get(BD_DISC *disc)
 {
     MOBJ_OBJECTS *objects;
+    size_t        size = 0;
 
-    objects = _mobj_get(disc, "BDMV" DIR_SEP "MovieObject.bdmv");
+    objects = disc_cache_get(disc, "MovieObject.bdmv");
     if (objects) {
         return objects;
     }
 
-    /* if failed, try backup file */
-    objects = _mobj_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "MovieObject.bdmv");
+    objects = _mobj_get(disc, "BDMV" DIR_SEP "MovieObject.bdmv", &size);
+    if (!objects) {
+        /* if failed, try backup file */
+        objects = _mobj_get(disc, "BDMV" DIR_SEP "BACKUP" DIR_SEP "MovieObject.bdmv", &size);
+    }
+
+    disc_cache_put(disc, "MovieObject.bdmv", objects, size);
     return objects;
 }
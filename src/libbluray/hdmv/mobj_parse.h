@@ -29,8 +29,8 @@ struct mobj_objects;
 struct mobj_cmd;
 
 BD_PRIVATE struct mobj_objects* mobj_parse(const char *file) BD_ATTR_MALLOC; /* parse MovieObject.bdmv */
-BD_PRIVATE struct mobj_objects* mobj_get(struct bd_disc *disc);              /* parse MovieObject.bdmv */
+BD_PRIVATE struct mobj_objects* mobj_get(struct bd_disc *disc);              /* parse MovieObject.bdmv. Returned object is shared (disc cache): must not be modified. */
 BD_PRIVATE void                 mobj_parse_cmd(uint8_t *buf, struct mobj_cmd *cmd);
-BD_PRIVATE void                 mobj_free(struct mobj_objects **index);
+BD_PRIVATE void                 mobj_free(struct mobj_objects **index);      /* release reference */
 
 #endif // _MOBJ_PARSE_H_
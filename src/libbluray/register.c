@@ -21,6 +21,7 @@
 
 #include "player_settings.h"
 
+#include "util/atomic.h"
 #include "util/attributes.h"
 #include "util/macro.h"
 #include "util/logging.h"
@@ -29,8 +30,8 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define BD_PSR_COUNT 128
-#define BD_GPR_COUNT 4096
+#define PSR_MASK_WORDS (BD_PSR_COUNT / 32)
+#define PSR_MASK_BIT(mask, reg) ((mask)[(reg) >> 5] & (1u << ((reg) & 31)))
 
 /*
  * Initial values for player status/setting registers (5.8.2).
@@ -160,20 +161,58 @@ static const char * const bd_psr_name[BD_PSR_COUNT] = {
 typedef struct {
     void *handle;
     void (*cb)(void *, BD_PSR_EVENT*);
+    uint32_t mask[PSR_MASK_WORDS];  /* registers this callback is interested in */
 } PSR_CB_DATA;
 
+/*
+ * Registers are read without locking (single 32-bit atomic load).
+ * Writes are serialized with mutex. Callers needing consistent values of
+ * several registers hold bd_psr_lock() while reading.
+ */
+
 struct bd_registers_s
 {
-    uint32_t     psr[BD_PSR_COUNT];
-    uint32_t     gpr[BD_GPR_COUNT];
+    BD_ATOMIC_UINT psr[BD_PSR_COUNT];
+    BD_ATOMIC_UINT gpr[BD_GPR_COUNT];
 
     /* callbacks */
     unsigned     num_cb;
     PSR_CB_DATA *cb;
+    uint32_t     cb_mask[PSR_MASK_WORDS];  /* union of callback masks */
+
+    /* write transaction */
+    unsigned     txn_depth;
+    uint32_t     txn_mask[PSR_MASK_WORDS];  /* registers written in transaction */
+    uint32_t     txn_old[BD_PSR_COUNT];     /* register values at transaction start */
+    uint8_t      txn_reg[BD_PSR_COUNT];     /* written registers in order of first write */
+    unsigned     txn_count;
 
     BD_MUTEX     mutex;
 };
 
+/*
+ * register access helpers. Writers must hold the lock.
+ */
+
+#define PSR_GET(p, reg)      ((uint32_t)bd_atomic_load_relaxed(&(p)->psr[reg]))
+#define PSR_SET(p, reg, val) bd_atomic_store(&(p)->psr[reg], (val))
+
+static void _psr_copy(BD_REGISTERS *p, int dst, int src, int count)
+{
+    int i;
+    for (i = 0; i < count; i++) {
+        PSR_SET(p, dst + i, PSR_GET(p, src + i));
+    }
+}
+
+static void _psr_init(BD_REGISTERS *p, int reg, int count)
+{
+    int i;
+    for (i = reg; i < reg + count; i++) {
+        PSR_SET(p, i, bd_psr_init[i]);
+    }
+}
+
 /*
  * init / free
  */
@@ -183,7 +222,7 @@ BD_REGISTERS *bd_registers_init(void)
     BD_REGISTERS *p = calloc(1, sizeof(BD_REGISTERS));
 
     if (p) {
-        memcpy(p->psr, bd_psr_init, sizeof(bd_psr_init));
+        _psr_init(p, 0, BD_PSR_COUNT);
 
         bd_mutex_init(&p->mutex);
     }
@@ -220,7 +259,20 @@ void bd_psr_unlock(BD_REGISTERS *p)
  * PSR change callback register / unregister
  */
 
-void bd_psr_register_cb  (BD_REGISTERS *p, void (*callback)(void*,BD_PSR_EVENT*), void *cb_handle)
+static void _update_cb_mask(BD_REGISTERS *p)
+{
+    unsigned i, j;
+
+    memset(p->cb_mask, 0, sizeof(p->cb_mask));
+    for (i = 0; i < p->num_cb; i++) {
+        for (j = 0; j < PSR_MASK_WORDS; j++) {
+            p->cb_mask[j] |= p->cb[i].mask[j];
+        }
+    }
+}
+
+static void _register_cb(BD_REGISTERS *p, void (*callback)(void*,BD_PSR_EVENT*), void *cb_handle,
+                         const uint32_t *mask)
 {
     /* no duplicates ! */
     PSR_CB_DATA *cb;
@@ -231,6 +283,9 @@ void bd_psr_register_cb  (BD_REGISTERS *p, void (*callback)(void*,BD_PSR_EVENT*)
     for (i = 0; i < p->num_cb; i++) {
         if (p->cb[i].handle == cb_handle && p->cb[i].cb == callback) {
 
+            memcpy(p->cb[i].mask, mask, sizeof(p->cb[i].mask));
+            _update_cb_mask(p);
+
             bd_psr_unlock(p);
             return;
         }
@@ -241,7 +296,9 @@ void bd_psr_register_cb  (BD_REGISTERS *p, void (*callback)(void*,BD_PSR_EVENT*)
         p->cb = cb;
         p->cb[p->num_cb].cb     = callback;
         p->cb[p->num_cb].handle = cb_handle;
+        memcpy(p->cb[p->num_cb].mask, mask, sizeof(p->cb[p->num_cb].mask));
         p->num_cb++;
+        _update_cb_mask(p);
     } else {
         BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_psr_register_cb(): realloc failed\n");
     }
@@ -249,6 +306,32 @@ void bd_psr_register_cb  (BD_REGISTERS *p, void (*callback)(void*,BD_PSR_EVENT*)
     bd_psr_unlock(p);
 }
 
+void bd_psr_register_cb  (BD_REGISTERS *p, void (*callback)(void*,BD_PSR_EVENT*), void *cb_handle)
+{
+    uint32_t mask[PSR_MASK_WORDS];
+
+    memset(mask, 0xff, sizeof(mask));
+    _register_cb(p, callback, cb_handle, mask);
+}
+
+void bd_psr_register_cb_filter(BD_REGISTERS *p, void (*callback)(void*,BD_PSR_EVENT*), void *cb_handle,
+                               const unsigned *psrs, unsigned num_psrs)
+{
+    uint32_t mask[PSR_MASK_WORDS];
+    unsigned i;
+
+    memset(mask, 0, sizeof(mask));
+    for (i = 0; i < num_psrs; i++) {
+        if (psrs[i] < BD_PSR_COUNT) {
+            mask[psrs[i] >> 5] |= 1u << (psrs[i] & 31);
+        } else {
+            BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_psr_register_cb_filter(): invalid register %u\n", psrs[i]);
+        }
+    }
+
+    _register_cb(p, callback, cb_handle, mask);
+}
+
 void bd_psr_unregister_cb(BD_REGISTERS *p, void (*callback)(void*,BD_PSR_EVENT*), void *cb_handle)
 {
     unsigned i = 0;
@@ -265,6 +348,75 @@ void bd_psr_unregister_cb(BD_REGISTERS *p, void (*callback)(void*,BD_PSR_EVENT*)
         i++;
     }
 
+    _update_cb_mask(p);
+
+    bd_psr_unlock(p);
+}
+
+/*
+ * PSR change notification
+ */
+
+static void _notify(BD_REGISTERS *p, BD_PSR_EVENT *ev)
+{
+    unsigned i;
+
+    for (i = 0; i < p->num_cb; i++) {
+        if (ev->psr_idx < 0 || PSR_MASK_BIT(p->cb[i].mask, ev->psr_idx)) {
+            p->cb[i].cb(p->cb[i].handle, ev);
+        }
+    }
+}
+
+/*
+ * PSR write transaction
+ */
+
+void bd_psr_begin(BD_REGISTERS *p)
+{
+    bd_psr_lock(p);
+
+    if (p->txn_depth++ == 0) {
+        memset(p->txn_mask, 0, sizeof(p->txn_mask));
+        p->txn_count = 0;
+    }
+}
+
+void bd_psr_commit(BD_REGISTERS *p)
+{
+    uint32_t     old_val[BD_PSR_COUNT];
+    uint8_t      regs[BD_PSR_COUNT];
+    unsigned     count, i;
+    BD_PSR_EVENT ev;
+
+    if (!p->txn_depth) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_psr_commit(): no transaction\n");
+        return;
+    }
+
+    if (--p->txn_depth) {
+        bd_psr_unlock(p);
+        return;
+    }
+
+    /* callbacks may start new transaction */
+    count = p->txn_count;
+    memcpy(regs,    p->txn_reg, count);
+    memcpy(old_val, p->txn_old, sizeof(old_val));
+
+    for (i = 0; i < count; i++) {
+        int reg = regs[i];
+        if (PSR_MASK_BIT(p->cb_mask, reg)) {
+
+            ev.new_val = PSR_GET(p, reg);
+            ev.old_val = old_val[reg];
+            ev.ev_type = ev.old_val == ev.new_val ? BD_PSR_WRITE : BD_PSR_CHANGE;
+            ev.psr_idx = reg;
+
+            _notify(p, &ev);
+        }
+    }
+
     bd_psr_unlock(p);
 }
 
@@ -278,8 +430,8 @@ void bd_psr_save_state(BD_REGISTERS *p)
 
     bd_psr_lock(p);
 
-    memcpy(p->psr + 36, p->psr + 4,  sizeof(uint32_t) * 5);
-    memcpy(p->psr + 42, p->psr + 10, sizeof(uint32_t) * 3);
+    _psr_copy(p, 36, 4,  5);
+    _psr_copy(p, 42, 10, 3);
 
     /* generate save event */
 
@@ -290,10 +442,7 @@ void bd_psr_save_state(BD_REGISTERS *p)
         ev.old_val = 0;
         ev.new_val = 0;
 
-        unsigned j;
-        for (j = 0; j < p->num_cb; j++) {
-            p->cb[j].cb(p->cb[j].handle, &ev);
-        }
+        _notify(p, &ev);
     }
 
     bd_psr_unlock(p);
@@ -304,8 +453,8 @@ void bd_psr_reset_backup_registers(BD_REGISTERS *p)
     bd_psr_lock(p);
 
     /* init backup registers to default */
-    memcpy(p->psr + 36, bd_psr_init + 36, sizeof(uint32_t) * 5);
-    memcpy(p->psr + 42, bd_psr_init + 42, sizeof(uint32_t) * 3);
+    _psr_init(p, 36, 5);
+    _psr_init(p, 42, 3);
 
     bd_psr_unlock(p);
 }
@@ -314,44 +463,53 @@ void bd_psr_restore_state(BD_REGISTERS *p)
 {
     uint32_t old_psr[13];
     uint32_t new_psr[13];
+    int      i;
 
     bd_psr_lock(p);
 
     if (p->num_cb) {
-        memcpy(old_psr, p->psr, sizeof(old_psr[0]) * 13);
+        for (i = 4; i < 13; i++) {
+            old_psr[i] = PSR_GET(p, i);
+        }
     }
 
     /* restore backup registers */
-    memcpy(p->psr + 4,  p->psr + 36, sizeof(uint32_t) * 5);
-    memcpy(p->psr + 10, p->psr + 42, sizeof(uint32_t) * 3);
+    _psr_copy(p, 4,  36, 5);
+    _psr_copy(p, 10, 42, 3);
 
     if (p->num_cb) {
-        memcpy(new_psr, p->psr, sizeof(new_psr[0]) * 13);
+        for (i = 4; i < 13; i++) {
+            new_psr[i] = PSR_GET(p, i);
+        }
     }
 
     /* init backup registers to default */
-    memcpy(p->psr + 36, bd_psr_init + 36, sizeof(uint32_t) * 5);
-    memcpy(p->psr + 42, bd_psr_init + 42, sizeof(uint32_t) * 3);
+    _psr_init(p, 36, 5);
+    _psr_init(p, 42, 3);
 
     /* generate restore events */
     if (p->num_cb) {
         BD_PSR_EVENT ev;
-        unsigned     i, j;
+
+        /* restore event handlers re-open playlist and seek, writing the same
+         * registers several times. Coalesce these writes to single change
+         * event per register, sent after all restore events. */
+        bd_psr_begin(p);
 
         ev.ev_type = BD_PSR_RESTORE;
 
         for (i = 4; i < 13; i++) {
-            if (i != PSR_NAV_TIMER) {
+            if (i != PSR_NAV_TIMER && PSR_MASK_BIT(p->cb_mask, i)) {
 
                 ev.psr_idx = i;
                 ev.old_val = old_psr[i];
                 ev.new_val = new_psr[i];
 
-                for (j = 0; j < p->num_cb; j++) {
-                    p->cb[j].cb(p->cb[j].handle, &ev);
-                }
+                _notify(p, &ev);
             }
         }
+
+        bd_psr_commit(p);
     }
 
     bd_psr_unlock(p);
@@ -368,7 +526,7 @@ int bd_gpr_write(BD_REGISTERS *p, int reg, uint32_t val)
         return -1;
     }
 
-    p->gpr[reg] = val;
+    bd_atomic_store(&p->gpr[reg], val);
     return 0;
 }
 
@@ -379,7 +537,7 @@ uint32_t bd_gpr_read(BD_REGISTERS *p, int reg)
         return 0;
     }
 
-    return p->gpr[reg];
+    return bd_atomic_load_relaxed(&p->gpr[reg]);
 }
 
 /*
@@ -395,17 +553,21 @@ uint32_t bd_psr_read(BD_REGISTERS *p, int reg)
         return -1;
     }
 
+#ifdef BD_HAVE_ATOMICS
+    val = PSR_GET(p, reg);
+#else
     bd_psr_lock(p);
-
-    val = p->psr[reg];
-
+    val = PSR_GET(p, reg);
     bd_psr_unlock(p);
+#endif
 
     return val;
 }
 
 int bd_psr_setting_write(BD_REGISTERS *p, int reg, uint32_t val)
 {
+    uint32_t old_val;
+
     if (reg < 0 || reg >= BD_PSR_COUNT) {
         BD_DEBUG(DBG_BLURAY, "bd_psr_write(%d, %d): invalid register\n", reg, val);
         return -1;
@@ -413,32 +575,35 @@ int bd_psr_setting_write(BD_REGISTERS *p, int reg, uint32_t val)
 
     bd_psr_lock(p);
 
-    if (p->psr[reg] == val) {
+    old_val = PSR_GET(p, reg);
+
+    if (old_val == val) {
         BD_DEBUG(DBG_BLURAY, "bd_psr_write(%d, %d): no change in value\n", reg, val);
     } else if (bd_psr_name[reg]) {
-        BD_DEBUG(DBG_BLURAY, "bd_psr_write(): PSR%-4d (%s) 0x%x -> 0x%x\n", reg, bd_psr_name[reg], p->psr[reg], val);
+        BD_DEBUG(DBG_BLURAY, "bd_psr_write(): PSR%-4d (%s) 0x%x -> 0x%x\n", reg, bd_psr_name[reg], old_val, val);
     } else {
-        BD_DEBUG(DBG_BLURAY, "bd_psr_write(): PSR%-4d 0x%x -> 0x%x\n", reg, p->psr[reg], val);
+        BD_DEBUG(DBG_BLURAY, "bd_psr_write(): PSR%-4d 0x%x -> 0x%x\n", reg, old_val, val);
     }
 
-    if (p->num_cb) {
+    PSR_SET(p, reg, val);
+
+    if (p->txn_depth) {
+        /* notify in bd_psr_commit() */
+        if (!PSR_MASK_BIT(p->txn_mask, reg)) {
+            p->txn_mask[reg >> 5] |= 1u << (reg & 31);
+            p->txn_old[reg] = old_val;
+            p->txn_reg[p->txn_count++] = reg;
+        }
+
+    } else if (PSR_MASK_BIT(p->cb_mask, reg)) {
         BD_PSR_EVENT ev;
-        unsigned i;
 
-        ev.ev_type = p->psr[reg] == val ? BD_PSR_WRITE : BD_PSR_CHANGE;
+        ev.ev_type = old_val == val ? BD_PSR_WRITE : BD_PSR_CHANGE;
         ev.psr_idx = reg;
-        ev.old_val = p->psr[reg];
+        ev.old_val = old_val;
         ev.new_val = val;
 
-        p->psr[reg] = val;
-
-        for (i = 0; i < p->num_cb; i++) {
-            p->cb[i].cb(p->cb[i].handle, &ev);
-        }
-
-    } else {
-
-        p->psr[reg] = val;
+        _notify(p, &ev);
     }
 
     bd_psr_unlock(p);
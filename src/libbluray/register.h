@@ -24,6 +24,9 @@
 
 #include <stdint.h>
 
+#define BD_PSR_COUNT 128
+#define BD_GPR_COUNT 4096
+
 /*
  * Player Status Registers
  */
@@ -186,6 +189,28 @@ void bd_psr_lock(BD_REGISTERS *);
  */
 void bd_psr_unlock(BD_REGISTERS *);
 
+/**
+ *
+ *  Begin PSR write transaction
+ *
+ *  Locks PSRs (like bd_psr_lock()). Change callbacks of writes are delayed
+ *  until bd_psr_commit(). Register that is written several times generates
+ *  single event (value at transaction start -> final value).
+ *  Transactions can be nested, events are sent when outermost transaction is committed,
+ *  in order of first write.
+ *
+ * @param registers  BD_REGISTERS object
+ */
+void bd_psr_begin(BD_REGISTERS *);
+
+/**
+ *
+ *  Commit PSR write transaction and unlock PSRs
+ *
+ * @param registers  BD_REGISTERS object
+ */
+void bd_psr_commit(BD_REGISTERS *);
+
 /**
  *
  *  Save player state
@@ -202,6 +227,8 @@ void bd_psr_save_state(BD_REGISTERS *);
  *
  *  Restore registers 4-8 and 10-12 from backup registers 36-40 and 42-44.
  *  Initialize backup registers to default values.
+ *  BD_PSR_RESTORE events are delivered inside PSR write transaction:
+ *  PSRs written by restore event handlers are notified once, after all restore events.
  *
  * @param registers  BD_REGISTERS object
  */
@@ -249,6 +276,23 @@ typedef struct {
  */
 void bd_psr_register_cb(BD_REGISTERS *, void (*callback)(void*,BD_PSR_EVENT*), void *cb_handle);
 
+/**
+ *
+ *  Register callback function for selected registers
+ *
+ *  Function is called only when one of listed PSRs is written or restored.
+ *  BD_PSR_SAVE event is always delivered.
+ *  If callback is already registered, the register list is replaced.
+ *
+ * @param registers  BD_REGISTERS object
+ * @param callback  callback function pointer
+ * @param handle  application-specific handle that is provided to callback function as first parameter
+ * @param psrs  PSR numbers
+ * @param num_psrs  number of entries in psrs
+ */
+void bd_psr_register_cb_filter(BD_REGISTERS *, void (*callback)(void*,BD_PSR_EVENT*), void *cb_handle,
+                               const unsigned *psrs, unsigned num_psrs);
+
 /**
  *
  *  Unregister callback function
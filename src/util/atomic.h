@@ -0,0 +1,76 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Minimal atomic operations for lock-free data structures
+ */
+
+#ifndef LIBBLURAY_ATOMIC_H_
+#define LIBBLURAY_ATOMIC_H_
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+
+#include <stdatomic.h>
+
+#define BD_HAVE_ATOMICS 1
+
+typedef atomic_uint BD_ATOMIC_UINT;
+
+#define bd_atomic_load(p)             atomic_load_explicit((p), memory_order_acquire)
+#define bd_atomic_load_relaxed(p)     atomic_load_explicit((p), memory_order_relaxed)
+#define bd_atomic_store(p, v)         atomic_store_explicit((p), (v), memory_order_release)
+#define bd_atomic_cas(p, pexp, v)     atomic_compare_exchange_strong_explicit((p), (pexp), (v), \
+                                                                              memory_order_acq_rel, \
+                                                                              memory_order_acquire)
+#define bd_atomic_fence()             atomic_thread_fence(memory_order_seq_cst)
+#define bd_atomic_add(p, v)           atomic_fetch_add_explicit((p), (v), memory_order_relaxed)  /* returns old value */
+#define bd_atomic_dec(p)              atomic_fetch_sub_explicit((p), 1, memory_order_acq_rel)    /* returns old value */
+
+#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+
+#define BD_HAVE_ATOMICS 1
+
+typedef volatile unsigned BD_ATOMIC_UINT;
+
+#define bd_atomic_load(p)             __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define bd_atomic_load_relaxed(p)     __atomic_load_n((p), __ATOMIC_RELAXED)
+#define bd_atomic_store(p, v)         __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define bd_atomic_cas(p, pexp, v)     __atomic_compare_exchange_n((p), (pexp), (v), 0, \
+                                                                  __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define bd_atomic_fence()             __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define bd_atomic_add(p, v)           __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)  /* returns old value */
+#define bd_atomic_dec(p)              __atomic_fetch_sub((p), 1, __ATOMIC_ACQ_REL)    /* returns old value */
+
+#else
+
+/* no atomics: operations are valid only when serialized by a lock (BD_HAVE_ATOMICS is not defined) */
+typedef volatile unsigned BD_ATOMIC_UINT;
+
+#define bd_atomic_load(p)             (*(p))
+#define bd_atomic_load_relaxed(p)     (*(p))
+#define bd_atomic_store(p, v)         (*(p) = (v))
+#define bd_atomic_cas(p, pexp, v)     (*(p) == *(pexp) ? (*(p) = (v), 1) : (*(pexp) = *(p), 0))
+#define bd_atomic_fence()             do { } while (0)
+#define bd_atomic_add(p, v)           ((*(p) += (v)) - (v))
+#define bd_atomic_dec(p)              ((*(p))--)
+
+#endif
+
+#endif /* LIBBLURAY_ATOMIC_H_ */
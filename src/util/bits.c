@@ -24,8 +24,10 @@
 
 #include "file/file.h"
 #include "util/logging.h"
+#include "util/macro.h"
 
 #include <stdio.h>  // SEEK_*
+#include <stdlib.h>
 
 /**
  * \file
@@ -44,8 +46,24 @@ void bs_init( BITSTREAM *bs, BD_FILE_H *fp )
 {
     int64_t size = file_size(fp);;
     bs->fp = fp;
+    bs->mem = NULL;
     bs->pos = 0;
     bs->end = (size < 0) ? 0 : size;
+
+    if (size > BF_BUF_SIZE && size <= BF_MEM_SIZE) {
+        /* read whole file at once */
+        bs->mem = malloc((size_t)size);
+        if (bs->mem) {
+            bs->size = file_read(bs->fp, bs->mem, size);
+            if (bs->size == (size_t)size) {
+                bb_init(&bs->bb, bs->mem, bs->size);
+                return;
+            }
+            X_FREE(bs->mem);
+            file_seek(bs->fp, 0, SEEK_SET);
+        }
+    }
+
     bs->size = file_read(bs->fp, bs->buf, BF_BUF_SIZE);
     if (bs->size == 0 || bs->size > BF_BUF_SIZE) {
         bs->size = 0;
@@ -55,6 +73,17 @@ void bs_init( BITSTREAM *bs, BD_FILE_H *fp )
     bb_init(&bs->bb, bs->buf, bs->size);
 }
 
+void bs_close( BITSTREAM *bs )
+{
+    X_FREE(bs->mem);
+}
+
+/* whole file is in buffer, no need to access file */
+static int _bs_loaded( const BITSTREAM *bs )
+{
+    return bs->pos == 0 && (int64_t)bs->size >= bs->end;
+}
+
 void bb_seek( BITBUFFER *bb, int64_t off, int whence)
 {
     int64_t b;
@@ -98,7 +127,15 @@ void bs_seek( BITSTREAM *bs, int64_t off, int whence)
             break;
     }
     b = off >> 3;
-    if (b >= bs->end)
+    if (_bs_loaded(bs)) {
+        if (b >= bs->end) {
+            bs->bb.p      = bs->bb.p_end;
+            bs->bb.i_left = 8;
+        } else {
+            bs->bb.p      = &bs->bb.p_start[b];
+            bs->bb.i_left = 8 - (off & 0x07);
+        }
+    } else if (b >= bs->end)
     {
         if (BF_BUF_SIZE < bs->end) {
             bs->pos = bs->end - BF_BUF_SIZE;
@@ -110,7 +147,7 @@ void bs_seek( BITSTREAM *bs, int64_t off, int whence)
         bs->size = file_read(bs->fp, bs->buf, BF_BUF_SIZE);
         bb_init(&bs->bb, bs->buf, bs->size);
         bs->bb.p = bs->bb.p_end;
-    } else if (b < bs->pos || b >= (bs->pos + BF_BUF_SIZE)) {
+    } else if (b < bs->pos || b >= (bs->pos + (int64_t)bs->size)) {
         file_seek(bs->fp, b, SEEK_SET);
         bs->pos = b;
         bs->size = file_read(bs->fp, bs->buf, BF_BUF_SIZE);
@@ -133,7 +170,8 @@ void bs_seek_byte( BITSTREAM *s, int64_t off)
 }
 
 
-uint32_t bb_read( BITBUFFER *bb, int i_count )
+/* bit-by-bit reader, used near end of buffer (see bb_read()) */
+uint32_t bb_read_slow( BITBUFFER *bb, int i_count )
 {
     static const uint32_t i_mask[33] = {
         0x00,
@@ -182,7 +220,7 @@ uint32_t bs_read( BITSTREAM *bs, int i_count )
     int left;
     int bytes = (i_count + 7) >> 3;
 
-    if (bs->bb.p + bytes >= bs->bb.p_end) {
+    if (bs->bb.p + bytes >= bs->bb.p_end && !_bs_loaded(bs)) {
         bs->pos = bs->pos + (bs->bb.p - bs->bb.p_start);
         left = bs->bb.i_left;
         file_seek(bs->fp, bs->pos, SEEK_SET);
@@ -209,7 +247,7 @@ void bs_skip( BITSTREAM *bs, size_t i_count )
     int left;
     size_t bytes = (i_count + 7) >> 3;
 
-    if (bs->bb.p + bytes >= bs->bb.p_end) {
+    if (bs->bb.p + bytes >= bs->bb.p_end && !_bs_loaded(bs)) {
         bs->pos = bs->pos + (bs->bb.p - bs->bb.p_start);
         left = bs->bb.i_left;
         file_seek(bs->fp, bs->pos, SEEK_SET);
@@ -28,6 +28,7 @@
 
 #include <stdint.h>
 #include <stddef.h>    // size_t
+#include <string.h>    // memcpy
 
 
 /**
@@ -36,6 +37,7 @@
  */
 
 #define BF_BUF_SIZE   (1024*32)
+#define BF_MEM_SIZE   (1024*1024*8)  /* files up to this size are parsed from memory */
 
 typedef struct {
     const uint8_t *p_start;
@@ -48,6 +50,7 @@ typedef struct {
 typedef struct {
     BD_FILE_H *fp;
     uint8_t    buf[BF_BUF_SIZE];
+    uint8_t   *mem;       /* whole file (when larger than buf) */
     BITBUFFER  bb;
     int64_t    pos;
     int64_t    end;
@@ -56,15 +59,50 @@ typedef struct {
 
 BD_PRIVATE void bb_init( BITBUFFER *bb, const uint8_t *p_data, size_t i_data );
 BD_PRIVATE void bs_init( BITSTREAM *bs, BD_FILE_H *fp );
+BD_PRIVATE void bs_close( BITSTREAM *bs );
 BD_PRIVATE void bb_seek( BITBUFFER *bb, int64_t off, int whence);
 BD_PRIVATE void bs_seek( BITSTREAM *bs, int64_t off, int whence);
 BD_PRIVATE void bb_seek_byte( BITBUFFER *bb, int64_t off);
 BD_PRIVATE void bs_seek_byte( BITSTREAM *s, int64_t off);
 BD_PRIVATE void bb_skip( BITBUFFER *bb, size_t i_count );
 BD_PRIVATE void bs_skip( BITSTREAM *bs, size_t i_count );  /* note: i_count must be less than BF_BUF_SIZE */
-BD_PRIVATE uint32_t bb_read( BITBUFFER *bb, int i_count );
+BD_PRIVATE uint32_t bb_read_slow( BITBUFFER *bb, int i_count );
 BD_PRIVATE uint32_t bs_read( BITSTREAM *bs, int i_count );
 
+/* unaligned big-endian 64-bit load */
+static inline uint64_t bb_load_be64( const uint8_t *p )
+{
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return __builtin_bswap64(v);
+#elif defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+#else
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+           ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) | ((uint64_t)p[6] <<  8) |  (uint64_t)p[7];
+#endif
+}
+
+/* read up to 32 bits */
+static inline uint32_t bb_read( BITBUFFER *bb, int i_count )
+{
+    if (i_count > 0 && i_count <= 32 && bb->p_end - bb->p >= 8) {
+        /* fast path: extract bits from one 64-bit word */
+        int      skip  = 8 - bb->i_left;
+        int      used  = skip + i_count;
+        uint64_t word  = bb_load_be64(bb->p);
+
+        bb->p     += used >> 3;
+        bb->i_left = 8 - (used & 7);
+
+        return (uint32_t)((word << skip) >> (64 - i_count));
+    }
+    return bb_read_slow(bb, i_count);
+}
+
 static inline int64_t bb_pos( const BITBUFFER *bb )
 {
     return 8 * ( bb->p - bb->p_start ) + 8 - bb->i_left;
@@ -100,6 +138,13 @@ static inline void bb_read_bytes( BITBUFFER *bb, uint8_t *buf, int i_count )
 {
     int ii;
 
+    if (bb->i_left == 8 && i_count >= 0 && bb->p_end - bb->p >= i_count) {
+        /* byte-aligned */
+        memcpy(buf, bb->p, i_count);
+        bb->p += i_count;
+        return;
+    }
+
     for (ii = 0; ii < i_count; ii++) {
         buf[ii] = bb_read(bb, 8);
     }
@@ -109,6 +154,13 @@ static inline void bs_read_bytes( BITSTREAM *s, uint8_t *buf, int i_count )
 {
     int ii;
 
+    if (s->bb.i_left == 8 && i_count >= 0 && s->bb.p_end - s->bb.p >= i_count) {
+        /* byte-aligned, data in buffer */
+        memcpy(buf, s->bb.p, i_count);
+        s->bb.p += i_count;
+        return;
+    }
+
     for (ii = 0; ii < i_count; ii++) {
         buf[ii] = bs_read(s, 8);
     }
@@ -0,0 +1,261 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/* MAP_ANONYMOUS, MADV_HUGEPAGE */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "buffer.h"
+
+#include "atomic.h"
+#include "logging.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <sys/mman.h>
+#   if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#       define MAP_ANONYMOUS MAP_ANON
+#   endif
+#endif
+
+#define HUGE_PAGE_SIZE  (2 * 1024 * 1024)
+
+/* size of OS allocation */
+static size_t _alloc_size(size_t size)
+{
+    size_t align = size >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : BD_BUFFER_ALIGN;
+    return (size + align - 1) & ~(align - 1);
+}
+
+/*
+ * OS allocation
+ */
+
+#if defined(_WIN32)
+
+static void *_os_alloc(size_t size)
+{
+    void *p = NULL;
+
+    if (size >= HUGE_PAGE_SIZE) {
+        /* requires SeLockMemoryPrivilege */
+        SIZE_T large = GetLargePageMinimum();
+        if (large && !(size % large)) {
+            p = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+        }
+    }
+    if (!p) {
+        p = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    }
+    return p;
+}
+
+static void _os_free(void *p, size_t size)
+{
+    (void)size;
+    VirtualFree(p, 0, MEM_RELEASE);
+}
+
+#else
+
+static void *_os_alloc(size_t size)
+{
+    void *p;
+
+    if (size < HUGE_PAGE_SIZE) {
+        if (posix_memalign(&p, BD_BUFFER_ALIGN, size)) {
+            return NULL;
+        }
+        return p;
+    }
+
+#if defined(MAP_ANONYMOUS)
+    {
+        /* over-allocate and trim to huge page boundary */
+        uint8_t *map, *start;
+        size_t   head, tail;
+
+        map = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            return NULL;
+        }
+
+        start = (uint8_t *)(((uintptr_t)map + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+        head  = (size_t)(start - map);
+        tail  = HUGE_PAGE_SIZE - head;
+        if (head) {
+            munmap(map, head);
+        }
+        if (tail) {
+            munmap(start + size, tail);
+        }
+
+#if defined(MADV_HUGEPAGE)
+        madvise(start, size, MADV_HUGEPAGE);
+#endif
+        return start;
+    }
+#else
+    if (posix_memalign(&p, BD_BUFFER_ALIGN, size)) {
+        return NULL;
+    }
+    return p;
+#endif
+}
+
+static void _os_free(void *p, size_t size)
+{
+#if defined(MAP_ANONYMOUS)
+    if (size >= HUGE_PAGE_SIZE) {
+        munmap(p, size);
+        return;
+    }
+#else
+    (void)size;
+#endif
+    free(p);
+}
+
+#endif
+
+/*
+ * buffer pool
+ */
+
+#define POOL_SIZE       4
+#define POOL_MAX_BYTES  (128 * 1024 * 1024)
+
+#ifdef BD_HAVE_ATOMICS
+static BD_ATOMIC_UINT pool_lock;  /* spin lock protecting pool */
+static struct {
+    void   *buf;
+    size_t  size;  /* allocation size */
+} pool[POOL_SIZE];
+static size_t pool_bytes;
+
+static void _pool_lock(void)
+{
+    unsigned expected = 0;
+    while (!bd_atomic_cas(&pool_lock, &expected, 1)) {
+        expected = 0;
+    }
+}
+
+static void _pool_unlock(void)
+{
+    bd_atomic_store(&pool_lock, 0);
+}
+#endif
+
+static void *_pool_get(size_t size)
+{
+    void *p = NULL;
+#ifdef BD_HAVE_ATOMICS
+    unsigned ii;
+
+    _pool_lock();
+    for (ii = 0; ii < POOL_SIZE; ii++) {
+        if (pool[ii].buf && pool[ii].size == size) {
+            p = pool[ii].buf;
+            pool[ii].buf = NULL;
+            pool_bytes -= size;
+            break;
+        }
+    }
+    _pool_unlock();
+#else
+    (void)size;
+#endif
+    return p;
+}
+
+/* returns 0 if pool is full */
+static int _pool_put(void *p, size_t size)
+{
+    int result = 0;
+#ifdef BD_HAVE_ATOMICS
+    unsigned ii;
+
+    _pool_lock();
+    if (pool_bytes + size <= POOL_MAX_BYTES) {
+        for (ii = 0; ii < POOL_SIZE; ii++) {
+            if (!pool[ii].buf) {
+                pool[ii].buf  = p;
+                pool[ii].size = size;
+                pool_bytes += size;
+                result = 1;
+                break;
+            }
+        }
+    }
+    _pool_unlock();
+#else
+    (void)p;
+    (void)size;
+#endif
+    return result;
+}
+
+/*
+ *
+ */
+
+void *bd_buffer_alloc(size_t size)
+{
+    void *p;
+
+    if (!size) {
+        return NULL;
+    }
+
+    size = _alloc_size(size);
+
+    p = _pool_get(size);
+    if (p) {
+        return p;
+    }
+
+    p = _os_alloc(size);
+    if (!p) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "bd_buffer_alloc(%"PRIu64") failed\n", (uint64_t)size);
+    }
+    return p;
+}
+
+void bd_buffer_free(void *p, size_t size)
+{
+    if (!p) {
+        return;
+    }
+
+    size = _alloc_size(size);
+
+    if (!_pool_put(p, size)) {
+        _os_free(p, size);
+    }
+}
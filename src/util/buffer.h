@@ -0,0 +1,43 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2026  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBLURAY_BUFFER_H_
+#define LIBBLURAY_BUFFER_H_
+
+#include "attributes.h"
+
+#include <stddef.h>
+
+/*
+ * large I/O buffers
+ *
+ * Buffers are aligned to BD_BUFFER_ALIGN (direct I/O). Buffers of at least
+ * 2 MB are backed by huge pages where available.
+ * Freed buffers are kept in a small pool and reused by next allocation
+ * of the same size (ex. read-ahead buffer of next clip).
+ */
+
+#define BD_BUFFER_ALIGN  4096
+
+BD_PRIVATE void *bd_buffer_alloc(size_t size);
+
+/* size must be the size given to bd_buffer_alloc() */
+BD_PRIVATE void  bd_buffer_free(void *buf, size_t size);
+
+#endif // LIBBLURAY_BUFFER_H_
@@ -62,6 +62,24 @@ void bd_set_debug_handler(BD_LOG_FUNC);
 void bd_set_debug_mask(uint32_t mask);
 uint32_t bd_get_debug_mask(void);
 
+/*
+ * Asynchronous logging.
+ *
+ * Log messages are queued and passed to the log handler (or written to
+ * log file) from a background thread. Messages are dropped when the queue
+ * is full. Messages longer than 511 bytes are truncated.
+ * Should be changed only when no other thread is logging (ex. before
+ * opening any discs).
+ *
+ * queue_size: max. number of queued messages (0 = synchronous logging (default)).
+ * Returns 1 on success, 0 if asynchronous logging is not supported.
+ */
+
+int bd_set_debug_async(unsigned queue_size);
+
+/* number of log messages dropped because the asynchronous queue was full */
+uint32_t bd_get_debug_dropped(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,8 +20,15 @@
 
 #include "logging.h"
 
+#include "atomic.h"
+#include "macro.h"
+#include "mutex.h"
+#include "thread.h"
+#include "time.h"
+
 #include "file/file.h"
 
+#include <inttypes.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
@@ -29,6 +36,221 @@
 
 uint32_t            debug_mask = (uint32_t)-1; /* set all bits to make sure bd_debug() is called for initialization */
 static BD_LOG_FUNC  log_func   = NULL;
+static FILE        *logfile    = NULL;
+
+static void _log_output(const char *msg)
+{
+    if (log_func) {
+        log_func(msg);
+    } else {
+        fprintf(logfile, "%s", msg);
+    }
+}
+
+/*
+ * asynchronous log sink
+ *
+ * Messages are formatted by the logging thread and queued to a bounded
+ * multi-producer ring. Output (log handler / file) is done in a background
+ * thread. Messages are dropped when the ring is full.
+ */
+
+#define LOG_MSG_SIZE        512   /* longer messages are truncated */
+#define LOG_QUEUE_MAX_SIZE  4096
+
+typedef struct {
+    BD_ATOMIC_UINT seq;   /* == pos: free, == pos + 1: message ready */
+    char           msg[LOG_MSG_SIZE];
+} LOG_SLOT;
+
+typedef struct {
+    BD_ATOMIC_UINT tail;      /* next slot to write */
+    unsigned       head;      /* next slot to output (consumer only) */
+    unsigned       mask;
+    LOG_SLOT      *slot;
+
+    BD_ATOMIC_UINT sleeping;  /* consumer is waiting for cond */
+    BD_ATOMIC_UINT stop;
+    BD_MUTEX       mutex;
+    BD_COND        cond;
+    BD_THREAD      thread;
+} LOG_QUEUE;
+
+static LOG_QUEUE      *log_queue   = NULL;
+static BD_ATOMIC_UINT  log_dropped = 0;
+
+#ifdef BD_HAVE_ATOMICS
+
+static int _log_push(LOG_QUEUE *q, const char *msg)
+{
+    unsigned  pos = bd_atomic_load(&q->tail);
+    LOG_SLOT *s;
+
+    while (1) {
+        int diff;
+
+        s    = &q->slot[pos & q->mask];
+        diff = (int)(bd_atomic_load(&s->seq) - pos);
+        if (diff == 0) {
+            if (bd_atomic_cas(&q->tail, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* full */
+            return 0;
+        } else {
+            pos = bd_atomic_load(&q->tail);
+        }
+    }
+
+    strncpy(s->msg, msg, LOG_MSG_SIZE - 1);
+    s->msg[LOG_MSG_SIZE - 1] = 0;
+    bd_atomic_store(&s->seq, pos + 1);
+
+    bd_atomic_fence();
+    if (bd_atomic_load(&q->sleeping)) {
+        bd_mutex_lock(&q->mutex);
+        bd_cond_signal(&q->cond);
+        bd_mutex_unlock(&q->mutex);
+    }
+
+    return 1;
+}
+
+static int _log_pop(LOG_QUEUE *q)
+{
+    LOG_SLOT *s = &q->slot[q->head & q->mask];
+
+    if (bd_atomic_load(&s->seq) != q->head + 1) {
+        return 0;
+    }
+
+    _log_output(s->msg);
+
+    bd_atomic_store(&s->seq, q->head + q->mask + 1);
+    q->head++;
+    return 1;
+}
+
+static void *_log_thread(void *p)
+{
+    LOG_QUEUE *q = (LOG_QUEUE *)p;
+    unsigned   dropped = 0;
+
+    while (1) {
+        unsigned d;
+
+        while (_log_pop(q)) {
+        }
+
+        d = bd_atomic_load(&log_dropped);
+        if (d != dropped) {
+            char msg[64];
+            sprintf(msg, "logging.c: %u log messages dropped\n", d - dropped);
+            _log_output(msg);
+            dropped = d;
+        }
+
+        if (bd_atomic_load(&q->stop)) {
+            break;
+        }
+
+        bd_mutex_lock(&q->mutex);
+        bd_atomic_store(&q->sleeping, 1);
+        bd_atomic_fence();
+        if (bd_atomic_load(&q->slot[q->head & q->mask].seq) != q->head + 1 && !bd_atomic_load(&q->stop)) {
+            /* timeout: producer may have missed sleeping flag */
+            bd_cond_timedwait(&q->cond, &q->mutex, 100);
+        }
+        bd_atomic_store(&q->sleeping, 0);
+        bd_mutex_unlock(&q->mutex);
+    }
+
+    return NULL;
+}
+
+static void _log_queue_free(LOG_QUEUE **pq)
+{
+    LOG_QUEUE *q = *pq;
+
+    if (q) {
+        bd_mutex_lock(&q->mutex);
+        bd_atomic_store(&q->stop, 1);
+        bd_cond_signal(&q->cond);
+        bd_mutex_unlock(&q->mutex);
+
+        bd_thread_join(&q->thread);
+
+        bd_cond_destroy(&q->cond);
+        bd_mutex_destroy(&q->mutex);
+        X_FREE(q->slot);
+        X_FREE(*pq);
+    }
+}
+
+static LOG_QUEUE *_log_queue_init(unsigned queue_size)
+{
+    LOG_QUEUE *q;
+    unsigned   size = 16, ii;
+
+    /* round up to power of two */
+    while (size < queue_size && size < LOG_QUEUE_MAX_SIZE) {
+        size <<= 1;
+    }
+
+    q = calloc(1, sizeof(*q));
+    if (!q) {
+        return NULL;
+    }
+    q->slot = calloc(size, sizeof(LOG_SLOT));
+    if (!q->slot) {
+        X_FREE(q);
+        return NULL;
+    }
+    for (ii = 0; ii < size; ii++) {
+        bd_atomic_store(&q->slot[ii].seq, ii);
+    }
+    q->mask = size - 1;
+
+    bd_mutex_init(&q->mutex);
+    bd_cond_init(&q->cond);
+
+    if (bd_thread_create(&q->thread, "bd_log", _log_thread, q) < 0) {
+        bd_cond_destroy(&q->cond);
+        bd_mutex_destroy(&q->mutex);
+        X_FREE(q->slot);
+        X_FREE(q);
+    }
+
+    return q;
+}
+
+#endif /* BD_HAVE_ATOMICS */
+
+int bd_set_debug_async(unsigned queue_size)
+{
+#ifdef BD_HAVE_ATOMICS
+    LOG_QUEUE *q = log_queue;
+
+    /* stop old queue (flushes queued messages) */
+    log_queue = NULL;
+    _log_queue_free(&q);
+
+    if (queue_size) {
+        log_queue = _log_queue_init(queue_size);
+        return log_queue ? 1 : 0;
+    }
+    return 1;
+#else
+    /* no lock-free queue available */
+    return !queue_size;
+#endif
+}
+
+uint32_t bd_get_debug_dropped(void)
+{
+    return bd_atomic_load(&log_dropped);
+}
 
 void bd_set_debug_handler(BD_LOG_FUNC f)
 {
@@ -48,7 +270,6 @@ uint32_t bd_get_debug_mask(void)
 void bd_debug(const char *file, int line, uint32_t mask, const char *format, ...)
 {
     static int   debug_init = 0;
-    static FILE *logfile    = NULL;
 
     // Only call getenv() once.
     if (!debug_init) {
@@ -86,10 +307,153 @@ void bd_debug(const char *file, int line, uint32_t mask, const char *format, ...
         vsnprintf(pt, sizeof(buffer) - (size_t)(intptr_t)(pt - buffer) - 1, format, args);
         va_end(args);
 
-        if (log_func) {
-            log_func(buffer);
-        } else {
-            fprintf(logfile, "%s", buffer);
+#ifdef BD_HAVE_ATOMICS
+        if (log_queue) {
+            if (!_log_push(log_queue, buffer)) {
+                bd_atomic_add(&log_dropped, 1);
+            }
+            return;
         }
+#endif
+
+        _log_output(buffer);
+    }
+}
+
+/*
+ * binary trace
+ */
+
+typedef struct {
+    BD_ATOMIC_UINT seq;   /* record index + 1, written after record data */
+    uint16_t       id;
+    uint32_t       arg2;
+    uint64_t       time;  /* us */
+    uint64_t       arg1;
+} BD_TRACE_RECORD;
+
+struct bd_trace_buf_s {
+    BD_ATOMIC_UINT   next;     /* index of next record */
+    BD_ATOMIC_UINT   enabled;
+    unsigned         mask;     /* number of records - 1 */
+#ifndef BD_HAVE_ATOMICS
+    BD_MUTEX         mutex;
+#endif
+    BD_TRACE_RECORD *rec;
+};
+
+static const char * const trace_names[] = {
+    "none", "read", "unit", "file_read", "read_error", "seek", "clip_open", "decrypt", "event",
+};
+
+BD_TRACE_BUF *bd_trace_init(unsigned num_records)
+{
+    BD_TRACE_BUF *p;
+    unsigned size = 16;
+
+    /* round up to power of two */
+    while (size < num_records && size < (1u << 24)) {
+        size <<= 1;
+    }
+
+    p = calloc(1, sizeof(*p));
+    if (!p) {
+        return NULL;
+    }
+    p->rec = calloc(size, sizeof(BD_TRACE_RECORD));
+    if (!p->rec) {
+        X_FREE(p);
+        return NULL;
+    }
+
+    p->mask    = size - 1;
+    p->enabled = 1;
+#ifndef BD_HAVE_ATOMICS
+    bd_mutex_init(&p->mutex);
+#endif
+
+    return p;
+}
+
+void bd_trace_free(BD_TRACE_BUF **p)
+{
+    if (p && *p) {
+#ifndef BD_HAVE_ATOMICS
+        bd_mutex_destroy(&(*p)->mutex);
+#endif
+        X_FREE((*p)->rec);
+        X_FREE(*p);
+    }
+}
+
+void bd_trace_enable(BD_TRACE_BUF *p, int enable)
+{
+    bd_atomic_store(&p->enabled, !!enable);
+}
+
+void bd_trace(BD_TRACE_BUF *p, bd_trace_id_e id, uint64_t arg1, uint32_t arg2)
+{
+    BD_TRACE_RECORD *r;
+    unsigned         idx;
+
+    if (!bd_atomic_load(&p->enabled)) {
+        return;
+    }
+
+#ifndef BD_HAVE_ATOMICS
+    bd_mutex_lock(&p->mutex);
+#endif
+
+    idx = bd_atomic_add(&p->next, 1);
+    r   = &p->rec[idx & p->mask];
+
+    /* invalidate record while it is being written */
+    bd_atomic_store(&r->seq, 0);
+    bd_atomic_fence();
+    r->id   = (uint16_t)id;
+    r->arg1 = arg1;
+    r->arg2 = arg2;
+    r->time = bd_get_time_us();
+    bd_atomic_store(&r->seq, idx + 1);
+
+#ifndef BD_HAVE_ATOMICS
+    bd_mutex_unlock(&p->mutex);
+#endif
+}
+
+void bd_trace_dump(BD_TRACE_BUF *p)
+{
+    unsigned next, first, idx;
+
+    if (!p) {
+        return;
+    }
+
+    next  = bd_atomic_load(&p->next);
+    first = next > p->mask ? next - p->mask - 1 : 0;
+
+    bd_debug(__FILE__, __LINE__, DBG_CRIT, "trace: %u records (%u total)\n", next - first, next);
+
+    for (idx = first; idx != next; idx++) {
+        BD_TRACE_RECORD *r = &p->rec[idx & p->mask];
+        unsigned id, arg2;
+        uint64_t arg1, time;
+
+        if (bd_atomic_load(&r->seq) != idx + 1) {
+            continue;
+        }
+        id   = r->id;
+        arg1 = r->arg1;
+        arg2 = r->arg2;
+        time = r->time;
+        bd_atomic_fence();
+        if (bd_atomic_load(&r->seq) != idx + 1) {
+            /* overwritten while reading */
+            continue;
+        }
+
+        bd_debug(__FILE__, __LINE__, DBG_CRIT, "trace %8u %12"PRIu64" %-10s %12"PRIu64" %10u\n",
+                 idx, time, id < sizeof(trace_names) / sizeof(trace_names[0]) ? trace_names[id] : "?",
+                 arg1, arg2);
     }
 }
@@ -38,5 +38,56 @@ BD_PRIVATE extern uint32_t debug_mask;
 
 BD_PRIVATE void bd_debug(const char *file, int line, uint32_t mask, const char *format, ...) BD_ATTR_FORMAT_PRINTF(4,5);
 
+/*
+ * per-packet / per-unit debug traces in stream read path.
+ * Compiled out with --disable-hotpath-debug (binary trace is still available).
+ */
+
+#ifdef DISABLE_HOTPATH_DEBUG
+#define BD_DEBUG_HOT(MASK,...) \
+  do {                                                  \
+    if (0) {                                            \
+      bd_debug(__FILE__,__LINE__,MASK,__VA_ARGS__);     \
+    }                                                   \
+  } while (0)
+#else
+#define BD_DEBUG_HOT(MASK,...) BD_DEBUG(MASK,__VA_ARGS__)
+#endif
+
+/*
+ * binary trace
+ *
+ * Fixed-size records are stored to a ring buffer without formatting.
+ * Records are formatted only when the trace is dumped.
+ * Recording is lock-free and can be used from any thread.
+ */
+
+typedef enum {
+    BD_TRACE_NONE = 0,
+    BD_TRACE_READ,        /* bd_read():        arg1 = title position, arg2 = requested bytes */
+    BD_TRACE_UNIT,        /* aligned unit:     arg1 = clip position,  arg2 = clip id */
+    BD_TRACE_FILE_READ,   /* clip file read:   arg1 = clip position,  arg2 = bytes read */
+    BD_TRACE_READ_ERROR,  /* read failed:      arg1 = clip position,  arg2 = clip id */
+    BD_TRACE_SEEK,        /* stream seek:      arg1 = clip position,  arg2 = clip id */
+    BD_TRACE_CLIP_OPEN,   /* clip opened:      arg1 = clip size,      arg2 = clip id */
+    BD_TRACE_DECRYPT,     /* units decrypted:  arg1 = number of units, arg2 = time (us) */
+    BD_TRACE_EVENT,       /* event queued:     arg1 = param,          arg2 = event */
+} bd_trace_id_e;
+
+typedef struct bd_trace_buf_s BD_TRACE_BUF;
+
+BD_PRIVATE BD_TRACE_BUF *bd_trace_init(unsigned num_records);
+BD_PRIVATE void          bd_trace_free(BD_TRACE_BUF **p);
+BD_PRIVATE void          bd_trace_enable(BD_TRACE_BUF *p, int enable);
+BD_PRIVATE void          bd_trace(BD_TRACE_BUF *p, bd_trace_id_e id, uint64_t arg1, uint32_t arg2);
+BD_PRIVATE void          bd_trace_dump(BD_TRACE_BUF *p);
+
+#define BD_TRACE(BUF,ID,ARG1,ARG2)                      \
+  do {                                                  \
+    if (BD_UNLIKELY(!!(BUF))) {                         \
+      bd_trace(BUF, ID, ARG1, ARG2);                    \
+    }                                                   \
+  } while (0)
+
 
 #endif /* LOGGING_H_ */
@@ -30,6 +30,8 @@
 #   include <windows.h>
 #elif defined(HAVE_PTHREAD_H)
 #   include <pthread.h>
+#   include <errno.h>
+#   include <sys/time.h>
 #else
 #   error no mutex support found
 #endif
@@ -47,6 +49,11 @@ static int _mutex_lock(MUTEX_IMPL *p)
     return 0;
 }
 
+static int _mutex_trylock(MUTEX_IMPL *p)
+{
+    return TryEnterCriticalSection(&p->cs) ? 0 : 1;
+}
+
 static int _mutex_unlock(MUTEX_IMPL *p)
 {
     LeaveCriticalSection(&p->cs);
@@ -65,6 +72,149 @@ static int _mutex_destroy(MUTEX_IMPL *p)
     return 0;
 }
 
+typedef struct {
+    CONDITION_VARIABLE cv;
+} COND_IMPL;
+
+static int _cond_init(COND_IMPL *p)
+{
+    InitializeConditionVariable(&p->cv);
+    return 0;
+}
+
+static int _cond_destroy(COND_IMPL *p)
+{
+    (void)p;
+    return 0;
+}
+
+static int _cond_wait(COND_IMPL *p, MUTEX_IMPL *m, unsigned timeout_ms, int timed)
+{
+    if (!SleepConditionVariableCS(&p->cv, &m->cs, timed ? timeout_ms : INFINITE)) {
+        if (GetLastError() == ERROR_TIMEOUT) {
+            return 1;
+        }
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "SleepConditionVariableCS() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _cond_signal(COND_IMPL *p)
+{
+    WakeConditionVariable(&p->cv);
+    return 0;
+}
+
+static int _cond_broadcast(COND_IMPL *p)
+{
+    WakeAllConditionVariable(&p->cv);
+    return 0;
+}
+
+/* non-recursive mutex */
+
+typedef struct {
+    SRWLOCK lock;
+} FAST_MUTEX_IMPL;
+
+static int _fast_mutex_init(FAST_MUTEX_IMPL *p)
+{
+    InitializeSRWLock(&p->lock);
+    return 0;
+}
+
+static int _fast_mutex_destroy(FAST_MUTEX_IMPL *p)
+{
+    (void)p;
+    return 0;
+}
+
+static int _fast_mutex_lock(FAST_MUTEX_IMPL *p)
+{
+    AcquireSRWLockExclusive(&p->lock);
+    return 0;
+}
+
+static int _fast_mutex_trylock(FAST_MUTEX_IMPL *p)
+{
+    return TryAcquireSRWLockExclusive(&p->lock) ? 0 : 1;
+}
+
+static int _fast_mutex_unlock(FAST_MUTEX_IMPL *p)
+{
+    ReleaseSRWLockExclusive(&p->lock);
+    return 0;
+}
+
+/* reader-writer lock */
+
+typedef DWORD THREAD_ID;
+#define NO_THREAD        0
+#define _thread_self()   GetCurrentThreadId()
+#define _thread_equal(a, b) ((a) == (b))
+
+typedef struct {
+    SRWLOCK   lock;
+    THREAD_ID owner;        /* writer */
+    int       write_count;  /* recursive write locks (and read locks taken by writer) */
+} RWLOCK_IMPL;
+
+static int _rwlock_init(RWLOCK_IMPL *p)
+{
+    InitializeSRWLock(&p->lock);
+    return 0;
+}
+
+static int _rwlock_destroy(RWLOCK_IMPL *p)
+{
+    (void)p;
+    return 0;
+}
+
+static int _rwlock_rdlock(RWLOCK_IMPL *p)
+{
+    AcquireSRWLockShared(&p->lock);
+    return 0;
+}
+
+static int _rwlock_tryrdlock(RWLOCK_IMPL *p)
+{
+    return TryAcquireSRWLockShared(&p->lock) ? 0 : 1;
+}
+
+static int _rwlock_wrlock(RWLOCK_IMPL *p)
+{
+    AcquireSRWLockExclusive(&p->lock);
+    return 0;
+}
+
+static int _rwlock_rdunlock(RWLOCK_IMPL *p)
+{
+    ReleaseSRWLockShared(&p->lock);
+    return 0;
+}
+
+static int _rwlock_wrunlock(RWLOCK_IMPL *p)
+{
+    ReleaseSRWLockExclusive(&p->lock);
+    return 0;
+}
+
+/* one-time initialization of static mutexes */
+
+static SRWLOCK once_lock = SRWLOCK_INIT;
+
+static void _once_lock(void)
+{
+    AcquireSRWLockExclusive(&once_lock);
+}
+
+static void _once_unlock(void)
+{
+    ReleaseSRWLockExclusive(&once_lock);
+}
+
 
 #elif defined(HAVE_PTHREAD_H)
 
@@ -106,6 +256,31 @@ static int _mutex_lock(MUTEX_IMPL *p)
     return 0;
 }
 
+static int _mutex_trylock(MUTEX_IMPL *p)
+{
+    int result;
+
+    if (pthread_equal(p->owner, pthread_self())) {
+        /* recursive lock */
+        p->lock_count++;
+        return 0;
+    }
+
+    result = pthread_mutex_trylock(&p->mutex);
+    if (result == EBUSY) {
+        return 1;
+    }
+    if (result) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_mutex_trylock() failed !\n");
+        return -1;
+    }
+
+    p->owner      = pthread_self();
+    p->lock_count = 1;
+
+    return 0;
+}
+
 static int _mutex_unlock(MUTEX_IMPL *p)
 {
     if (!pthread_equal(p->owner, pthread_self())) {
@@ -143,6 +318,226 @@ static int _mutex_destroy(MUTEX_IMPL *p)
     return 0;
 }
 
+typedef struct {
+    pthread_cond_t cond;
+} COND_IMPL;
+
+static int _cond_init(COND_IMPL *p)
+{
+    if (pthread_cond_init(&p->cond, NULL)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_cond_init() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _cond_destroy(COND_IMPL *p)
+{
+    if (pthread_cond_destroy(&p->cond)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_cond_destroy() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _cond_wait(COND_IMPL *p, MUTEX_IMPL *m, unsigned timeout_ms, int timed)
+{
+    int lock_count, result;
+
+    if (!pthread_equal(m->owner, pthread_self())) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_wait(): not owner !\n");
+        return -1;
+    }
+
+    /* pthread_cond_wait() releases the mutex */
+    lock_count    = m->lock_count;
+    m->owner      = (pthread_t)-1;
+    m->lock_count = 0;
+
+    if (timed) {
+        struct timeval  now;
+        struct timespec ts;
+
+        gettimeofday(&now, NULL);
+        ts.tv_sec  = now.tv_sec + timeout_ms / 1000;
+        ts.tv_nsec = now.tv_usec * 1000 + (timeout_ms % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_nsec -= 1000000000;
+            ts.tv_sec++;
+        }
+        result = pthread_cond_timedwait(&p->cond, &m->mutex, &ts);
+    } else {
+        result = pthread_cond_wait(&p->cond, &m->mutex);
+    }
+
+    m->owner      = pthread_self();
+    m->lock_count = lock_count;
+
+    if (result == ETIMEDOUT) {
+        return 1;
+    }
+    if (result) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_cond_wait() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _cond_signal(COND_IMPL *p)
+{
+    return pthread_cond_signal(&p->cond) ? -1 : 0;
+}
+
+static int _cond_broadcast(COND_IMPL *p)
+{
+    return pthread_cond_broadcast(&p->cond) ? -1 : 0;
+}
+
+/* non-recursive mutex */
+
+typedef struct {
+    pthread_mutex_t mutex;
+} FAST_MUTEX_IMPL;
+
+static int _fast_mutex_init(FAST_MUTEX_IMPL *p)
+{
+    if (pthread_mutex_init(&p->mutex, NULL)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_mutex_init() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _fast_mutex_destroy(FAST_MUTEX_IMPL *p)
+{
+    if (pthread_mutex_destroy(&p->mutex)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_mutex_destroy() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _fast_mutex_lock(FAST_MUTEX_IMPL *p)
+{
+    if (pthread_mutex_lock(&p->mutex)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_mutex_lock() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _fast_mutex_trylock(FAST_MUTEX_IMPL *p)
+{
+    int result = pthread_mutex_trylock(&p->mutex);
+    if (result == EBUSY) {
+        return 1;
+    }
+    if (result) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_mutex_trylock() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _fast_mutex_unlock(FAST_MUTEX_IMPL *p)
+{
+    if (pthread_mutex_unlock(&p->mutex)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_mutex_unlock() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* reader-writer lock */
+
+typedef pthread_t THREAD_ID;
+#define NO_THREAD        ((pthread_t)-1)
+#define _thread_self()   pthread_self()
+#define _thread_equal(a, b) pthread_equal((a), (b))
+
+typedef struct {
+    pthread_rwlock_t lock;
+    THREAD_ID        owner;        /* writer */
+    int              write_count;  /* recursive write locks (and read locks taken by writer) */
+} RWLOCK_IMPL;
+
+static int _rwlock_init(RWLOCK_IMPL *p)
+{
+    if (pthread_rwlock_init(&p->lock, NULL)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_rwlock_init() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _rwlock_destroy(RWLOCK_IMPL *p)
+{
+    if (pthread_rwlock_destroy(&p->lock)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_rwlock_destroy() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _rwlock_rdlock(RWLOCK_IMPL *p)
+{
+    if (pthread_rwlock_rdlock(&p->lock)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_rwlock_rdlock() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _rwlock_tryrdlock(RWLOCK_IMPL *p)
+{
+    int result = pthread_rwlock_tryrdlock(&p->lock);
+    if (result == EBUSY) {
+        return 1;
+    }
+    if (result) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_rwlock_tryrdlock() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _rwlock_wrlock(RWLOCK_IMPL *p)
+{
+    if (pthread_rwlock_wrlock(&p->lock)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_rwlock_wrlock() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _rwlock_rdunlock(RWLOCK_IMPL *p)
+{
+    if (pthread_rwlock_unlock(&p->lock)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_rwlock_unlock() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _rwlock_wrunlock(RWLOCK_IMPL *p)
+{
+    return _rwlock_rdunlock(p);
+}
+
+/* one-time initialization of static mutexes */
+
+static pthread_mutex_t once_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void _once_lock(void)
+{
+    pthread_mutex_lock(&once_lock);
+}
+
+static void _once_unlock(void)
+{
+    pthread_mutex_unlock(&once_lock);
+}
+
 #endif /* HAVE_PTHREAD_H */
 
 int bd_mutex_lock(BD_MUTEX *p)
@@ -154,6 +549,15 @@ int bd_mutex_lock(BD_MUTEX *p)
     return _mutex_lock((MUTEX_IMPL*)p->impl);
 }
 
+int bd_mutex_trylock(BD_MUTEX *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_mutex_trylock() failed !\n");
+        return -1;
+    }
+    return _mutex_trylock((MUTEX_IMPL*)p->impl);
+}
+
 int bd_mutex_unlock(BD_MUTEX *p)
 {
     if (!p->impl) {
@@ -179,6 +583,19 @@ int bd_mutex_init(BD_MUTEX *p)
     return 0;
 }
 
+int bd_mutex_init_once(BD_MUTEX *p)
+{
+    int result = 0;
+
+    _once_lock();
+    if (!p->impl) {
+        result = bd_mutex_init(p);
+    }
+    _once_unlock();
+
+    return result;
+}
+
 int bd_mutex_destroy(BD_MUTEX *p)
 {
     if (!p->impl) {
@@ -194,3 +611,260 @@ int bd_mutex_destroy(BD_MUTEX *p)
     return 0;
 }
 
+
+/*
+ * condition variable
+ */
+
+int bd_cond_init(BD_COND *p)
+{
+    p->impl = calloc(1, sizeof(COND_IMPL));
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_init() failed !\n");
+        return -1;
+    }
+
+    if (_cond_init((COND_IMPL*)p->impl) < 0) {
+        X_FREE(p->impl);
+        return -1;
+    }
+
+    return 0;
+}
+
+int bd_cond_destroy(BD_COND *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_destroy() failed !\n");
+        return -1;
+    }
+
+    if (_cond_destroy((COND_IMPL*)p->impl) < 0) {
+        return -1;
+    }
+
+    X_FREE(p->impl);
+    return 0;
+}
+
+int bd_cond_wait(BD_COND *p, BD_MUTEX *m)
+{
+    if (!p->impl || !m->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_wait() failed !\n");
+        return -1;
+    }
+    return _cond_wait((COND_IMPL*)p->impl, (MUTEX_IMPL*)m->impl, 0, 0);
+}
+
+int bd_cond_timedwait(BD_COND *p, BD_MUTEX *m, unsigned timeout_ms)
+{
+    if (!p->impl || !m->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_timedwait() failed !\n");
+        return -1;
+    }
+    return _cond_wait((COND_IMPL*)p->impl, (MUTEX_IMPL*)m->impl, timeout_ms, 1);
+}
+
+int bd_cond_signal(BD_COND *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_signal() failed !\n");
+        return -1;
+    }
+    return _cond_signal((COND_IMPL*)p->impl);
+}
+
+int bd_cond_broadcast(BD_COND *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_cond_broadcast() failed !\n");
+        return -1;
+    }
+    return _cond_broadcast((COND_IMPL*)p->impl);
+}
+
+/*
+ * non-recursive mutex
+ */
+
+int bd_fast_mutex_init(BD_FAST_MUTEX *p)
+{
+    p->impl = calloc(1, sizeof(FAST_MUTEX_IMPL));
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_fast_mutex_init() failed !\n");
+        return -1;
+    }
+
+    if (_fast_mutex_init((FAST_MUTEX_IMPL*)p->impl) < 0) {
+        X_FREE(p->impl);
+        return -1;
+    }
+
+    return 0;
+}
+
+int bd_fast_mutex_destroy(BD_FAST_MUTEX *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_fast_mutex_destroy() failed !\n");
+        return -1;
+    }
+
+    if (_fast_mutex_destroy((FAST_MUTEX_IMPL*)p->impl) < 0) {
+        return -1;
+    }
+
+    X_FREE(p->impl);
+    return 0;
+}
+
+int bd_fast_mutex_lock(BD_FAST_MUTEX *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_fast_mutex_lock() failed !\n");
+        return -1;
+    }
+    return _fast_mutex_lock((FAST_MUTEX_IMPL*)p->impl);
+}
+
+int bd_fast_mutex_trylock(BD_FAST_MUTEX *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_fast_mutex_trylock() failed !\n");
+        return -1;
+    }
+    return _fast_mutex_trylock((FAST_MUTEX_IMPL*)p->impl);
+}
+
+int bd_fast_mutex_unlock(BD_FAST_MUTEX *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_fast_mutex_unlock() failed !\n");
+        return -1;
+    }
+    return _fast_mutex_unlock((FAST_MUTEX_IMPL*)p->impl);
+}
+
+/*
+ * reader-writer lock
+ *
+ * Write lock is recursive. Writer may also take read lock (counted as
+ * recursive write lock). Reader must not try to take write lock.
+ */
+
+int bd_rwlock_init(BD_RWLOCK *p)
+{
+    RWLOCK_IMPL *impl;
+
+    p->impl = impl = calloc(1, sizeof(RWLOCK_IMPL));
+    if (!impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_rwlock_init() failed !\n");
+        return -1;
+    }
+
+    impl->owner = NO_THREAD;
+
+    if (_rwlock_init(impl) < 0) {
+        X_FREE(p->impl);
+        return -1;
+    }
+
+    return 0;
+}
+
+int bd_rwlock_destroy(BD_RWLOCK *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_rwlock_destroy() failed !\n");
+        return -1;
+    }
+
+    if (_rwlock_destroy((RWLOCK_IMPL*)p->impl) < 0) {
+        return -1;
+    }
+
+    X_FREE(p->impl);
+    return 0;
+}
+
+int bd_rwlock_rdlock(BD_RWLOCK *p)
+{
+    RWLOCK_IMPL *impl = (RWLOCK_IMPL*)p->impl;
+
+    if (!impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_rwlock_rdlock() failed !\n");
+        return -1;
+    }
+
+    if (_thread_equal(impl->owner, _thread_self())) {
+        impl->write_count++;
+        return 0;
+    }
+
+    return _rwlock_rdlock(impl);
+}
+
+int bd_rwlock_tryrdlock(BD_RWLOCK *p)
+{
+    RWLOCK_IMPL *impl = (RWLOCK_IMPL*)p->impl;
+
+    if (!impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_rwlock_tryrdlock() failed !\n");
+        return -1;
+    }
+
+    if (_thread_equal(impl->owner, _thread_self())) {
+        impl->write_count++;
+        return 0;
+    }
+
+    return _rwlock_tryrdlock(impl);
+}
+
+int bd_rwlock_wrlock(BD_RWLOCK *p)
+{
+    RWLOCK_IMPL *impl = (RWLOCK_IMPL*)p->impl;
+
+    if (!impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_rwlock_wrlock() failed !\n");
+        return -1;
+    }
+
+    if (_thread_equal(impl->owner, _thread_self())) {
+        /* recursive lock */
+        impl->write_count++;
+        return 0;
+    }
+
+    if (_rwlock_wrlock(impl) < 0) {
+        return -1;
+    }
+
+    impl->owner       = _thread_self();
+    impl->write_count = 1;
+
+    return 0;
+}
+
+int bd_rwlock_unlock(BD_RWLOCK *p)
+{
+    RWLOCK_IMPL *impl = (RWLOCK_IMPL*)p->impl;
+
+    if (!impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_rwlock_unlock() failed !\n");
+        return -1;
+    }
+
+    if (!_thread_equal(impl->owner, _thread_self())) {
+        return _rwlock_rdunlock(impl);
+    }
+
+    impl->write_count--;
+    if (impl->write_count > 0) {
+        return 0;
+    }
+
+    impl->owner = NO_THREAD;
+
+    return _rwlock_wrunlock(impl);
+}
@@ -34,7 +34,70 @@ struct bd_mutex_s {
 BD_PRIVATE int bd_mutex_init(BD_MUTEX *p);
 BD_PRIVATE int bd_mutex_destroy(BD_MUTEX *p);
 
+/* initialize zero-initialized static mutex, if not done yet. Thread-safe, mutex is never destroyed. */
+BD_PRIVATE int bd_mutex_init_once(BD_MUTEX *p);
+
 BD_PRIVATE int bd_mutex_lock(BD_MUTEX *p);
+BD_PRIVATE int bd_mutex_trylock(BD_MUTEX *p);  /* 1 if mutex is locked by another thread */
 BD_PRIVATE int bd_mutex_unlock(BD_MUTEX *p);
 
+/*
+ * non-recursive mutex
+ *
+ * Cheaper than BD_MUTEX. Must not be locked again by the owning thread.
+ * Can not be used with condition variables.
+ */
+
+typedef struct bd_fast_mutex_s BD_FAST_MUTEX;
+struct bd_fast_mutex_s {
+    void *impl;
+};
+
+BD_PRIVATE int bd_fast_mutex_init(BD_FAST_MUTEX *p);
+BD_PRIVATE int bd_fast_mutex_destroy(BD_FAST_MUTEX *p);
+
+BD_PRIVATE int bd_fast_mutex_lock(BD_FAST_MUTEX *p);
+BD_PRIVATE int bd_fast_mutex_trylock(BD_FAST_MUTEX *p);  /* 1 if mutex is locked by another thread */
+BD_PRIVATE int bd_fast_mutex_unlock(BD_FAST_MUTEX *p);
+
+/*
+ * reader-writer lock
+ *
+ * Any number of readers, or one writer. Write lock is recursive, and the
+ * writer may take read locks. Reader must not upgrade to write lock.
+ */
+
+typedef struct bd_rwlock_s BD_RWLOCK;
+struct bd_rwlock_s {
+    void *impl;
+};
+
+BD_PRIVATE int bd_rwlock_init(BD_RWLOCK *p);
+BD_PRIVATE int bd_rwlock_destroy(BD_RWLOCK *p);
+
+BD_PRIVATE int bd_rwlock_rdlock(BD_RWLOCK *p);
+BD_PRIVATE int bd_rwlock_tryrdlock(BD_RWLOCK *p);  /* 1 if write locked by another thread */
+BD_PRIVATE int bd_rwlock_wrlock(BD_RWLOCK *p);
+BD_PRIVATE int bd_rwlock_unlock(BD_RWLOCK *p);     /* release read or write lock */
+
+/*
+ * condition variable
+ *
+ * Mutex must be locked (once) by the calling thread when waiting.
+ * Waiting functions may return spuriously, caller must re-check the condition.
+ */
+
+typedef struct bd_cond_s BD_COND;
+struct bd_cond_s {
+    void *impl;
+};
+
+BD_PRIVATE int bd_cond_init(BD_COND *p);
+BD_PRIVATE int bd_cond_destroy(BD_COND *p);
+
+BD_PRIVATE int bd_cond_wait(BD_COND *p, BD_MUTEX *m);
+BD_PRIVATE int bd_cond_timedwait(BD_COND *p, BD_MUTEX *m, unsigned timeout_ms);  /* 1 on timeout */
+BD_PRIVATE int bd_cond_signal(BD_COND *p);
+BD_PRIVATE int bd_cond_broadcast(BD_COND *p);
+
 #endif // LIBBLURAY_MUTEX_H_
@@ -19,6 +19,7 @@
 
 #include "refcnt.h"
 
+#include "atomic.h"
 #include "logging.h"
 #include "mutex.h"
 
@@ -30,15 +31,65 @@
  */
 
 typedef struct {
+#ifdef BD_HAVE_ATOMICS
+  BD_ATOMIC_UINT count;   /* reference count */
+#else
   BD_MUTEX mutex;   /* initialized only if counted == 1 */
   int      count;   /* reference count */
   unsigned counted; /* 1 if this object is ref-counted */
+#endif
+  void   (*cleanup)(void *); /* called before object is freed */
 } BD_REFCNT;
 
 /*
  *
  */
 
+#ifdef BD_HAVE_ATOMICS
+
+void bd_refcnt_inc(const void *obj)
+{
+    if (!obj) {
+        return;
+    }
+
+    BD_REFCNT *ref = &(((BD_REFCNT *)(intptr_t)obj)[-1]);
+
+    /* new reference is always taken from an existing one: no ordering needed */
+    bd_atomic_add(&ref->count, 1);
+}
+
+void bd_refcnt_dec(const void *obj)
+{
+    if (!obj) {
+        return;
+    }
+
+    BD_REFCNT *ref = &((BD_REFCNT *)(intptr_t)obj)[-1];
+
+    if (bd_atomic_dec(&ref->count) > 1) {
+        return;
+    }
+
+    if (ref->cleanup) {
+        ref->cleanup(&ref[1]);
+    }
+
+    free(ref);
+}
+
+static int _is_shared(BD_REFCNT *ref)
+{
+    return bd_atomic_load(&ref->count) > 1;
+}
+
+static void _refcnt_init(BD_REFCNT *ref)
+{
+    bd_atomic_store(&ref->count, 1);
+}
+
+#else /* BD_HAVE_ATOMICS */
+
 void bd_refcnt_inc(const void *obj)
 {
     if (!obj) {
@@ -81,15 +132,31 @@ void bd_refcnt_dec(const void *obj)
         bd_mutex_destroy(&ref->mutex);
     }
 
+    if (ref->cleanup) {
+        ref->cleanup(&ref[1]);
+    }
+
     free(ref);
 }
 
-void *refcnt_realloc(void *obj, size_t sz)
+static int _is_shared(BD_REFCNT *ref)
+{
+    return ref->counted;
+}
+
+static void _refcnt_init(BD_REFCNT *ref)
+{
+    (void)ref;
+}
+
+#endif /* BD_HAVE_ATOMICS */
+
+void *refcnt_realloc(void *obj, size_t sz, void (*cleanup)(void *))
 {
     sz += sizeof(BD_REFCNT);
 
     if (obj) {
-        if (((BD_REFCNT *)obj)[-1].counted) {
+        if (_is_shared(&((BD_REFCNT *)obj)[-1])) {
             bd_refcnt_dec(obj);
             BD_DEBUG(DBG_CRIT, "refcnt_realloc(): realloc locked object !\n");
             obj = NULL;
@@ -107,10 +174,10 @@ void *refcnt_realloc(void *obj, size_t sz)
             return NULL;
         }
         memset(obj, 0, sizeof(BD_REFCNT));
+        _refcnt_init(obj);
     }
 
+    ((BD_REFCNT *)obj)->cleanup = cleanup;
+
     return &((BD_REFCNT *)obj)[1];
 }
-
-
-
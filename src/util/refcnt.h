@@ -31,22 +31,25 @@
 /*
  * Reference-counted memory blocks.
  *
- * - Object must be allocated with refcnt_realloc(NULL, size).
+ * - Object must be allocated with refcnt_realloc(NULL, size, cleanup).
  *   Returned object has reference count of 1.
- * - Object can be re-allocated with refcnt_realloc(obj, size)
+ * - Object can be re-allocated with refcnt_realloc(obj, size, cleanup)
  *   as long as bd_refcnt_inc() has not been called.
  * - Object must be freed with bd_refcnt_dec().
+ * - Optional cleanup function is called when the last reference is released
+ *   (before the memory block is freed).
  *
- * by default, reference counting is not used (use count = 1).
- * Reference counting is initialized during first call to bd_refcnt_inc().
+ * Reference count is updated with atomic operations when available.
+ * Without atomics, reference counting is not used by default (use count = 1),
+ * and a per-object mutex is initialized during first call to bd_refcnt_inc().
  * This results in reference count = 2.
  *
- * This is thread-safe as long as first bd_refcnt_inc() is done from the
- * same thread that owns the object initially.
+ * Without atomics, this is thread-safe as long as first bd_refcnt_inc()
+ * is done from the same thread that owns the object initially.
  *
  */
 
-BD_PRIVATE void *refcnt_realloc(void *obj, size_t sz);
+BD_PRIVATE void *refcnt_realloc(void *obj, size_t sz, void (*cleanup)(void *));
 
 #ifndef BD_OVERLAY_INTERFACE_VERSION
 void bd_refcnt_inc(const void *obj);
@@ -0,0 +1,127 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "sha1.h"
+
+#include <string.h>
+
+#define ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void _transform(uint32_t h[5], const uint8_t *p)
+{
+    uint32_t w[80];
+    uint32_t a, b, c, d, e, t;
+    unsigned ii;
+
+    for (ii = 0; ii < 16; ii++) {
+        w[ii] = ((uint32_t)p[4*ii] << 24) | ((uint32_t)p[4*ii+1] << 16) |
+                ((uint32_t)p[4*ii+2] << 8) | p[4*ii+3];
+    }
+    for (; ii < 80; ii++) {
+        t = w[ii-3] ^ w[ii-8] ^ w[ii-14] ^ w[ii-16];
+        w[ii] = ROL(t, 1);
+    }
+
+    a = h[0]; b = h[1]; c = h[2]; d = h[3]; e = h[4];
+
+    for (ii = 0; ii < 80; ii++) {
+        if (ii < 20) {
+            t = ((b & c) | (~b & d)) + 0x5a827999;
+        } else if (ii < 40) {
+            t = (b ^ c ^ d) + 0x6ed9eba1;
+        } else if (ii < 60) {
+            t = ((b & c) | (b & d) | (c & d)) + 0x8f1bbcdc;
+        } else {
+            t = (b ^ c ^ d) + 0xca62c1d6;
+        }
+        t += ROL(a, 5) + e + w[ii];
+        e = d;
+        d = c;
+        c = ROL(b, 30);
+        b = a;
+        a = t;
+    }
+
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+}
+
+void bd_sha1_init(BD_SHA1 *s)
+{
+    s->h[0] = 0x67452301;
+    s->h[1] = 0xefcdab89;
+    s->h[2] = 0x98badcfe;
+    s->h[3] = 0x10325476;
+    s->h[4] = 0xc3d2e1f0;
+    s->len  = 0;
+}
+
+void bd_sha1_update(BD_SHA1 *s, const void *data, size_t len)
+{
+    const uint8_t *p   = (const uint8_t *)data;
+    unsigned       off = (unsigned)(s->len & 63);
+
+    s->len += len;
+
+    if (off) {
+        size_t n = 64 - off;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(s->buf + off, p, n);
+        p   += n;
+        len -= n;
+        if (off + n < 64) {
+            return;
+        }
+        _transform(s->h, s->buf);
+    }
+
+    for (; len >= 64; p += 64, len -= 64) {
+        _transform(s->h, p);
+    }
+
+    memcpy(s->buf, p, len);
+}
+
+void bd_sha1_final(BD_SHA1 *s, uint8_t digest[20])
+{
+    uint64_t bits = s->len * 8;
+    unsigned off  = (unsigned)(s->len & 63);
+    unsigned ii;
+
+    s->buf[off++] = 0x80;
+    if (off > 56) {
+        memset(s->buf + off, 0, 64 - off);
+        _transform(s->h, s->buf);
+        off = 0;
+    }
+    memset(s->buf + off, 0, 56 - off);
+    for (ii = 0; ii < 8; ii++) {
+        s->buf[56 + ii] = (uint8_t)(bits >> (56 - 8 * ii));
+    }
+    _transform(s->h, s->buf);
+
+    for (ii = 0; ii < 20; ii++) {
+        digest[ii] = (uint8_t)(s->h[ii / 4] >> (24 - 8 * (ii % 4)));
+    }
+}
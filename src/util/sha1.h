@@ -0,0 +1,42 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBLURAY_SHA1_H_
+#define LIBBLURAY_SHA1_H_
+
+#include "attributes.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * SHA-1 (content identification, not for security)
+ */
+
+typedef struct {
+    uint32_t h[5];
+    uint64_t len;      /* bytes hashed */
+    uint8_t  buf[64];
+} BD_SHA1;
+
+BD_PRIVATE void bd_sha1_init(BD_SHA1 *s);
+BD_PRIVATE void bd_sha1_update(BD_SHA1 *s, const void *data, size_t len);
+BD_PRIVATE void bd_sha1_final(BD_SHA1 *s, uint8_t digest[20]);
+
+#endif // LIBBLURAY_SHA1_H_
@@ -67,6 +67,35 @@ char * str_printf(const char *fmt, ...)
     }
 }
 
+char *str_cat3(char *buf, size_t size, const char *s1, const char *s2, const char *s3)
+{
+    size_t l1, l2, l3;
+
+    s1 = s1 ? s1 : "";
+    s2 = s2 ? s2 : "";
+    s3 = s3 ? s3 : "";
+    l1 = strlen(s1);
+    l2 = strlen(s2);
+    l3 = strlen(s3);
+
+    if (l1 + l2 + l3 >= size) {
+        return str_printf("%s%s%s", s1, s2, s3);
+    }
+
+    memcpy(buf,           s1, l1);
+    memcpy(buf + l1,      s2, l2);
+    memcpy(buf + l1 + l2, s3, l3 + 1);
+
+    return buf;
+}
+
+void str_cat_free(char *buf, char *str)
+{
+    if (str != buf) {
+        free(str);
+    }
+}
+
 uint32_t str_to_uint32(const char *s, int n)
 {
     uint32_t val = 0;
@@ -22,11 +22,23 @@
 
 #include "attributes.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 BD_PRIVATE char * str_dup(const char *str) BD_ATTR_MALLOC;
 BD_PRIVATE char * str_printf(const char *fmt, ...) BD_ATTR_FORMAT_PRINTF(1,2) BD_ATTR_MALLOC;
 
+/*
+ * concatenate s1 + s2 + s3 to caller's buffer without allocating.
+ * If result does not fit to buf, it is allocated from heap.
+ * NULL strings are treated as empty.
+ * Result must be released with str_cat_free(buf, result).
+ */
+BD_PRIVATE char * str_cat3(char *buf, size_t size, const char *s1, const char *s2, const char *s3);
+BD_PRIVATE void   str_cat_free(char *buf, char *str);
+
+#define STR_PATH_BUF_SIZE 512
+
 BD_PRIVATE uint32_t str_to_uint32(const char *s, int n);
 BD_PRIVATE void     str_tolower(char *s);
 
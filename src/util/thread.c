@@ -0,0 +1,198 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined(HAVE_PTHREAD_SETNAME_NP) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  /* pthread_setname_np() */
+#endif
+
+#include "thread.h"
+
+#include "logging.h"
+#include "macro.h"
+
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#   include <process.h>
+#elif defined(HAVE_PTHREAD_H)
+#   include <pthread.h>
+#   include <unistd.h>
+#else
+#   error no thread support found
+#endif
+
+
+/*
+ * start hook
+ */
+
+static void  *_start_handle;
+static void (*_start_func)(void *, const char *);
+
+void bd_thread_set_start_handler(void *handle, void (*func)(void *, const char *))
+{
+    _start_handle = handle;
+    _start_func   = func;
+}
+
+void bd_thread_started(const char *name)
+{
+    void (*func)(void *, const char *) = _start_func;
+
+    if (func) {
+        func(_start_handle, name);
+    }
+}
+
+#if defined(_WIN32)
+
+typedef struct {
+    HANDLE  handle;
+    const char *name;
+    void *(*func)(void *);
+    void   *arg;
+} THREAD_IMPL;
+
+static unsigned __stdcall _thread_main(void *p)
+{
+    THREAD_IMPL *t = (THREAD_IMPL *)p;
+    bd_thread_started(t->name);
+    t->func(t->arg);
+    return 0;
+}
+
+static int _thread_create(THREAD_IMPL *p)
+{
+    p->handle = (HANDLE)_beginthreadex(NULL, 0, _thread_main, p, 0, NULL);
+    if (!p->handle) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "_beginthreadex() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _thread_join(THREAD_IMPL *p)
+{
+    if (WaitForSingleObject(p->handle, INFINITE) != WAIT_OBJECT_0) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "WaitForSingleObject() failed !\n");
+        return -1;
+    }
+    CloseHandle(p->handle);
+    return 0;
+}
+
+#elif defined(HAVE_PTHREAD_H)
+
+typedef struct {
+    pthread_t thread;
+    const char *name;
+    void   *(*func)(void *);
+    void     *arg;
+} THREAD_IMPL;
+
+static void *_thread_main(void *p)
+{
+    THREAD_IMPL *t = (THREAD_IMPL *)p;
+
+#if defined(HAVE_PTHREAD_SETNAME_NP)
+#  if defined(__APPLE__)
+    pthread_setname_np(t->name);
+#  else
+    pthread_setname_np(pthread_self(), t->name);
+#  endif
+#endif
+
+    bd_thread_started(t->name);
+    return t->func(t->arg);
+}
+
+static int _thread_create(THREAD_IMPL *p)
+{
+    if (pthread_create(&p->thread, NULL, _thread_main, p)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_create() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int _thread_join(THREAD_IMPL *p)
+{
+    if (pthread_join(p->thread, NULL)) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "pthread_join() failed !\n");
+        return -1;
+    }
+    return 0;
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+int bd_thread_create(BD_THREAD *p, const char *name, void *(*func)(void *), void *arg)
+{
+    THREAD_IMPL *t = calloc(1, sizeof(THREAD_IMPL));
+    if (!t) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_thread_create() failed !\n");
+        return -1;
+    }
+
+    t->name = name;
+    t->func = func;
+    t->arg  = arg;
+
+    if (_thread_create(t) < 0) {
+        X_FREE(t);
+        return -1;
+    }
+
+    p->impl = t;
+    return 0;
+}
+
+int bd_thread_join(BD_THREAD *p)
+{
+    if (!p->impl) {
+        BD_DEBUG(DBG_BLURAY|DBG_CRIT, "bd_thread_join() failed !\n");
+        return -1;
+    }
+
+    if (_thread_join((THREAD_IMPL*)p->impl) < 0) {
+        return -1;
+    }
+
+    X_FREE(p->impl);
+    return 0;
+}
+
+unsigned bd_cpu_count(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (unsigned)si.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned)n : 1;
+#else
+    return 1;
+#endif
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBLURAY_THREAD_H_
+#define LIBBLURAY_THREAD_H_
+
+#include "attributes.h"
+
+/*
+ * joinable worker thread
+ */
+
+typedef struct bd_thread_s BD_THREAD;
+struct bd_thread_s {
+    void *impl;
+};
+
+/* name: short role name (max. 15 chars), must stay valid while the thread is running */
+BD_PRIVATE int bd_thread_create(BD_THREAD *p, const char *name, void *(*func)(void *), void *arg);
+BD_PRIVATE int bd_thread_join(BD_THREAD *p);
+
+/*
+ * thread start hook
+ */
+
+/* called in each library-created thread before it starts working */
+BD_PRIVATE void bd_thread_set_start_handler(void *handle, void (*func)(void *, const char *));
+
+/* run start hook for a thread not created with bd_thread_create() (ex. BD-J threads) */
+BD_PRIVATE void bd_thread_started(const char *name);
+
+/* number of online processors (at least 1) */
+BD_PRIVATE unsigned bd_cpu_count(void);
+
+#endif // LIBBLURAY_THREAD_H_
@@ -50,6 +50,17 @@ static uint64_t _bd_get_scr_impl(void)
     return (uint64_t)(counter.QuadPart * 1000.0 / frequency.QuadPart) * 90;
 }
 
+static uint64_t _bd_get_time_us_impl(void)
+{
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+           (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+}
+
 #elif defined(HAVE_SYS_TIME_H)
 
 static uint64_t _bd_get_scr_impl(void)
@@ -59,6 +70,13 @@ static uint64_t _bd_get_scr_impl(void)
     return ((uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000) * 90;
 }
 
+static uint64_t _bd_get_time_us_impl(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
 #endif
 
 uint64_t bd_get_scr(void)
@@ -73,3 +91,8 @@ uint64_t bd_get_scr(void)
 
     return now - t0;
 }
+
+uint64_t bd_get_time_us(void)
+{
+    return _bd_get_time_us_impl();
+}
@@ -26,4 +26,7 @@
 
 BD_PRIVATE uint64_t bd_get_scr(void);
 
+/* monotonic time in microseconds (for statistics) */
+BD_PRIVATE uint64_t bd_get_time_us(void);
+
 #endif // LIBBLURAY_TIME_H_
@@ -0,0 +1,234 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "timers.h"
+
+#include "logging.h"
+#include "macro.h"
+#include "mutex.h"
+#include "thread.h"
+#include "time.h"
+
+#include <stdlib.h>
+
+typedef struct {
+    uint64_t deadline;
+    unsigned id;
+} TIMER_ENTRY;
+
+struct bd_timers_s {
+    bd_timer_f  expired;
+    void       *handle;
+
+    BD_MUTEX    mutex;
+    BD_COND     cond;     /* heap changed or exit requested */
+    BD_THREAD   thread;
+    int         exit;
+
+    TIMER_ENTRY heap[BD_TIMERS_MAX];
+    unsigned    count;
+    int         pos[BD_TIMERS_MAX];  /* heap index of timer id, -1 = not armed */
+};
+
+/*
+ * min-heap
+ */
+
+static void _swap(BD_TIMERS *t, unsigned a, unsigned b)
+{
+    TIMER_ENTRY tmp = t->heap[a];
+    t->heap[a] = t->heap[b];
+    t->heap[b] = tmp;
+    t->pos[t->heap[a].id] = a;
+    t->pos[t->heap[b].id] = b;
+}
+
+static void _sift_up(BD_TIMERS *t, unsigned i)
+{
+    while (i > 0 && t->heap[(i - 1) / 2].deadline > t->heap[i].deadline) {
+        _swap(t, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void _sift_down(BD_TIMERS *t, unsigned i)
+{
+    for (;;) {
+        unsigned l = 2 * i + 1, r = l + 1, min = i;
+        if (l < t->count && t->heap[l].deadline < t->heap[min].deadline) {
+            min = l;
+        }
+        if (r < t->count && t->heap[r].deadline < t->heap[min].deadline) {
+            min = r;
+        }
+        if (min == i) {
+            break;
+        }
+        _swap(t, i, min);
+        i = min;
+    }
+}
+
+static void _remove(BD_TIMERS *t, unsigned i)
+{
+    t->pos[t->heap[i].id] = -1;
+    t->count--;
+    if (i < t->count) {
+        t->heap[i] = t->heap[t->count];
+        t->pos[t->heap[i].id] = i;
+        _sift_down(t, i);
+        _sift_up(t, i);
+    }
+}
+
+/*
+ * thread
+ */
+
+static void *_timer_thread(void *arg)
+{
+    BD_TIMERS *t = (BD_TIMERS *)arg;
+
+    bd_mutex_lock(&t->mutex);
+
+    while (!t->exit) {
+        uint64_t now;
+
+        if (!t->count) {
+            bd_cond_wait(&t->cond, &t->mutex);
+            continue;
+        }
+
+        now = bd_get_time_us();
+        if (t->heap[0].deadline > now) {
+            uint64_t wait_ms = (t->heap[0].deadline - now + 999) / 1000;
+            bd_cond_timedwait(&t->cond, &t->mutex, (unsigned)BD_MIN(wait_ms, 1000));
+            continue;
+        }
+
+        unsigned id = t->heap[0].id;
+        _remove(t, 0);
+
+        bd_mutex_unlock(&t->mutex);
+        t->expired(t->handle, id);
+        bd_mutex_lock(&t->mutex);
+    }
+
+    bd_mutex_unlock(&t->mutex);
+
+    return NULL;
+}
+
+BD_TIMERS *bd_timers_init(bd_timer_f expired, void *handle)
+{
+    BD_TIMERS *t;
+    unsigned   ii;
+
+    t = calloc(1, sizeof(*t));
+    if (!t) {
+        return NULL;
+    }
+
+    t->expired = expired;
+    t->handle  = handle;
+    for (ii = 0; ii < BD_TIMERS_MAX; ii++) {
+        t->pos[ii] = -1;
+    }
+
+    bd_mutex_init(&t->mutex);
+    bd_cond_init(&t->cond);
+
+    if (bd_thread_create(&t->thread, "bd_timer", _timer_thread, t) < 0) {
+        BD_DEBUG(DBG_BLURAY | DBG_CRIT, "failed creating timer thread\n");
+        bd_cond_destroy(&t->cond);
+        bd_mutex_destroy(&t->mutex);
+        X_FREE(t);
+        return NULL;
+    }
+
+    return t;
+}
+
+void bd_timers_free(BD_TIMERS **pt)
+{
+    if (pt && *pt) {
+        BD_TIMERS *t = *pt;
+        *pt = NULL;
+
+        bd_mutex_lock(&t->mutex);
+        t->exit = 1;
+        bd_cond_signal(&t->cond);
+        bd_mutex_unlock(&t->mutex);
+
+        bd_thread_join(&t->thread);
+
+        bd_cond_destroy(&t->cond);
+        bd_mutex_destroy(&t->mutex);
+        X_FREE(t);
+    }
+}
+
+void bd_timers_set(BD_TIMERS *t, unsigned id, uint64_t deadline_us)
+{
+    if (!t || id >= BD_TIMERS_MAX) {
+        return;
+    }
+
+    bd_mutex_lock(&t->mutex);
+
+    if (t->pos[id] >= 0) {
+        unsigned i = t->pos[id];
+        if (t->heap[i].deadline == deadline_us) {
+            bd_mutex_unlock(&t->mutex);
+            return;
+        }
+        t->heap[i].deadline = deadline_us;
+        _sift_down(t, i);
+        _sift_up(t, i);
+    } else {
+        t->heap[t->count].deadline = deadline_us;
+        t->heap[t->count].id       = id;
+        t->pos[id] = t->count;
+        _sift_up(t, t->count++);
+    }
+
+    /* wake up only if earliest deadline changed */
+    if (t->heap[0].id == id) {
+        bd_cond_signal(&t->cond);
+    }
+
+    bd_mutex_unlock(&t->mutex);
+}
+
+void bd_timers_cancel(BD_TIMERS *t, unsigned id)
+{
+    if (!t || id >= BD_TIMERS_MAX) {
+        return;
+    }
+
+    bd_mutex_lock(&t->mutex);
+    if (t->pos[id] >= 0) {
+        _remove(t, t->pos[id]);
+    }
+    bd_mutex_unlock(&t->mutex);
+}
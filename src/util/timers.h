@@ -0,0 +1,50 @@
+/*
+ * This file is part of libbluray
+ * Copyright (C) 2015  VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBBLURAY_TIMERS_H_
+#define LIBBLURAY_TIMERS_H_
+
+#include "attributes.h"
+
+#include <stdint.h>
+
+/*
+ * timer thread
+ *
+ * Single thread with a min-heap of deadlines (bd_get_time_us() clock).
+ * Each timer id is armed at most once; re-arming replaces the deadline.
+ * Expired timers are reported from the timer thread, without internal
+ * lock held. Callback may re-arm or cancel timers.
+ */
+
+#define BD_TIMERS_MAX  8  /* timer ids 0 ... BD_TIMERS_MAX-1 */
+
+typedef struct bd_timers_s BD_TIMERS;
+
+typedef void (*bd_timer_f)(void *handle, unsigned id);
+
+BD_PRIVATE BD_TIMERS *bd_timers_init(bd_timer_f expired, void *handle);
+
+/* stop timer thread. Must not be called while callback may be waiting for a lock held by caller. */
+BD_PRIVATE void bd_timers_free(BD_TIMERS **);
+
+BD_PRIVATE void bd_timers_set(BD_TIMERS *, unsigned id, uint64_t deadline_us);
+BD_PRIVATE void bd_timers_cancel(BD_TIMERS *, unsigned id);
+
+#endif // LIBBLURAY_TIMERS_H_